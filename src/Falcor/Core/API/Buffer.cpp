@@ -181,14 +181,15 @@ template<typename ViewClass>
 using CreateFuncType = std::function<typename ViewClass::SharedPtr(Buffer* pBuffer, uint32_t firstElement, uint32_t elementCount)>;
 
 template<typename ViewClass, typename ViewMapType>
-typename ViewClass::SharedPtr findViewCommon(Buffer* pBuffer, uint32_t firstElement, uint32_t elementCount, ViewMapType& viewMap, CreateFuncType<ViewClass> createFunc) {
+typename ViewClass::SharedPtr findViewCommon(Buffer* pBuffer, uint32_t firstElement, uint32_t elementCount, ViewMapType& viewMap, std::mutex& viewsMutex, CreateFuncType<ViewClass> createFunc) {
     ResourceViewInfo view = ResourceViewInfo(firstElement, elementCount);
 
-    if (viewMap.find(view) == viewMap.end()) {
-        viewMap[view] = createFunc(pBuffer, firstElement, elementCount);
+    std::lock_guard<std::mutex> lock(viewsMutex);
+    auto it = viewMap.find(view);
+    if (it == viewMap.end()) {
+        it = viewMap.emplace(view, createFunc(pBuffer, firstElement, elementCount)).first;
     }
-
-    return viewMap[view];
+    return it->second;
 }
 
 ShaderResourceView::SharedPtr Buffer::getSRV(uint32_t firstElement, uint32_t elementCount) {
@@ -196,7 +197,7 @@ ShaderResourceView::SharedPtr Buffer::getSRV(uint32_t firstElement, uint32_t ele
         return ShaderResourceView::create(pBuffer->device(), pBuffer->shared_from_this(), firstElement, elementCount);
     };
 
-    return findViewCommon<ShaderResourceView>(this, firstElement, elementCount, mSrvs, createFunc);
+    return findViewCommon<ShaderResourceView>(this, firstElement, elementCount, mSrvs, mViewsMutex, createFunc);
 }
 
 ShaderResourceView::SharedPtr Buffer::getSRV() {
@@ -208,7 +209,7 @@ UnorderedAccessView::SharedPtr Buffer::getUAV(uint32_t firstElement, uint32_t el
         return UnorderedAccessView::create(pBuffer->device(), pBuffer->shared_from_this(), firstElement, elementCount);
     };
 
-    return findViewCommon<UnorderedAccessView>(this, firstElement, elementCount, mUavs, createFunc);
+    return findViewCommon<UnorderedAccessView>(this, firstElement, elementCount, mUavs, mViewsMutex, createFunc);
 }
 
 UnorderedAccessView::SharedPtr Buffer::getUAV() {
@@ -52,4 +52,9 @@ ComputeStateObject::SharedPtr ComputeStateObject::create(std::shared_ptr<Device>
     return SharedPtr(new ComputeStateObject(pDevice, desc));
 }
 
+std::shared_future<ComputeStateObject::SharedPtr> ComputeStateObject::createAsync(std::shared_ptr<Device> pDevice, const Desc& desc) {
+    assert(pDevice && pDevice->getPipelineCache());
+    return pDevice->getPipelineCache()->enqueue([pDevice, desc]() { return create(pDevice, desc); }).share();
+}
+
 }  // namespace Falcor
@@ -28,6 +28,8 @@
 #ifndef SRC_FALCOR_CORE_API_COMPUTESTATEOBJECT_H_
 #define SRC_FALCOR_CORE_API_COMPUTESTATEOBJECT_H_
 
+#include <future>
+
 #include "Falcor/Core/Program/ProgramVersion.h"
 #include "Falcor/Core/API/RootSignature.h"
 
@@ -62,6 +64,13 @@ class dlldecl ComputeStateObject {
     */
     static SharedPtr create(std::shared_ptr<Device> pDevice, const Desc& desc);
 
+    /** Create a compute state object on a worker thread of the device's pipeline cache.
+        The program kernels in desc must already be linked.
+        \param[in] desc State object description.
+        \return Future for the new object. get() rethrows if creation failed.
+    */
+    static std::shared_future<SharedPtr> createAsync(std::shared_ptr<Device> pDevice, const Desc& desc);
+
     const ApiHandle& getApiHandle() { return mApiHandle; }
     const Desc& getDesc() const { return mDesc; }
 
@@ -137,9 +137,12 @@ class dlldecl CopyContext {
     */
     void updateTexturePage(const VirtualTexturePage* pPage, Buffer::SharedPtr pStagingBuffer);
 
-    /** Uodate texture image data (used to fill mip tail data)
+    /** Update whole mip levels from one packed buffer with a single staging buffer and copy (used to fill mip tail data)
+        \param[in] mipLevels Mip levels to update.
+        \param[in] offsets Offset of each level in pData. Rows are tightly packed texels, or blocks for compressed formats.
+        \param[in] pData Packed data of dataSize bytes.
     */
-    void updateMipTailData(const Texture* pTexture, const int3& offset, const uint3& extent, uint8_t mipLevel, const void* pData);
+    void updateMipTailData(const Texture* pTexture, const std::vector<uint32_t>& mipLevels, const std::vector<size_t>& offsets, const void* pData, size_t dataSize);
     
     /** Update a buffer
     */
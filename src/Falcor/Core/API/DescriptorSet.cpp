@@ -57,4 +57,16 @@ DescriptorSet::Layout& DescriptorSet::Layout::addRange(DescriptorSet::Type type,
     return *this;
 }
 
+size_t DescriptorSet::Layout::getHash() const {
+    size_t hash = std::hash<uint32_t>()((uint32_t)mVisibility);
+    auto combine = [&hash](uint32_t v) { hash ^= std::hash<uint32_t>()(v) + 0x9e3779b9 + (hash << 6) + (hash >> 2); };
+    for (const auto& r : mRanges) {
+        combine((uint32_t)r.type);
+        combine(r.baseRegIndex);
+        combine(r.descCount);
+        combine(r.regSpace);
+    }
+    return hash;
+}
+
 }  // namespace Falcor
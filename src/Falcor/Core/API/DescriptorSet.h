@@ -76,6 +76,10 @@ class dlldecl DescriptorSet {
             uint32_t baseRegIndex;
             uint32_t descCount;
             uint32_t regSpace;
+
+            bool operator==(const Range& other) const {
+                return type == other.type && baseRegIndex == other.baseRegIndex && descCount == other.descCount && regSpace == other.regSpace;
+            }
         };
 
         Layout(ShaderVisibility visibility = ShaderVisibility::All) : mVisibility(visibility) {}
@@ -83,6 +87,13 @@ class dlldecl DescriptorSet {
         size_t getRangeCount() const { return mRanges.size(); }
         const Range& getRange(size_t index) const { return mRanges[index]; }
         ShaderVisibility getVisibility() const { return mVisibility; }
+
+        bool operator==(const Layout& other) const { return mVisibility == other.mVisibility && mRanges == other.mRanges; }
+        bool operator!=(const Layout& other) const { return !(*this == other); }
+
+        /** Hash of the ranges and visibility, used to share API layout objects between sets.
+        */
+        size_t getHash() const;
      private:
         std::vector<Range> mRanges;
         ShaderVisibility mVisibility;
@@ -109,6 +120,11 @@ class dlldecl DescriptorSet {
     void setSampler(uint32_t rangeIndex, uint32_t descIndex, const Sampler* pSampler);
     void setCbv(uint32_t rangeIndex, uint32_t descIndex, ConstantBufferView* pView);
 
+    /** Submit the descriptors set since the last flush. The setXXX() calls only record the writes, they are applied
+        in a single batch here. Binding the set flushes it implicitly.
+    */
+    void flushWrites();
+
     void bindForGraphics(CopyContext* pCtx, const RootSignature* pRootSig, uint32_t rootIndex);
     void bindForCompute(CopyContext* pCtx, const RootSignature* pRootSig, uint32_t rootIndex);
 
@@ -30,6 +30,7 @@
 
 #include "Falcor/Core/API/ResourceManager.h"
 #include "Falcor/Utils/Debug/debug.h"
+#include "Falcor/Utils/ConfigStore.h"
 
 namespace Falcor {
     
@@ -119,6 +120,14 @@ bool Device::init(std::shared_ptr<const DeviceManager> pDeviceManager) {
         .setDescCount(DescriptorPool::Type::RawBufferSrv, 2 * 1024)
         .setDescCount(DescriptorPool::Type::RawBufferUav, 2 * 1024);
 #endif
+    // Pipeline cache persists across runs unless disabled with "pcoff"
+    const auto& config = ConfigStore::instance();
+    std::string pipelineCacheFilename;
+    if (!config.get<bool>("pcoff", false)) {
+        pipelineCacheFilename = config.get<std::string>("cache_dir", "/tmp/lava/cache") + "/pipelines_" + std::to_string(mGpuId) + ".bin";
+    }
+    mpPipelineCache = PipelineCache::create(shared_from_this(), pipelineCacheFilename);
+
     mpFrameFence = GpuFence::create(shared_from_this());
     mpGpuDescPool = DescriptorPool::create(shared_from_this(), poolDesc, mpFrameFence);
     poolDesc.setShaderVisible(false).setDescCount(DescriptorPool::Type::Rtv, 16 * 1024).setDescCount(DescriptorPool::Type::Dsv, 1024);
@@ -307,8 +316,15 @@ void Device::cleanup() {
     releaseNullTypedBufferViews(shared_from_this());
     releaseStaticResources(shared_from_this());
 
+    const auto descStats = getDescriptorStats();
+    LOG_INFO("Descriptors: %llu set layouts for %llu requests, %llu sets from %llu pool pages (%llu recycled), %llu descriptors in %llu writes",
+        (unsigned long long)descStats.layoutsCreated, (unsigned long long)descStats.layoutRequests,
+        (unsigned long long)descStats.setsAllocated, (unsigned long long)descStats.poolPagesCreated, (unsigned long long)descStats.poolPagesRecycled,
+        (unsigned long long)descStats.descriptorsWritten, (unsigned long long)descStats.writeCalls);
+
     mpRenderContext.reset();
     mpUploadHeap.reset();
+    mpPipelineCache.reset();    // saves the cache
     mpCpuDescPool.reset();
     mpGpuDescPool.reset();
     mpFrameFence.reset();
@@ -42,6 +42,7 @@
 #include "Falcor/Core/API/LowLevelContextData.h"
 #include "Falcor/Core/API/DescriptorPool.h"
 #include "Falcor/Core/API/GpuMemoryHeap.h"
+#include "Falcor/Core/API/PipelineCache.h"
 #include "Falcor/Core/API/QueryHeap.h"
 #include "Falcor/Core/API/Sampler.h"
 
@@ -202,6 +203,22 @@ class dlldecl Device: public std::enable_shared_from_this<Device> {
     const DescriptorPool::SharedPtr& getCpuDescriptorPool() const { return mpCpuDescPool; }
     const DescriptorPool::SharedPtr& getGpuDescriptorPool() const { return mpGpuDescPool; }
     const GpuMemoryHeap::SharedPtr& getUploadHeap() const { return mpUploadHeap; }
+    const PipelineCache::SharedPtr& getPipelineCache() const { return mpPipelineCache; }
+
+    /** Descriptor allocation counters, accumulated over the lifetime of the device.
+    */
+    struct DescriptorStats {
+        uint64_t layoutsCreated = 0;        ///< Distinct set layouts created
+        uint64_t layoutRequests = 0;        ///< Layout lookups, including the ones served from the cache
+        uint64_t setsAllocated = 0;
+        uint64_t poolPagesCreated = 0;
+        uint64_t poolPagesRecycled = 0;     ///< Pool pages reset after all their sets were released
+        uint64_t writeCalls = 0;            ///< Batched descriptor set updates
+        uint64_t descriptorsWritten = 0;
+    };
+
+    DescriptorStats getDescriptorStats() const;
+
     void releaseResource(ApiObjectHandle pResource);
     double getGpuTimestampFrequency() const { return mGpuTimestampFrequency; }  // ms/tick
 
@@ -257,6 +274,7 @@ class dlldecl Device: public std::enable_shared_from_this<Device> {
     Desc mDesc;
     ApiHandle mApiHandle;
     GpuMemoryHeap::SharedPtr mpUploadHeap;
+    PipelineCache::SharedPtr mpPipelineCache;
     DescriptorPool::SharedPtr mpCpuDescPool;
     DescriptorPool::SharedPtr mpGpuDescPool;
     bool mIsWindowOccluded = false;
@@ -37,8 +37,15 @@ namespace Falcor {
 
     GpuMemoryHeap::GpuMemoryHeap(std::shared_ptr<Device> device, Type type, size_t pageSize, const GpuFence::SharedPtr& pFence)
         : mType(type)
-        , mPageSize(pageSize)
         , mpFence(pFence)
+        , mPageSize(pageSize)
+        , mLargeBlockPool(
+            { kLargeBlockPages * pageSize, kMaxIdleLargeBlocks * kLargeBlockPages * pageSize },
+            [this](uint32_t blockID, uint64_t size) {
+                if (blockID >= mLargeBlocks.size()) mLargeBlocks.resize(blockID + 1);
+                initBasePageData(mLargeBlocks[blockID], size);
+            },
+            [this](uint32_t blockID) { mLargeBlocks[blockID] = BaseData(); })
         , mpDevice(device)
     {
         allocateNewPage();
@@ -68,10 +75,16 @@ namespace Falcor {
     }
 
     GpuMemoryHeap::Allocation GpuMemoryHeap::allocate(size_t size, size_t alignment) {
+        std::lock_guard<std::mutex> lock(mMutex);
         Allocation data;
         if (size > mPageSize) {
-            data.pageID = GpuMemoryHeap::Allocation::kMegaPageId;
-            initBasePageData(data, size);
+            auto allocation = mLargeBlockPool.allocate(size, alignment);
+            const BaseData& block = mLargeBlocks[allocation.blockID];
+            data.pageID = Allocation::kLargeBlockPageId;
+            data.blockID = allocation.blockID;
+            data.offset = allocation.offset;
+            data.pData = block.pData + allocation.offset;
+            data.pResourceHandle = block.pResourceHandle;
         } else {
             // Calculate the start
             size_t currentOffset = align_to(alignment, mpActivePage->currentOffset);
@@ -94,10 +107,18 @@ namespace Falcor {
 
     void GpuMemoryHeap::release(Allocation& data) {
         assert(data.pResourceHandle);
-        mDeferredReleases.push(data);
+        std::lock_guard<std::mutex> lock(mMutex);
+        // The GPU may use the memory until the end of the frame it is released in, not just the one it was allocated in.
+        data.fenceValue = mpFence->getCpuValue();
+        if (data.pageID == Allocation::kLargeBlockPageId) {
+            mLargeBlockPool.release({ data.blockID, data.offset }, data.fenceValue);
+        } else {
+            mDeferredReleases.push(data);
+        }
     }
 
     void GpuMemoryHeap::executeDeferredReleases() {
+        std::lock_guard<std::mutex> lock(mMutex);
         uint64_t gpuVal = mpFence->getGpuValue();
         while (mDeferredReleases.size() && mDeferredReleases.top().fenceValue <= gpuVal) {
             const Allocation& data = mDeferredReleases.top();
@@ -108,17 +129,16 @@ namespace Falcor {
                     mpActivePage->currentOffset = 0;
                 }
             } else {
-                if (data.pageID != Allocation::kMegaPageId) {
-                    auto& pData = mUsedPages[data.pageID];
-                    pData->allocationsCount--;
-                    if (pData->allocationsCount == 0) {
-                        mAvailablePages.push(std::move(pData));
-                        mUsedPages.erase(data.pageID);
-                    }
+                auto& pData = mUsedPages[data.pageID];
+                pData->allocationsCount--;
+                if (pData->allocationsCount == 0) {
+                    mAvailablePages.push(std::move(pData));
+                    mUsedPages.erase(data.pageID);
                 }
-                // else it's a mega-page. Popping it will release the resource
             }
             mDeferredReleases.pop();
         }
+
+        mLargeBlockPool.executeDeferredReleases(gpuVal);
     }
 }
@@ -30,10 +30,12 @@
 
 #include <queue>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 
 #include "Falcor/Core/Framework.h"
 #include "Falcor/Core/API/GpuFence.h"
+#include "Falcor/Utils/TlsfAllocator.h"
 
 namespace Falcor {
 
@@ -60,14 +62,18 @@ class dlldecl GpuMemoryHeap {
     struct Allocation : public BaseData {
         uint64_t pageID = 0;
         uint64_t fenceValue = 0;
+        uint32_t blockID = TlsfBlockPool::kInvalidBlock;   ///< Large block the allocation lives in, if pageID is kLargeBlockPageId.
 
-        static const uint64_t kMegaPageId = -1;
+        static const uint64_t kLargeBlockPageId = -1;
         bool operator<(const Allocation& other)  const { return fenceValue > other.fenceValue; }
     };
 
     ~GpuMemoryHeap();
 
     /** Create a new GPU memory heap.
+        Allocations up to the page size are bump-allocated from pages. Larger ones are sub-allocated from reusable
+        blocks of kLargeBlockPages pages, or from a dedicated power-of-two block for even larger requests.
+        The heap may be used from several threads, e.g. by render graph passes recording on worker contexts.
         \param[in] type The type of heap.
         \param[in] pageSize Page size in bytes.
         \param[in] pFence Fence to use for synchronization.
@@ -76,10 +82,18 @@ class dlldecl GpuMemoryHeap {
     static SharedPtr create(std::shared_ptr<Device> device, Type type, size_t pageSize, const GpuFence::SharedPtr& pFence);
 
     Allocation allocate(size_t size, size_t alignment = 1);
+
+    /** Release an allocation. The memory is reused once the GPU is done with the current frame.
+    */
     void release(Allocation& data);
     size_t getPageSize() const { return mPageSize; }
     void executeDeferredReleases();
 
+    static const size_t kLargeBlockPages = 16;
+    static const size_t kMaxIdleLargeBlocks = 4;   ///< Empty large blocks kept for reuse, in units of regular blocks.
+
+    TlsfBlockPool::Stats getLargeBlockStats() const { std::lock_guard<std::mutex> lock(mMutex); return mLargeBlockPool.getStats(); }
+
 private:
     GpuMemoryHeap(std::shared_ptr<Device> device, Type type, size_t pageSize, const GpuFence::SharedPtr& pFence);
 
@@ -92,6 +106,7 @@ private:
 
     Type mType;
     GpuFence::SharedPtr mpFence;
+    mutable std::mutex mMutex;
     size_t mPageSize = 0;
     size_t mCurrentPageId = 0;
     PageData::UniquePtr mpActivePage;
@@ -100,6 +115,9 @@ private:
     std::unordered_map<size_t, PageData::UniquePtr> mUsedPages;
     std::queue<PageData::UniquePtr> mAvailablePages;
 
+    TlsfBlockPool mLargeBlockPool;
+    std::vector<BaseData> mLargeBlocks;   // Indexed by TlsfBlockPool block ID.
+
     std::shared_ptr<Device> mpDevice; 
 
     void allocateNewPage();
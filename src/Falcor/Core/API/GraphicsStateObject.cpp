@@ -70,14 +70,18 @@ GraphicsStateObject::~GraphicsStateObject() {
     mpDevice->releaseResource(mApiHandle);
 }
 
-GraphicsStateObject::GraphicsStateObject(std::shared_ptr<Device> pDevice, const Desc& desc) : mpDevice(pDevice), mDesc(desc) {
-    assert(mpDevice);
+void GraphicsStateObject::initDefaultStates(std::shared_ptr<Device> pDevice) {
     if (spDefaultBlendState == nullptr) {
         // Create default objects
-        spDefaultBlendState = BlendState::create(BlendState::Desc(mpDevice));
+        spDefaultBlendState = BlendState::create(BlendState::Desc(pDevice));
         spDefaultDepthStencilState = DepthStencilState::create(DepthStencilState::Desc());
         spDefaultRasterizerState = RasterizerState::create(RasterizerState::Desc());
     }
+}
+
+GraphicsStateObject::GraphicsStateObject(std::shared_ptr<Device> pDevice, const Desc& desc) : mpDevice(pDevice), mDesc(desc) {
+    assert(mpDevice);
+    initDefaultStates(mpDevice);
 
     // Initialize default objects
     if (!mDesc.mpBlendState) mDesc.mpBlendState = spDefaultBlendState;
@@ -92,6 +96,13 @@ GraphicsStateObject::SharedPtr GraphicsStateObject::create(std::shared_ptr<Devic
     return SharedPtr(new GraphicsStateObject(pDevice, desc));
 }
 
+std::shared_future<GraphicsStateObject::SharedPtr> GraphicsStateObject::createAsync(std::shared_ptr<Device> pDevice, const Desc& desc) {
+    assert(pDevice && pDevice->getPipelineCache());
+    // The default states are shared, create them here rather than racing on the worker
+    initDefaultStates(pDevice);
+    return pDevice->getPipelineCache()->enqueue([pDevice, desc]() { return create(pDevice, desc); }).share();
+}
+
 GraphicsStateObject::Desc::Desc (std::shared_ptr<Device> pDevice): mFboDesc(pDevice) {
 
 }
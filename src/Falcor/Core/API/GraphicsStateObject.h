@@ -28,6 +28,8 @@
 #ifndef SRC_FALCOR_CORE_API_GRAPHICSSTATEOBJECT_H_
 #define SRC_FALCOR_CORE_API_GRAPHICSSTATEOBJECT_H_
 
+#include <future>
+
 #include "Falcor/Core/API/VertexLayout.h"
 #include "Falcor/Core/API/FBO.h"
 #include "Falcor/Core/Program/ProgramVersion.h"
@@ -122,6 +124,13 @@ class dlldecl GraphicsStateObject {
     */
     static SharedPtr create(std::shared_ptr<Device> pDevice, const Desc& desc);
 
+    /** Create a graphics state object on a worker thread of the device's pipeline cache.
+        The program kernels in desc must already be linked.
+        \param[in] desc State object description.
+        \return Future for the new object. get() rethrows if creation failed.
+    */
+    static std::shared_future<SharedPtr> createAsync(std::shared_ptr<Device> pDevice, const Desc& desc);
+
     const ApiHandle& getApiHandle() { return mApiHandle; }
 
     const Desc& getDesc() const { return mDesc; }
@@ -129,6 +138,7 @@ class dlldecl GraphicsStateObject {
  private:
     GraphicsStateObject(std::shared_ptr<Device> pDevice, const Desc& desc);
     void apiInit();
+    static void initDefaultStates(std::shared_ptr<Device> pDevice);
 
     Desc mDesc;
     ApiHandle mApiHandle;
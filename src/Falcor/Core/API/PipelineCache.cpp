@@ -0,0 +1,228 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "PipelineCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Falcor/Core/API/Device.h"
+#include "Falcor/Utils/BinaryFileStream.h"
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+namespace fs = boost::filesystem;
+
+namespace Falcor {
+
+namespace {
+
+const char kFileMagic[4] = { 'F', 'P', 'L', 'C' };
+const uint32_t kFileVersion = 1;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    PipelineCache::DeviceIdentity identity;
+    uint64_t dataSize;
+    uint64_t dataHash;
+};
+
+/** Header every driver puts in front of its cache data (VkPipelineCacheHeaderVersionOne).
+*/
+struct DriverDataHeader {
+    uint32_t headerSize;
+    uint32_t headerVersion;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint8_t pipelineCacheUUID[16];
+};
+
+const uint32_t kDriverHeaderVersionOne = 1;
+
+uint64_t hashData(const uint8_t* pData, size_t size) {
+    uint64_t hash = 14695981039346656037ull;    // FNV-1a
+    for (size_t i = 0; i < size; i++) {
+        hash ^= pData[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+}  // namespace
+
+bool PipelineCache::DeviceIdentity::operator==(const DeviceIdentity& other) const {
+    return vendorID == other.vendorID && deviceID == other.deviceID && driverVersion == other.driverVersion &&
+        std::memcmp(pipelineCacheUUID, other.pipelineCacheUUID, sizeof(pipelineCacheUUID)) == 0;
+}
+
+std::vector<uint8_t> PipelineCache::serialize(const DeviceIdentity& identity, const void* pData, size_t size) {
+    FileHeader header = {};
+    std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+    header.version = kFileVersion;
+    header.identity = identity;
+    header.dataSize = size;
+    header.dataHash = hashData(static_cast<const uint8_t*>(pData), size);
+
+    std::vector<uint8_t> file(sizeof(FileHeader) + size);
+    std::memcpy(file.data(), &header, sizeof(FileHeader));
+    if (size) std::memcpy(file.data() + sizeof(FileHeader), pData, size);
+    return file;
+}
+
+bool PipelineCache::deserialize(const std::vector<uint8_t>& file, const DeviceIdentity& identity, std::vector<uint8_t>& data) {
+    data.clear();
+    if (file.size() < sizeof(FileHeader)) return false;
+
+    FileHeader header;
+    std::memcpy(&header, file.data(), sizeof(FileHeader));
+    if (std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0 || header.version != kFileVersion) return false;
+    if (header.identity != identity) return false;
+    if (header.dataSize != file.size() - sizeof(FileHeader)) return false;
+
+    const uint8_t* pData = file.data() + sizeof(FileHeader);
+    if (hashData(pData, header.dataSize) != header.dataHash) return false;
+
+    // The driver validates this too, but some drivers have been known to crash on foreign data.
+    if (header.dataSize < sizeof(DriverDataHeader)) return false;
+    DriverDataHeader driverHeader;
+    std::memcpy(&driverHeader, pData, sizeof(DriverDataHeader));
+    if (driverHeader.headerSize < sizeof(DriverDataHeader) || driverHeader.headerSize > header.dataSize) return false;
+    if (driverHeader.headerVersion != kDriverHeaderVersionOne) return false;
+    if (driverHeader.vendorID != identity.vendorID || driverHeader.deviceID != identity.deviceID) return false;
+    if (std::memcmp(driverHeader.pipelineCacheUUID, identity.pipelineCacheUUID, sizeof(identity.pipelineCacheUUID)) != 0) return false;
+
+    data.assign(pData, pData + header.dataSize);
+    return true;
+}
+
+PipelineCache::PipelineCache(std::shared_ptr<Device> pDevice, const std::string& filename, uint32_t workerCount)
+    : mpDevice(pDevice), mFilename(filename) {
+    assert(mpDevice);
+    mpWorkers = std::make_unique<ThreadPool>(std::max(1u, workerCount));
+
+    std::vector<uint8_t> initialData;
+    if (!mFilename.empty() && fs::exists(mFilename)) {
+        BinaryFileStream stream(mFilename, BinaryFileStream::Mode::Read);
+        std::vector<uint8_t> file(stream.getRemainingStreamSize());
+        stream.read(file.data(), file.size());
+
+        if (stream.isGood() && deserialize(file, apiGetDeviceIdentity(), initialData)) {
+            LOG_DBG("Loaded %zu bytes of pipeline cache from %s", initialData.size(), mFilename.c_str());
+        } else {
+            LOG_WARN("Ignoring pipeline cache %s, it was written by another device or driver or is corrupted", mFilename.c_str());
+            initialData.clear();
+        }
+    }
+    mStats.loadedDataSize = initialData.size();
+
+    apiInit(initialData);
+}
+
+PipelineCache::~PipelineCache() {
+    // Finish pending asynchronous creations before the cache goes away
+    mpWorkers.reset();
+    if (mStats.pipelinesCreated) {
+        LOG_INFO("Pipeline cache: %llu pipelines created, %llu cache hits%s, %llu of %llu async state objects used, %.2f ms total, %.2f ms max",
+            (unsigned long long)mStats.pipelinesCreated, (unsigned long long)mStats.cacheHits,
+            mCreationFeedbackSupported ? "" : " (no creation feedback)",
+            (unsigned long long)mStats.asyncUsed, (unsigned long long)mStats.asyncCreated,
+            mStats.totalCreateTimeMs, mStats.maxCreateTimeMs);
+    }
+    save();
+    apiRelease();
+}
+
+PipelineCache::SharedPtr PipelineCache::create(std::shared_ptr<Device> pDevice, const std::string& filename, uint32_t workerCount) {
+    return SharedPtr(new PipelineCache(pDevice, filename, workerCount));
+}
+
+bool PipelineCache::save() {
+    uint64_t pipelinesCreated;
+    {
+        std::lock_guard<std::mutex> lock(mStatsMutex);
+        pipelinesCreated = mStats.pipelinesCreated;
+    }
+    if (mFilename.empty() || pipelinesCreated == mSavedPipelinesCreated) return true;
+
+    std::vector<uint8_t> data;
+    if (!apiGetData(data)) {
+        LOG_ERR("Unable to get pipeline cache data");
+        return false;
+    }
+
+    try {
+        fs::path dir = fs::path(mFilename).parent_path();
+        if (!dir.empty() && !fs::exists(dir)) fs::create_directories(dir);
+    } catch (fs::filesystem_error& e) {
+        LOG_ERR("Unable to create pipeline cache directory !!!\n %s", e.what());
+        return false;
+    }
+
+    // Write to a temporary file first so a crash never leaves a truncated cache behind
+    std::string tmpFilename = mFilename + ".tmp";
+    auto file = serialize(apiGetDeviceIdentity(), data.data(), data.size());
+    {
+        BinaryFileStream stream(tmpFilename, BinaryFileStream::Mode::Write);
+        stream.write(file.data(), file.size());
+        if (!stream.isGood()) {
+            LOG_ERR("Unable to write pipeline cache %s", tmpFilename.c_str());
+            stream.remove();
+            return false;
+        }
+    }
+    if (std::rename(tmpFilename.c_str(), mFilename.c_str()) != 0) {
+        LOG_ERR("Unable to replace pipeline cache %s", mFilename.c_str());
+        std::remove(tmpFilename.c_str());
+        return false;
+    }
+
+    mSavedPipelinesCreated = pipelinesCreated;
+    LOG_DBG("Saved %zu bytes of pipeline cache to %s", data.size(), mFilename.c_str());
+    return true;
+}
+
+void PipelineCache::recordCreation(double timeMs, bool cacheHit) {
+    std::lock_guard<std::mutex> lock(mStatsMutex);
+    mStats.pipelinesCreated++;
+    if (cacheHit) mStats.cacheHits++;
+    mStats.totalCreateTimeMs += timeMs;
+    mStats.maxCreateTimeMs = std::max(mStats.maxCreateTimeMs, timeMs);
+}
+
+void PipelineCache::recordAsyncUse() {
+    std::lock_guard<std::mutex> lock(mStatsMutex);
+    mStats.asyncUsed++;
+}
+
+PipelineCache::Stats PipelineCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mStatsMutex);
+    return mStats;
+}
+
+}  // namespace Falcor
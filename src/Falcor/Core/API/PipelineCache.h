@@ -0,0 +1,144 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#ifndef SRC_FALCOR_CORE_API_PIPELINECACHE_H_
+#define SRC_FALCOR_CORE_API_PIPELINECACHE_H_
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Falcor/Core/Framework.h"
+#include "Falcor/Utils/ThreadPool.h"
+
+namespace Falcor {
+
+class Device;
+
+/** Driver pipeline cache shared by all graphics and compute state objects of a device.
+    The cache is loaded from disk on creation and written back by save() and on destruction. The file is only
+    accepted if it was written by the same device and driver.
+    Also owns the worker threads GraphicsStateObject::createAsync() and ComputeStateObject::createAsync() run on.
+*/
+class dlldecl PipelineCache {
+ public:
+    using SharedPtr = std::shared_ptr<PipelineCache>;
+
+    /** Device and driver a cache file belongs to.
+    */
+    struct DeviceIdentity {
+        uint32_t vendorID = 0;
+        uint32_t deviceID = 0;
+        uint32_t driverVersion = 0;
+        uint8_t pipelineCacheUUID[16] = {};
+
+        bool operator==(const DeviceIdentity& other) const;
+        bool operator!=(const DeviceIdentity& other) const { return !(*this == other); }
+    };
+
+    struct Stats {
+        uint64_t pipelinesCreated = 0;      ///< Graphics and compute pipelines created through the cache.
+        uint64_t cacheHits = 0;             ///< Creations the driver served from the cache. Needs VK_EXT_pipeline_creation_feedback.
+        uint64_t asyncCreated = 0;          ///< State objects created on worker threads.
+        uint64_t asyncUsed = 0;             ///< Of those, the ones a draw or dispatch picked up.
+        double totalCreateTimeMs = 0.0;     ///< Time spent in pipeline creation, on any thread.
+        double maxCreateTimeMs = 0.0;
+        size_t loadedDataSize = 0;          ///< Bytes of cache data loaded from disk, 0 if there was no valid file.
+    };
+
+    ~PipelineCache();
+
+    /** Create the cache.
+        \param[in] filename File to load the cache from and save it to. Empty keeps the cache in memory only.
+        \param[in] workerCount Threads for asynchronous state object creation.
+    */
+    static SharedPtr create(std::shared_ptr<Device> pDevice, const std::string& filename, uint32_t workerCount = 2);
+
+    /** Write the cache data to the file. Only writes if pipelines were created since the last load or save.
+    */
+    bool save();
+
+    VkPipelineCache getApiHandle() const { return mApiHandle; }
+
+    /** Check if creation feedback is available, i.e. cache hits are counted.
+    */
+    bool isCreationFeedbackSupported() const { return mCreationFeedbackSupported; }
+
+    /** Record a pipeline creation. Called by the API backends, thread safe.
+    */
+    void recordCreation(double timeMs, bool cacheHit);
+
+    /** Record that a draw or dispatch used an asynchronously created state object.
+    */
+    void recordAsyncUse();
+
+    Stats getStats() const;
+
+    /** Run a state object creation on a worker thread.
+    */
+    template<typename F>
+    auto enqueue(F&& f) -> std::future<typename std::result_of<F()>::type> {
+        {
+            std::lock_guard<std::mutex> lock(mStatsMutex);
+            mStats.asyncCreated++;
+        }
+        return mpWorkers->enqueue(std::forward<F>(f));
+    }
+
+    /** Wrap raw driver cache data into the file format.
+    */
+    static std::vector<uint8_t> serialize(const DeviceIdentity& identity, const void* pData, size_t size);
+
+    /** Validate a cache file and extract the driver cache data from it.
+        Rejects files with a different identity, a corrupted payload, or driver data whose own header doesn't match.
+        \return True if data holds data to initialize the driver cache with.
+    */
+    static bool deserialize(const std::vector<uint8_t>& file, const DeviceIdentity& identity, std::vector<uint8_t>& data);
+
+ private:
+    PipelineCache(std::shared_ptr<Device> pDevice, const std::string& filename, uint32_t workerCount);
+    void apiInit(const std::vector<uint8_t>& initialData);
+    bool apiGetData(std::vector<uint8_t>& data) const;
+    void apiRelease();
+    DeviceIdentity apiGetDeviceIdentity() const;
+
+    std::shared_ptr<Device> mpDevice;
+    std::string mFilename;
+    VkPipelineCache mApiHandle = VK_NULL_HANDLE;
+    bool mCreationFeedbackSupported = false;
+    std::unique_ptr<ThreadPool> mpWorkers;
+
+    mutable std::mutex mStatsMutex;
+    Stats mStats;
+    uint64_t mSavedPipelinesCreated = 0;
+};
+
+}  // namespace Falcor
+
+#endif  // SRC_FALCOR_CORE_API_PIPELINECACHE_H_
@@ -85,6 +85,7 @@ const std::string to_string(Resource::State state) {
 
 void Resource::invalidateViews() const {
     //logInfo("Invalidating resource views");
+    std::lock_guard<std::mutex> lock(mViewsMutex);
     mSrvs.clear();
     mUavs.clear();
     mRtvs.clear();
@@ -30,6 +30,7 @@
 
 #include <string>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <unordered_map>
 
@@ -208,6 +209,7 @@ class dlldecl Resource : public std::enable_shared_from_this<Resource> {
     VmaAllocation mAllocation;
     size_t mID;
 
+    mutable std::mutex mViewsMutex;     ///< Guards the view maps, render graph passes sharing an input may create its views from worker threads
     mutable std::unordered_map<ResourceViewInfo, ShaderResourceView::SharedPtr, ViewInfoHashFunc> mSrvs;
     mutable std::unordered_map<ResourceViewInfo, RenderTargetView::SharedPtr, ViewInfoHashFunc> mRtvs;
     mutable std::unordered_map<ResourceViewInfo, DepthStencilView::SharedPtr, ViewInfoHashFunc> mDsvs;
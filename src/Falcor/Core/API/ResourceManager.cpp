@@ -6,6 +6,7 @@
 #include "ResourceManager.h"
 
 #include "Falcor/Utils/Image/LTX_Bitmap.h"
+#include "Falcor/Utils/Image/LTX_MipTail.h"
 #include "Falcor/Utils/Debug/debug.h"
 #include "Falcor/Utils/ConfigStore.h"
 
@@ -50,6 +51,7 @@ ResourceManager::SharedPtr ResourceManager::create(std::shared_ptr<Device> pDevi
 
     pMgr->mSparseTexturesEnabled = !config.get<bool>("vtoff", false);
     pMgr->mForceTexturesConversion = config.get<bool>("fconv", false);
+    pMgr->mCompressSparseTextures = config.get<bool>("vtbc", false);
     pMgr->deviceCacheMemSize = config.get<int>("deviceCacheMemSize", 536870912);  
     pMgr->hostCacheMemSize = config.get<int>("hostCacheMemSize", 1073741824); 
 
@@ -149,9 +151,9 @@ Texture::SharedPtr ResourceManager::createSparseTextureFromFile(const std::strin
         return nullptr;
     }
 
-    std::string ltxFilename = fullpath + ".ltx";
-
-    bool doCompression = false;
+    // Block compressed pages go to their own file so switching "vtbc" never picks up a stale conversion
+    bool doCompression = compress && mCompressSparseTextures;
+    std::string ltxFilename = fullpath + (doCompression ? ".bc.ltx" : ".ltx");
 
     auto search = mLoadedTexturesMap.find(ltxFilename);
     if(search != mLoadedTexturesMap.end()) {
@@ -166,18 +168,20 @@ Texture::SharedPtr ResourceManager::createSparseTextureFromFile(const std::strin
         return nullptr;
     } 
         
-    //if (doCompression) {
-    //    LOG_DBG("Compressing texture from format %s", to_string(texFormat).c_str());
-    //    texFormat = compressedFormat(texFormat);
-    //}
-
+    bool converted = false;
     if(mForceTexturesConversion || !fs::exists(ltxFilename) ) {
         LOG_DBG("Converting texture %s to LTX format ...",  fullpath.c_str());
-        LTX_Bitmap::convertToKtxFile(mpDevice, fullpath, ltxFilename, true);
+        LTX_Bitmap::convertToKtxFile(mpDevice, fullpath, ltxFilename, true, doCompression);
         LOG_DBG("Conversion done %s", ltxFilename.c_str());
+        converted = true;
     }
 
     auto pLtxBitmap = LTX_Bitmap::createFromFile(mpDevice, ltxFilename, true);
+    if (!pLtxBitmap && !converted) {
+        // Possibly written by an older version without a mip tail, convert again once
+        LTX_Bitmap::convertToKtxFile(mpDevice, fullpath, ltxFilename, true, doCompression);
+        pLtxBitmap = LTX_Bitmap::createFromFile(mpDevice, ltxFilename, true);
+    }
     if (!pLtxBitmap) {
         LOG_ERR("Error loading converted ltx bitmap from %s !!!", ltxFilename.c_str());
         pTex = nullptr;
@@ -216,6 +220,9 @@ Texture::SharedPtr ResourceManager::createSparseTextureFromFile(const std::strin
     if (pTex != nullptr) {
         mLoadedTexturesMap[ltxFilename] = pTex;
         mTextureLTXBitmapsMap[pTex->id()] = std::move(pLtxBitmap);
+
+        // The mip tail is always resident, upload it right away so distant surfaces have prefiltered texels before any page is loaded
+        fillMipTail(pTex);
     }
 
     return pTex;
@@ -256,7 +263,6 @@ void ResourceManager::loadPages(const Texture::SharedPtr& pTexture, const std::v
         mPages[pageID]->allocate();
     }
     pTexture->updateSparseBindInfo();
-    //fillMipTail(pTexture);
 
     // read data and fill pages
     auto pLtxBitmap = mTextureLTXBitmapsMap[textureID];
@@ -274,7 +280,6 @@ void ResourceManager::loadPages(const Texture::SharedPtr& pTexture, const std::v
 
     fclose(pFile);
 
-    //fillMipTail(pTexture);
     pTexture->updateSparseBindInfo();
 }
 
@@ -290,39 +295,41 @@ void ResourceManager::fillMipTail(const Texture::SharedPtr& pTexture) {
         return;
     }
 
-    auto pLtxBitmap = mTextureLTXBitmapsMap[textureID];
+    auto pLtxBitmap = it->second;
     auto pTex = pTexture.get();
 
-    //uint32_t mipLevel = pTex->mSparseImageMemoryRequirements.imageMipTailFirstLod;
-    //uint32_t width = std::max(pTex->mWidth >> pTex->mSparseImageMemoryRequirements.imageMipTailFirstLod, 1u);
-    //uint32_t height = std::max(pTex->mHeight >> pTex->mSparseImageMemoryRequirements.imageMipTailFirstLod, 1u);
-    //uint32_t depth = 1;
-
-    VkSparseImageMemoryBind mipTailimageMemoryBind{};
+    // The device decides which levels are in the mip tail, the LTX file stores the levels smaller than a page
+    uint32_t mipTailStart = pTex->getMipTailStart();
+    uint32_t mipLevelsCount = std::min<uint32_t>(pTex->getMipCount(), pLtxBitmap->getMipLevelsCount());
+    if (mipTailStart >= mipLevelsCount) return;
 
-    VkMemoryAllocateInfo memAllocInfo = {};
-    memAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    memAllocInfo.pNext = NULL;
-    memAllocInfo.allocationSize = pTex->mSparseImageMemoryRequirements.imageMipTailSize;
-    memAllocInfo.memoryTypeIndex = pTex->mMemoryTypeIndex;
-    
-    if ( VK_FAILED(vkAllocateMemory(mpDevice->getApiHandle(), &memAllocInfo, nullptr, &mipTailimageMemoryBind.memory)) ) {
-        LOG_ERR("Could not allocate memory !!!");
+    std::vector<uint8_t> mipTailData;
+    if (!pLtxBitmap->readMipTailData(mipTailData)) {
+        LOG_WARN("No mip tail stored in %s", pLtxBitmap->getFilename().c_str());
         return;
     }
 
-    for (uint32_t mipLevel = pTex->mMipTailStart; mipLevel < pTex->mMipLevels; mipLevel++) {
-
-        const uint32_t width = std::max(pTex->mWidth >> mipLevel, 1u);
-        const uint32_t height = std::max(pTex->mHeight >> mipLevel, 1u);
-        const uint32_t depth = 1;
+    auto layout = ltxGetMipTailLayout(pLtxBitmap->getWidth(), pLtxBitmap->getHeight(), pLtxBitmap->getMipLevelsCount(), pLtxBitmap->getMipTailStart(), pLtxBitmap->getFormat());
 
-        std::vector<unsigned char> tmpPage(65536, 255);
+    std::vector<uint32_t> mipLevels;
+    std::vector<size_t> offsets;
+    for (const auto& level : layout) {
+        if (level.mipLevel < mipTailStart || level.mipLevel >= mipLevelsCount) continue;
+        if (level.offset + level.size > mipTailData.size()) {
+            LOG_ERR("Truncated mip tail in %s !!!", pLtxBitmap->getFilename().c_str());
+            return;
+        }
+        mipLevels.push_back(level.mipLevel);
+        offsets.push_back(level.offset);
+    }
 
-        LOG_WARN("Fill mip tail level %u", mipLevel);
-        mpCtx->updateMipTailData(pTex, {0,0,0}, { width, height, depth }, mipLevel, tmpPage.data());
-        //mpCtx->updateSubresourceData(pTex, 0, tmpPage.data(), uint3(0), { width, height, depth });
+    if (mipTailStart < pLtxBitmap->getMipTailStart()) {
+        LOG_WARN("Mip tail of %s starts at level %u on the device but at level %u in the file, levels in between stay empty",
+            pLtxBitmap->getFilename().c_str(), mipTailStart, pLtxBitmap->getMipTailStart());
     }
+
+    // All levels in one staging buffer and one copy
+    mpCtx->updateMipTailData(pTex, mipLevels, offsets, mipTailData.data(), mipTailData.size());
     mpCtx->flush(true);
 }
 
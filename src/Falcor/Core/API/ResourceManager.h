@@ -57,6 +57,7 @@ class dlldecl ResourceManager: public std::enable_shared_from_this<ResourceManag
     friend class Device;
 
     bool mForceTexturesConversion = false;
+    bool mCompressSparseTextures = false;   ///< Store sparse texture pages block compressed, see LTX_Bitmap::convertToKtxFile()
     bool mSparseTexturesEnabled = true;
     bool mHasSparseResources = false;
 
@@ -31,7 +31,6 @@
 #include "Texture.h"
 #include "Device.h"
 #include "RenderContext.h"
-#include "Falcor/Utils/Threading.h"
 
 #include "Falcor/Utils/Debug/debug.h"
 
@@ -140,7 +139,7 @@ template<typename ViewClass>
 using CreateFuncType = std::function<typename ViewClass::SharedPtr(Texture* pTexture, uint32_t mostDetailedMip, uint32_t mipCount, uint32_t firstArraySlice, uint32_t arraySize)>;
 
 template<typename ViewClass, typename ViewMapType>
-typename ViewClass::SharedPtr findViewCommon(Texture* pTexture, uint32_t mostDetailedMip, uint32_t mipCount, uint32_t firstArraySlice, uint32_t arraySize, ViewMapType& viewMap, CreateFuncType<ViewClass> createFunc) {
+typename ViewClass::SharedPtr findViewCommon(Texture* pTexture, uint32_t mostDetailedMip, uint32_t mipCount, uint32_t firstArraySlice, uint32_t arraySize, ViewMapType& viewMap, std::mutex& viewsMutex, CreateFuncType<ViewClass> createFunc) {
     uint32_t resMipCount = 1;
     uint32_t resArraySize = 1;
 
@@ -173,10 +172,12 @@ typename ViewClass::SharedPtr findViewCommon(Texture* pTexture, uint32_t mostDet
 
     ResourceViewInfo view = ResourceViewInfo(mostDetailedMip, mipCount, firstArraySlice, arraySize);
 
-    if (viewMap.find(view) == viewMap.end()) {
-        viewMap[view] = createFunc(pTexture, mostDetailedMip, mipCount, firstArraySlice, arraySize);
+    std::lock_guard<std::mutex> lock(viewsMutex);
+    auto it = viewMap.find(view);
+    if (it == viewMap.end()) {
+        it = viewMap.emplace(view, createFunc(pTexture, mostDetailedMip, mipCount, firstArraySlice, arraySize)).first;
     }
-    return viewMap[view];
+    return it->second;
 }
 
 DepthStencilView::SharedPtr Texture::getDSV(uint32_t mipLevel, uint32_t firstArraySlice, uint32_t arraySize) {
@@ -184,7 +185,7 @@ DepthStencilView::SharedPtr Texture::getDSV(uint32_t mipLevel, uint32_t firstArr
         return DepthStencilView::create(pTexture->device(), pTexture->shared_from_this(), mostDetailedMip, firstArraySlice, arraySize);
     };
 
-    return findViewCommon<DepthStencilView>(this, mipLevel, 1, firstArraySlice, arraySize, mDsvs, createFunc);
+    return findViewCommon<DepthStencilView>(this, mipLevel, 1, firstArraySlice, arraySize, mDsvs, mViewsMutex, createFunc);
 }
 
 UnorderedAccessView::SharedPtr Texture::getUAV(uint32_t mipLevel, uint32_t firstArraySlice, uint32_t arraySize) {
@@ -192,7 +193,7 @@ UnorderedAccessView::SharedPtr Texture::getUAV(uint32_t mipLevel, uint32_t first
         return UnorderedAccessView::create(pTexture->device(), pTexture->shared_from_this(), mostDetailedMip, firstArraySlice, arraySize);
     };
 
-    return findViewCommon<UnorderedAccessView>(this, mipLevel, 1, firstArraySlice, arraySize, mUavs, createFunc);
+    return findViewCommon<UnorderedAccessView>(this, mipLevel, 1, firstArraySlice, arraySize, mUavs, mViewsMutex, createFunc);
 }
 
 ShaderResourceView::SharedPtr Texture::getSRV() {
@@ -209,7 +210,7 @@ RenderTargetView::SharedPtr Texture::getRTV(uint32_t mipLevel, uint32_t firstArr
         return RenderTargetView::create(pTexture->device(), pTexture->shared_from_this(), mostDetailedMip, firstArraySlice, arraySize);
     };
 
-    auto result = findViewCommon<RenderTargetView>(this, mipLevel, 1, firstArraySlice, arraySize, mRtvs, createFunc);
+    auto result = findViewCommon<RenderTargetView>(this, mipLevel, 1, firstArraySlice, arraySize, mRtvs, mViewsMutex, createFunc);
     if (!result) {
         LOG_ERR("ERROR findViewCommon<RenderTargetView> returned NULL");
     }
@@ -225,7 +226,7 @@ ShaderResourceView::SharedPtr Texture::getSRV(uint32_t mostDetailedMip, uint32_t
     if(mIsSparse)
         updateSparseBindInfo();
 
-    return findViewCommon<ShaderResourceView>(this, mostDetailedMip, mipCount, firstArraySlice, arraySize, mSrvs, createFunc);
+    return findViewCommon<ShaderResourceView>(this, mostDetailedMip, mipCount, firstArraySlice, arraySize, mSrvs, mViewsMutex, createFunc);
 }
 
 void Texture::captureToFile(uint32_t mipLevel, uint32_t arraySlice, const std::string& filename, Bitmap::FileFormat format, Bitmap::ExportFlags exportFlags) {
@@ -235,11 +236,7 @@ void Texture::captureToFile(uint32_t mipLevel, uint32_t arraySlice, const std::s
 
     readTextureData(mipLevel, arraySlice, textureData, resourceFormat, channels);
 
-    auto func = [=]() {
-        Bitmap::saveImage(filename, getWidth(mipLevel), getHeight(mipLevel), format, exportFlags, resourceFormat, true, (void*)(textureData.data()));
-    };
-
-    Threading::dispatchTask(func);
+    Bitmap::saveImageAsync(filename, getWidth(mipLevel), getHeight(mipLevel), format, exportFlags, resourceFormat, true, std::move(textureData));
 }
 
 void Texture::captureToFileBlocking(uint32_t mipLevel, uint32_t arraySlice, const std::string& filename, Bitmap::FileFormat format, Bitmap::ExportFlags exportFlags) {
@@ -144,8 +144,10 @@ Buffer::ApiHandle createBuffer(Device::SharedPtr pDevice, size_t size, Buffer::B
 
 void Buffer::apiInit(bool hasInitData) {
     if (mCpuAccess == CpuAccess::Write) {
-        mDynamicData = mpDevice->getUploadHeap()->allocate(mSize);
+        // The buffer doesn't exist yet to query its alignment. 256 bytes covers the uniform, storage and copy offset limits.
+        mDynamicData = mpDevice->getUploadHeap()->allocate(mSize, 256);
         mApiHandle = mDynamicData.pResourceHandle;
+        mGpuVaOffset = mDynamicData.offset;
     } else {
         if (mCpuAccess == CpuAccess::Read && mBindFlags == BindFlags::None) {
             mApiHandle = createBuffer(mpDevice, mSize, mBindFlags, Device::MemoryType::Readback);
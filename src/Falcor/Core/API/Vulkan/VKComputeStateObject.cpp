@@ -51,8 +51,8 @@ void ComputeStateObject::apiInit() {
     info.layout = mDesc.mpRootSignature->getApiHandle();
 
 
-    VkPipeline pipeline;
-    if (VK_FAILED(vkCreateComputePipelines(mpDevice->getApiHandle(), VK_NULL_HANDLE, 1, &info, nullptr, &pipeline))) {
+    VkPipeline pipeline = createVkComputePipeline(mpDevice, info);
+    if (pipeline == VK_NULL_HANDLE) {
         throw std::runtime_error("Could not create compute pipeline.");
     }
     mApiHandle = ApiHandle::create(mpDevice, pipeline);
@@ -280,41 +280,34 @@ namespace Falcor {
         vkCmdCopyBufferToImage(getLowLevelData()->getCommandList(), pStagingBuffer->getApiHandle(), pTexture->getApiHandle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &vkCopy);
     }
 
-    void CopyContext::updateMipTailData(const Texture* pTexture, const int3& offset, const uint3& extent, uint8_t mipLevel, const void* pData) {
+    void CopyContext::updateMipTailData(const Texture* pTexture, const std::vector<uint32_t>& mipLevels, const std::vector<size_t>& offsets, const void* pData, size_t dataSize) {
         assert(pTexture);
         assert(pData);
-
-        VkBufferImageCopy region{};
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.baseArrayLayer = 0;
-        region.imageSubresource.layerCount = 1;
-        region.imageSubresource.mipLevel = mipLevel;
-
-        region.bufferOffset = 0;
-        region.imageOffset = { offset.x, offset.y, offset.z };
-        region.imageExtent = { extent.x, extent.y, extent.z };
-
-        //region.imageOffset = { 0,0,0 };
-        //region.imageExtent = { 128 >> (int)mipLevel, 128 >> (int)mipLevel,1 };
-
-        Buffer::SharedPtr pStaging;
-        auto const format = pTexture->getFormat();
-
-        uint32_t numChannels = getFormatChannelCount(format);
-        uint32_t totalChannelsBits = 0;
-
-        for( uint32_t i = 0; i < numChannels; i++ ) {
-            totalChannelsBits += getNumChannelBits(format, i);
+        assert(mipLevels.size() == offsets.size());
+
+        if (mipLevels.empty()) return;
+
+        Buffer::SharedPtr pStaging = Buffer::create(mpDevice, dataSize, Buffer::BindFlags::None, Buffer::CpuAccess::Write, pData);
+
+        std::vector<VkBufferImageCopy> regions(mipLevels.size());
+        for (size_t i = 0; i < mipLevels.size(); i++) {
+            VkBufferImageCopy& region = regions[i];
+            region = {};
+            region.bufferOffset = pStaging->getGpuAddressOffset() + offsets[i];
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+            region.imageSubresource.mipLevel = mipLevels[i];
+            region.imageOffset = { 0, 0, 0 };
+            region.imageExtent = { pTexture->getWidth(mipLevels[i]), pTexture->getHeight(mipLevels[i]), 1 };
         }
 
-        size_t dataSize = region.imageExtent.width * region.imageExtent.height * region.imageExtent.depth * (totalChannelsBits / 8);
-        dataSize = 65536;
-        pStaging = Buffer::create(mpDevice, dataSize, Buffer::BindFlags::None, pData ? Buffer::CpuAccess::Write : Buffer::CpuAccess::Read, pData);
-
         // Execute the copy
         resourceBarrier(pTexture, Resource::State::CopyDest);
         resourceBarrier(pStaging.get(), Resource::State::CopySource);
-        vkCmdCopyBufferToImage(getLowLevelData()->getCommandList(), pStaging->getApiHandle(), pTexture->getApiHandle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        vkCmdCopyBufferToImage(getLowLevelData()->getCommandList(), pStaging->getApiHandle(), pTexture->getApiHandle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
     }
 
     CopyContext::ReadTextureTask::SharedPtr CopyContext::ReadTextureTask::create(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex) {
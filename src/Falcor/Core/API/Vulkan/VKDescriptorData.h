@@ -28,26 +28,82 @@
 #ifndef SRC_FALCOR_CORE_API_VULKAN_VKDESCRIPTORDATA_H_
 #define SRC_FALCOR_CORE_API_VULKAN_VKDESCRIPTORDATA_H_
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "Falcor/Core/API/Device.h"
+#include "Falcor/Core/API/DescriptorSet.h"
 
 namespace Falcor {
 
+/** Descriptor sets are carved from pages of VkDescriptorPools and never freed one by one. A page that ran out of space
+    is retired and reset as a whole once all its sets were released, which happens behind the frame fence.
+*/
 struct DescriptorPoolApiData {
-    DescriptorHeapHandle descriptorPool;
+    struct Page {
+        DescriptorHeapHandle pool;
+        std::vector<VkDescriptorPoolSize> freeSizes;    ///< Descriptors per type not allocated since the last reset
+        uint32_t freeSets = 0;                          ///< Sets not allocated since the last reset
+        uint32_t liveSets = 0;
+        bool retired = false;       ///< Full, no longer allocated from
+        bool dedicated = false;     ///< Sized for a single layout that doesn't fit a regular page, destroyed once empty
+    };
+
+    std::shared_ptr<Device> pDevice;
+    std::vector<VkDescriptorPoolSize> pageSizes;
+    uint32_t pageMaxSets = 0;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Page>> pages;
+    std::vector<Page*> freePages;
+    Page* pCurrent = nullptr;
+
+    std::atomic<uint64_t> setsAllocated = { 0 };
+    std::atomic<uint64_t> pagesCreated = { 0 };
+    std::atomic<uint64_t> pagesRecycled = { 0 };
+    std::atomic<uint64_t> writeCalls = { 0 };
+    std::atomic<uint64_t> descriptorsWritten = { 0 };
+
+    /** Allocate a set, opening a new page when the current one is full.
+        \param[out] pPage The page the set was allocated from, to be passed to releaseSet().
+    */
+    VkDescriptorSet allocateSet(VkDescriptorSetLayout layout, const DescriptorSet::Layout& desc, Page*& pPage);
+    void releaseSet(Page* pPage);
+
+ private:
+    Page* createPage(const std::vector<VkDescriptorPoolSize>& sizes, uint32_t maxSets, bool dedicated);
+    void retirePage(Page* pPage);
+    void recyclePage(Page* pPage);
 };
 
 struct DescriptorSetApiData {
-    DescriptorSetApiData(Device::SharedPtr device, VkDescriptorSetLayout l, VkDescriptorPool p, VkDescriptorSet s) : layout(l), set(s), pool(p), mpDevice(device) {}
-    
-    VkDescriptorSetLayout layout;
-    VkDescriptorPool pool;
+    DescriptorSetApiData(std::shared_ptr<DescriptorPoolApiData> pPoolData, DescriptorPoolApiData::Page* pPage, VkDescriptorSetLayout l, VkDescriptorSet s)
+        : layout(l), set(s), pPoolData(pPoolData), pPage(pPage) {}
+
+    VkDescriptorSetLayout layout;       ///< Owned by the device layout cache
     VkDescriptorSet set;
 
-    Device::SharedPtr mpDevice;
+    std::shared_ptr<DescriptorPoolApiData> pPoolData;
+    DescriptorPoolApiData::Page* pPage;
+
+    /** Writes recorded by DescriptorSet::setXXX() until flushWrites(). The info pointers are resolved at flush time
+        since the info arrays may reallocate while recording.
+    */
+    enum class InfoType { Image, Buffer, TexelBufferView };
+    struct WriteInfo {
+        InfoType type;
+        uint32_t index;
+    };
+    std::vector<VkWriteDescriptorSet> writes;
+    std::vector<WriteInfo> writeInfos;
+    std::vector<VkDescriptorImageInfo> imageInfos;
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    std::vector<VkBufferView> texelBufferViews;
 
     ~DescriptorSetApiData() {
-        vkFreeDescriptorSets(mpDevice->getApiHandle(), pool, 1, &set);
-        vkDestroyDescriptorSetLayout(mpDevice->getApiHandle(), layout, nullptr);
+        pPoolData->releaseSet(pPage);
     }
 };
 
@@ -26,6 +26,9 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "Falcor/stdafx.h"
+
+#include <algorithm>
+
 #include "Falcor/Core/API/DescriptorPool.h"
 #include "Falcor/Core/API/Device.h"
 #include "Falcor/Core/API/Vulkan/VKDescriptorData.h"
@@ -86,39 +89,154 @@ VkDescriptorType falcorToVkDescType(DescriptorPool::Type type) {
     }
 }
 
+namespace {
+
+// Pools are split into pages so sets can be recycled a page at a time instead of being freed individually
+const uint32_t kPagesPerPool = 16;
+const uint32_t kMinDescriptorsPerPage = 1024;
+const uint32_t kMaxSetsPerPage = 1024;
+
+void addPoolSize(std::vector<VkDescriptorPoolSize>& sizes, VkDescriptorType type, uint32_t count) {
+    for (auto& s : sizes) {
+        if (s.type == type) {
+            s.descriptorCount += count;
+            return;
+        }
+    }
+    sizes.push_back({ type, count });
+}
+
+bool fitsPage(const std::vector<VkDescriptorPoolSize>& pageSizes, const std::vector<VkDescriptorPoolSize>& setSizes) {
+    for (const auto& needed : setSizes) {
+        auto it = std::find_if(pageSizes.begin(), pageSizes.end(), [&needed](const VkDescriptorPoolSize& s) { return s.type == needed.type; });
+        if (it == pageSizes.end() || it->descriptorCount < needed.descriptorCount) return false;
+    }
+    return true;
+}
+
+// Only valid if fitsPage() returned true
+void takeFromPage(std::vector<VkDescriptorPoolSize>& pageSizes, const std::vector<VkDescriptorPoolSize>& setSizes) {
+    for (const auto& needed : setSizes) {
+        auto it = std::find_if(pageSizes.begin(), pageSizes.end(), [&needed](const VkDescriptorPoolSize& s) { return s.type == needed.type; });
+        it->descriptorCount -= needed.descriptorCount;
+    }
+}
+
+}  // namespace
+
 void DescriptorPool::apiInit() {
     //LOG_DBG("DescriptorPool apiInit");
     mpApiData = std::make_shared<DescriptorPool::ApiData>();
-    uint32_t totalDescCount = 0;
-    VkDescriptorPoolSize poolSizeForType[kTypeCount];
+    mpApiData->pDevice = mpDevice;
+    mpApiData->pageMaxSets = kMaxSetsPerPage;
 
-    uint32_t usedSlots = 0;
+    // Several Falcor types map to the same descriptor type, the counts are merged per page
     for (uint32_t i = 0; i < kTypeCount; i++) {
-        if(mDesc.mDescCount[i]) {
-            poolSizeForType[usedSlots].type = falcorToVkDescType((DescriptorPool::Type)i);
-            poolSizeForType[usedSlots].descriptorCount = mDesc.mDescCount[i];
-            totalDescCount += mDesc.mDescCount[usedSlots];
-            usedSlots++;
+        uint32_t count = mDesc.mDescCount[i];
+        if (count == 0) continue;
+        uint32_t pageCount = std::max(count / kPagesPerPool, std::min(count, kMinDescriptorsPerPage));
+        addPoolSize(mpApiData->pageSizes, falcorToVkDescType((DescriptorPool::Type)i), pageCount);
+    }
+    //LOG_DBG("DescriptorPool apiInit done");
+}
+
+const DescriptorPool::ApiHandle& DescriptorPool::getApiHandle(uint32_t heapIndex) const {
+    assert(heapIndex < mpApiData->pages.size());
+    return mpApiData->pages[heapIndex]->pool;
+}
+
+VkDescriptorSet DescriptorPoolApiData::allocateSet(VkDescriptorSetLayout layout, const DescriptorSet::Layout& desc, Page*& pPage) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<VkDescriptorPoolSize> setSizes;
+    for (size_t r = 0; r < desc.getRangeCount(); r++) {
+        const auto& range = desc.getRange(r);
+        addPoolSize(setSizes, falcorToVkDescType(range.type), range.descCount);
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    // Sets are never freed individually and the remaining capacity of a page is tracked, so an allocation only fails
+    // on a real error. Running a pool out of memory is invalid usage without VK_KHR_maintenance1.
+    if (!fitsPage(pageSizes, setSizes)) {
+        pPage = createPage(setSizes, 1, true);
+    } else {
+        if (pCurrent && (pCurrent->freeSets == 0 || !fitsPage(pCurrent->freeSizes, setSizes))) {
+            retirePage(pCurrent);
+            pCurrent = nullptr;
+        }
+        if (!pCurrent) {
+            if (freePages.size()) {
+                pCurrent = freePages.back();
+                freePages.pop_back();
+            } else {
+                pCurrent = createPage(pageSizes, pageMaxSets, false);
+            }
         }
+        pPage = pCurrent;
     }
 
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    allocInfo.descriptorPool = pPage->pool;
+    vk_call(vkAllocateDescriptorSets(pDevice->getApiHandle(), &allocInfo, &set));
+    takeFromPage(pPage->freeSizes, setSizes);
+    pPage->freeSets--;
+    if (pPage->dedicated) pPage->retired = true;
+
+    pPage->liveSets++;
+    setsAllocated++;
+    return set;
+}
+
+void DescriptorPoolApiData::releaseSet(Page* pPage) {
+    std::lock_guard<std::mutex> lock(mutex);
+    assert(pPage->liveSets > 0);
+    pPage->liveSets--;
+    if (pPage->retired && pPage->liveSets == 0) recyclePage(pPage);
+}
+
+DescriptorPoolApiData::Page* DescriptorPoolApiData::createPage(const std::vector<VkDescriptorPoolSize>& sizes, uint32_t maxSets, bool dedicated) {
     VkDescriptorPoolCreateInfo info = {};
     info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    info.maxSets = totalDescCount;
-    info.poolSizeCount = usedSlots;
-    info.pPoolSizes = poolSizeForType;
-    info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    info.maxSets = maxSets;
+    info.poolSizeCount = (uint32_t)sizes.size();
+    info.pPoolSizes = sizes.data();
 
     VkDescriptorPool pool;
-    if (VK_FAILED(vkCreateDescriptorPool(mpDevice->getApiHandle(), &info, nullptr, &pool))) {
+    if (VK_FAILED(vkCreateDescriptorPool(pDevice->getApiHandle(), &info, nullptr, &pool))) {
         throw std::runtime_error("Error creating descriptor pool!");
     }
-    mpApiData->descriptorPool = ApiHandle::create(mpDevice, pool);
-    //LOG_DBG("DescriptorPool apiInit done");
+
+    auto pPage = std::make_unique<Page>();
+    pPage->pool = DescriptorHeapHandle::create(pDevice, pool);
+    pPage->freeSizes = sizes;
+    pPage->freeSets = maxSets;
+    pPage->dedicated = dedicated;
+    pages.push_back(std::move(pPage));
+    pagesCreated++;
+    return pages.back().get();
 }
 
-const DescriptorPool::ApiHandle& DescriptorPool::getApiHandle(uint32_t heapIndex) const {
-    return mpApiData->descriptorPool;
+void DescriptorPoolApiData::retirePage(Page* pPage) {
+    pPage->retired = true;
+    if (pPage->liveSets == 0) recyclePage(pPage);
+}
+
+void DescriptorPoolApiData::recyclePage(Page* pPage) {
+    // All sets of the page were released after the GPU was done with them
+    if (pPage->dedicated) {
+        pages.erase(std::find_if(pages.begin(), pages.end(), [pPage](const std::unique_ptr<Page>& p) { return p.get() == pPage; }));
+        return;
+    }
+    vkResetDescriptorPool(pDevice->getApiHandle(), pPage->pool, 0);
+    pPage->freeSizes = pageSizes;
+    pPage->freeSets = pageMaxSets;
+    pPage->retired = false;
+    freePages.push_back(pPage);
+    pagesRecycled++;
 }
 
 }  // namespace Falcor
@@ -36,18 +36,14 @@
 
 namespace Falcor {
 
-    VkDescriptorSetLayout createDescriptorSetLayout(std::shared_ptr<Device> pDevice, const DescriptorSet::Layout& layout);
+    VkDescriptorSetLayout getDescriptorSetLayout(std::shared_ptr<Device> pDevice, const DescriptorSet::Layout& layout);
     VkDescriptorType falcorToVkDescType(DescriptorPool::Type type);
 
     void DescriptorSet::apiInit() {
-        auto layout = createDescriptorSetLayout(mpDevice, mLayout);
-        VkDescriptorSetAllocateInfo allocInfo = {};
-        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = mpPool->getApiHandle(0);
-        allocInfo.descriptorSetCount = 1;
-        allocInfo.pSetLayouts = &layout;
-        vk_call(vkAllocateDescriptorSets(mpPool->device()->getApiHandle(), &allocInfo, &mApiHandle));
-        mpApiData = std::make_shared<DescriptorSetApiData>(mpPool->device(), layout, mpPool->getApiHandle(0), mApiHandle);
+        auto layout = getDescriptorSetLayout(mpDevice, mLayout);
+        DescriptorPoolApiData::Page* pPage = nullptr;
+        mApiHandle = mpPool->mpApiData->allocateSet(layout, mLayout, pPage);
+        mpApiData = std::make_shared<DescriptorSetApiData>(mpPool->mpApiData, pPage, layout, mApiHandle);
     }
 
     DescriptorSet::CpuHandle DescriptorSet::getCpuHandle(uint32_t rangeIndex, uint32_t descInRange) const {
@@ -60,14 +56,50 @@ namespace Falcor {
         return nullptr;
     }
 
+    /** Record a single descriptor write. Consecutive array elements of a binding are merged into one write.
+    */
+    static void queueWrite(DescriptorSetApiData* pData, uint32_t bindIndex, uint32_t arrayIndex, VkDescriptorType type, DescriptorSetApiData::InfoType infoType, uint32_t infoIndex) {
+        if (pData->writes.size()) {
+            auto& last = pData->writes.back();
+            const auto& lastInfo = pData->writeInfos.back();
+            if (last.dstBinding == bindIndex && last.descriptorType == type && lastInfo.type == infoType &&
+                last.dstArrayElement + last.descriptorCount == arrayIndex && lastInfo.index + last.descriptorCount == infoIndex) {
+                last.descriptorCount++;
+                return;
+            }
+        }
+
+        VkWriteDescriptorSet write = {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = pData->set;
+        write.dstBinding = bindIndex;
+        write.dstArrayElement = arrayIndex;
+        write.descriptorType = type;
+        write.descriptorCount = 1;
+        pData->writes.push_back(write);
+        pData->writeInfos.push_back({ infoType, infoIndex });
+    }
+
+    static void queueImageWrite(DescriptorSetApiData* pData, uint32_t bindIndex, uint32_t arrayIndex, VkDescriptorType type, const VkDescriptorImageInfo& info) {
+        pData->imageInfos.push_back(info);
+        queueWrite(pData, bindIndex, arrayIndex, type, DescriptorSetApiData::InfoType::Image, (uint32_t)pData->imageInfos.size() - 1);
+    }
+
+    static void queueBufferWrite(DescriptorSetApiData* pData, uint32_t bindIndex, uint32_t arrayIndex, VkDescriptorType type, const VkDescriptorBufferInfo& info) {
+        pData->bufferInfos.push_back(info);
+        queueWrite(pData, bindIndex, arrayIndex, type, DescriptorSetApiData::InfoType::Buffer, (uint32_t)pData->bufferInfos.size() - 1);
+    }
+
+    static void queueTexelBufferWrite(DescriptorSetApiData* pData, uint32_t bindIndex, uint32_t arrayIndex, VkDescriptorType type, VkBufferView view) {
+        pData->texelBufferViews.push_back(view);
+        queueWrite(pData, bindIndex, arrayIndex, type, DescriptorSetApiData::InfoType::TexelBufferView, (uint32_t)pData->texelBufferViews.size() - 1);
+    }
+
     template<bool isUav, typename ViewType>
-    static void setSrvUavCommon(Device::SharedPtr device, VkDescriptorSet set, uint32_t bindIndex, uint32_t arrayIndex, const ViewType* pView, DescriptorPool::Type type) {
+    static void setSrvUavCommon(DescriptorSetApiData* pData, uint32_t bindIndex, uint32_t arrayIndex, const ViewType* pView, DescriptorPool::Type type) {
         //LOG_DBG("setSrvUavCommon descriptor type %s", to_string(type).c_str());
-        VkWriteDescriptorSet write = {};
-        VkDescriptorImageInfo image;
-        VkDescriptorBufferInfo buffer;
         typename ViewType::ApiHandle handle = pView->getApiHandle();
-        VkBufferView texelBufferView = {};
+        VkDescriptorType vkType = falcorToVkDescType(type);
 
         if (handle.getType() == VkResourceType::Buffer) {
             Buffer* pBuffer = dynamic_cast<Buffer*>(pView->getResource());
@@ -75,42 +107,30 @@ namespace Falcor {
             //LOG_DBG("Buffer %zu update descriptor set bindFlags %s", pBuffer->id(),to_string(pBuffer->getBindFlags()).c_str());
 
             if (pBuffer->isTyped()) {
-                texelBufferView = pBuffer->getUAV()->getApiHandle();
-                write.pTexelBufferView = &texelBufferView;
-                write.pBufferInfo = nullptr;
+                queueTexelBufferWrite(pData, bindIndex, arrayIndex, vkType, pBuffer->getUAV()->getApiHandle());
             } else {
+                VkDescriptorBufferInfo buffer;
                 buffer.buffer = pBuffer->getApiHandle();
                 buffer.offset = pBuffer->getGpuAddressOffset();
                 buffer.range = pBuffer->getSize();
-                write.pBufferInfo = &buffer;
-                write.pTexelBufferView = nullptr;
+                queueBufferWrite(pData, bindIndex, arrayIndex, vkType, buffer);
             }
-            write.pImageInfo = nullptr;
         } else {
             assert(handle.getType() == VkResourceType::Image);
+            VkDescriptorImageInfo image;
             image.imageLayout = isUav ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
             image.imageView = handle;
             image.sampler = nullptr;
-            write.pImageInfo = &image;
+            queueImageWrite(pData, bindIndex, arrayIndex, vkType, image);
         }
-
-        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        write.descriptorType = falcorToVkDescType(type);
-        write.dstSet = set;
-        write.dstBinding = bindIndex;
-        write.dstArrayElement = arrayIndex;
-        write.descriptorCount = 1;
-
-        //LOG_DBG("vkUpdateDescriptorSets 1");
-        vkUpdateDescriptorSets(device->getApiHandle(), 1, &write, 0, nullptr);
     }
 
     void DescriptorSet::setSrv(uint32_t rangeIndex, uint32_t descIndex, const ShaderResourceView* pSrv) {
-        setSrvUavCommon<false>(mpPool->device(), mApiHandle, mLayout.getRange(rangeIndex).baseRegIndex, descIndex, pSrv, mLayout.getRange(rangeIndex).type);
+        setSrvUavCommon<false>(mpApiData.get(), mLayout.getRange(rangeIndex).baseRegIndex, descIndex, pSrv, mLayout.getRange(rangeIndex).type);
     }
 
     void DescriptorSet::setUav(uint32_t rangeIndex, uint32_t descIndex, const UnorderedAccessView* pUav) {
-        setSrvUavCommon<true>(mpPool->device(), mApiHandle, mLayout.getRange(rangeIndex).baseRegIndex, descIndex, pUav, mLayout.getRange(rangeIndex).type);
+        setSrvUavCommon<true>(mpApiData.get(), mLayout.getRange(rangeIndex).baseRegIndex, descIndex, pUav, mLayout.getRange(rangeIndex).type);
     }
 
     void DescriptorSet::setSampler(uint32_t rangeIndex, uint32_t descIndex, const Sampler* pSampler) {
@@ -118,44 +138,46 @@ namespace Falcor {
         info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
         info.imageView = nullptr;
         info.sampler = pSampler->getApiHandle();
-
-        VkWriteDescriptorSet write = {};
-        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        write.dstSet = mApiHandle;
-        write.dstBinding = mLayout.getRange(rangeIndex).baseRegIndex;
-        write.dstArrayElement = descIndex;
-        write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-        write.descriptorCount = 1;
-        write.pImageInfo = &info;
-
-        //LOG_DBG("vkUpdateDescriptorSets 2");
-        vkUpdateDescriptorSets(mpPool->device()->getApiHandle(), 1, &write, 0, nullptr);
-        //LOG_DBG("vkUpdateDescriptorSets 2 done");
+        queueImageWrite(mpApiData.get(), mLayout.getRange(rangeIndex).baseRegIndex, descIndex, VK_DESCRIPTOR_TYPE_SAMPLER, info);
     }
 
     void DescriptorSet::setCbv(uint32_t rangeIndex, uint32_t descIndex, ConstantBufferView* pView) {
         //LOG_DBG("setCbv rangeIndex %u, descIndex %u, range type %s", rangeIndex, descIndex, to_string((DescriptorPool::Type)mLayout.getRange(rangeIndex).type).c_str());
-        VkDescriptorBufferInfo info;
-
         const auto& pBuffer = dynamic_cast<const Buffer*>(pView->getResource());
         assert(pBuffer);
+
+        VkDescriptorBufferInfo info;
         info.buffer = pBuffer->getApiHandle();
         info.offset = pBuffer->getGpuAddressOffset();
         info.range = pBuffer->getSize();
+        queueBufferWrite(mpApiData.get(), mLayout.getRange(rangeIndex).baseRegIndex, descIndex, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, info);
+    }
 
-        VkWriteDescriptorSet write = {};
-        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        write.dstSet = mApiHandle;
-        write.dstBinding = mLayout.getRange(rangeIndex).baseRegIndex;
-        write.dstArrayElement = descIndex;
-        write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        write.descriptorCount = 1;
-        write.pBufferInfo = &info;
+    void DescriptorSet::flushWrites() {
+        auto& data = *mpApiData;
+        if (data.writes.empty()) return;
+
+        uint64_t descriptorCount = 0;
+        for (size_t i = 0; i < data.writes.size(); i++) {
+            auto& write = data.writes[i];
+            const auto& info = data.writeInfos[i];
+            switch (info.type) {
+                case DescriptorSetApiData::InfoType::Image: write.pImageInfo = &data.imageInfos[info.index]; break;
+                case DescriptorSetApiData::InfoType::Buffer: write.pBufferInfo = &data.bufferInfos[info.index]; break;
+                case DescriptorSetApiData::InfoType::TexelBufferView: write.pTexelBufferView = &data.texelBufferViews[info.index]; break;
+            }
+            descriptorCount += write.descriptorCount;
+        }
+
+        vkUpdateDescriptorSets(mpDevice->getApiHandle(), (uint32_t)data.writes.size(), data.writes.data(), 0, nullptr);
+        data.pPoolData->writeCalls++;
+        data.pPoolData->descriptorsWritten += descriptorCount;
 
-        //LOG_DBG("Buffer %zu update descriptor set bindFlags %s", pBuffer->id(),to_string(pBuffer->getBindFlags()).c_str());
-        //LOG_DBG("vkUpdateDescriptorSets 3");
-        vkUpdateDescriptorSets(mpPool->device()->getApiHandle(), 1, &write, 0, nullptr);
-        //LOG_DBG("vkUpdateDescriptorSets 3 done");
+        data.writes.clear();
+        data.writeInfos.clear();
+        data.imageInfos.clear();
+        data.bufferInfos.clear();
+        data.texelBufferViews.clear();
     }
 
     template<bool forGraphics>
@@ -166,10 +188,12 @@ namespace Falcor {
     }
 
     void DescriptorSet::bindForGraphics(CopyContext* pCtx, const RootSignature* pRootSig, uint32_t rootIndex) {
+        flushWrites();
         bindCommon<true>(mApiHandle, pCtx, pRootSig, rootIndex);
     }
 
     void DescriptorSet::bindForCompute(CopyContext* pCtx, const RootSignature* pRootSig, uint32_t rootIndex) {
+        flushWrites();
         bindCommon<false>(mApiHandle, pCtx, pRootSig, rootIndex);
     }
 
@@ -25,6 +25,7 @@
  # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
+#include <algorithm>
 #include <set>
 
 #include "Falcor/stdafx.h"
@@ -33,6 +34,7 @@
 #include "Falcor/Core/API/DescriptorPool.h"
 #include "Falcor/Core/API/GpuFence.h"
 #include "Falcor/Core/API/Vulkan/FalcorVK.h"
+#include "Falcor/Core/API/Vulkan/VKDescriptorData.h"
 #include "Falcor/Utils/Debug/debug.h"
 #include "Falcor.h"
 
@@ -214,11 +216,35 @@ void Device::destroyApiObjects() {
         vkDestroyFence(mApiHandle, f, nullptr);
     }
 
+    for (auto& bucket : mpApiData->descriptorSetLayouts.layouts) {
+        for (auto& entry : bucket.second) vkDestroyDescriptorSetLayout(mApiHandle, entry.second, nullptr);
+    }
+    mpApiData->descriptorSetLayouts.layouts.clear();
+
     //vmaDestroyAllocator(mAllocator);
 
     safe_delete(mpApiData);
 }
 
+Device::DescriptorStats Device::getDescriptorStats() const {
+    DescriptorStats stats;
+    {
+        std::lock_guard<std::mutex> lock(mpApiData->descriptorSetLayouts.mutex);
+        stats.layoutsCreated = mpApiData->descriptorSetLayouts.created;
+        stats.layoutRequests = mpApiData->descriptorSetLayouts.requests;
+    }
+    for (const auto& pPool : { mpGpuDescPool, mpCpuDescPool }) {
+        if (!pPool) continue;
+        const auto* pData = pPool->getApiData();
+        stats.setsAllocated += pData->setsAllocated;
+        stats.poolPagesCreated += pData->pagesCreated;
+        stats.poolPagesRecycled += pData->pagesRecycled;
+        stats.writeCalls += pData->writeCalls;
+        stats.descriptorsWritten += pData->descriptorsWritten;
+    }
+    return stats;
+}
+
 static std::vector<VkLayerProperties> enumarateInstanceLayersProperties() {
     uint32_t layerCount = 0;
     vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
@@ -478,6 +504,13 @@ VkDevice createLogicalDevice(VkPhysicalDevice physicalDevice, DeviceApiData *pDa
         }
     }
 
+#ifdef VK_EXT_pipeline_creation_feedback
+    // Optional, lets the pipeline cache count hits
+    pData->pipelineCreationFeedback = isExtensionSupported(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME, pData->deviceExtensions);
+    bool feedbackRequested = std::any_of(extensionNames.begin(), extensionNames.end(), [](const char* name) { return std::string(name) == VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME; });
+    if (pData->pipelineCreationFeedback && !feedbackRequested) extensionNames.push_back(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+#endif
+
     // Logical Device
     VkDeviceCreateInfo deviceInfo = {};
     deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -29,7 +29,13 @@
 #define SRC_FALCOR_CORE_API_VULKAN_VKDEVICE_H_
 
 #include "Falcor/Core/API/Vulkan/FalcorVK.h"
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "Falcor/Core/API/Device.h"
+#include "Falcor/Core/API/DescriptorSet.h"
 
 namespace Falcor {
 
@@ -53,6 +59,16 @@ struct DeviceApiData {
     uint32_t vkMemoryTypeBits[(uint32_t)Device::MemoryType::Count];
     VkPhysicalDeviceLimits deviceLimits;
     std::vector<VkExtensionProperties> deviceExtensions;
+    bool pipelineCreationFeedback = false;     ///< VK_EXT_pipeline_creation_feedback is enabled
+
+    /** Descriptor set layouts shared by all sets and root signatures, destroyed with the device.
+    */
+    struct {
+        std::mutex mutex;
+        std::unordered_map<size_t, std::vector<std::pair<DescriptorSet::Layout, VkDescriptorSetLayout>>> layouts;    ///< Layout hash -> layouts with that hash
+        uint64_t created = 0;
+        uint64_t requests = 0;
+    } descriptorSetLayouts;
 
     struct {
         std::vector<VkFence> f;
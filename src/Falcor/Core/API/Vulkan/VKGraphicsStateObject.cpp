@@ -106,8 +106,8 @@ namespace Falcor {
         pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
         pipelineCreateInfo.basePipelineIndex = 0;
 
-        VkPipeline pipeline;
-        if (VK_FAILED(vkCreateGraphicsPipelines(mpDevice->getApiHandle(), VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &pipeline))) {
+        VkPipeline pipeline = createVkGraphicsPipeline(mpDevice, pipelineCreateInfo);
+        if (pipeline == VK_NULL_HANDLE) {
             throw std::runtime_error("Could not create graphics pipeline.");
         }
         mApiHandle = ApiHandle::create(mpDevice, pipeline);
@@ -0,0 +1,80 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Falcor/stdafx.h"
+#include "Falcor/Core/API/PipelineCache.h"
+#include "Falcor/Core/API/Device.h"
+#include "Falcor/Core/API/Vulkan/VKDevice.h"
+
+namespace Falcor {
+
+void PipelineCache::apiInit(const std::vector<uint8_t>& initialData) {
+    VkPipelineCacheCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    info.initialDataSize = initialData.size();
+    info.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+    if (VK_FAILED(vkCreatePipelineCache(mpDevice->getApiHandle(), &info, nullptr, &mApiHandle))) {
+        // Try again without the loaded data before giving up
+        info.initialDataSize = 0;
+        info.pInitialData = nullptr;
+        mStats.loadedDataSize = 0;
+        if (VK_FAILED(vkCreatePipelineCache(mpDevice->getApiHandle(), &info, nullptr, &mApiHandle))) {
+            throw std::runtime_error("Could not create pipeline cache.");
+        }
+    }
+
+    mCreationFeedbackSupported = mpDevice->apiData()->pipelineCreationFeedback;
+}
+
+bool PipelineCache::apiGetData(std::vector<uint8_t>& data) const {
+    size_t size = 0;
+    if (VK_FAILED(vkGetPipelineCacheData(mpDevice->getApiHandle(), mApiHandle, &size, nullptr))) return false;
+    data.resize(size);
+    if (VK_FAILED(vkGetPipelineCacheData(mpDevice->getApiHandle(), mApiHandle, &size, data.data()))) return false;
+    data.resize(size);
+    return true;
+}
+
+void PipelineCache::apiRelease() {
+    if (mApiHandle != VK_NULL_HANDLE) {
+        vkDestroyPipelineCache(mpDevice->getApiHandle(), mApiHandle, nullptr);
+        mApiHandle = VK_NULL_HANDLE;
+    }
+}
+
+PipelineCache::DeviceIdentity PipelineCache::apiGetDeviceIdentity() const {
+    const auto& properties = mpDevice->apiData()->properties;
+    DeviceIdentity identity;
+    identity.vendorID = properties.vendorID;
+    identity.deviceID = properties.deviceID;
+    identity.driverVersion = properties.driverVersion;
+    std::memcpy(identity.pipelineCacheUUID, properties.pipelineCacheUUID, sizeof(identity.pipelineCacheUUID));
+    return identity;
+}
+
+}  // namespace Falcor
@@ -25,11 +25,13 @@
  # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
+#include <mutex>
 #include <set>
 
 #include "Falcor/stdafx.h"
 #include "Falcor/Core/API/RootSignature.h"
 #include "Falcor/Core/API/Device.h"
+#include "Falcor/Core/API/Vulkan/VKDevice.h"
 #include "Falcor/Utils/Debug/debug.h"
 
 namespace Falcor {
@@ -66,7 +68,7 @@ namespace Falcor {
         return flags;
     }
 
-    VkDescriptorSetLayout createDescriptorSetLayout(std::shared_ptr<Device> pDevice, const DescriptorSet::Layout& layout) {
+    static VkDescriptorSetLayout createDescriptorSetLayout(std::shared_ptr<Device> pDevice, const DescriptorSet::Layout& layout) {
         //LOG_DBG("createDescriptorSetLayout");
         std::vector<VkDescriptorSetLayoutBinding> bindings(layout.getRangeCount());
 
@@ -100,6 +102,25 @@ namespace Falcor {
         return vkHandle;
     }
 
+    /** Get the layout object for a set layout, creating it on first use. Layouts are owned by the device and shared
+        by all descriptor sets and root signatures.
+    */
+    VkDescriptorSetLayout getDescriptorSetLayout(std::shared_ptr<Device> pDevice, const DescriptorSet::Layout& layout) {
+        auto& cache = pDevice->apiData()->descriptorSetLayouts;
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        cache.requests++;
+
+        auto& bucket = cache.layouts[layout.getHash()];
+        for (const auto& entry : bucket) {
+            if (entry.first == layout) return entry.second;
+        }
+
+        VkDescriptorSetLayout vkHandle = createDescriptorSetLayout(pDevice, layout);
+        bucket.emplace_back(layout, vkHandle);
+        cache.created++;
+        return vkHandle;
+    }
+
     void RootSignature::apiInit() {
         // Find the max set index
         uint32_t maxIndex = 0;
@@ -108,11 +129,11 @@ namespace Falcor {
             maxIndex = std::max(set.getRange(0).regSpace, maxIndex);
         }
 
-        static VkDescriptorSetLayout emptyLayout = createDescriptorSetLayout(mpDevice, {});   // #VKTODO This gets deleted multiple times on exit
+        VkDescriptorSetLayout emptyLayout = getDescriptorSetLayout(mpDevice, {});
         std::vector<VkDescriptorSetLayout> vkSetLayouts(maxIndex + 1, emptyLayout);
 
         for (const auto& set : mDesc.mSets) {
-            vkSetLayouts[set.getRange(0).regSpace] = createDescriptorSetLayout(mpDevice, set); //createDescriptorSetLayout() verifies that all ranges use the same register space
+            vkSetLayouts[set.getRange(0).regSpace] = getDescriptorSetLayout(mpDevice, set); //createDescriptorSetLayout() verifies that all ranges use the same register space
         }
 
         VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
@@ -29,6 +29,8 @@
 #include "VKState.h"
 #include "Falcor/Core/API/FBO.h"
 #include "Falcor/Core/API/Device.h"
+#include "Falcor/Core/API/PipelineCache.h"
+#include "Falcor/Utils/Timing/CpuTimer.h"
 
 #include "Falcor/Utils/Debug/debug.h"
 
@@ -558,4 +560,61 @@ namespace Falcor {
         infoOut.info.pDependencies = nullptr;
     }
 
+    const void* PipelineCreationFeedback::chain(const void* pNext, uint32_t stageCount, bool enable) {
+        enabled = enable;
+#ifdef VK_EXT_pipeline_creation_feedback
+        if (!enabled) return pNext;
+        stages.assign(stageCount, {});
+        info = {};
+        info.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+        info.pNext = pNext;
+        info.pPipelineCreationFeedback = &pipeline;
+        info.pipelineStageCreationFeedbackCount = stageCount;
+        info.pPipelineStageCreationFeedbacks = stages.data();
+        return &info;
+#else
+        enabled = false;
+        return pNext;
+#endif
+    }
+
+    bool PipelineCreationFeedback::isCacheHit() const {
+#ifdef VK_EXT_pipeline_creation_feedback
+        return enabled && (pipeline.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT) &&
+            (pipeline.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT);
+#else
+        return false;
+#endif
+    }
+
+    template<typename CreateInfo, typename CreateFunc>
+    static VkPipeline createVkPipeline(const std::shared_ptr<Device>& pDevice, CreateInfo& info, uint32_t stageCount, CreateFunc createFunc) {
+        const auto& pCache = pDevice->getPipelineCache();
+        VkPipelineCache cacheHandle = pCache ? pCache->getApiHandle() : VK_NULL_HANDLE;
+
+        PipelineCreationFeedback feedback;
+        info.pNext = feedback.chain(info.pNext, stageCount, pCache && pCache->isCreationFeedbackSupported());
+
+        auto start = CpuTimer::getCurrentTimePoint();
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkResult result = createFunc(pDevice->getApiHandle(), cacheHandle, &info, &pipeline);
+        double timeMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+        if (VK_FAILED(result)) return VK_NULL_HANDLE;
+        if (pCache) pCache->recordCreation(timeMs, feedback.isCacheHit());
+        return pipeline;
+    }
+
+    VkPipeline createVkGraphicsPipeline(const std::shared_ptr<Device>& pDevice, VkGraphicsPipelineCreateInfo& info) {
+        return createVkPipeline(pDevice, info, info.stageCount, [](VkDevice device, VkPipelineCache cache, const VkGraphicsPipelineCreateInfo* pInfo, VkPipeline* pPipeline) {
+            return vkCreateGraphicsPipelines(device, cache, 1, pInfo, nullptr, pPipeline);
+        });
+    }
+
+    VkPipeline createVkComputePipeline(const std::shared_ptr<Device>& pDevice, VkComputePipelineCreateInfo& info) {
+        return createVkPipeline(pDevice, info, 1, [](VkDevice device, VkPipelineCache cache, const VkComputePipelineCreateInfo* pInfo, VkPipeline* pPipeline) {
+            return vkCreateComputePipelines(device, cache, 1, pInfo, nullptr, pPipeline);
+        });
+    }
+
 }  // namespace Falcor
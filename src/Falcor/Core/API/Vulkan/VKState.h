@@ -52,6 +52,31 @@ namespace Falcor {
         VkRenderPassCreateInfo info;
     };
 
+    /** Pipeline creation feedback to chain into a pipeline create info, so the pipeline cache can count hits.
+        Does nothing when VK_EXT_pipeline_creation_feedback isn't enabled.
+    */
+    struct PipelineCreationFeedback {
+#ifdef VK_EXT_pipeline_creation_feedback
+        VkPipelineCreationFeedbackEXT pipeline = {};
+        std::vector<VkPipelineCreationFeedbackEXT> stages;
+        VkPipelineCreationFeedbackCreateInfoEXT info = {};
+#endif
+        bool enabled = false;
+
+        /** Chain into a create info. stageCount must match the create info's stage count.
+        */
+        const void* chain(const void* pNext, uint32_t stageCount, bool enable);
+
+        /** Check if the driver reported the pipeline as found in the pipeline cache.
+        */
+        bool isCacheHit() const;
+    };
+
+    /** Create graphics or compute pipelines through the device's pipeline cache and record the creation time and cache hits.
+    */
+    VkPipeline createVkGraphicsPipeline(const std::shared_ptr<Device>& pDevice, VkGraphicsPipelineCreateInfo& info);
+    VkPipeline createVkComputePipeline(const std::shared_ptr<Device>& pDevice, VkComputePipelineCreateInfo& info);
+
     //void initVkShaderStageInfo(const ProgramVersion* pProgram, std::vector<VkPipelineShaderStageCreateInfo>& infosOut);
     void initVkShaderStageInfo(const ProgramKernels::SharedConstPtr& pProgramKernels, std::vector<VkPipelineShaderStageCreateInfo>& infosOut);
     void initVkBlendInfo(const Fbo::Desc& fboDesc, const BlendState* pState, ColorBlendStateCreateInfo& infoOut);
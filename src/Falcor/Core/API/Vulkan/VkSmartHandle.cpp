@@ -125,10 +125,8 @@ namespace Falcor {
     }
 
     VkRootSignature::~VkRootSignature() {
+        // The set layouts are owned by the device layout cache
         vkDestroyPipelineLayout(mpDevice->getApiHandle(), mApiHandle, nullptr);
-        for (auto& s : mSets) {
-            vkDestroyDescriptorSetLayout(mpDevice->getApiHandle(), s, nullptr);
-        }
     }
 
 
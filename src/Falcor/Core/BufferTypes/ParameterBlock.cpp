@@ -1570,6 +1570,9 @@ bool ParameterBlock::bindIntoDescriptorSet(const ParameterBlockReflection* pRefl
                 pSet,
                 setIndex,
                 destRangeIndex);
+
+            // Sub-blocks wrote into the same set, submit everything in one update
+            pSet->flushWrites();
         }
 
         return true;
@@ -92,6 +92,13 @@ class ParameterBlockSharedPtr : public std::shared_ptr<T> {
     ShaderVar operator[](UniformShaderVarOffset offset) const {
         return getRootVar()[offset];
     }
+
+    /** Get a shader variable from a pre-resolved handle.
+        This is an alias for `getRootVar()[handle]`.
+    */
+    ShaderVar operator[](const ShaderVarHandle& handle) const {
+        return getRootVar()[handle];
+    }
 };
 
 /** A parameter block. This block stores all the parameter data associated with a specific type in shader code
@@ -27,6 +27,7 @@
  **************************************************************************/
 #include "Falcor/stdafx.h"
 #include "Program.h"
+#include <mutex>
 #include "slang/slang.h"
 #include "Falcor/Utils/StringUtils.h"
 #include "Falcor/Utils/Debug/debug.h"
@@ -41,6 +42,9 @@ const std::string kSupportedShaderModels[] = { "4_0", "4_1", "5_0", "5_1", "6_0"
 
 static Program::DefineList sGlobalDefineList;
 
+// Slang sessions share the global session, which is not thread safe. Render graph passes recording on worker threads may link concurrently.
+static std::mutex sSlangMutex;
+
 static Shader::SharedPtr createShaderFromBlob(std::shared_ptr<Device> pDevice, const Shader::Blob& shaderBlob, ShaderType shaderType, const std::string& entryPointName, Shader::CompilerFlags flags, std::string& log) {
     std::string errorMsg;
     auto pShader = Shader::create(pDevice, shaderBlob, shaderType, entryPointName, flags, log);
@@ -575,6 +579,7 @@ ProgramKernels::SharedPtr Program::preprocessAndCreateProgramKernels(
     ProgramVars    const* pVars,
     std::string         & log) const
 {
+    std::lock_guard<std::mutex> lock(sSlangMutex);
     auto pSlangGlobalScope = pVersion->getSlangGlobalScope();
     auto pSlangSession = pSlangGlobalScope->getSession();
 
@@ -747,6 +752,7 @@ ProgramKernels::SharedPtr Program::preprocessAndCreateProgramKernels(
 }
 
 ProgramVersion::SharedPtr Program::preprocessAndCreateProgramVersion(std::string& log) const {
+    std::lock_guard<std::mutex> lock(sSlangMutex);
     TimeReport timeReport;
 
     auto pSlangRequest = createSlangCompileRequest(mDefineList);
@@ -278,6 +278,78 @@ namespace Falcor
         return ShaderVar();
     }
 
+    namespace
+    {
+        bool isConstantBuffer(const ReflectionType* pType)
+        {
+            auto pResourceType = pType->asResourceType();
+            return pResourceType && pResourceType->getType() == ReflectionResourceType::Type::ConstantBuffer;
+        }
+    }
+
+    ShaderVar ShaderVar::operator[](const ShaderVarHandle& handle) const
+    {
+        if (!isValid()) return *this;
+        auto pType = getType();
+
+        // Same implicit dereference of constant buffers and parameter blocks as the lookups by name
+        if (isConstantBuffer(pType.get())) return getParameterBlock()->getRootVar()[handle];
+
+#ifdef _DEBUG
+        if (!handle.isResolvedFor(*this))
+        {
+            logError("Shader variable handle '" + handle.getPath() + "' was resolved against another type. Resolve it again after the program changed.");
+            assert(false);
+        }
+#endif
+        if (!handle.isValid()) return ShaderVar();
+
+        const auto& offset = handle.getBindLocation();
+        return ShaderVar(mpBlock, TypedShaderVarOffset(offset.getType().get(), mOffset + offset));
+    }
+
+    bool ShaderVarHandle::resolve(const ShaderVar& parent)
+    {
+        mOffset = TypedShaderVarOffset();
+        mpParentType = nullptr;
+        if (!parent.isValid()) return false;
+
+        ShaderVar base = isConstantBuffer(parent.getType().get()) ? parent.getParameterBlock()->getRootVar() : parent;
+        auto pParentType = base.getType();
+
+        // Walk the path from a zero offset so the result can be applied to any variable of the parent type
+        TypedShaderVarOffset offset = pParentType->getZeroOffset();
+        size_t begin = 0;
+        while (true)
+        {
+            size_t end = mPath.find('.', begin);
+            std::string name = mPath.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+
+            auto pMember = offset.getType()->findMember(name);
+            if (!pMember)
+            {
+                logError("Can't resolve shader variable handle '" + mPath + "', no member named '" + name + "' found.");
+                return false;
+            }
+            offset = TypedShaderVarOffset(pMember->getType().get(), offset + pMember->getBindLocation());
+
+            if (end == std::string::npos) break;
+            begin = end + 1;
+        }
+
+        mOffset = offset;
+        mpParentType = pParentType;
+        return true;
+    }
+
+    bool ShaderVarHandle::isResolvedFor(const ShaderVar& parent) const
+    {
+        if (!mpParentType || !parent.isValid()) return false;
+        auto pType = parent.getType();
+        if (pType == mpParentType) return true;
+        return isConstantBuffer(pType.get()) && parent.getParameterBlock()->getElementType() == mpParentType;
+    }
+
     bool ShaderVar::isValid() const
     {
         return mOffset.isValid();
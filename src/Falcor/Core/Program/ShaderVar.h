@@ -38,6 +38,7 @@
 namespace Falcor {
 
 class ParameterBlock;
+class ShaderVarHandle;
 
 template<typename T>
 class ParameterBlockSharedPtr;
@@ -318,6 +319,14 @@ struct dlldecl ShaderVar {
     */
     ShaderVar operator[](UniformShaderVarOffset const& offset) const;
 
+    /** Create a shader variable from a pre-resolved handle.
+
+        This is the fast path for binding code that runs every frame: no reflection lookup by name is done.
+        The handle must have been resolved against the type this variable points to. Debug builds check that and
+        report handles that went stale because the program was recompiled.
+    */
+    ShaderVar operator[](const ShaderVarHandle& handle) const;
+
     /** Implicit conversion from a shader variable to a texture.
         This operation allows a bound texture to be queried using the `[]` syntax:
             pTexture = pVars["someTexture"];
@@ -389,6 +398,55 @@ struct dlldecl ShaderVar {
     template<typename T> bool setImpl(const T& val) const;
 };
 
+/** A member path resolved against a reflection type once and reused for every bind.
+
+    Looking a variable up by name walks the reflection on every call. A handle does the walk once and keeps the
+    resulting offset, which is relative to the type it was resolved against:
+
+        ShaderVarHandle baseColor("baseColor");
+
+        // Once per program version
+        baseColor.resolve(pBlock["materials"][0]);
+
+        // Every frame
+        pBlock["materials"][i][baseColor] = pTexture;
+
+    Since reflection types belong to a program version, a handle has to be resolved again when the program changes.
+    isResolvedFor() is a cheap check for that.
+*/
+class dlldecl ShaderVarHandle {
+ public:
+    ShaderVarHandle() = default;
+
+    /** Create an unresolved handle.
+        \param[in] path Member names separated by '.', e.g. "lights.count". Array elements are indexed on the ShaderVar.
+    */
+    explicit ShaderVarHandle(const std::string& path) : mPath(path) {}
+
+    /** Resolve the path against the type `parent` points to. If `parent` is a constant buffer or parameter block the
+        path is resolved against its contents, the same way `ShaderVar::operator[]` looks members up.
+        \return False if the path doesn't exist. An error is logged and the handle is left invalid.
+    */
+    bool resolve(const ShaderVar& parent);
+
+    /** Check if the handle was resolved against the type `parent` points to.
+    */
+    bool isResolvedFor(const ShaderVar& parent) const;
+
+    bool isValid() const { return mOffset.isValid(); }
+    const std::string& getPath() const { return mPath; }
+
+    /** Get the offset relative to the type the handle was resolved against.
+        For handles resolved against the root of a parameter block this can be passed directly to the block's setXXX() calls.
+    */
+    const TypedShaderVarOffset& getBindLocation() const { return mOffset; }
+
+ private:
+    std::string mPath;
+    TypedShaderVarOffset mOffset;
+    ReflectionType::SharedConstPtr mpParentType;    // Kept alive so a recycled address can't pass isResolvedFor()
+};
+
 }  // namespace Falcor
 
 #include "Falcor/Core/BufferTypes/ParameterBlock.h"
@@ -27,6 +27,10 @@
  **************************************************************************/
 #include "Falcor/stdafx.h"
 #include "ComputeState.h"
+
+#include <algorithm>
+
+#include "Falcor/Core/API/Device.h"
 #include "Falcor/Core/Program/ProgramVars.h"
 #include "Falcor/Utils/Debug/debug.h"
 
@@ -37,6 +41,14 @@ ComputeState::ComputeState(std::shared_ptr<Device> device): mpDevice(device) {
 }
 
 ComputeStateObject::SharedPtr ComputeState::getCSO(const ComputeVars* pVars) {
+    return resolveCSO(pVars, false);
+}
+
+void ComputeState::precreateCSO(const ComputeVars* pVars) {
+    resolveCSO(pVars, true);
+}
+
+ComputeStateObject::SharedPtr ComputeState::resolveCSO(const ComputeVars* pVars, bool precreate) {
     auto pProgramKernels = mpProgram ? mpProgram->getActiveVersion()->getKernels(pVars) : nullptr;
     bool newProgram = (pProgramKernels.get() != mCachedData.pProgramKernels);
     
@@ -65,7 +77,19 @@ ComputeStateObject::SharedPtr ComputeState::getCSO(const ComputeVars* pVars) {
         if (mpCsoGraph->scanForMatchingNode(cmpFunc)) {
             pCso = mpCsoGraph->getCurrentNode();
         } else {
-            pCso = ComputeStateObject::create(mpDevice, mDesc);
+            auto pending = std::find_if(mPendingCsos.begin(), mPendingCsos.end(), [this](const PendingCso& p) { return p.desc == mDesc; });
+            if (precreate) {
+                if (pending == mPendingCsos.end()) mPendingCsos.push_back({ mDesc, ComputeStateObject::createAsync(mpDevice, mDesc) });
+                return nullptr;
+            }
+
+            if (pending != mPendingCsos.end()) {
+                pCso = pending->future.get();
+                mPendingCsos.erase(pending);
+                mpDevice->getPipelineCache()->recordAsyncUse();
+            } else {
+                pCso = ComputeStateObject::create(mpDevice, mDesc);
+            }
             mpCsoGraph->setCurrentNodeData(pCso);
         }
     }
@@ -67,10 +67,17 @@ class dlldecl ComputeState {
     /** Get the active compute state object
     */
     ComputeStateObject::SharedPtr getCSO(const ComputeVars* pVars);
+
+    /** Start creating the compute state object for the current program on a worker thread, so the first dispatch
+        with it doesn't stall on pipeline compilation. Program kernels are linked on the calling thread.
+    */
+    void precreateCSO(const ComputeVars* pVars);
     
  private:
     ComputeState(std::shared_ptr<Device> device);
 
+    ComputeStateObject::SharedPtr resolveCSO(const ComputeVars* pVars, bool precreate);
+
     std::shared_ptr<Device> mpDevice;
     ComputeProgram::SharedPtr mpProgram;
     ComputeStateObject::Desc mDesc;
@@ -84,6 +91,12 @@ class dlldecl ComputeState {
 
     using _StateGraph = StateGraph<ComputeStateObject::SharedPtr, void*>;
     _StateGraph::SharedPtr mpCsoGraph;
+
+    struct PendingCso {
+        ComputeStateObject::Desc desc;
+        std::shared_future<ComputeStateObject::SharedPtr> future;
+    };
+    std::vector<PendingCso> mPendingCsos;     ///< Created by precreateCSO(), not yet used by a dispatch
 };
 
 }  // namespace Flacor
@@ -28,6 +28,10 @@
 #include "Falcor/stdafx.h"
 #include "GraphicsState.h"
 
+#include <algorithm>
+
+#include "Falcor/Core/API/Device.h"
+
 namespace Falcor {
 
 static GraphicsStateObject::PrimitiveType topology2Type(Vao::Topology t) {
@@ -64,6 +68,14 @@ GraphicsState::GraphicsState(std::shared_ptr<Device> device): mpDevice(device),
 GraphicsState::~GraphicsState() = default;
 
 GraphicsStateObject::SharedPtr GraphicsState::getGSO(const GraphicsVars* pVars) {
+    return resolveGSO(pVars, false);
+}
+
+void GraphicsState::precreateGSO(const GraphicsVars* pVars) {
+    resolveGSO(pVars, true);
+}
+
+GraphicsStateObject::SharedPtr GraphicsState::resolveGSO(const GraphicsVars* pVars, bool precreate) {
     assert(mpDevice);
 
     auto pProgramKernels = mpProgram ? mpProgram->getActiveVersion()->getKernels(pVars) : nullptr;
@@ -105,7 +117,19 @@ GraphicsStateObject::SharedPtr GraphicsState::getGSO(const GraphicsVars* pVars)
         if (mpGsoGraph->scanForMatchingNode(cmpFunc)) {
             pGso = mpGsoGraph->getCurrentNode();
         } else {
-            pGso = GraphicsStateObject::create(mpDevice, mDesc);
+            auto pending = std::find_if(mPendingGsos.begin(), mPendingGsos.end(), [this](const PendingGso& p) { return p.desc == mDesc; });
+            if (precreate) {
+                if (pending == mPendingGsos.end()) mPendingGsos.push_back({ mDesc, GraphicsStateObject::createAsync(mpDevice, mDesc) });
+                return nullptr;
+            }
+
+            if (pending != mPendingGsos.end()) {
+                pGso = pending->future.get();
+                mPendingGsos.erase(pending);
+                mpDevice->getPipelineCache()->recordAsyncUse();
+            } else {
+                pGso = GraphicsStateObject::create(mpDevice, mDesc);
+            }
             mpGsoGraph->setCurrentNodeData(pGso);
         }
     }
@@ -226,6 +226,12 @@ class dlldecl GraphicsState {
     */
     virtual GraphicsStateObject::SharedPtr getGSO(const GraphicsVars* pVars);
 
+    /** Start creating the graphics state object for the current state on a worker thread, so the first draw with it
+        doesn't stall on pipeline compilation. Program kernels are linked on the calling thread.
+        Call during scene load with the vars the draws will use; getGSO() picks up the result.
+    */
+    void precreateGSO(const GraphicsVars* pVars);
+
     /** Get the desc
     */
     const GraphicsStateObject::Desc& getDesc() const { return mDesc; }
@@ -233,6 +239,8 @@ class dlldecl GraphicsState {
 private:
     GraphicsState(std::shared_ptr<Device> device);
 
+    GraphicsStateObject::SharedPtr resolveGSO(const GraphicsVars* pVars, bool precreate);
+
     Vao::SharedConstPtr mpVao;
     Fbo::SharedPtr mpFbo;
     GraphicsProgram::SharedPtr mpProgram;
@@ -257,6 +265,12 @@ private:
 
     using _StateGraph = StateGraph<GraphicsStateObject::SharedPtr, void*>;
     _StateGraph::SharedPtr mpGsoGraph;
+
+    struct PendingGso {
+        GraphicsStateObject::Desc desc;
+        std::shared_future<GraphicsStateObject::SharedPtr> future;
+    };
+    std::vector<PendingGso> mPendingGsos;     ///< Created by precreateGSO(), not yet used by a draw
 };
 
 }  // namespace Falcor
@@ -41,6 +41,52 @@ const uint32_t kMaxBVHDepth = 64;
 const uint32_t kMaxLeafTriangleCount = 1 << PackedNode::kTriangleCountBits;
 const uint32_t kMaxLeafTriangleOffset = 1 << PackedNode::kTriangleOffsetBits;
 
+// Ranges of triangles are reduced in chunks of fixed size, and the chunk results are merged in chunk order.
+// The chunking only depends on the range, so the serial and parallel builds produce bit-identical results.
+const uint32_t kReductionChunkSize = 4096;
+
+// Ranges with at least this many triangles are split on the calling thread using parallel binning.
+// Smaller ranges are built serially, as independent subtree tasks in the parallel build.
+const uint32_t kMinParallelTriangleCount = 4 * kReductionChunkSize;
+
+/** Reduces a range of triangles in fixed-size chunks.
+    \param[in] pThreadPool Thread pool to process the chunks on, or nullptr to process them on the calling thread.
+    \param[in] begin First triangle of the range.
+    \param[in] end One past the last triangle of the range.
+    \param[in] reduceChunk Function computing the result for the chunk [chunkBegin, chunkEnd).
+    \param[in] merge Function merging a chunk result into the accumulated result.
+    \return The merged result.
+*/
+template<typename T, typename ReduceFunc, typename MergeFunc>
+T reduceInChunks(ThreadPool* pThreadPool, uint32_t begin, uint32_t end, const ReduceFunc& reduceChunk, const MergeFunc& merge)
+{
+    assert(begin < end);
+    const uint32_t chunkCount = (end - begin + kReductionChunkSize - 1) / kReductionChunkSize;
+    std::vector<T> results(chunkCount);
+
+    auto processChunk = [&](uint32_t chunk)
+    {
+        uint32_t chunkBegin = begin + chunk * kReductionChunkSize;
+        results[chunk] = reduceChunk(chunkBegin, std::min(chunkBegin + kReductionChunkSize, end));
+    };
+
+    if (pThreadPool && end - begin >= kMinParallelTriangleCount)
+    {
+        std::vector<std::future<void>> futures;
+        futures.reserve(chunkCount);
+        for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) futures.push_back(pThreadPool->enqueue(processChunk, chunk));
+        for (auto& f : futures) f.wait();
+    }
+    else
+    {
+        for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) processChunk(chunk);
+    }
+
+    T result = std::move(results[0]);
+    for (uint32_t chunk = 1; chunk < chunkCount; ++chunk) merge(result, results[chunk]);
+    return result;
+}
+
 inline float safeACos(float v)
 {
     return std::acos(glm::clamp(v, -1.0f, 1.0f));
@@ -83,6 +129,15 @@ float computeCosConeAngle(const float3& coneDir, const float cosTheta, const flo
     return cosResult;
 }
 
+/** Merges two cone angles computed by computeCosConeAngle() for the same cone direction.
+    The result is the same as if all cones had been accumulated sequentially.
+*/
+inline float mergeCosConeAngles(const float cosTheta, const float cosOtherTheta)
+{
+    if (cosTheta == kInvalidCosConeAngle || cosOtherTheta == kInvalidCosConeAngle) return kInvalidCosConeAngle;
+    return std::min(cosTheta, cosOtherTheta);
+}
+
 /** Given two cones specified by direction vectors and the cosine of
     their spread angles, returns a cone that bounds both of them. This
     is what was used previously; the cones it returns aren't as tight as
@@ -229,11 +284,31 @@ void LightBVHBuilder::build(LightBVH& bvh)
     // Get global list of emissive triangles.
     assert(bvh.mpLightCollection);
     const auto& triangles = bvh.mpLightCollection->getMeshLightTriangles();
-    if (triangles.empty()) return;
+
+    std::vector<uint32_t> triangleIndices;
+    std::vector<uint64_t> triangleBitmasks;
+    if (!buildNodes(triangles, bvh.mNodes, triangleIndices, triangleBitmasks)) return;
+
+    // The BVH is ready, mark it as valid and upload the data.
+    bvh.mIsValid = true;
+    bvh.mMaxTriangleCountPerLeaf = mOptions.maxTriangleCountPerLeaf;
+    bvh.uploadCPUBuffers(triangleIndices, triangleBitmasks);
+
+    // Computate metadata.
+    bvh.finalize();
+}
+
+bool LightBVHBuilder::buildNodes(const std::vector<LightCollection::MeshLightTriangle>& triangles, std::vector<PackedNode>& nodes, std::vector<uint32_t>& triangleIndices, std::vector<uint64_t>& triangleBitmasks)
+{
+    nodes.clear();
+    triangleIndices.clear();
+    triangleBitmasks.clear();
+    if (triangles.empty()) return false;
 
     // Create list of triangles that should be included in BVH.
     // For each triangle, precompute data we need for the build.
-    BuildingData data(bvh.mNodes);
+    std::vector<TriangleSortData> trianglesData;
+    BuildingData data(nodes, trianglesData, triangleIndices, triangleBitmasks);
     data.trianglesData.reserve(triangles.size());
 
     for (size_t i = 0; i < triangles.size(); i++)
@@ -256,7 +331,7 @@ void LightBVHBuilder::build(LightBVH& bvh)
     }
 
     // If there are no non-culled triangles, we're done.
-    if (data.trianglesData.empty()) return;
+    if (data.trianglesData.empty()) return false;
 
     // Validate options.
     if (mOptions.maxTriangleCountPerLeaf > kMaxLeafTriangleCount)
@@ -272,7 +347,6 @@ void LightBVHBuilder::build(LightBVH& bvh)
     // To be grossly conservative, assume each triangle requires two nodes.
     // This is only system RAM and shouldn't be that much, so it's not worth being more careful about it.
     // TODO: Better estimate of how many nodes we will need.
-    data.nodes.clear();
     data.nodes.reserve(2 * data.trianglesData.size());
     data.triangleIndices.reserve(data.trianglesData.size());
 
@@ -281,7 +355,31 @@ void LightBVHBuilder::build(LightBVH& bvh)
 
     // Build the tree.
     SplitHeuristicFunction splitFunc = getSplitFunction(mOptions.splitHeuristicSelection);
-    buildInternal(mOptions, splitFunc, 0ull, 0, Range(0, static_cast<uint32_t>(data.trianglesData.size())), data);
+    const Range rootRange(0, static_cast<uint32_t>(data.trianglesData.size()));
+
+    if (mOptions.useParallelBuild && rootRange.length() >= kMinParallelTriangleCount)
+    {
+        if (!mpThreadPool) mpThreadPool = std::make_unique<ThreadPool>(std::max(1u, std::thread::hardware_concurrency()));
+        data.pThreadPool = mpThreadPool.get();
+
+        // The subtree tasks reference the building data, so make sure they have all finished before leaving this scope.
+        TopLevelNode root;
+        try
+        {
+            buildTopLevel(mOptions, splitFunc, 0ull, 0, rootRange, data, root);
+        }
+        catch (...)
+        {
+            waitForSubtrees(root);
+            throw;
+        }
+        waitForSubtrees(root);
+        spliceTopLevel(root, data);
+    }
+    else
+    {
+        buildSubtree(mOptions, splitFunc, 0ull, 0, rootRange, data, data.nodes, data.triangleIndices);
+    }
     assert(!data.nodes.empty());
 
     size_t numValid = 0;
@@ -293,13 +391,7 @@ void LightBVHBuilder::build(LightBVH& bvh)
     float cosConeAngle;
     computeLightingConesInternal(0, data, cosConeAngle);
 
-    // The BVH is ready, mark it as valid and upload the data.
-    bvh.mIsValid = true;
-    bvh.mMaxTriangleCountPerLeaf = mOptions.maxTriangleCountPerLeaf;
-    bvh.uploadCPUBuffers(data.triangleIndices, data.triangleBitmasks);
-
-    // Computate metadata.
-    bvh.finalize();
+    return true;
 }
 
 bool LightBVHBuilder::renderUI(Gui::Widgets& widget)
@@ -313,6 +405,7 @@ bool LightBVHBuilder::renderOptions(Gui::Widgets& widget, Options& options) cons
     bool optionsChanged = false;
 
     optionsChanged |= widget.checkbox("Allow refitting", options.allowRefitting);
+    optionsChanged |= widget.checkbox("Parallel build", options.useParallelBuild);
     optionsChanged |= widget.var("Max triangle count per leaf", options.maxTriangleCountPerLeaf, 1u, kMaxLeafTriangleCount);
     optionsChanged |= widget.dropdown("Split heuristic", kSplitHeuristicList, (uint32_t&)options.splitHeuristicSelection);
 
@@ -350,22 +443,17 @@ LightBVHBuilder::LightBVHBuilder(const Options& options) : mOptions(options)
 {
 }
 
-uint32_t LightBVHBuilder::buildInternal(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data)
+uint32_t LightBVHBuilder::buildSubtree(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data,
+    std::vector<PackedNode>& nodes, std::vector<uint32_t>& triangleIndices)
 {
     assert(triangleRange.begin < triangleRange.end);
 
     // Compute the AABB and total flux of the node.
     float nodeFlux = 0.f;
     BBox nodeBounds;
-    for (uint32_t dataIndex = triangleRange.begin; dataIndex < triangleRange.end; ++dataIndex)
-    {
-        nodeBounds |= data.trianglesData[dataIndex].bounds;
-        nodeFlux += data.trianglesData[dataIndex].flux;
-    }
+    computeNodeBoundsAndFlux(triangleRange, data, nodeBounds, nodeFlux);
     assert(nodeBounds.valid());
 
-    data.currentNodeFlux = nodeFlux;
-
     bool trySplitting = triangleRange.length() > (options.createLeavesASAP ? options.maxTriangleCountPerLeaf : 1);
     const SplitResult splitResult = trySplitting ? splitHeuristic(data, triangleRange, nodeBounds, options) : SplitResult();
 
@@ -379,9 +467,9 @@ uint32_t LightBVHBuilder::buildInternal(const Options& options, const SplitHeuri
         std::nth_element(std::begin(data.trianglesData) + triangleRange.begin, std::begin(data.trianglesData) + splitResult.triangleIndex, std::begin(data.trianglesData) + triangleRange.end, comp);
 
         // Allocate internal node.
-        assert(data.nodes.size() < std::numeric_limits<uint32_t>::max());
-        const uint32_t nodeIndex = (uint32_t)data.nodes.size();
-        data.nodes.push_back({});
+        assert(nodes.size() < std::numeric_limits<uint32_t>::max());
+        const uint32_t nodeIndex = (uint32_t)nodes.size();
+        nodes.push_back({});
 
         InternalNode node = {};
         node.attribs.setAABB(nodeBounds.minPoint, nodeBounds.maxPoint);
@@ -395,13 +483,13 @@ uint32_t LightBVHBuilder::buildInternal(const Options& options, const SplitHeuri
             throw std::runtime_error(("BVH depth of " + std::to_string(depth + 1) + " reached; maximum of " + std::to_string(kMaxBVHDepth) + " allowed.").c_str());
         }
 
-        uint32_t leftIndex = buildInternal(options, splitHeuristic, bitmask | (0ull << depth), depth + 1, Range(triangleRange.begin, splitResult.triangleIndex), data);
-        uint32_t rightIndex = buildInternal(options, splitHeuristic, bitmask | (1ull << depth), depth + 1, Range(splitResult.triangleIndex, triangleRange.end), data);
+        uint32_t leftIndex = buildSubtree(options, splitHeuristic, bitmask | (0ull << depth), depth + 1, Range(triangleRange.begin, splitResult.triangleIndex), data, nodes, triangleIndices);
+        uint32_t rightIndex = buildSubtree(options, splitHeuristic, bitmask | (1ull << depth), depth + 1, Range(splitResult.triangleIndex, triangleRange.end), data, nodes, triangleIndices);
 
         assert(leftIndex == nodeIndex + 1); // The left node should always be placed immediately after the current node.
         node.rightChildIdx = rightIndex;
 
-        data.nodes[nodeIndex].setInternalNode(node);
+        nodes[nodeIndex].setInternalNode(node);
         return nodeIndex;
     }
     else // No split => create leaf node
@@ -409,9 +497,9 @@ uint32_t LightBVHBuilder::buildInternal(const Options& options, const SplitHeuri
         assert(triangleRange.length() <= options.maxTriangleCountPerLeaf);
 
         // Allocate leaf node.
-        assert(data.nodes.size() < std::numeric_limits<uint32_t>::max());
-        const uint32_t nodeIndex = (uint32_t)data.nodes.size();
-        data.nodes.push_back({});
+        assert(nodes.size() < std::numeric_limits<uint32_t>::max());
+        const uint32_t nodeIndex = (uint32_t)nodes.size();
+        nodes.push_back({});
 
         LeafNode node = {};
         node.attribs.setAABB(nodeBounds.minPoint, nodeBounds.maxPoint);
@@ -421,21 +509,135 @@ uint32_t LightBVHBuilder::buildInternal(const Options& options, const SplitHeuri
         node.attribs.cosConeAngle = cosTheta;
 
         node.triangleCount = triangleRange.length();
-        node.triangleOffset = (uint32_t)data.triangleIndices.size();
+        node.triangleOffset = (uint32_t)triangleIndices.size();
         assert(node.triangleCount < kMaxLeafTriangleCount);
         assert(node.triangleOffset < kMaxLeafTriangleOffset);
 
         for (uint32_t triangleIdx = triangleRange.begin, index = 0; triangleIdx < triangleRange.end; ++triangleIdx, ++index)
         {
             uint32_t globalTriangleIndex = data.trianglesData[triangleIdx].triangleIndex;
-            data.triangleIndices.push_back(globalTriangleIndex);
+            triangleIndices.push_back(globalTriangleIndex);
             data.triangleBitmasks[globalTriangleIndex] = bitmask;
         }
-        assert(data.triangleIndices.size() == node.triangleOffset + node.triangleCount);
+        assert(triangleIndices.size() == node.triangleOffset + node.triangleCount);
+
+        nodes[nodeIndex].setLeafNode(node);
+        return nodeIndex;
+    }
+}
+
+void LightBVHBuilder::buildTopLevel(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data, TopLevelNode& topLevelNode)
+{
+    assert(triangleRange.begin < triangleRange.end);
+    assert(data.pThreadPool);
+
+    // Small ranges are built serially as independent tasks.
+    // The tasks operate on disjoint ranges of the triangle data and write disjoint triangle bitmasks, so no synchronization is needed.
+    // They see the building data without the thread pool: a task running on a worker must not wait for chunks queued behind it,
+    // which would deadlock once such tasks occupy every worker (e.g. large ranges that cannot be split).
+    auto dispatchSubtree = [&]()
+    {
+        topLevelNode.subtree = data.pThreadPool->enqueue([this, &options, &splitHeuristic, bitmask, depth, triangleRange, &data]()
+        {
+            BuildingData serialData(data.nodes, data.trianglesData, data.triangleIndices, data.triangleBitmasks);
+            Subtree subtree;
+            buildSubtree(options, splitHeuristic, bitmask, depth, triangleRange, serialData, subtree.nodes, subtree.triangleIndices);
+            return subtree;
+        });
+    };
+
+    if (triangleRange.length() < kMinParallelTriangleCount)
+    {
+        dispatchSubtree();
+        return;
+    }
 
-        data.nodes[nodeIndex].setLeafNode(node);
+    // Compute the AABB and total flux of the node.
+    float nodeFlux = 0.f;
+    BBox nodeBounds;
+    computeNodeBoundsAndFlux(triangleRange, data, nodeBounds, nodeFlux);
+    assert(nodeBounds.valid());
+
+    bool trySplitting = triangleRange.length() > (options.createLeavesASAP ? options.maxTriangleCountPerLeaf : 1);
+    const SplitResult splitResult = trySplitting ? splitHeuristic(data, triangleRange, nodeBounds, options) : SplitResult();
+
+    // Let the serial build decide what to do with ranges we cannot split.
+    if (!splitResult.isValid())
+    {
+        dispatchSubtree();
+        return;
+    }
+
+    assert(triangleRange.begin < splitResult.triangleIndex && splitResult.triangleIndex < triangleRange.end);
+
+    // Sort the centroids and update the lists accordingly.
+    auto comp = [dim = splitResult.axis](const TriangleSortData& d1, const TriangleSortData& d2) { return d1.bounds.centroid()[dim] < d2.bounds.centroid()[dim]; };
+    std::nth_element(std::begin(data.trianglesData) + triangleRange.begin, std::begin(data.trianglesData) + splitResult.triangleIndex, std::begin(data.trianglesData) + triangleRange.end, comp);
+
+    topLevelNode.node.attribs.setAABB(nodeBounds.minPoint, nodeBounds.maxPoint);
+    topLevelNode.node.attribs.flux = nodeFlux;
+
+    if (depth >= kMaxBVHDepth)
+    {
+        throw std::runtime_error(("BVH depth of " + std::to_string(depth + 1) + " reached; maximum of " + std::to_string(kMaxBVHDepth) + " allowed.").c_str());
+    }
+
+    topLevelNode.pLeft = std::make_unique<TopLevelNode>();
+    topLevelNode.pRight = std::make_unique<TopLevelNode>();
+    buildTopLevel(options, splitHeuristic, bitmask | (0ull << depth), depth + 1, Range(triangleRange.begin, splitResult.triangleIndex), data, *topLevelNode.pLeft);
+    buildTopLevel(options, splitHeuristic, bitmask | (1ull << depth), depth + 1, Range(splitResult.triangleIndex, triangleRange.end), data, *topLevelNode.pRight);
+}
+
+uint32_t LightBVHBuilder::spliceTopLevel(TopLevelNode& topLevelNode, BuildingData& data)
+{
+    assert(data.nodes.size() < std::numeric_limits<uint32_t>::max());
+    const uint32_t nodeIndex = (uint32_t)data.nodes.size();
+
+    if (topLevelNode.subtree.valid())
+    {
+        Subtree subtree = topLevelNode.subtree.get();
+        const uint32_t triangleOffset = (uint32_t)data.triangleIndices.size();
+
+        // Rebase the child indices and triangle offsets of the subtree.
+        // The packed data is patched in place since unpacking and repacking the node attributes is lossy.
+        const uint32_t triangleOffsetMask = (1u << PackedNode::kTriangleOffsetBits) - 1;
+        for (PackedNode node : subtree.nodes)
+        {
+            if (node.isLeaf())
+            {
+                uint32_t offset = (node.data[0].x & triangleOffsetMask) + triangleOffset;
+                assert(offset < kMaxLeafTriangleOffset);
+                node.data[0].x = (node.data[0].x & ~triangleOffsetMask) | offset;
+            }
+            else
+            {
+                node.data[0].x += nodeIndex;
+            }
+            data.nodes.push_back(node);
+        }
+        data.triangleIndices.insert(data.triangleIndices.end(), subtree.triangleIndices.begin(), subtree.triangleIndices.end());
         return nodeIndex;
     }
+
+    // Allocate internal node.
+    data.nodes.push_back({});
+
+    assert(topLevelNode.pLeft && topLevelNode.pRight);
+    uint32_t leftIndex = spliceTopLevel(*topLevelNode.pLeft, data);
+    uint32_t rightIndex = spliceTopLevel(*topLevelNode.pRight, data);
+
+    assert(leftIndex == nodeIndex + 1); // The left node should always be placed immediately after the current node.
+    topLevelNode.node.rightChildIdx = rightIndex;
+
+    data.nodes[nodeIndex].setInternalNode(topLevelNode.node);
+    return nodeIndex;
+}
+
+void LightBVHBuilder::waitForSubtrees(TopLevelNode& topLevelNode)
+{
+    if (topLevelNode.subtree.valid()) topLevelNode.subtree.wait();
+    if (topLevelNode.pLeft) waitForSubtrees(*topLevelNode.pLeft);
+    if (topLevelNode.pRight) waitForSubtrees(*topLevelNode.pRight);
 }
 
 float3 LightBVHBuilder::computeLightingConesInternal(const uint32_t nodeIndex, BuildingData& data, float& cosConeAngle)
@@ -498,6 +700,30 @@ float3 LightBVHBuilder::computeLightingCone(const Range& triangleRange, const Bu
     return coneDirection;
 }
 
+void LightBVHBuilder::computeNodeBoundsAndFlux(const Range& triangleRange, const BuildingData& data, BBox& nodeBounds, float& nodeFlux)
+{
+    using BoundsAndFlux = std::pair<BBox, float>;
+    BoundsAndFlux result = reduceInChunks<BoundsAndFlux>(data.pThreadPool, triangleRange.begin, triangleRange.end,
+        [&data](uint32_t begin, uint32_t end)
+        {
+            BoundsAndFlux chunk = { BBox(), 0.f };
+            for (uint32_t dataIndex = begin; dataIndex < end; ++dataIndex)
+            {
+                chunk.first |= data.trianglesData[dataIndex].bounds;
+                chunk.second += data.trianglesData[dataIndex].flux;
+            }
+            return chunk;
+        },
+        [](BoundsAndFlux& result, const BoundsAndFlux& chunk)
+        {
+            result.first |= chunk.first;
+            result.second += chunk.second;
+        });
+
+    nodeBounds = result.first;
+    nodeFlux = result.second;
+}
+
 LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithEqual(const BuildingData& /*data*/, const Range& triangleRange, const BBox& nodeBounds, const Options& /*parameters*/)
 {
     // Find the largest dimension.
@@ -566,15 +792,22 @@ LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAH(const Bu
             return std::min((uint32_t)((p - bmin) * scale), parameters.binCount - 1);
         };
 
-        // Reset the bins.
-        for (Bin& bin : bins) bin = Bin();
-
         // Fill the bins with all triangles.
-        for (uint32_t i = triangleRange.begin; i < triangleRange.end; ++i)
-        {
-            const auto& td = data.trianglesData[i];
-            bins[getBinId(td)] |= td;
-        }
+        bins = reduceInChunks<std::vector<Bin>>(data.pThreadPool, triangleRange.begin, triangleRange.end,
+            [&](uint32_t begin, uint32_t end)
+            {
+                std::vector<Bin> chunkBins(parameters.binCount);
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    const auto& td = data.trianglesData[i];
+                    chunkBins[getBinId(td)] |= td;
+                }
+                return chunkBins;
+            },
+            [](std::vector<Bin>& result, const std::vector<Bin>& chunkBins)
+            {
+                for (size_t i = 0; i < result.size(); ++i) result[i] |= chunkBins[i];
+            });
 
         // First, compute A_j(L) * N_j(L) by sweeping over the bins from left to right.
         // Note that the costs vector has n-1 elements when there are n bins; the i:th elements represents the split between bin i and i+1.
@@ -736,15 +969,22 @@ LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAOH(const B
             return std::min((uint32_t)((p - bmin) * scale), parameters.binCount - 1);
         };
 
-        // Reset the bins.
-        for (Bin& bin : bins) bin = Bin();
-
         // Fill the bins with all triangles.
-        for (uint32_t i = triangleRange.begin; i < triangleRange.end; ++i)
-        {
-            const auto& td = data.trianglesData[i];
-            bins[getBinId(td)] |= td;
-        }
+        bins = reduceInChunks<std::vector<Bin>>(data.pThreadPool, triangleRange.begin, triangleRange.end,
+            [&](uint32_t begin, uint32_t end)
+            {
+                std::vector<Bin> chunkBins(parameters.binCount);
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    const auto& td = data.trianglesData[i];
+                    chunkBins[getBinId(td)] |= td;
+                }
+                return chunkBins;
+            },
+            [](std::vector<Bin>& result, const std::vector<Bin>& chunkBins)
+            {
+                for (size_t i = 0; i < result.size(); ++i) result[i] |= chunkBins[i];
+            });
 
         // Compute the lighting cones for each bin.
         // The cone direction is the average direction over all lights in the bin and the cone angle is grown to include all.
@@ -755,12 +995,24 @@ LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAOH(const B
             bin.cosConeAngle = glm::length(bin.coneDirection) < FLT_MIN ? kInvalidCosConeAngle : 1.0f;
             bin.coneDirection = glm::normalize(bin.coneDirection);
         }
-        for (uint32_t i = triangleRange.begin; i < triangleRange.end; ++i)
-        {
-            const auto& td = data.trianglesData[i];
-            Bin& bin = bins[getBinId(td)];
-            bin.cosConeAngle = computeCosConeAngle(bin.coneDirection, bin.cosConeAngle, td.coneDirection, td.cosConeAngle);
-        }
+        std::vector<float> cosConeAngles = reduceInChunks<std::vector<float>>(data.pThreadPool, triangleRange.begin, triangleRange.end,
+            [&](uint32_t begin, uint32_t end)
+            {
+                std::vector<float> chunkCosConeAngles(bins.size());
+                for (size_t j = 0; j < bins.size(); ++j) chunkCosConeAngles[j] = bins[j].cosConeAngle;
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    const auto& td = data.trianglesData[i];
+                    uint32_t binId = getBinId(td);
+                    chunkCosConeAngles[binId] = computeCosConeAngle(bins[binId].coneDirection, chunkCosConeAngles[binId], td.coneDirection, td.cosConeAngle);
+                }
+                return chunkCosConeAngles;
+            },
+            [](std::vector<float>& result, const std::vector<float>& chunkCosConeAngles)
+            {
+                for (size_t j = 0; j < result.size(); ++j) result[j] = mergeCosConeAngles(result[j], chunkCosConeAngles[j]);
+            });
+        for (size_t j = 0; j < bins.size(); ++j) bins[j].cosConeAngle = cosConeAngles[j];
 
         // First, compute A_j(L) * N_j(L) by sweeping over the bins from left to right.
         // Note that the costs vector has n-1 elements when there are n bins; the i:th elements represents the split between bin i and i+1.
@@ -859,7 +1111,10 @@ LightBVHBuilder::SplitResult LightBVHBuilder::computeSplitWithBinnedSAOH(const B
         // Evaluate the cost metric for the node. This requires us to first compute the cone angle.
         float cosTheta = kInvalidCosConeAngle;
         computeLightingCone(triangleRange, data, cosTheta);
-        float leafCost = evalSAOH(nodeBounds, data.currentNodeFlux, cosTheta, parameters);
+        BBox leafBounds;
+        float leafFlux = 0.f;
+        computeNodeBoundsAndFlux(triangleRange, data, leafBounds, leafFlux);
+        float leafCost = evalSAOH(nodeBounds, leafFlux, cosTheta, parameters);
         if (leafCost <= overallBestSplit.first) return SplitResult();
     }
 
@@ -903,6 +1158,7 @@ SCRIPT_BINDING(LightBVHBuilder) {
     options.field(allowRefitting);
     options.field(usePreintegration);
     options.field(useLightingCones);
+    options.field(useParallelBuild);
 #undef field
 }
 #endif
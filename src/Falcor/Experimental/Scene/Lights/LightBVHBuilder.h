@@ -31,9 +31,11 @@
 #include "Utils/AlignedAllocator.h"
 #include "Utils/Math/BBox.h"
 #include "Utils/Math/Vector.h"
+#include "Utils/ThreadPool.h"
 #include "Utils/UI/Gui.h"
 
 #include <limits>
+#include <memory>
 #include <vector>
 
 namespace Falcor {
@@ -73,6 +75,7 @@ public:
         bool           allowRefitting = true;                                ///< Rather than always rebuilding the BVH from scratch, keep the hierarchy but update the bounds and lighting cones.
         bool           usePreintegration = true;                             ///< Use pre-integration for culling out emissive triangles and use their flux when computing the splits. Only valid when using the BinnedSAOH split heuristic.
         bool           useLightingCones = true;                              ///< Use lighting cones when computing the splits. Only valid when using the BinnedSAOH split heuristic.
+        bool           useParallelBuild = true;                              ///< Split the top levels with parallel binning and build the remaining subtrees as parallel tasks. The result is identical to the serial build.
     };
 
     /** Creates a new object.
@@ -85,6 +88,16 @@ public:
     */
     void build(LightBVH& bvh);
 
+    /** Build the BVH nodes on the CPU without touching the GPU.
+        This is the part of build() that does the actual work and is exposed for testing and benchmarking.
+        \param[in] triangles Global list of emissive triangles.
+        \param[out] nodes BVH nodes in depth-first order (left child stored immediately after its parent).
+        \param[out] triangleIndices Triangle indices sorted by leaf node.
+        \param[out] triangleBitmasks Per triangle traversal bit pattern, indexed by global triangle index.
+        \return True if a BVH was built, false if there were no (non-culled) triangles.
+    */
+    bool buildNodes(const std::vector<LightCollection::MeshLightTriangle>& triangles, std::vector<PackedNode>& nodes, std::vector<uint32_t>& triangleIndices, std::vector<uint64_t>& triangleBitmasks);
+
     virtual bool renderUI(Gui::Widgets& widget);
 
     const Options& getOptions() const { return mOptions; }
@@ -125,12 +138,33 @@ protected:
     struct BuildingData
     {
         std::vector<PackedNode>& nodes;                 ///< BVH nodes generated by the builder.
-        std::vector<TriangleSortData> trianglesData;    ///< Compact list of triangles to include in build.
-        std::vector<uint32_t> triangleIndices;          ///< Triangle indices sorted by leaf node. Each leaf node refers to a contiguous array of triangle indices.
-        std::vector<uint64_t> triangleBitmasks;         ///< Array containing the per triangle bit pattern retracing the tree traversal to reach the triangle: 0=left child, 1=right child; this array gets filled in during the build process. Indexed by global triangle index.
-        float currentNodeFlux = 0.f;                    ///< Used by computeSAOHSplit() as the leaf creation cost.
+        std::vector<TriangleSortData>& trianglesData;   ///< Compact list of triangles to include in build.
+        std::vector<uint32_t>& triangleIndices;         ///< Triangle indices sorted by leaf node. Each leaf node refers to a contiguous array of triangle indices.
+        std::vector<uint64_t>& triangleBitmasks;        ///< Array containing the per triangle bit pattern retracing the tree traversal to reach the triangle: 0=left child, 1=right child; this array gets filled in during the build process. Indexed by global triangle index.
+        ThreadPool* pThreadPool = nullptr;              ///< Thread pool used for the parallel build, or nullptr for a serial build.
+
+        BuildingData(std::vector<PackedNode>& bvhNodes, std::vector<TriangleSortData>& bvhTrianglesData, std::vector<uint32_t>& bvhTriangleIndices, std::vector<uint64_t>& bvhTriangleBitmasks)
+            : nodes(bvhNodes), trianglesData(bvhTrianglesData), triangleIndices(bvhTriangleIndices), triangleBitmasks(bvhTriangleBitmasks) {}
+    };
+
+    /** Nodes and triangle indices of a subtree built by a parallel task.
+        Node and triangle offsets are local to the subtree and are rebased when the subtree is spliced into the final node list.
+    */
+    struct Subtree
+    {
+        std::vector<PackedNode> nodes;
+        std::vector<uint32_t> triangleIndices;
+    };
 
-        BuildingData(std::vector<PackedNode>& bvhNodes) : nodes(bvhNodes) {}
+    /** Top-level node of the parallel build. Either an internal node whose children are top-level nodes themselves,
+        or a subtree that is built as an independent task.
+    */
+    struct TopLevelNode
+    {
+        InternalNode node = {};
+        std::unique_ptr<TopLevelNode> pLeft;
+        std::unique_ptr<TopLevelNode> pRight;
+        std::future<Subtree> subtree;                   ///< Valid if this is a subtree task.
     };
 
     /** Compute the split according to a specified heuristic.
@@ -147,15 +181,35 @@ protected:
     */
     bool renderOptions(Gui::Widgets& widget, Options& options) const;
 
-    /** Recursive BVH build.
+    /** Recursive serial BVH build. Used for the whole tree, or for the subtree tasks of the parallel build.
         \param[in] splitHeuristic The splitting heuristic to be used.
         \param[in] bitmask Bit pattern retracing the tree traversal to reach the node to be built: 0=left child, 1=right child.
         \param[in] depth Depth of the node to be built
         \param[in] triangleRange Range of triangles to process.
         \param[in,out] data Prepared light data.
+        \param[out] nodes Nodes of the subtree. Child indices are relative to the start of the list.
+        \param[out] triangleIndices Triangle indices of the subtree. Leaf offsets are relative to the start of the list.
         \return Index of the allocated node.
     */
-    uint32_t buildInternal(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data);
+    uint32_t buildSubtree(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data,
+        std::vector<PackedNode>& nodes, std::vector<uint32_t>& triangleIndices);
+
+    /** Recursive top-level build of the parallel builder.
+        Large ranges are split on the calling thread using parallel binning, and smaller ranges are dispatched as subtree tasks.
+        See buildSubtree() for the parameters.
+        \param[out] topLevelNode The top-level node.
+    */
+    void buildTopLevel(const Options& options, const SplitHeuristicFunction& splitHeuristic, uint64_t bitmask, uint32_t depth, const Range& triangleRange, BuildingData& data, TopLevelNode& topLevelNode);
+
+    /** Append the top-level nodes and finished subtrees to the final node list in depth-first order.
+        This reproduces the node layout of the serial build.
+        \return Index of the node.
+    */
+    uint32_t spliceTopLevel(TopLevelNode& topLevelNode, BuildingData& data);
+
+    /** Wait for all subtree tasks below a top-level node to finish.
+    */
+    static void waitForSubtrees(TopLevelNode& topLevelNode);
 
     /** Recursive computation of lighting cones for all internal nodes.
         \param[in] nodeIndex Index of the current node.
@@ -173,6 +227,10 @@ protected:
     */
     static float3 computeLightingCone(const Range& triangleRange, const BuildingData& data, float& cosTheta);
 
+    /** Compute the AABB and total flux of a range of triangles.
+    */
+    static void computeNodeBoundsAndFlux(const Range& triangleRange, const BuildingData& data, BBox& nodeBounds, float& nodeFlux);
+
     // See the documentation of SplitHeuristicFunction.
     static SplitResult computeSplitWithEqual(const BuildingData& /*data*/, const Range& triangleRange, const BBox& nodeBounds, const Options& /*parameters*/);
     static SplitResult computeSplitWithBinnedSAH(const BuildingData& data, const Range& triangleRange, const BBox& nodeBounds, const Options& parameters);
@@ -182,6 +240,8 @@ protected:
 
     // Configuration
     Options mOptions;
+
+    std::unique_ptr<ThreadPool> mpThreadPool;           ///< Thread pool for the parallel build. Created on first use.
 };
 
 }  // namespace Falcor
@@ -139,6 +139,8 @@
 #include "Falcor/Utils/Perception/SingleThresholdMeasurement.h"
 #include "Falcor/Utils/SampleGenerators/DxSamplePattern.h"
 #include "Falcor/Utils/SampleGenerators/HaltonSamplePattern.h"
+#include "Falcor/Utils/SampleGenerators/PMJ02SamplePattern.h"
+#include "Falcor/Utils/SampleGenerators/SobolSamplePattern.h"
 #include "Falcor/Utils/SampleGenerators/StratifiedSamplePattern.h"
 #include "Falcor/Utils/SampleGenerators/CPUSampleGenerator.h"
 #include "Falcor/Utils/Scripting/Scripting.h"
@@ -148,6 +150,7 @@
 #include "Falcor/Utils/Timing/FrameRate.h"
 #include "Falcor/Utils/Timing/Profiler.h"
 #include "Falcor/Utils/Timing/TimeReport.h"
+#include "Falcor/Utils/Timing/TraceRecorder.h"
 #include "Falcor/Utils/UI/Font.h"
 #include "Falcor/Utils/UI/Gui.h"
 #include "Falcor/Utils/UI/DebugDrawer.h"
@@ -78,6 +78,10 @@ class Device;
         */
         virtual void executeIndirect(ComputeContext* context, const Buffer* pArgBuffer, uint64_t argBufferOffset = 0);
 
+        /** Start creating the pipeline for the current program and vars on a worker thread, so the first execute() doesn't stall on it.
+        */
+        void precreate() { mpState->precreateCSO(mpVars.get()); }
+
         /** Get the vars
         */
         const ComputeVars::SharedPtr& getVars() const { assert(mpVars); return mpVars; };
@@ -93,6 +93,7 @@ void RenderGraph::setScene(const Scene::SharedPtr& pScene) {
             LOG_ERR("No render context in mpDevice !!!");
         }
         it.second.pPass->setScene(mpDevice->getRenderContext(), pScene);
+        mCompilerHistory.changedPasses.insert(it.second.pPass.get());
     }
     mRecompile = true;
 }
@@ -108,7 +109,7 @@ uint32_t RenderGraph::addPass(const RenderPass::SharedPtr& pPass, const std::str
         mNameToIndex[passName] = passIndex;
     }
 
-    pPass->mPassChangedCB = [this]() { mRecompile = true; };
+    pPass->mPassChangedCB = [this, pPass = pPass.get()]() { onPassChanged(pPass); };
     pPass->mName = passName;
 
     if (mpScene) pPass->setScene(mpDevice->getRenderContext(), mpScene);
@@ -156,7 +157,7 @@ void RenderGraph::updatePass(RenderContext* pRenderContext, const std::string& p
     std::string passTypeName = getClassTypeName(pOldPass.get());
     auto pPass = RenderPassLibrary::instance(mpDevice).createPass(pRenderContext, passTypeName.c_str(), dict);
     pPassIt->second.pPass = pPass;
-    pPass->mPassChangedCB = [this]() { mRecompile = true; };
+    pPass->mPassChangedCB = [this, pPass = pPass.get()]() { onPassChanged(pPass); };
     pPass->mName = pOldPass->getName();
 
     if (mpScene) pPass->setScene(mpDevice->getRenderContext(), mpScene);
@@ -347,12 +348,17 @@ std::vector<std::string> RenderGraph::getAvailableOutputs() const {
     return outputs;
 }
 
+void RenderGraph::onPassChanged(const RenderPass* pPass) {
+    mCompilerHistory.changedPasses.insert(pPass);
+    mRecompile = true;
+}
+
 bool RenderGraph::compile(RenderContext* pContext, std::string& log) {
     if (!mRecompile) return true;
     mpExe = nullptr;
 
     try {
-        mpExe = RenderGraphCompiler::compile(*this, pContext, mCompilerDeps);
+        mpExe = RenderGraphCompiler::compile(*this, pContext, mCompilerDeps, mCompilerHistory);
         mRecompile = false;
         return true;
     } catch (const std::exception& e) {
@@ -255,6 +255,7 @@ class Device;
         };
 
         uint32_t getEdge(const std::string& src, const std::string& dst);
+        void onPassChanged(const RenderPass* pPass);
         void getUnsatisfiedInputs(const NodeData* pNodeData, const RenderPassReflection& passReflection, std::vector<RenderPassReflection::Field>& outList) const;
         void autoConnectPasses(const NodeData* pSrcNode, const RenderPassReflection& srcReflection, const NodeData* pDestNode, std::vector<RenderPassReflection::Field>& unsatisfiedInputs);
 
@@ -284,6 +285,7 @@ class Device;
         RenderGraphExe::SharedPtr mpExe;
         bool mRecompile = false;
         RenderGraphCompiler::Dependencies mCompilerDeps;
+        RenderGraphCompiler::History mCompilerHistory;  ///< Lets recompilation skip the parts of the graph an edit didn't affect
 
         std::shared_ptr<Device> mpDevice;
     };
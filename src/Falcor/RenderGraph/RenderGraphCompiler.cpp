@@ -29,6 +29,7 @@
 #include "RenderGraphCompiler.h"
 #include "RenderGraph.h"
 #include "RenderPasses/ResolvePass.h"
+#include "Falcor/Utils/Debug/debug.h"
 
 namespace Falcor {
 
@@ -40,30 +41,82 @@ namespace {
 
 RenderGraphCompiler::RenderGraphCompiler(RenderGraph& graph, const Dependencies& dependencies) : mGraph(graph), mDependencies(dependencies) {}
 
-RenderGraphExe::SharedPtr RenderGraphCompiler::compile(RenderGraph& graph, RenderContext* pContext, const Dependencies& dependencies) {
+RenderGraphExe::SharedPtr RenderGraphCompiler::compile(RenderGraph& graph, RenderContext* pContext, const Dependencies& dependencies, History& history) {
     RenderGraphCompiler c = RenderGraphCompiler(graph, dependencies);
 
+    // If anything below throws the history stays cleared and the next compilation is a full one
+    History previous = std::move(history);
+    history = History();
+
     // Register the external resources
     auto pResourcesCache = ResourceCache::create(graph.device());
     for (const auto&[name, pRes] : dependencies.externalResources) pResourcesCache->registerExternalResource(name, pRes);
 
-    c.resolveExecutionOrder();
-    c.compilePasses(pContext);
+    Topology topology = c.captureTopology();
+    if (previous.pResourceCache && topology == previous.topology) {
+        // Same passes, edges and outputs, so the same order. Only passes that reported a change can reflect differently.
+        c.mExecutionList = previous.executionOrder;
+        for (auto& p : c.mExecutionList) {
+            if (previous.changedPasses.count(p.pPass.get())) p.reflector = p.pPass->reflect({});
+        }
+    } else {
+        c.resolveExecutionOrder();
+    }
+    std::vector<PassData> executionOrder = c.mExecutionList;
+
+    auto compileData = std::move(previous.compileData);
+    c.compilePasses(pContext, previous.changedPasses, compileData);
     if (c.insertAutoPasses()) c.resolveExecutionOrder();
     c.validateGraph();
-    c.allocateResources(pResourcesCache.get());
+    c.allocateResources(pResourcesCache.get(), previous.pResourceCache.get());
 
     auto pExe = RenderGraphExe::create();
     pExe->mExecutionList.reserve(c.mExecutionList.size());
 
+    std::unordered_map<uint32_t, uint32_t> nodeToIndex;
+    for (size_t i = 0; i < c.mExecutionList.size(); i++) nodeToIndex.emplace(c.mExecutionList[i].index, uint32_t(i));
+
     for (auto e : c.mExecutionList) {
-        pExe->insertPass(e.name, e.pPass);
+        // Data and execution edges from passes that execute
+        std::vector<uint32_t> dependencies;
+        const DirectedGraph::Node* pNode = graph.mpGraph->getNode(e.index);
+        for (uint32_t i = 0; i < pNode->getIncomingEdgeCount(); i++) {
+            auto it = nodeToIndex.find(graph.mpGraph->getEdge(pNode->getIncomingEdge(i))->getSourceNode());
+            if (it != nodeToIndex.end()) dependencies.push_back(it->second);
+        }
+        pExe->insertPass(e.name, e.pPass, e.reflector, dependencies);
     }
     c.restoreCompilationChanges();
     pExe->mpResourceCache = pResourcesCache;
+
+    // Only keep compile data of passes the history holds on to, so a new pass allocated at a recycled address can't match it.
+    // Passes that reported a change during this compilation stay in history.changedPasses.
+    for (const auto& p : executionOrder) {
+        auto it = compileData.find(p.pPass.get());
+        if (it != compileData.end()) history.compileData.insert(*it);
+    }
+    history.topology = std::move(topology);
+    history.executionOrder = std::move(executionOrder);
+    history.pResourceCache = pResourcesCache;
     return pExe;
 }
 
+RenderGraphCompiler::Topology RenderGraphCompiler::captureTopology() const {
+    // Edge IDs change when restoreCompilationChanges() re-adds edges, so edges are identified by their end points
+    Topology topology;
+    for (const auto& [index, node] : mGraph.mNodeData) topology.nodes.emplace_back(index, node.name, node.pPass.get());
+    for (const auto& [edgeID, edgeData] : mGraph.mEdgeData) {
+        const auto& pEdge = mGraph.mpGraph->getEdge(edgeID);
+        topology.edges.emplace_back(pEdge->getSourceNode(), pEdge->getDestNode(), edgeData.srcField, edgeData.dstField);
+    }
+    for (const auto& o : mGraph.mOutputs) topology.outputs.emplace_back(o.nodeId, o.field);
+
+    std::sort(topology.nodes.begin(), topology.nodes.end());
+    std::sort(topology.edges.begin(), topology.edges.end());
+    std::sort(topology.outputs.begin(), topology.outputs.end());
+    return topology;
+}
+
 void RenderGraphCompiler::validateGraph() const {
     std::string err;
 
@@ -213,7 +266,7 @@ bool RenderGraphCompiler::insertAutoPasses() {
     return addedPasses;
 }
 
-void RenderGraphCompiler::allocateResources(ResourceCache* pResourceCache) {
+void RenderGraphCompiler::allocateResources(ResourceCache* pResourceCache, const ResourceCache* pPreviousCache) {
     // Build list to look up execution order index from the pass
     std::unordered_map<RenderPass*, uint32_t> passToIndex;
     for (size_t i = 0; i < mExecutionList.size(); i++) {
@@ -280,7 +333,7 @@ void RenderGraphCompiler::allocateResources(ResourceCache* pResourceCache) {
         }
     }
 
-    pResourceCache->allocateResources(mDependencies.defaultResourceProps);
+    pResourceCache->allocateResources(mDependencies.defaultResourceProps, pPreviousCache);
 }
 
 
@@ -353,20 +406,36 @@ RenderPass::CompileData RenderGraphCompiler::prepPassCompilationData(const PassD
     return compileData;
 }
 
-void RenderGraphCompiler::compilePasses(RenderContext* pContext) {
+void RenderGraphCompiler::compilePasses(RenderContext* pContext, const std::unordered_set<const RenderPass*>& changedPasses, std::unordered_map<const RenderPass*, RenderPass::CompileData>& compileData) {
+    std::unordered_set<const RenderPass*> dirty = changedPasses;
+    uint32_t compiledCount = 0;
+
     while(1) {
         std::string log;
         bool success = true;
         for (auto& p : mExecutionList) {
+            auto data = prepPassCompilationData(p);
+
+            // A pass that didn't change and sees the same resources as last time would compile to the same state
+            auto it = compileData.find(p.pPass.get());
+            if (it != compileData.end() && dirty.count(p.pPass.get()) == 0 && it->second == data) continue;
+
             try {
-                p.pPass->compile(pContext, prepPassCompilationData(p));
+                p.pPass->compile(pContext, data);
+                compileData[p.pPass.get()] = std::move(data);
+                dirty.erase(p.pPass.get());
+                compiledCount++;
             } catch (const std::exception& e) {
+                compileData.erase(p.pPass.get());
                 log += std::string(e.what()) + "\n";
                 success = false;
             }
         }
 
-        if (success) return;
+        if (success) {
+            LOG_DBG("RenderGraphCompiler: %u pass compilations for %zu passes", compiledCount, mExecutionList.size());
+            return;
+        }
 
         // Retry
         bool changed = false;
@@ -26,6 +26,10 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #pragma once
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "ResourceCache.h"
 #include "RenderGraphExe.h"
 
@@ -41,13 +45,8 @@ namespace Falcor
             ResourceCache::DefaultProperties defaultResourceProps;
             ResourceCache::ResourcesMap externalResources;
         };
-        static RenderGraphExe::SharedPtr compile(RenderGraph& graph, RenderContext* pContext, const Dependencies& dependencies);
 
     private:
-        RenderGraphCompiler(RenderGraph& graph, const Dependencies& dependencies);
-        RenderGraph& mGraph;
-        const Dependencies& mDependencies;
-
         struct PassData
         {
             uint32_t index;
@@ -55,6 +54,43 @@ namespace Falcor
             std::string name;
             RenderPassReflection reflector;
         };
+
+        /** Nodes, edges and outputs of the graph as the user built it, before auto-generated passes are inserted.
+        */
+        struct Topology
+        {
+            std::vector<std::tuple<uint32_t, std::string, const RenderPass*>> nodes;
+            std::vector<std::tuple<uint32_t, uint32_t, std::string, std::string>> edges;
+            std::vector<std::pair<uint32_t, std::string>> outputs;
+
+            bool operator==(const Topology& other) const { return nodes == other.nodes && edges == other.edges && outputs == other.outputs; }
+        };
+
+    public:
+        /** State kept between compilations so a recompile only redoes what an edit affected.
+            A default constructed history makes the next compilation a full one.
+        */
+        struct History
+        {
+            Topology topology;
+            std::vector<PassData> executionOrder;   ///< Execution order for `topology`, with the passes' initial reflection
+            std::unordered_map<const RenderPass*, RenderPass::CompileData> compileData;    ///< Data each pass was last compiled with
+            ResourceCache::SharedPtr pResourceCache;
+            std::unordered_set<const RenderPass*> changedPasses;    ///< Passes that reported a change since the last compilation
+        };
+
+        /** Compile a graph.
+            \param[in,out] history State of the previous compilation, updated on success. Passes are only compiled again if they changed or their
+                compile data did, resources are only reallocated if their properties changed, and the execution order is only resolved again
+                if the graph's topology changed. On failure the history is cleared.
+        */
+        static RenderGraphExe::SharedPtr compile(RenderGraph& graph, RenderContext* pContext, const Dependencies& dependencies, History& history);
+
+    private:
+        RenderGraphCompiler(RenderGraph& graph, const Dependencies& dependencies);
+        RenderGraph& mGraph;
+        const Dependencies& mDependencies;
+
         std::vector<PassData> mExecutionList;
 
         // TODO Better way to track history, or avoid changing the original graph altogether?
@@ -64,10 +100,11 @@ namespace Falcor
             std::vector<std::pair<std::string, std::string>> removedEdges;
         } mCompilationChanges;
 
+        Topology captureTopology() const;
         void resolveExecutionOrder();
-        void compilePasses(RenderContext* pContext);
+        void compilePasses(RenderContext* pContext, const std::unordered_set<const RenderPass*>& changedPasses, std::unordered_map<const RenderPass*, RenderPass::CompileData>& compileData);
         bool insertAutoPasses();
-        void allocateResources(ResourceCache* pResourceCache);
+        void allocateResources(ResourceCache* pResourceCache, const ResourceCache* pPreviousCache);
         void validateGraph() const;
         void restoreCompilationChanges();
         RenderPass::CompileData prepPassCompilationData(const PassData& passData);
@@ -28,28 +28,139 @@
 #include "stdafx.h"
 #include "RenderGraphExe.h"
 
+#include <algorithm>
+#include <future>
+#include <unordered_map>
+
+#include "Falcor/Utils/ConfigStore.h"
+#include "Falcor/Utils/ThreadPool.h"
+
 namespace Falcor {
 
+    namespace {
+        RenderGraphSchedule::Access getFieldAccess(RenderPassReflection::Field::Visibility visibility) {
+            using Visibility = RenderPassReflection::Field::Visibility;
+            RenderGraphSchedule::Access access = RenderGraphSchedule::Access::None;
+            if (is_set(visibility, Visibility::Input)) access |= RenderGraphSchedule::Access::Read;
+            if (is_set(visibility, Visibility::Output) || is_set(visibility, Visibility::Internal)) access |= RenderGraphSchedule::Access::Write;
+            return access;
+        }
+
+        /** State a planned transition moves a resource to, Undefined if it is left to the pass.
+            Writes are only transitioned when the resource can be written in a single way, the pass' own barrier then becomes a no-op.
+        */
+        Resource::State getTransitionState(Resource::BindFlags bindFlags, RenderGraphSchedule::Access access) {
+            if (access == RenderGraphSchedule::Access::Read) {
+                return is_set(bindFlags, Resource::BindFlags::ShaderResource) ? Resource::State::ShaderResource : Resource::State::Undefined;
+            }
+            if (access == RenderGraphSchedule::Access::Write) {
+                Resource::State state = Resource::State::Undefined;
+                uint32_t writeBindings = 0;
+                if (is_set(bindFlags, Resource::BindFlags::RenderTarget)) { state = Resource::State::RenderTarget; writeBindings++; }
+                if (is_set(bindFlags, Resource::BindFlags::UnorderedAccess)) { state = Resource::State::UnorderedAccess; writeBindings++; }
+                if (is_set(bindFlags, Resource::BindFlags::DepthStencil)) { state = Resource::State::DepthStencil; writeBindings++; }
+                return writeBindings == 1 ? state : Resource::State::Undefined;
+            }
+            return Resource::State::Undefined;
+        }
+    }  // namespace
+
+    RenderGraphExe::RenderGraphExe() {
+        mRecordThreadCount = (uint32_t)std::max(0, ConfigStore::instance().get<int>("rg_record_threads", 0));
+    }
+
+    RenderGraphExe::~RenderGraphExe() = default;
+
     void RenderGraphExe::execute(const Context& ctx) {
         auto pDevice = ctx.pRenderContext->device();
         PROFILE(pDevice, "RenderGraphExe::execute()");
+        updateBindings();
+
+        if (mRecordThreadCount > 0 && mSchedule.getMaxLevelWidth() > 1) {
+            executeLevels(ctx);
+            return;
+        }
 
         for (const auto& pass : mExecutionList) {
             PROFILE(pDevice, pass.name);
 
-            RenderData renderData(pass.name, mpResourceCache, ctx.pGraphDictionary, ctx.defaultTexDims, ctx.defaultTexFormat);
+            RenderData renderData(pass.name, pass.bindings, mpResourceCache.get(), ctx.pGraphDictionary, ctx.defaultTexDims, ctx.defaultTexFormat);
             pass.pPass->execute(ctx.pRenderContext, renderData);
         }
     }
 
+    void RenderGraphExe::executeLevels(const Context& ctx) {
+        auto pDevice = ctx.pRenderContext->device();
+        RenderContext* pContext = ctx.pRenderContext;
+
+        if (!mpThreadPool) mpThreadPool = std::make_unique<ThreadPool>(mRecordThreadCount);
+
+        std::vector<const Pass*> parallelPasses;
+        for (const auto& level : mSchedule.getLevels()) {
+            issueTransitions(pContext, level);
+
+            // Passes that have to record on the graph's context go first
+            parallelPasses.clear();
+            for (uint32_t p : level.passes) {
+                const auto& pass = mExecutionList[p];
+                if (level.passes.size() > 1 && pass.pPass->supportsParallelRecording()) {
+                    parallelPasses.push_back(&pass);
+                    continue;
+                }
+                PROFILE(pDevice, pass.name);
+                RenderData renderData(pass.name, pass.bindings, mpResourceCache.get(), ctx.pGraphDictionary, ctx.defaultTexDims, ctx.defaultTexFormat);
+                pass.pPass->execute(pContext, renderData);
+            }
+            if (parallelPasses.empty()) continue;
+
+            // Submit what was recorded so far, so the workers' commands execute after the transitions above
+            pContext->flush();
+
+            uint32_t workerCount = std::min(mRecordThreadCount, (uint32_t)parallelPasses.size());
+            while (mWorkerContexts.size() < workerCount) {
+                mWorkerContexts.push_back(RenderContext::create(pDevice, pContext->getLowLevelData()->getCommandQueue()));
+            }
+
+            PROFILE(pDevice, "RenderGraphExe::parallelLevel");
+            std::vector<std::future<void>> futures;
+            futures.reserve(workerCount);
+            for (uint32_t w = 0; w < workerCount; w++) {
+                futures.push_back(mpThreadPool->enqueue([&, w] {
+                    RenderContext* pWorkerContext = mWorkerContexts[w].get();
+                    for (size_t i = w; i < parallelPasses.size(); i += workerCount) {
+                        const auto& pass = *parallelPasses[i];
+                        RenderData renderData(pass.name, pass.bindings, mpResourceCache.get(), ctx.pGraphDictionary, ctx.defaultTexDims, ctx.defaultTexFormat);
+                        pass.pPass->execute(pWorkerContext, renderData);
+                    }
+                }));
+            }
+            // Wait for every worker before rethrowing, they reference the pass list
+            for (auto& f : futures) f.wait();
+            for (auto& f : futures) f.get();
+
+            // Passes of a level don't depend on each other, submitting in worker order keeps the queue order deterministic
+            for (uint32_t w = 0; w < workerCount; w++) mWorkerContexts[w]->flush();
+        }
+    }
+
+    void RenderGraphExe::issueTransitions(RenderContext* pContext, const RenderGraphSchedule::Level& level) const {
+        for (const auto& t : level.transitions) {
+            const auto& pResource = *mScheduleResources[t.resource];
+            if (!pResource) continue;
+            Resource::State state = getTransitionState(pResource->getBindFlags(), t.after);
+            if (state != Resource::State::Undefined) pContext->resourceBarrier(pResource.get(), state);
+        }
+    }
+
     void RenderGraphExe::resolvePerFrameSparseResources(const Context& ctx) {
         auto pDevice = ctx.pRenderContext->device();
         PROFILE(pDevice, "RenderGraphExe::resolvePerFrameSparseResources()");
+        updateBindings();
 
         for (const auto& pass : mExecutionList) {
             PROFILE(pDevice, pass.name);
 
-            RenderData renderData(pass.name, mpResourceCache, ctx.pGraphDictionary, ctx.defaultTexDims, ctx.defaultTexFormat);
+            RenderData renderData(pass.name, pass.bindings, mpResourceCache.get(), ctx.pGraphDictionary, ctx.defaultTexDims, ctx.defaultTexFormat);
             pass.pPass->resolvePerFrameSparseResources(ctx.pRenderContext, renderData);
         }
     }
@@ -57,11 +168,12 @@ namespace Falcor {
     void RenderGraphExe::resolvePerSampleSparseResources(const Context& ctx) {
         auto pDevice = ctx.pRenderContext->device();
         PROFILE(pDevice, "RenderGraphExe::resolvePerSampleSparseResources()");
+        updateBindings();
 
         for (const auto& pass : mExecutionList) {
             PROFILE(pDevice, pass.name);
 
-            RenderData renderData(pass.name, mpResourceCache, ctx.pGraphDictionary, ctx.defaultTexDims, ctx.defaultTexFormat);
+            RenderData renderData(pass.name, pass.bindings, mpResourceCache.get(), ctx.pGraphDictionary, ctx.defaultTexDims, ctx.defaultTexFormat);
             pass.pPass->resolvePerSampleSparseResources(ctx.pRenderContext, renderData);
         }
     }
@@ -107,8 +219,50 @@ namespace Falcor {
         }
     }
 
-    void RenderGraphExe::insertPass(const std::string& name, const RenderPass::SharedPtr& pPass) {
-        mExecutionList.push_back(Pass(name, pPass));
+    void RenderGraphExe::insertPass(const std::string& name, const RenderPass::SharedPtr& pPass, const RenderPassReflection& reflection, const std::vector<uint32_t>& dependencies) {
+        Pass pass(name, pPass);
+        pass.bindings.resize(reflection.getFieldCount());
+        pass.accesses.resize(reflection.getFieldCount());
+        for (size_t f = 0; f < reflection.getFieldCount(); f++) {
+            const auto& field = *reflection.getField(f);
+            pass.bindings[f].field = field.getName();
+            pass.accesses[f] = getFieldAccess(field.getVisibility());
+        }
+        pass.dependencies = dependencies;
+        mExecutionList.push_back(std::move(pass));
+    }
+
+    void RenderGraphExe::updateBindings() {
+        assert(mpResourceCache);
+        if (mBindingsVersion == mpResourceCache->getVersion()) return;
+
+        // The cache hands out references to its slots, so the full names are only built when the cache layout changes
+        for (auto& pass : mExecutionList) {
+            for (auto& binding : pass.bindings) binding.pResource = &mpResourceCache->getResource(pass.name + '.' + binding.field);
+        }
+        mBindingsVersion = mpResourceCache->getVersion();
+
+        if (mRecordThreadCount > 0) buildSchedule();
+    }
+
+    void RenderGraphExe::buildSchedule() {
+        // Fields aliasing the same resource resolve to the same cache slot, so the slots identify the resources
+        std::unordered_map<const Resource::SharedPtr*, uint32_t> resourceIDs;
+        mScheduleResources.clear();
+
+        std::vector<RenderGraphSchedule::PassDesc> passes(mExecutionList.size());
+        for (size_t p = 0; p < mExecutionList.size(); p++) {
+            const auto& pass = mExecutionList[p];
+            passes[p].dependencies = pass.dependencies;
+            for (size_t f = 0; f < pass.bindings.size(); f++) {
+                const Resource::SharedPtr* pSlot = pass.bindings[f].pResource;
+                if (!pSlot || !*pSlot) continue;    // Unconnected optional field
+                auto it = resourceIDs.emplace(pSlot, uint32_t(mScheduleResources.size())).first;
+                if (it->second == mScheduleResources.size()) mScheduleResources.push_back(pSlot);
+                passes[p].resources.push_back({ it->second, pass.accesses[f] });
+            }
+        }
+        mSchedule = RenderGraphSchedule::build(passes);
     }
 
     Resource::SharedPtr RenderGraphExe::getResource(const std::string& name) const {
@@ -28,17 +28,23 @@
 #ifndef FALCOR_RENDERGRAPH_RENDERGRAPHEXE_H_
 #define FALCOR_RENDERGRAPH_RENDERGRAPHEXE_H_
 
+#include <memory>
+
 #include "ResourceCache.h"
 #include "Utils/InternalDictionary.h"
 #include "RenderPass.h"
+#include "RenderGraphSchedule.h"
 
 namespace Falcor {
 
 class RenderGraphCompiler;
+class ThreadPool;
 
 class dlldecl RenderGraphExe {
  public:
     using SharedPtr = std::shared_ptr<RenderGraphExe>;
+    ~RenderGraphExe();
+
     struct Context {
         RenderContext* pRenderContext;
         InternalDictionary::SharedPtr pGraphDictionary;
@@ -46,7 +52,10 @@ class dlldecl RenderGraphExe {
         ResourceFormat defaultTexFormat;
     };
 
-    /** Execute the graph
+    /** Execute the graph.
+        If the "rg_record_threads" config value is set, passes that support parallel recording and don't depend on each other are recorded
+        on that many worker threads, each with a context of its own. Each level of independent passes is submitted in order after the
+        transitions it needs were issued on the graph's context.
     */
     void execute(const Context& ctx);
 
@@ -90,14 +99,29 @@ class dlldecl RenderGraphExe {
 private:
     friend class RenderGraphCompiler;
     static SharedPtr create() { return SharedPtr(new RenderGraphExe); }
-    RenderGraphExe() = default;
+    RenderGraphExe();
+
+    /** Append a pass to the execution list.
+        \param[in] dependencies Indices in the execution list of the passes connected to this pass' inputs or execution edges.
+    */
+    void insertPass(const std::string& name, const RenderPass::SharedPtr& pPass, const RenderPassReflection& reflection, const std::vector<uint32_t>& dependencies);
+
+    /** Resolve the passes' binding tables against the resource cache, if it changed since they were last resolved.
+        Rebuilds the schedule when recording in parallel.
+    */
+    void updateBindings();
 
-    void insertPass(const std::string& name, const RenderPass::SharedPtr& pPass);
+    void buildSchedule();
+    void executeLevels(const Context& ctx);
+    void issueTransitions(RenderContext* pContext, const RenderGraphSchedule::Level& level) const;
 
     struct Pass
     {
         std::string name;
         RenderPass::SharedPtr pPass;
+        RenderData::BindingTable bindings;  ///< One entry per reflected field
+        std::vector<RenderGraphSchedule::Access> accesses;  ///< How each field is accessed, parallel to bindings
+        std::vector<uint32_t> dependencies;
     private:
         friend class RenderGraphExe; // Force RenderGraphCompiler to use insertPass() by hiding this Ctor from it
         Pass(const std::string& name_, const RenderPass::SharedPtr& pPass_) : name(name_), pPass(pPass_) {}
@@ -105,6 +129,14 @@ private:
 
     std::vector<Pass> mExecutionList;
     ResourceCache::SharedPtr mpResourceCache;
+    uint64_t mBindingsVersion = uint64_t(-1);   ///< Resource cache version the binding tables were resolved against
+
+    // Parallel recording
+    uint32_t mRecordThreadCount = 0;
+    RenderGraphSchedule mSchedule;
+    std::vector<const Resource::SharedPtr*> mScheduleResources;    ///< Cache slot of each resource ID the schedule uses
+    std::unique_ptr<ThreadPool> mpThreadPool;
+    std::vector<RenderContext::SharedPtr> mWorkerContexts;
 };
 
 }  // namespace Falcor
@@ -0,0 +1,103 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "RenderGraphSchedule.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+
+namespace Falcor {
+
+RenderGraphSchedule RenderGraphSchedule::build(const std::vector<PassDesc>& passes) {
+    // Last levels a resource was read and written at, -1 if never
+    struct ResourceLevels {
+        int32_t read = -1;
+        int32_t write = -1;
+    };
+    std::unordered_map<uint32_t, ResourceLevels> resourceLevels;
+    std::vector<int32_t> passLevels(passes.size(), 0);
+    std::vector<std::map<uint32_t, Access>> passAccesses(passes.size());
+    int32_t levelCount = 0;
+
+    for (size_t p = 0; p < passes.size(); p++) {
+        // Fields aliasing the same resource are merged into one access
+        auto& accesses = passAccesses[p];
+        for (const auto& r : passes[p].resources) {
+            if (r.access != Access::None) accesses[r.resource] = accesses[r.resource] | r.access;
+        }
+
+        int32_t level = 0;
+        for (uint32_t d : passes[p].dependencies) {
+            assert(d < p);
+            level = std::max(level, passLevels[d] + 1);
+        }
+        for (const auto& [resource, access] : accesses) {
+            const auto& last = resourceLevels[resource];
+            int32_t after = is_set(access, Access::Write) ? std::max(last.read, last.write) : last.write;
+            level = std::max(level, after + 1);
+        }
+
+        for (const auto& [resource, access] : accesses) {
+            auto& last = resourceLevels[resource];
+            if (is_set(access, Access::Read)) last.read = std::max(last.read, level);
+            if (is_set(access, Access::Write)) last.write = level;
+        }
+        passLevels[p] = level;
+        levelCount = std::max(levelCount, level + 1);
+    }
+
+    RenderGraphSchedule schedule;
+    schedule.mLevels.resize(levelCount);
+    for (size_t p = 0; p < passes.size(); p++) schedule.mLevels[passLevels[p]].passes.push_back(uint32_t(p));
+
+    // Passes of a level don't conflict, so a resource is either only read by the level or read/written by a single pass of it
+    std::unordered_map<uint32_t, Access> current;
+    for (auto& level : schedule.mLevels) {
+        std::map<uint32_t, Access> levelAccesses;
+        for (uint32_t p : level.passes) {
+            for (const auto& [resource, access] : passAccesses[p]) levelAccesses[resource] = levelAccesses[resource] | access;
+        }
+
+        for (const auto& [resource, access] : levelAccesses) {
+            auto& before = current[resource];
+            // Read after read needs nothing, everything else needs at least an execution dependency
+            if (before != access || is_set(access, Access::Write)) level.transitions.push_back({ resource, before, access });
+            before = access;
+        }
+    }
+    return schedule;
+}
+
+uint32_t RenderGraphSchedule::getMaxLevelWidth() const {
+    size_t width = 0;
+    for (const auto& level : mLevels) width = std::max(width, level.passes.size());
+    return uint32_t(width);
+}
+
+}  // namespace Falcor
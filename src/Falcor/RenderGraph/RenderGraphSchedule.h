@@ -0,0 +1,95 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#ifndef SRC_FALCOR_RENDERGRAPH_RENDERGRAPHSCHEDULE_H_
+#define SRC_FALCOR_RENDERGRAPH_RENDERGRAPHSCHEDULE_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "Falcor/Core/Framework.h"
+
+namespace Falcor {
+
+/** Groups the passes of a compiled graph into levels of passes that don't depend on each other, and plans the resource
+    transitions between the levels from the graph's edges and the resources each pass touches. Passes of one level
+    may be recorded in parallel.
+*/
+class dlldecl RenderGraphSchedule {
+ public:
+    enum class Access : uint32_t {
+        None = 0x0,
+        Read = 0x1,
+        Write = 0x2,
+        ReadWrite = Read | Write,
+    };
+
+    struct ResourceAccess {
+        uint32_t resource;      ///< Any ID, equal for every field that resolves to the same resource
+        Access access;
+    };
+
+    struct PassDesc {
+        std::vector<uint32_t> dependencies;     ///< Indices of the passes that must execute before this one
+        std::vector<ResourceAccess> resources;
+    };
+
+    /** The state a resource leaves before a level and the one it is used in by the level.
+    */
+    struct Transition {
+        uint32_t resource;
+        Access before;          ///< None if the resource was not used by an earlier level
+        Access after;
+    };
+
+    struct Level {
+        std::vector<uint32_t> passes;           ///< Pass indices, in execution order
+        std::vector<Transition> transitions;    ///< To issue before any pass of the level records, sorted by resource
+    };
+
+    /** Build the schedule.
+        \param[in] passes The passes, in an execution order that satisfies the dependencies.
+        A pass is placed one level after the last pass it depends on, or that it conflicts with through a resource
+        (read after write, write after read or write after write). Passes of a level therefore never conflict and can be recorded in any order.
+    */
+    static RenderGraphSchedule build(const std::vector<PassDesc>& passes);
+
+    const std::vector<Level>& getLevels() const { return mLevels; }
+
+    /** Number of passes in the widest level.
+    */
+    uint32_t getMaxLevelWidth() const;
+
+ private:
+    std::vector<Level> mLevels;
+};
+
+enum_class_operators(RenderGraphSchedule::Access);
+
+}  // namespace Falcor
+
+#endif  // SRC_FALCOR_RENDERGRAPH_RENDERGRAPHSCHEDULE_H_
@@ -30,8 +30,9 @@
 
 namespace Falcor {
 
-RenderData::RenderData(const std::string& passName, const ResourceCache::SharedPtr& pResourceCache, const InternalDictionary::SharedPtr& pDict, const uint2& defaultTexDims, ResourceFormat defaultTexFormat)
+RenderData::RenderData(const std::string& passName, const BindingTable& bindings, const ResourceCache* pResourceCache, const InternalDictionary::SharedPtr& pDict, const uint2& defaultTexDims, ResourceFormat defaultTexFormat)
     : mName(passName)
+    , mBindings(bindings)
     , mpResources(pResourceCache)
     , mpDictionary(pDict)
     , mDefaultTexDims(defaultTexDims)
@@ -41,6 +42,12 @@ RenderData::RenderData(const std::string& passName, const ResourceCache::SharedP
 }
 
 const Resource::SharedPtr& RenderData::getResource(const std::string& name) const {
+    // Passes have a handful of fields, scanning them beats building "pass.field" and hashing it
+    for (const auto& binding : mBindings) {
+        if (binding.field == name) return *binding.pResource;
+    }
+
+    // Not a reflected field, the cache may still know the name
     return mpResources->getResource(mName + '.' + name);
 }
 
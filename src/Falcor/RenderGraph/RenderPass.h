@@ -46,6 +46,14 @@ namespace Falcor {
 */
 class dlldecl RenderData {
  public:
+    /** Resource slot of one of the pass' fields, resolved by RenderGraphExe after the graph is compiled.
+    */
+    struct Binding {
+        std::string field;                                  ///< Field name, without the pass' name
+        const Resource::SharedPtr* pResource = nullptr;     ///< Slot in the resource cache
+    };
+    using BindingTable = std::vector<Binding>;
+
     /** Get a resource
         \param[in] name The name of the pass' resource (i.e. "outputColor"). No need to specify the pass' name
         \return If the name exists, a pointer to the resource. Otherwise, nullptr
@@ -71,9 +79,10 @@ class dlldecl RenderData {
     ResourceFormat getDefaultTextureFormat() const { return mDefaultTexFormat; }
  protected:
     friend class RenderGraphExe;
-    RenderData(const std::string& passName, const ResourceCache::SharedPtr& pResourceCache, const InternalDictionary::SharedPtr& pDict, const uint2& defaultTexDims, ResourceFormat defaultTexFormat);
+    RenderData(const std::string& passName, const BindingTable& bindings, const ResourceCache* pResourceCache, const InternalDictionary::SharedPtr& pDict, const uint2& defaultTexDims, ResourceFormat defaultTexFormat);
     const std::string& mName;
-    ResourceCache::SharedPtr mpResources;
+    const BindingTable& mBindings;
+    const ResourceCache* mpResources;
     InternalDictionary::SharedPtr mpDictionary;
     uint2 mDefaultTexDims;
     ResourceFormat mDefaultTexFormat;
@@ -99,6 +108,10 @@ class dlldecl RenderPass : public std::enable_shared_from_this<RenderPass> {
         RenderPassReflection connectedResources;
         uint2 defaultTexDims;
         ResourceFormat defaultTexFormat;
+
+        bool operator==(const CompileData& other) const {
+            return connectedResources == other.connectedResources && defaultTexDims == other.defaultTexDims && defaultTexFormat == other.defaultTexFormat;
+        }
     };
 
     /** Called once before compilation. Describes I/O requirements of the pass.
@@ -122,6 +135,13 @@ class dlldecl RenderPass : public std::enable_shared_from_this<RenderPass> {
     */
     virtual void execute(RenderContext* pRenderContext, const RenderData& renderData) = 0;
 
+    /** Whether execute() may be called on a worker thread, with a context of its own, while other passes of the graph record.
+        Passes that return true must read their inputs as shader resources and must not touch objects shared with other passes. Constant
+        buffer updates, descriptor sets, resource views and program linking are safe from workers. Blits and FullScreenPass (its vertex
+        buffer is shared) are not.
+    */
+    virtual bool supportsParallelRecording() const { return false; }
+
     /** Get a dictionary that can be used to reconstruct the object
     */
     virtual Dictionary getScriptingDictionary() { return {}; }
@@ -28,6 +28,7 @@
 #include "Falcor/stdafx.h"
 #include "ResourceCache.h"
 #include "Falcor/Core/API/Texture.h"
+#include "Falcor/Utils/Debug/debug.h"
 
 namespace Falcor {
 
@@ -40,6 +41,7 @@ namespace Falcor {
     void ResourceCache::reset() {
         mNameToIndex.clear();
         mResourceData.clear();
+        mVersion++;
     }
 
     const Resource::SharedPtr& ResourceCache::getResource(const std::string& name) const {
@@ -63,7 +65,11 @@ namespace Falcor {
     }
 
     void ResourceCache::registerExternalResource(const std::string& name, const Resource::SharedPtr& pResource) {
-        if(pResource) mExternalResources[name] = pResource;
+        if (pResource) {
+            // Replacing a known resource reuses its slot, a new name may shadow a field resolved earlier
+            auto result = mExternalResources.insert_or_assign(name, pResource);
+            if (result.second) mVersion++;
+        }
         else
         {
             auto it = mExternalResources.find(name);
@@ -73,6 +79,7 @@ namespace Falcor {
             }
 
             mExternalResources.erase(it);
+            mVersion++;
         }
     }
 
@@ -83,6 +90,7 @@ namespace Falcor {
 
     void ResourceCache::registerField(const std::string& name, const RenderPassReflection::Field& field, uint32_t timePoint, const std::string& alias) {
         assert(mNameToIndex.find(name) == mNameToIndex.end());
+        mVersion++;
 
         bool addAlias = (alias.empty() == false);
         if (addAlias && mNameToIndex.count(alias) == 0) {
@@ -106,55 +114,66 @@ namespace Falcor {
         }
     }
 
-    Resource::SharedPtr createResourceForPass(std::shared_ptr<Device> pDevice, const ResourceCache::DefaultProperties& params, const RenderPassReflection::Field& field, bool resolveBindFlags, const std::string& resourceName)
-    {
-        uint32_t width = field.getWidth() ? field.getWidth() : params.dims.x;
-        uint32_t height = field.getHeight() ? field.getHeight() : params.dims.y;
-        uint32_t depth = field.getDepth() ? field.getDepth() : 1;
-        uint32_t sampleCount = field.getSampleCount() ? field.getSampleCount() : 1;
-        auto bindFlags = field.getBindFlags();
-        auto arraySize = field.getArraySize();
-        auto mipLevels = field.getMipCount();
+    bool ResourceCache::ResolvedProperties::operator==(const ResolvedProperties& other) const {
+        return type == other.type && width == other.width && height == other.height && depth == other.depth && sampleCount == other.sampleCount &&
+            arraySize == other.arraySize && mipLevels == other.mipLevels && format == other.format && bindFlags == other.bindFlags;
+    }
 
-        ResourceFormat format = ResourceFormat::Unknown;
+    ResourceCache::ResolvedProperties ResourceCache::resolveProperties(const std::shared_ptr<Device>& pDevice, const DefaultProperties& params, const RenderPassReflection::Field& field, bool resolveBindFlags)
+    {
+        ResolvedProperties props;
+        props.type = field.getType();
+        props.width = field.getWidth() ? field.getWidth() : params.dims.x;
+        props.height = field.getHeight() ? field.getHeight() : params.dims.y;
+        props.depth = field.getDepth() ? field.getDepth() : 1;
+        props.sampleCount = field.getSampleCount() ? field.getSampleCount() : 1;
+        props.bindFlags = field.getBindFlags();
+        props.arraySize = field.getArraySize();
+        props.mipLevels = field.getMipCount();
+        props.format = ResourceFormat::Unknown;
 
         if (field.getType() != RenderPassReflection::Field::Type::RawBuffer) {
-            format = field.getFormat() == ResourceFormat::Unknown ? params.format : field.getFormat();
+            props.format = field.getFormat() == ResourceFormat::Unknown ? params.format : field.getFormat();
             if (resolveBindFlags) {
                 ResourceBindFlags mask = Resource::BindFlags::UnorderedAccess | Resource::BindFlags::ShaderResource;
                 bool isOutput = is_set(field.getVisibility(), RenderPassReflection::Field::Visibility::Output);
                 bool isInternal = is_set(field.getVisibility(), RenderPassReflection::Field::Visibility::Internal);
                 if (isOutput || isInternal) mask |= Resource::BindFlags::DepthStencil | Resource::BindFlags::RenderTarget;
-                auto supported = getFormatBindFlags(pDevice, format);
+                auto supported = getFormatBindFlags(pDevice, props.format);
                 mask &= supported;
-                bindFlags |= mask;
+                props.bindFlags |= mask;
             }
         } else {
             // RawBuffer
-            if (resolveBindFlags) bindFlags = Resource::BindFlags::UnorderedAccess | Resource::BindFlags::ShaderResource;
+            if (resolveBindFlags) props.bindFlags = Resource::BindFlags::UnorderedAccess | Resource::BindFlags::ShaderResource;
         }
+        return props;
+    }
+
+    Resource::SharedPtr ResourceCache::createResource(const std::shared_ptr<Device>& pDevice, const ResolvedProperties& props, const std::string& resourceName)
+    {
         Resource::SharedPtr pResource;
 
-        switch (field.getType())
+        switch (props.type)
         {
         case RenderPassReflection::Field::Type::RawBuffer:
-            pResource = Buffer::create(pDevice, width, bindFlags, Buffer::CpuAccess::None);
+            pResource = Buffer::create(pDevice, props.width, props.bindFlags, Buffer::CpuAccess::None);
             break;
         case RenderPassReflection::Field::Type::Texture1D:
-            pResource = Texture::create1D(pDevice, width, format, arraySize, mipLevels, nullptr, bindFlags);
+            pResource = Texture::create1D(pDevice, props.width, props.format, props.arraySize, props.mipLevels, nullptr, props.bindFlags);
             break;
         case RenderPassReflection::Field::Type::Texture2D:
-            if (sampleCount > 1) {
-                pResource = Texture::create2DMS(pDevice, width, height, format, sampleCount, arraySize, bindFlags);
+            if (props.sampleCount > 1) {
+                pResource = Texture::create2DMS(pDevice, props.width, props.height, props.format, props.sampleCount, props.arraySize, props.bindFlags);
             } else {
-                pResource = Texture::create2D(pDevice, width, height, format, arraySize, mipLevels, nullptr, bindFlags);
+                pResource = Texture::create2D(pDevice, props.width, props.height, props.format, props.arraySize, props.mipLevels, nullptr, props.bindFlags);
             }
             break;
         case RenderPassReflection::Field::Type::Texture3D:
-            pResource = Texture::create3D(pDevice, width, height, depth, format, mipLevels, nullptr, bindFlags);
+            pResource = Texture::create3D(pDevice, props.width, props.height, props.depth, props.format, props.mipLevels, nullptr, props.bindFlags);
             break;
         case RenderPassReflection::Field::Type::TextureCube:
-            pResource = Texture::createCube(pDevice, width, height, format, arraySize, mipLevels, nullptr, bindFlags);
+            pResource = Texture::createCube(pDevice, props.width, props.height, props.format, props.arraySize, props.mipLevels, nullptr, props.bindFlags);
             break;
         default:
             should_not_get_here();
@@ -164,11 +183,33 @@ namespace Falcor {
         return pResource;
     }
 
-    void ResourceCache::allocateResources(const DefaultProperties& params) {
+    void ResourceCache::allocateResources(const DefaultProperties& params, const ResourceCache* pPrevious) {
+        uint32_t reusedCount = 0;
+        uint32_t createdCount = 0;
+
         for (auto& data : mResourceData) {
             if ((data.pResource == nullptr) && (data.field.isValid())) {
-                data.pResource = createResourceForPass(mpDevice, params, data.field, data.resolveBindFlags, data.name);
+                data.props = resolveProperties(mpDevice, params, data.field, data.resolveBindFlags);
+
+                // Take over the previous resource if it was created for the same field with the same properties.
+                // Checking the owning name keeps a resource from being handed to two fields that used to be aliased.
+                if (pPrevious) {
+                    auto it = pPrevious->mNameToIndex.find(data.name);
+                    if (it != pPrevious->mNameToIndex.end()) {
+                        const auto& previous = pPrevious->mResourceData[it->second];
+                        if (previous.pResource && previous.name == data.name && previous.props == data.props) {
+                            data.pResource = previous.pResource;
+                            reusedCount++;
+                            continue;
+                        }
+                    }
+                }
+
+                data.pResource = createResource(mpDevice, data.props, data.name);
+                createdCount++;
             }
         }
+
+        if (pPrevious) LOG_DBG("ResourceCache: reused %u resources, created %u", reusedCount, createdCount);
     }
 }
@@ -77,22 +77,44 @@ class dlldecl ResourceCache : public std::enable_shared_from_this<ResourceCache>
 
     /** Allocate all resources that need to be created/updated.
         This includes new resources, resources whose properties have been updated since last allocation call.
+        \param[in] pPrevious Optional. Cache of a previous compilation of the same graph. Resources with the same name and the same
+            resolved properties are taken over from it instead of being created again.
     */
-    void allocateResources(const DefaultProperties& params);
+    void allocateResources(const DefaultProperties& params, const ResourceCache* pPrevious = nullptr);
 
     /** Clears all registered field/resource properties and allocated resources.
     */
     void reset();
 
+    /** Get a counter that changes whenever a name may resolve to a different resource slot.
+        References returned by getResource() stay valid, and keep seeing newly allocated resources, until it changes.
+    */
+    uint64_t getVersion() const { return mVersion; }
+
  private:
     ResourceCache(std::shared_ptr<Device> pDevice);// = default;
 
+    /** Properties a resource is created with, after defaults and bind flags are resolved.
+    */
+    struct ResolvedProperties {
+        RenderPassReflection::Field::Type type;
+        uint32_t width, height, depth, sampleCount, arraySize, mipLevels;
+        ResourceFormat format;
+        ResourceBindFlags bindFlags;
+
+        bool operator==(const ResolvedProperties& other) const;
+    };
+
+    static ResolvedProperties resolveProperties(const std::shared_ptr<Device>& pDevice, const DefaultProperties& params, const RenderPassReflection::Field& field, bool resolveBindFlags);
+    static Resource::SharedPtr createResource(const std::shared_ptr<Device>& pDevice, const ResolvedProperties& props, const std::string& resourceName);
+
     struct ResourceData {
         RenderPassReflection::Field field;      // Holds merged properties for aliased resources
         std::pair<uint32_t, uint32_t> lifetime; // Time range where this resource is being used
         Resource::SharedPtr pResource;          // The resource
         bool resolveBindFlags;                  // Whether or not we should resolve the field's bind-flags before creating the resource
         std::string name;                       // Full name of the resource, including the pass name
+        ResolvedProperties props;               // Properties pResource was created with
     };
 
     // Resources and properties for fields within (and therefore owned by) a render graph
@@ -102,6 +124,7 @@ class dlldecl ResourceCache : public std::enable_shared_from_this<ResourceCache>
     // References to output resources not to be allocated by the render graph
     ResourcesMap mExternalResources;
 
+    uint64_t mVersion = 0;
     std::shared_ptr<Device> mpDevice;
 };
 
@@ -72,6 +72,12 @@ void AnimationController::setEnabled(bool enabled) {
     mAnimationChanged = true;
 }
 
+void AnimationController::invalidateLocalMatrix(uint32_t matrixID) {
+    assert(matrixID < mLocalMatrices.size());
+    mInvalidatedMatrixIDs.push_back(matrixID);
+    mAnimationChanged = true;
+}
+
 void AnimationController::initLocalMatrices() {
     for (size_t i = 0; i < mLocalMatrices.size(); i++) {
         mLocalMatrices[i] = mpScene->mSceneGraph[i].transform;
@@ -84,6 +90,7 @@ bool AnimationController::animate(RenderContext* pContext, double currentTime) {
     PROFILE(mpDevice, "animate");
 
     mMatricesChanged.assign(mMatricesChanged.size(), false);
+    mChangedMatrixIDs.clear();
 
     if (mAnimationChanged == false) {
         if (!mEnabled || !hasAnimations()) return false;
@@ -98,6 +105,9 @@ bool AnimationController::animate(RenderContext* pContext, double currentTime) {
     mAnimationChanged = false;
     mLastAnimationTime = currentTime;
 
+    for (uint32_t matrixID : mInvalidatedMatrixIDs) mMatricesChanged[matrixID] = true;
+    mInvalidatedMatrixIDs.clear();
+
     if (mEnabled) {
         for (auto& pAnimation : mAnimations) {
             pAnimation->animate(currentTime, mLocalMatrices);
@@ -124,6 +134,7 @@ void AnimationController::updateMatrices() {
             mGlobalMatrices[i] = mGlobalMatrices[mpScene->mSceneGraph[i].parent] * mGlobalMatrices[i];
             mMatricesChanged[i] = mMatricesChanged[i] || mMatricesChanged[mpScene->mSceneGraph[i].parent];
         }
+        if (mMatricesChanged[i]) mChangedMatrixIDs.push_back((uint32_t)i);
 
         mInvTransposeGlobalMatrices[i] = transpose(inverse(mGlobalMatrices[i]));
 
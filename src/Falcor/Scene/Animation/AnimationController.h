@@ -83,6 +83,10 @@ class dlldecl AnimationController {
     */
     bool isEnabled() const { return mEnabled; };
 
+    /** Reload the local matrix of a scene graph node whose transform was edited. Applied by the next animate().
+    */
+    void invalidateLocalMatrix(uint32_t matrixID);
+
     /** Run the animation
         \return true if a change occurred, otherwise false
     */
@@ -92,6 +96,10 @@ class dlldecl AnimationController {
     */
     bool didMatrixChanged(size_t matrixID) const { return mMatricesChanged[matrixID]; }
 
+    /** Get the IDs of the global matrices that changed in the last animate() call, sorted.
+    */
+    const std::vector<uint32_t>& getChangedMatrixIDs() const { return mChangedMatrixIDs; }
+
     /** Get the global matrices
     */
     const std::vector<glm::mat4>& getGlobalMatrices() const { return mGlobalMatrices; }
@@ -110,6 +118,8 @@ class dlldecl AnimationController {
     std::vector<glm::mat4> mGlobalMatrices;
     std::vector<glm::mat4> mInvTransposeGlobalMatrices;
     std::vector<bool> mMatricesChanged;
+    std::vector<uint32_t> mChangedMatrixIDs;
+    std::vector<uint32_t> mInvalidatedMatrixIDs;
 
     bool mEnabled = true;
     bool mAnimationChanged = true;
@@ -263,7 +263,8 @@ bool Camera::isObjectCulled(const BoundingBox& box) const
 void Camera::setShaderData(const ShaderVar& var) const
 {
     calculateCameraParameters();
-    var["data"].setBlob(mData);
+    if (!mDataHandle.isResolvedFor(var)) mDataHandle.resolve(var);
+    var[mDataHandle].setBlob(mData);
 }
 
 void Camera::setPatternGenerator(const CPUSampleGenerator::SharedPtr& pGenerator, const float2& scale)
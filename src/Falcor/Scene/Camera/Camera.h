@@ -284,6 +284,7 @@ private:
     void calculateCameraParameters() const;
     mutable CameraData mData;
     CameraData mPrevData;
+    mutable ShaderVarHandle mDataHandle{ "data" };  ///< Resolved on the first setShaderData() call for a camera type
 
     struct
     {
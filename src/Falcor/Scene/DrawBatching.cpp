@@ -0,0 +1,78 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "DrawBatching.h"
+
+#include <numeric>
+
+namespace Falcor {
+
+DrawBatchList buildDrawBatches(const std::vector<uint32_t>& meshIDs, const std::vector<uint8_t>& flipped, uint32_t meshCount) {
+    std::vector<uint32_t> instanceIDs(meshIDs.size());
+    std::iota(instanceIDs.begin(), instanceIDs.end(), 0);
+    return buildDrawBatches(instanceIDs, meshIDs, flipped, meshCount);
+}
+
+DrawBatchList buildDrawBatches(const std::vector<uint32_t>& instanceIDs, const std::vector<uint32_t>& meshIDs, const std::vector<uint8_t>& flipped, uint32_t meshCount) {
+    assert(meshIDs.size() == flipped.size());
+    assert(instanceIDs.size() <= std::numeric_limits<uint32_t>::max());
+    const uint32_t instanceCount = (uint32_t)instanceIDs.size();
+
+    // Counting sort on (winding, mesh). Bucket b = flipped * meshCount + meshID.
+    auto bucketOf = [&](uint32_t instanceID) {
+        assert(instanceID < meshIDs.size() && meshIDs[instanceID] < meshCount);
+        return (flipped[instanceID] ? meshCount : 0) + meshIDs[instanceID];
+    };
+
+    std::vector<uint32_t> bucketStart(2 * (size_t)meshCount + 1, 0);
+    for (uint32_t i = 0; i < instanceCount; i++) bucketStart[bucketOf(instanceIDs[i]) + 1]++;
+    for (size_t b = 1; b < bucketStart.size(); b++) bucketStart[b] += bucketStart[b - 1];
+
+    DrawBatchList list;
+    list.drawIDs.resize(instanceCount);
+    std::vector<uint32_t> cursor(bucketStart.begin(), bucketStart.end() - 1);
+    for (uint32_t i = 0; i < instanceCount; i++) {
+        uint32_t instanceID = instanceIDs[i];
+        list.drawIDs[cursor[bucketOf(instanceID)]++] = instanceID;
+    }
+
+    for (uint32_t b = 0; b < 2 * meshCount; b++) {
+        uint32_t count = bucketStart[b + 1] - bucketStart[b];
+        if (count == 0) continue;
+
+        DrawBatch batch;
+        batch.meshID = b % meshCount;
+        batch.startInstance = bucketStart[b];
+        batch.instanceCount = count;
+        (b < meshCount ? list.counterClockwise : list.clockwise).push_back(batch);
+    }
+
+    return list;
+}
+
+}  // namespace Falcor
@@ -0,0 +1,80 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#ifndef SRC_FALCOR_SCENE_DRAWBATCHING_H_
+#define SRC_FALCOR_SCENE_DRAWBATCHING_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "Falcor/Core/Framework.h"
+
+namespace Falcor {
+
+/** One multi-instance draw: all instances of a mesh that share the same winding.
+*/
+struct DrawBatch {
+    uint32_t meshID = 0;
+    uint32_t startInstance = 0;     ///< First entry in DrawBatchList::drawIDs, used as the draw's start instance location.
+    uint32_t instanceCount = 0;
+};
+
+/** Draws for a scene, split by winding.
+*/
+struct DrawBatchList {
+    std::vector<DrawBatch> counterClockwise;    ///< Instances with a regular transform.
+    std::vector<DrawBatch> clockwise;           ///< Instances whose transform flips the handedness.
+
+    /** Per-instance vertex data fetched with the draw's instance index. Maps startInstance + SV_InstanceID to the mesh instance ID.
+    */
+    std::vector<uint32_t> drawIDs;
+
+    size_t getDrawCount() const { return counterClockwise.size() + clockwise.size(); }
+};
+
+/** Group mesh instances into multi-instance draws.
+    Instances sharing a mesh and winding end up in one draw. Batches are ordered by winding (counter-clockwise first),
+    then by mesh ID, and the instances in a batch keep their relative order. Runs in O(instances + meshes).
+    \param[in] meshIDs Mesh ID of each mesh instance.
+    \param[in] flipped Non-zero for each mesh instance whose transform flips the handedness. Same size as meshIDs.
+    \param[in] meshCount Number of meshes. All mesh IDs must be smaller.
+    \return The draw batches. drawIDs contains every mesh instance exactly once.
+*/
+dlldecl DrawBatchList buildDrawBatches(const std::vector<uint32_t>& meshIDs, const std::vector<uint8_t>& flipped, uint32_t meshCount);
+
+/** Group a subset of the mesh instances, e.g. the ones that survived culling, into multi-instance draws.
+    \param[in] instanceIDs Mesh instances to draw. Indices into meshIDs and flipped.
+    \param[in] meshIDs Mesh ID of each mesh instance in the scene.
+    \param[in] flipped Non-zero for each mesh instance whose transform flips the handedness. Same size as meshIDs.
+    \param[in] meshCount Number of meshes. All mesh IDs must be smaller.
+    \return The draw batches. drawIDs contains the entries of instanceIDs, ordered as described above.
+*/
+dlldecl DrawBatchList buildDrawBatches(const std::vector<uint32_t>& instanceIDs, const std::vector<uint32_t>& meshIDs, const std::vector<uint8_t>& flipped, uint32_t meshCount);
+
+}  // namespace Falcor
+
+#endif  // SRC_FALCOR_SCENE_DRAWBATCHING_H_
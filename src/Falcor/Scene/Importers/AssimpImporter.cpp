@@ -27,6 +27,7 @@
  **************************************************************************/
 #include "Falcor/stdafx.h"
 #include "assimp/Importer.hpp"
+#include "assimp/DefaultIOSystem.h"
 #include "assimp/postprocess.h"
 #include "assimp/scene.h"
 #include "assimp/pbrmaterial.h"
@@ -37,6 +38,9 @@
 #include "Falcor/Scene/SceneBuilder.h"
 #include "Falcor/Scene/Importer.h"
 #include "Falcor/Scene/Material/Material.h"
+#include "Falcor/Utils/Image/Bitmap.h"
+#include "Falcor/Utils/ThreadPool.h"
+#include "BoneWeights.h"
 
 namespace Falcor {
 
@@ -59,6 +63,25 @@ namespace
         return clamp(sqrt(2.0f / (specPower + 2.0f)), 0.f, 1.f);
     }
 
+    /** Default file access that reports every file assimp opens (the scene file, .mtl, .bin, ...) to the builder,
+        so the scene cache knows which files the scene depends on.
+    */
+    class DependencyIOSystem : public Assimp::DefaultIOSystem
+    {
+    public:
+        DependencyIOSystem(SceneBuilder& builder) : mBuilder(builder) {}
+
+        Assimp::IOStream* Open(const char* pFile, const char* pMode = "rb") override
+        {
+            Assimp::IOStream* pStream = DefaultIOSystem::Open(pFile, pMode);
+            if (pStream) mBuilder.addDependency(pFile);
+            return pStream;
+        }
+
+    private:
+        SceneBuilder& mBuilder;
+    };
+
     enum class ImportMode {
         Default,
         OBJ,
@@ -133,6 +156,46 @@ namespace
         }
     };
 
+    /** Runs indexed tasks on a thread pool, at most `window` tasks ahead of the consumer.
+        The consumer takes the results in increasing index order, which keeps everything committed to the scene builder
+        in the same order as a serial import.
+    */
+    template<typename T>
+    class OrderedTasks
+    {
+    public:
+        OrderedTasks(ThreadPool& threadPool, size_t count, size_t window, std::function<T(size_t)> task)
+            : mThreadPool(threadPool), mTask(std::move(task)), mFutures(count), mWindow(std::max<size_t>(1, window)) {}
+
+        ~OrderedTasks()
+        {
+            // Tasks reference data owned by the caller, wait for the ones that were never taken.
+            for (size_t i = 0; i < mEnqueued; i++)
+            {
+                if (mFutures[i].valid()) mFutures[i].wait();
+            }
+        }
+
+        T take(size_t index)
+        {
+            assert(index < mFutures.size());
+            size_t end = std::min(mFutures.size(), index + mWindow);
+            for (; mEnqueued < end; mEnqueued++)
+            {
+                size_t i = mEnqueued;
+                mFutures[i] = mThreadPool.enqueue([this, i]() { return mTask(i); });
+            }
+            return mFutures[index].get();
+        }
+
+    private:
+        ThreadPool& mThreadPool;
+        std::function<T(size_t)> mTask;
+        std::vector<std::future<T>> mFutures;
+        size_t mWindow;
+        size_t mEnqueued = 0;
+    };
+
     class ImporterData
     {
     public:
@@ -145,6 +208,11 @@ namespace
         std::map<const std::string, Texture::SharedPtr> textureCache;
         const SceneBuilder::InstanceMatrices& modelInstances;
         std::map<std::string, glm::mat4> localToBindPoseMatrices;
+        ThreadPool threadPool{ std::max(1u, std::thread::hardware_concurrency()) };
+
+        /** Number of tasks to keep in flight ahead of the serial consumer. Bounds the memory held by finished tasks.
+        */
+        size_t getTaskWindow() const { return 4 * (size_t)std::max(1u, std::thread::hardware_concurrency()); }
 
         uint32_t getFalcorNodeID(const aiNode* pNode) const
         {
@@ -447,9 +515,9 @@ namespace
 
     void loadBones(const aiMesh* pAiMesh, const ImporterData& data, std::vector<float4>& weights, std::vector<uint4>& ids)
     {
-        const uint32_t vertexCount = pAiMesh->mNumVertices;
-        weights.resize(vertexCount);
-        ids.resize(vertexCount);
+        static_assert(BoneWeightSelector::kMaxInfluences == Scene::kMaxBonesPerVertex);
+        BoneWeightSelector selector(pAiMesh->mNumVertices);
+        uint32_t droppedCount = 0;
 
         for (uint32_t bone = 0; bone < pAiMesh->mNumBones; bone++)
         {
@@ -458,41 +526,42 @@ namespace
             uint32_t aiBoneID = data.getFalcorNodeID(pAiBone->mName.C_Str(), 0);
 
             // The way Assimp works, the weights holds the IDs of the vertices it affects.
-            // We loop over all the weights, initializing the vertices data along the way
             for (uint32_t weightID = 0; weightID < pAiBone->mNumWeights; weightID++)
             {
-                // Get the vertex the current weight affects
                 const aiVertexWeight& aiWeight = pAiBone->mWeights[weightID];
-
-                // Get the address of the Bone ID and weight for the current vertex
-                uint4& vertexIds = ids[aiWeight.mVertexId];
-                float4& vertexWeights = weights[aiWeight.mVertexId];
-
-                // Find the next unused slot in the bone array of the vertex, and initialize it with the current value
-                bool emptySlotFound = false;
-                for (uint32_t j = 0; j < Scene::kMaxBonesPerVertex; j++)
-                {
-                    if (vertexWeights[j] == 0)
-                    {
-                        vertexIds[j] = aiBoneID;
-                        vertexWeights[j] = aiWeight.mWeight;
-                        emptySlotFound = true;
-                        break;
-                    }
-                }
-
-                if (emptySlotFound == false) logError("One of the vertices has too many bones attached to it. If you'll continue, this bone will be ignored and the animation might not look correct");
+                if (!selector.add(aiWeight.mVertexId, aiBoneID, aiWeight.mWeight)) droppedCount++;
             }
         }
 
-        // Now we need to normalize the weights for each vertex, since in some models the sum is larger than 1
-        for (uint32_t i = 0; i < vertexCount; i++)
+        if (droppedCount > 0)
         {
-            float4& w = weights[i];
-            float f = 0;
-            for (uint32_t j = 0; j < Scene::kMaxBonesPerVertex; j++) f += w[j];
-            w /= f;
+            logWarning("Mesh '" + std::string(pAiMesh->mName.C_Str()) + "' has vertices with more than " + std::to_string(Scene::kMaxBonesPerVertex) + " bones attached. "
+                "Dropped the " + std::to_string(droppedCount) + " weakest weights, the animation might not look correct");
         }
+
+        // The weights are normalized, since in some models the sum is larger than 1
+        selector.finalize(weights, ids);
+    }
+
+    /** Per-vertex and index data converted from an aiMesh. Owns the arrays a SceneBuilder::Mesh points to.
+    */
+    struct MeshBuffers
+    {
+        std::vector<uint32_t> indices;
+        std::vector<float2> texCrds;
+        std::vector<float4> tangents;
+        std::vector<uint4> boneIDs;
+        std::vector<float4> boneWeights;
+    };
+
+    MeshBuffers processMesh(const ImporterData& data, const aiMesh* pAiMesh, bool loadTangents)
+    {
+        MeshBuffers buffers;
+        createIndexList(pAiMesh, buffers.indices);
+        if (pAiMesh->HasTextureCoords(0)) createTexCrdList(pAiMesh->mTextureCoords[0], pAiMesh->mNumVertices, buffers.texCrds);
+        if (loadTangents && pAiMesh->HasTangentsAndBitangents()) createTangentList(pAiMesh->mTangents, pAiMesh->mBitangents, pAiMesh->mNormals, pAiMesh->mNumVertices, buffers.tangents);
+        if (pAiMesh->HasBones()) loadBones(pAiMesh, data, buffers.boneWeights, buffers.boneIDs);
+        return buffers;
     }
 
     void createMeshes(ImporterData& data)
@@ -500,42 +569,27 @@ namespace
         const aiScene* pScene = data.pScene;
         const bool loadTangents = is_set(data.builder.getFlags(), SceneBuilder::Flags::UseOriginalTangentSpace);
 
-        // Find the largest mesh.
-        uint64_t largestIndexCount = 0;
-        uint64_t largestVertexCount = 0;
-
-        for (uint32_t i = 0; i < pScene->mNumMeshes; i++)
+        // Convert the meshes on the thread pool and add them to the builder in order.
+        OrderedTasks<MeshBuffers> tasks(data.threadPool, pScene->mNumMeshes, data.getTaskWindow(), [&](size_t i)
         {
-            const aiMesh* pAiMesh = pScene->mMeshes[i];
-            uint64_t indexCount = pAiMesh->mNumFaces * pAiMesh->mFaces[0].mNumIndices;
-
-            largestIndexCount = std::max(largestIndexCount, indexCount);
-            largestVertexCount = std::max(largestVertexCount, (uint64_t)pAiMesh->mNumVertices);
-        }
-
-        // Reserve memory for the vertex and index data.
-        std::vector<uint32_t> indexList;
-        std::vector<float2> texCrds;
-        std::vector<float4> tangents;
-        indexList.reserve(largestIndexCount);
-        texCrds.reserve(largestVertexCount);
-        if (loadTangents) tangents.reserve(largestVertexCount);
+            return processMesh(data, pScene->mMeshes[i], loadTangents);
+        });
 
         // Add all the meshes.
         for (uint32_t i = 0; i < pScene->mNumMeshes; i++)
         {
             const aiMesh* pAiMesh = pScene->mMeshes[i];
             const uint32_t perFaceIndexCount = pAiMesh->mFaces[0].mNumIndices;
+            MeshBuffers buffers = tasks.take(i);
 
             SceneBuilder::Mesh mesh;
             mesh.name = pAiMesh->mName.C_Str();
             mesh.faceCount = pAiMesh->mNumFaces;
 
             // Indices
-            createIndexList(pAiMesh, indexList);
-            assert(indexList.size() <= std::numeric_limits<uint32_t>::max());
-            mesh.indexCount = (uint32_t)indexList.size();
-            mesh.pIndices = indexList.data();
+            assert(buffers.indices.size() <= std::numeric_limits<uint32_t>::max());
+            mesh.indexCount = (uint32_t)buffers.indices.size();
+            mesh.pIndices = buffers.indices.data();
 
             // Vertices
             assert(pAiMesh->mVertices);
@@ -547,31 +601,23 @@ namespace
             mesh.normals.pData = reinterpret_cast<float3*>(pAiMesh->mNormals);
             mesh.normals.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
 
-            if (pAiMesh->HasTextureCoords(0))
+            if (!buffers.texCrds.empty())
             {
-                createTexCrdList(pAiMesh->mTextureCoords[0], pAiMesh->mNumVertices, texCrds);
-                assert(!texCrds.empty());
-                mesh.texCrds.pData = texCrds.data();
+                mesh.texCrds.pData = buffers.texCrds.data();
                 mesh.texCrds.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
             }
 
-            if (loadTangents && pAiMesh->HasTangentsAndBitangents())
+            if (!buffers.tangents.empty())
             {
-                createTangentList(pAiMesh->mTangents, pAiMesh->mBitangents, pAiMesh->mNormals, pAiMesh->mNumVertices, tangents);
-                assert(!tangents.empty());
-                mesh.tangents.pData = tangents.data();
+                mesh.tangents.pData = buffers.tangents.data();
                 mesh.tangents.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
             }
 
-            std::vector<uint4> boneIds;
-            std::vector<float4> boneWeights;
-
-            if (pAiMesh->HasBones())
+            if (!buffers.boneIDs.empty())
             {
-                loadBones(pAiMesh, data, boneWeights, boneIds);
-                mesh.boneIDs.pData = boneIds.data();
+                mesh.boneIDs.pData = buffers.boneIDs.data();
                 mesh.boneIDs.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
-                mesh.boneWeights.pData = boneWeights.data();
+                mesh.boneWeights.pData = buffers.boneWeights.data();
                 mesh.boneWeights.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
             }
 
@@ -726,7 +772,88 @@ namespace
         }
     }
 
-    void loadTextures(std::shared_ptr<Device> pDevice, ImporterData& data, const aiMaterial* pAiMaterial, const std::string& folder, Material* pMaterial, ImportMode importMode, bool useSrgb)
+    /** Get the path of a material's texture as stored in the asset.
+        \return False if the material has no texture for this mapping.
+    */
+    bool getTexturePath(const aiMaterial* pAiMaterial, const TextureMapping& source, std::string& path)
+    {
+        // Skip if texture of requested type is not available
+        if (pAiMaterial->GetTextureCount(source.aiType) < source.aiIndex + 1) return false;
+
+        aiString aiPath;
+        pAiMaterial->GetTexture(source.aiType, source.aiIndex, &aiPath);
+        path = aiPath.data;
+        return true;
+    }
+
+    std::string getTextureFullPath(const std::string& folder, const std::string& path)
+    {
+        return replaceSubstring(folder + '/' + path, "\\", "/");
+    }
+
+    /** Decodes the images of all material textures on the thread pool, ahead of material creation.
+        Material creation stays serial and turns the decoded images into textures in the same order as before.
+        DDS files are left to Texture::createFromFile().
+    */
+    class TexturePrefetcher
+    {
+    public:
+        TexturePrefetcher(std::shared_ptr<Device> pDevice, ImporterData& data, const std::string& folder, ImportMode importMode)
+        {
+            // Collect the textures in order of first use, the same order loadTextures() requests them in.
+            for (uint32_t i = 0; i < data.pScene->mNumMaterials; i++)
+            {
+                for (const auto& source : kTextureMappings[int(importMode)])
+                {
+                    std::string path;
+                    if (!getTexturePath(data.pScene->mMaterials[i], source, path) || path.empty()) continue;
+                    if (hasSuffix(path, ".dds", false) || mIndices.count(path)) continue;
+                    mIndices[path] = mFilenames.size();
+                    mFilenames.push_back(getTextureFullPath(folder, path));
+                }
+            }
+
+            mpTasks = std::make_unique<OrderedTasks<Image>>(data.threadPool, mFilenames.size(), data.getTaskWindow(), [this, pDevice](size_t i)
+            {
+                Image image;
+                if (!findFileInDataDirectories(mFilenames[i], image.fullpath)) return image;
+                image.pBitmap = Bitmap::createFromFile(pDevice, image.fullpath, true);
+                return image;
+            });
+        }
+
+        /** Create a texture from a prefetched image.
+            \return The texture, or nullptr if the image wasn't prefetched or failed to load.
+        */
+        Texture::SharedPtr createTexture(std::shared_ptr<Device> pDevice, const std::string& path, bool loadAsSrgb)
+        {
+            auto it = mIndices.find(path);
+            if (it == mIndices.end()) return nullptr;
+
+            Image image = mpTasks->take(it->second);
+            if (!image.pBitmap) return nullptr;
+
+            ResourceFormat texFormat = image.pBitmap->getFormat();
+            if (loadAsSrgb) texFormat = linearToSrgbFormat(texFormat);
+
+            auto pTex = Texture::create2D(pDevice, image.pBitmap->getWidth(), image.pBitmap->getHeight(), texFormat, 1, Texture::kMaxPossible, image.pBitmap->getData());
+            if (pTex) pTex->setSourceFilename(image.fullpath);
+            return pTex;
+        }
+
+    private:
+        struct Image
+        {
+            std::string fullpath;
+            Bitmap::UniqueConstPtr pBitmap;
+        };
+
+        std::map<std::string, size_t> mIndices;     ///< Texture path in the asset -> index in mFilenames.
+        std::vector<std::string> mFilenames;
+        std::unique_ptr<OrderedTasks<Image>> mpTasks;
+    };
+
+    void loadTextures(std::shared_ptr<Device> pDevice, ImporterData& data, TexturePrefetcher& prefetcher, const aiMaterial* pAiMaterial, const std::string& folder, Material* pMaterial, ImportMode importMode, bool useSrgb)
     {
         assert(pDevice);
 
@@ -734,13 +861,9 @@ namespace
 
         for (const auto& source : textureMappings)
         {
-            // Skip if texture of requested type is not available
-            if (pAiMaterial->GetTextureCount(source.aiType) < source.aiIndex + 1) continue;
-
             // Get the texture name
-            aiString aiPath;
-            pAiMaterial->GetTexture(source.aiType, source.aiIndex, &aiPath);
-            std::string path(aiPath.data);
+            std::string path;
+            if (!getTexturePath(pAiMaterial, source, path)) continue;
             if (path.empty())
             {
                 logWarning("Texture has empty file name, ignoring.");
@@ -757,9 +880,9 @@ namespace
             else
             {
                 // create a new texture
-                std::string fullpath = folder + '/' + path;
-                fullpath = replaceSubstring(fullpath, "\\", "/");
-                pTex = Texture::createFromFile(pDevice, fullpath, true, useSrgb && pMaterial->isSrgbTextureRequired(source.targetType));
+                bool loadAsSrgb = useSrgb && pMaterial->isSrgbTextureRequired(source.targetType);
+                pTex = prefetcher.createTexture(pDevice, path, loadAsSrgb);
+                if (!pTex) pTex = Texture::createFromFile(pDevice, getTextureFullPath(folder, path), true, loadAsSrgb);
                 if (pTex)
                 {
                     data.textureCache[path] = pTex;
@@ -774,7 +897,7 @@ namespace
         pDevice->flushAndSync();
     }
 
-    Material::SharedPtr createMaterial(std::shared_ptr<Device> pDevice, ImporterData& data, const aiMaterial* pAiMaterial, const std::string& folder, ImportMode importMode, bool useSrgb)
+    Material::SharedPtr createMaterial(std::shared_ptr<Device> pDevice, ImporterData& data, TexturePrefetcher& prefetcher, const aiMaterial* pAiMaterial, const std::string& folder, ImportMode importMode, bool useSrgb)
     {
         assert(pDevice);
 
@@ -800,7 +923,7 @@ namespace
         }
 
         // Load textures. Note that loading is affected by the current shading model.
-        loadTextures(pDevice, data, pAiMaterial, folder, pMaterial.get(), importMode, useSrgb);
+        loadTextures(pDevice, data, prefetcher, pAiMaterial, folder, pMaterial.get(), importMode, useSrgb);
 
         // Opacity
         float opacity = 1.f;
@@ -923,10 +1046,13 @@ namespace
 
         bool useSrgb = !is_set(data.builder.getFlags(), SceneBuilder::Flags::AssumeLinearSpaceTextures);
 
+        // Image decoding runs on the thread pool while the materials are created in order.
+        TexturePrefetcher prefetcher(pDevice, data, modelFolder, importMode);
+
         for (uint32_t i = 0; i < data.pScene->mNumMaterials; i++)
         {
             const aiMaterial* pAiMaterial = data.pScene->mMaterials[i];
-            auto pMaterial = createMaterial(pDevice, data, pAiMaterial, modelFolder, importMode, useSrgb);
+            auto pMaterial = createMaterial(pDevice, data, prefetcher, pAiMaterial, modelFolder, importMode, useSrgb);
             if (pMaterial == nullptr)
             {
                 logError("Can't allocate memory for material");
@@ -1055,6 +1181,7 @@ bool AssimpImporter::import(const std::string& filename, SceneBuilder& builder,
 
     Assimp::Importer importer;
     importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, removeFlags);
+    importer.SetIOHandler(new DependencyIOSystem(builder));   // Owned by the importer
 
     const aiScene* pScene = importer.ReadFile(fullpath, assimpFlags);
     timeReport.measure("Loading asset file");
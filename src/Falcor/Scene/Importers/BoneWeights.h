@@ -0,0 +1,88 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#ifndef SRC_FALCOR_SCENE_IMPORTERS_BONEWEIGHTS_H_
+#define SRC_FALCOR_SCENE_IMPORTERS_BONEWEIGHTS_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "Falcor/Utils/Math/Vector.h"
+
+namespace Falcor {
+
+/** Collects bone influences per vertex and keeps the strongest kMaxInfluences of them.
+    Each add() is constant time: the slots of a vertex are kept sorted by decreasing weight, and empty slots have
+    weight 0.
+*/
+class BoneWeightSelector {
+ public:
+    static const uint32_t kMaxInfluences = 4;
+
+    explicit BoneWeightSelector(uint32_t vertexCount) : mIDs(vertexCount, uint4(0)), mWeights(vertexCount, float4(0.f)) {}
+
+    /** Add an influence.
+        \return False if an influence was dropped because the vertex already had kMaxInfluences stronger ones.
+    */
+    bool add(uint32_t vertexID, uint32_t boneID, float weight) {
+        if (weight <= 0.f) return true;
+
+        uint4& ids = mIDs[vertexID];
+        float4& weights = mWeights[vertexID];
+        bool dropped = weights[kMaxInfluences - 1] > 0.f;
+        if (dropped && weight <= weights[kMaxInfluences - 1]) return false;
+
+        uint32_t slot = kMaxInfluences - 1;
+        while (slot > 0 && weights[slot - 1] < weight) {
+            weights[slot] = weights[slot - 1];
+            ids[slot] = ids[slot - 1];
+            slot--;
+        }
+        weights[slot] = weight;
+        ids[slot] = boneID;
+        return !dropped;
+    }
+
+    /** Normalize the weights of each vertex to sum to one and move the results out.
+    */
+    void finalize(std::vector<float4>& weights, std::vector<uint4>& ids) {
+        for (float4& w : mWeights) {
+            float sum = w.x + w.y + w.z + w.w;
+            if (sum > 0.f) w /= sum;
+        }
+        weights = std::move(mWeights);
+        ids = std::move(mIDs);
+    }
+
+ private:
+    std::vector<uint4> mIDs;
+    std::vector<float4> mWeights;
+};
+
+}  // namespace Falcor
+
+#endif  // SRC_FALCOR_SCENE_IMPORTERS_BONEWEIGHTS_H_
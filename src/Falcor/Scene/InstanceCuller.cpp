@@ -0,0 +1,234 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "InstanceCuller.h"
+
+#include <algorithm>
+#include <future>
+#include <numeric>
+#include <thread>
+
+#include "Falcor/Utils/ThreadPool.h"
+
+namespace Falcor {
+
+namespace {
+
+const uint32_t kMaxLeafSize = 8;
+const uint32_t kTasksPerThread = 4;
+const uint32_t kAllPlanes = 0x3f;
+
+}  // namespace
+
+Frustum Frustum::fromViewProjMatrix(const glm::mat4& viewProj) {
+    // See: https://fgiesen.wordpress.com/2012/08/31/frustum-planes-from-the-projection-matrix/
+    Frustum frustum;
+    glm::mat4 tempMat = glm::transpose(viewProj);
+    for (int i = 0; i < 6; i++) {
+        float4 plane = (i & 1) ? tempMat[i >> 1] : -tempMat[i >> 1];
+        if (i != 5) plane += tempMat[3];    // Z range is [0, w]. For the 0 <= z plane we don't need to add w
+        frustum.planes[i] = plane;
+    }
+    return frustum;
+}
+
+bool Frustum::isCulled(const BoundingBox& box) const {
+    for (int i = 0; i < 6; i++) {
+        float3 n = float3(planes[i]);
+        float dist = glm::dot(n, box.center) + planes[i].w;
+        float radius = glm::dot(glm::abs(n), box.extent);
+        if (dist + radius <= 0.f) return true;
+    }
+    return false;
+}
+
+InstanceCuller::InstanceCuller(uint32_t threadCount)
+    : mThreadCount(threadCount ? threadCount : std::max(1u, std::thread::hardware_concurrency())) {}
+
+InstanceCuller::~InstanceCuller() = default;
+
+void InstanceCuller::build(const std::vector<BoundingBox>& instanceBBs) {
+    assert(instanceBBs.size() < std::numeric_limits<uint32_t>::max());
+    mInstanceBounds = instanceBBs;
+    mInstanceOrder.resize(instanceBBs.size());
+    std::iota(mInstanceOrder.begin(), mInstanceOrder.end(), 0);
+
+    mNodes.clear();
+    mTaskRoots.clear();
+    if (instanceBBs.empty()) return;
+
+    mNodes.reserve(2 * (instanceBBs.size() / kMaxLeafSize + 1));
+    buildRecursive(0, (uint32_t)instanceBBs.size());
+    refitNodes();
+    chooseTaskRoots();
+}
+
+uint32_t InstanceCuller::buildRecursive(uint32_t begin, uint32_t end) {
+    uint32_t nodeIndex = (uint32_t)mNodes.size();
+    mNodes.emplace_back();
+    mNodes[nodeIndex].first = begin;
+    mNodes[nodeIndex].count = end - begin;
+    if (end - begin <= kMaxLeafSize) return nodeIndex;
+
+    // Median split along the longest axis of the centroid bounds.
+    float3 centroidMin(std::numeric_limits<float>::max());
+    float3 centroidMax(-std::numeric_limits<float>::max());
+    for (uint32_t i = begin; i < end; i++) {
+        const float3& c = mInstanceBounds[mInstanceOrder[i]].center;
+        centroidMin = glm::min(centroidMin, c);
+        centroidMax = glm::max(centroidMax, c);
+    }
+    float3 size = centroidMax - centroidMin;
+    int axis = (size.x >= size.y && size.x >= size.z) ? 0 : (size.y >= size.z ? 1 : 2);
+
+    uint32_t mid = begin + (end - begin) / 2;
+    std::nth_element(mInstanceOrder.begin() + begin, mInstanceOrder.begin() + mid, mInstanceOrder.begin() + end, [this, axis](uint32_t a, uint32_t b) {
+        return mInstanceBounds[a].center[axis] < mInstanceBounds[b].center[axis];
+    });
+
+    buildRecursive(begin, mid);
+    uint32_t rightChild = buildRecursive(mid, end);
+    mNodes[nodeIndex].rightChild = rightChild;
+    return nodeIndex;
+}
+
+void InstanceCuller::refit(const std::vector<BoundingBox>& instanceBBs) {
+    assert(instanceBBs.size() == mInstanceBounds.size());
+    mInstanceBounds = instanceBBs;
+    refitNodes();
+}
+
+void InstanceCuller::refitNodes() {
+    // Children always come after their parent, so a reverse sweep sees them first.
+    for (size_t i = mNodes.size(); i-- > 0;) {
+        Node& node = mNodes[i];
+        float3 boxMin, boxMax;
+        if (node.isLeaf()) {
+            boxMin = float3(std::numeric_limits<float>::max());
+            boxMax = float3(-std::numeric_limits<float>::max());
+            for (uint32_t j = node.first; j < node.first + node.count; j++) {
+                const BoundingBox& bb = mInstanceBounds[mInstanceOrder[j]];
+                boxMin = glm::min(boxMin, bb.center - bb.extent);
+                boxMax = glm::max(boxMax, bb.center + bb.extent);
+            }
+        } else {
+            const Node& left = mNodes[i + 1];
+            const Node& right = mNodes[node.rightChild];
+            boxMin = glm::min(left.center - left.extent, right.center - right.extent);
+            boxMax = glm::max(left.center + left.extent, right.center + right.extent);
+        }
+        node.center = (boxMin + boxMax) * 0.5f;
+        node.extent = (boxMax - boxMin) * 0.5f;
+    }
+}
+
+void InstanceCuller::chooseTaskRoots() {
+    // Split the top of the tree into enough subtrees to keep all threads busy. Keeping them in left to right
+    // order makes the concatenated result independent of the thread count.
+    const size_t targetCount = mThreadCount > 1 ? (size_t)mThreadCount * kTasksPerThread : 1;
+    mTaskRoots = { 0 };
+    while (mTaskRoots.size() < targetCount) {
+        std::vector<uint32_t> next;
+        bool expanded = false;
+        for (uint32_t nodeIndex : mTaskRoots) {
+            const Node& node = mNodes[nodeIndex];
+            if (node.isLeaf()) {
+                next.push_back(nodeIndex);
+            } else {
+                next.push_back(nodeIndex + 1);
+                next.push_back(node.rightChild);
+                expanded = true;
+            }
+        }
+        if (!expanded) break;
+        mTaskRoots = std::move(next);
+    }
+}
+
+void InstanceCuller::cull(const Frustum& frustum, std::vector<uint32_t>& visibleInstances) {
+    visibleInstances.clear();
+    if (mNodes.empty()) return;
+
+    if (mTaskRoots.size() <= 1) {
+        cullSubtree(frustum, 0, kAllPlanes, visibleInstances);
+        return;
+    }
+
+    if (!mpThreadPool) mpThreadPool = std::make_unique<ThreadPool>(mThreadCount);
+
+    mTaskResults.resize(mTaskRoots.size());
+    std::vector<std::future<void>> futures;
+    futures.reserve(mTaskRoots.size());
+    for (size_t t = 0; t < mTaskRoots.size(); t++) {
+        futures.push_back(mpThreadPool->enqueue([this, &frustum, t]() {
+            mTaskResults[t].clear();
+            cullSubtree(frustum, mTaskRoots[t], kAllPlanes, mTaskResults[t]);
+        }));
+    }
+
+    size_t visibleCount = 0;
+    for (size_t t = 0; t < futures.size(); t++) {
+        futures[t].get();
+        visibleCount += mTaskResults[t].size();
+    }
+
+    visibleInstances.reserve(visibleCount);
+    for (const auto& result : mTaskResults) visibleInstances.insert(visibleInstances.end(), result.begin(), result.end());
+}
+
+void InstanceCuller::cullSubtree(const Frustum& frustum, uint32_t nodeIndex, uint32_t planeMask, std::vector<uint32_t>& visible) const {
+    const Node& node = mNodes[nodeIndex];
+
+    // Only test the planes the parent wasn't already fully inside of.
+    for (int i = 0; i < 6; i++) {
+        if ((planeMask & (1u << i)) == 0) continue;
+        float3 n = float3(frustum.planes[i]);
+        float dist = glm::dot(n, node.center) + frustum.planes[i].w;
+        float radius = glm::dot(glm::abs(n), node.extent);
+        if (dist + radius <= 0.f) return;
+        if (dist - radius > 0.f) planeMask &= ~(1u << i);
+    }
+
+    if (planeMask == 0) {
+        visible.insert(visible.end(), mInstanceOrder.begin() + node.first, mInstanceOrder.begin() + node.first + node.count);
+        return;
+    }
+
+    if (node.isLeaf()) {
+        for (uint32_t j = node.first; j < node.first + node.count; j++) {
+            uint32_t instanceID = mInstanceOrder[j];
+            if (!frustum.isCulled(mInstanceBounds[instanceID])) visible.push_back(instanceID);
+        }
+        return;
+    }
+
+    cullSubtree(frustum, nodeIndex + 1, planeMask, visible);
+    cullSubtree(frustum, node.rightChild, planeMask, visible);
+}
+
+}  // namespace Falcor
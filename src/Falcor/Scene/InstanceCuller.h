@@ -0,0 +1,119 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#ifndef SRC_FALCOR_SCENE_INSTANCECULLER_H_
+#define SRC_FALCOR_SCENE_INSTANCECULLER_H_
+
+#include <memory>
+#include <vector>
+
+#include "Falcor/Core/Framework.h"
+#include "Falcor/Utils/Math/AABB.h"
+
+namespace Falcor {
+
+class ThreadPool;
+
+/** View frustum as six planes. A point p is inside a plane if dot(plane.xyz, p) + plane.w > 0.
+*/
+struct Frustum {
+    float4 planes[6];
+
+    /** Extract the planes from a view-projection matrix with a [0, w] depth range, the same way Camera does.
+    */
+    static Frustum fromViewProjMatrix(const glm::mat4& viewProj);
+
+    /** Check if a box is culled. Matches Camera::isObjectCulled().
+    */
+    bool isCulled(const BoundingBox& box) const;
+};
+
+/** Frustum culling of mesh instances using a BVH over their world-space bounding boxes.
+
+    The BVH is built once with build() and refit with refit() when instance transforms change. cull() traverses it
+    on a thread pool and returns the visible instances. Subtrees that are fully inside the frustum are accepted without
+    testing the instances in them, subtrees that are fully outside are skipped.
+*/
+class dlldecl InstanceCuller {
+ public:
+    /** Create a culler.
+        \param[in] threadCount Number of worker threads for cull(). 0 uses all hardware threads, 1 culls on the calling thread.
+    */
+    explicit InstanceCuller(uint32_t threadCount = 0);
+    ~InstanceCuller();
+
+    /** Build the BVH.
+        \param[in] instanceBBs World-space bounding box of each instance.
+    */
+    void build(const std::vector<BoundingBox>& instanceBBs);
+
+    /** Update the BVH bounds after instances moved. The tree topology is kept, so quality degrades with large motion.
+        \param[in] instanceBBs World-space bounding box of each instance. Must have the same size as in the last build().
+    */
+    void refit(const std::vector<BoundingBox>& instanceBBs);
+
+    /** Find the instances that are not culled by the frustum.
+        \param[in] frustum The view frustum.
+        \param[out] visibleInstances IDs of the visible instances, in BVH order. The result doesn't depend on the thread count.
+    */
+    void cull(const Frustum& frustum, std::vector<uint32_t>& visibleInstances);
+
+    uint32_t getInstanceCount() const { return (uint32_t)mInstanceBounds.size(); }
+    uint32_t getNodeCount() const { return (uint32_t)mNodes.size(); }
+
+ private:
+    /** BVH node in depth-first order. The left child of an interior node directly follows it.
+        Every subtree covers a contiguous range of mInstanceOrder.
+    */
+    struct Node {
+        float3 center;
+        uint32_t rightChild = 0;    ///< 0 for leaves, the root is never a right child.
+        float3 extent;
+        uint32_t first = 0;         ///< First entry of the subtree in mInstanceOrder.
+        uint32_t count = 0;         ///< Number of instances in the subtree.
+
+        bool isLeaf() const { return rightChild == 0; }
+    };
+
+    uint32_t buildRecursive(uint32_t begin, uint32_t end);
+    void refitNodes();
+    void chooseTaskRoots();
+    void cullSubtree(const Frustum& frustum, uint32_t nodeIndex, uint32_t planeMask, std::vector<uint32_t>& visible) const;
+
+    std::vector<Node> mNodes;
+    std::vector<uint32_t> mInstanceOrder;       ///< Instance IDs sorted by leaf.
+    std::vector<BoundingBox> mInstanceBounds;
+    std::vector<uint32_t> mTaskRoots;           ///< Subtrees culled as separate tasks.
+    std::vector<std::vector<uint32_t>> mTaskResults;
+
+    uint32_t mThreadCount;
+    std::unique_ptr<ThreadPool> mpThreadPool;
+};
+
+}  // namespace Falcor
+
+#endif  // SRC_FALCOR_SCENE_INSTANCECULLER_H_
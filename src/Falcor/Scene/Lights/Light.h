@@ -146,6 +146,8 @@ protected:
     float mUiLightIntensityScale = 1.0f;
     LightData mData, mPrevData;
     Changes mChanges = Changes::None;
+
+    friend class SceneBuilder;
 };
 
 /** Directional light source.
@@ -387,6 +387,8 @@ private:
     static UpdateFlags sGlobalUpdates;
 
     std::shared_ptr<Device> mpDevice;
+
+    friend class SceneBuilder;
 };
 
 enum_class_operators(Material::UpdateFlags);
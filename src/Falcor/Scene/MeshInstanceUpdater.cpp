@@ -0,0 +1,186 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "MeshInstanceUpdater.h"
+
+#include <algorithm>
+#include <future>
+#include <thread>
+
+#include "Falcor/Utils/ThreadPool.h"
+
+namespace Falcor {
+
+namespace {
+
+// Below this many items per chunk the work isn't worth a task.
+const size_t kMinChunkSize = 4096;
+const size_t kChunksPerThread = 4;
+
+}  // namespace
+
+MeshInstanceUpdater::MeshInstanceUpdater(uint32_t threadCount)
+    : mThreadCount(threadCount ? threadCount : std::max(1u, std::thread::hardware_concurrency())) {}
+
+MeshInstanceUpdater::~MeshInstanceUpdater() = default;
+
+size_t MeshInstanceUpdater::getChunkCount(size_t count) const {
+    size_t maxChunks = (count + kMinChunkSize - 1) / kMinChunkSize;
+    return std::max<size_t>(1, std::min(maxChunks, (size_t)mThreadCount * kChunksPerThread));
+}
+
+void MeshInstanceUpdater::parallelFor(size_t count, const std::function<void(size_t, size_t, size_t)>& func) {
+    size_t chunkCount = getChunkCount(count);
+    if (chunkCount == 1 || mThreadCount == 1) {
+        // Same chunking as the parallel path, so reductions give identical results.
+        size_t chunkSize = (count + chunkCount - 1) / std::max<size_t>(1, chunkCount);
+        for (size_t c = 0; c < chunkCount; c++) func(c, std::min(count, c * chunkSize), std::min(count, (c + 1) * chunkSize));
+        return;
+    }
+
+    if (!mpThreadPool) mpThreadPool = std::make_unique<ThreadPool>(mThreadCount);
+
+    size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    std::vector<std::future<void>> futures;
+    futures.reserve(chunkCount);
+    for (size_t c = 0; c < chunkCount; c++) {
+        size_t begin = std::min(count, c * chunkSize);
+        size_t end = std::min(count, begin + chunkSize);
+        futures.push_back(mpThreadPool->enqueue([&func, c, begin, end]() { func(c, begin, end); }));
+    }
+    for (auto& f : futures) f.get();
+}
+
+void MeshInstanceUpdater::init(const std::vector<MeshInstanceData>& instances, uint32_t matrixCount) {
+    // Counting sort of the instances by matrix ID.
+    mMatrixInstanceOffsets.assign((size_t)matrixCount + 1, 0);
+    for (const auto& inst : instances) {
+        assert(inst.globalMatrixID < matrixCount);
+        mMatrixInstanceOffsets[inst.globalMatrixID + 1]++;
+    }
+    for (size_t m = 1; m < mMatrixInstanceOffsets.size(); m++) mMatrixInstanceOffsets[m] += mMatrixInstanceOffsets[m - 1];
+
+    mMatrixInstances.resize(instances.size());
+    std::vector<uint32_t> cursor(mMatrixInstanceOffsets.begin(), mMatrixInstanceOffsets.end() - 1);
+    for (uint32_t i = 0; i < (uint32_t)instances.size(); i++) {
+        mMatrixInstances[cursor[instances[i].globalMatrixID]++] = i;
+    }
+}
+
+void MeshInstanceUpdater::findChangedInstances(const std::vector<uint32_t>& changedMatrixIDs, std::vector<uint32_t>& instanceIDs) const {
+    instanceIDs.clear();
+    for (uint32_t matrixID : changedMatrixIDs) {
+        assert(matrixID + 1 < mMatrixInstanceOffsets.size());
+        instanceIDs.insert(instanceIDs.end(), mMatrixInstances.begin() + mMatrixInstanceOffsets[matrixID], mMatrixInstances.begin() + mMatrixInstanceOffsets[matrixID + 1]);
+    }
+
+    // Each instance has a single matrix, so there are no duplicates as long as the matrix IDs are unique.
+    std::sort(instanceIDs.begin(), instanceIDs.end());
+    instanceIDs.erase(std::unique(instanceIDs.begin(), instanceIDs.end()), instanceIDs.end());
+}
+
+void MeshInstanceUpdater::updateBounds(const std::vector<MeshInstanceData>& instances, const std::vector<BoundingBox>& meshBBs, const std::vector<glm::mat4>& globalMatrices, std::vector<BoundingBox>& instanceBBs) {
+    instanceBBs.resize(instances.size());
+    parallelFor(instances.size(), [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const auto& inst = instances[i];
+            instanceBBs[i] = meshBBs[inst.meshID].transform(globalMatrices[inst.globalMatrixID]);
+        }
+    });
+}
+
+void MeshInstanceUpdater::updateBounds(const std::vector<uint32_t>& instanceIDs, const std::vector<MeshInstanceData>& instances, const std::vector<BoundingBox>& meshBBs, const std::vector<glm::mat4>& globalMatrices, std::vector<BoundingBox>& instanceBBs) {
+    assert(instanceBBs.size() == instances.size());
+    parallelFor(instanceIDs.size(), [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const auto& inst = instances[instanceIDs[i]];
+            instanceBBs[instanceIDs[i]] = meshBBs[inst.meshID].transform(globalMatrices[inst.globalMatrixID]);
+        }
+    });
+}
+
+BoundingBox MeshInstanceUpdater::computeSceneBounds(const std::vector<BoundingBox>& instanceBBs) {
+    if (instanceBBs.empty()) return BoundingBox();
+
+    std::vector<float3> chunkMin(getChunkCount(instanceBBs.size()), float3(std::numeric_limits<float>::max()));
+    std::vector<float3> chunkMax(chunkMin.size(), float3(-std::numeric_limits<float>::max()));
+    parallelFor(instanceBBs.size(), [&](size_t chunk, size_t begin, size_t end) {
+        float3 boxMin = chunkMin[chunk];
+        float3 boxMax = chunkMax[chunk];
+        for (size_t i = begin; i < end; i++) {
+            boxMin = glm::min(boxMin, instanceBBs[i].getMinPos());
+            boxMax = glm::max(boxMax, instanceBBs[i].getMaxPos());
+        }
+        chunkMin[chunk] = boxMin;
+        chunkMax[chunk] = boxMax;
+    });
+
+    float3 boxMin = chunkMin[0];
+    float3 boxMax = chunkMax[0];
+    for (size_t c = 1; c < chunkMin.size(); c++) {
+        boxMin = glm::min(boxMin, chunkMin[c]);
+        boxMax = glm::max(boxMax, chunkMax[c]);
+    }
+    return BoundingBox::fromMinMax(boxMin, boxMax);
+}
+
+void MeshInstanceUpdater::updateFlags(std::vector<MeshInstanceData>& instances, const std::vector<glm::mat4>& globalMatrices, std::vector<Range>& dirtyRanges) {
+    updateFlags(instances.size(), [](size_t i) { return (uint32_t)i; }, instances, globalMatrices, dirtyRanges);
+}
+
+void MeshInstanceUpdater::updateFlags(const std::vector<uint32_t>& instanceIDs, std::vector<MeshInstanceData>& instances, const std::vector<glm::mat4>& globalMatrices, std::vector<Range>& dirtyRanges) {
+    assert(std::is_sorted(instanceIDs.begin(), instanceIDs.end()));
+    updateFlags(instanceIDs.size(), [&instanceIDs](size_t i) { return instanceIDs[i]; }, instances, globalMatrices, dirtyRanges);
+}
+
+void MeshInstanceUpdater::updateFlags(size_t count, const std::function<uint32_t(size_t)>& getInstanceID, std::vector<MeshInstanceData>& instances, const std::vector<glm::mat4>& globalMatrices, std::vector<Range>& dirtyRanges) {
+    mFlagsChanged.resize(count);
+    parallelFor(count, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            auto& inst = instances[getInstanceID(i)];
+            uint32_t prevFlags = inst.flags;
+            inst.flags = (uint32_t)MeshInstanceFlags::None;
+            if (doesTransformFlip(globalMatrices[inst.globalMatrixID])) inst.flags |= (uint32_t)MeshInstanceFlags::Flipped;
+            mFlagsChanged[i] = inst.flags != prevFlags ? 1 : 0;
+        }
+    });
+
+    // Collect the changed instances into ranges, merging ranges that are close enough to upload together.
+    dirtyRanges.clear();
+    for (size_t i = 0; i < count; i++) {
+        if (!mFlagsChanged[i]) continue;
+        uint32_t instanceID = getInstanceID(i);
+        if (!dirtyRanges.empty() && instanceID - (dirtyRanges.back().first + dirtyRanges.back().count) <= kMaxRangeGap) {
+            dirtyRanges.back().count = instanceID - dirtyRanges.back().first + 1;
+        } else {
+            dirtyRanges.push_back({ instanceID, 1 });
+        }
+    }
+}
+
+}  // namespace Falcor
@@ -0,0 +1,122 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#ifndef SRC_FALCOR_SCENE_MESHINSTANCEUPDATER_H_
+#define SRC_FALCOR_SCENE_MESHINSTANCEUPDATER_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "Falcor/Core/Framework.h"
+#include "Falcor/Utils/Math/AABB.h"
+#include "SceneTypes.slang"
+
+namespace Falcor {
+
+class ThreadPool;
+
+/** Checks if the transform flips the coordinate system handedness (its determinant is negative).
+*/
+inline bool doesTransformFlip(const glm::mat4& m) {
+    return glm::determinant((glm::mat3)m) < 0.f;
+}
+
+/** CPU side of the per-frame mesh instance updates, driven by the global matrices that changed.
+
+    Keeps a matrix -> instances index so an animation that moves a single node only touches the instances attached
+    to it. World bounds and instance flags are updated in parallel on an internal thread pool for large inputs.
+*/
+class dlldecl MeshInstanceUpdater {
+ public:
+    /** Range of mesh instances, e.g. a dirty range of the instance buffer.
+    */
+    struct Range {
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    /** Create an updater.
+        \param[in] threadCount Number of worker threads. 0 uses all hardware threads, 1 runs everything on the calling thread.
+    */
+    explicit MeshInstanceUpdater(uint32_t threadCount = 0);
+    ~MeshInstanceUpdater();
+
+    /** Index the instances by global matrix. Call again whenever the instance list changes.
+    */
+    void init(const std::vector<MeshInstanceData>& instances, uint32_t matrixCount);
+
+    /** Find the instances that use any of the changed matrices.
+        \param[in] changedMatrixIDs IDs of the global matrices that changed.
+        \param[out] instanceIDs Affected mesh instances, sorted and unique.
+    */
+    void findChangedInstances(const std::vector<uint32_t>& changedMatrixIDs, std::vector<uint32_t>& instanceIDs) const;
+
+    /** Transform the mesh bounds of all instances into world space.
+        \param[out] instanceBBs World bounds per instance. Resized to the instance count.
+    */
+    void updateBounds(const std::vector<MeshInstanceData>& instances, const std::vector<BoundingBox>& meshBBs, const std::vector<glm::mat4>& globalMatrices, std::vector<BoundingBox>& instanceBBs);
+
+    /** Transform the mesh bounds of some instances into world space. instanceBBs must already hold an entry per instance.
+    */
+    void updateBounds(const std::vector<uint32_t>& instanceIDs, const std::vector<MeshInstanceData>& instances, const std::vector<BoundingBox>& meshBBs, const std::vector<glm::mat4>& globalMatrices, std::vector<BoundingBox>& instanceBBs);
+
+    /** Compute the union of all instance bounds with a parallel reduction.
+    */
+    BoundingBox computeSceneBounds(const std::vector<BoundingBox>& instanceBBs);
+
+    /** Recompute the flags of all instances.
+        \param[out] dirtyRanges Ranges of instances whose flags changed, sorted. Nearby ranges are merged.
+    */
+    void updateFlags(std::vector<MeshInstanceData>& instances, const std::vector<glm::mat4>& globalMatrices, std::vector<Range>& dirtyRanges);
+
+    /** Recompute the flags of some instances.
+        \param[in] instanceIDs Instances to update, sorted.
+        \param[out] dirtyRanges Ranges of instances whose flags changed, sorted. Nearby ranges are merged.
+    */
+    void updateFlags(const std::vector<uint32_t>& instanceIDs, std::vector<MeshInstanceData>& instances, const std::vector<glm::mat4>& globalMatrices, std::vector<Range>& dirtyRanges);
+
+    /** Dirty ranges closer than this many instances are merged into one upload.
+    */
+    static const uint32_t kMaxRangeGap = 64;
+
+ private:
+    size_t getChunkCount(size_t count) const;
+    void parallelFor(size_t count, const std::function<void(size_t, size_t, size_t)>& func);
+    void updateFlags(size_t count, const std::function<uint32_t(size_t)>& getInstanceID, std::vector<MeshInstanceData>& instances, const std::vector<glm::mat4>& globalMatrices, std::vector<Range>& dirtyRanges);
+
+    std::vector<uint32_t> mMatrixInstanceOffsets;   ///< Per matrix, first entry in mMatrixInstances. Has matrixCount + 1 entries.
+    std::vector<uint32_t> mMatrixInstances;         ///< Instance IDs grouped by matrix.
+    std::vector<uint8_t> mFlagsChanged;             ///< Scratch, one entry per updated instance.
+
+    uint32_t mThreadCount;
+    std::unique_ptr<ThreadPool> mpThreadPool;
+};
+
+}  // namespace Falcor
+
+#endif  // SRC_FALCOR_SCENE_MESHINSTANCEUPDATER_H_
@@ -31,6 +31,7 @@
 #include "Scene.h"
 #include "HitInfo.h"
 #include "Importer.h"
+#include "DrawBatching.h"
 
 #ifdef FALCOR_D3D12
 #include "Raytracing/RtProgram/RtProgram.h"
@@ -65,12 +66,6 @@ typedef struct D3D12_DRAW_ARGUMENTS {
 
     namespace
     {
-        // Checks if the transform flips the coordinate system handedness (its determinant is negative).
-        bool doesTransformFlip(const glm::mat4& m)
-        {
-            return glm::determinant((glm::mat3)m) < 0.f;
-        }
-
         const std::string kParameterBlockName = "gScene";
         const std::string kMeshBufferName = "meshes";
         const std::string kMeshInstanceBufferName = "meshInstances";
@@ -132,7 +127,7 @@ typedef struct D3D12_DRAW_ARGUMENTS {
         if (!mpLightCollection)
         {
             mpLightCollection = LightCollection::create(pContext, shared_from_this());
-            mpLightCollection->setShaderData(mpSceneBlock["lightCollection"]);
+            mpLightCollection->setShaderData(mpSceneBlock[mHandles.lightCollection]);
         }
         return mpLightCollection;
     }
@@ -142,24 +137,52 @@ typedef struct D3D12_DRAW_ARGUMENTS {
         PROFILE(mpDevice, "renderScene");
 
         pState->setVao(mpVao);
-        pVars->setParameterBlock("gScene", mpSceneBlock);
+        bindSceneBlock(pVars);
 
         bool overrideRS = !is_set(flags, RenderFlags::UserRasterizerState);
         auto pCurrentRS = pState->getRasterizerState();
         bool isIndexed = hasIndexBuffer();
 
+        bool culled = mFrustumCulling && is_set(flags, RenderFlags::FrustumCulling);
+        const DrawArgs& drawCounterClockwise = culled ? mCulledDrawCounterClockwiseMeshes : mDrawCounterClockwiseMeshes;
+        const DrawArgs& drawClockwise = culled ? mCulledDrawClockwiseMeshes : mDrawClockwiseMeshes;
+
+        if (drawCounterClockwise.count)
+        {
+            if (overrideRS) pState->setRasterizerState(nullptr);
+            if (isIndexed) pContext->drawIndexedIndirect(pState, pVars, drawCounterClockwise.count, drawCounterClockwise.pBuffer.get(), 0, nullptr, 0);
+            else pContext->drawIndirect(pState, pVars, drawCounterClockwise.count, drawCounterClockwise.pBuffer.get(), 0, nullptr, 0);
+        }
+
+        if (drawClockwise.count)
+        {
+            if (overrideRS) pState->setRasterizerState(mpFrontClockwiseRS);
+            if (isIndexed) pContext->drawIndexedIndirect(pState, pVars, drawClockwise.count, drawClockwise.pBuffer.get(), 0, nullptr, 0);
+            else pContext->drawIndirect(pState, pVars, drawClockwise.count, drawClockwise.pBuffer.get(), 0, nullptr, 0);
+        }
+
+        if (overrideRS) pState->setRasterizerState(pCurrentRS);
+    }
+
+    void Scene::precreatePipelines(GraphicsState* pState, GraphicsVars* pVars, RenderFlags flags)
+    {
+        // Same state changes as render(), with culling the draw counts can only shrink
+        pState->setVao(mpVao);
+        bindSceneBlock(pVars);
+
+        bool overrideRS = !is_set(flags, RenderFlags::UserRasterizerState);
+        auto pCurrentRS = pState->getRasterizerState();
+
         if (mDrawCounterClockwiseMeshes.count)
         {
             if (overrideRS) pState->setRasterizerState(nullptr);
-            if (isIndexed) pContext->drawIndexedIndirect(pState, pVars, mDrawCounterClockwiseMeshes.count, mDrawCounterClockwiseMeshes.pBuffer.get(), 0, nullptr, 0);
-            else pContext->drawIndirect(pState, pVars, mDrawCounterClockwiseMeshes.count, mDrawCounterClockwiseMeshes.pBuffer.get(), 0, nullptr, 0);
+            pState->precreateGSO(pVars);
         }
 
         if (mDrawClockwiseMeshes.count)
         {
             if (overrideRS) pState->setRasterizerState(mpFrontClockwiseRS);
-            if (isIndexed) pContext->drawIndexedIndirect(pState, pVars, mDrawClockwiseMeshes.count, mDrawClockwiseMeshes.pBuffer.get(), 0, nullptr, 0);
-            else pContext->drawIndirect(pState, pVars, mDrawClockwiseMeshes.count, mDrawClockwiseMeshes.pBuffer.get(), 0, nullptr, 0);
+            pState->precreateGSO(pVars);
         }
 
         if (overrideRS) pState->setRasterizerState(pCurrentRS);
@@ -199,6 +222,7 @@ typedef struct D3D12_DRAW_ARGUMENTS {
         assert(pReflection);
 
         mpSceneBlock = ParameterBlock::create(mpDevice, pReflection);
+        resolveShaderVarHandles();
         mpMeshesBuffer = Buffer::createStructured(mpDevice, mpSceneBlock[kMeshBufferName], (uint32_t)mMeshDesc.size(), Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, nullptr, false);
         mpMeshesBuffer->setName("Scene::mpMeshesBuffer");
         mpMeshInstancesBuffer = Buffer::createStructured(mpDevice, mpSceneBlock[kMeshInstanceBufferName], (uint32_t)mMeshInstanceData.size(), Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, nullptr, false);
@@ -217,6 +241,46 @@ typedef struct D3D12_DRAW_ARGUMENTS {
 
     }
 
+    void Scene::resolveShaderVarHandles()
+    {
+        auto resolve = [](ShaderVarHandle& handle, const std::string& path, const ShaderVar& parent)
+        {
+            handle = ShaderVarHandle(path);
+            handle.resolve(parent);
+        };
+
+        auto sceneVar = mpSceneBlock->getRootVar();
+        resolve(mHandles.camera, kCamera, sceneVar);
+        resolve(mHandles.lightCount, "lightCount", sceneVar);
+        resolve(mHandles.lightProbe, "lightProbe", sceneVar);
+        resolve(mHandles.lightCollection, "lightCollection", sceneVar);
+        resolve(mHandles.envMap, kEnvMap, sceneVar);
+        resolve(mHandles.materialResources, "materialResources", sceneVar);
+
+        // The array is sized by MATERIAL_COUNT, there is nothing to resolve the element members against in a scene without materials
+        if (mMaterials.empty()) return;
+        auto materialVar = sceneVar[mHandles.materialResources][size_t(0)];
+        resolve(mHandles.baseColor, "baseColor", materialVar);
+        resolve(mHandles.specular, "specular", materialVar);
+        resolve(mHandles.roughness, "roughness", materialVar);
+        resolve(mHandles.emissive, "emissive", materialVar);
+        resolve(mHandles.normalMap, "normalMap", materialVar);
+        resolve(mHandles.occlusionMap, "occlusionMap", materialVar);
+        resolve(mHandles.samplerState, "samplerState", materialVar);
+    }
+
+    void Scene::bindSceneBlock(ProgramVars* pVars)
+    {
+        // Passes usually keep their vars, so the lookup by name only happens when the vars of another program come in
+        auto rootVar = pVars->getRootVar();
+        if (!mVarsSceneBlockHandle.isResolvedFor(rootVar))
+        {
+            mVarsSceneBlockHandle = ShaderVarHandle(kParameterBlockName);
+            if (!mVarsSceneBlockHandle.resolve(rootVar)) return;
+        }
+        rootVar[mVarsSceneBlockHandle].setParameterBlock(mpSceneBlock);
+    }
+
     void Scene::uploadResources()
     {
         // Upload geometry
@@ -232,7 +296,7 @@ typedef struct D3D12_DRAW_ARGUMENTS {
 
         if (mpLightProbe)
         {
-            mpLightProbe->setShaderData(mpSceneBlock["lightProbe"]);
+            mpLightProbe->setShaderData(mpSceneBlock[mHandles.lightProbe]);
         }
     }
 
@@ -248,9 +312,9 @@ typedef struct D3D12_DRAW_ARGUMENTS {
 
         const auto& resources = material->getResources();
 
-        auto var = mpSceneBlock["materialResources"][materialID];
+        auto var = mpSceneBlock[mHandles.materialResources][materialID];
 
-#define set_texture(texName) var[#texName] = resources.texName;
+#define set_texture(texName) var[mHandles.texName] = resources.texName;
         set_texture(baseColor);
         set_texture(specular);
         set_texture(roughness);
@@ -259,51 +323,105 @@ typedef struct D3D12_DRAW_ARGUMENTS {
         set_texture(occlusionMap);
 #undef set_texture
 
-        var["samplerState"] = resources.samplerState;
+        var[mHandles.samplerState] = resources.samplerState;
     }
 
     void Scene::uploadSelectedCamera()
     {
-        getCamera()->setShaderData(mpSceneBlock[kCamera]);
+        getCamera()->setShaderData(mpSceneBlock[mHandles.camera]);
     }
 
-    void Scene::updateBounds()
+    void Scene::updateBounds(bool forceUpdate)
     {
         const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
-        std::vector<BoundingBox> instanceBBs;
-        instanceBBs.reserve(mMeshInstanceData.size());
-
-        for (const auto& inst : mMeshInstanceData)
+        if (forceUpdate || mInstanceBBs.size() != mMeshInstanceData.size())
         {
-            const BoundingBox& meshBB = mMeshBBs[inst.meshID];
-            const glm::mat4& transform = globalMatrices[inst.globalMatrixID];
-            instanceBBs.push_back(meshBB.transform(transform));
+            mInstanceUpdater.updateBounds(mMeshInstanceData, mMeshBBs, globalMatrices, mInstanceBBs);
         }
-
-        mSceneBB = instanceBBs.front();
-        for (const BoundingBox& bb : instanceBBs)
+        else
         {
-            mSceneBB = BoundingBox::fromUnion(mSceneBB, bb);
+            mInstanceUpdater.updateBounds(mChangedInstances, mMeshInstanceData, mMeshBBs, globalMatrices, mInstanceBBs);
         }
+
+        mSceneBB = mInstanceUpdater.computeSceneBounds(mInstanceBBs);
     }
 
-    void Scene::updateMeshInstances(bool forceUpdate)
+    void Scene::updateMeshVertices(uint32_t meshID, const std::vector<StaticVertexData>& vertices)
     {
-        bool dataChanged = false;
-        const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
+        assert(meshID < mMeshDesc.size());
+        const MeshDesc& mesh = mMeshDesc[meshID];
+        if (vertices.size() != mesh.vertexCount) throw std::runtime_error("Scene::updateMeshVertices() vertex count doesn't match the mesh");
+        if (mMeshHasDynamicData[meshID]) throw std::runtime_error("Scene::updateMeshVertices() can't update skinned meshes");
 
-        for (auto& inst : mMeshInstanceData)
+        std::vector<PackedStaticVertexData> staticData(vertices.size());
+        std::vector<PrevVertexData> prevData(vertices.size());
+        float3 boxMin(std::numeric_limits<float>::max());
+        float3 boxMax(-std::numeric_limits<float>::max());
+        for (size_t i = 0; i < vertices.size(); i++)
         {
-            uint32_t prevFlags = inst.flags;
-            inst.flags = (uint32_t)MeshInstanceFlags::None;
+            staticData[i].pack(vertices[i]);
+            prevData[i].position = vertices[i].position;
+            boxMin = glm::min(boxMin, vertices[i].position);
+            boxMax = glm::max(boxMax, vertices[i].position);
+        }
+
+        // Previous positions are replaced too, an edit is not motion
+        mpVao->getVertexBuffer(kStaticDataBufferIndex)->setBlob(staticData.data(), mesh.vbOffset * sizeof(PackedStaticVertexData), staticData.size() * sizeof(PackedStaticVertexData));
+        mpVao->getVertexBuffer(kPrevVertexBufferIndex)->setBlob(prevData.data(), mesh.vbOffset * sizeof(PrevVertexData), prevData.size() * sizeof(PrevVertexData));
+
+        mMeshBBs[meshID] = BoundingBox::fromMinMax(boxMin, boxMax);
+        mUpdatedMeshes.push_back(meshID);
+    }
+
+    void Scene::setNodeTransform(uint32_t nodeID, const glm::mat4& transform)
+    {
+        assert(nodeID < mSceneGraph.size());
+        mSceneGraph[nodeID].transform = transform;
+        mpAnimationController->invalidateLocalMatrix(nodeID);
+    }
+
+    void Scene::setFrustumCulling(bool enabled)
+    {
+        if (enabled == mFrustumCulling) return;
+        mFrustumCulling = enabled;
+        mFrustumCullingDirty = true;
+    }
+
+    void Scene::updateFrustumCulling()
+    {
+        if (!mFrustumCulling || !mpInstanceCuller) return;
+
+        bool meshesMoved = is_set(mUpdates, UpdateFlags::MeshesMoved);
+        bool cameraChanged = is_set(mUpdates, UpdateFlags::CameraMoved | UpdateFlags::CameraPropertiesChanged | UpdateFlags::CameraSwitched);
+        if (!mFrustumCullingDirty && !meshesMoved && !cameraChanged) return;
+        mFrustumCullingDirty = false;
+
+        PROFILE(mpDevice, "frustumCulling");
 
-            const glm::mat4& transform = globalMatrices[inst.globalMatrixID];
-            if (doesTransformFlip(transform)) inst.flags |= (uint32_t)MeshInstanceFlags::Flipped;
+        Frustum frustum = Frustum::fromViewProjMatrix(getCamera()->getViewProjMatrix());
+        mpInstanceCuller->cull(frustum, mVisibleInstances);
 
-            dataChanged |= (inst.flags != prevFlags);
+        // The second half of the draw ID buffer holds the draw IDs of the visible instances.
+        DrawBatchList batches = buildDrawBatches(mVisibleInstances, mInstanceMeshIDs, mInstanceFlipped, getMeshCount());
+        const uint32_t drawIDOffset = getMeshInstanceCount();
+        if (!batches.drawIDs.empty())
+        {
+            mpVao->getVertexBuffer(kDrawIdBufferIndex)->setBlob(batches.drawIDs.data(), drawIDOffset * sizeof(uint32_t), batches.drawIDs.size() * sizeof(uint32_t));
         }
 
-        if (forceUpdate || dataChanged)
+        uploadDrawArgs(batches.counterClockwise, drawIDOffset, mCulledDrawCounterClockwiseMeshes, "Scene::mCulledDrawCounterClockwiseMeshes::pBuffer");
+        uploadDrawArgs(batches.clockwise, drawIDOffset, mCulledDrawClockwiseMeshes, "Scene::mCulledDrawClockwiseMeshes::pBuffer");
+    }
+
+    void Scene::updateMeshInstances(bool forceUpdate)
+    {
+        const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
+
+        std::vector<MeshInstanceUpdater::Range> dirtyRanges;
+        if (forceUpdate) mInstanceUpdater.updateFlags(mMeshInstanceData, globalMatrices, dirtyRanges);
+        else mInstanceUpdater.updateFlags(mChangedInstances, mMeshInstanceData, globalMatrices, dirtyRanges);
+
+        if (forceUpdate)
         {
             // Make sure the scene data fits in the packed format.
             // TODO: If we run into the limits, use bits from the materialID field.
@@ -322,7 +440,29 @@ typedef struct D3D12_DRAW_ARGUMENTS {
             size_t byteSize = sizeof(PackedMeshInstanceData) * mPackedMeshInstanceData.size();
             assert(mpMeshInstancesBuffer && mpMeshInstancesBuffer->getSize() == byteSize);
             mpMeshInstancesBuffer->setBlob(mPackedMeshInstanceData.data(), 0, byteSize);
+            return;
+        }
+
+        // Only repack and upload the instances whose flags changed.
+        bool windingChanged = false;
+        for (const auto& range : dirtyRanges)
+        {
+            for (uint32_t i = range.first; i < range.first + range.count; i++)
+            {
+                mPackedMeshInstanceData[i].pack(mMeshInstanceData[i]);
+
+                uint8_t flipped = (mMeshInstanceData[i].flags & (uint32_t)MeshInstanceFlags::Flipped) ? 1 : 0;
+                if (i < mInstanceFlipped.size() && mInstanceFlipped[i] != flipped)
+                {
+                    mInstanceFlipped[i] = flipped;
+                    windingChanged = true;
+                }
+            }
+            mpMeshInstancesBuffer->setBlob(mPackedMeshInstanceData.data() + range.first, range.first * sizeof(PackedMeshInstanceData), range.count * sizeof(PackedMeshInstanceData));
         }
+
+        // An animation flipped the determinant of some instances, they move to the draws of the other winding.
+        if (windingChanged) updateDrawBatches();
     }
 
     void Scene::finalize() {
@@ -336,10 +476,11 @@ typedef struct D3D12_DRAW_ARGUMENTS {
         timeReport.measure("Scene::finalize initResources");
 
         mpAnimationController->animate(mpDevice->getRenderContext(), 0); // Requires Scene block to exist
+        mInstanceUpdater.init(mMeshInstanceData, (uint32_t)mSceneGraph.size());
         updateMeshInstances(true);
         timeReport.measure("Scene::finalize updateMeshInstances");
 
-        updateBounds();
+        updateBounds(true);
         timeReport.measure("Scene::finalize updateBounds");
 
         createDrawList();
@@ -546,7 +687,7 @@ typedef struct D3D12_DRAW_ARGUMENTS {
 
         if (combinedChanges != Light::Changes::None || forceUpdate)
         {
-            mpSceneBlock["lightCount"] = lightCount;
+            mpSceneBlock[mHandles.lightCount] = lightCount;
             updateLightStats();
         }
 
@@ -572,7 +713,7 @@ typedef struct D3D12_DRAW_ARGUMENTS {
             if (envMapChanges != EnvMap::Changes::None || forceUpdate)
             {
                 if (envMapChanges != EnvMap::Changes::None) flags |= UpdateFlags::EnvMapChanged;
-                mpEnvMap->setShaderData(mpSceneBlock[kEnvMap]);
+                mpEnvMap->setShaderData(mpSceneBlock[mHandles.envMap]);
             }
         }
 
@@ -606,16 +747,26 @@ typedef struct D3D12_DRAW_ARGUMENTS {
     Scene::UpdateFlags Scene::update(RenderContext* pContext, double currentTime)
     {
         mUpdates = UpdateFlags::None;
+        mChangedInstances.clear();
         if (mpAnimationController->animate(pContext, currentTime))
         {
             mUpdates |= UpdateFlags::SceneGraphChanged;
-            for (const auto& inst : mMeshInstanceData)
+            mInstanceUpdater.findChangedInstances(mpAnimationController->getChangedMatrixIDs(), mChangedInstances);
+            if (!mChangedInstances.empty()) mUpdates |= UpdateFlags::MeshesMoved;
+        }
+
+        if (!mUpdatedMeshes.empty())
+        {
+            // The instances of updated meshes need new world bounds
+            for (uint32_t meshID : mUpdatedMeshes)
             {
-                if (mpAnimationController->didMatrixChanged(inst.globalMatrixID))
-                {
-                    mUpdates |= UpdateFlags::MeshesMoved;
-                }
+                const auto& instanceIDs = mMeshIdToInstanceIds[meshID];
+                mChangedInstances.insert(mChangedInstances.end(), instanceIDs.begin(), instanceIDs.end());
             }
+            mUpdatedMeshes.clear();
+            std::sort(mChangedInstances.begin(), mChangedInstances.end());
+            mChangedInstances.erase(std::unique(mChangedInstances.begin(), mChangedInstances.end()), mChangedInstances.end());
+            mUpdates |= UpdateFlags::GeometryChanged | UpdateFlags::MeshesMoved;
         }
 
         mUpdates |= updateSelectedCamera(false);
@@ -627,11 +778,15 @@ typedef struct D3D12_DRAW_ARGUMENTS {
         {
             mTlasCache.clear();
             updateMeshInstances(false);
+            updateBounds(false);
+            if (mpInstanceCuller) mpInstanceCuller->refit(mInstanceBBs);
         }
 
+        updateFrustumCulling();
+
         // If a transform in the scene changed, update BLASes with skinned meshes
         #ifdef FALCOR_D3D12
-        if (mBlasData.size() && mHasSkinnedMesh && is_set(mUpdates, UpdateFlags::SceneGraphChanged))
+        if (mBlasData.size() && ((mHasSkinnedMesh && is_set(mUpdates, UpdateFlags::SceneGraphChanged)) || is_set(mUpdates, UpdateFlags::GeometryChanged)))
         {
             mTlasCache.clear();
             buildBlas(pContext);
@@ -670,6 +825,10 @@ typedef struct D3D12_DRAW_ARGUMENTS {
             mpCamCtrl->setCameraSpeed(mCameraSpeed);
         }
 
+        bool frustumCulling = mFrustumCulling;
+        if (widget.checkbox("Frustum Culling", frustumCulling)) setFrustumCulling(frustumCulling);
+        if (mFrustumCulling) widget.text("Visible instances: " + std::to_string(getVisibleInstanceCount()) + " / " + std::to_string(getMeshInstanceCount()));
+
         if (mCameraList.size() > 1)
         {
             uint32_t camIndex = mSelectedCamera;
@@ -974,69 +1133,97 @@ typedef struct D3D12_DRAW_ARGUMENTS {
 
     void Scene::createDrawList()
     {
-        auto pMatricesBuffer = mpSceneBlock->getBuffer("worldMatrices");
-        const glm::mat4* matrices = (glm::mat4*)pMatricesBuffer->map(Buffer::MapType::Read); // #SCENEV2 This will cause the pipeline to flush and sync, but it's probably not too bad as this only happens once
+        // Instances of the same mesh with the same winding are drawn with a single multi-instance draw.
+        // The winding comes from the instance flags, which updateMeshInstances() keeps in sync with the matrices.
+        mInstanceMeshIDs.resize(mMeshInstanceData.size());
+        mInstanceFlipped.resize(mMeshInstanceData.size());
+        for (size_t i = 0; i < mMeshInstanceData.size(); i++)
+        {
+            mInstanceMeshIDs[i] = mMeshInstanceData[i].meshID;
+            mInstanceFlipped[i] = (mMeshInstanceData[i].flags & (uint32_t)MeshInstanceFlags::Flipped) ? 1 : 0;
+        }
+
+        mDrawCounterClockwiseMeshes = {};
+        mDrawClockwiseMeshes = {};
+        updateDrawBatches();
 
-        auto createBuffers = [&](const auto& drawClockwiseMeshes, const auto& drawCounterClockwiseMeshes)
+        // Culled draws are a subset of the full ones, so buffers of the same size only grow when the winding of instances changes.
+        auto createCulledBuffer = [&](DrawArgs& culled, const DrawArgs& full, const std::string& name)
         {
-            // Create the draw-indirect buffer
-            if (drawCounterClockwiseMeshes.size())
-            {
-                mDrawCounterClockwiseMeshes.pBuffer = Buffer::create(mpDevice, sizeof(drawCounterClockwiseMeshes[0]) * drawCounterClockwiseMeshes.size(), Resource::BindFlags::IndirectArg, Buffer::CpuAccess::None, drawCounterClockwiseMeshes.data());
-                mDrawCounterClockwiseMeshes.pBuffer->setName("Scene::mDrawCounterClockwiseMeshes::pBuffer");
-                mDrawCounterClockwiseMeshes.count = (uint32_t)drawCounterClockwiseMeshes.size();
-            }
+            culled = {};
+            if (!full.pBuffer) return;
+            culled.pBuffer = Buffer::create(mpDevice, full.pBuffer->getSize(), Resource::BindFlags::IndirectArg, Buffer::CpuAccess::None, nullptr);
+            culled.pBuffer->setName(name);
+        };
+        createCulledBuffer(mCulledDrawCounterClockwiseMeshes, mDrawCounterClockwiseMeshes, "Scene::mCulledDrawCounterClockwiseMeshes::pBuffer");
+        createCulledBuffer(mCulledDrawClockwiseMeshes, mDrawClockwiseMeshes, "Scene::mCulledDrawClockwiseMeshes::pBuffer");
+
+        mpInstanceCuller = std::make_unique<InstanceCuller>();
+        mpInstanceCuller->build(mInstanceBBs);
+        mFrustumCullingDirty = true;
+    }
+
+    void Scene::updateDrawBatches()
+    {
+        DrawBatchList batches = buildDrawBatches(mInstanceMeshIDs, mInstanceFlipped, getMeshCount());
+        LOG_DBG("Scene::updateDrawBatches %zu mesh instances in %zu draws", mMeshInstanceData.size(), batches.getDrawCount());
+
+        // The draw ID vertex stream maps the draw's instance index back to the mesh instance ID.
+        const auto& pDrawIDBuffer = mpVao->getVertexBuffer(kDrawIdBufferIndex);
+        assert(pDrawIDBuffer && pDrawIDBuffer->getSize() >= 2 * batches.drawIDs.size() * sizeof(uint32_t));
+        pDrawIDBuffer->setBlob(batches.drawIDs.data(), 0, batches.drawIDs.size() * sizeof(uint32_t));
+
+        uploadDrawArgs(batches.counterClockwise, 0, mDrawCounterClockwiseMeshes, "Scene::mDrawCounterClockwiseMeshes::pBuffer");
+        uploadDrawArgs(batches.clockwise, 0, mDrawClockwiseMeshes, "Scene::mDrawClockwiseMeshes::pBuffer");
 
-            if (drawClockwiseMeshes.size())
+        // The culled batches were built with the previous winding
+        mFrustumCullingDirty = true;
+    }
+
+    void Scene::uploadDrawArgs(const std::vector<DrawBatch>& batchList, uint32_t startInstanceOffset, DrawArgs& drawArgs, const std::string& name)
+    {
+        auto upload = [&](const auto& args)
+        {
+            drawArgs.count = (uint32_t)args.size();
+            if (args.empty()) return;
+
+            size_t size = sizeof(args[0]) * args.size();
+            if (drawArgs.pBuffer && drawArgs.pBuffer->getSize() >= size)
             {
-                mDrawClockwiseMeshes.pBuffer = Buffer::create(mpDevice, sizeof(drawClockwiseMeshes[0]) * drawClockwiseMeshes.size(), Resource::BindFlags::IndirectArg, Buffer::CpuAccess::None, drawClockwiseMeshes.data());
-                mDrawClockwiseMeshes.pBuffer->setName("Scene::mDrawClockwiseMeshes::pBuffer");
-                mDrawClockwiseMeshes.count = (uint32_t)drawClockwiseMeshes.size();
+                drawArgs.pBuffer->setBlob(args.data(), 0, size);
+                return;
             }
-
-            size_t drawCount = drawClockwiseMeshes.size() + drawCounterClockwiseMeshes.size();
-            assert(drawCount <= std::numeric_limits<uint32_t>::max());
+            drawArgs.pBuffer = Buffer::create(mpDevice, size, Resource::BindFlags::IndirectArg, Buffer::CpuAccess::None, args.data());
+            drawArgs.pBuffer->setName(name);
         };
 
         if (hasIndexBuffer())
         {
-            std::vector<D3D12_DRAW_INDEXED_ARGUMENTS> drawClockwiseMeshes, drawCounterClockwiseMeshes;
-
-            for (const auto& instance : mMeshInstanceData)
+            std::vector<D3D12_DRAW_INDEXED_ARGUMENTS> args(batchList.size());
+            for (size_t i = 0; i < batchList.size(); i++)
             {
-                const auto& mesh = mMeshDesc[instance.meshID];
-                const auto& transform = matrices[instance.globalMatrixID];
-
-                D3D12_DRAW_INDEXED_ARGUMENTS draw;
-                draw.IndexCountPerInstance = mesh.indexCount;
-                draw.InstanceCount = 1;
-                draw.StartIndexLocation = mesh.ibOffset;
-                draw.BaseVertexLocation = mesh.vbOffset;
-                draw.StartInstanceLocation = (uint32_t)(drawClockwiseMeshes.size() + drawCounterClockwiseMeshes.size());
-
-                (doesTransformFlip(transform)) ? drawClockwiseMeshes.push_back(draw) : drawCounterClockwiseMeshes.push_back(draw);
+                const auto& mesh = mMeshDesc[batchList[i].meshID];
+                args[i].IndexCountPerInstance = mesh.indexCount;
+                args[i].InstanceCount = batchList[i].instanceCount;
+                args[i].StartIndexLocation = mesh.ibOffset;
+                args[i].BaseVertexLocation = mesh.vbOffset;
+                args[i].StartInstanceLocation = startInstanceOffset + batchList[i].startInstance;
             }
-            createBuffers(drawClockwiseMeshes, drawCounterClockwiseMeshes);
+            upload(args);
         }
         else
         {
-            std::vector<D3D12_DRAW_ARGUMENTS> drawClockwiseMeshes, drawCounterClockwiseMeshes;
-
-            for (const auto& instance : mMeshInstanceData)
+            std::vector<D3D12_DRAW_ARGUMENTS> args(batchList.size());
+            for (size_t i = 0; i < batchList.size(); i++)
             {
-                const auto& mesh = mMeshDesc[instance.meshID];
-                const auto& transform = matrices[instance.globalMatrixID];
+                const auto& mesh = mMeshDesc[batchList[i].meshID];
                 assert(mesh.indexCount == 0);
-
-                D3D12_DRAW_ARGUMENTS draw;
-                draw.VertexCountPerInstance = mesh.vertexCount;
-                draw.InstanceCount = 1;
-                draw.StartVertexLocation = mesh.vbOffset;
-                draw.StartInstanceLocation = (uint32_t)(drawClockwiseMeshes.size() + drawCounterClockwiseMeshes.size());
-
-                (doesTransformFlip(transform)) ? drawClockwiseMeshes.push_back(draw) : drawCounterClockwiseMeshes.push_back(draw);
+                args[i].VertexCountPerInstance = mesh.vertexCount;
+                args[i].InstanceCount = batchList[i].instanceCount;
+                args[i].StartVertexLocation = mesh.vbOffset;
+                args[i].StartInstanceLocation = startInstanceOffset + batchList[i].startInstance;
             }
-            createBuffers(drawClockwiseMeshes, drawCounterClockwiseMeshes);
+            upload(args);
         }
     }
 
@@ -1633,7 +1820,7 @@ typedef struct D3D12_DRAW_ARGUMENTS {
         assert(tlasIt->second.pSrv);
 
         // Bind Scene parameter block.
-        getCamera()->setShaderData(mpSceneBlock[kCamera]);
+        getCamera()->setShaderData(mpSceneBlock[mHandles.camera]);
         var["gScene"] = mpSceneBlock;
 
         // Bind TLAS.
@@ -1645,7 +1832,7 @@ typedef struct D3D12_DRAW_ARGUMENTS {
     {
         if (mpEnvMap == pEnvMap) return;
         mpEnvMap = pEnvMap;
-        if (mpEnvMap) mpEnvMap->setShaderData(mpSceneBlock[kEnvMap]);
+        if (mpEnvMap) mpEnvMap->setShaderData(mpSceneBlock[mHandles.envMap]);
     }
 
     void Scene::loadEnvMap(const std::string& filename)
@@ -43,12 +43,15 @@
 #include "Falcor/Scene/Camera/CameraController.h"
 #include "Falcor/Experimental/Scene/Lights/LightCollection.h"
 #include "Falcor/Experimental/Scene/Lights/EnvMap.h"
+#include "Falcor/Scene/InstanceCuller.h"
+#include "Falcor/Scene/MeshInstanceUpdater.h"
 #include "SceneTypes.slang"
 
 namespace Falcor {
 
 class Device;
 class RtProgramVars;
+struct DrawBatch;
 
 /** DXR Scene and Resources Layout:
     - BLAS creation logic is similar to Falcor 3.0, and are grouped in the following order:
@@ -116,6 +119,7 @@ class dlldecl Scene : public std::enable_shared_from_this<Scene> {
         UserRasterizerState     = 0x1,  ///< Use the rasterizer state currently bound to `pState`. If this flag is not set, the default rasterizer state will be used.
                                         ///< Note that we need to change the rasterizer state during rendering because some meshes have a negative scale factor, and hence the triangles will have a different winding order.
                                         ///< If such meshes exist, overriding the state may result in incorrect rendering output
+        FrustumCulling          = 0x2,  ///< Only draw the mesh instances inside the camera frustum if frustum culling is enabled on the scene. Use it for passes that render from the scene camera.
     };
 
     /** Flags indicating if and what was updated in the scene
@@ -135,6 +139,7 @@ class dlldecl Scene : public std::enable_shared_from_this<Scene> {
         EnvMapChanged               = 0x400, ///< Environment map changed (check EnvMap::getChanges() for more specific information)
         LightCountChanged           = 0x800, ///< Number of active lights changed
         RenderSettingsChanged       = 0x1000,///< Render settings changed
+        GeometryChanged             = 0x2000,///< Mesh vertices were replaced with updateMeshVertices()
 
         All                         = -1
     };
@@ -296,6 +301,29 @@ class dlldecl Scene : public std::enable_shared_from_this<Scene> {
     */
     const BoundingBox& getMeshBounds(uint32_t meshID) const { return mMeshBBs[meshID]; }
 
+    /** Replace the vertices of a mesh in place, e.g. points edited in a host application. The index buffer is kept, so the
+        vertices must be in the order the SceneBuilder stored them. Skinned meshes can't be updated.
+        The next update() refits the bounds of the mesh's instances and reports GeometryChanged and MeshesMoved.
+    */
+    void updateMeshVertices(uint32_t meshID, const std::vector<StaticVertexData>& vertices);
+
+    /** Replace the local transform of a scene graph node. The next update() reports the instances below it as moved.
+    */
+    void setNodeTransform(uint32_t nodeID, const glm::mat4& transform);
+
+    /** Enable or disable CPU frustum culling of mesh instances against the selected camera.
+        Only affects render() calls with RenderFlags::FrustumCulling set.
+    */
+    void setFrustumCulling(bool enabled);
+
+    /** Check if frustum culling is enabled
+    */
+    bool isFrustumCullingEnabled() const { return mFrustumCulling; }
+
+    /** Get the number of mesh instances that passed frustum culling in the last update(). Returns the total instance count if culling is disabled.
+    */
+    uint32_t getVisibleInstanceCount() const { return mFrustumCulling ? (uint32_t)mVisibleInstances.size() : getMeshInstanceCount(); }
+
     /** Get the number of lights in the scene
     */
     uint32_t getLightCount() const { return (uint32_t)mLights.size(); }
@@ -364,6 +392,11 @@ class dlldecl Scene : public std::enable_shared_from_this<Scene> {
     */
     void render(RenderContext* pContext, GraphicsState* pState, GraphicsVars* pVars, RenderFlags flags = RenderFlags::None);
 
+    /** Start creating the graphics state objects render() will need for this state and vars on worker threads.
+        Call once the state's program and FBO are set up, e.g. while the rest of the scene loads.
+    */
+    void precreatePipelines(GraphicsState* pState, GraphicsVars* pVars, RenderFlags flags = RenderFlags::None);
+
     /** Render the scene using raytracing
     */
     #ifdef FALCOR_D3D12
@@ -457,6 +490,14 @@ private:
     */
     void initResources();
 
+    /** Resolve the handles of the scene block members that are bound every frame.
+    */
+    void resolveShaderVarHandles();
+
+    /** Bind the scene block to the "gScene" member of a program's vars.
+    */
+    void bindSceneBlock(ProgramVars* pVars);
+
     /** Uploads scene data to parameter block
     */
     void uploadResources();
@@ -469,11 +510,17 @@ private:
     */
     void uploadSelectedCamera();
 
-    /** Update the scene's global bounding box.
+    /** Update the world-space bounds of the mesh instances and the scene's global bounding box.
+        \param[in] forceUpdate Update all instances instead of the ones in mChangedInstances.
+    */
+    void updateBounds(bool forceUpdate);
+
+    /** Cull the mesh instances against the selected camera and update the culled draw arguments.
     */
-    void updateBounds();
+    void updateFrustumCulling();
 
-    /** Update mesh instances.
+    /** Update mesh instance flags and upload the changed parts of the instance buffer.
+        \param[in] forceUpdate Update and upload all instances instead of the ones in mChangedInstances.
     */
     void updateMeshInstances(bool forceUpdate);
 
@@ -485,6 +532,16 @@ private:
     */
     void createDrawList();
 
+    /** Rebuild the unculled draw batches from mInstanceMeshIDs and mInstanceFlipped, e.g. after the winding of instances changed.
+        Also marks the culled draws dirty.
+    */
+    void updateDrawBatches();
+
+    /** Write the indirect draw arguments for a list of batches. The buffer is reused if it is large enough.
+        \param[in] startInstanceOffset Offset added to each batch's start instance, i.e. the batches' first entry in the draw ID buffer.
+    */
+    void uploadDrawArgs(const std::vector<DrawBatch>& batchList, uint32_t startInstanceOffset, DrawArgs& drawArgs, const std::string& name);
+
     /** Sort meshes into groups by transform. Updates mMeshInstances and mMeshGroups.
     */
     void sortMeshes();
@@ -572,6 +629,15 @@ private:
         uint32_t count = 0;
     } mDrawClockwiseMeshes, mDrawCounterClockwiseMeshes;
 
+    // Frustum culling
+    bool mFrustumCulling = false;
+    bool mFrustumCullingDirty = true;
+    std::unique_ptr<InstanceCuller> mpInstanceCuller;
+    std::vector<uint32_t> mVisibleInstances;
+    std::vector<uint32_t> mInstanceMeshIDs;                     ///< Mesh ID per mesh instance, input to the draw batching.
+    std::vector<uint8_t> mInstanceFlipped;                      ///< Non-zero per mesh instance with a flipped winding.
+    DrawArgs mCulledDrawClockwiseMeshes, mCulledDrawCounterClockwiseMeshes;  ///< Same capacity as the full draw arguments, count is the current number of draws.
+
     static const uint32_t kInvalidNode = -1;
 
     struct Node {
@@ -602,6 +668,10 @@ private:
 
     // Scene Metadata (CPU Only)
     std::vector<BoundingBox> mMeshBBs;                          ///< Bounding boxes for meshes (not instances)
+    std::vector<BoundingBox> mInstanceBBs;                      ///< World-space bounding boxes for mesh instances
+    MeshInstanceUpdater mInstanceUpdater;                       ///< Change-tracked updates of instance bounds and flags
+    std::vector<uint32_t> mChangedInstances;                    ///< Mesh instances whose matrix changed in the last update()
+    std::vector<uint32_t> mUpdatedMeshes;                       ///< Meshes whose vertices were replaced since the last update()
     std::vector<std::vector<uint32_t>> mMeshIdToInstanceIds;    ///< Mapping of what instances belong to which mesh
     BoundingBox mSceneBB;                                       ///< Bounding boxes of the entire scene
     std::vector<bool> mMeshHasDynamicData;                      ///< Whether a Mesh has dynamic data, meaning it is skinned
@@ -616,6 +686,26 @@ private:
     Buffer::SharedPtr mpLightsBuffer;
     ParameterBlock::SharedPtr mpSceneBlock;
 
+    // Scene block members, resolved once in initResources() instead of looked up by name on every update
+    struct SceneBlockHandles {
+        ShaderVarHandle camera;
+        ShaderVarHandle lightCount;
+        ShaderVarHandle lightProbe;
+        ShaderVarHandle lightCollection;
+        ShaderVarHandle envMap;
+        ShaderVarHandle materialResources;
+
+        // Members of a materialResources element
+        ShaderVarHandle baseColor;
+        ShaderVarHandle specular;
+        ShaderVarHandle roughness;
+        ShaderVarHandle emissive;
+        ShaderVarHandle normalMap;
+        ShaderVarHandle occlusionMap;
+        ShaderVarHandle samplerState;
+    } mHandles;
+    ShaderVarHandle mVarsSceneBlockHandle;                      ///< "gScene" in the vars last passed to render(), re-resolved when they change
+
     // Camera
     CameraControllerType mCamCtrlType = CameraControllerType::FirstPerson;
     CameraController::SharedPtr mpCamCtrl;
@@ -26,6 +26,7 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include <mutex>
+#include <tuple>
 
 #ifdef _WIN32
 #include <filesystem>
@@ -37,6 +38,7 @@ namespace fs = boost::filesystem;
 
 #include "stdafx.h"
 #include "SceneBuilder.h"
+#include "SceneCache.h"
 #include "../Externals/mikktspace/mikktspace.h"
 
 
@@ -153,11 +155,55 @@ SceneBuilder::SharedPtr SceneBuilder::create(std::shared_ptr<Device> pDevice, co
 }
 
 bool SceneBuilder::import(const std::string& filename, const InstanceMatrices& instances, const Dictionary& dict) {
+    // Imports made by an importer, e.g. the models of a .pyscene or .fscene file, are counted as nested
+    if (mImportDepth > 0) mNestedImportCount++;
+
+    // The cache can only stand in for an import into an empty builder. Importer options are not part of the key.
+    SceneCache::Key cacheKey = 0;
+    std::string cacheFilename;
+    if (is_set(mFlags, Flags::UseCache) && dict.size() == 0 && isEmpty()) {
+        Flags keyFlags = mFlags & ~(Flags::UseCache | Flags::RebuildCache);
+        cacheKey = SceneCache::computeKey(filename, (uint32_t)keyFlags, instances);
+        if (cacheKey) cacheFilename = SceneCache::getCacheFilename(cacheKey);
+    }
+
+    if (cacheKey && !is_set(mFlags, Flags::RebuildCache) && SceneCache::hasValidCache(cacheFilename, cacheKey)) {
+        TimeReport timeReport;
+        SceneCacheData data;
+        if (SceneCache::readCache(cacheFilename, cacheKey, data) && importCacheData(data)) {
+            mFilename = filename;
+            timeReport.addTotal("SceneBuilder::import '" + filename + "' loaded from cache in");
+            timeReport.printToLog();
+            return true;
+        }
+        logWarning("Failed to load scene cache '" + cacheFilename + "', importing '" + filename + "' instead.");
+    }
+
+    const uint32_t nestedImportCount = mNestedImportCount;
+    mImportDepth++;
     bool success = Importer::import(filename, *this, instances, dict);
+    mImportDepth--;
     mFilename = filename;
+
+    if (success && cacheKey) {
+        SceneCacheData data;
+        if (mNestedImportCount != nestedImportCount) {
+            // Scripts change the scene after it was built and the files they import are not tracked as dependencies.
+            // The imported files are cached on their own.
+            logInfo("Scene '" + filename + "' imports other scene files, not caching it.");
+        } else if (!exportCacheData(data)) {
+            logInfo("Scene '" + filename + "' uses features the scene cache doesn't support, not caching it.");
+        } else if (SceneCache::writeCache(cacheFilename, cacheKey, data)) {
+            logInfo("Wrote scene cache '" + cacheFilename + "' for '" + filename + "'.");
+        }
+    }
     return success;
 }
 
+void SceneBuilder::addDependency(const std::string& filename) {
+    if (std::find(mDependencies.begin(), mDependencies.end(), filename) == mDependencies.end()) mDependencies.push_back(filename);
+}
+
 uint32_t SceneBuilder::addNode(const Node& node) {
     assert(node.parent == kInvalidNode || node.parent < mSceneGraph.size());
 
@@ -521,7 +567,7 @@ void SceneBuilder::setCamera(const std::string name)
     }
 }
 
-Vao::SharedPtr SceneBuilder::createVao(uint16_t drawCount)
+Vao::SharedPtr SceneBuilder::createVao(uint32_t drawCount)
 {
     for (auto& mesh : mMeshes) assert(mesh.topology == mMeshes[0].topology);
     const size_t vertexCount = (uint32_t)mBuffersData.staticData.size();
@@ -546,9 +592,11 @@ Vao::SharedPtr SceneBuilder::createVao(uint16_t drawCount)
     Vao::BufferVec pVBs(Scene::kVertexBufferCount);
     pVBs[Scene::kStaticDataBufferIndex] = pStaticBuffer;
     pVBs[Scene::kPrevVertexBufferIndex] = pPrevBuffer;
-    std::vector<uint16_t> drawIDs(drawCount);
-    for (uint32_t i = 0; i < drawCount; i++) drawIDs[i] = i;
-    pVBs[Scene::kDrawIdBufferIndex] = Buffer::create(mpDevice, drawCount * sizeof(uint16_t), ResourceBindFlags::Vertex, Buffer::CpuAccess::None, drawIDs.data());
+    // Scene::createDrawList() fills the first half with the mesh instance ID of every instance of every draw.
+    // The second half holds the visible instances when frustum culling is enabled.
+    std::vector<uint32_t> drawIDs(2 * (size_t)drawCount);
+    for (uint32_t i = 0; i < drawCount; i++) drawIDs[i] = drawIDs[drawCount + i] = i;
+    pVBs[Scene::kDrawIdBufferIndex] = Buffer::create(mpDevice, drawIDs.size() * sizeof(uint32_t), ResourceBindFlags::Vertex, Buffer::CpuAccess::None, drawIDs.data());
 
     // The layout only initializes the vertex data and draw ID layout. The skinning data doesn't get passed into the vertex shader.
     VertexLayout::SharedPtr pLayout = VertexLayout::create();
@@ -567,7 +615,7 @@ Vao::SharedPtr SceneBuilder::createVao(uint16_t drawCount)
 
     // Add the draw ID layout
     VertexBufferLayout::SharedPtr pInstLayout = VertexBufferLayout::create();
-    pInstLayout->addElement(INSTANCE_DRAW_ID_NAME, 0, ResourceFormat::R16Uint, 1, INSTANCE_DRAW_ID_LOC);
+    pInstLayout->addElement(INSTANCE_DRAW_ID_NAME, 0, ResourceFormat::R32Uint, 1, INSTANCE_DRAW_ID_LOC);
     pInstLayout->setInputClass(VertexBufferLayout::InputClass::PerInstanceData, 1);
     pLayout->addBufferLayout(Scene::kDrawIdBufferIndex, pInstLayout);
 
@@ -673,7 +721,6 @@ Scene::SharedPtr SceneBuilder::getScene()
     uint32_t drawCount = createMeshData(mpScene.get());
     timeReport.measure("getScene createMeshData");
 
-    assert(drawCount <= std::numeric_limits<uint16_t>::max());
     mpScene->mpVao = createVao(drawCount);
     timeReport.measure("getScene createVao");
 
@@ -714,6 +761,301 @@ void SceneBuilder::calculateMeshBoundingBoxes(Scene* pScene)
     }
 }
 
+bool SceneBuilder::isEmpty() const
+{
+    return mMeshes.empty() && mSceneGraph.empty() && mMaterials.empty() && mCameras.empty() && mLights.empty() &&
+        mAnimations.empty() && !mpLightProbe && !mpEnvMap;
+}
+
+bool SceneBuilder::exportCacheData(SceneCacheData& data) const
+{
+    if (!mAnimations.empty() || mpLightProbe) return false;
+
+    // The cache is only valid as long as none of the files the scene was built from changed.
+    data.dependencies = mDependencies;
+    auto addDependency = [&data](const std::string& filename)
+    {
+        if (!filename.empty() && std::find(data.dependencies.begin(), data.dependencies.end(), filename) == data.dependencies.end()) data.dependencies.push_back(filename);
+    };
+
+    data.indices = mBuffersData.indices;
+    data.staticData = mBuffersData.staticData;
+    data.dynamicData = mBuffersData.dynamicData;
+
+    data.meshes.resize(mMeshes.size());
+    for (size_t i = 0; i < mMeshes.size(); i++)
+    {
+        const auto& mesh = mMeshes[i];
+        auto& desc = data.meshes[i];
+        desc.topology = (uint32_t)mesh.topology;
+        desc.materialId = mesh.materialId;
+        desc.indexOffset = mesh.indexOffset;
+        desc.staticVertexOffset = mesh.staticVertexOffset;
+        desc.dynamicVertexOffset = mesh.dynamicVertexOffset;
+        desc.indexCount = mesh.indexCount;
+        desc.vertexCount = mesh.vertexCount;
+        desc.hasDynamicData = mesh.hasDynamicData ? 1 : 0;
+        desc.instances.resize(mesh.instances.size());
+        for (size_t j = 0; j < mesh.instances.size(); j++)
+        {
+            desc.instances[j].nodeId = mesh.instances[j].nodeId;
+            desc.instances[j].materialId = mesh.instances[j].materialId;
+            desc.instances[j].overrideMaterial = mesh.instances[j].overrideMaterial ? 1 : 0;
+        }
+    }
+
+    data.sceneGraph.resize(mSceneGraph.size());
+    for (size_t i = 0; i < mSceneGraph.size(); i++)
+    {
+        const auto& node = mSceneGraph[i];
+        auto& desc = data.sceneGraph[i];
+        desc.name = node.name;
+        desc.transform = node.transform;
+        desc.localToBindPose = node.localToBindPose;
+        desc.parent = node.parent;
+        desc.children = node.children;
+        desc.meshes = node.meshes;
+    }
+
+    data.materials.resize(mMaterials.size());
+    for (size_t i = 0; i < mMaterials.size(); i++)
+    {
+        const auto& pMaterial = mMaterials[i];
+        auto& desc = data.materials[i];
+        desc.name = pMaterial->getName();
+        desc.data = pMaterial->mData;
+        desc.occlusionMapEnabled = pMaterial->mOcclusionMapEnabled;
+
+        for (uint32_t slot = 0; slot < (uint32_t)Material::TextureSlot::Count; slot++)
+        {
+            auto pTexture = pMaterial->getTexture((Material::TextureSlot)slot);
+            if (!pTexture) continue;
+
+            // Textures that weren't loaded from a file can't be referenced.
+            auto& ref = desc.textures[slot];
+            ref.filename = pTexture->getSourceFilename();
+            if (ref.filename.empty()) return false;
+
+            ref.sparse = pTexture->isSparse();
+            ref.srgb = isSrgbFormat(pTexture->getFormat());
+
+            // Sparse textures reference the converted file, the resource manager wants the original one.
+            if (ref.sparse && hasSuffix(ref.filename, ".ltx")) ref.filename.resize(ref.filename.size() - 4);
+            addDependency(ref.filename);
+        }
+    }
+
+    data.cameras.resize(mCameras.size());
+    for (size_t i = 0; i < mCameras.size(); i++)
+    {
+        data.cameras[i].name = mCameras[i]->getName();
+        data.cameras[i].data = mCameras[i]->getData();
+        data.cameras[i].preserveHeight = mCameras[i]->mPreserveHeight;
+    }
+
+    data.lights.resize(mLights.size());
+    for (size_t i = 0; i < mLights.size(); i++)
+    {
+        const auto& pLight = mLights[i];
+        auto& desc = data.lights[i];
+        desc.name = pLight->getName();
+        desc.data = pLight->getData();
+        desc.active = pLight->isActive();
+
+        switch (pLight->getType())
+        {
+        case LightType::Point:
+        case LightType::Directional:
+            break;
+        case LightType::Rect:
+        case LightType::Sphere:
+        case LightType::Disc:
+        {
+            auto pAreaLight = std::dynamic_pointer_cast<AnalyticAreaLight>(pLight);
+            if (!pAreaLight) return false;
+            desc.scaling = pAreaLight->getScaling();
+            desc.transform = pAreaLight->getTransformMatrix();
+            break;
+        }
+        case LightType::Distant:
+        {
+            auto pDistantLight = std::dynamic_pointer_cast<DistantLight>(pLight);
+            if (!pDistantLight) return false;
+            desc.angle = pDistantLight->getAngle();
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+
+    data.selectedCamera = mSelectedCamera;
+    data.cameraSpeed = mCameraSpeed;
+    data.envMapFilename = mpEnvMap ? mpEnvMap->getFilename() : "";
+    addDependency(data.envMapFilename);
+    return true;
+}
+
+bool SceneBuilder::importCacheData(const SceneCacheData& data)
+{
+    assert(isEmpty());
+
+    // Validate all references before anything is created.
+    const size_t nodeCount = data.sceneGraph.size();
+    const size_t materialCount = data.materials.size();
+    bool valid = true;
+    for (const auto& mesh : data.meshes)
+    {
+        valid = valid && mesh.materialId < materialCount;
+        valid = valid && (uint64_t)mesh.indexOffset + mesh.indexCount <= data.indices.size();
+        valid = valid && (uint64_t)mesh.staticVertexOffset + mesh.vertexCount <= data.staticData.size();
+        valid = valid && (!mesh.hasDynamicData || (uint64_t)mesh.dynamicVertexOffset + mesh.vertexCount <= data.dynamicData.size());
+        for (const auto& instance : mesh.instances)
+        {
+            valid = valid && instance.nodeId < nodeCount && (!instance.overrideMaterial || instance.materialId < materialCount);
+        }
+    }
+    for (const auto& node : data.sceneGraph)
+    {
+        valid = valid && (node.parent == kInvalidNode || node.parent < nodeCount);
+        for (uint32_t child : node.children) valid = valid && child < nodeCount;
+        for (uint32_t meshID : node.meshes) valid = valid && meshID < data.meshes.size();
+    }
+    if (!valid)
+    {
+        logWarning("Scene cache data has out of range references.");
+        return false;
+    }
+
+    std::vector<Light::SharedPtr> lights;
+    for (const auto& desc : data.lights)
+    {
+        Light::SharedPtr pLight;
+        switch ((LightType)desc.data.type)
+        {
+        case LightType::Point:
+            pLight = PointLight::create();
+            break;
+        case LightType::Directional:
+            pLight = DirectionalLight::create();
+            break;
+        case LightType::Rect:
+        case LightType::Sphere:
+        case LightType::Disc:
+        {
+            auto pAreaLight = AnalyticAreaLight::create((LightType)desc.data.type);
+            pAreaLight->setScaling(desc.scaling);
+            pAreaLight->setTransformMatrix(desc.transform);
+            pLight = pAreaLight;
+            break;
+        }
+        case LightType::Distant:
+        {
+            auto pDistantLight = DistantLight::create();
+            pDistantLight->setAngle(desc.angle);
+            pLight = pDistantLight;
+            break;
+        }
+        default:
+            logWarning("Scene cache data has an unsupported light type.");
+            return false;
+        }
+
+        pLight->setName(desc.name);
+        pLight->mData = desc.data;
+        pLight->mPrevData = desc.data;
+        pLight->mActive = desc.active;
+        lights.push_back(pLight);
+    }
+
+    // Materials referencing the same file share the texture.
+    std::map<std::tuple<std::string, bool, bool>, Texture::SharedPtr> textures;
+    std::vector<Material::SharedPtr> materials;
+    materials.reserve(materialCount);
+    for (const auto& desc : data.materials)
+    {
+        auto pMaterial = Material::create(mpDevice, desc.name);
+        for (uint32_t slot = 0; slot < (uint32_t)Material::TextureSlot::Count; slot++)
+        {
+            const auto& ref = desc.textures[slot];
+            if (ref.filename.empty()) continue;
+
+            auto& pTexture = textures[std::make_tuple(ref.filename, ref.srgb, ref.sparse)];
+            if (!pTexture)
+            {
+                auto pResourceManager = mpDevice->resourceManager();
+                pTexture = ref.sparse ? pResourceManager->createSparseTextureFromFile(ref.filename, true, ref.srgb) : pResourceManager->createTextureFromFile(ref.filename, true, ref.srgb);
+                if (!pTexture) logWarning("Can't load texture '" + ref.filename + "' referenced by the scene cache.");
+            }
+            if (pTexture) pMaterial->setTexture((Material::TextureSlot)slot, pTexture);
+        }
+
+        // Restore the parameters last, setTexture() derives flags that the cached data already has.
+        pMaterial->mData = desc.data;
+        pMaterial->mOcclusionMapEnabled = desc.occlusionMapEnabled;
+        materials.push_back(pMaterial);
+    }
+    if (!textures.empty()) mpDevice->flushAndSync();
+
+    mCameras.reserve(data.cameras.size());
+    for (const auto& desc : data.cameras)
+    {
+        auto pCamera = Camera::create();
+        pCamera->setName(desc.name);
+        pCamera->mData = desc.data;
+        pCamera->mPreserveHeight = desc.preserveHeight;
+        pCamera->mDirty = true;
+        mCameras.push_back(pCamera);
+    }
+
+    mBuffersData.indices = data.indices;
+    mBuffersData.staticData = data.staticData;
+    mBuffersData.dynamicData = data.dynamicData;
+
+    mMeshes.resize(data.meshes.size());
+    for (size_t i = 0; i < data.meshes.size(); i++)
+    {
+        const auto& desc = data.meshes[i];
+        auto& mesh = mMeshes[i];
+        mesh.topology = (Vao::Topology)desc.topology;
+        mesh.materialId = desc.materialId;
+        mesh.indexOffset = desc.indexOffset;
+        mesh.staticVertexOffset = desc.staticVertexOffset;
+        mesh.dynamicVertexOffset = desc.dynamicVertexOffset;
+        mesh.indexCount = desc.indexCount;
+        mesh.vertexCount = desc.vertexCount;
+        mesh.hasDynamicData = desc.hasDynamicData != 0;
+        mesh.instances.resize(desc.instances.size());
+        for (size_t j = 0; j < desc.instances.size(); j++)
+        {
+            mesh.instances[j].nodeId = desc.instances[j].nodeId;
+            mesh.instances[j].materialId = desc.instances[j].materialId;
+            mesh.instances[j].overrideMaterial = desc.instances[j].overrideMaterial != 0;
+        }
+    }
+
+    mSceneGraph.resize(nodeCount);
+    for (size_t i = 0; i < nodeCount; i++)
+    {
+        const auto& desc = data.sceneGraph[i];
+        auto& node = mSceneGraph[i];
+        node.name = desc.name;
+        node.transform = desc.transform;
+        node.localToBindPose = desc.localToBindPose;
+        node.parent = desc.parent;
+        node.children = desc.children;
+        node.meshes = desc.meshes;
+    }
+
+    mMaterials = std::move(materials);
+    mLights = std::move(lights);
+    mSelectedCamera = data.selectedCamera;
+    mCameraSpeed = data.cameraSpeed;
+    if (!data.envMapFilename.empty()) mpEnvMap = EnvMap::create(mpDevice, data.envMapFilename);
+    mDirty = true;
+    return true;
+}
+
 void SceneBuilder::addAnimation(const Animation::SharedPtr& pAnimation)
 {
     mAnimations.push_back(pAnimation);
@@ -741,6 +1083,8 @@ SCRIPT_BINDING(SceneBuilder)
     flags.value("UseSpecGlossMaterials", SceneBuilder::Flags::UseSpecGlossMaterials);
     flags.value("UseMetalRoughMaterials", SceneBuilder::Flags::UseMetalRoughMaterials);
     flags.value("NonIndexedVertices", SceneBuilder::Flags::NonIndexedVertices);
+    flags.value("UseCache", SceneBuilder::Flags::UseCache);
+    flags.value("RebuildCache", SceneBuilder::Flags::RebuildCache);
     ScriptBindings::addEnumBinaryOperators(flags);
 }
 
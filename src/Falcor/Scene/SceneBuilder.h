@@ -37,6 +37,7 @@
 namespace Falcor {
 
 class Device;
+struct SceneCacheData;
 
 class dlldecl SceneBuilder {
  public:
@@ -54,6 +55,8 @@ class dlldecl SceneBuilder {
         UseSpecGlossMaterials       = 0x20,   ///< Set materials to use Spec-Gloss shading model. Otherwise default is Spec-Gloss for OBJ, Metal-Rough for everything else.
         UseMetalRoughMaterials      = 0x40,   ///< Set materials to use Metal-Rough shading model. Otherwise default is Spec-Gloss for OBJ, Metal-Rough for everything else.
         NonIndexedVertices          = 0x80,   ///< Convert meshes to use non-indexed vertices. This requires more memory but may increase performance.
+        UseCache                    = 0x100,  ///< Load imported files from the scene cache if possible, and write the cache after importing. See SceneCache.
+        RebuildCache                = 0x200,  ///< Ignore existing cache files and write new ones. Only used together with UseCache.
 
         Default = None
     };
@@ -170,12 +173,20 @@ class dlldecl SceneBuilder {
     static SharedPtr create(std::shared_ptr<Device> pDevice, const std::string& filename, Flags buildFlags = Flags::Default, const InstanceMatrices& instances = InstanceMatrices());
 
     /** Import a scene/model file
+        With Flags::UseCache, files that import other files through the builder (.pyscene, .fscene) are never cached,
+        only the files they import are.
         \param filename The filename to load
         \param instances A list of instance matrices to load. This is optional, by default a single instance will be load
         \return true if the import succeeded, otherwise false
     */
     bool import(const std::string& filename, const InstanceMatrices& instances = InstanceMatrices(), const Dictionary& dict = Dictionary());
 
+    /** Record a file the imported scene was built from (e.g. an .mtl or .bin file). Importers call this for every file
+        they read besides the scene file, a cached scene is reimported when any of them changes. Textures and the
+        environment map are recorded automatically.
+    */
+    void addDependency(const std::string& filename);
+
     /** Get the scene. Make sure to add all the objects before calling this function
         \return nullptr if something went wrong, otherwise a new Scene object
     */
@@ -323,13 +334,29 @@ protected:
     float mCameraSpeed = 1.0f;
 
     uint32_t addMaterial(const Material::SharedPtr& pMaterial, bool removeDuplicate);
-    Vao::SharedPtr createVao(uint16_t drawCount);
+    Vao::SharedPtr createVao(uint32_t drawCount);
 
     uint32_t createMeshData(Scene* pScene);
     void createGlobalMatricesBuffer(Scene* pScene);
     void calculateMeshBoundingBoxes(Scene* pScene);
     void createAnimationController(Scene* pScene);
+
+    bool isEmpty() const;
+
+    /** Copy the builder state into cacheable form.
+        \return False if the state contains something the cache can't represent (animations, light probes).
+    */
+    bool exportCacheData(SceneCacheData& data) const;
+
+    /** Restore the builder state from the cache. Must be called on an empty builder.
+        \return False if the data is inconsistent. The builder is left unchanged in that case.
+    */
+    bool importCacheData(const SceneCacheData& data);
+
     std::string mFilename;
+    std::vector<std::string> mDependencies;     ///< Files read by the importers, see addDependency().
+    uint32_t mImportDepth = 0;                  ///< Number of import() calls in progress.
+    uint32_t mNestedImportCount = 0;            ///< Number of import() calls made from within another import().
 };
 
 enum_class_operators(SceneBuilder::Flags);
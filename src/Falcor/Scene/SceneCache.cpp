@@ -0,0 +1,519 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "SceneCache.h"
+
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include "boost/filesystem.hpp"
+namespace fs = boost::filesystem;
+#endif
+
+#include "Falcor/Utils/BinaryFileStream.h"
+
+namespace Falcor {
+
+namespace {
+
+const char kMagic[8] = { 'F', 'S', 'C', 'A', 'C', 'H', 'E', '\0' };
+const char kCacheDirEnvVar[] = "FALCOR_SCENE_CACHE_DIR";
+
+// Upper bound for element counts read from a file, protects against huge allocations from corrupt files.
+const uint64_t kMaxElementCount = uint64_t(1) << 34;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t key;
+    uint64_t payloadSize;
+
+    // Layout of the structs that are stored verbatim. The file is rejected if any of them changed.
+    uint32_t staticVertexSize;
+    uint32_t dynamicVertexSize;
+    uint32_t materialDataSize;
+    uint32_t cameraDataSize;
+    uint32_t lightDataSize;
+    uint32_t _pad[3];
+};
+
+static_assert(sizeof(Header) % SceneCache::kAlignment == 0, "Header size must keep the payload aligned");
+
+Header createHeader(SceneCache::Key key) {
+    Header header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = SceneCache::kVersion;
+    header.headerSize = (uint32_t)sizeof(Header);
+    header.key = key;
+    header.staticVertexSize = (uint32_t)sizeof(PackedStaticVertexData);
+    header.dynamicVertexSize = (uint32_t)sizeof(DynamicVertexData);
+    header.materialDataSize = (uint32_t)sizeof(MaterialData);
+    header.cameraDataSize = (uint32_t)sizeof(CameraData);
+    header.lightDataSize = (uint32_t)sizeof(LightData);
+    return header;
+}
+
+bool isHeaderCompatible(const Header& header, SceneCache::Key key) {
+    Header expected = createHeader(key);
+    expected.payloadSize = header.payloadSize;
+    return std::memcmp(&header, &expected, sizeof(Header)) == 0;
+}
+
+/** FNV-1a, good enough to key cache files.
+*/
+class Hash {
+ public:
+    void add(const void* pData, size_t size) {
+        const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(pData);
+        for (size_t i = 0; i < size; i++) {
+            mValue ^= pBytes[i];
+            mValue *= 0x100000001b3ull;
+        }
+    }
+
+    template<typename T>
+    void add(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be hashed");
+        add(&value, sizeof(T));
+    }
+
+    void add(const std::string& str) {
+        add((uint64_t)str.size());
+        add(str.data(), str.size());
+    }
+
+    uint64_t get() const { return mValue; }
+
+ private:
+    uint64_t mValue = 0xcbf29ce484222325ull;
+};
+
+/** Serializes the cache payload. Without a stream it only counts bytes, which is used to size the header up front.
+*/
+class CacheWriter {
+ public:
+    CacheWriter(BinaryFileStream* pStream) : mpStream(pStream) {}
+
+    void writeBytes(const void* pData, size_t size) {
+        if (size == 0) return;
+        if (mpStream) mpStream->write(pData, size);
+        mOffset += size;
+    }
+
+    template<typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be written directly");
+        writeBytes(&value, sizeof(T));
+    }
+
+    void write(const std::string& str) {
+        write((uint64_t)str.size());
+        writeBytes(str.data(), str.size());
+    }
+
+    /** Write an array of plain data. The elements are aligned, so the array can be used in place when the file is mapped.
+    */
+    template<typename T>
+    void writeArray(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be written directly");
+        write((uint64_t)values.size());
+        align();
+        writeBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    void align() {
+        static const uint8_t kZeros[SceneCache::kAlignment] = {};
+        size_t padding = (SceneCache::kAlignment - mOffset % SceneCache::kAlignment) % SceneCache::kAlignment;
+        writeBytes(kZeros, padding);
+    }
+
+    uint64_t getOffset() const { return mOffset; }
+
+ private:
+    BinaryFileStream* mpStream;
+    uint64_t mOffset = 0;
+};
+
+class CacheReader {
+ public:
+    CacheReader(BinaryFileStream& stream, uint64_t size) : mStream(stream), mSize(size) {}
+
+    bool readBytes(void* pData, size_t size) {
+        if (mFailed || size > mSize - mOffset) {
+            mFailed = true;
+            return false;
+        }
+        if (size == 0) return true;
+        mStream.read(pData, size);
+        mOffset += size;
+        if (mStream.isFail()) mFailed = true;
+        return !mFailed;
+    }
+
+    template<typename T>
+    bool read(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be read directly");
+        return readBytes(&value, sizeof(T));
+    }
+
+    bool read(std::string& str) {
+        uint64_t size = 0;
+        if (!read(size) || !checkCount(size, 1)) return false;
+        str.resize((size_t)size);
+        return readBytes(&str[0], (size_t)size);
+    }
+
+    template<typename T>
+    bool readArray(std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be read directly");
+        uint64_t count = 0;
+        if (!read(count) || !align() || !checkCount(count, sizeof(T))) return false;
+        values.resize((size_t)count);
+        return readBytes(values.data(), (size_t)count * sizeof(T));
+    }
+
+    /** Read the element count of a container that is read element by element.
+    */
+    bool readCount(uint64_t& count, size_t minElementSize) {
+        return read(count) && checkCount(count, minElementSize);
+    }
+
+    bool align() {
+        uint8_t padding[SceneCache::kAlignment];
+        size_t paddingSize = (SceneCache::kAlignment - mOffset % SceneCache::kAlignment) % SceneCache::kAlignment;
+        return readBytes(padding, paddingSize);
+    }
+
+    bool isDone() const { return !mFailed && mOffset == mSize; }
+
+ private:
+    bool checkCount(uint64_t count, size_t elementSize) {
+        if (count > kMaxElementCount || count * elementSize > mSize - mOffset) mFailed = true;
+        return !mFailed;
+    }
+
+    BinaryFileStream& mStream;
+    uint64_t mSize;
+    uint64_t mOffset = 0;
+    bool mFailed = false;
+};
+
+/** Size and modification time of a file the scene was built from. Both are 0 if the file doesn't exist.
+*/
+struct FileStamp {
+    uint64_t size = 0;
+    int64_t modifiedTime = 0;
+};
+
+FileStamp getFileStamp(const std::string& filename);
+
+void writeData(CacheWriter& writer, const SceneCacheData& data) {
+    // Dependencies go first, a stale cache is rejected without reading the rest.
+    writer.write((uint64_t)data.dependencies.size());
+    for (const auto& filename : data.dependencies) {
+        FileStamp stamp = getFileStamp(filename);
+        writer.write(filename);
+        writer.write(stamp.size);
+        writer.write(stamp.modifiedTime);
+    }
+
+    // Large buffers come next so they are cheap to find when the file is mapped.
+    writer.writeArray(data.indices);
+    writer.writeArray(data.staticData);
+    writer.writeArray(data.dynamicData);
+
+    writer.write((uint64_t)data.meshes.size());
+    for (const auto& mesh : data.meshes) {
+        writer.write(mesh.topology);
+        writer.write(mesh.materialId);
+        writer.write(mesh.indexOffset);
+        writer.write(mesh.staticVertexOffset);
+        writer.write(mesh.dynamicVertexOffset);
+        writer.write(mesh.indexCount);
+        writer.write(mesh.vertexCount);
+        writer.write(mesh.hasDynamicData);
+        writer.writeArray(mesh.instances);
+    }
+
+    writer.write((uint64_t)data.sceneGraph.size());
+    for (const auto& node : data.sceneGraph) {
+        writer.write(node.name);
+        writer.write(node.transform);
+        writer.write(node.localToBindPose);
+        writer.write(node.parent);
+        writer.writeArray(node.children);
+        writer.writeArray(node.meshes);
+    }
+
+    writer.write((uint64_t)data.materials.size());
+    for (const auto& material : data.materials) {
+        writer.write(material.name);
+        writer.write(material.data);
+        writer.write((uint32_t)material.occlusionMapEnabled);
+        for (const auto& texture : material.textures) {
+            writer.write(texture.filename);
+            writer.write((uint32_t)texture.srgb);
+            writer.write((uint32_t)texture.sparse);
+        }
+    }
+
+    writer.write((uint64_t)data.cameras.size());
+    for (const auto& camera : data.cameras) {
+        writer.write(camera.name);
+        writer.write(camera.data);
+        writer.write((uint32_t)camera.preserveHeight);
+    }
+
+    writer.write((uint64_t)data.lights.size());
+    for (const auto& light : data.lights) {
+        writer.write(light.name);
+        writer.write(light.data);
+        writer.write((uint32_t)light.active);
+        writer.write(light.scaling);
+        writer.write(light.transform);
+        writer.write(light.angle);
+    }
+
+    writer.write(data.selectedCamera);
+    writer.write(data.cameraSpeed);
+    writer.write(data.envMapFilename);
+}
+
+bool readBool(CacheReader& reader, bool& value) {
+    uint32_t v = 0;
+    if (!reader.read(v)) return false;
+    value = v != 0;
+    return true;
+}
+
+/** Read the dependencies and compare them against the files on disk.
+    \param[out] upToDate False if any dependency changed since the cache was written.
+    \return False if the file is corrupt.
+*/
+bool readDependencies(CacheReader& reader, std::vector<std::string>& dependencies, bool& upToDate) {
+    uint64_t count = 0;
+    if (!reader.readCount(count, sizeof(uint64_t) * 3)) return false;
+    dependencies.resize((size_t)count);
+    upToDate = true;
+    for (auto& filename : dependencies) {
+        FileStamp cached;
+        if (!reader.read(filename) || !reader.read(cached.size) || !reader.read(cached.modifiedTime)) return false;
+        FileStamp current = getFileStamp(filename);
+        if (current.size != cached.size || current.modifiedTime != cached.modifiedTime) upToDate = false;
+    }
+    return true;
+}
+
+/** Read everything after the dependencies.
+*/
+bool readData(CacheReader& reader, SceneCacheData& data) {
+    if (!reader.readArray(data.indices)) return false;
+    if (!reader.readArray(data.staticData)) return false;
+    if (!reader.readArray(data.dynamicData)) return false;
+
+    uint64_t count = 0;
+    if (!reader.readCount(count, 8 * sizeof(uint32_t))) return false;
+    data.meshes.resize((size_t)count);
+    for (auto& mesh : data.meshes) {
+        bool ok = reader.read(mesh.topology) && reader.read(mesh.materialId) && reader.read(mesh.indexOffset) &&
+            reader.read(mesh.staticVertexOffset) && reader.read(mesh.dynamicVertexOffset) && reader.read(mesh.indexCount) &&
+            reader.read(mesh.vertexCount) && reader.read(mesh.hasDynamicData) && reader.readArray(mesh.instances);
+        if (!ok) return false;
+    }
+
+    if (!reader.readCount(count, sizeof(uint64_t))) return false;
+    data.sceneGraph.resize((size_t)count);
+    for (auto& node : data.sceneGraph) {
+        bool ok = reader.read(node.name) && reader.read(node.transform) && reader.read(node.localToBindPose) &&
+            reader.read(node.parent) && reader.readArray(node.children) && reader.readArray(node.meshes);
+        if (!ok) return false;
+    }
+
+    if (!reader.readCount(count, sizeof(MaterialData))) return false;
+    data.materials.resize((size_t)count);
+    for (auto& material : data.materials) {
+        if (!reader.read(material.name) || !reader.read(material.data) || !readBool(reader, material.occlusionMapEnabled)) return false;
+        for (auto& texture : material.textures) {
+            if (!reader.read(texture.filename) || !readBool(reader, texture.srgb) || !readBool(reader, texture.sparse)) return false;
+        }
+    }
+
+    if (!reader.readCount(count, sizeof(CameraData))) return false;
+    data.cameras.resize((size_t)count);
+    for (auto& camera : data.cameras) {
+        if (!reader.read(camera.name) || !reader.read(camera.data) || !readBool(reader, camera.preserveHeight)) return false;
+    }
+
+    if (!reader.readCount(count, sizeof(LightData))) return false;
+    data.lights.resize((size_t)count);
+    for (auto& light : data.lights) {
+        bool ok = reader.read(light.name) && reader.read(light.data) && readBool(reader, light.active) &&
+            reader.read(light.scaling) && reader.read(light.transform) && reader.read(light.angle);
+        if (!ok) return false;
+    }
+
+    return reader.read(data.selectedCamera) && reader.read(data.cameraSpeed) && reader.read(data.envMapFilename);
+}
+
+bool readHeader(BinaryFileStream& stream, uint64_t fileSize, Header& header) {
+    if (fileSize < sizeof(Header)) return false;
+    stream.read(&header, sizeof(Header));
+    return !stream.isFail();
+}
+
+uint64_t getFileSize(const std::string& filename) {
+    try {
+        return fs::exists(filename) ? (uint64_t)fs::file_size(filename) : 0;
+    } catch (...) {
+        return 0;
+    }
+}
+
+FileStamp getFileStamp(const std::string& filename) {
+    std::string fullpath = filename;
+    if (!fs::exists(fullpath) && !findFileInDataDirectories(filename, fullpath)) return {};
+    return { getFileSize(fullpath), (int64_t)getFileModifiedTime(fullpath) };
+}
+
+}  // namespace
+
+SceneCache::Key SceneCache::computeKey(const std::string& filename, uint32_t flags, const std::vector<glm::mat4>& instances) {
+    if (!fs::exists(filename)) return 0;
+
+    Hash hash;
+    hash.add((uint32_t)kVersion);
+    hash.add(fs::absolute(filename).string());
+    hash.add(getFileSize(filename));
+    hash.add((int64_t)getFileModifiedTime(filename));
+    hash.add(flags);
+    hash.add((uint64_t)instances.size());
+    hash.add(instances.data(), instances.size() * sizeof(glm::mat4));
+
+    // 0 is reserved for "no key".
+    return hash.get() == 0 ? 1 : hash.get();
+}
+
+std::string SceneCache::getCacheDirectory() {
+    std::string dir;
+    if (!getEnvironmentVariable(kCacheDirEnvVar, dir) || dir.empty()) {
+        dir = (fs::temp_directory_path() / "falcor_scene_cache").string();
+    }
+    return dir;
+}
+
+std::string SceneCache::getCacheFilename(Key key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.fscache", (unsigned long long)key);
+    return (fs::path(getCacheDirectory()) / name).string();
+}
+
+bool SceneCache::hasValidCache(const std::string& filename, Key key) {
+    uint64_t fileSize = getFileSize(filename);
+    if (fileSize == 0) return false;
+
+    BinaryFileStream stream(filename, BinaryFileStream::Mode::Read);
+    Header header;
+    if (!readHeader(stream, fileSize, header)) return false;
+    if (!isHeaderCompatible(header, key) || header.payloadSize != fileSize - sizeof(Header)) return false;
+
+    CacheReader reader(stream, header.payloadSize);
+    std::vector<std::string> dependencies;
+    bool upToDate = false;
+    return readDependencies(reader, dependencies, upToDate) && upToDate;
+}
+
+bool SceneCache::writeCache(const std::string& filename, Key key, const SceneCacheData& data) {
+    std::string dir = fs::path(filename).parent_path().string();
+    if (!dir.empty() && !isDirectoryExists(dir) && !createDirectory(dir)) {
+        logWarning("Can't create scene cache directory '" + dir + "'.");
+        return false;
+    }
+
+    // Write to a temporary file first, other processes may be reading the cache at the same time.
+    std::string tempFilename = filename + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        CacheWriter counter(nullptr);
+        writeData(counter, data);
+
+        Header header = createHeader(key);
+        header.payloadSize = counter.getOffset();
+
+        BinaryFileStream stream(tempFilename, BinaryFileStream::Mode::Write);
+        stream.write(&header, sizeof(Header));
+        CacheWriter writer(&stream);
+        writeData(writer, data);
+
+        bool failed = stream.isFail();
+        stream.close();
+        if (failed) {
+            logWarning("Failed to write scene cache '" + tempFilename + "'.");
+            std::remove(tempFilename.c_str());
+            return false;
+        }
+    }
+
+    std::remove(filename.c_str());
+    if (std::rename(tempFilename.c_str(), filename.c_str()) != 0) {
+        logWarning("Failed to move scene cache '" + tempFilename + "' to '" + filename + "'.");
+        std::remove(tempFilename.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SceneCache::readCache(const std::string& filename, Key key, SceneCacheData& data) {
+    uint64_t fileSize = getFileSize(filename);
+    BinaryFileStream stream(filename, BinaryFileStream::Mode::Read);
+
+    Header header;
+    if (!readHeader(stream, fileSize, header) || !isHeaderCompatible(header, key) || header.payloadSize != fileSize - sizeof(Header)) {
+        logWarning("Scene cache '" + filename + "' is missing or out of date.");
+        return false;
+    }
+
+    CacheReader reader(stream, header.payloadSize);
+    bool upToDate = false;
+    if (readDependencies(reader, data.dependencies, upToDate) && !upToDate) {
+        logWarning("Scene cache '" + filename + "' is out of date, a file the scene was built from changed.");
+        return false;
+    }
+    if (!upToDate || !readData(reader, data) || !reader.isDone()) {
+        logWarning("Scene cache '" + filename + "' is corrupt.");
+        return false;
+    }
+    return true;
+}
+
+}  // namespace Falcor
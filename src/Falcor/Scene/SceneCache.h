@@ -0,0 +1,173 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#ifndef SRC_FALCOR_SCENE_SCENECACHE_H_
+#define SRC_FALCOR_SCENE_SCENECACHE_H_
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "Scene.h"
+
+namespace Falcor {
+
+/** Processed scene builder state in a form that can be written to and read from disk.
+    Everything in here is plain data, GPU objects (materials, textures, lights, cameras) are stored as descriptions
+    and recreated by the SceneBuilder when the cache is loaded.
+*/
+struct SceneCacheData {
+    /** Reference to a texture file. The texture itself is not cached, it is loaded again from its source file.
+    */
+    struct TextureRef {
+        std::string filename;       ///< Source file. Empty if the slot is unused.
+        bool srgb = false;          ///< Texture was loaded as sRGB.
+        bool sparse = false;        ///< Texture was created as sparse texture.
+    };
+
+    struct MaterialDesc {
+        std::string name;
+        MaterialData data;
+        bool occlusionMapEnabled = false;
+        std::array<TextureRef, (size_t)Material::TextureSlot::Count> textures;
+    };
+
+    struct NodeDesc {
+        std::string name;
+        glm::mat4 transform;
+        glm::mat4 localToBindPose;
+        uint32_t parent = Scene::kInvalidNode;
+        std::vector<uint32_t> children;
+        std::vector<uint32_t> meshes;
+    };
+
+    struct MeshInstanceDesc {
+        uint32_t nodeId = 0;
+        uint32_t materialId = 0;
+        uint32_t overrideMaterial = 0;
+    };
+
+    struct MeshDesc {
+        uint32_t topology = 0;
+        uint32_t materialId = 0;
+        uint32_t indexOffset = 0;
+        uint32_t staticVertexOffset = 0;
+        uint32_t dynamicVertexOffset = 0;
+        uint32_t indexCount = 0;
+        uint32_t vertexCount = 0;
+        uint32_t hasDynamicData = 0;
+        std::vector<MeshInstanceDesc> instances;
+    };
+
+    struct CameraDesc {
+        std::string name;
+        CameraData data;
+        bool preserveHeight = true;
+    };
+
+    struct LightDesc {
+        std::string name;
+        LightData data;
+        bool active = true;
+        float3 scaling = float3(1.f);                   ///< Analytic area lights only.
+        glm::mat4 transform = glm::mat4(1.f);           ///< Analytic area lights only.
+        float angle = 0.f;                              ///< Distant lights only.
+    };
+
+    // Geometry buffers
+    std::vector<uint32_t> indices;
+    std::vector<PackedStaticVertexData> staticData;
+    std::vector<DynamicVertexData> dynamicData;
+
+    std::vector<MeshDesc> meshes;
+    std::vector<NodeDesc> sceneGraph;
+    std::vector<MaterialDesc> materials;
+    std::vector<CameraDesc> cameras;
+    std::vector<LightDesc> lights;
+    uint32_t selectedCamera = 0;
+    float cameraSpeed = 1.f;
+    std::string envMapFilename;
+
+    /** Files the scene was built from besides the scene file (.mtl, .bin, textures, ...). Their size and modification
+        time are stored with the cache, which is rejected on load if any of them changed.
+    */
+    std::vector<std::string> dependencies;
+};
+
+/** Binary cache of processed scene builder state.
+
+    A cache file is a small header followed by the payload. Large arrays (index and vertex buffers) are stored
+    contiguously and aligned to kAlignment bytes, so loading them is a single read straight into the destination
+    vector, and the file can be memory mapped as-is.
+
+    Cache files are keyed by a hash of the source file (path, size, modification time), the build flags and the
+    instance matrices. Files referenced by the scene are listed in the cache itself (SceneCacheData::dependencies) and
+    checked when it is read. Files written by a different cache version, with different vertex layouts or with changed
+    dependencies are rejected.
+*/
+class dlldecl SceneCache {
+ public:
+    using Key = uint64_t;
+
+    static const uint32_t kVersion = 3;
+    static const uint32_t kAlignment = 16;
+
+    /** Compute the cache key for importing a file.
+        \param[in] filename Scene file. Only the file itself is hashed, the files it references are checked by hasValidCache() and readCache().
+        \param[in] flags Build flags, as an integer so this doesn't depend on the SceneBuilder.
+        \param[in] instances Instance matrices passed to the importer.
+        \return The key, or 0 if the file doesn't exist.
+    */
+    static Key computeKey(const std::string& filename, uint32_t flags, const std::vector<glm::mat4>& instances);
+
+    /** Get the cache directory. Uses FALCOR_SCENE_CACHE_DIR if set, otherwise a directory in the system temp path.
+    */
+    static std::string getCacheDirectory();
+
+    /** Get the cache filename for a key.
+    */
+    static std::string getCacheFilename(Key key);
+
+    /** Check if a valid cache file exists for a key. Only the header and the dependencies are read.
+    */
+    static bool hasValidCache(const std::string& filename, Key key);
+
+    /** Write a cache file. The file is written to a temporary file first and then renamed, so readers never see partial files.
+        \return True if successful.
+    */
+    static bool writeCache(const std::string& filename, Key key, const SceneCacheData& data);
+
+    /** Read a cache file.
+        \param[out] data The cached data. Undefined if the read failed.
+        \return True if successful.
+    */
+    static bool readCache(const std::string& filename, Key key, SceneCacheData& data);
+};
+
+}  // namespace Falcor
+
+#endif  // SRC_FALCOR_SCENE_SCENECACHE_H_
@@ -393,6 +393,15 @@ class Device;
     } RegisterGPUTest##Name;                                                    \
     static void GPUUnitTest##Name(GPUUnitTestContext& ctx) /* over to the user for the braces */
 
+/** Skip message for wall clock benchmarks, e.g. GPU_TEST(Name, BENCHMARK_SKIP_MESSAGE).
+    Their thresholds depend on the machine load, so they only run in builds configured with FALCOR_TEST_BENCHMARKS.
+*/
+#ifdef FALCOR_TEST_BENCHMARKS
+#define BENCHMARK_SKIP_MESSAGE
+#else
+#define BENCHMARK_SKIP_MESSAGE "Benchmark, configure with FALCOR_TEST_BENCHMARKS=ON to run it"
+#endif
+
 /** Macro definitions for the GPU unit testing framework. Note that they
     are all a single statement (including any additional << printed
     values).  Thus, it's perfectly fine to write code like:
@@ -0,0 +1,697 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "BCCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include <glm/gtc/packing.hpp>
+
+#include "Falcor/Utils/ThreadPool.h"
+
+namespace Falcor {
+
+namespace {
+
+const uint32_t kBlockRowsPerTask = 4;       // Granularity of the parallel encoder, in rows of blocks.
+const uint32_t kRefineIterations = 2;       // Least squares passes after the initial endpoint fit.
+const int kWeights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+ThreadPool& getEncodePool() {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+class BitWriter {
+ public:
+    explicit BitWriter(uint8_t* pData) : mpData(pData) {}
+
+    void write(uint32_t value, uint32_t bitCount) {
+        for (uint32_t i = 0; i < bitCount; i++, mPos++) {
+            mpData[mPos >> 3] |= uint8_t(((value >> i) & 1) << (mPos & 7));
+        }
+    }
+
+ private:
+    uint8_t* mpData;
+    uint32_t mPos = 0;
+};
+
+class BitReader {
+ public:
+    explicit BitReader(const uint8_t* pData) : mpData(pData) {}
+
+    uint32_t read(uint32_t bitCount) {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < bitCount; i++, mPos++) {
+            value |= uint32_t((mpData[mPos >> 3] >> (mPos & 7)) & 1) << i;
+        }
+        return value;
+    }
+
+ private:
+    const uint8_t* mpData;
+    uint32_t mPos = 0;
+};
+
+/** Fit a line through N-channel texels and return its extent along the principal axis.
+*/
+template<int N>
+void fitEndpoints(const float (&texels)[16][N], float (&e0)[N], float (&e1)[N]) {
+    float mean[N] = {};
+    float lo[N], hi[N];
+    for (int c = 0; c < N; c++) { lo[c] = texels[0][c]; hi[c] = texels[0][c]; }
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < N; c++) {
+            mean[c] += texels[i][c] / 16.f;
+            lo[c] = std::min(lo[c], texels[i][c]);
+            hi[c] = std::max(hi[c], texels[i][c]);
+        }
+    }
+
+    float cov[N][N] = {};
+    for (int i = 0; i < 16; i++) {
+        for (int a = 0; a < N; a++) {
+            for (int b = 0; b < N; b++) cov[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+        }
+    }
+
+    // Power iteration, starting from the bounding box diagonal.
+    float axis[N];
+    for (int c = 0; c < N; c++) axis[c] = hi[c] - lo[c];
+    for (int iter = 0; iter < 8; iter++) {
+        float next[N] = {};
+        for (int a = 0; a < N; a++) {
+            for (int b = 0; b < N; b++) next[a] += cov[a][b] * axis[b];
+        }
+        float norm = 0.f;
+        for (int c = 0; c < N; c++) norm = std::max(norm, std::abs(next[c]));
+        if (norm < 1e-12f) break;
+        for (int c = 0; c < N; c++) axis[c] = next[c] / norm;
+    }
+    float length = 0.f;
+    for (int c = 0; c < N; c++) length += axis[c] * axis[c];
+    length = std::sqrt(length);
+
+    if (length < 1e-12f) {
+        for (int c = 0; c < N; c++) { e0[c] = mean[c]; e1[c] = mean[c]; }
+        return;
+    }
+    for (int c = 0; c < N; c++) axis[c] /= length;
+
+    float tMin = std::numeric_limits<float>::max(), tMax = -std::numeric_limits<float>::max();
+    for (int i = 0; i < 16; i++) {
+        float t = 0.f;
+        for (int c = 0; c < N; c++) t += (texels[i][c] - mean[c]) * axis[c];
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+    for (int c = 0; c < N; c++) {
+        e0[c] = mean[c] + axis[c] * tMin;
+        e1[c] = mean[c] + axis[c] * tMax;
+    }
+}
+
+/** Least squares endpoints for fixed interpolation weights (0 = e0, 1 = e1).
+    \return False if the weights don't constrain both endpoints.
+*/
+template<int N>
+bool refineEndpoints(const float (&texels)[16][N], const float (&weights)[16], float (&e0)[N], float (&e1)[N]) {
+    float aa = 0.f, ab = 0.f, bb = 0.f;
+    float x0[N] = {}, x1[N] = {};
+    for (int i = 0; i < 16; i++) {
+        float a = 1.f - weights[i], b = weights[i];
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < N; c++) {
+            x0[c] += a * texels[i][c];
+            x1[c] += b * texels[i][c];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::abs(det) < 1e-6f) return false;
+
+    for (int c = 0; c < N; c++) {
+        e0[c] = (bb * x0[c] - ab * x1[c]) / det;
+        e1[c] = (aa * x1[c] - ab * x0[c]) / det;
+    }
+    return true;
+}
+
+int clampInt(float x, int lo, int hi) {
+    return std::min(hi, std::max(lo, int(std::lround(x))));
+}
+
+// BC1
+
+uint16_t packRgb565(const float (&c)[3]) {
+    return uint16_t((clampInt(c[0] * 31.f / 255.f, 0, 31) << 11) | (clampInt(c[1] * 63.f / 255.f, 0, 63) << 5) | clampInt(c[2] * 31.f / 255.f, 0, 31));
+}
+
+void unpackRgb565(uint16_t c, int (&rgb)[3]) {
+    int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+void getBC1Palette(uint16_t c0, uint16_t c1, int (&palette)[4][4]) {
+    int a[3], b[3];
+    unpackRgb565(c0, a);
+    unpackRgb565(c1, b);
+    for (int c = 0; c < 3; c++) {
+        palette[0][c] = a[c];
+        palette[1][c] = b[c];
+        if (c0 > c1) {
+            palette[2][c] = (2 * a[c] + b[c]) / 3;
+            palette[3][c] = (a[c] + 2 * b[c]) / 3;
+        } else {
+            palette[2][c] = (a[c] + b[c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = c0 > c1 ? 255 : 0;
+}
+
+/** Pick indices for a pair of 565 endpoints in four color mode. Swaps the endpoints into the order the mode needs.
+*/
+float evaluateBC1(const float (&texels)[16][3], uint16_t& c0, uint16_t& c1, uint32_t (&indices)[16]) {
+    if (c0 < c1) std::swap(c0, c1);
+
+    int palette[4][4];
+    getBC1Palette(c0, c1, palette);
+    uint32_t candidates = c0 == c1 ? 1 : 4;   // Equal endpoints decode in three color mode, only use index 0.
+
+    float total = 0.f;
+    for (int i = 0; i < 16; i++) {
+        float best = std::numeric_limits<float>::max();
+        for (uint32_t p = 0; p < candidates; p++) {
+            float err = 0.f;
+            for (int c = 0; c < 3; c++) err += (texels[i][c] - palette[p][c]) * (texels[i][c] - palette[p][c]);
+            if (err < best) { best = err; indices[i] = p; }
+        }
+        total += best;
+    }
+    return total;
+}
+
+void encodeBC1Block(const uint8_t* pTexels, uint8_t* pBlock) {
+    float texels[16][3];
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) texels[i][c] = pTexels[i * 4 + c];
+    }
+
+    float e0[3], e1[3];
+    fitEndpoints(texels, e0, e1);
+
+    static const float kIndexWeights[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+    float bestErr = std::numeric_limits<float>::max();
+    uint16_t bestC0 = 0, bestC1 = 0;
+    uint32_t bestIndices[16] = {};
+
+    for (uint32_t iter = 0; iter <= kRefineIterations; iter++) {
+        uint16_t c0 = packRgb565(e1), c1 = packRgb565(e0);
+        uint32_t indices[16];
+        float err = evaluateBC1(texels, c0, c1, indices);
+        if (err < bestErr) {
+            bestErr = err;
+            bestC0 = c0;
+            bestC1 = c1;
+            std::memcpy(bestIndices, indices, sizeof(indices));
+        }
+        if (c0 == c1) break;
+
+        // Palette entry 0 is c0, so weights run from c1 (e0) to c0 (e1).
+        float weights[16];
+        for (int i = 0; i < 16; i++) weights[i] = 1.f - kIndexWeights[indices[i]];
+        if (!refineEndpoints(texels, weights, e0, e1)) break;
+    }
+
+    std::memset(pBlock, 0, 8);
+    pBlock[0] = uint8_t(bestC0);
+    pBlock[1] = uint8_t(bestC0 >> 8);
+    pBlock[2] = uint8_t(bestC1);
+    pBlock[3] = uint8_t(bestC1 >> 8);
+    for (int i = 0; i < 16; i++) pBlock[4 + i / 4] |= uint8_t(bestIndices[i] << ((i % 4) * 2));
+}
+
+void decodeBC1Block(const uint8_t* pBlock, uint8_t* pTexels) {
+    uint16_t c0 = uint16_t(pBlock[0] | (pBlock[1] << 8));
+    uint16_t c1 = uint16_t(pBlock[2] | (pBlock[3] << 8));
+    int palette[4][4];
+    getBC1Palette(c0, c1, palette);
+    for (int i = 0; i < 16; i++) {
+        uint32_t index = (pBlock[4 + i / 4] >> ((i % 4) * 2)) & 3;
+        for (int c = 0; c < 4; c++) pTexels[i * 4 + c] = uint8_t(palette[index][c]);
+    }
+}
+
+// BC4 and BC5
+
+void getBC4Palette(int r0, int r1, int (&palette)[8]) {
+    palette[0] = r0;
+    palette[1] = r1;
+    if (r0 > r1) {
+        for (int i = 2; i < 8; i++) palette[i] = ((8 - i) * r0 + (i - 1) * r1) / 7;
+    } else {
+        for (int i = 2; i < 6; i++) palette[i] = ((6 - i) * r0 + (i - 1) * r1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+/** Encode one channel of 16 texels read with the given stride.
+*/
+void encodeBC4Block(const uint8_t* pTexels, uint32_t stride, uint8_t* pBlock) {
+    int lo = 255, hi = 0;
+    for (int i = 0; i < 16; i++) {
+        lo = std::min(lo, int(pTexels[i * stride]));
+        hi = std::max(hi, int(pTexels[i * stride]));
+    }
+
+    // With hi > lo this is the eight value mode, equal endpoints only ever use index 0.
+    int palette[8];
+    getBC4Palette(hi, lo, palette);
+
+    std::memset(pBlock, 0, 8);
+    pBlock[0] = uint8_t(hi);
+    pBlock[1] = uint8_t(lo);
+    uint64_t bits = 0;
+    for (int i = 0; i < 16; i++) {
+        int value = pTexels[i * stride];
+        uint32_t best = 0;
+        if (hi > lo) {
+            for (uint32_t p = 1; p < 8; p++) {
+                if (std::abs(palette[p] - value) < std::abs(palette[best] - value)) best = p;
+            }
+        }
+        bits |= uint64_t(best) << (3 * i);
+    }
+    for (int i = 0; i < 6; i++) pBlock[2 + i] = uint8_t(bits >> (8 * i));
+}
+
+void decodeBC4Block(const uint8_t* pBlock, uint8_t* pTexels, uint32_t stride) {
+    int palette[8];
+    getBC4Palette(pBlock[0], pBlock[1], palette);
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; i++) bits |= uint64_t(pBlock[2 + i]) << (8 * i);
+    for (int i = 0; i < 16; i++) pTexels[i * stride] = uint8_t(palette[(bits >> (3 * i)) & 7]);
+}
+
+void encodeBC4Block(const uint8_t* pTexels, uint8_t* pBlock) { encodeBC4Block(pTexels, 1, pBlock); }
+void decodeBC4Block(const uint8_t* pBlock, uint8_t* pTexels) { decodeBC4Block(pBlock, pTexels, 1); }
+
+void encodeBC5Block(const uint8_t* pTexels, uint8_t* pBlock) {
+    encodeBC4Block(pTexels, 2, pBlock);
+    encodeBC4Block(pTexels + 1, 2, pBlock + 8);
+}
+
+void decodeBC5Block(const uint8_t* pBlock, uint8_t* pTexels) {
+    decodeBC4Block(pBlock, pTexels, 2);
+    decodeBC4Block(pBlock + 8, pTexels + 1, 2);
+}
+
+// BC7 mode 6: one subset, RGBA 7.7.7.7 endpoints with a p-bit each, 4-bit indices.
+
+/** Quantize an endpoint to 7 bits per channel plus a shared p-bit, returning the 8-bit values it decodes to.
+*/
+void quantizeBC7Mode6Endpoint(const float (&e)[4], int (&q)[4], int& pBit, int (&decoded)[4]) {
+    float bestErr = std::numeric_limits<float>::max();
+    for (int p = 0; p < 2; p++) {
+        int candidate[4];
+        float err = 0.f;
+        for (int c = 0; c < 4; c++) {
+            candidate[c] = clampInt((e[c] - p) / 2.f, 0, 127);
+            float d = float(candidate[c] * 2 + p) - e[c];
+            err += d * d;
+        }
+        if (err < bestErr) {
+            bestErr = err;
+            pBit = p;
+            for (int c = 0; c < 4; c++) q[c] = candidate[c];
+        }
+    }
+    for (int c = 0; c < 4; c++) decoded[c] = q[c] * 2 + pBit;
+}
+
+int interpolate(int e0, int e1, int weight) {
+    return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+void encodeBC7Block(const uint8_t* pTexels, uint8_t* pBlock) {
+    float texels[16][4];
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 4; c++) texels[i][c] = pTexels[i * 4 + c];
+    }
+
+    float e0[4], e1[4];
+    fitEndpoints(texels, e0, e1);
+
+    float bestErr = std::numeric_limits<float>::max();
+    int bestQ[2][4] = {}, bestP[2] = {};
+    uint32_t bestIndices[16] = {};
+
+    for (uint32_t iter = 0; iter <= kRefineIterations; iter++) {
+        int q[2][4], p[2], decoded[2][4];
+        quantizeBC7Mode6Endpoint(e0, q[0], p[0], decoded[0]);
+        quantizeBC7Mode6Endpoint(e1, q[1], p[1], decoded[1]);
+
+        int palette[16][4];
+        for (int w = 0; w < 16; w++) {
+            for (int c = 0; c < 4; c++) palette[w][c] = interpolate(decoded[0][c], decoded[1][c], kWeights4[w]);
+        }
+
+        uint32_t indices[16];
+        float total = 0.f;
+        for (int i = 0; i < 16; i++) {
+            float best = std::numeric_limits<float>::max();
+            for (uint32_t w = 0; w < 16; w++) {
+                float err = 0.f;
+                for (int c = 0; c < 4; c++) err += (texels[i][c] - palette[w][c]) * (texels[i][c] - palette[w][c]);
+                if (err < best) { best = err; indices[i] = w; }
+            }
+            total += best;
+        }
+
+        if (total < bestErr) {
+            bestErr = total;
+            std::memcpy(bestQ, q, sizeof(q));
+            std::memcpy(bestP, p, sizeof(p));
+            std::memcpy(bestIndices, indices, sizeof(indices));
+        }
+
+        float weights[16];
+        for (int i = 0; i < 16; i++) weights[i] = kWeights4[indices[i]] / 64.f;
+        if (!refineEndpoints(texels, weights, e0, e1)) break;
+    }
+
+    // The anchor index is stored without its top bit, so texel 0 must use the lower half of the palette.
+    if (bestIndices[0] >= 8) {
+        std::swap(bestQ[0], bestQ[1]);
+        std::swap(bestP[0], bestP[1]);
+        for (auto& index : bestIndices) index = 15 - index;
+    }
+
+    std::memset(pBlock, 0, 16);
+    BitWriter writer(pBlock);
+    writer.write(1 << 6, 7);
+    for (int c = 0; c < 4; c++) {
+        writer.write(bestQ[0][c], 7);
+        writer.write(bestQ[1][c], 7);
+    }
+    writer.write(bestP[0], 1);
+    writer.write(bestP[1], 1);
+    for (int i = 0; i < 16; i++) writer.write(bestIndices[i], i == 0 ? 3 : 4);
+}
+
+void decodeBC7Block(const uint8_t* pBlock, uint8_t* pTexels) {
+    BitReader reader(pBlock);
+    if (reader.read(7) != (1 << 6)) {
+        std::memset(pTexels, 0, 64);
+        return;
+    }
+
+    int e[2][4];
+    for (int c = 0; c < 4; c++) {
+        e[0][c] = reader.read(7) << 1;
+        e[1][c] = reader.read(7) << 1;
+    }
+    int p0 = reader.read(1), p1 = reader.read(1);
+    for (int c = 0; c < 4; c++) {
+        e[0][c] |= p0;
+        e[1][c] |= p1;
+    }
+    for (int i = 0; i < 16; i++) {
+        uint32_t index = reader.read(i == 0 ? 3 : 4);
+        for (int c = 0; c < 4; c++) pTexels[i * 4 + c] = uint8_t(interpolate(e[0][c], e[1][c], kWeights4[index]));
+    }
+}
+
+// BC6H mode 11: one region, unsigned, 10-bit endpoints stored as is, 4-bit indices.
+
+int unquantizeBC6H(int value) {
+    if (value == 0) return 0;
+    if (value == 1023) return 0xffff;
+    return ((value << 16) + 0x8000) >> 10;
+}
+
+uint16_t finishUnquantizeBC6H(int value) {
+    return uint16_t((value * 31) >> 6);
+}
+
+void encodeBC6HBlock(const uint8_t* pTexels, uint8_t* pBlock) {
+    const float* pFloats = reinterpret_cast<const float*>(pTexels);
+
+    // Fit in the unquantized 16-bit domain, where interpolation is linear.
+    float halves[16][3], texels[16][3];
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+            float value = pFloats[i * 4 + c];
+            uint16_t h = (value > 0.f) ? glm::packHalf1x16(value) : 0;
+            h = std::min<uint16_t>(h, 0x7bff);   // Largest finite half, also catches Inf and NaN.
+            halves[i][c] = h;
+            texels[i][c] = h * 64.f / 31.f;
+        }
+    }
+
+    float e0[3], e1[3];
+    fitEndpoints(texels, e0, e1);
+
+    float bestErr = std::numeric_limits<float>::max();
+    int bestQ[2][3] = {};
+    uint32_t bestIndices[16] = {};
+
+    for (uint32_t iter = 0; iter <= kRefineIterations; iter++) {
+        int q[2][3], unq[2][3];
+        for (int c = 0; c < 3; c++) {
+            q[0][c] = clampInt((e0[c] - 32.f) / 64.f, 0, 1023);
+            q[1][c] = clampInt((e1[c] - 32.f) / 64.f, 0, 1023);
+            unq[0][c] = unquantizeBC6H(q[0][c]);
+            unq[1][c] = unquantizeBC6H(q[1][c]);
+        }
+
+        float palette[16][3];
+        for (int w = 0; w < 16; w++) {
+            for (int c = 0; c < 3; c++) palette[w][c] = finishUnquantizeBC6H(interpolate(unq[0][c], unq[1][c], kWeights4[w]));
+        }
+
+        // Error on the half bit patterns, roughly a relative error.
+        uint32_t indices[16];
+        float total = 0.f;
+        for (int i = 0; i < 16; i++) {
+            float best = std::numeric_limits<float>::max();
+            for (uint32_t w = 0; w < 16; w++) {
+                float err = 0.f;
+                for (int c = 0; c < 3; c++) err += (halves[i][c] - palette[w][c]) * (halves[i][c] - palette[w][c]);
+                if (err < best) { best = err; indices[i] = w; }
+            }
+            total += best;
+        }
+
+        if (total < bestErr) {
+            bestErr = total;
+            std::memcpy(bestQ, q, sizeof(q));
+            std::memcpy(bestIndices, indices, sizeof(indices));
+        }
+
+        float weights[16];
+        for (int i = 0; i < 16; i++) weights[i] = kWeights4[indices[i]] / 64.f;
+        if (!refineEndpoints(texels, weights, e0, e1)) break;
+    }
+
+    if (bestIndices[0] >= 8) {
+        std::swap(bestQ[0], bestQ[1]);
+        for (auto& index : bestIndices) index = 15 - index;
+    }
+
+    std::memset(pBlock, 0, 16);
+    BitWriter writer(pBlock);
+    writer.write(0x03, 5);
+    for (int e = 0; e < 2; e++) {
+        for (int c = 0; c < 3; c++) writer.write(bestQ[e][c], 10);
+    }
+    for (int i = 0; i < 16; i++) writer.write(bestIndices[i], i == 0 ? 3 : 4);
+}
+
+void decodeBC6HBlock(const uint8_t* pBlock, uint8_t* pTexels) {
+    float* pFloats = reinterpret_cast<float*>(pTexels);
+    BitReader reader(pBlock);
+    if (reader.read(5) != 0x03) {
+        std::memset(pTexels, 0, 16 * 4 * sizeof(float));
+        return;
+    }
+
+    int unq[2][3];
+    for (int e = 0; e < 2; e++) {
+        for (int c = 0; c < 3; c++) unq[e][c] = unquantizeBC6H(reader.read(10));
+    }
+    for (int i = 0; i < 16; i++) {
+        uint32_t index = reader.read(i == 0 ? 3 : 4);
+        for (int c = 0; c < 3; c++) {
+            pFloats[i * 4 + c] = glm::unpackHalf1x16(finishUnquantizeBC6H(interpolate(unq[0][c], unq[1][c], kWeights4[index])));
+        }
+        pFloats[i * 4 + 3] = 1.f;
+    }
+}
+
+struct CodecDesc {
+    uint32_t texelSize;     ///< Bytes per source texel.
+    uint32_t blockSize;     ///< Bytes per block.
+    void (*encode)(const uint8_t* pTexels, uint8_t* pBlock);
+    void (*decode)(const uint8_t* pBlock, uint8_t* pTexels);
+};
+
+bool getCodec(ResourceFormat format, CodecDesc& desc) {
+    switch (format) {
+        case ResourceFormat::BC1RGBUnorm:
+        case ResourceFormat::BC1RGBSrgb:
+            desc = { 4, 8, encodeBC1Block, decodeBC1Block };
+            return true;
+        case ResourceFormat::BC4Unorm:
+            desc = { 1, 8, encodeBC4Block, decodeBC4Block };
+            return true;
+        case ResourceFormat::BC5Unorm:
+            desc = { 2, 16, encodeBC5Block, decodeBC5Block };
+            return true;
+        case ResourceFormat::BC6HU16:
+            desc = { 16, 16, encodeBC6HBlock, decodeBC6HBlock };
+            return true;
+        case ResourceFormat::BC7Unorm:
+        case ResourceFormat::BC7Srgb:
+            desc = { 4, 16, encodeBC7Block, decodeBC7Block };
+            return true;
+        default:
+            return false;
+    }
+}
+
+/** Call func(rowBegin, rowEnd) for chunks of block rows, in parallel if requested. The calling thread takes the first chunk.
+*/
+template<typename Func>
+void forEachBlockRows(uint32_t blockRows, bool parallel, const Func& func) {
+    const uint32_t chunkCount = (blockRows + kBlockRowsPerTask - 1) / kBlockRowsPerTask;
+    if (!parallel || chunkCount <= 1) {
+        func(0u, blockRows);
+        return;
+    }
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(chunkCount - 1);
+    for (uint32_t chunk = 1; chunk < chunkCount; chunk++) {
+        uint32_t rowBegin = chunk * kBlockRowsPerTask;
+        uint32_t rowEnd = std::min(blockRows, rowBegin + kBlockRowsPerTask);
+        futures.push_back(getEncodePool().enqueue([&func, rowBegin, rowEnd]() { func(rowBegin, rowEnd); }));
+    }
+    func(0u, std::min(blockRows, kBlockRowsPerTask));
+    for (auto& f : futures) f.get();
+}
+
+}  // namespace
+
+bool isBCEncodeSupported(ResourceFormat format) {
+    CodecDesc desc;
+    return getCodec(format, desc);
+}
+
+ResourceFormat getBCSourceFormat(ResourceFormat format) {
+    switch (format) {
+        case ResourceFormat::BC1RGBUnorm:
+        case ResourceFormat::BC1RGBSrgb:
+        case ResourceFormat::BC7Unorm:
+        case ResourceFormat::BC7Srgb:
+            return ResourceFormat::RGBA8Unorm;
+        case ResourceFormat::BC4Unorm:
+            return ResourceFormat::R8Unorm;
+        case ResourceFormat::BC5Unorm:
+            return ResourceFormat::RG8Unorm;
+        case ResourceFormat::BC6HU16:
+            return ResourceFormat::RGBA32Float;
+        default:
+            return ResourceFormat::Unknown;
+    }
+}
+
+bool bcCompress(ResourceFormat format, uint32_t width, uint32_t height, const void* pSrc, size_t srcRowPitch, void* pDst, size_t dstRowPitch, bool parallel) {
+    CodecDesc codec;
+    if (!getCodec(format, codec)) return false;
+
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    if (dstRowPitch == 0) dstRowPitch = size_t(blocksX) * codec.blockSize;
+
+    forEachBlockRows(blocksY, parallel, [&](uint32_t rowBegin, uint32_t rowEnd) {
+        uint8_t texels[16 * 16];
+        for (uint32_t by = rowBegin; by < rowEnd; by++) {
+            uint8_t* pBlock = static_cast<uint8_t*>(pDst) + by * dstRowPitch;
+            for (uint32_t bx = 0; bx < blocksX; bx++, pBlock += codec.blockSize) {
+                for (uint32_t i = 0; i < 16; i++) {
+                    uint32_t x = std::min(bx * 4 + i % 4, width - 1);
+                    uint32_t y = std::min(by * 4 + i / 4, height - 1);
+                    const uint8_t* pTexel = static_cast<const uint8_t*>(pSrc) + y * srcRowPitch + x * codec.texelSize;
+                    std::memcpy(texels + i * codec.texelSize, pTexel, codec.texelSize);
+                }
+                codec.encode(texels, pBlock);
+            }
+        }
+    });
+    return true;
+}
+
+bool bcDecompress(ResourceFormat format, uint32_t width, uint32_t height, const void* pSrc, size_t srcRowPitch, void* pDst, size_t dstRowPitch) {
+    CodecDesc codec;
+    if (!getCodec(format, codec)) return false;
+
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    if (srcRowPitch == 0) srcRowPitch = size_t(blocksX) * codec.blockSize;
+
+    uint8_t texels[16 * 16];
+    for (uint32_t by = 0; by < blocksY; by++) {
+        const uint8_t* pBlock = static_cast<const uint8_t*>(pSrc) + by * srcRowPitch;
+        for (uint32_t bx = 0; bx < blocksX; bx++, pBlock += codec.blockSize) {
+            codec.decode(pBlock, texels);
+            for (uint32_t i = 0; i < 16; i++) {
+                uint32_t x = bx * 4 + i % 4;
+                uint32_t y = by * 4 + i / 4;
+                if (x >= width || y >= height) continue;
+                std::memcpy(static_cast<uint8_t*>(pDst) + y * dstRowPitch + x * codec.texelSize, texels + i * codec.texelSize, codec.texelSize);
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace Falcor
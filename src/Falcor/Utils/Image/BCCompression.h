@@ -0,0 +1,75 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#ifndef SRC_FALCOR_UTILS_IMAGE_BCCOMPRESSION_H_
+#define SRC_FALCOR_UTILS_IMAGE_BCCOMPRESSION_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "Falcor/Core/Framework.h"
+#include "Falcor/Core/API/Formats.h"
+
+namespace Falcor {
+
+/** CPU encoder and decoder for the block compressed formats LTX pages can be stored in.
+    Supported are BC1 (RGB, no alpha), BC4, BC5, BC6H (unsigned) and BC7. The BC6H and BC7 encoders only emit a
+    single-subset mode (BC6H mode 11, BC7 mode 6), which trades some quality for a simple and fast encoder.
+    Blocks are fitted along the principal axis of their texels and refined with a least squares pass.
+*/
+
+/** Check if bcCompress() can produce the format.
+*/
+dlldecl bool isBCEncodeSupported(ResourceFormat format);
+
+/** Get the format of the texels bcCompress() takes for a BC format: R8Unorm for BC4, RG8Unorm for BC5,
+    RGBA32Float for BC6H and RGBA8Unorm for BC1 and BC7. Returns Unknown for unsupported formats.
+*/
+dlldecl ResourceFormat getBCSourceFormat(ResourceFormat format);
+
+/** Compress an image. Blocks over the right and bottom edge replicate the last column and row.
+    \param[in] format Destination BC format, see isBCEncodeSupported().
+    \param[in] width Width of the image in texels.
+    \param[in] height Height of the image in texels.
+    \param[in] pSrc Texels in getBCSourceFormat(format).
+    \param[in] srcRowPitch Distance between source rows in bytes.
+    \param[out] pDst Blocks in rows of (width + 3) / 4 blocks.
+    \param[in] dstRowPitch Distance between block rows in bytes, 0 for tightly packed.
+    \param[in] parallel Encode rows of blocks on worker threads.
+    \return False if the format is not supported.
+*/
+dlldecl bool bcCompress(ResourceFormat format, uint32_t width, uint32_t height, const void* pSrc, size_t srcRowPitch, void* pDst, size_t dstRowPitch = 0, bool parallel = true);
+
+/** Decompress blocks written by bcCompress() into texels of getBCSourceFormat(format).
+    BC6H and BC7 blocks in other modes than the encoder emits decode to zero.
+    \return False if the format is not supported.
+*/
+dlldecl bool bcDecompress(ResourceFormat format, uint32_t width, uint32_t height, const void* pSrc, size_t srcRowPitch, void* pDst, size_t dstRowPitch);
+
+}  // namespace Falcor
+
+#endif  // SRC_FALCOR_UTILS_IMAGE_BCCOMPRESSION_H_
@@ -28,6 +28,10 @@
 #include "stdafx.h"
 #include "Bitmap.h"
 #include "BitmapUtils.h"
+#include "LTX_Bitmap.h"
+
+#include <chrono>
+#include <mutex>
 
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/imagebuf.h>
@@ -36,6 +40,7 @@
 #include "FreeImage.h"
 #include "Falcor/Core/API/Texture.h"
 #include "Falcor/Utils/StringUtils.h"
+#include "Falcor/Utils/ThreadPool.h"
 
 namespace oiio = OpenImageIO_v2_3;
 
@@ -315,6 +320,120 @@ void Bitmap::saveImageDialog(Texture* pTexture) {
     }
 }
 
+namespace {
+
+bool isFloat32Format(ResourceFormat format) {
+    return format == ResourceFormat::RGBA32Float || format == ResourceFormat::RGB32Float;
+}
+
+const uint32_t kRowsPerBlock = 64;          // Granularity of the parallel pixel conversion.
+const size_t kMaxConcurrentSaves = 4;       // Number of files saveImageAsync() writes at the same time.
+
+uint32_t getWorkerThreadCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/** Pool for pixel conversion blocks. Tasks on this pool never wait on other tasks.
+*/
+ThreadPool& getBlockPool() {
+    static ThreadPool pool(getWorkerThreadCount());
+    return pool;
+}
+
+/** Pool running whole saveImageAsync() jobs.
+*/
+ThreadPool& getFilePool() {
+    static ThreadPool pool(kMaxConcurrentSaves);
+    return pool;
+}
+
+struct PendingSaves {
+    std::mutex mutex;
+    std::vector<std::shared_future<void>> futures;
+} gPendingSaves;
+
+/** Call func(rowBegin, rowEnd) for blocks of kRowsPerBlock rows in parallel. The calling thread processes the first block.
+*/
+template<typename Func>
+void forEachRowBlock(uint32_t height, const Func& func) {
+    const uint32_t blockCount = (height + kRowsPerBlock - 1) / kRowsPerBlock;
+    if (blockCount <= 1) {
+        func(0u, height);
+        return;
+    }
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(blockCount - 1);
+    for (uint32_t block = 1; block < blockCount; block++) {
+        uint32_t rowBegin = block * kRowsPerBlock;
+        uint32_t rowEnd = std::min(height, rowBegin + kRowsPerBlock);
+        futures.push_back(getBlockPool().enqueue([&func, rowBegin, rowEnd]() { func(rowBegin, rowEnd); }));
+    }
+    func(0u, std::min(height, kRowsPerBlock));
+    for (auto& f : futures) f.get();
+}
+
+/** Block-parallel version of convertToRGBA32Float().
+*/
+std::vector<float> convertToRGBA32FloatParallel(ResourceFormat format, uint32_t width, uint32_t height, const void* pData) {
+    std::vector<float> floatData(size_t(width) * height * 4);
+    const size_t srcRowPitch = size_t(width) * getFormatBytesPerBlock(format);
+
+    forEachRowBlock(height, [&](uint32_t rowBegin, uint32_t rowEnd) {
+        const uint8_t* pSrc = static_cast<const uint8_t*>(pData) + rowBegin * srcRowPitch;
+        auto block = convertToRGBA32Float(format, width, rowEnd - rowBegin, pSrc);
+        std::memcpy(floatData.data() + size_t(rowBegin) * width * 4, block.data(), block.size() * sizeof(float));
+    });
+
+    return floatData;
+}
+
+/** OpenEXR compresses blocks of scanlines (or tiles) on its own thread pool. Size it to the machine once.
+*/
+void initExrThreads() {
+    static std::once_flag flag;
+    std::call_once(flag, []() { oiio::attribute("exr_threads", int(getWorkerThreadCount())); });
+}
+
+oiio::ImageSpec createExrSpec(uint32_t width, uint32_t height, Bitmap::ExportFlags exportFlags) {
+    const bool exportAlpha = is_set(exportFlags, Bitmap::ExportFlags::ExportAlpha);
+    const bool uncompressed = is_set(exportFlags, Bitmap::ExportFlags::Uncompressed);
+
+    // Matches the previous FreeImage defaults: half/PIZ, float/none when uncompressed, half/B44 when lossy.
+    oiio::ImageSpec spec(width, height, exportAlpha ? 4 : 3, uncompressed ? oiio::TypeDesc::FLOAT : oiio::TypeDesc::HALF);
+    if (uncompressed) {
+        spec.attribute("compression", "none");
+    } else if (is_set(exportFlags, Bitmap::ExportFlags::Lossy)) {
+        spec.attribute("compression", "b44");
+    } else {
+        spec.attribute("compression", "piz");
+    }
+    return spec;
+}
+
+/** Write an RGB32F/RGBA32F buffer (top row first) to an EXR file. Alpha is skipped through the pixel stride if not exported.
+*/
+bool saveExr(const std::string& filename, uint32_t width, uint32_t height, Bitmap::ExportFlags exportFlags, uint32_t bytesPerPixel, const void* pData) {
+    initExrThreads();
+
+    auto out = oiio::ImageOutput::create(filename);
+    if (!out) {
+        logError("Bitmap::saveImage can't create EXR writer for " + filename + ": " + oiio::geterror());
+        return false;
+    }
+
+    if (!out->open(filename, createExrSpec(width, height, exportFlags))) {
+        logError("Bitmap::saveImage can't open " + filename + ": " + out->geterror());
+        return false;
+    }
+
+    bool result = out->write_image(oiio::TypeDesc::FLOAT, pData, bytesPerPixel);
+    if (!result) logError("Bitmap::saveImage failed writing " + filename + ": " + out->geterror());
+    return out->close() && result;
+}
+
+}  // namespace
+
 void Bitmap::saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, void* pData) {
     if (pData == nullptr) {
         logError("Bitmap::saveImage provided no data to save.");
@@ -333,21 +452,20 @@ void Bitmap::saveImage(const std::string& filename, uint32_t width, uint32_t hei
     //TODO replace this code for swapping channels. Can't use freeimage masks b/c they only care about 16 bpp images
     //issue #74 in gitlab
     if (resourceFormat == ResourceFormat::RGBA8Unorm || resourceFormat == ResourceFormat::RGBA8Snorm || resourceFormat == ResourceFormat::RGBA8UnormSrgb) {
-        for (uint32_t a = 0; a < width*height; a++) {
-            uint32_t* pPixel = (uint32_t*)pData;
-            pPixel += a;
-            uint8_t* ch = (uint8_t*)pPixel;
-            std::swap(ch[0], ch[2]);
-            if (is_set(exportFlags, ExportFlags::ExportAlpha) == false) {
-                ch[3] = 0xff;
+        const bool exportAlpha = is_set(exportFlags, ExportFlags::ExportAlpha);
+        forEachRowBlock(height, [=](uint32_t rowBegin, uint32_t rowEnd) {
+            uint8_t* ch = static_cast<uint8_t*>(pData) + size_t(rowBegin) * width * 4;
+            for (size_t a = 0; a < size_t(rowEnd - rowBegin) * width; a++, ch += 4) {
+                std::swap(ch[0], ch[2]);
+                if (!exportAlpha) ch[3] = 0xff;
             }
-        }
+        });
     }
 
     if (fileFormat == Bitmap::FileFormat::PfmFile || fileFormat == Bitmap::FileFormat::ExrFile) {
         std::vector<float> floatData;
-        if (isConvertibleToRGBA32Float(resourceFormat)) {
-            floatData = convertToRGBA32Float(resourceFormat, width, height, pData);
+        if (!isFloat32Format(resourceFormat) && isConvertibleToRGBA32Float(resourceFormat)) {
+            floatData = convertToRGBA32FloatParallel(resourceFormat, width, height, pData);
             pData = floatData.data();
             resourceFormat = ResourceFormat::RGBA32Float;
             bytesPerPixel = 16;
@@ -374,34 +492,32 @@ void Bitmap::saveImage(const std::string& filename, uint32_t width, uint32_t hei
             return;
         }
 
+        if (fileFormat == Bitmap::FileFormat::ExrFile) {
+            saveExr(filename, width, height, exportFlags, bytesPerPixel, pData);
+            return;
+        }
+
         // Upload the image manually and flip it vertically
         bool scanlineCopy = exportAlpha ? bytesPerPixel == 16 : bytesPerPixel == 12;
 
         pImage = FreeImage_AllocateT(exportAlpha ? FIT_RGBAF : FIT_RGBF, width, height);
-        BYTE* head = (BYTE*)pData;
-        for (unsigned y = 0; y < height; y++) {
-            float* dstBits = (float*)FreeImage_GetScanLine(pImage, height - y - 1);
-            if (scanlineCopy) {
-                std::memcpy(dstBits, head, bytesPerPixel * width);
-            } else {
-                assert(exportAlpha == false);
-                for (unsigned x = 0; x < width; x++) {
-                    dstBits[x*3 + 0] = (((float*)head)[x*4 + 0]);
-                    dstBits[x*3 + 1] = (((float*)head)[x*4 + 1]);
-                    dstBits[x*3 + 2] = (((float*)head)[x*4 + 2]);
+        forEachRowBlock(height, [=](uint32_t rowBegin, uint32_t rowEnd) {
+            const BYTE* head = static_cast<const BYTE*>(pData) + size_t(rowBegin) * bytesPerPixel * width;
+            for (unsigned y = rowBegin; y < rowEnd; y++) {
+                float* dstBits = (float*)FreeImage_GetScanLine(pImage, height - y - 1);
+                if (scanlineCopy) {
+                    std::memcpy(dstBits, head, bytesPerPixel * width);
+                } else {
+                    assert(exportAlpha == false);
+                    for (unsigned x = 0; x < width; x++) {
+                        dstBits[x*3 + 0] = (((const float*)head)[x*4 + 0]);
+                        dstBits[x*3 + 1] = (((const float*)head)[x*4 + 1]);
+                        dstBits[x*3 + 2] = (((const float*)head)[x*4 + 2]);
+                    }
                 }
+                head += bytesPerPixel * width;
             }
-            head += bytesPerPixel * width;
-        }
-
-        if (fileFormat == Bitmap::FileFormat::ExrFile) {
-            flags = 0;
-            if (is_set(exportFlags, ExportFlags::Uncompressed)) {
-                flags |= EXR_NONE | EXR_FLOAT;
-            } else if (is_set(exportFlags, ExportFlags::Lossy)) {
-                flags |= EXR_B44 | EXR_ZIP;
-            }
-        }
+        });
     } else {
         FIBITMAP* pTemp = FreeImage_ConvertFromRawBits((BYTE*)pData, width, height, bytesPerPixel * width, bytesPerPixel * 8, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, isTopDown);
         if (is_set(exportFlags, ExportFlags::ExportAlpha) == false || fileFormat == Bitmap::FileFormat::JpegFile) {
@@ -459,11 +575,120 @@ void Bitmap::saveImage(const std::string& filename, uint32_t width, uint32_t hei
     FreeImage_Unload(pImage);
 }
 
+std::shared_future<void> Bitmap::saveImageAsync(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, std::vector<uint8_t> data) {
+    auto pData = std::make_shared<std::vector<uint8_t>>(std::move(data));
+    auto job = [=]() {
+        saveImage(filename, width, height, fileFormat, exportFlags, resourceFormat, isTopDown, pData->data());
+    };
+
+    std::shared_future<void> future = getFilePool().enqueue(job).share();
+
+    std::lock_guard<std::mutex> lock(gPendingSaves.mutex);
+    auto& futures = gPendingSaves.futures;
+    futures.erase(std::remove_if(futures.begin(), futures.end(), [](const std::shared_future<void>& f) {
+        return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }), futures.end());
+    futures.push_back(future);
+
+    return future;
+}
+
+void Bitmap::waitForPendingSaves() {
+    std::vector<std::shared_future<void>> futures;
+    {
+        std::lock_guard<std::mutex> lock(gPendingSaves.mutex);
+        futures.swap(gPendingSaves.futures);
+    }
+    for (auto& f : futures) f.wait();
+}
+
+struct Bitmap::StreamWriter::Impl {
+    std::unique_ptr<oiio::ImageOutput> pOutput;
+    std::vector<float> floatData;
+};
+
+Bitmap::StreamWriter::UniquePtr Bitmap::StreamWriter::create(const std::string& filename, uint32_t width, uint32_t height, ExportFlags exportFlags, ResourceFormat resourceFormat) {
+    if (!hasSuffix(filename, ".exr", false)) {
+        logError("Bitmap::StreamWriter supports only EXR files (" + filename + ").");
+        return nullptr;
+    }
+
+    if (!isFloat32Format(resourceFormat) && !isConvertibleToRGBA32Float(resourceFormat)) {
+        logError("Bitmap::StreamWriter supports only 32-bit/channel RGB/RGBA or formats convertible to RGBA32Float.");
+        return nullptr;
+    }
+
+    if (is_set(exportFlags, ExportFlags::ExportAlpha) && getFormatChannelCount(resourceFormat) < 4) {
+        logError("Bitmap::StreamWriter requesting to export alpha-channel, but the resource doesn't have an alpha-channel");
+        return nullptr;
+    }
+
+    initExrThreads();
+
+    auto pImpl = std::make_unique<Impl>();
+    pImpl->pOutput = oiio::ImageOutput::create(filename);
+    if (!pImpl->pOutput || !pImpl->pOutput->open(filename, createExrSpec(width, height, exportFlags))) {
+        logError("Bitmap::StreamWriter can't open " + filename + ": " + oiio::geterror());
+        return nullptr;
+    }
+
+    UniquePtr pWriter(new StreamWriter());
+    pWriter->mpImpl = std::move(pImpl);
+    pWriter->mWidth = width;
+    pWriter->mHeight = height;
+    pWriter->mFormat = resourceFormat;
+    return pWriter;
+}
+
+bool Bitmap::StreamWriter::writeRows(uint32_t firstRow, uint32_t rowCount, const void* pData) {
+    if (!mpImpl || !mpImpl->pOutput) {
+        logError("Bitmap::StreamWriter::writeRows called on a closed writer.");
+        return false;
+    }
+
+    if (firstRow != mRowsWritten || firstRow + rowCount > mHeight) {
+        logError("Bitmap::StreamWriter::writeRows rows must be written in order and within the image.");
+        return false;
+    }
+
+    uint32_t bytesPerPixel = getFormatBytesPerBlock(mFormat);
+    if (!isFloat32Format(mFormat)) {
+        mpImpl->floatData = convertToRGBA32FloatParallel(mFormat, mWidth, rowCount, pData);
+        pData = mpImpl->floatData.data();
+        bytesPerPixel = 16;
+    }
+
+    if (!mpImpl->pOutput->write_scanlines(firstRow, firstRow + rowCount, 0, oiio::TypeDesc::FLOAT, pData, bytesPerPixel)) {
+        logError("Bitmap::StreamWriter failed writing rows: " + mpImpl->pOutput->geterror());
+        return false;
+    }
+
+    mRowsWritten += rowCount;
+    return true;
+}
+
+bool Bitmap::StreamWriter::close() {
+    if (!mpImpl || !mpImpl->pOutput) return false;
+
+    bool complete = mRowsWritten == mHeight;
+    if (!complete) logWarning("Bitmap::StreamWriter closed after " + std::to_string(mRowsWritten) + " of " + std::to_string(mHeight) + " rows.");
+
+    bool result = mpImpl->pOutput->close();
+    mpImpl->pOutput.reset();
+    return complete && result;
+}
+
+Bitmap::StreamWriter::~StreamWriter() {
+    close();
+}
+
 void Bitmap::saveSparseImage(const std::string& filename, uint32_t width, uint32_t height, ResourceFormat resourceFormat, void* pData) {
     if(!hasSuffix(filename, ".ltx")) {
         LOG_ERR("Only LTX format supported for saving sparse images !!!");
         return;
     }
+
+    LTX_Bitmap::saveToFile(filename, width, height, resourceFormat, pData);
 }
 
 void Bitmap::readDataRegion(uint2 offset, uint2 extent, std::vector<uint8_t>& data ) const {
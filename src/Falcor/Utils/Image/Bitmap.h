@@ -28,6 +28,8 @@
 #ifndef SRC_FALCOR_UTILS_IMAGE_BITMAP_H_
 #define SRC_FALCOR_UTILS_IMAGE_BITMAP_H_
 
+#include <future>
+
 #include "Falcor/Core/Framework.h"
 
 
@@ -79,7 +81,61 @@ class dlldecl Bitmap : public std::enable_shared_from_this<Bitmap> {
     */
     static void saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, void* pData);
 
-    /** Store a memory buffer to a sparse file.
+    /** Store a memory buffer to a file on a background thread. Several files may be in flight at once.
+        The parameters are the same as for saveImage(), except that the writer takes ownership of the pixel data.
+        \return A future that becomes ready once the file has been written.
+    */
+    static std::shared_future<void> saveImageAsync(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, std::vector<uint8_t> data);
+
+    /** Block until all images queued with saveImageAsync() have been written.
+    */
+    static void waitForPendingSaves();
+
+    /** Incremental EXR writer. Blocks of scanlines are handed over as soon as they are available (e.g. while the
+        rest of the frame is still being read back), converted in parallel and compressed by the OpenEXR thread pool.
+    */
+    class dlldecl StreamWriter {
+     public:
+        using UniquePtr = std::unique_ptr<StreamWriter>;
+
+        /** Open an EXR file for streaming.
+            \param[in] filename Output filename. Must have the .exr extension.
+            \param[in] width The width of the image.
+            \param[in] height The height of the image.
+            \param[in] exportFlags The flags to export the file. See ExportFlags above.
+            \param[in] resourceFormat The format of the row data passed to writeRows().
+            \return A new object, or nullptr if the file can't be opened or the format is not supported.
+        */
+        static UniquePtr create(const std::string& filename, uint32_t width, uint32_t height, ExportFlags exportFlags, ResourceFormat resourceFormat);
+
+        /** Write a block of rows. Rows are top-down and must be submitted in order.
+            \param[in] firstRow Index of the first row in the block. Must equal the number of rows written so far.
+            \param[in] rowCount Number of rows in the block.
+            \param[in] pData Pointer to the rows, tightly packed.
+        */
+        bool writeRows(uint32_t firstRow, uint32_t rowCount, const void* pData);
+
+        /** Finish the file. Called by the destructor if needed.
+            \return False if not all rows were written or the file could not be finalized.
+        */
+        bool close();
+
+        uint32_t getRowsWritten() const { return mRowsWritten; }
+
+        ~StreamWriter();
+
+     private:
+        struct Impl;
+        StreamWriter() = default;
+
+        std::unique_ptr<Impl> mpImpl;
+        uint32_t mWidth = 0;
+        uint32_t mHeight = 0;
+        uint32_t mRowsWritten = 0;
+        ResourceFormat mFormat = ResourceFormat::Unknown;
+    };
+
+    /** Store a memory buffer to a sparse (LTX) file. The image is written page by page together with its mip chain.
         \param[in] filename Output filename. Can include a path - absolute or relative to the executable directory.
         \param[in] width The width of the image.
         \param[in] height The height of the image.
@@ -113,6 +113,10 @@ std::vector<float> convertToRGBA32Float(ResourceFormat format, uint32_t width, u
     {
         floatData = convertHalfToRGBA32Float(width, height, channelCount, pData);
     }
+    else if (type == FormatType::Float && channelBits == 32)
+    {
+        floatData = convertRGB32FloatToRGBA32Float(width, height, channelCount, pData);
+    }
     else if (type == FormatType::Uint && channelBits == 16)
     {
         floatData = convertIntToRGBA32Float<uint16_t>(width, height, channelCount, pData);
@@ -52,6 +52,10 @@ namespace oiio = OpenImageIO_v2_3;
 
 static const size_t kLtxHeaderOffset = sizeof(LTX_Header);
 
+// 9.0 adds the packed mip tail region, files written before don't have the mip tail fields in their header
+static const uint8_t kLtxMajorVersion = 9;
+static const uint8_t kLtxMinorVersion = 0;
+
 static struct {
     bool operator()(size_t a, size_t b) const {   
         return a < b;
@@ -90,6 +94,11 @@ LTX_Bitmap::SharedConstPtr LTX_Bitmap::createFromFile(std::shared_ptr<Device> pD
             return nullptr;
         }
 
+        if ((magic[5] - 48) * 10 + (magic[6] - 48) < kLtxMajorVersion * 10 + kLtxMinorVersion) {
+            LOG_WARN("LTX file %s was written by an older version, it needs to be converted again", filename.c_str());
+            return nullptr;
+        }
+
         file.seekg(0, file.beg);
     } else {
         LOG_ERR("Error opening file: %s !!!", filename.c_str());
@@ -188,6 +197,28 @@ static ResourceFormat getDestFormat(const ResourceFormat &format) {
             return ResourceFormat::RGBA32Uint;  // this should force 96bit to 128bit conversion
         case ResourceFormat::RGB32Float:
             return ResourceFormat::RGBA32Float; // this should force 96bit to 128bit conversion
+        case ResourceFormat::RGB16Float:
+            return ResourceFormat::RGBA16Float; // this should force 48bit to 64bit conversion
+        default:
+            break;
+    }
+
+    return format;
+}
+
+/** Block compressed format LTX pages of an uncompressed destination format are encoded to, or the format itself if there's none.
+*/
+static ResourceFormat getCompressedDestFormat(const ResourceFormat &format, bool hasAlpha) {
+    switch (format) {
+        case ResourceFormat::R8Unorm:
+            return ResourceFormat::BC4Unorm;
+        case ResourceFormat::RG8Unorm:
+            return ResourceFormat::BC5Unorm;
+        case ResourceFormat::RGBA8Unorm:
+            return hasAlpha ? ResourceFormat::BC7Unorm : ResourceFormat::BC1RGBUnorm;
+        case ResourceFormat::RGBA16Float:
+        case ResourceFormat::RGBA32Float:
+            return ResourceFormat::BC6HU16;  // alpha is dropped
         default:
             break;
     }
@@ -196,6 +227,11 @@ static ResourceFormat getDestFormat(const ResourceFormat &format) {
 }
 
 static uint3 getPageDims(const ResourceFormat &format) {
+    if (isCompressedFormat(format)) {
+        // standard sparse block shapes, 64KB of 4x4 blocks
+        return (getFormatBytesPerBlock(format) == 8) ? uint3{512, 256, 1} : uint3{256, 256, 1};
+    }
+
     uint32_t channelCount = getFormatChannelCount(format);
     uint32_t totalBits = 0;
 
@@ -248,7 +284,7 @@ static LTX_MipInfo calcMipInfo(const uint3& imgDims, const ResourceFormat &forma
     return info;
 }
 
-void LTX_Bitmap::convertToKtxFile(std::shared_ptr<Device> pDevice, const std::string& srcFilename, const std::string& dstFilename, bool isTopDown) {
+void LTX_Bitmap::convertToKtxFile(std::shared_ptr<Device> pDevice, const std::string& srcFilename, const std::string& dstFilename, bool isTopDown, bool compress) {
     auto in = oiio::ImageInput::open(srcFilename);
     if (!in) {
         LOG_ERR("Error reading image file %s", srcFilename.c_str());
@@ -265,6 +301,10 @@ void LTX_Bitmap::convertToKtxFile(std::shared_ptr<Device> pDevice, const std::st
     auto srcFormat = getFormatOIIO(spec.format.basetype, spec.nchannels);
     LOG_WARN("Source ResourceFormat from OIIO: %s", to_string(srcFormat).c_str());
     auto dstFormat = getDestFormat(srcFormat);
+    if (compress) {
+        dstFormat = getCompressedDestFormat(dstFormat, spec.nchannels == 4);
+        LOG_DBG("LTX pages compressed to %s", to_string(dstFormat).c_str());
+    }
 
     oiio::ImageBuf srcBuff;
 
@@ -280,6 +320,12 @@ void LTX_Bitmap::convertToKtxFile(std::shared_ptr<Device> pDevice, const std::st
         srcBuff = oiio::ImageBuf(srcFilename);
     }
 
+    writeLtxFile(dstFilename, srcBuff, dstFormat, fs::last_write_time(srcFilename));
+}
+
+bool LTX_Bitmap::writeLtxFile(const std::string& dstFilename, oiio::ImageBuf& srcBuff, ResourceFormat dstFormat, time_t srcLastWriteTime) {
+    const oiio::ImageSpec &spec = srcBuff.spec();
+
     // TODO: make image analysis (pre scale down source with blurry data) and reflect that in dstDims
     uint3 srcDims = {spec.width, spec.height, spec.depth};
     uint3 dstDims = srcDims;
@@ -289,10 +335,9 @@ void LTX_Bitmap::convertToKtxFile(std::shared_ptr<Device> pDevice, const std::st
     
     // make header
     LTX_Header header;
-    unsigned char magic[12];
-    makeMagic(9, 8, &header.magic[0]);
+    makeMagic(kLtxMinorVersion, kLtxMajorVersion, &header.magic[0]);
 
-    header.srcLastWriteTime = fs::last_write_time(srcFilename);
+    header.srcLastWriteTime = srcLastWriteTime;
     header.width = dstDims.x;
     header.height = dstDims.y;
     header.depth = dstDims.z;
@@ -303,14 +348,23 @@ void LTX_Bitmap::convertToKtxFile(std::shared_ptr<Device> pDevice, const std::st
     header.mipLevelsCount = mipInfo.mipLevelsCount;
     header.mipTailStart   = mipInfo.mipTailStart;
     header.format = dstFormat;//pBitmap->getFormat();
+    header.compressionRatio = {getFormatWidthCompressionRatio(dstFormat), getFormatHeightCompressionRatio(dstFormat)};
 
     // open file and write header
     FILE *pFile = fopen(dstFilename.c_str(), "wb");
+    if (!pFile) {
+        LOG_ERR("Error opening file %s for writing !!!", dstFilename.c_str());
+        return false;
+    }
     fwrite(&header, sizeof(unsigned char), sizeof(LTX_Header), pFile);
 
     LOG_WARN("LTX Mip page dims %u %u %u ...", mipInfo.pageDims.x, mipInfo.pageDims.y, mipInfo.pageDims.z);
 
-    if(ltxCpuGenerateAndWriteMIPTilesHQSlow(header, mipInfo, srcBuff, pFile)) {
+    bool result = isCompressedFormat(dstFormat) ? ltxCpuGenerateAndWriteMIPTilesBC(header, mipInfo, srcBuff, pFile) : ltxCpuGenerateAndWriteMIPTilesHQSlow(header, mipInfo, srcBuff, pFile);
+    if(result) {
+        result = ltxCpuGenerateAndWriteMipTail(header, mipInfo, srcBuff, pFile);
+    }
+    if(result) {
     //if(ltxCpuGenerateDebugMIPTiles(header, mipInfo, srcBuff, pFile)) {
         // re-write header as it might get modified ... 
         // TODO: increment pagesCount ONLY upon successfull fwrite !
@@ -318,6 +372,55 @@ void LTX_Bitmap::convertToKtxFile(std::shared_ptr<Device> pDevice, const std::st
         fwrite(&header, sizeof(unsigned char), sizeof(LTX_Header), pFile);
     }
     fclose(pFile);
+    return result;
+}
+
+static oiio::TypeDesc getTypeDescOIIO(ResourceFormat format) {
+    uint32_t channelBits = getNumChannelBits(format, 0);
+    switch (getFormatType(format)) {
+        case FormatType::Float:
+            if (channelBits == 32) return oiio::TypeDesc::FLOAT;
+            if (channelBits == 16) return oiio::TypeDesc::HALF;
+            break;
+        case FormatType::Unorm:
+        case FormatType::UnormSrgb:
+            if (channelBits == 8) return oiio::TypeDesc::UINT8;
+            if (channelBits == 16) return oiio::TypeDesc::UINT16;
+            break;
+        case FormatType::Uint:
+            if (channelBits == 32) return oiio::TypeDesc::UINT32;
+            break;
+        default:
+            break;
+    }
+    return oiio::TypeDesc::UNKNOWN;
+}
+
+void LTX_Bitmap::saveToFile(const std::string& filename, uint32_t width, uint32_t height, ResourceFormat resourceFormat, void* pData) {
+    if (pData == nullptr) {
+        LOG_ERR("LTX_Bitmap::saveToFile provided no data to save !!!");
+        return;
+    }
+
+    auto typeDesc = getTypeDescOIIO(resourceFormat);
+    if (typeDesc == oiio::TypeDesc::UNKNOWN) {
+        LOG_ERR("LTX_Bitmap::saveToFile unsupported resource format %s !!!", to_string(resourceFormat).c_str());
+        return;
+    }
+
+    // Wrap the caller's memory, no copy is made.
+    int nchannels = getFormatChannelCount(resourceFormat);
+    oiio::ImageBuf srcBuff(oiio::ImageSpec(width, height, nchannels, typeDesc), pData);
+
+    if (nchannels == 3) {
+        // Pages are stored as RGBA, same as in convertToKtxFile()
+        int channelorder[] = { 0, 1, 2, -1 /*use a float value*/ };
+        float channelvalues[] = { 0 /*ignore*/, 0 /*ignore*/, 0 /*ignore*/, 1.0 };
+        std::string channelnames[] = { "", "", "", "A" };
+        srcBuff = oiio::ImageBufAlgo::channels(srcBuff, 4, channelorder, channelvalues, channelnames);
+    }
+
+    writeLtxFile(filename, srcBuff, getDestFormat(resourceFormat), time(nullptr));
 }
 
 void LTX_Bitmap::readPageData(size_t pageNum, void *pData) const {
@@ -361,4 +464,25 @@ void LTX_Bitmap::readPagesData(std::vector<std::pair<size_t, void*>>& pages, boo
     fclose(pFile);
 }
 
+bool LTX_Bitmap::readMipTailData(std::vector<uint8_t>& data) const {
+    data.clear();
+    if (mHeader.mipTailSize == 0) return false;
+
+    auto pFile = fopen(mFilename.c_str(), "rb");
+    if (!pFile) {
+        LOG_ERR("Error opening file: %s !!!", mFilename.c_str());
+        return false;
+    }
+
+    data.resize(mHeader.mipTailSize);
+    bool result = fseek(pFile, long(mHeader.mipTailOffset), SEEK_SET) == 0 && fread(data.data(), 1, data.size(), pFile) == data.size();
+    fclose(pFile);
+
+    if (!result) {
+        LOG_ERR("Error reading mip tail from %s !!!", mFilename.c_str());
+        data.clear();
+    }
+    return result;
+}
+
 }  // namespace Falcor
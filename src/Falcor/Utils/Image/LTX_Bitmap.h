@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include "Falcor/Core/Framework.h"
 
+namespace OpenImageIO_v2_3 { class ImageBuf; }
 
 namespace Falcor {
 
@@ -39,6 +40,9 @@ struct LTX_Header {
         uint32_t width;
         uint32_t height;
     } compressionRatio = {1, 1};
+
+    uint64_t        mipTailOffset = 0;  // file offset of the packed mip tail levels, laid out as ltxGetMipTailLayout() returns them
+    uint32_t        mipTailSize = 0;    // 0 if there is no mip tail
 };
 
 struct LTX_MipInfo {
@@ -117,6 +121,10 @@ class dlldecl LTX_Bitmap : public std::enable_shared_from_this<LTX_Bitmap> {
     */
     uint8_t getMipLevelsCount() const { return mHeader.mipLevelsCount; }
 
+    /** Get the first mip level stored in the packed mip tail region instead of pages
+    */
+    uint8_t getMipTailStart() const { return mHeader.mipTailStart; }
+
     /** Get the number of bytes per pixel
     */
     ResourceFormat getFormat() const { return mHeader.format; }
@@ -125,12 +133,20 @@ class dlldecl LTX_Bitmap : public std::enable_shared_from_this<LTX_Bitmap> {
 
     
  protected:
-    static void convertToKtxFile(std::shared_ptr<Device> pDevice, const std::string& srcFilename, const std::string& dstFilename, bool isTopDown);
+    /** Convert an image file to LTX. With compress set, pages of 8-bit and half/float sources are block compressed
+        (BC4 for R, BC5 for RG, BC1 for RGB, BC7 for RGBA, BC6H for half/float); other formats are stored uncompressed.
+    */
+    static void convertToKtxFile(std::shared_ptr<Device> pDevice, const std::string& srcFilename, const std::string& dstFilename, bool isTopDown, bool compress = false);
 
     void readPageData (size_t pageNum, void *pData) const;
     void readPageData (size_t pageNum, void *pData, FILE *pFile) const;
     void readPagesData (std::vector<std::pair<size_t, void*>>& pages, bool unsorted = false) const;
 
+    /** Read the whole packed mip tail region in one go.
+        \return False if the file has no mip tail or it can't be read.
+    */
+    bool readMipTailData(std::vector<uint8_t>& data) const;
+
     friend class ResourceManager;
 
  private:
@@ -139,6 +155,10 @@ class dlldecl LTX_Bitmap : public std::enable_shared_from_this<LTX_Bitmap> {
     static bool checkMagic(const unsigned char* magic);
     static void makeMagic(uint8_t minor, uint8_t major, unsigned char *magic);
 
+    /** Write header, pages and mip chain of srcBuff to an LTX file. Shared by convertToKtxFile() and saveToFile().
+    */
+    static bool writeLtxFile(const std::string& dstFilename, OpenImageIO_v2_3::ImageBuf& srcBuff, ResourceFormat dstFormat, time_t srcLastWriteTime);
+
     uint8_t*    mpData = nullptr;
     size_t      mDataSize = 0;
     
@@ -1,6 +1,8 @@
 #include "Falcor/Core/Framework.h"
 #include "Falcor/Core/API/Formats.h"
 #include "LTX_BitmapAlgo.h"
+#include "LTX_MipTail.h"
+#include "BCCompression.h"
 
 namespace Falcor {
 
@@ -208,6 +210,113 @@ bool ltxCpuGenerateAndWriteMIPTilesHQSlow(LTX_Header &header, LTX_MipInfo &mipIn
     return true;
 }
 
+bool ltxCpuGenerateAndWriteMIPTilesBC(LTX_Header &header, LTX_MipInfo &mipInfo, oiio::ImageBuf &srcBuff, FILE *pFile) {
+    assert(pFile);
+
+    auto format = header.format;
+    auto srcFormat = getBCSourceFormat(format);
+    if (srcFormat == ResourceFormat::Unknown) {
+        LOG_ERR("No BC encoder for format %s !!!", to_string(format).c_str());
+        return false;
+    }
+
+    // source texels as the encoder takes them
+    uint32_t srcChannelCount = getFormatChannelCount(srcFormat);
+    size_t srcBytesPerPixel = getFormatBytesPerBlock(srcFormat);
+    oiio::TypeDesc srcTypeDesc = (getFormatType(srcFormat) == FormatType::Float) ? oiio::TypeDesc::FLOAT : oiio::TypeDesc::UINT8;
+
+    // page dimensions in blocks
+    uint32_t blockWidth = getFormatWidthCompressionRatio(format);
+    uint32_t blockHeight = getFormatHeightCompressionRatio(format);
+    size_t blockSize = getFormatBytesPerBlock(format);
+    uint32_t pageBlocksX = header.pageDims.width / blockWidth;
+    uint32_t pageBlocksY = header.pageDims.height / blockHeight;
+    size_t pageRowStride = pageBlocksX * blockSize;
+    assert(pageRowStride * pageBlocksY == header.pageDataSize);
+
+    uint32_t pagesCount = 0;
+    std::vector<unsigned char> pixels;
+    std::vector<unsigned char> blocks;
+    std::vector<unsigned char> page(header.pageDataSize);
+
+    for(uint8_t mipLevel = 0; mipLevel < mipInfo.mipTailStart; mipLevel++) {
+        uint32_t mipLevelWidth = mipInfo.mipLevelsDims[mipLevel].x;
+        uint32_t mipLevelHeight = mipInfo.mipLevelsDims[mipLevel].y;
+
+        pixels.resize(size_t(mipLevelWidth) * mipLevelHeight * srcBytesPerPixel);
+        oiio::ROI roi(0, mipLevelWidth, 0, mipLevelHeight, 0, 1, 0, srcChannelCount);
+        if (mipLevel == 0) {
+            srcBuff.get_pixels(roi, srcTypeDesc, pixels.data(), oiio::AutoStride, oiio::AutoStride, oiio::AutoStride);
+        } else {
+            oiio::ImageBufAlgo::resize(srcBuff, "", 0, roi).get_pixels(roi, srcTypeDesc, pixels.data(), oiio::AutoStride, oiio::AutoStride, oiio::AutoStride);
+        }
+
+        uint32_t blocksX = (mipLevelWidth + blockWidth - 1) / blockWidth;
+        uint32_t blocksY = (mipLevelHeight + blockHeight - 1) / blockHeight;
+        size_t blocksRowStride = blocksX * blockSize;
+        blocks.resize(blocksRowStride * blocksY);
+        bcCompress(format, mipLevelWidth, mipLevelHeight, pixels.data(), mipLevelWidth * srcBytesPerPixel, blocks.data(), blocksRowStride);
+
+        uint32_t pagesNumX = (blocksX + pageBlocksX - 1) / pageBlocksX;
+        uint32_t pagesNumY = (blocksY + pageBlocksY - 1) / pageBlocksY;
+        LOG_DBG("Writing BC mip level %u tiles %u %u ...", mipLevel, pagesNumX, pagesNumY);
+
+        for(uint32_t tileIdxY = 0; tileIdxY < pagesNumY; tileIdxY++) {
+            uint32_t rowsCount = std::min(pageBlocksY, blocksY - tileIdxY * pageBlocksY);
+            for(uint32_t tileIdxX = 0; tileIdxX < pagesNumX; tileIdxX++) {
+                size_t rowBytes = std::min(pageBlocksX, blocksX - tileIdxX * pageBlocksX) * blockSize;
+                const unsigned char *pTileData = blocks.data() + tileIdxY * pageBlocksY * blocksRowStride + tileIdxX * pageRowStride;
+
+                std::fill(page.begin(), page.end(), 0);
+                for(uint32_t row = 0; row < rowsCount; row++) {
+                    std::memcpy(page.data() + row * pageRowStride, pTileData + row * blocksRowStride, rowBytes);
+                }
+                fwrite(page.data(), sizeof(uint8_t), page.size(), pFile);
+            }
+        }
+        pagesCount += pagesNumX * pagesNumY;
+    }
+
+    header.pagesCount = pagesCount;
+
+    return true;
+}
+
+bool ltxCpuGenerateAndWriteMipTail(LTX_Header &header, LTX_MipInfo &mipInfo, oiio::ImageBuf &srcBuff, FILE *pFile) {
+    assert(pFile);
+
+    header.mipTailOffset = 0;
+    header.mipTailSize = 0;
+    if (mipInfo.mipTailStart >= mipInfo.mipLevelsCount) return true;
+
+    // level 0 texels in the format the tail is filtered in
+    auto format = header.format;
+    auto texelFormat = isCompressedFormat(format) ? getBCSourceFormat(format) : format;
+    oiio::TypeDesc texelTypeDesc = oiio::TypeDesc::UINT8;
+    if (getFormatType(texelFormat) == FormatType::Float) texelTypeDesc = oiio::TypeDesc::FLOAT;
+    else if (getFormatType(texelFormat) == FormatType::Uint) texelTypeDesc = oiio::TypeDesc::UINT32;
+    int channelCount = getFormatChannelCount(texelFormat);
+
+    // level 0 is read from srcBuff in bands, a copy of the whole level would double the peak memory of large textures
+    auto readRows = [&](uint32_t firstRow, uint32_t rowCount, void* pTexels) {
+        oiio::ROI roi(0, header.width, firstRow, firstRow + rowCount, 0, 1, 0, channelCount);
+        return srcBuff.get_pixels(roi, texelTypeDesc, pTexels, oiio::AutoStride, oiio::AutoStride, oiio::AutoStride);
+    };
+
+    std::vector<uint8_t> mipTail;
+    if (!ltxGenerateMipTailFromRows(format, header.width, header.height, mipInfo.mipLevelsCount, mipInfo.mipTailStart, readRows, mipTail)) {
+        LOG_ERR("Unable to generate mip tail for format %s !!!", to_string(format).c_str());
+        return false;
+    }
+    LOG_DBG("Writing mip tail levels %u to %u, %zu bytes ...", mipInfo.mipTailStart, mipInfo.mipLevelsCount - 1, mipTail.size());
+
+    // the region follows the last page written
+    fseek(pFile, 0, SEEK_END);
+    header.mipTailOffset = static_cast<uint64_t>(ftell(pFile));
+    header.mipTailSize = static_cast<uint32_t>(mipTail.size());
+    return fwrite(mipTail.data(), sizeof(uint8_t), mipTail.size(), pFile) == mipTail.size();
+}
+
 bool ltxCpuGenerateAndWriteMIPTilesHQFast(LTX_Header &header, LTX_MipInfo &mipInfo, oiio::ImageBuf &srcBuff, FILE *pFile) {
     return true;
 }
@@ -31,6 +31,16 @@ bool ltxCpuGenerateAndWriteMIPTilesLQ(LTX_Header &header, LTX_MipInfo &mipInfo,
  */
 bool ltxCpuGenerateAndWriteMIPTilesPOT(LTX_Header &header, LTX_MipInfo &mipInfo, oiio::ImageBuf &srcBuff, FILE *pFile);
 
+/* Block compressed tiles for a BC header.format. Each mip level is encoded in parallel, then cut into pages of
+   pageDims texels, which hold whole blocks and pageDataSize bytes. Partial pages are zero padded like in HQSlow.
+ */
+bool ltxCpuGenerateAndWriteMIPTilesBC(LTX_Header &header, LTX_MipInfo &mipInfo, oiio::ImageBuf &srcBuff, FILE *pFile);
+
+/* Packed mip tail levels, appended after the pages. Levels are box filtered from level 0 on worker threads and stored in
+   header.format, see LTX_MipTail.h. Sets header.mipTailOffset and header.mipTailSize.
+ */
+bool ltxCpuGenerateAndWriteMipTail(LTX_Header &header, LTX_MipInfo &mipInfo, oiio::ImageBuf &srcBuff, FILE *pFile);
+
 /* Debug ltx tiles generation
  */
 bool ltxCpuGenerateDebugMIPTiles(LTX_Header &header, LTX_MipInfo &mipInfo, oiio::ImageBuf &srcBuff, FILE *pFile);
@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <thread>
+
+#include "LTX_MipTail.h"
+#include "BCCompression.h"
+
+#include "Falcor/Utils/ThreadPool.h"
+
+namespace Falcor {
+
+namespace {
+
+const uint32_t kRowsPerTask = 16;       // Destination rows in a tile filtered by one task.
+
+ThreadPool& getDownsamplePool() {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+/** Call func(rowBegin, rowEnd) for tiles of rows, in parallel if requested. The calling thread takes the first tile.
+*/
+template<typename Func>
+void forEachRowTile(uint32_t rows, bool parallel, const Func& func) {
+    const uint32_t tileCount = (rows + kRowsPerTask - 1) / kRowsPerTask;
+    if (!parallel || tileCount <= 1) {
+        func(0u, rows);
+        return;
+    }
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(tileCount - 1);
+    for (uint32_t tile = 1; tile < tileCount; tile++) {
+        uint32_t rowBegin = tile * kRowsPerTask;
+        uint32_t rowEnd = std::min(rows, rowBegin + kRowsPerTask);
+        futures.push_back(getDownsamplePool().enqueue([&func, rowBegin, rowEnd]() { func(rowBegin, rowEnd); }));
+    }
+    func(0u, std::min(rows, kRowsPerTask));
+    for (auto& f : futures) f.get();
+}
+
+inline uint8_t average(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { return uint8_t((uint32_t(a) + b + c + d + 2) >> 2); }
+inline uint32_t average(uint32_t a, uint32_t b, uint32_t c, uint32_t d) { return uint32_t((uint64_t(a) + b + c + d + 2) >> 2); }
+inline float average(float a, float b, float c, float d) { return (a + b + c + d) * 0.25f; }
+
+template<typename T, uint32_t N>
+void downsampleRows(uint32_t srcWidth, uint32_t srcHeight, const uint8_t* pSrc, size_t srcRowPitch, uint8_t* pDst, size_t dstRowPitch, uint32_t rowBegin, uint32_t rowEnd) {
+    const uint32_t dstWidth = std::max(srcWidth >> 1, 1u);
+    for (uint32_t y = rowBegin; y < rowEnd; y++) {
+        const T* pRow0 = reinterpret_cast<const T*>(pSrc + size_t(std::min(2 * y, srcHeight - 1)) * srcRowPitch);
+        const T* pRow1 = reinterpret_cast<const T*>(pSrc + size_t(std::min(2 * y + 1, srcHeight - 1)) * srcRowPitch);
+        T* pOut = reinterpret_cast<T*>(pDst + size_t(y) * dstRowPitch);
+        for (uint32_t x = 0; x < dstWidth; x++) {
+            uint32_t x0 = std::min(2 * x, srcWidth - 1) * N;
+            uint32_t x1 = std::min(2 * x + 1, srcWidth - 1) * N;
+            for (uint32_t c = 0; c < N; c++) pOut[x * N + c] = average(pRow0[x0 + c], pRow0[x1 + c], pRow1[x0 + c], pRow1[x1 + c]);
+        }
+    }
+}
+
+using DownsampleFunc = void (*)(uint32_t, uint32_t, const uint8_t*, size_t, uint8_t*, size_t, uint32_t, uint32_t);
+
+template<typename T>
+DownsampleFunc getDownsampleFunc(uint32_t channelCount) {
+    switch (channelCount) {
+        case 1: return downsampleRows<T, 1>;
+        case 2: return downsampleRows<T, 2>;
+        case 3: return downsampleRows<T, 3>;
+        case 4: return downsampleRows<T, 4>;
+        default: return nullptr;
+    }
+}
+
+DownsampleFunc getDownsampleFunc(ResourceFormat format) {
+    if (format == ResourceFormat::Unknown || isCompressedFormat(format)) return nullptr;
+
+    uint32_t channelCount = getFormatChannelCount(format);
+    uint32_t channelBits = getNumChannelBits(format, 0);
+    for (uint32_t i = 1; i < channelCount; i++) {
+        if (getNumChannelBits(format, i) != channelBits) return nullptr;
+    }
+    if (getFormatBytesPerBlock(format) * 8 != channelBits * channelCount) return nullptr;
+
+    switch (getFormatType(format)) {
+        case FormatType::Unorm:
+            return channelBits == 8 ? getDownsampleFunc<uint8_t>(channelCount) : nullptr;
+        case FormatType::Uint:
+            return channelBits == 32 ? getDownsampleFunc<uint32_t>(channelCount) : nullptr;
+        case FormatType::Float:
+            return channelBits == 32 ? getDownsampleFunc<float>(channelCount) : nullptr;
+        default:
+            return nullptr;
+    }
+}
+
+}  // namespace
+
+std::vector<LTX_MipTailLevel> ltxGetMipTailLayout(uint32_t width, uint32_t height, uint8_t mipLevelsCount, uint8_t mipTailStart, ResourceFormat format, size_t* pTotalSize) {
+    std::vector<LTX_MipTailLevel> levels;
+    uint32_t blockWidth = getFormatWidthCompressionRatio(format);
+    uint32_t blockHeight = getFormatHeightCompressionRatio(format);
+    size_t blockSize = getFormatBytesPerBlock(format);
+
+    size_t offset = 0;
+    for (uint32_t mipLevel = mipTailStart; mipLevel < mipLevelsCount; mipLevel++) {
+        LTX_MipTailLevel level;
+        level.mipLevel = uint8_t(mipLevel);
+        level.width = std::max(width >> mipLevel, 1u);
+        level.height = std::max(height >> mipLevel, 1u);
+        level.offset = offset;
+        level.rowPitch = size_t((level.width + blockWidth - 1) / blockWidth) * blockSize;
+        level.size = level.rowPitch * ((level.height + blockHeight - 1) / blockHeight);
+        levels.push_back(level);
+
+        offset += (level.size + kLtxMipTailAlignment - 1) & ~(kLtxMipTailAlignment - 1);
+    }
+
+    if (pTotalSize) *pTotalSize = offset;
+    return levels;
+}
+
+bool ltxDownsample(ResourceFormat format, uint32_t srcWidth, uint32_t srcHeight, const void* pSrc, size_t srcRowPitch, void* pDst, size_t dstRowPitch, bool parallel) {
+    DownsampleFunc func = getDownsampleFunc(format);
+    if (!func) return false;
+
+    forEachRowTile(std::max(srcHeight >> 1, 1u), parallel, [&](uint32_t rowBegin, uint32_t rowEnd) {
+        func(srcWidth, srcHeight, static_cast<const uint8_t*>(pSrc), srcRowPitch, static_cast<uint8_t*>(pDst), dstRowPitch, rowBegin, rowEnd);
+    });
+    return true;
+}
+
+bool ltxGenerateMipTail(ResourceFormat format, uint32_t width, uint32_t height, uint8_t mipLevelsCount, uint8_t mipTailStart, const void* pTexels, std::vector<uint8_t>& data, bool parallel) {
+    data.clear();
+
+    bool compressed = isCompressedFormat(format);
+    ResourceFormat texelFormat = compressed ? getBCSourceFormat(format) : format;
+    if (!getDownsampleFunc(texelFormat) || (compressed && !isBCEncodeSupported(format))) return false;
+    if (mipTailStart >= mipLevelsCount) return true;
+
+    size_t totalSize = 0;
+    auto layout = ltxGetMipTailLayout(width, height, mipLevelsCount, mipTailStart, format, &totalSize);
+    data.assign(totalSize, 0);
+
+    const size_t texelSize = getFormatBytesPerBlock(texelFormat);
+    auto storeLevel = [&](const LTX_MipTailLevel& level, const uint8_t* pLevelTexels) {
+        if (compressed) {
+            bcCompress(format, level.width, level.height, pLevelTexels, level.width * texelSize, data.data() + level.offset, level.rowPitch, parallel);
+        } else {
+            std::memcpy(data.data() + level.offset, pLevelTexels, level.size);
+        }
+    };
+
+    // Each level is filtered from the previous one, so level 0 is only read once. The chain alternates between two buffers.
+    const uint8_t* pLevelTexels = static_cast<const uint8_t*>(pTexels);
+    if (mipTailStart == 0) storeLevel(layout[0], pLevelTexels);
+
+    std::vector<uint8_t> levelTexels[2];
+    uint32_t levelWidth = width;
+    uint32_t levelHeight = height;
+    for (uint32_t mipLevel = 1; mipLevel < mipLevelsCount; mipLevel++) {
+        uint32_t dstWidth = std::max(levelWidth >> 1, 1u);
+        uint32_t dstHeight = std::max(levelHeight >> 1, 1u);
+        auto& dst = levelTexels[mipLevel & 1];
+        dst.resize(size_t(dstWidth) * dstHeight * texelSize);
+        ltxDownsample(texelFormat, levelWidth, levelHeight, pLevelTexels, levelWidth * texelSize, dst.data(), dstWidth * texelSize, parallel);
+
+        pLevelTexels = dst.data();
+        levelWidth = dstWidth;
+        levelHeight = dstHeight;
+        if (mipLevel >= mipTailStart) storeLevel(layout[mipLevel - mipTailStart], pLevelTexels);
+    }
+    return true;
+}
+
+bool ltxGenerateMipTailFromRows(ResourceFormat format, uint32_t width, uint32_t height, uint8_t mipLevelsCount, uint8_t mipTailStart,
+    const std::function<bool(uint32_t firstRow, uint32_t rowCount, void* pTexels)>& readRows, std::vector<uint8_t>& data, bool parallel) {
+    data.clear();
+
+    bool compressed = isCompressedFormat(format);
+    ResourceFormat texelFormat = compressed ? getBCSourceFormat(format) : format;
+    if (!getDownsampleFunc(texelFormat) || (compressed && !isBCEncodeSupported(format))) return false;
+    if (mipTailStart >= mipLevelsCount) return true;
+
+    // Row y of level mipTailStart only depends on level 0 rows [y << mipTailStart, (y + 1) << mipTailStart), as long as no level
+    // in between is clamped to a height of 1. Smaller images are filtered as a single band.
+    const size_t texelSize = getFormatBytesPerBlock(texelFormat);
+    const uint32_t bandRows = (height >> mipTailStart) != 0 ? 1u << mipTailStart : height;
+    const uint32_t tailWidth = std::max(width >> mipTailStart, 1u);
+    const uint32_t tailHeight = std::max(height >> mipTailStart, 1u);
+
+    std::vector<uint8_t> tailTexels(size_t(tailWidth) * tailHeight * texelSize);
+    std::vector<uint8_t> band(size_t(width) * bandRows * texelSize);
+    std::vector<uint8_t> levelTexels[2];
+    for (uint32_t y = 0; y < tailHeight; y++) {
+        if (!readRows(y * bandRows, bandRows, band.data())) return false;
+
+        const uint8_t* pLevelTexels = band.data();
+        uint32_t levelWidth = width;
+        uint32_t levelHeight = bandRows;
+        for (uint32_t mipLevel = 1; mipLevel <= mipTailStart; mipLevel++) {
+            uint32_t dstWidth = std::max(levelWidth >> 1, 1u);
+            uint32_t dstHeight = std::max(levelHeight >> 1, 1u);
+            auto& dst = levelTexels[mipLevel & 1];
+            dst.resize(size_t(dstWidth) * dstHeight * texelSize);
+            ltxDownsample(texelFormat, levelWidth, levelHeight, pLevelTexels, levelWidth * texelSize, dst.data(), dstWidth * texelSize, parallel);
+
+            pLevelTexels = dst.data();
+            levelWidth = dstWidth;
+            levelHeight = dstHeight;
+        }
+        std::memcpy(tailTexels.data() + size_t(y) * tailWidth * texelSize, pLevelTexels, size_t(tailWidth) * texelSize);
+    }
+
+    // The tail is laid out the same whether it is measured from level 0 or from its first level.
+    return ltxGenerateMipTail(format, tailWidth, tailHeight, uint8_t(mipLevelsCount - mipTailStart), 0, tailTexels.data(), data, parallel);
+}
+
+}  // namespace Falcor
@@ -0,0 +1,62 @@
+#ifndef SRC_FALCOR_UTILS_IMAGE_LTX_MIPTAIL_H_
+#define SRC_FALCOR_UTILS_IMAGE_LTX_MIPTAIL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <vector>
+
+#include "Falcor/Core/Framework.h"
+#include "Falcor/Core/API/Formats.h"
+
+namespace Falcor {
+
+/** Placement of one mip tail level in the packed mip tail region of an LTX file.
+    Levels follow each other from the first mip tail level down to 1x1, each one starting at a kLtxMipTailAlignment aligned offset.
+    Rows are tightly packed texels, or rows of blocks for compressed formats, which is what a buffer to image copy with a zero row length takes.
+*/
+struct LTX_MipTailLevel {
+    uint8_t  mipLevel = 0;
+    uint32_t width = 0;     ///< Level dimensions in texels, max(dim >> mipLevel, 1)
+    uint32_t height = 0;
+    size_t   offset = 0;    ///< From the start of the mip tail region
+    size_t   rowPitch = 0;
+    size_t   size = 0;
+};
+
+const size_t kLtxMipTailAlignment = 16;
+
+/** Get the layout of the mip tail region, levels mipTailStart to mipLevelsCount - 1.
+    \param[in] format Format the texture is stored in.
+    \param[out] pTotalSize Size of the region in bytes.
+*/
+dlldecl std::vector<LTX_MipTailLevel> ltxGetMipTailLayout(uint32_t width, uint32_t height, uint8_t mipLevelsCount, uint8_t mipTailStart, ResourceFormat format, size_t* pTotalSize = nullptr);
+
+/** Halve an image with a 2x2 box filter. The destination is max(srcWidth >> 1, 1) x max(srcHeight >> 1, 1): odd source dimensions
+    drop the last column or row and a dimension of 1 averages the same texel twice.
+    8-bit unorm values are rounded to nearest, 32-bit uint values too.
+    \param[in] format Texel format, 8-bit unorm, 32-bit uint or 32-bit float with 1 to 4 channels.
+    \param[in] parallel Filter tiles of destination rows on worker threads.
+    \return False if the format is not supported.
+*/
+dlldecl bool ltxDownsample(ResourceFormat format, uint32_t srcWidth, uint32_t srcHeight, const void* pSrc, size_t srcRowPitch, void* pDst, size_t dstRowPitch, bool parallel = true);
+
+/** Generate the packed mip tail region by repeatedly downsampling level 0.
+    \param[in] format Format the texture is stored in. For BC formats the texels are in getBCSourceFormat(format) and the mip tail levels are
+               block compressed, otherwise texels are in format.
+    \param[in] pTexels Level 0 texels, tightly packed.
+    \param[out] data Mip tail region laid out as ltxGetMipTailLayout() returns it. Empty if the texture has no mip tail.
+    \return False if the format is not supported.
+*/
+dlldecl bool ltxGenerateMipTail(ResourceFormat format, uint32_t width, uint32_t height, uint8_t mipLevelsCount, uint8_t mipTailStart, const void* pTexels, std::vector<uint8_t>& data, bool parallel = true);
+
+/** Same result as ltxGenerateMipTail(), without holding level 0 in memory. Level 0 is read in bands of 2^mipTailStart rows, each band
+    is filtered down to one row of the first mip tail level and the rest of the tail is generated from that level.
+    \param[in] readRows Called as readRows(firstRow, rowCount, pTexels) to fill tightly packed level 0 texels. Returns false on error.
+*/
+dlldecl bool ltxGenerateMipTailFromRows(ResourceFormat format, uint32_t width, uint32_t height, uint8_t mipLevelsCount, uint8_t mipTailStart,
+    const std::function<bool(uint32_t firstRow, uint32_t rowCount, void* pTexels)>& readRows, std::vector<uint8_t>& data, bool parallel = true);
+
+}  // namespace Falcor
+
+#endif  // SRC_FALCOR_UTILS_IMAGE_LTX_MIPTAIL_H_
@@ -28,6 +28,8 @@
 #include "Falcor/stdafx.h"
 #include "Logger.h"
 
+#include "lava_utils_lib/logging.h"
+
 namespace Falcor {
     
 namespace {
@@ -38,7 +40,8 @@ Logger::Level sVerbosity = Logger::Level::Warning;
 
 #if _LOG_ENABLED
 bool sInitialized = false;
-FILE* sLogFile = nullptr;
+int sLogSinkID = -1;
+int sStderrSinkID = -1;
 
 std::string generateLogFilePath() {
     // Get current process name
@@ -74,16 +77,28 @@ FILE* openLogFile() {
     return pFile;
 }
 
-void printToLogFile(const std::string& s) {
+lava::ut::log::Severity getLogSeverity(Logger::Level L) {
+    switch (L) {
+        case Logger::Level::Info: return lava::ut::log::Severity::info;
+        case Logger::Level::Warning: return lava::ut::log::Severity::warning;
+        case Logger::Level::Error: return lava::ut::log::Severity::error;
+        default: return lava::ut::log::Severity::fatal;
+    }
+}
+
+// Records go through the shared lava log on the Falcor channel. The log file and, without a debugger, stderr for errors
+// are sinks of that channel only, so Falcor records never reach lava's console. Records are queued and written in
+// batches by the log's writer thread, errors are flushed before log() returns.
+void printToLogFile(Logger::Level L, const std::string& msg) {
     if (!sInitialized) {
-        sLogFile = openLogFile();
+        const uint32_t channels = uint32_t(lava::ut::log::Channel::falcor);
+        FILE* pFile = openLogFile();
+        if (pFile) sLogSinkID = lava::ut::log::add_sink(pFile, true, lava::ut::log::Severity::trace, channels);
+        if (!isDebuggerPresent()) sStderrSinkID = lava::ut::log::add_sink(stderr, false, lava::ut::log::Severity::error, channels);
         sInitialized = true;
     }
 
-    if (sLogFile) {
-        std::fprintf(sLogFile, "%s", s.c_str());
-        std::fflush(sLogFile);
-    }
+    lava::ut::log::submit(getLogSeverity(L), msg, lava::ut::log::Channel::falcor);
 }
 #endif
 
@@ -91,11 +106,15 @@ void printToLogFile(const std::string& s) {
 
 void Logger::shutdown() {
 #if _LOG_ENABLED
-    if(sLogFile) {
-        fclose(sLogFile);
-        sLogFile = nullptr;
-        sInitialized = false;
+    if(sLogSinkID >= 0) {
+        lava::ut::log::remove_sink(sLogSinkID);
+        sLogSinkID = -1;
+    }
+    if(sStderrSinkID >= 0) {
+        lava::ut::log::remove_sink(sStderrSinkID);
+        sStderrSinkID = -1;
     }
+    sInitialized = false;
 #endif
 }
 
@@ -117,15 +136,10 @@ const char* getLogLevelString(Logger::Level L) {
 void Logger::log(Level L, const std::string& msg, MsgBox mbox) {
 #if _LOG_ENABLED
     if(L >= sVerbosity) {
-        std::string s = getLogLevelString(L) + std::string("\t") + msg + "\n";
-        printToLogFile(s);
-        if (isDebuggerPresent()) {   
+        printToLogFile(L, msg);
+        if (isDebuggerPresent()) {
+            std::string s = getLogLevelString(L) + std::string("\t") + msg + "\n";
             printToDebugWindow(s);
-        } else {
-            // Log errors to stderr if no debugger is attached.
-            if (L >= Logger::Level::Error) {
-                std::cerr << s;
-            }
         }
     }
 #endif
@@ -152,7 +166,8 @@ void Logger::log(Level L, const std::string& msg, MsgBox mbox) {
             if (L == Level::Warning) icon = MsgBoxIcon::Warning;
             else if (L >= Level::Error) icon = MsgBoxIcon::Error;
 
-            // Show message box
+            // Show message box, with the log written out in case the user aborts or the process is killed
+            lava::ut::log::flush_log();
             auto result = msgBox(msg, buttons, icon);
             if (result == Debug) debugBreak();
             else if (result == Abort) exit(1);
@@ -168,7 +183,7 @@ void Logger::log(Level L, const std::string& msg, MsgBox mbox) {
 
 bool Logger::setLogFilePath(const std::string& path) {
 #if _LOG_ENABLED
-    if (sLogFile) {
+    if (sLogSinkID >= 0) {
         return false;
     } else {
         sLogFilePath = path;
@@ -0,0 +1,226 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "PMJ02SamplePattern.h"
+
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        // Points are kept in 24-bit fixed point, so they convert to float exactly and never change stratum.
+        const uint32_t kFixedBits = 24;
+
+        uint32_t hash(uint32_t x)
+        {
+            x ^= x >> 16;
+            x *= 0x7feb352du;
+            x ^= x >> 15;
+            x *= 0x846ca68bu;
+            x ^= x >> 16;
+            return x;
+        }
+
+        /** Incremental pmj02 construction.
+            The sequence is extended by doubling. New samples go into the empty sub-quadrants of the cells of older
+            samples, and within those into strata that are still free in all elementary intervals of the new size.
+        */
+        class Builder
+        {
+        public:
+            Builder(uint32_t seed) : mRng(seed) {}
+
+            std::vector<uint2> build(uint32_t count)
+            {
+                mPoints.clear();
+                mPoints.reserve(count);
+                mPoints.push_back(uint2(mRng() >> (32 - kFixedBits), mRng() >> (32 - kFixedBits)));
+
+                uint32_t n = 1;     // The first n * n samples have one sample per cell of an n x n grid.
+                while ((uint32_t)mPoints.size() < count)
+                {
+                    // n^2 -> 2n^2: each new sample goes into the sub-quadrant diagonally opposite an existing one.
+                    const uint32_t N = n * n;
+                    setLevel(2 * N);
+                    for (uint32_t i = 0; i < N; i++)
+                    {
+                        uint2 q = getSubQuadrant(mPoints[i], 2 * n);
+                        place(q.x ^ 1, q.y ^ 1, 2 * n);
+                    }
+                    if ((uint32_t)mPoints.size() >= count) break;
+
+                    // 2n^2 -> 4n^2: each cell has two samples in diagonal sub-quadrants, fill the other two in random order.
+                    setLevel(4 * N);
+                    std::vector<bool> flipX(N);
+                    for (uint32_t i = 0; i < N; i++)
+                    {
+                        uint2 q = getSubQuadrant(mPoints[i], 2 * n);
+                        flipX[i] = (mRng() & 1) != 0;
+                        if (flipX[i]) place(q.x ^ 1, q.y, 2 * n);
+                        else place(q.x, q.y ^ 1, 2 * n);
+                    }
+                    for (uint32_t i = 0; i < N; i++)
+                    {
+                        uint2 q = getSubQuadrant(mPoints[i], 2 * n);
+                        if (flipX[i]) place(q.x, q.y ^ 1, 2 * n);
+                        else place(q.x ^ 1, q.y, 2 * n);
+                    }
+                    n *= 2;
+                }
+                return std::move(mPoints);
+            }
+
+        private:
+            static uint2 getSubQuadrant(const uint2& p, uint32_t gridSize)
+            {
+                uint32_t shift = kFixedBits - bitScanReverse(gridSize);
+                return uint2(p.x >> shift, p.y >> shift);
+            }
+
+            /** Prepare the occupancy of all elementary intervals with sampleCount cells.
+            */
+            void setLevel(uint32_t sampleCount)
+            {
+                mLevel = bitScanReverse(sampleCount);
+                mOccupied.assign(mLevel + 1, std::vector<uint8_t>(sampleCount, 0));
+                for (const auto& p : mPoints) mark(p.x >> (kFixedBits - mLevel), p.y >> (kFixedBits - mLevel));
+            }
+
+            /** Elementary interval k has 2^k columns and 2^(level-k) rows.
+            */
+            uint32_t getCell(uint32_t k, uint32_t x, uint32_t y) const
+            {
+                return ((y >> k) << k) | (x >> (mLevel - k));
+            }
+
+            void mark(uint32_t x, uint32_t y)
+            {
+                for (uint32_t k = 0; k <= mLevel; k++) mOccupied[k][getCell(k, x, y)] = 1;
+            }
+
+            bool isFree(uint32_t x, uint32_t y) const
+            {
+                for (uint32_t k = 1; k < mLevel; k++)
+                {
+                    if (mOccupied[k][getCell(k, x, y)]) return false;
+                }
+                return true;
+            }
+
+            /** Add a sample in sub-quadrant (qx, qy) of a gridSize x gridSize grid.
+            */
+            void place(uint32_t qx, uint32_t qy, uint32_t gridSize)
+            {
+                // Candidate strata at the finest resolution. The 1D strata (k = 0 and k = level) are filtered up front.
+                const uint32_t width = (1u << mLevel) / gridSize;
+                mCandidatesX.clear();
+                mCandidatesY.clear();
+                for (uint32_t i = 0; i < width; i++)
+                {
+                    uint32_t x = qx * width + i, y = qy * width + i;
+                    if (!mOccupied[mLevel][x]) mCandidatesX.push_back(x);
+                    if (!mOccupied[0][y]) mCandidatesY.push_back(y);
+                }
+                std::shuffle(mCandidatesX.begin(), mCandidatesX.end(), mRng);
+                std::shuffle(mCandidatesY.begin(), mCandidatesY.end(), mRng);
+
+                for (uint32_t x : mCandidatesX)
+                {
+                    for (uint32_t y : mCandidatesY)
+                    {
+                        if (isFree(x, y))
+                        {
+                            addPoint(x, y, mLevel);
+                            return;
+                        }
+                    }
+                }
+
+                // Not expected to happen. Keep the sample in its sub-quadrant so the sequence stays usable.
+                addPoint(qx, qy, bitScanReverse(gridSize));
+            }
+
+            /** Add a point jittered within stratum (x, y) at the given level.
+            */
+            void addPoint(uint32_t x, uint32_t y, uint32_t level)
+            {
+                const uint32_t jitterBits = kFixedBits - level;
+                const uint32_t jitterMask = (1u << jitterBits) - 1;
+                uint2 p((x << jitterBits) | (mRng() & jitterMask), (y << jitterBits) | (mRng() & jitterMask));
+                mPoints.push_back(p);
+                mark(p.x >> (kFixedBits - mLevel), p.y >> (kFixedBits - mLevel));
+            }
+
+            std::mt19937 mRng;
+            std::vector<uint2> mPoints;
+            uint32_t mLevel = 0;
+            std::vector<std::vector<uint8_t>> mOccupied;   ///< Per elementary interval shape, one flag per cell.
+            std::vector<uint32_t> mCandidatesX;
+            std::vector<uint32_t> mCandidatesY;
+        };
+    }
+
+    PMJ02SamplePattern::SharedPtr PMJ02SamplePattern::create(uint32_t sampleCount, uint32_t seed)
+    {
+        return SharedPtr(new PMJ02SamplePattern(sampleCount, seed));
+    }
+
+    PMJ02SamplePattern::PMJ02SamplePattern(uint32_t sampleCount, uint32_t seed)
+        : mSampleCount(std::max(1u, sampleCount))
+        , mSeed(seed)
+    {
+        if (mSampleCount > kMaxTableSize) logWarning("PMJ02SamplePattern() builds at most " + std::to_string(kMaxTableSize) + " samples. Later samples repeat them with a random shift.");
+
+        uint32_t tableSize = 1;
+        while (tableSize < std::min(mSampleCount, kMaxTableSize)) tableSize *= 2;
+
+        auto points = Builder(seed).build(tableSize);
+        mSamples.resize(tableSize);
+        for (uint32_t i = 0; i < tableSize; i++)
+        {
+            mSamples[i] = float2(points[i]) * (1.f / (1u << kFixedBits));
+        }
+    }
+
+    float2 PMJ02SamplePattern::getSample(uint32_t index) const
+    {
+        const uint32_t tableSize = (uint32_t)mSamples.size();
+        float2 p = mSamples[index % tableSize];
+
+        // Each round past the table gets its own shift, so it doesn't repeat the same positions.
+        uint32_t round = index / tableSize;
+        if (round > 0)
+        {
+            uint32_t h = hash(mSeed ^ hash(round));
+            float2 shift = float2(h >> 16, h & 0xffff) * (1.f / 65536.f);
+            p = glm::fract(p + shift);
+        }
+        return p - 0.5f;
+    }
+}
@@ -0,0 +1,84 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#ifndef SRC_FALCOR_UTILS_SAMPLEGNERATORS_PMJ02SAMPLEPATTERN_H_
+#define SRC_FALCOR_UTILS_SAMPLEGNERATORS_PMJ02SAMPLEPATTERN_H_
+
+#include "CPUSampleGenerator.h"
+
+namespace Falcor {
+
+/** Progressive multi-jittered (0,2) sample pattern generator.
+
+    Builds a pmj02 sequence (Christensen et al. 2018, "Progressive Multi-Jittered
+    Sample Sequences") at creation time: every prefix of 2^k samples has exactly
+    one sample in each 2D elementary interval of area 2^-k.
+
+    The table holds the sample count rounded up to a power of two, at most
+    kMaxTableSize samples. Sample lookups are O(1) and reset() can resume at any
+    sample. Past the end of the table, each further round repeats the table with
+    a random toroidal shift.
+*/
+class dlldecl PMJ02SamplePattern : public CPUSampleGenerator, public inherit_shared_from_this<CPUSampleGenerator, PMJ02SamplePattern> {
+ public:
+    using SharedPtr = std::shared_ptr<PMJ02SamplePattern>;
+    using inherit_shared_from_this<CPUSampleGenerator, PMJ02SamplePattern>::shared_from_this;
+    virtual ~PMJ02SamplePattern() = default;
+
+    /** Largest table that is built. Generation time grows as O(n^1.5).
+    */
+    static const uint32_t kMaxTableSize = 1u << 14;
+
+    /** Create progressive multi-jittered (0,2) sample pattern generator.
+        \param[in] sampleCount The nominal number of samples.
+        \param[in] seed Random seed. Different seeds give independent sequences.
+        \return New object, or throws an exception on error.
+    */
+    static SharedPtr create(uint32_t sampleCount = 1, uint32_t seed = 0);
+
+    virtual uint32_t getSampleCount() const override { return mSampleCount; }
+    virtual void reset(uint32_t startID = 0) override { mCurSample = startID; }
+    virtual float2 next() override { return getSample(mCurSample++); }
+
+    /** Return the sample at an arbitrary index, in the range [-0.5, 0.5) in each dimension.
+    */
+    float2 getSample(uint32_t index) const;
+
+    uint32_t getTableSize() const { return (uint32_t)mSamples.size(); }
+
+ protected:
+    PMJ02SamplePattern(uint32_t sampleCount, uint32_t seed);
+
+    uint32_t mSampleCount = 0;
+    uint32_t mSeed = 0;
+    uint32_t mCurSample = 0;
+    std::vector<float2> mSamples;   ///< pmj02 points in [0, 1).
+};
+
+}  // namespace Falcor
+
+#endif  // SRC_FALCOR_UTILS_SAMPLEGNERATORS_PMJ02SAMPLEPATTERN_H_
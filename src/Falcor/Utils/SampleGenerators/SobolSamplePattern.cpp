@@ -0,0 +1,107 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "SobolSamplePattern.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        uint32_t reverseBits(uint32_t x)
+        {
+            x = ((x & 0xaaaaaaaau) >> 1) | ((x & 0x55555555u) << 1);
+            x = ((x & 0xccccccccu) >> 2) | ((x & 0x33333333u) << 2);
+            x = ((x & 0xf0f0f0f0u) >> 4) | ((x & 0x0f0f0f0fu) << 4);
+            x = ((x & 0xff00ff00u) >> 8) | ((x & 0x00ff00ffu) << 8);
+            return (x >> 16) | (x << 16);
+        }
+
+        /** Permutation where each bit only depends on the bits below it (Laine and Karras 2011).
+        */
+        uint32_t laineKarrasPermutation(uint32_t x, uint32_t seed)
+        {
+            x += seed;
+            x ^= x * 0x6c50b47cu;
+            x ^= x * 0xb82f1e52u;
+            x ^= x * 0xc7afe638u;
+            x ^= x * 0x8d22f6e6u;
+            return x;
+        }
+
+        /** Owen scrambling of a 32-bit fixed point value: each bit is flipped depending on all bits above it.
+        */
+        uint32_t nestedUniformScramble(uint32_t x, uint32_t seed)
+        {
+            return reverseBits(laineKarrasPermutation(reverseBits(x), seed));
+        }
+
+        uint32_t hashCombine(uint32_t seed, uint32_t v)
+        {
+            return seed ^ (v + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+        }
+
+        /** First two Sobol dimensions as 32-bit fixed point values. Dimension 0 is the van der Corput sequence.
+        */
+        uint2 sobol2D(uint32_t index)
+        {
+            uint32_t x = reverseBits(index);
+            uint32_t y = 0;
+            for (uint32_t v = 1u << 31; index != 0; index >>= 1, v ^= v >> 1)
+            {
+                if (index & 1) y ^= v;
+            }
+            return uint2(x, y);
+        }
+
+        float toUnitFloat(uint32_t x)
+        {
+            // Keep 24 bits so the result is exactly representable and strictly below 1.
+            return (float)(x >> 8) * (1.f / (1u << 24));
+        }
+    }
+
+    SobolSamplePattern::SharedPtr SobolSamplePattern::create(uint32_t sampleCount, uint32_t seed)
+    {
+        return SharedPtr(new SobolSamplePattern(sampleCount, seed));
+    }
+
+    SobolSamplePattern::SobolSamplePattern(uint32_t sampleCount, uint32_t seed)
+        : mSampleCount(std::max(1u, sampleCount))
+        , mSeed(seed)
+    {
+    }
+
+    float2 SobolSamplePattern::getSample(uint32_t index) const
+    {
+        // Scrambling the index shuffles the sequence without breaking the stratification of power-of-two prefixes.
+        uint2 p = sobol2D(nestedUniformScramble(index, mSeed));
+        float x = toUnitFloat(nestedUniformScramble(p.x, hashCombine(mSeed, 0)));
+        float y = toUnitFloat(nestedUniformScramble(p.y, hashCombine(mSeed, 1)));
+        return float2(x, y) - 0.5f;
+    }
+}
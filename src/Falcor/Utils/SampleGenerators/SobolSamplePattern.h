@@ -0,0 +1,77 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#ifndef SRC_FALCOR_UTILS_SAMPLEGNERATORS_SOBOLSAMPLEPATTERN_H_
+#define SRC_FALCOR_UTILS_SAMPLEGNERATORS_SOBOLSAMPLEPATTERN_H_
+
+#include "CPUSampleGenerator.h"
+
+namespace Falcor {
+
+/** Owen-scrambled Sobol sample pattern generator.
+
+    Generates the first two dimensions of the Sobol sequence, randomized with
+    hash-based nested uniform scrambling and shuffled by scrambling the index
+    (Burley 2020, "Practical Hash-based Owen Scrambling").
+
+    Every prefix of 2^k samples is stratified in all 2D elementary intervals
+    of that size, like a pmj02 sequence. Any sample can be computed directly
+    from its index, so the sequence has no length limit and reset() can resume
+    progressive rendering at any sample.
+*/
+class dlldecl SobolSamplePattern : public CPUSampleGenerator, public inherit_shared_from_this<CPUSampleGenerator, SobolSamplePattern> {
+ public:
+    using SharedPtr = std::shared_ptr<SobolSamplePattern>;
+    using inherit_shared_from_this<CPUSampleGenerator, SobolSamplePattern>::shared_from_this;
+    virtual ~SobolSamplePattern() = default;
+
+    /** Create Owen-scrambled Sobol sample pattern generator.
+        \param[in] sampleCount The nominal number of samples. Samples beyond it continue the sequence.
+        \param[in] seed Scrambling seed. Different seeds give independent randomizations.
+        \return New object, or throws an exception on error.
+    */
+    static SharedPtr create(uint32_t sampleCount = 1, uint32_t seed = 0);
+
+    virtual uint32_t getSampleCount() const override { return mSampleCount; }
+    virtual void reset(uint32_t startID = 0) override { mCurSample = startID; }
+    virtual float2 next() override { return getSample(mCurSample++); }
+
+    /** Return the sample at an arbitrary index, in the range [-0.5, 0.5) in each dimension.
+    */
+    float2 getSample(uint32_t index) const;
+
+ protected:
+    SobolSamplePattern(uint32_t sampleCount, uint32_t seed);
+
+    uint32_t mSampleCount = 0;
+    uint32_t mSeed = 0;
+    uint32_t mCurSample = 0;
+};
+
+}  // namespace Falcor
+
+#endif  // SRC_FALCOR_UTILS_SAMPLEGNERATORS_SOBOLSAMPLEPATTERN_H_
@@ -30,6 +30,7 @@
 
 #include "stdafx.h"
 #include "Profiler.h"
+#include "TraceRecorder.h"
 #include "Falcor/Core/API/Device.h"
 #include "Falcor/Core/API/GpuTimer.h"
 
@@ -72,6 +73,8 @@ namespace Falcor {
     }
 
     void Profiler::startEvent(std::shared_ptr<Device> pDevice, const std::string& name, Flags flags, bool showInMsg) {
+        if (is_set(flags, Flags::Internal)) TraceRecorder::beginEvent(name);
+
         if (gProfileEnabled && is_set(flags, Flags::Internal)) {
             curEventName = curEventName + "#" + name;
             EventData* pData = getEvent(pDevice, curEventName);
@@ -123,6 +126,7 @@ namespace Falcor {
             sCurrentLevel--;
             curEventName.erase(curEventName.find_last_of("#"));
         }
+        if (is_set(flags, Flags::Internal)) TraceRecorder::endEvent(name);
         #ifdef _WIN32
         if (is_set(flags, Flags::Pix)) {
             PIXEndEvent((ID3D12GraphicsCommandList*)gpDevice->getRenderContext()->getLowLevelData()->getCommandList());
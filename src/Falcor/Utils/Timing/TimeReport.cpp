@@ -28,6 +28,7 @@
 #include "stdafx.h"
 #include <numeric>
 #include "TimeReport.h"
+#include "TraceRecorder.h"
 #include "Utils/Logger.h"
 #include "Utils/StringUtils.h"
 
@@ -51,6 +52,7 @@ void TimeReport::printToLog() {
 void TimeReport::measure(const std::string& name) {
     auto currentTime = CpuTimer::getCurrentTimePoint();
     std::chrono::duration<double> duration = currentTime - mLastMeasureTime;
+    TraceRecorder::recordComplete(name, mLastMeasureTime, currentTime);
     mLastMeasureTime = currentTime;
     mMeasurements.push_back({name, duration.count()});
 }
@@ -0,0 +1,488 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "TraceRecorder.h"
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#include "Falcor/Core/Platform/OS.h"
+
+namespace Falcor {
+
+std::atomic<bool> TraceRecorder::sEnabled(false);
+
+namespace {
+
+const char kBinaryMagic[4] = { 'F', 'T', 'R', 'C' };
+const uint32_t kBinaryVersion = 1;
+const auto kCollectInterval = std::chrono::milliseconds(10);
+
+struct ThreadState;
+
+/** Single-producer/single-consumer ring buffer owned by one recording thread.
+    Only the owning thread writes events and advances the head; only the collector reads events and advances the tail.
+*/
+struct ThreadBuffer {
+    std::array<TraceRecorder::Event, TraceRecorder::kThreadBufferSize> events;
+    std::atomic<uint64_t> head{ 0 };
+    std::atomic<uint64_t> tail{ 0 };
+    uint32_t threadId = 0;
+    ThreadState* pOwner = nullptr;      ///< Null once the owning thread exited. Guarded by the recorder mutex.
+};
+
+/** Per-thread recording state. The buffer is allocated on the first event and released by stop() or, once drained,
+    after the thread exited.
+*/
+struct ThreadState {
+    std::atomic<bool> writing{ false };             ///< Set while the thread writes to pBuffer, see pushEvent() and stop().
+    std::atomic<ThreadBuffer*> pBuffer{ nullptr };  ///< Owned by RecorderData::threadBuffers.
+    uint32_t threadId = ~0u;
+    std::unordered_map<std::string, uint32_t> nameIds;  ///< Thread-local cache of the global name table.
+
+    ~ThreadState();
+};
+
+struct RecorderData {
+    std::mutex mutex;       ///< Guards all members below.
+    std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+    uint32_t threadCount = 0;   ///< Sequential thread ids handed out so far.
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> nameIds;
+    std::vector<TraceRecorder::Event> events;
+    std::atomic<uint64_t> droppedEventCount{ 0 };
+    CpuTimer::TimePoint epoch = CpuTimer::getCurrentTimePoint();
+
+    std::thread collector;
+    std::condition_variable collectorCondition;
+    bool stopCollector = false;
+
+    ~RecorderData() {
+        if (!collector.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopCollector = true;
+        }
+        collectorCondition.notify_all();
+        collector.join();
+    }
+};
+
+RecorderData& getData() {
+    static RecorderData data;
+    return data;
+}
+
+thread_local ThreadState tlThreadState;
+
+ThreadState::~ThreadState() {
+    // The collector frees the buffer once it drained the remaining events. stop() may release it concurrently, hence the lock.
+    auto& data = getData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    if (ThreadBuffer* pOwned = pBuffer.load(std::memory_order_relaxed)) pOwned->pOwner = nullptr;
+}
+
+/** Allocate the buffer of the calling thread while recording.
+*/
+void allocateThreadBuffer(ThreadState& state) {
+    auto& data = getData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    if (!data.collector.joinable() || state.pBuffer.load(std::memory_order_relaxed)) return;
+
+    if (state.threadId == ~0u) state.threadId = data.threadCount++;
+    data.threadBuffers.push_back(std::make_unique<ThreadBuffer>());
+    ThreadBuffer* pBuffer = data.threadBuffers.back().get();
+    pBuffer->threadId = state.threadId;
+    pBuffer->pOwner = &state;
+    state.pBuffer.store(pBuffer, std::memory_order_relaxed);
+}
+
+uint32_t getNameId(ThreadState& state, const std::string& name) {
+    auto it = state.nameIds.find(name);
+    if (it != state.nameIds.end()) return it->second;
+
+    auto& data = getData();
+    uint32_t nameId;
+    {
+        std::lock_guard<std::mutex> lock(data.mutex);
+        auto globalIt = data.nameIds.find(name);
+        if (globalIt != data.nameIds.end()) {
+            nameId = globalIt->second;
+        } else {
+            nameId = (uint32_t)data.names.size();
+            data.names.push_back(name);
+            data.nameIds[name] = nameId;
+        }
+    }
+    state.nameIds[name] = nameId;
+    return nameId;
+}
+
+uint64_t toTimestamp(CpuTimer::TimePoint time) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time - getData().epoch).count();
+    return ns > 0 ? (uint64_t)ns : 0;
+}
+
+void pushEventToBuffer(ThreadBuffer* pBuffer, uint32_t nameId, TraceRecorder::Phase phase, uint64_t timestamp, uint64_t duration) {
+    uint64_t head = pBuffer->head.load(std::memory_order_relaxed);
+    uint64_t tail = pBuffer->tail.load(std::memory_order_acquire);
+    if (head - tail >= TraceRecorder::kThreadBufferSize) {
+        getData().droppedEventCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TraceRecorder::Event& event = pBuffer->events[head & (TraceRecorder::kThreadBufferSize - 1)];
+    event.timestamp = timestamp;
+    event.duration = duration;
+    event.nameId = nameId;
+    event.threadId = pBuffer->threadId;
+    event.phase = phase;
+    pBuffer->head.store(head + 1, std::memory_order_release);
+
+    // Wake up the collector early when a buffer fills up faster than it is drained.
+    if (head - tail == TraceRecorder::kThreadBufferSize / 2) getData().collectorCondition.notify_one();
+}
+
+void pushEvent(const std::string& name, TraceRecorder::Phase phase, uint64_t timestamp, uint64_t duration) {
+    // Everything that takes the mutex happens before the write is announced, as stop() waits for writers with the mutex held.
+    ThreadState& state = tlThreadState;
+    uint32_t nameId = getNameId(state, name);
+    if (!state.pBuffer.load(std::memory_order_relaxed)) allocateThreadBuffer(state);
+
+    // stop() disables recording before it waits for writers and releases the buffers. Announcing the write before checking
+    // the flag again means either stop() waits for this write or the write sees recording disabled.
+    state.writing.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    ThreadBuffer* pBuffer = state.pBuffer.load(std::memory_order_relaxed);
+    if (TraceRecorder::isEnabled() && pBuffer) pushEventToBuffer(pBuffer, nameId, phase, timestamp, duration);
+    state.writing.store(false, std::memory_order_release);
+}
+
+/** Move all pending events from the thread buffers to the collected event list and free the buffers of exited threads.
+    The caller must hold the mutex.
+*/
+void collectEvents(RecorderData& data) {
+    for (auto& pBuffer : data.threadBuffers) {
+        uint64_t tail = pBuffer->tail.load(std::memory_order_relaxed);
+        uint64_t head = pBuffer->head.load(std::memory_order_acquire);
+        for (uint64_t i = tail; i < head; i++) {
+            data.events.push_back(pBuffer->events[i & (TraceRecorder::kThreadBufferSize - 1)]);
+        }
+        pBuffer->tail.store(head, std::memory_order_release);
+    }
+    data.threadBuffers.erase(std::remove_if(data.threadBuffers.begin(), data.threadBuffers.end(),
+        [](const std::unique_ptr<ThreadBuffer>& pBuffer) { return pBuffer->pOwner == nullptr; }), data.threadBuffers.end());
+}
+
+/** Collect the pending events and free all thread buffers. Recording must be disabled and the caller must hold the mutex.
+*/
+void releaseThreadBuffers(RecorderData& data) {
+    // A thread that announced its write before recording was disabled may still be writing to its buffer.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (auto& pBuffer : data.threadBuffers) {
+        if (!pBuffer->pOwner) continue;
+        while (pBuffer->pOwner->writing.load()) std::this_thread::yield();
+    }
+    collectEvents(data);
+    for (auto& pBuffer : data.threadBuffers) pBuffer->pOwner->pBuffer.store(nullptr, std::memory_order_relaxed);
+    data.threadBuffers.clear();
+}
+
+void collectorLoop() {
+    auto& data = getData();
+    std::unique_lock<std::mutex> lock(data.mutex);
+    while (!data.stopCollector) {
+        data.collectorCondition.wait_for(lock, kCollectInterval);
+        collectEvents(data);
+    }
+}
+
+std::string escapeJson(const std::string& s) {
+    std::string result;
+    result.reserve(s.size());
+    for (char c : s) {
+        switch (c) {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    result += buf;
+                } else {
+                    result += c;
+                }
+        }
+    }
+    return result;
+}
+
+/** Convert nanoseconds to the microseconds used by the Chrome trace format.
+*/
+std::string toMicroseconds(uint64_t ns) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.3f", ns * 1e-3);
+    return buf;
+}
+
+}  // namespace
+
+void TraceRecorder::start() {
+    auto& data = getData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    if (data.collector.joinable()) return;
+
+    data.stopCollector = false;
+    data.collector = std::thread(collectorLoop);
+    sEnabled.store(true);
+}
+
+void TraceRecorder::stop() {
+    auto& data = getData();
+    sEnabled.store(false);
+    {
+        std::lock_guard<std::mutex> lock(data.mutex);
+        if (!data.collector.joinable()) return;
+        data.stopCollector = true;
+    }
+    data.collectorCondition.notify_all();
+    data.collector.join();
+
+    std::lock_guard<std::mutex> lock(data.mutex);
+    if (data.collector.joinable()) {
+        // Restarted in the meantime, the buffers are in use again.
+        collectEvents(data);
+        return;
+    }
+    releaseThreadBuffers(data);
+}
+
+void TraceRecorder::beginEvent(const std::string& name) {
+    if (!isEnabled()) return;
+    pushEvent(name, Phase::Begin, toTimestamp(CpuTimer::getCurrentTimePoint()), 0);
+}
+
+void TraceRecorder::endEvent(const std::string& name) {
+    if (!isEnabled()) return;
+    pushEvent(name, Phase::End, toTimestamp(CpuTimer::getCurrentTimePoint()), 0);
+}
+
+void TraceRecorder::recordComplete(const std::string& name, CpuTimer::TimePoint start, CpuTimer::TimePoint end) {
+    if (!isEnabled()) return;
+    uint64_t startTimestamp = toTimestamp(start);
+    uint64_t endTimestamp = toTimestamp(end);
+    pushEvent(name, Phase::Complete, startTimestamp, endTimestamp > startTimestamp ? endTimestamp - startTimestamp : 0);
+}
+
+void TraceRecorder::recordInstant(const std::string& name) {
+    if (!isEnabled()) return;
+    pushEvent(name, Phase::Instant, toTimestamp(CpuTimer::getCurrentTimePoint()), 0);
+}
+
+std::vector<TraceRecorder::Event> TraceRecorder::getEvents() {
+    auto& data = getData();
+    std::vector<Event> events;
+    {
+        std::lock_guard<std::mutex> lock(data.mutex);
+        collectEvents(data);
+        events = data.events;
+    }
+    // Stable sort keeps Begin/End pairs with equal timestamps in recording order.
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.timestamp < b.timestamp; });
+    return events;
+}
+
+std::string TraceRecorder::getEventName(uint32_t nameId) {
+    auto& data = getData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    return nameId < data.names.size() ? data.names[nameId] : std::string();
+}
+
+uint32_t TraceRecorder::getThreadBufferCount() {
+    auto& data = getData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    return (uint32_t)data.threadBuffers.size();
+}
+
+uint64_t TraceRecorder::getDroppedEventCount() {
+    return getData().droppedEventCount.load(std::memory_order_relaxed);
+}
+
+void TraceRecorder::clear() {
+    auto& data = getData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    collectEvents(data);
+    data.events.clear();
+    data.droppedEventCount.store(0);
+}
+
+bool TraceRecorder::writeChromeTrace(const std::string& filename) {
+    auto events = getEvents();
+
+    std::ofstream out(filename);
+    if (!out) {
+        logError("TraceRecorder: Can't open file '" + filename + "' for writing");
+        return false;
+    }
+
+    std::vector<std::string> names;
+    {
+        auto& data = getData();
+        std::lock_guard<std::mutex> lock(data.mutex);
+        names = data.names;
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"" << escapeJson(getExecutableName()) << "\"}}";
+    for (const auto& event : events) {
+        out << ",\n{\"name\":\"" << escapeJson(names[event.nameId]) << "\",\"ph\":\"" << (char)event.phase << "\",\"pid\":0,\"tid\":" << event.threadId
+            << ",\"ts\":" << toMicroseconds(event.timestamp);
+        if (event.phase == Phase::Complete) out << ",\"dur\":" << toMicroseconds(event.duration);
+        if (event.phase == Phase::Instant) out << ",\"s\":\"t\"";
+        out << "}";
+    }
+    out << "\n],\"otherData\":{\"droppedEvents\":" << getDroppedEventCount() << "}}\n";
+
+    return out.good();
+}
+
+bool TraceRecorder::writeBinary(const std::string& filename) {
+    auto events = getEvents();
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+        logError("TraceRecorder: Can't open file '" + filename + "' for writing");
+        return false;
+    }
+
+    std::vector<std::string> names;
+    {
+        auto& data = getData();
+        std::lock_guard<std::mutex> lock(data.mutex);
+        names = data.names;
+    }
+
+    auto write = [&out](const auto& value) { out.write(reinterpret_cast<const char*>(&value), sizeof(value)); };
+
+    out.write(kBinaryMagic, sizeof(kBinaryMagic));
+    write(kBinaryVersion);
+    write((uint32_t)names.size());
+    for (const auto& name : names) {
+        write((uint32_t)name.size());
+        out.write(name.data(), name.size());
+    }
+    write((uint64_t)events.size());
+    for (const auto& event : events) {
+        write(event.timestamp);
+        write(event.duration);
+        write(event.nameId);
+        write(event.threadId);
+        write((uint8_t)event.phase);
+    }
+
+    return out.good();
+}
+
+bool TraceRecorder::writeMetrics(const std::string& filename) {
+    auto events = getEvents();
+
+    struct Metric {
+        uint64_t count = 0;
+        uint64_t total = 0;
+        uint64_t min = std::numeric_limits<uint64_t>::max();
+        uint64_t max = 0;
+
+        void add(uint64_t duration) {
+            count++;
+            total += duration;
+            min = std::min(min, duration);
+            max = std::max(max, duration);
+        }
+    };
+
+    // Compute durations of Complete events directly, and of Begin/End pairs by matching them per thread.
+    std::vector<Metric> metrics;
+    std::map<std::pair<uint32_t, uint32_t>, std::vector<uint64_t>> openEvents;
+    for (const auto& event : events) {
+        if (event.nameId >= metrics.size()) metrics.resize(event.nameId + 1);
+        switch (event.phase) {
+            case Phase::Complete:
+                metrics[event.nameId].add(event.duration);
+                break;
+            case Phase::Begin:
+                openEvents[{ event.threadId, event.nameId }].push_back(event.timestamp);
+                break;
+            case Phase::End: {
+                auto& stack = openEvents[{ event.threadId, event.nameId }];
+                if (stack.empty()) break;
+                metrics[event.nameId].add(event.timestamp - stack.back());
+                stack.pop_back();
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    std::ofstream out(filename);
+    if (!out) {
+        logError("TraceRecorder: Can't open file '" + filename + "' for writing");
+        return false;
+    }
+
+    out << "{\n";
+    bool first = true;
+    for (uint32_t nameId = 0; nameId < metrics.size(); nameId++) {
+        const auto& m = metrics[nameId];
+        if (m.count == 0) continue;
+        out << (first ? "" : ",\n") << "  \"" << escapeJson(getEventName(nameId)) << "\": {\"count\":" << m.count
+            << ",\"totalMs\":" << m.total * 1e-6 << ",\"meanMs\":" << (m.total * 1e-6) / m.count
+            << ",\"minMs\":" << m.min * 1e-6 << ",\"maxMs\":" << m.max * 1e-6 << "}";
+        first = false;
+    }
+    out << "\n}\n";
+
+    return out.good();
+}
+
+bool TraceRecorder::write(const std::string& filename) {
+    return getExtensionFromFile(filename) == "bin" ? writeBinary(filename) : writeChromeTrace(filename);
+}
+
+}  // namespace Falcor
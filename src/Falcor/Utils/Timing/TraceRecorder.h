@@ -0,0 +1,171 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#ifndef SRC_FALCOR_UTILS_TIMING_TRACERECORDER_H_
+#define SRC_FALCOR_UTILS_TIMING_TRACERECORDER_H_
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "CpuTimer.h"
+
+namespace Falcor {
+
+/** Low-overhead trace recorder.
+    Events are written into lock-free per-thread ring buffers, which are drained by a background collector thread.
+    The collected events can be exported as Chrome trace-event JSON (chrome://tracing, Perfetto), as a compact
+    binary file, or as per-event summary metrics.
+    Recording is disabled by default. When disabled, all record calls return after a single relaxed atomic load.
+*/
+class dlldecl TraceRecorder {
+ public:
+    enum class Phase : uint8_t {
+        Begin = 'B',        ///< Start of a duration event. Must be matched by an End event on the same thread.
+        End = 'E',          ///< End of a duration event.
+        Complete = 'X',     ///< Duration event with known start time and duration.
+        Instant = 'i',      ///< Event without duration.
+    };
+
+    /** Recorded event. Timestamps are in nanoseconds since the recorder was started.
+    */
+    struct Event {
+        uint64_t timestamp = 0;
+        uint64_t duration = 0;      ///< Only valid for Complete events.
+        uint32_t nameId = 0;        ///< See getEventName().
+        uint32_t threadId = 0;      ///< Sequential id of the recording thread.
+        Phase phase = Phase::Instant;
+    };
+
+    /** Number of events each thread can buffer before the collector drains them. Events are dropped when the buffer is full.
+        Buffers are allocated on a thread's first event and freed by stop(), or when the thread exits.
+    */
+    static const uint32_t kThreadBufferSize = 1 << 16;
+
+    /** Enable recording and start the background collector thread.
+    */
+    static void start();
+
+    /** Disable recording, stop the collector thread, collect all pending events and free the thread buffers.
+    */
+    static void stop();
+
+    /** Check if recording is enabled.
+    */
+    static bool isEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+
+    /** Record the start of a duration event on the calling thread.
+    */
+    static void beginEvent(const std::string& name);
+
+    /** Record the end of a duration event on the calling thread.
+    */
+    static void endEvent(const std::string& name);
+
+    /** Record a duration event with known start and end time.
+    */
+    static void recordComplete(const std::string& name, CpuTimer::TimePoint start, CpuTimer::TimePoint end);
+
+    /** Record an instant event.
+    */
+    static void recordInstant(const std::string& name);
+
+    /** Collect all pending events from the thread buffers and return all events collected so far, sorted by timestamp.
+    */
+    static std::vector<Event> getEvents();
+
+    /** Get the name of an event.
+    */
+    static std::string getEventName(uint32_t nameId);
+
+    /** Get the number of thread buffers currently allocated.
+    */
+    static uint32_t getThreadBufferCount();
+
+    /** Get the number of events dropped because a thread buffer was full.
+    */
+    static uint64_t getDroppedEventCount();
+
+    /** Discard all recorded events.
+    */
+    static void clear();
+
+    /** Write the recorded events as Chrome trace-event JSON.
+        \return True if the file was written successfully.
+    */
+    static bool writeChromeTrace(const std::string& filename);
+
+    /** Write the recorded events in the compact binary format.
+        The file starts with the magic "FTRC" and a format version, followed by the event name table and the raw event records.
+        \return True if the file was written successfully.
+    */
+    static bool writeBinary(const std::string& filename);
+
+    /** Write per-event summary metrics (count, total, mean, min and max duration) as JSON.
+        \return True if the file was written successfully.
+    */
+    static bool writeMetrics(const std::string& filename);
+
+    /** Write the recorded events to a file, picking the format from the extension.
+        Files ending in ".bin" use the binary format, all other files are written as Chrome trace JSON.
+        \return True if the file was written successfully.
+    */
+    static bool write(const std::string& filename);
+
+ private:
+    static std::atomic<bool> sEnabled;
+};
+
+/** Helper class recording a Complete event for its lifetime.
+    Use the TRACE_SCOPE macro instead of creating TraceScope objects directly.
+*/
+class TraceScope {
+ public:
+    TraceScope(const std::string& name) : mEnabled(TraceRecorder::isEnabled()) {
+        if (mEnabled) {
+            mName = name;
+            mStart = CpuTimer::getCurrentTimePoint();
+        }
+    }
+
+    ~TraceScope() {
+        if (mEnabled) TraceRecorder::recordComplete(mName, mStart, CpuTimer::getCurrentTimePoint());
+    }
+
+ private:
+    std::string mName;
+    bool mEnabled;
+    CpuTimer::TimePoint mStart;
+};
+
+#define TRACE_SCOPE_CONCAT_IMPL(_a, _b) _a##_b
+#define TRACE_SCOPE_CONCAT(_a, _b) TRACE_SCOPE_CONCAT_IMPL(_a, _b)
+#define TRACE_SCOPE(_name) Falcor::TraceScope TRACE_SCOPE_CONCAT(_traceScope, __LINE__)(_name)
+
+}  // namespace Falcor
+
+#endif  // SRC_FALCOR_UTILS_TIMING_TRACERECORDER_H_
@@ -0,0 +1,361 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "stdafx.h"
+#include "TlsfAllocator.h"
+
+namespace Falcor {
+
+namespace {
+
+uint32_t log2Floor(uint64_t x) {
+    uint32_t hi = uint32_t(x >> 32);
+    return hi ? 32 + bitScanReverse(hi) : bitScanReverse(uint32_t(x));
+}
+
+uint64_t alignUp(uint64_t x, uint64_t alignment) {
+    return (x + alignment - 1) & ~(alignment - 1);
+}
+
+bool isPow2(uint64_t x) {
+    return x && (x & (x - 1)) == 0;
+}
+
+}  // namespace
+
+TlsfAllocator::TlsfAllocator(uint64_t size, uint64_t granularity)
+    : mSize(size & ~(granularity - 1))
+    , mGranularity(granularity) {
+    assert(isPow2(granularity));
+    // Larger ranges would need more first level classes than fit in the bitmap.
+    assert(mSize / mGranularity < (1ull << (kFLCount + kSLLog2 - 1)));
+    mFreeLists.fill(kNoBlock);
+
+    if (mSize > 0) {
+        uint32_t block = createBlock();
+        mBlocks[block].offset = 0;
+        mBlocks[block].size = mSize;
+        insertFreeBlock(block);
+    }
+}
+
+void TlsfAllocator::mapping(uint64_t size, uint32_t& fl, uint32_t& sl) const {
+    uint64_t units = size / mGranularity;
+    if (units < kSLCount) {
+        fl = 0;
+        sl = uint32_t(units);
+    } else {
+        uint32_t msb = log2Floor(units);
+        fl = msb - kSLLog2 + 1;
+        sl = uint32_t(units >> (msb - kSLLog2)) - kSLCount;
+    }
+}
+
+uint32_t TlsfAllocator::findFreeBlock(uint64_t size) const {
+    // Round up to the next class boundary so that any block in the class found is large enough.
+    uint64_t units = size / mGranularity;
+    if (units >= kSLCount) {
+        units += (1ull << (log2Floor(units) - kSLLog2)) - 1;
+    }
+
+    uint32_t fl, sl;
+    mapping(units * mGranularity, fl, sl);
+    if (fl >= kFLCount) return kNoBlock;
+
+    uint32_t slMap = mSLBitmaps[fl] & (~0u << sl);
+    if (slMap == 0) {
+        uint32_t flMap = (fl + 1 < kFLCount) ? mFLBitmap & (~0u << (fl + 1)) : 0;
+        if (flMap == 0) return kNoBlock;
+
+        fl = bitScanForward(flMap);
+        slMap = mSLBitmaps[fl];
+    }
+    sl = bitScanForward(slMap);
+    return mFreeLists[fl * kSLCount + sl];
+}
+
+void TlsfAllocator::insertFreeBlock(uint32_t block) {
+    uint32_t fl, sl;
+    mapping(mBlocks[block].size, fl, sl);
+    uint32_t& head = mFreeLists[fl * kSLCount + sl];
+
+    mBlocks[block].isFree = true;
+    mBlocks[block].prevFree = kNoBlock;
+    mBlocks[block].nextFree = head;
+    if (head != kNoBlock) mBlocks[head].prevFree = block;
+    head = block;
+
+    mFLBitmap |= 1u << fl;
+    mSLBitmaps[fl] |= 1u << sl;
+}
+
+void TlsfAllocator::removeFreeBlock(uint32_t block) {
+    Block& b = mBlocks[block];
+    if (b.prevFree != kNoBlock) mBlocks[b.prevFree].nextFree = b.nextFree;
+    if (b.nextFree != kNoBlock) mBlocks[b.nextFree].prevFree = b.prevFree;
+
+    uint32_t fl, sl;
+    mapping(b.size, fl, sl);
+    uint32_t& head = mFreeLists[fl * kSLCount + sl];
+    if (head == block) {
+        head = b.nextFree;
+        if (head == kNoBlock) {
+            mSLBitmaps[fl] &= ~(1u << sl);
+            if (mSLBitmaps[fl] == 0) mFLBitmap &= ~(1u << fl);
+        }
+    }
+
+    b.isFree = false;
+    b.prevFree = kNoBlock;
+    b.nextFree = kNoBlock;
+}
+
+uint32_t TlsfAllocator::splitBlock(uint32_t block, uint64_t size) {
+    uint32_t rest = createBlock();
+    Block& b = mBlocks[block];
+    Block& r = mBlocks[rest];
+
+    r.offset = b.offset + size;
+    r.size = b.size - size;
+    r.prevPhysical = block;
+    r.nextPhysical = b.nextPhysical;
+    if (b.nextPhysical != kNoBlock) mBlocks[b.nextPhysical].prevPhysical = rest;
+
+    b.size = size;
+    b.nextPhysical = rest;
+    return rest;
+}
+
+void TlsfAllocator::mergeWithNext(uint32_t block) {
+    uint32_t next = mBlocks[block].nextPhysical;
+    Block& b = mBlocks[block];
+    const Block& n = mBlocks[next];
+
+    b.size += n.size;
+    b.nextPhysical = n.nextPhysical;
+    if (n.nextPhysical != kNoBlock) mBlocks[n.nextPhysical].prevPhysical = block;
+    destroyBlock(next);
+}
+
+uint32_t TlsfAllocator::createBlock() {
+    if (!mUnusedBlocks.empty()) {
+        uint32_t block = mUnusedBlocks.back();
+        mUnusedBlocks.pop_back();
+        mBlocks[block] = Block();
+        return block;
+    }
+    mBlocks.emplace_back();
+    return uint32_t(mBlocks.size() - 1);
+}
+
+void TlsfAllocator::destroyBlock(uint32_t block) {
+    mUnusedBlocks.push_back(block);
+}
+
+uint64_t TlsfAllocator::allocate(uint64_t size, uint64_t alignment) {
+    assert(isPow2(alignment));
+    size = alignUp(std::max<uint64_t>(size, 1), mGranularity);
+    alignment = std::max(alignment, mGranularity);
+
+    // Offsets are always granularity aligned, larger alignments need room to skip ahead.
+    uint64_t searchSize = size + alignment - mGranularity;
+    uint32_t block = findFreeBlock(searchSize);
+    if (block == kNoBlock) return kInvalidOffset;
+    removeFreeBlock(block);
+
+    uint64_t padding = alignUp(mBlocks[block].offset, alignment) - mBlocks[block].offset;
+    if (padding > 0) {
+        uint32_t aligned = splitBlock(block, padding);
+        insertFreeBlock(block);
+        block = aligned;
+    }
+    if (mBlocks[block].size > size) {
+        insertFreeBlock(splitBlock(block, size));
+    }
+
+    mUsedSize += mBlocks[block].size;
+    mAllocated[mBlocks[block].offset] = block;
+    return mBlocks[block].offset;
+}
+
+void TlsfAllocator::free(uint64_t offset) {
+    auto it = mAllocated.find(offset);
+    if (it == mAllocated.end()) {
+        assert(false);
+        return;
+    }
+    uint32_t block = it->second;
+    mAllocated.erase(it);
+    mUsedSize -= mBlocks[block].size;
+
+    uint32_t next = mBlocks[block].nextPhysical;
+    if (next != kNoBlock && mBlocks[next].isFree) {
+        removeFreeBlock(next);
+        mergeWithNext(block);
+    }
+    uint32_t prev = mBlocks[block].prevPhysical;
+    if (prev != kNoBlock && mBlocks[prev].isFree) {
+        removeFreeBlock(prev);
+        mergeWithNext(prev);
+        block = prev;
+    }
+    insertFreeBlock(block);
+}
+
+uint64_t TlsfAllocator::getLargestFreeSize() const {
+    if (mFLBitmap == 0) return 0;
+
+    uint32_t fl = bitScanReverse(mFLBitmap);
+    uint32_t sl = bitScanReverse(mSLBitmaps[fl]);
+    uint64_t largest = 0;
+    for (uint32_t block = mFreeLists[fl * kSLCount + sl]; block != kNoBlock; block = mBlocks[block].nextFree) {
+        largest = std::max(largest, mBlocks[block].size);
+    }
+    return largest;
+}
+
+TlsfBlockPool::TlsfBlockPool(const Desc& desc, CreateBlockFunc createBlock, DestroyBlockFunc destroyBlock)
+    : mDesc(desc)
+    , mCreateBlock(std::move(createBlock))
+    , mDestroyBlock(std::move(destroyBlock)) {
+    assert(isPow2(mDesc.granularity));
+    mDesc.blockSize = alignUp(std::max(mDesc.blockSize, mDesc.granularity), mDesc.granularity);
+}
+
+uint32_t TlsfBlockPool::addBlock(uint64_t size) {
+    uint32_t blockID = 0;
+    while (blockID < mBlocks.size() && mBlocks[blockID]) blockID++;
+    if (blockID == mBlocks.size()) mBlocks.emplace_back();
+
+    mBlocks[blockID] = std::make_unique<Block>(size, mDesc.granularity);
+    mCreateBlock(blockID, size);
+    mBlocksCreated++;
+    return blockID;
+}
+
+TlsfBlockPool::Allocation TlsfBlockPool::allocate(uint64_t size, uint64_t alignment) {
+    uint64_t required = alignUp(std::max<uint64_t>(size, 1), mDesc.granularity) + std::max(alignment, mDesc.granularity) - mDesc.granularity;
+    bool dedicated = required > mDesc.blockSize;
+
+    // Regular requests only use regular blocks and large ones only dedicated blocks, so a pooled dedicated block
+    // isn't fragmented by small allocations. Dedicated blocks are tried from smallest to largest.
+    std::vector<uint32_t> candidates;
+    for (uint32_t i = 0; i < (uint32_t)mBlocks.size(); i++) {
+        if (mBlocks[i] && (mBlocks[i]->allocator.getSize() > mDesc.blockSize) == dedicated) candidates.push_back(i);
+    }
+    if (dedicated) {
+        std::stable_sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b) {
+            return mBlocks[a]->allocator.getSize() < mBlocks[b]->allocator.getSize();
+        });
+    }
+
+    Allocation allocation;
+    for (uint32_t blockID : candidates) {
+        uint64_t offset = mBlocks[blockID]->allocator.allocate(size, alignment);
+        if (offset != TlsfAllocator::kInvalidOffset) {
+            allocation.blockID = blockID;
+            allocation.offset = offset;
+            return allocation;
+        }
+    }
+
+    // Round dedicated blocks up to a power of two, so requests of a similar size can reuse them.
+    uint64_t blockSize = mDesc.blockSize;
+    if (dedicated) {
+        blockSize = 1ull << log2Floor(required);
+        if (blockSize < required) blockSize <<= 1;
+    }
+
+    uint32_t blockID = addBlock(blockSize);
+    allocation.offset = mBlocks[blockID]->allocator.allocate(size, alignment);
+    assert(allocation.offset != TlsfAllocator::kInvalidOffset);
+    allocation.blockID = blockID;
+    return allocation;
+}
+
+void TlsfBlockPool::release(const Allocation& allocation, uint64_t fenceValue) {
+    assert(allocation.blockID < mBlocks.size() && mBlocks[allocation.blockID]);
+    assert(mDeferredReleases.empty() || mDeferredReleases.back().fenceValue <= fenceValue);
+    mDeferredReleases.push({ fenceValue, allocation });
+}
+
+void TlsfBlockPool::executeDeferredReleases(uint64_t completedFenceValue) {
+    bool freed = false;
+    while (!mDeferredReleases.empty() && mDeferredReleases.front().fenceValue <= completedFenceValue) {
+        const auto& release = mDeferredReleases.front();
+        auto& pBlock = mBlocks[release.allocation.blockID];
+        pBlock->allocator.free(release.allocation.offset);
+        pBlock->lastUseFenceValue = release.fenceValue;
+        mDeferredReleases.pop();
+        freed = true;
+    }
+    if (freed) trimIdleBlocks();
+}
+
+void TlsfBlockPool::trimIdleBlocks() {
+    std::vector<uint32_t> idle;
+    uint64_t idleSize = 0;
+    for (uint32_t i = 0; i < (uint32_t)mBlocks.size(); i++) {
+        if (mBlocks[i] && mBlocks[i]->allocator.isEmpty()) {
+            idle.push_back(i);
+            idleSize += mBlocks[i]->allocator.getSize();
+        }
+    }
+    if (idleSize <= mDesc.maxIdleSize) return;
+
+    std::sort(idle.begin(), idle.end(), [this](uint32_t a, uint32_t b) {
+        return mBlocks[a]->lastUseFenceValue < mBlocks[b]->lastUseFenceValue;
+    });
+    for (uint32_t blockID : idle) {
+        if (idleSize <= mDesc.maxIdleSize) break;
+        idleSize -= mBlocks[blockID]->allocator.getSize();
+        mBlocks[blockID].reset();
+        mDestroyBlock(blockID);
+        mBlocksDestroyed++;
+    }
+}
+
+uint64_t TlsfBlockPool::getBlockSize(uint32_t blockID) const {
+    return (blockID < mBlocks.size() && mBlocks[blockID]) ? mBlocks[blockID]->allocator.getSize() : 0;
+}
+
+TlsfBlockPool::Stats TlsfBlockPool::getStats() const {
+    Stats stats;
+    for (const auto& pBlock : mBlocks) {
+        if (!pBlock) continue;
+        stats.blockCount++;
+        if (pBlock->allocator.isEmpty()) stats.idleBlockCount++;
+        stats.allocationCount += pBlock->allocator.getAllocationCount();
+        stats.reservedSize += pBlock->allocator.getSize();
+        stats.usedSize += pBlock->allocator.getUsedSize();
+    }
+    stats.blocksCreated = mBlocksCreated;
+    stats.blocksDestroyed = mBlocksDestroyed;
+    return stats;
+}
+
+}  // namespace Falcor
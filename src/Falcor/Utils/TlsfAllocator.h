@@ -0,0 +1,204 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#ifndef SRC_FALCOR_UTILS_TLSFALLOCATOR_H_
+#define SRC_FALCOR_UTILS_TLSFALLOCATOR_H_
+
+#include <stdint.h>
+#include <array>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "Falcor/Core/Framework.h"
+
+namespace Falcor {
+
+/** Two-level segregated fit (TLSF) sub-allocator over a single range of memory.
+    Only offsets are handed out, the memory itself lives elsewhere. Allocation is O(1): free ranges are kept in
+    power-of-two classes split into 16 linear sub-classes, and neighbouring free ranges are merged on free. Free is O(1)
+    apart from looking the offset up in a hash map.
+*/
+class dlldecl TlsfAllocator {
+ public:
+    static const uint64_t kInvalidOffset = ~0ull;
+
+    /** Create an allocator.
+        \param[in] size Size of the range in bytes. Rounded down to the granularity.
+        \param[in] granularity Smallest unit handed out, a power of two. Every offset is aligned to it.
+    */
+    TlsfAllocator(uint64_t size, uint64_t granularity = 256);
+
+    /** Allocate a range.
+        \param[in] size Size in bytes.
+        \param[in] alignment Alignment of the returned offset, a power of two.
+        \return Offset of the range, or kInvalidOffset if there is no free range large enough.
+    */
+    uint64_t allocate(uint64_t size, uint64_t alignment = 1);
+
+    /** Free a range returned by allocate().
+    */
+    void free(uint64_t offset);
+
+    uint64_t getSize() const { return mSize; }
+    uint64_t getUsedSize() const { return mUsedSize; }
+    uint32_t getAllocationCount() const { return (uint32_t)mAllocated.size(); }
+    bool isEmpty() const { return mAllocated.empty(); }
+
+    /** Size of the largest free range, for statistics. Not O(1).
+    */
+    uint64_t getLargestFreeSize() const;
+
+ private:
+    static const uint32_t kSLLog2 = 4;
+    static const uint32_t kSLCount = 1 << kSLLog2;
+    static const uint32_t kFLCount = 32;
+    static const uint32_t kNoBlock = ~0u;
+
+    struct Block {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint32_t prevPhysical = kNoBlock;
+        uint32_t nextPhysical = kNoBlock;
+        uint32_t prevFree = kNoBlock;
+        uint32_t nextFree = kNoBlock;
+        bool isFree = false;
+    };
+
+    void mapping(uint64_t size, uint32_t& fl, uint32_t& sl) const;
+    uint32_t findFreeBlock(uint64_t size) const;
+    void insertFreeBlock(uint32_t block);
+    void removeFreeBlock(uint32_t block);
+    uint32_t splitBlock(uint32_t block, uint64_t size);
+    void mergeWithNext(uint32_t block);
+    uint32_t createBlock();
+    void destroyBlock(uint32_t block);
+
+    uint64_t mSize;
+    uint64_t mGranularity;
+    uint64_t mUsedSize = 0;
+
+    std::vector<Block> mBlocks;
+    std::vector<uint32_t> mUnusedBlocks;
+    std::unordered_map<uint64_t, uint32_t> mAllocated;   // Offset -> block.
+
+    uint32_t mFLBitmap = 0;
+    std::array<uint32_t, kFLCount> mSLBitmaps = {};
+    std::array<uint32_t, kFLCount * kSLCount> mFreeLists;
+};
+
+/** Pool of TLSF-managed blocks with fence-based reclamation, for allocations too large for a paged heap.
+    The pool only tracks offsets; the owner creates and destroys the memory behind each block in the callbacks.
+    Blocks have a fixed size, larger requests get a dedicated block rounded up to a power of two which, once free,
+    is only reused by other large requests. Empty blocks stay in the pool until the idle size exceeds the budget,
+    then the least recently used ones are destroyed.
+    Only the sub-allocation inside a block is O(1). allocate() tries the blocks of the request's kind one after the other
+    and trimming scans all blocks, both linear in the block count, which stays small since blocks are large.
+*/
+class dlldecl TlsfBlockPool {
+ public:
+    static const uint32_t kInvalidBlock = ~0u;
+
+    struct Desc {
+        uint64_t blockSize = 32 * 1024 * 1024;      ///< Size of regular blocks.
+        uint64_t maxIdleSize = 128 * 1024 * 1024;   ///< Total size of empty blocks kept for reuse.
+        uint64_t granularity = 256;                 ///< Allocation granularity, see TlsfAllocator.
+    };
+
+    struct Allocation {
+        uint32_t blockID = kInvalidBlock;
+        uint64_t offset = 0;
+    };
+
+    struct Stats {
+        uint32_t blockCount = 0;
+        uint32_t idleBlockCount = 0;
+        uint32_t allocationCount = 0;
+        uint64_t reservedSize = 0;
+        uint64_t usedSize = 0;
+        uint64_t blocksCreated = 0;
+        uint64_t blocksDestroyed = 0;
+    };
+
+    using CreateBlockFunc = std::function<void(uint32_t blockID, uint64_t size)>;
+    using DestroyBlockFunc = std::function<void(uint32_t blockID)>;
+
+    /** Create a pool.
+        \param[in] desc Pool parameters.
+        \param[in] createBlock Called when a block is added. Block IDs are small and reused after destruction.
+        \param[in] destroyBlock Called when an empty block is trimmed. Not called when the pool is destroyed.
+    */
+    TlsfBlockPool(const Desc& desc, CreateBlockFunc createBlock, DestroyBlockFunc destroyBlock);
+
+    /** Allocate from a block of the request's size class that has room, adding a block if none has.
+        Linear in the number of blocks.
+    */
+    Allocation allocate(uint64_t size, uint64_t alignment = 1);
+
+    /** Queue an allocation to be freed once the fence reaches fenceValue.
+    */
+    void release(const Allocation& allocation, uint64_t fenceValue);
+
+    /** Free the allocations whose fence value was reached and trim idle blocks.
+        \param[in] completedFenceValue Last fence value the GPU has completed.
+    */
+    void executeDeferredReleases(uint64_t completedFenceValue);
+
+    uint64_t getBlockSize(uint32_t blockID) const;
+    Stats getStats() const;
+
+ private:
+    struct Block {
+        TlsfAllocator allocator;
+        uint64_t lastUseFenceValue = 0;   ///< Fence value of the last release, orders idle blocks for trimming.
+
+        Block(uint64_t size, uint64_t granularity) : allocator(size, granularity) {}
+    };
+
+    struct DeferredRelease {
+        uint64_t fenceValue;
+        Allocation allocation;
+    };
+
+    uint32_t addBlock(uint64_t size);
+    void trimIdleBlocks();
+
+    Desc mDesc;
+    CreateBlockFunc mCreateBlock;
+    DestroyBlockFunc mDestroyBlock;
+
+    std::vector<std::unique_ptr<Block>> mBlocks;   // Indexed by block ID, null for unused IDs.
+    std::queue<DeferredRelease> mDeferredReleases;
+    uint64_t mBlocksCreated = 0;
+    uint64_t mBlocksDestroyed = 0;
+};
+
+}  // namespace Falcor
+
+#endif  // SRC_FALCOR_UTILS_TLSFALLOCATOR_H_
@@ -299,6 +299,11 @@ namespace Falcor
         {
             return error(mFilename, "Failed to allocate SWScale context");
         }
+
+        if(desc.queueDepth > 0 && startWorkers(desc.queueDepth) == false)
+        {
+            return error(mFilename, "Failed to allocate the video frame queue");
+        }
         return true;
     }
 
@@ -335,8 +340,71 @@ namespace Falcor
         }
     }
 
+    bool VideoEncoder::startWorkers(uint32_t queueDepth)
+    {
+        mpRawFrames = std::make_unique<BoundedQueue<std::vector<uint8_t>>>(queueDepth);
+        mpEncodeFrames = std::make_unique<BoundedQueue<AVFrame*>>(queueDepth);
+        mpFreeFrames = std::make_unique<BoundedQueue<AVFrame*>>(queueDepth);
+        for(uint32_t i = 0; i < queueDepth; i++)
+        {
+            AVFrame* pFrame = allocateFrame(mpCodecContext->pix_fmt, mpCodecContext->width, mpCodecContext->height, mFilename);
+            if(pFrame == nullptr)
+            {
+                return false;
+            }
+            mFramePool.push_back(pFrame);
+            mpFreeFrames->push(pFrame);
+        }
+
+        // Color conversion and encoding each get a thread, so a frame can be converted while the previous one is encoded.
+        mConvertThread = std::thread([this]()
+        {
+            std::vector<uint8_t> data;
+            AVFrame* pFrame = nullptr;
+            while(mpRawFrames->pop(data) && mpFreeFrames->pop(pFrame))
+            {
+                convertFrame(data.data(), pFrame);
+                mpEncodeFrames->push(pFrame);
+            }
+            mpEncodeFrames->close();
+        });
+
+        mEncodeThread = std::thread([this]()
+        {
+            AVFrame* pFrame = nullptr;
+            while(mpEncodeFrames->pop(pFrame))
+            {
+                encodeFrame(pFrame);
+                mpFreeFrames->push(pFrame);
+            }
+        });
+        return true;
+    }
+
+    void VideoEncoder::stopWorkers()
+    {
+        if(mpRawFrames == nullptr)
+        {
+            return;
+        }
+
+        // Closing the input lets the convert thread drain it, which in turn closes the encode queue once done.
+        mpRawFrames->close();
+        if(mConvertThread.joinable()) mConvertThread.join();
+        mpEncodeFrames->close();
+        if(mEncodeThread.joinable()) mEncodeThread.join();
+
+        for(auto& pFrame : mFramePool) av_frame_free(&pFrame);
+        mFramePool.clear();
+        mpRawFrames = nullptr;
+        mpEncodeFrames = nullptr;
+        mpFreeFrames = nullptr;
+    }
+
     void VideoEncoder::endCapture()
     {
+        stopWorkers();
+
         if(mpOutputContext)
         {
             // Flush the codex
@@ -357,6 +425,32 @@ namespace Falcor
     }
 
     void VideoEncoder::appendFrame(const void* pData)
+    {
+        if(mpRawFrames)
+        {
+            const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(pData);
+            appendFrame(std::vector<uint8_t>(pBytes, pBytes + mpCodecContext->height * mRowPitch));
+            return;
+        }
+
+        convertFrame(pData, mpFrame);
+        encodeFrame(mpFrame);
+    }
+
+    void VideoEncoder::appendFrame(std::vector<uint8_t>&& data)
+    {
+        assert(data.size() >= mpCodecContext->height * mRowPitch);
+        if(mpRawFrames == nullptr)
+        {
+            appendFrame(data.data());
+            return;
+        }
+
+        // Blocks while the queue is full, which throttles the caller to the encoder's speed.
+        mpRawFrames->push(std::move(data));
+    }
+
+    void VideoEncoder::convertFrame(const void* pData, AVFrame* pFrame)
     {
         if(mpFlippedImage)
         {
@@ -371,29 +465,42 @@ namespace Falcor
             pData = mpFlippedImage;
         }
 
+        // The codec may still reference the frame buffers of an earlier frame.
+        if(av_frame_make_writable(pFrame) < 0)
+        {
+            error(mFilename, "Can't make video frame writable");
+            return;
+        }
+
         uint8_t* src[AV_NUM_DATA_POINTERS] = {0};
         int32_t rowPitch[AV_NUM_DATA_POINTERS] = {0};
         src[0] = (uint8_t*)pData;
         rowPitch[0] = (int32_t)mRowPitch;
 
         // Scale and convert the image
-        sws_scale(mpSwsContext, src, rowPitch, 0, mpCodecContext->height, mpFrame->data, mpFrame->linesize);
+        sws_scale(mpSwsContext, src, rowPitch, 0, mpCodecContext->height, pFrame->data, pFrame->linesize);
+        pFrame->pts = mNextPts++;
+    }
 
-        // Encode the frame
-        int r = avcodec_send_frame(mpCodecContext, mpFrame);
-        mpFrame->pts++;
+    void VideoEncoder::encodeFrame(AVFrame* pFrame)
+    {
+        // Encode the frame. If the codec is full, write out its pending packets and try again.
+        int r = avcodec_send_frame(mpCodecContext, pFrame);
         if(r == AVERROR(EAGAIN))
         {
             if(flush(mpCodecContext, mpOutputContext, mpOutputStream, mFilename) == false)
             {
                 return;
             }
+            r = avcodec_send_frame(mpCodecContext, pFrame);
         }
-        else if(r < 0)
+
+        if(r < 0)
         {
             error(mFilename, "Can't send video frame");
             return;
         }
+        flush(mpCodecContext, mpOutputContext, mpOutputStream, mFilename);
     }
 
     FileDialogFilterVec VideoEncoder::getSupportedContainerForCodec(Codec codec)
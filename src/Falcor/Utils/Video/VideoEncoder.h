@@ -26,6 +26,8 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #pragma once
+#include <thread>
+#include "Utils/BoundedQueue.h"
 
 struct AVFormatContext;
 struct AVStream;
@@ -61,6 +63,7 @@ namespace Falcor
             ResourceFormat format = ResourceFormat::BGRA8UnormSrgb;
             bool flipY = false;
             std::string filename;
+            uint32_t queueDepth = 0;    ///< Frames buffered between appendFrame() and the encoder. 0 converts and encodes on the calling thread.
         };
 
         ~VideoEncoder();
@@ -71,7 +74,17 @@ namespace Falcor
         */
         static UniquePtr create(const Desc& desc);
 
+        /** Append a frame of desc.width x desc.height pixels in desc.format.
+            With a queue the data is copied and the call only blocks while the queue is full.
+        */
         void appendFrame(const void* pData);
+
+        /** Same as above, taking ownership of the data so queued frames don't need a copy.
+        */
+        void appendFrame(std::vector<uint8_t>&& data);
+
+        /** Encode all queued frames and close the file.
+        */
         void endCapture();
 
         static bool isFormatSupported(ResourceFormat format);
@@ -80,6 +93,10 @@ namespace Falcor
     private:
         VideoEncoder(const std::string& filename);
         bool init(const Desc& desc);
+        bool startWorkers(uint32_t queueDepth);
+        void stopWorkers();
+        void convertFrame(const void* pData, AVFrame* pFrame);
+        void encodeFrame(AVFrame* pFrame);
 
         AVFormatContext* mpOutputContext = nullptr;
         AVStream*        mpOutputStream  = nullptr;
@@ -91,6 +108,16 @@ namespace Falcor
         ResourceFormat mFormat;
         uint32_t mRowPitch = 0;
         uint8_t* mpFlippedImage = nullptr; // Used in case the image memory layout if bottom->top
+        int64_t mNextPts = 0;
+
+        // Asynchronous pipeline: appendFrame() -> mRawFrames -> convert thread -> mEncodeFrames -> encode thread.
+        // Converted frames come from a fixed pool, so a slow encoder eventually blocks appendFrame().
+        std::unique_ptr<BoundedQueue<std::vector<uint8_t>>> mpRawFrames;
+        std::unique_ptr<BoundedQueue<AVFrame*>> mpEncodeFrames;
+        std::unique_ptr<BoundedQueue<AVFrame*>> mpFreeFrames;
+        std::vector<AVFrame*> mFramePool;
+        std::thread mConvertThread;
+        std::thread mEncodeThread;
     };
 
     inline std::string to_string(VideoEncoder::Codec c)
@@ -43,6 +43,9 @@ const std::string kAddRanges = "addRanges";
 const std::string kPrint = "print";
 const std::string kOutputs = "outputs";
 
+// Frames buffered between the render thread and the encoder threads.
+const uint32_t kEncodeQueueDepth = 4;
+
 Texture::SharedPtr createTextureForBlit(std::shared_ptr<Falcor::Device> pDevice, const Texture* pSource) {
     assert(pSource->getType() == Texture::Type::Texture2D);
     return Texture::create2D(pDevice, pSource->getWidth(), pSource->getHeight(), ResourceFormat::RGBA8UnormSrgb, 1, 1, nullptr, Texture::BindFlags::RenderTarget);
@@ -75,6 +78,7 @@ Texture::SharedPtr createTextureForBlit(std::shared_ptr<Falcor::Device> pDevice,
         d.codec = mpEncoderUI->getCodec();
         d.fps = mpEncoderUI->getFPS();
         d.gopSize = mpEncoderUI->getGopSize();
+        d.queueDepth = kEncodeQueueDepth;
 
         for (uint32_t i = 0 ; i < pGraph->getOutputCount() ; i++) {
             const auto& outputName = pGraph->getOutputName(i);
@@ -99,23 +103,34 @@ Texture::SharedPtr createTextureForBlit(std::shared_ptr<Falcor::Device> pDevice,
             d.filename = getOutputNamePrefix(outputName) + to_string(r.first) + "." + to_string(r.second) + "." + VideoEncoder::getSupportedContainerForCodec(d.codec)[0].ext;
             encoder.output = outputName;
             encoder.pEncoder = VideoEncoder::create(d);
+            if (!encoder.pEncoder) continue;
             mEncoders.push_back(std::move(encoder));
         }
     }
 
     void VideoCapture::endRange(RenderGraph* pGraph, const Range& r) {
-        for (const auto& e : mEncoders) e.pEncoder->endCapture();
+        // Hand over the last readback and wait for the encoders to drain their queues.
+        for (auto& e : mEncoders) {
+            if (e.pPendingRead) e.pEncoder->appendFrame(e.pPendingRead->getData());
+            e.pPendingRead = nullptr;
+            e.pEncoder->endCapture();
+        }
+        mEncoders.clear();
     }
 
     void VideoCapture::triggerFrame(RenderContext* pCtx, RenderGraph* pGraph, uint64_t frameID) {
-        for (const auto& e : mEncoders) {
+        for (auto& e : mEncoders) {
             Texture::SharedPtr pTex = std::dynamic_pointer_cast<Texture>(pGraph->getOutput(e.output));
             if (e.pBlitTex) {
                 pCtx->blit(pTex->getSRV(0, 1, 0, 1), e.pBlitTex->getRTV(0, 0, 1));
                 pTex = e.pBlitTex;
             }
 
-            e.pEncoder->appendFrame(pCtx->readTextureSubresource(pTex.get(), 0).data());
+            // Double-buffered readback: start copying this frame, then pass the previous one on. Its copy was submitted
+            // a frame ago, so waiting for it rarely stalls. The encoder converts and encodes on its own threads.
+            auto pRead = pCtx->asyncReadTextureSubresource(pTex.get(), 0);
+            if (e.pPendingRead) e.pEncoder->appendFrame(e.pPendingRead->getData());
+            e.pPendingRead = pRead;
         }
     }
 
@@ -59,6 +59,7 @@ namespace Mogwai
             std::string output;
             VideoEncoder::UniquePtr pEncoder;
             Texture::SharedPtr pBlitTex;
+            CopyContext::ReadTextureTask::SharedPtr pPendingRead;   ///< Readback of the previous frame, handed to the encoder one frame late.
         };
         std::vector<EncodeData> mEncoders;
     };
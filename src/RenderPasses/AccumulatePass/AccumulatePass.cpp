@@ -37,6 +37,8 @@ extern "C" falcorexport const char* getProjDir() {
 static void regAccumulatePass(pybind11::module& m) {
     pybind11::class_<AccumulatePass, RenderPass, AccumulatePass::SharedPtr> pass(m, "AccumulatePass");
     pass.def("reset", &AccumulatePass::reset);
+    pass.def("setAdaptiveSampling", &AccumulatePass::setAdaptiveSampling, "threshold"_a, "minSamples"_a = 16);
+    pass.def("isConverged", &AccumulatePass::isConverged);
 
     pybind11::enum_<AccumulatePass::Precision> precision(m, "AccumulatePrecision");
     precision.value("Double", AccumulatePass::Precision::Double);
@@ -61,6 +63,8 @@ const char kEnableAccumulation[] = "enableAccumulation";
 const char kAutoReset[] = "autoReset";
 const char kPrecisionMode[] = "precisionMode";
 const char kSubFrameCount[] = "subFrameCount";
+const char kAdaptiveThreshold[] = "adaptiveThreshold";
+const char kAdaptiveMinSamples[] = "adaptiveMinSamples";
 
 const Gui::DropdownList kModeSelectorList =
 {
@@ -83,6 +87,8 @@ AccumulatePass::AccumulatePass(Device::SharedPtr pDevice, const Dictionary& dict
         else if (key == kAutoReset) mAutoReset = value;
         else if (key == kPrecisionMode) mPrecisionMode = value;
         else if (key == kSubFrameCount) mSubFrameCount = value;
+        else if (key == kAdaptiveThreshold) mAdaptiveThreshold = value;
+        else if (key == kAdaptiveMinSamples) mAdaptiveMinSamples = value;
         else logWarning("Unknown field '" + key + "' in AccumulatePass dictionary");
     }
 
@@ -93,6 +99,9 @@ AccumulatePass::AccumulatePass(Device::SharedPtr pDevice, const Dictionary& dict
     mpProgram[Precision::SingleCompensated] = ComputeProgram::createFromFile(pDevice, kShaderFile, "accumulateSingleCompensated", Program::DefineList(), Shader::CompilerFlags::FloatingPointModePrecise | Shader::CompilerFlags::TreatWarningsAsErrors);
     mpVars = ComputeVars::create(pDevice, mpProgram[Precision::Single]->getReflector());
 
+    mpTileErrorProgram = ComputeProgram::createFromFile(pDevice, kShaderFile, "computeTileError", Program::DefineList(), Shader::CompilerFlags::TreatWarningsAsErrors);
+    mpTileErrorVars = ComputeVars::create(pDevice, mpTileErrorProgram->getReflector());
+
     mpState = ComputeState::create(pDevice);
 }
 
@@ -102,6 +111,8 @@ Dictionary AccumulatePass::getScriptingDictionary() {
     dict[kAutoReset] = mAutoReset;
     dict[kPrecisionMode] = mPrecisionMode;
     dict[kSubFrameCount] = mSubFrameCount;
+    dict[kAdaptiveThreshold] = mAdaptiveThreshold;
+    dict[kAdaptiveMinSamples] = mAdaptiveMinSamples;
     return dict;
 }
 
@@ -127,6 +138,15 @@ void AccumulatePass::enableAccumulation(bool enable) {
     mEnableAccumulation = enable;
 }
 
+void AccumulatePass::setAdaptiveSampling(float threshold, uint32_t minSamples) {
+    threshold = std::max(0.f, threshold);
+    if (threshold == mAdaptiveThreshold && minSamples == mAdaptiveMinSamples) return;
+
+    mAdaptiveThreshold = threshold;
+    mAdaptiveMinSamples = minSamples;
+    reset();
+}
+
 void AccumulatePass::execute(RenderContext* pRenderContext, const RenderData& renderData) {
     if (mAutoReset) {
         if (mSubFrameCount > 0) // Option to accumulate N frames. Works also for motion blur. Overrides logic for automatic reset on scene changes.
@@ -179,10 +199,17 @@ void AccumulatePass::execute(RenderContext* pRenderContext, const RenderData& re
 
     // Setup accumulation.
     prepareAccumulation(pRenderContext, resolution.x, resolution.y);
+    prepareAdaptiveSampling(pRenderContext, resolution.x, resolution.y);
+
+    // Once all tiles converged, every pixel drops its sample and the dispatch only resolves the accumulated average into the output,
+    // which may have been reallocated or overwritten since. The frame count and tile estimates stay frozen.
+    const bool converged = mTileScheduler.isConverged();
 
     // Set shader parameters.
     mpVars["PerFrameCB"]["gResolution"] = resolution;
-    mpVars["PerFrameCB"]["gAccumCount"] = mFrameCount++;
+    mpVars["PerFrameCB"]["gAccumCount"] = converged ? mFrameCount : mFrameCount++;
+    mpVars["PerFrameCB"]["gAdaptive"] = mTileScheduler.isEnabled();
+    mpVars["PerFrameCB"]["gTileCountX"] = mTileScheduler.getTileCountX();
     mpVars["gCurFrame"] = pSrc;
     mpVars["gOutputFrame"] = pDst;
 
@@ -191,6 +218,8 @@ void AccumulatePass::execute(RenderContext* pRenderContext, const RenderData& re
     mpVars["gLastFrameCorr"] = mpLastFrameCorr;
     mpVars["gLastFrameSumLo"] = mpLastFrameSumLo;
     mpVars["gLastFrameSumHi"] = mpLastFrameSumHi;
+    mpVars["gLumStats"] = mpLumStats;
+    mpVars["gTileActive"] = mpTileActive;
 
     // Run the accumulation program.
     auto pProgram = mpProgram[mPrecisionMode];
@@ -200,6 +229,32 @@ void AccumulatePass::execute(RenderContext* pRenderContext, const RenderData& re
 
     pRenderContext->dispatch(mpState.get(), mpVars.get(), numGroups);
 
+    if (!converged && mTileScheduler.shouldEstimate(mFrameCount)) updateActiveTiles(pRenderContext, resolution);
+}
+
+void AccumulatePass::updateActiveTiles(RenderContext* pRenderContext, const uint2& resolution) {
+    mpTileErrorVars["PerFrameCB"]["gResolution"] = resolution;
+    mpTileErrorVars["PerFrameCB"]["gTileCountX"] = mTileScheduler.getTileCountX();
+    mpTileErrorVars["gLumStats"] = mpLumStats;
+    mpTileErrorVars["gTileError"] = mpTileError;
+
+    uint3 numGroups = div_round_up(uint3(resolution.x, resolution.y, 1u), mpTileErrorProgram->getReflector()->getThreadGroupSize());
+    mpState->setProgram(mpTileErrorProgram);
+    pRenderContext->dispatch(mpState.get(), mpTileErrorVars.get(), numGroups);
+
+    // The estimates are tiny, but the host has to wait for them. This only happens every few frames.
+    const size_t size = mTileScheduler.getTileCount() * sizeof(float);
+    pRenderContext->copyBufferRegion(mpTileErrorReadback.get(), 0, mpTileError.get(), 0, size);
+    pRenderContext->flush(true);
+
+    const float* pErrors = reinterpret_cast<const float*>(mpTileErrorReadback->map(Buffer::MapType::Read));
+    bool changed = mTileScheduler.update(pErrors, mFrameCount);
+    mpTileErrorReadback->unmap();
+
+    if (changed) {
+        const auto& activeTiles = mTileScheduler.getActiveTiles();
+        mpTileActive->setBlob(activeTiles.data(), 0, activeTiles.size() * sizeof(uint32_t));
+    }
 }
 
 void AccumulatePass::renderUI(Gui::Widgets& widget) {
@@ -219,6 +274,12 @@ void AccumulatePass::renderUI(Gui::Widgets& widget) {
 
         const std::string text = std::string("Frames accumulated ") + std::to_string(mFrameCount);
         widget.text(text.c_str());
+
+        if (mTileScheduler.isEnabled())
+        {
+            const std::string tilesText = std::string("Active tiles ") + std::to_string(mTileScheduler.getActiveTileCount()) + " / " + std::to_string(mTileScheduler.getTileCount());
+            widget.text(tilesText.c_str());
+        }
     }
 }
 
@@ -262,3 +323,34 @@ void AccumulatePass::prepareAccumulation(RenderContext* pRenderContext, uint32_t
     prepareBuffer(mpLastFrameSumLo, ResourceFormat::RGBA32Uint, mPrecisionMode == Precision::Double);
     prepareBuffer(mpLastFrameSumHi, ResourceFormat::RGBA32Uint, mPrecisionMode == Precision::Double);
 }
+
+void AccumulatePass::prepareAdaptiveSampling(RenderContext* pRenderContext, uint32_t width, uint32_t height) {
+    if (mAdaptiveThreshold <= 0.f) {
+        mpLumStats = nullptr;
+        mpTileActive = nullptr;
+        mpTileError = nullptr;
+        mpTileErrorReadback = nullptr;
+        if (mTileScheduler.isEnabled()) mTileScheduler.reset(width, height, 0.f, mAdaptiveMinSamples);
+        return;
+    }
+
+    if (!mpLumStats || mpLumStats->getWidth() != width || mpLumStats->getHeight() != height) {
+        mpLumStats = Texture::create2D(pRenderContext->device(), width, height, ResourceFormat::RGBA32Float, 1, 1, nullptr, Resource::BindFlags::ShaderResource | Resource::BindFlags::UnorderedAccess);
+        mFrameCount = 0;
+    }
+
+    // Start over with all tiles active whenever accumulation restarts.
+    if (mFrameCount == 0) {
+        pRenderContext->clearUAV(mpLumStats->getUAV().get(), float4(0.f));
+        mTileScheduler.reset(width, height, mAdaptiveThreshold, mAdaptiveMinSamples);
+
+        const uint32_t tileCount = mTileScheduler.getTileCount();
+        if (!mpTileActive || mpTileActive->getElementCount() != tileCount) {
+            mpTileActive = Buffer::createStructured(mpDevice, sizeof(uint32_t), tileCount, Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, nullptr, false);
+            mpTileError = Buffer::createStructured(mpDevice, sizeof(float), tileCount, Resource::BindFlags::ShaderResource | Resource::BindFlags::UnorderedAccess, Buffer::CpuAccess::None, nullptr, false);
+            mpTileErrorReadback = Buffer::create(mpDevice, tileCount * sizeof(float), Resource::BindFlags::None, Buffer::CpuAccess::Read, nullptr);
+        }
+        const auto& activeTiles = mTileScheduler.getActiveTiles();
+        mpTileActive->setBlob(activeTiles.data(), 0, activeTiles.size() * sizeof(uint32_t));
+    }
+}
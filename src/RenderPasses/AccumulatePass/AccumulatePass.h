@@ -29,6 +29,8 @@
 
 #include "Falcor/Falcor.h"
 
+#include "AdaptiveSampling.h"
+
 using namespace Falcor;
 
 /** Temporal accumulation render pass.
@@ -39,6 +41,11 @@ using namespace Falcor;
     For accumulating many samples for ground truth rendering etc., fp32 precision
     is not always sufficient. The pass supports higher precision modes using
     either error compensation (Kahan summation) or double precision math.
+
+    Optionally the pass samples adaptively: every few frames it estimates the
+    relative error of each 16x16 tile and stops accumulating into tiles whose
+    error dropped below a threshold. Once all tiles converged, isConverged()
+    tells the host that further frames won't change the output.
 */
 class AccumulatePass : public RenderPass {
  public:
@@ -63,6 +70,18 @@ class AccumulatePass : public RenderPass {
     // Scripting functions
     void reset() { mFrameCount = 0; }
 
+    /** Enable or disable adaptive sampling. Resets accumulation if the settings changed.
+        \param[in] threshold Relative error at which a tile stops accumulating. 0 disables adaptive sampling.
+        \param[in] minSamples Samples every tile gets before it can converge.
+    */
+    void setAdaptiveSampling(float threshold, uint32_t minSamples);
+
+    /** Check if adaptive sampling is enabled and every tile converged.
+    */
+    bool isConverged() const { return mFrameCount > 0 && mTileScheduler.isConverged(); }
+
+    uint32_t getActiveTileCount() const { return mTileScheduler.getActiveTileCount(); }
+
     enum class Precision : uint32_t {
         Double,                 ///< Standard summation in double precision.
         Single,                 ///< Standard summation in single precision.
@@ -72,6 +91,8 @@ class AccumulatePass : public RenderPass {
  protected:
     AccumulatePass(Device::SharedPtr pDevice, const Dictionary& dict);
     void prepareAccumulation(RenderContext* pRenderContext, uint32_t width, uint32_t height);
+    void prepareAdaptiveSampling(RenderContext* pRenderContext, uint32_t width, uint32_t height);
+    void updateActiveTiles(RenderContext* pRenderContext, const uint2& resolution);
 
     // Internal state
     Scene::SharedPtr            mpScene;                        ///< The current scene (or nullptr if no scene).
@@ -86,6 +107,17 @@ class AccumulatePass : public RenderPass {
     Texture::SharedPtr          mpLastFrameSumLo;               ///< Last frame running sum (lo bits). Used in Double mode.
     Texture::SharedPtr          mpLastFrameSumHi;               ///< Last frame running sum (hi bits). Used in Double mode.
 
+    // Adaptive sampling
+    ComputeProgram::SharedPtr   mpTileErrorProgram;             ///< Reduces pixel statistics to per-tile errors.
+    ComputeVars::SharedPtr      mpTileErrorVars;
+    AdaptiveSampling::TileScheduler mTileScheduler;             ///< Tracks which tiles are still accumulating.
+    Texture::SharedPtr          mpLumStats;                     ///< Luminance sum, sum of squares and sample count per pixel.
+    Buffer::SharedPtr           mpTileActive;                   ///< Active tile mask uploaded from mTileScheduler.
+    Buffer::SharedPtr           mpTileError;                    ///< Error estimate per tile.
+    Buffer::SharedPtr           mpTileErrorReadback;            ///< CPU copy of mpTileError.
+    float                       mAdaptiveThreshold = 0.f;       ///< Tile error threshold. 0 disables adaptive sampling.
+    uint32_t                    mAdaptiveMinSamples = 16;       ///< Samples every tile gets before it can converge.
+
     // UI variables
     bool                        mEnableAccumulation = true;     ///< UI control if accumulation is enabled.
     bool                        mAutoReset = true;              ///< Reset accumulation automatically upon scene changes, refresh flags, and/or subframe count.
@@ -0,0 +1,177 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#ifndef SRC_FALCOR_RENDERPASSES_ACCUMULATEPASS_ADAPTIVESAMPLING_H_
+#define SRC_FALCOR_RENDERPASSES_ACCUMULATEPASS_ADAPTIVESAMPLING_H_
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/** Tile error estimation and scheduling for adaptive sampling in the accumulation pass.
+
+    The accumulation shader keeps a running sum and sum of squares of each pixel's luminance. computeTileError in
+    Accumulate.cs.slang reduces them to one error estimate per tile, the same way computeTileErrors() does here.
+    The TileScheduler turns the estimates into the set of tiles that keep accumulating.
+*/
+namespace AdaptiveSampling {
+
+/** Tile size in pixels. Matches the thread group size of the accumulation shader.
+*/
+static const uint32_t kTileSize = 16;
+
+/** Added to the pixel mean before dividing, so the relative error of black pixels stays finite.
+*/
+static const float kErrorEpsilon = 1e-2f;
+
+/** Estimates are only read back every this many samples.
+*/
+static const uint32_t kEstimateInterval = 8;
+
+/** Error reported for pixels that don't have enough samples for a variance estimate.
+*/
+static const float kMaxError = 1e30f;
+
+inline float luminance(float r, float g, float b) {
+    return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+}
+
+/** Running luminance moments of one pixel, as stored by the shader.
+*/
+struct PixelStats {
+    float sum = 0.f;
+    float sumSq = 0.f;
+
+    void add(float value) {
+        sum += value;
+        sumSq += value * value;
+    }
+};
+
+/** Relative standard error of a pixel mean after n samples.
+*/
+inline float pixelError(float sum, float sumSq, uint32_t n) {
+    if (n < 2) return kMaxError;
+    float mean = sum / n;
+    float variance = std::max(0.f, sumSq / n - mean * mean) * n / (n - 1);
+    return std::sqrt(variance / n) / (kErrorEpsilon + mean);
+}
+
+/** Mean pixel error of every tile, in row-major tile order.
+    \param[in] pixels Pixel statistics in row-major order, width * height entries.
+    \param[in] n Number of samples accumulated in every pixel.
+*/
+inline std::vector<float> computeTileErrors(const std::vector<PixelStats>& pixels, uint32_t width, uint32_t height, uint32_t n) {
+    const uint32_t tilesX = (width + kTileSize - 1) / kTileSize;
+    const uint32_t tilesY = (height + kTileSize - 1) / kTileSize;
+    std::vector<float> errors(tilesX * tilesY, 0.f);
+
+    for (uint32_t ty = 0; ty < tilesY; ty++) {
+        for (uint32_t tx = 0; tx < tilesX; tx++) {
+            uint32_t x1 = std::min(width, (tx + 1) * kTileSize);
+            uint32_t y1 = std::min(height, (ty + 1) * kTileSize);
+            float sum = 0.f;
+            for (uint32_t y = ty * kTileSize; y < y1; y++) {
+                for (uint32_t x = tx * kTileSize; x < x1; x++) {
+                    const PixelStats& p = pixels[y * width + x];
+                    sum += pixelError(p.sum, p.sumSq, n);
+                }
+            }
+            errors[ty * tilesX + tx] = sum / ((x1 - tx * kTileSize) * (y1 - ty * kTileSize));
+        }
+    }
+    return errors;
+}
+
+/** Decides which tiles keep accumulating samples.
+    A tile stops once it has at least minSamples samples and its error estimate is at or below the threshold. Converged
+    tiles never restart until reset(), so their accumulated result stays frozen.
+*/
+class TileScheduler {
+ public:
+    /** Start over with every tile active.
+        \param[in] threshold Error threshold. 0 disables adaptive sampling.
+        \param[in] minSamples Samples every tile gets before it can converge. At least 2.
+    */
+    void reset(uint32_t width, uint32_t height, float threshold, uint32_t minSamples) {
+        mTilesX = (width + kTileSize - 1) / kTileSize;
+        mTilesY = (height + kTileSize - 1) / kTileSize;
+        mThreshold = threshold;
+        mMinSamples = std::max(2u, minSamples);
+        mActiveTiles.assign(mTilesX * mTilesY, 1);
+        mActiveCount = mTilesX * mTilesY;
+    }
+
+    bool isEnabled() const { return mThreshold > 0.f; }
+
+    /** Check if error estimates should be computed after this many samples.
+    */
+    bool shouldEstimate(uint32_t sampleCount) const {
+        return isEnabled() && mActiveCount > 0 && sampleCount >= mMinSamples && (sampleCount - mMinSamples) % kEstimateInterval == 0;
+    }
+
+    /** Retire the tiles that converged.
+        \param[in] pTileErrors Error estimate per tile, getTileCount() entries. Entries of converged tiles are ignored.
+        \param[in] sampleCount Samples accumulated so far.
+        \return True if any tile converged.
+    */
+    bool update(const float* pTileErrors, uint32_t sampleCount) {
+        if (!isEnabled() || sampleCount < mMinSamples) return false;
+
+        bool changed = false;
+        for (uint32_t i = 0; i < getTileCount(); i++) {
+            if (mActiveTiles[i] && pTileErrors[i] <= mThreshold) {
+                mActiveTiles[i] = 0;
+                mActiveCount--;
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    uint32_t getTileCountX() const { return mTilesX; }
+    uint32_t getTileCount() const { return mTilesX * mTilesY; }
+    uint32_t getActiveTileCount() const { return mActiveCount; }
+    bool isConverged() const { return isEnabled() && mActiveCount == 0; }
+
+    /** Non-zero for each tile that keeps accumulating, uploaded to the shader as is.
+    */
+    const std::vector<uint32_t>& getActiveTiles() const { return mActiveTiles; }
+
+ private:
+    uint32_t mTilesX = 0;
+    uint32_t mTilesY = 0;
+    float mThreshold = 0.f;
+    uint32_t mMinSamples = 2;
+    std::vector<uint32_t> mActiveTiles;
+    uint32_t mActiveCount = 0;
+};
+
+}  // namespace AdaptiveSampling
+
+#endif  // SRC_FALCOR_RENDERPASSES_ACCUMULATEPASS_ADAPTIVESAMPLING_H_
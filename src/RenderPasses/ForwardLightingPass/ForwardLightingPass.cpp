@@ -161,7 +161,7 @@ void ForwardLightingPass::execute(RenderContext* pContext, const RenderData& ren
             mpVars->setTexture(kVisBuffer, renderData[kVisBuffer]->asTexture());
         
         mpState->setFbo(mpFbo);
-        mpScene->render(pContext, mpState.get(), mpVars.get());
+        mpScene->render(pContext, mpState.get(), mpVars.get(), Scene::RenderFlags::FrustumCulling);
     }
 }
 
@@ -215,7 +215,8 @@ void GBufferRaster::execute(RenderContext* pRenderContext, const RenderData& ren
     mRaster.pVars["PerFrameCB"]["gParams"].setBlob(mGBufferParams);
     mRaster.pState->setFbo(mpFbo); // Sets the viewport
 
-    Scene::RenderFlags flags = mForceCullMode ? Scene::RenderFlags::UserRasterizerState : Scene::RenderFlags::None;
+    Scene::RenderFlags flags = Scene::RenderFlags::FrustumCulling;
+    if (mForceCullMode) flags |= Scene::RenderFlags::UserRasterizerState;
     mpScene->render(pRenderContext, mRaster.pState.get(), mRaster.pVars.get(), flags);
 
     mGBufferParams.frameCount++;
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <chrono>
+#include <map>
 #include "TexturesResolvePass.h"
 
 #include "Falcor/Utils/Debug/debug.h"
@@ -70,14 +71,111 @@ RenderPassReflection TexturesResolvePass::reflect(const CompileData& compileData
 }
 
 void TexturesResolvePass::updateTexturesResolveData() {
- 
+    std::vector<TexturesResolve::MaterialTexturesDesc> materials;
+    std::map<uint32_t, Texture::SharedPtr> texturesMap; // maps real texture ID to textures
+
+    uint32_t materialsCount = mpScene->getMaterialCount();
+    materials.reserve(materialsCount);
+
+    for( uint32_t m_i = 0; m_i < materialsCount; m_i++ ) {
+        auto materialResources = mpScene->getMaterial(m_i)->getResources();
+
+        TexturesResolve::MaterialTexturesDesc materialTextures;
+        for(const auto& pTexture: {materialResources.baseColor, materialResources.specular, materialResources.roughness, materialResources.normalMap}) {
+            if (!pTexture || !pTexture->isSparse()) continue;
+
+            TexturesResolve::VirtualTextureDesc desc;
+            desc.textureID = pTexture->id();
+            desc.width = pTexture->getWidth();
+            desc.height = pTexture->getHeight();
+            desc.mipLevelsCount = pTexture->getMipCount();
+            desc.mipTailStart = pTexture->getMipTailStart();
+
+            auto pageRes = pTexture->getSparsePageRes();
+            desc.pageSizeW = pageRes.x;
+            desc.pageSizeH = pageRes.y;
+            desc.pageSizeD = pageRes.z;
+            desc.pagesCount = pTexture->getSparsePagesCount();
+            for (const auto& pPage : pTexture->pages()) desc.pageIDs.push_back(pPage->id());
+
+            desc.mipBases = pTexture->getMipBases();
+
+            materialTextures.push_back(desc);
+            texturesMap[desc.textureID] = pTexture;
+        }
+        materials.push_back(std::move(materialTextures));
+    }
+
+    mTableDirty = false;
+    if (!mResolveTable.build(materials)) return;
+
+    // Layout changed. Flags in flight refer to the old layout and will be dropped.
+    mTableVersion++;
+    if (mPendingRequests.valid()) loadRequestedPages();
+    mPageFlagsTracker.reset(mResolveTable.getTotalPagesCount());
+
+    mResolveTextures.clear();
+    for (const auto& texture : mResolveTable.getTextures()) mResolveTextures.push_back(texturesMap[texture.textureID]);
+
+    const auto& materialsData = mResolveTable.getMaterialsData();
+    if (!mpMaterialsResolveBuffer || mpMaterialsResolveBuffer->getElementCount() != std::max<size_t>(1, materialsData.size())) {
+        mpMaterialsResolveBuffer = Buffer::createStructured(mpDevice, sizeof(MaterialResolveData), std::max<size_t>(1, materialsData.size()), Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, nullptr, false);
+    }
+    if (!materialsData.empty()) mpMaterialsResolveBuffer->setBlob(materialsData.data(), 0, materialsData.size() * sizeof(MaterialResolveData));
+
+    LOG_DBG("Textures resolve table rebuilt: %zu materials, %zu textures, %u pages", materialsData.size(), mResolveTextures.size(), mResolveTable.getTotalPagesCount());
+}
+
+void TexturesResolvePass::loadRequestedPages() {
+    auto requests = mPendingRequests.get();
+
+    for (const auto& request : requests) {
+        mpDevice->resourceManager()->loadPages(mPendingRequestsTextures[request.textureIndex], request.pageIDs);
+    }
+    mPendingRequestsTextures.clear();
+}
+
+void TexturesResolvePass::readbackFeedback(uint32_t slotIndex) {
+    auto& slot = mFeedbackSlots[slotIndex];
+    if (!slot.pending) return;
+    slot.pending = false;
+
+    // Normally signaled long ago, we are kFeedbackSlotsCount - 1 frames behind.
+    mpFence->syncCpu(slot.fenceValue);
+    if (slot.tableVersion != mTableVersion) return;
+
+    uint32_t pagesCount = mResolveTable.getTotalPagesCount();
+    const int8_t* pFlags = reinterpret_cast<const int8_t*>(slot.pReadbackBuffer->map(Buffer::MapType::Read));
+    std::vector<int8_t> flags(pFlags, pFlags + pagesCount);
+    slot.pReadbackBuffer->unmap();
+
+    // One diff in flight at a time, the tracker is not thread safe.
+    if (mPendingRequests.valid()) loadRequestedPages();
+
+    mPendingRequestsTextures = mResolveTextures;
+    mPendingRequests = std::async(std::launch::async, [this, flags = std::move(flags), textures = mResolveTable.getTextures(), pagesCount]() {
+        return mPageFlagsTracker.diff(textures, pagesCount, flags.data());
+    });
+}
+
+void TexturesResolvePass::flushFeedback() {
+    // Oldest slot first so pages are requested in the order the frames were rendered.
+    for (uint32_t i = 0; i < kFeedbackSlotsCount; i++) {
+        readbackFeedback((mFrameIndex + i) % kFeedbackSlotsCount);
+    }
+    if (mPendingRequests.valid()) loadRequestedPages();
 }
 
 void TexturesResolvePass::setScene(RenderContext* pRenderContext, const Scene::SharedPtr& pScene) {
+    if (mPendingRequests.valid()) mPendingRequests.wait();
+    mPendingRequests = {};
+    mPendingRequestsTextures.clear();
+    for (auto& slot : mFeedbackSlots) slot.pending = false;
+
     mpScene = pScene;
+    mTableDirty = true;
     if (mpScene) {
         mpState->getProgram()->addDefines(mpScene->getSceneDefines());
-        //updateTexturesResolveData();
     }
     mpVars = GraphicsVars::create(pRenderContext->device(), mpState->getProgram()->getReflector());
 }
@@ -106,169 +204,47 @@ void TexturesResolvePass::execute(RenderContext* pContext, const RenderData& ren
     if (!mpScene)
         return;
 
-    auto exec_started = std::chrono::high_resolution_clock::now();
-
-    uint32_t totalPagesToUpdateCount = 0;
-    uint32_t currPagesStartOffset = 0;
-    uint32_t currTextureResolveID = 0; // texture id used to identify texture inside pass. always starts from 0.
-
-    std::vector<MaterialResolveData> materialsResolveBuffer;
-    std::map<uint32_t, Texture::SharedPtr> texturesMap; // maps real texture ID to textures
-    std::map<uint32_t, VirtualTextureData> virtualTexturesDataMap; //
-
-    uint32_t materialsCount = mpScene->getMaterialCount();
-
-    for( uint32_t m_i = 0; m_i < materialsCount; m_i++ ) {
-        auto pMaterial =  mpScene->getMaterial(m_i);
-        auto materialResources = pMaterial->getResources();
-
-        std::vector<Texture::SharedPtr> materialSparseTextures;
-
-        if(materialResources.baseColor) {
-            if (materialResources.baseColor->isSparse()) {
-                materialSparseTextures.push_back(materialResources.baseColor);
-            }
-        }
-
-        if(materialResources.specular) {
-            if (materialResources.specular->isSparse()) {
-                materialSparseTextures.push_back(materialResources.specular);
-            }
-        }
-
-        if(materialResources.roughness) {
-            if (materialResources.roughness->isSparse()) {
-                materialSparseTextures.push_back(materialResources.roughness);
-            }
-        }
-
-        if(materialResources.normalMap) {
-            if (materialResources.normalMap->isSparse()) {
-                materialSparseTextures.push_back(materialResources.normalMap);
-            }
-        }
-
-        MaterialResolveData materialResolveData = {};
-
-        size_t virtualTexturesCount = std::min((size_t)MAX_VTEX_PER_MATERIAL_COUNT, materialSparseTextures.size());
-        materialResolveData.virtualTexturesCount = virtualTexturesCount;
-        
-        // pre-fill some data
-        for( size_t t_i = 0; t_i < static_cast<size_t>(MAX_VTEX_PER_MATERIAL_COUNT); t_i++)
-            materialResolveData.virtualTextures[t_i].empty = true;
-
-        // fill data for active(used) textures
-        for( size_t t_i = 0; t_i < virtualTexturesCount; t_i++) {
-            auto &pTexture = materialSparseTextures[t_i];
-            uint32_t textureID = pTexture->id();
-                
-            auto &textureData = materialResolveData.virtualTextures[t_i];
-
-            // Check if this sparse texture data not stored for resolving
-            if (virtualTexturesDataMap.find(textureID) == virtualTexturesDataMap.end() ) {
-                // Fill vitrual texture data
-                textureData.empty = false;
-                textureData.textureID = textureID;
-                textureData.textureResolveID = currTextureResolveID;
-                textureData.width = pTexture->getWidth();
-                textureData.height = pTexture->getHeight();
-                textureData.mipLevelsCount = pTexture->getMipCount();
-                textureData.mipTailStart = pTexture->getMipTailStart();
-                textureData.pagesStartOffset = currPagesStartOffset;
-
-                auto pageRes = pTexture->getSparsePageRes();
-                textureData.pageSizeW = pageRes.x;
-                textureData.pageSizeH = pageRes.y;
-                textureData.pageSizeD = pageRes.z;
-                
-                auto const& mipBases = pTexture->getMipBases();
-
-                memcpy(&textureData.mipBases, mipBases.data(), mipBases.size() * sizeof(uint32_t));
-
-                currTextureResolveID++;
-                currPagesStartOffset += pTexture->getSparsePagesCount();
-                virtualTexturesDataMap[textureID] = textureData; 
-                texturesMap[textureID] = pTexture;
-            
-                // --- debug info 
-                LOG_WARN("Texture id: %u pages offset: %u width: %u height: %u", textureData.textureID, textureData.pagesStartOffset, textureData.width, textureData.height);
-                LOG_WARN("Texture id: %u mip levels: %u tail start: %u", textureData.textureID, textureData.mipLevelsCount, textureData.mipTailStart);
-                std::cout << "Mip bases : \n";
-                for( uint i = 0; i < 16; i++) std::cout << textureData.mipBases[i] << " ";
-                std::cout << "\n";
-
-            } else {
-                // Virtual texture data cached in map, reuse it
-                textureData = virtualTexturesDataMap[textureID];
-            }
-        }
-
-        materialsResolveBuffer.push_back(materialResolveData);
+    if (mTableDirty || is_set(mpScene->getUpdates(), Scene::UpdateFlags::MaterialsChanged)) {
+        updateTexturesResolveData();
     }
 
-    totalPagesToUpdateCount = currPagesStartOffset;
-    totalPagesToUpdateCount += 16;
+    // Load pages diffed since the last frame
+    if (mPendingRequests.valid() && mPendingRequests.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        loadRequestedPages();
+    }
 
-    auto pDataToResolveBuffer = Buffer::createStructured(mpDevice, sizeof(MaterialResolveData), materialsCount, Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, materialsResolveBuffer.data(), true);
-    mpVars->setBuffer("materialsResolveData", pDataToResolveBuffer);
+    if (!mpFence) mpFence = GpuFence::create(mpDevice);
 
-    uint32_t resolvedTexturesCount = currTextureResolveID;
+    // Reuse the oldest slot. Its flags are handed to the worker first.
+    uint32_t slotIndex = mFrameIndex % kFeedbackSlotsCount;
+    readbackFeedback(slotIndex);
+    auto& slot = mFeedbackSlots[slotIndex];
 
-    LOG_WARN("Total pages to update for %u textures is %u", resolvedTexturesCount, totalPagesToUpdateCount);
+    // Shader writes whole dwords and vkCmdFillBuffer needs a multiple of 4 bytes
+    uint32_t pagesBufferSize = (mResolveTable.getTotalPagesCount() + 3) & ~3u;
+    if (!slot.pPagesBuffer || slot.pPagesBuffer->getSize() != pagesBufferSize) {
+        slot.pPagesBuffer = Buffer::create(mpDevice, pagesBufferSize, Resource::BindFlags::ShaderResource | Resource::BindFlags::UnorderedAccess, Buffer::CpuAccess::None, nullptr);
+        slot.pReadbackBuffer = Buffer::create(mpDevice, pagesBufferSize, Resource::BindFlags::None, Buffer::CpuAccess::Read, nullptr);
+    }
+    pContext->clearUAV(slot.pPagesBuffer->getUAV().get(), uint4(0));
 
-    std::vector<int8_t> pagesInitDataBuffer(totalPagesToUpdateCount, 0);
-    auto pPagesBuffer = Buffer::create(mpDevice, totalPagesToUpdateCount, Resource::BindFlags::ShaderResource | Resource::BindFlags::UnorderedAccess, Buffer::CpuAccess::None, pagesInitDataBuffer.data());
-    mpVars->setBuffer("resolvedPagesBuff", pPagesBuffer);
+    mpVars->setBuffer("materialsResolveData", mpMaterialsResolveBuffer);
+    mpVars->setBuffer("resolvedPagesBuff", slot.pPagesBuffer);
 
     mpVars["PerFrameCB"]["gRenderTargetDim"] = float2(mpFbo->getWidth(), mpFbo->getHeight());
-    mpVars["PerFrameCB"]["materialsToResolveCount"] = materialsResolveBuffer.size();
-    mpVars["PerFrameCB"]["resolvedTexturesCount"] = resolvedTexturesCount;
-
-    LOG_WARN("%u textures needs to be resolved", resolvedTexturesCount);
+    mpVars["PerFrameCB"]["materialsToResolveCount"] = (uint32_t)mResolveTable.getMaterialsData().size();
+    mpVars["PerFrameCB"]["resolvedTexturesCount"] = (uint32_t)mResolveTable.getTextures().size();
 
     mpScene->render(pContext, mpState.get(), mpVars.get());
-    pContext->flush(true);
-
-    // Test resolved data
-    const int8_t* pOutPagesData = reinterpret_cast<const int8_t*>(pPagesBuffer->map(Buffer::MapType::Read));
-
-    // dev print pages
-    //std::cout << "Page ids: \n";
-    //for( uint32_t i = 0; i < totalPagesToUpdateCount; i++) {
-    //    std::cout << static_cast<int16_t>(pOutPagesData[i]) << " ";
-    //}
-    //std::cout << "\n\n";
-
-    // test count pages
-    std::vector<int8_t> page_flags(pOutPagesData, pOutPagesData + sizeof(int8_t) * totalPagesToUpdateCount);
-    uint32_t pagesToLoadCount = std::count(page_flags.begin(), page_flags.end(), 1);
-    LOG_WARN("%u pages needs to be loaded", pagesToLoadCount);
 
-    // test load pages
-    auto started = std::chrono::high_resolution_clock::now();
-
-    uint32_t pagesStartOffset = 0;
-    for (auto const& [textureID, pTexture] :texturesMap) {
-        uint32_t texturePagesCount = pTexture->getSparsePagesCount();
-        LOG_DBG("Analyzing %u pages for texture %u", texturePagesCount, textureID);
-
-        std::vector<uint32_t> pageIDs;
-
-        // index 'i' is a page index relative to the texture. starts with 0
-        for(uint32_t i = 0; i < texturePagesCount; i++) {
-
-            if (pOutPagesData[i + pagesStartOffset] != 0)
-                pageIDs.push_back(i + pagesStartOffset);
-        }
-        mpDevice->resourceManager()->loadPages(pTexture, pageIDs); 
-
-        pagesStartOffset += texturePagesCount;
-    }
-    auto done = std::chrono::high_resolution_clock::now();
-    std::cout << "Pages loading done in: " << std::chrono::duration_cast<std::chrono::milliseconds>(done-started).count() << std::endl;
-    std::cout << "TexturesResolvePass::execute done in: " << std::chrono::duration_cast<std::chrono::milliseconds>(done-exec_started).count() << std::endl;
+    // Queue the readback, the flags are picked up when this slot comes around again
+    pContext->copyBufferRegion(slot.pReadbackBuffer.get(), 0, slot.pPagesBuffer.get(), 0, pagesBufferSize);
+    pContext->flush(false);
+    slot.fenceValue = mpFence->gpuSignal(pContext->getLowLevelData()->getCommandQueue());
+    slot.tableVersion = mTableVersion;
+    slot.pending = true;
 
-    LOG_DBG("TexturesResolvePass::execute done");
+    mFrameIndex++;
 }
 
 TexturesResolvePass& TexturesResolvePass::setDepthStencilState(const DepthStencilState::SharedPtr& pDsState) {
@@ -35,9 +35,13 @@
 
 #include <slang/slang.h>
 
+#include <array>
+#include <future>
+
 using namespace Falcor;
 
 #include "TexturesResolveData.slangh"
+#include "TexturesResolveTable.h"
 
 #ifdef BUILD_DEPTH_PASS
 // #define dllpassdecl __declspec(dllexport)
@@ -67,12 +71,32 @@ class dllpassdecl TexturesResolvePass : public RenderPass, public inherit_shared
     TexturesResolvePass& setDepthStencilState(const DepthStencilState::SharedPtr& pDsState);
     TexturesResolvePass& setRasterizerState(const RasterizerState::SharedPtr& pRsState);
 
+    /** Page flags are read back kFeedbackSlotsCount - 1 frames after they were rendered, so execute() alone loads pages
+        two frames late. Call this after the last execute() (e.g. before a final or offline render) to wait for every
+        frame in flight and load all pages it requested.
+    */
+    void flushFeedback();
+
  private:
     TexturesResolvePass(Device::SharedPtr pDevice, const Dictionary& dict);
     void parseDictionary(const Dictionary& dict);
 
     void initDepth(RenderContext* pContext, const RenderData& renderData);
     void updateTexturesResolveData();
+    void readbackFeedback(uint32_t slotIndex);
+    void loadRequestedPages();
+
+    /** Page flags written by one frame. Slots are used round-robin so the CPU reads a slot
+        only after kFeedbackSlotsCount - 1 more frames have been submitted.
+    */
+    struct FeedbackSlot {
+        Buffer::SharedPtr pPagesBuffer;     ///< Page flags written by the shader.
+        Buffer::SharedPtr pReadbackBuffer;  ///< CPU readable copy of pPagesBuffer.
+        uint64_t fenceValue = 0;
+        uint32_t tableVersion = 0;          ///< Table layout the flags were produced with.
+        bool pending = false;
+    };
+    static const uint32_t kFeedbackSlotsCount = 3;
 
     Fbo::SharedPtr              mpFbo;
     GraphicsState::SharedPtr    mpState;
@@ -89,6 +113,22 @@ class dllpassdecl TexturesResolvePass : public RenderPass, public inherit_shared
     ParameterBlock::SharedPtr   mpDataBlock;
     Buffer::SharedPtr           mpTexResolveDataBuffer;
     bool                        mUsePreGenDepth = false;
+
+    // Persistent resolve table, rebuilt only when materials change
+    TexturesResolve::Table      mResolveTable;
+    Buffer::SharedPtr           mpMaterialsResolveBuffer;
+    std::vector<Texture::SharedPtr> mResolveTextures;   ///< Textures in Table::getTextures() order
+    uint32_t                    mTableVersion = 0;
+    bool                        mTableDirty = true;
+
+    std::array<FeedbackSlot, kFeedbackSlotsCount> mFeedbackSlots;
+    uint32_t                    mFrameIndex = 0;
+    GpuFence::SharedPtr         mpFence;
+
+    // Page flags are diffed on a worker, pages are loaded on the render thread
+    TexturesResolve::PageFlagsTracker mPageFlagsTracker;
+    std::future<std::vector<TexturesResolve::PageRequest>> mPendingRequests;
+    std::vector<Texture::SharedPtr> mPendingRequestsTextures;
 };
 
 #endif  // SRC_FALCOR_RENDERPASSES_TEXTURESRESOLVEPASS_H_
@@ -0,0 +1,207 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#ifndef SRC_FALCOR_RENDERPASSES_TEXTURESRESOLVEPASS_TEXTURESRESOLVETABLE_H_
+#define SRC_FALCOR_RENDERPASSES_TEXTURESRESOLVEPASS_TEXTURESRESOLVETABLE_H_
+
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "TexturesResolveData.slangh"
+
+/** Material to sparse texture page mapping of the textures resolve pass, and the tracking of which pages the
+    resolve shader flagged since they were last requested.
+*/
+namespace TexturesResolve {
+
+/** Sparse texture parameters needed to build the resolve table.
+*/
+struct VirtualTextureDesc {
+    uint32_t textureID = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipLevelsCount = 0;
+    uint32_t mipTailStart = 0;
+    uint32_t pageSizeW = 0;
+    uint32_t pageSizeH = 0;
+    uint32_t pageSizeD = 0;
+    uint32_t pagesCount = 0;
+    std::array<uint32_t, 16> mipBases = {};
+    std::vector<uint32_t> pageIDs;  ///< ResourceManager page ID of every texture page, pagesCount entries.
+};
+
+/** Sparse textures of one material, in binding order (base color, specular, roughness, normal map).
+*/
+using MaterialTexturesDesc = std::vector<VirtualTextureDesc>;
+
+/** Extra flags at the end of the page flags buffer, matches the padding the shader has always been given.
+*/
+static const uint32_t kPageFlagsPadding = 16;
+
+/** Persistent material -> virtual texture table uploaded to the resolve shader.
+    Textures get resolve IDs and page ranges in order of first use. Rebuilding with unchanged inputs is a no-op.
+*/
+class Table {
+ public:
+    struct TextureEntry {
+        uint32_t textureID;
+        uint32_t pagesStartOffset;  ///< First flag of this texture in the page flags buffer.
+        uint32_t pagesCount;
+        std::vector<uint32_t> pageIDs;  ///< ResourceManager page ID of every texture page.
+    };
+
+    /** Rebuild the table.
+        \return True if the packed material data or the texture layout changed and needs to be uploaded.
+    */
+    bool build(const std::vector<MaterialTexturesDesc>& materials) {
+        std::vector<MaterialResolveData> packed;
+        std::vector<TextureEntry> textures;
+        std::unordered_map<uint32_t, VirtualTextureData> textureData;   // texture ID -> packed data
+        uint32_t pagesStartOffset = 0;
+
+        packed.reserve(materials.size());
+        for (const auto& material : materials) {
+            MaterialResolveData materialData = {};
+
+            uint32_t virtualTexturesCount = std::min((uint32_t)MAX_VTEX_PER_MATERIAL_COUNT, (uint32_t)material.size());
+            materialData.virtualTexturesCount = virtualTexturesCount;
+            for (uint32_t t = 0; t < (uint32_t)MAX_VTEX_PER_MATERIAL_COUNT; t++) materialData.virtualTextures[t].empty = true;
+
+            for (uint32_t t = 0; t < virtualTexturesCount; t++) {
+                const auto& desc = material[t];
+                auto it = textureData.find(desc.textureID);
+                if (it == textureData.end()) {
+                    VirtualTextureData data = {};
+                    data.empty = false;
+                    data.textureID = desc.textureID;
+                    data.textureResolveID = (uint32_t)textures.size();
+                    data.width = desc.width;
+                    data.height = desc.height;
+                    data.mipLevelsCount = desc.mipLevelsCount;
+                    data.mipTailStart = desc.mipTailStart;
+                    data.pagesStartOffset = pagesStartOffset;
+                    data.pageSizeW = desc.pageSizeW;
+                    data.pageSizeH = desc.pageSizeH;
+                    data.pageSizeD = desc.pageSizeD;
+                    std::memcpy(data.mipBases, desc.mipBases.data(), sizeof(data.mipBases));
+
+                    textures.push_back({ desc.textureID, pagesStartOffset, desc.pagesCount, desc.pageIDs });
+                    pagesStartOffset += desc.pagesCount;
+                    it = textureData.emplace(desc.textureID, data).first;
+                }
+                materialData.virtualTextures[t] = it->second;
+            }
+            packed.push_back(materialData);
+        }
+
+        bool changed = packed.size() != mPacked.size() || textures.size() != mTextures.size() ||
+            std::memcmp(packed.data(), mPacked.data(), packed.size() * sizeof(MaterialResolveData)) != 0 ||
+            !std::equal(textures.begin(), textures.end(), mTextures.begin(), [](const TextureEntry& a, const TextureEntry& b) {
+                return a.textureID == b.textureID && a.pagesStartOffset == b.pagesStartOffset && a.pagesCount == b.pagesCount && a.pageIDs == b.pageIDs;
+            });
+
+        mPacked = std::move(packed);
+        mTextures = std::move(textures);
+        mTotalPagesCount = pagesStartOffset + kPageFlagsPadding;
+        return changed;
+    }
+
+    const std::vector<MaterialResolveData>& getMaterialsData() const { return mPacked; }
+    const std::vector<TextureEntry>& getTextures() const { return mTextures; }
+
+    /** Size of the page flags buffer in bytes (one byte per page).
+    */
+    uint32_t getTotalPagesCount() const { return mTotalPagesCount; }
+
+ private:
+    std::vector<MaterialResolveData> mPacked;
+    std::vector<TextureEntry> mTextures;
+    uint32_t mTotalPagesCount = kPageFlagsPadding;
+};
+
+/** Pages that need loading for one texture.
+*/
+struct PageRequest {
+    uint32_t textureIndex;          ///< Index into Table::getTextures().
+    std::vector<uint32_t> pageIDs;  ///< ResourceManager page IDs (TextureEntry::pageIDs), as passed to ResourceManager::loadPages().
+};
+
+/** Tracks which pages were already requested and turns a frame's page flags into requests for new pages only.
+*/
+class PageFlagsTracker {
+ public:
+    /** Forget all requested pages, e.g. after the table layout changed.
+    */
+    void reset(uint32_t totalPagesCount) {
+        mRequested.assign(totalPagesCount, 0);
+    }
+
+    /** Compare the flags read back from the GPU against the pages requested so far.
+        \param[in] table The table the flags were produced with.
+        \param[in] pFlags Page flags, one byte per page, at least table.getTotalPagesCount() bytes.
+        \return Requests for pages flagged for the first time, one entry per texture that has any.
+    */
+    std::vector<PageRequest> diff(const Table& table, const int8_t* pFlags) {
+        return diff(table.getTextures(), table.getTotalPagesCount(), pFlags);
+    }
+
+    /** Same as above, taking a snapshot of the table layout so the diff can run on a worker while the table is rebuilt.
+    */
+    std::vector<PageRequest> diff(const std::vector<Table::TextureEntry>& textures, uint32_t totalPagesCount, const int8_t* pFlags) {
+        if (mRequested.size() != totalPagesCount) reset(totalPagesCount);
+
+        std::vector<PageRequest> requests;
+        for (uint32_t t = 0; t < (uint32_t)textures.size(); t++) {
+            const auto& texture = textures[t];
+            PageRequest request = { t, {} };
+            // Flags are laid out per texture, the resource manager knows pages by their global ID.
+            uint32_t pagesCount = std::min(texture.pagesCount, (uint32_t)texture.pageIDs.size());
+            for (uint32_t i = 0; i < pagesCount; i++) {
+                uint32_t flagIndex = texture.pagesStartOffset + i;
+                if (pFlags[flagIndex] != 0 && mRequested[flagIndex] == 0) {
+                    mRequested[flagIndex] = 1;
+                    request.pageIDs.push_back(texture.pageIDs[i]);
+                }
+            }
+            if (!request.pageIDs.empty()) requests.push_back(std::move(request));
+        }
+        return requests;
+    }
+
+    size_t getRequestedCount() const { return std::count(mRequested.begin(), mRequested.end(), 1); }
+
+ private:
+    std::vector<uint8_t> mRequested;
+};
+
+}  // namespace TexturesResolve
+
+#endif  // SRC_FALCOR_RENDERPASSES_TEXTURESRESOLVEPASS_TEXTURESRESOLVETABLE_H_
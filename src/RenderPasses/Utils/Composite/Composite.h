@@ -52,6 +52,7 @@ class Composite : public RenderPass {
     virtual RenderPassReflection reflect(const CompileData& compileData) override;
     virtual void compile(RenderContext* pContext, const CompileData& compileData) override;
     virtual void execute(RenderContext* pRenderContext, const RenderData& renderData) override;
+    virtual bool supportsParallelRecording() const override { return true; }
     virtual void renderUI(Gui::Widgets& widget) override;
 
     static const char* kDesc;
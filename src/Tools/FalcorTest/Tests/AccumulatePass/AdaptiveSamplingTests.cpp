@@ -0,0 +1,168 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "RenderPasses/AccumulatePass/AdaptiveSampling.h"
+
+#include <chrono>
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        using namespace AdaptiveSampling;
+
+        /** Accumulates n samples per pixel. Pixels left of splitX are constant, the rest are uniform noise.
+        */
+        std::vector<PixelStats> accumulate(uint32_t width, uint32_t height, uint32_t splitX, uint32_t n, uint32_t seed = 0)
+        {
+            std::mt19937 rng(seed);
+            std::uniform_real_distribution<float> noise(0.f, 2.f);
+            std::vector<PixelStats> pixels(width * height);
+            for (uint32_t s = 0; s < n; s++)
+            {
+                for (uint32_t y = 0; y < height; y++)
+                {
+                    for (uint32_t x = 0; x < width; x++)
+                    {
+                        float value = x < splitX ? luminance(0.5f, 0.5f, 0.5f) : noise(rng);
+                        pixels[y * width + x].add(value);
+                    }
+                }
+            }
+            return pixels;
+        }
+    }
+
+    CPU_TEST(AdaptiveSamplingPixelError)
+    {
+        EXPECT_EQ(pixelError(1.f, 1.f, 1), kMaxError);
+        EXPECT_EQ(pixelError(8.f, 8.f, 8), 0.f);
+
+        // Samples 0 and 2: mean 1, unbiased variance 2, standard error 1.
+        float error = pixelError(2.f, 4.f, 2);
+        EXPECT_LE(std::abs(error - 1.f / (1.f + kErrorEpsilon)), 1e-5f);
+
+        // Black pixels stay finite.
+        EXPECT_EQ(pixelError(0.f, 0.f, 4), 0.f);
+    }
+
+    CPU_TEST(AdaptiveSamplingTileErrors)
+    {
+        // 40x20 has partial tiles on both the right and bottom edges.
+        const uint32_t width = 40, height = 20;
+        auto pixels = accumulate(width, height, 32, 16);
+        auto errors = computeTileErrors(pixels, width, height, 16);
+
+        EXPECT_EQ(errors.size(), 6u);
+        EXPECT_EQ(errors[0], 0.f);
+        EXPECT_EQ(errors[1], 0.f);
+        EXPECT_EQ(errors[3], 0.f);
+        EXPECT_EQ(errors[4], 0.f);
+        EXPECT_GT(errors[2], 0.1f);
+        EXPECT_GT(errors[5], 0.1f);
+    }
+
+    CPU_TEST(AdaptiveSamplingScheduler)
+    {
+        const uint32_t width = 64, height = 32;
+        const float threshold = 0.05f;
+        const uint32_t minSamples = 8;
+
+        TileScheduler scheduler;
+        scheduler.reset(width, height, threshold, minSamples);
+        EXPECT(scheduler.isEnabled());
+        EXPECT_EQ(scheduler.getTileCount(), 8u);
+        EXPECT_EQ(scheduler.getActiveTileCount(), 8u);
+        EXPECT(!scheduler.shouldEstimate(minSamples - 1));
+        EXPECT(scheduler.shouldEstimate(minSamples));
+        EXPECT(!scheduler.shouldEstimate(minSamples + 1));
+        EXPECT(scheduler.shouldEstimate(minSamples + kEstimateInterval));
+
+        // Left half is flat and converges at the first estimate, the noisy right half needs more samples.
+        uint32_t convergedAt = 0;
+        for (uint32_t n = minSamples; n <= 4096 && !scheduler.isConverged(); n += kEstimateInterval)
+        {
+            auto pixels = accumulate(width, height, 32, n, n);
+            auto errors = computeTileErrors(pixels, width, height, n);
+            scheduler.update(errors.data(), n);
+
+            const auto& active = scheduler.getActiveTiles();
+            if (n == minSamples)
+            {
+                EXPECT_EQ(scheduler.getActiveTileCount(), 4u);
+                EXPECT_EQ(active[0], 0u);
+                EXPECT_EQ(active[1], 0u);
+                EXPECT_EQ(active[2], 1u);
+                EXPECT_EQ(active[3], 1u);
+            }
+            convergedAt = n;
+        }
+        EXPECT(scheduler.isConverged());
+        EXPECT_GT(convergedAt, minSamples);
+
+        // Converged tiles stay retired, reset() starts over.
+        std::vector<float> errors(scheduler.getTileCount(), kMaxError);
+        EXPECT(!scheduler.update(errors.data(), convergedAt + kEstimateInterval));
+        EXPECT(scheduler.isConverged());
+        scheduler.reset(width, height, threshold, minSamples);
+        EXPECT_EQ(scheduler.getActiveTileCount(), 8u);
+    }
+
+    CPU_TEST(AdaptiveSamplingDisabled)
+    {
+        TileScheduler scheduler;
+        scheduler.reset(128, 128, 0.f, 4);
+        EXPECT(!scheduler.isEnabled());
+        EXPECT(!scheduler.shouldEstimate(4));
+
+        std::vector<float> errors(scheduler.getTileCount(), 0.f);
+        EXPECT(!scheduler.update(errors.data(), 64));
+        EXPECT(!scheduler.isConverged());
+        EXPECT_EQ(scheduler.getActiveTileCount(), scheduler.getTileCount());
+    }
+
+    CPU_TEST(AdaptiveSamplingBenchmark)
+    {
+        // Scheduler update for a 4K frame, which runs on the host every kEstimateInterval samples.
+        TileScheduler scheduler;
+        scheduler.reset(3840, 2160, 0.01f, 4);
+        std::vector<float> errors(scheduler.getTileCount());
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> dist(0.f, 0.02f);
+        for (auto& e : errors) e = dist(rng);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        scheduler.update(errors.data(), 4);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        EXPECT_GT(scheduler.getActiveTileCount(), 0u);
+        EXPECT_LT(scheduler.getActiveTileCount(), scheduler.getTileCount());
+        logInfo("AdaptiveSamplingBenchmark: scheduler update for " + std::to_string(scheduler.getTileCount()) + " tiles " + std::to_string(ms) + " ms.");
+    }
+}
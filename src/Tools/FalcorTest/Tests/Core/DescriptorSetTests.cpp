@@ -0,0 +1,104 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Falcor/Core/API/DescriptorSet.h"
+
+namespace Falcor {
+
+namespace {
+
+DescriptorSet::Layout makeMaterialLayout() {
+    DescriptorSet::Layout layout;
+    layout.addRange(DescriptorSet::Type::Cbv, 0, 1, 2);
+    layout.addRange(DescriptorSet::Type::TextureSrv, 1, 4, 2);
+    layout.addRange(DescriptorSet::Type::Sampler, 5, 8, 2);
+    return layout;
+}
+
+}  // namespace
+
+CPU_TEST(DescriptorSetLayoutHash)
+{
+    auto a = makeMaterialLayout();
+    auto b = makeMaterialLayout();
+    EXPECT(a == b);
+    EXPECT_EQ(a.getHash(), b.getHash());
+
+    // Any difference in ranges or visibility makes a different layout
+    DescriptorSet::Layout c;
+    c.addRange(DescriptorSet::Type::Cbv, 0, 1, 2);
+    c.addRange(DescriptorSet::Type::TextureSrv, 1, 5, 2);
+    c.addRange(DescriptorSet::Type::Sampler, 5, 8, 2);
+    EXPECT(a != c);
+    EXPECT_NE(a.getHash(), c.getHash());
+
+    DescriptorSet::Layout d(ShaderVisibility::Pixel);
+    d.addRange(DescriptorSet::Type::Cbv, 0, 1, 2);
+    d.addRange(DescriptorSet::Type::TextureSrv, 1, 4, 2);
+    d.addRange(DescriptorSet::Type::Sampler, 5, 8, 2);
+    EXPECT(a != d);
+
+    EXPECT(DescriptorSet::Layout() == DescriptorSet::Layout());
+    EXPECT(DescriptorSet::Layout() != a);
+}
+
+GPU_TEST(DescriptorSetLayoutCacheAndBatchedWrites)
+{
+    auto pDevice = ctx.getRenderContext()->device();
+    const uint32_t kSetCount = 2000;
+
+    // Sampler-only layout so the test doesn't need any resources
+    DescriptorSet::Layout layout;
+    layout.addRange(DescriptorSet::Type::Sampler, 0, 8, 7);
+
+    auto before = pDevice->getDescriptorStats();
+    std::vector<DescriptorSet::SharedPtr> sets;
+    for (uint32_t i = 0; i < kSetCount; i++) {
+        auto pSet = DescriptorSet::create(pDevice, pDevice->getGpuDescriptorPool(), layout);
+        for (uint32_t s = 0; s < 8; s++) pSet->setSampler(0, s, pDevice->getDefaultSampler().get());
+        pSet->flushWrites();
+        sets.push_back(pSet);
+    }
+    auto after = pDevice->getDescriptorStats();
+
+    // One layout for all sets, one update per set covering the whole array
+    EXPECT_LE(after.layoutsCreated - before.layoutsCreated, 1ull);
+    EXPECT_EQ(after.layoutRequests - before.layoutRequests, (uint64_t)kSetCount);
+    EXPECT_EQ(after.setsAllocated - before.setsAllocated, (uint64_t)kSetCount);
+    EXPECT_EQ(after.writeCalls - before.writeCalls, (uint64_t)kSetCount);
+    EXPECT_EQ(after.descriptorsWritten - before.descriptorsWritten, (uint64_t)kSetCount * 8);
+
+    // More sets than fit a single page, pages come back once the sets are released and the GPU is idle
+    EXPECT_GT(after.poolPagesCreated - before.poolPagesCreated, 1ull);
+    sets.clear();
+    pDevice->flushAndSync();
+    pDevice->flushAndSync();
+    EXPECT_GT(pDevice->getDescriptorStats().poolPagesRecycled, after.poolPagesRecycled);
+}
+
+}  // namespace Falcor
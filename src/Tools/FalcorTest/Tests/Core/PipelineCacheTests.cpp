@@ -0,0 +1,136 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Falcor/Core/API/PipelineCache.h"
+
+namespace Falcor {
+
+namespace {
+
+PipelineCache::DeviceIdentity makeIdentity() {
+    PipelineCache::DeviceIdentity identity;
+    identity.vendorID = 0x10de;
+    identity.deviceID = 0x2204;
+    identity.driverVersion = 0x1d4c8000;
+    for (uint32_t i = 0; i < 16; i++) identity.pipelineCacheUUID[i] = (uint8_t)(i * 7 + 1);
+    return identity;
+}
+
+/** Driver cache data as vkGetPipelineCacheData returns it: a VkPipelineCacheHeaderVersionOne followed by opaque data.
+*/
+std::vector<uint8_t> makeDriverData(const PipelineCache::DeviceIdentity& identity, size_t payloadSize) {
+    std::vector<uint8_t> data(32 + payloadSize);
+    uint32_t header[4] = { 32, 1, identity.vendorID, identity.deviceID };
+    std::memcpy(data.data(), header, sizeof(header));
+    std::memcpy(data.data() + sizeof(header), identity.pipelineCacheUUID, 16);
+    for (size_t i = 0; i < payloadSize; i++) data[32 + i] = (uint8_t)(i * 31 + 5);
+    return data;
+}
+
+}  // namespace
+
+CPU_TEST(PipelineCacheRoundTrip)
+{
+    auto identity = makeIdentity();
+    auto driverData = makeDriverData(identity, 1000);
+
+    auto file = PipelineCache::serialize(identity, driverData.data(), driverData.size());
+    std::vector<uint8_t> data;
+    EXPECT(PipelineCache::deserialize(file, identity, data));
+    EXPECT(data == driverData);
+}
+
+CPU_TEST(PipelineCacheRejectOtherDevice)
+{
+    auto identity = makeIdentity();
+    auto file = PipelineCache::serialize(identity, makeDriverData(identity, 64).data(), 32 + 64);
+    std::vector<uint8_t> data;
+
+    auto other = identity;
+    other.driverVersion++;
+    EXPECT(!PipelineCache::deserialize(file, other, data));
+    EXPECT(data.empty());
+
+    other = identity;
+    other.deviceID++;
+    EXPECT(!PipelineCache::deserialize(file, other, data));
+
+    other = identity;
+    other.pipelineCacheUUID[15] ^= 1;
+    EXPECT(!PipelineCache::deserialize(file, other, data));
+}
+
+CPU_TEST(PipelineCacheRejectCorrupted)
+{
+    auto identity = makeIdentity();
+    auto driverData = makeDriverData(identity, 256);
+    auto file = PipelineCache::serialize(identity, driverData.data(), driverData.size());
+    std::vector<uint8_t> data;
+
+    // Flipped payload byte
+    auto corrupted = file;
+    corrupted[corrupted.size() - 10] ^= 0x40;
+    EXPECT(!PipelineCache::deserialize(corrupted, identity, data));
+
+    // Truncated file
+    auto truncated = file;
+    truncated.resize(file.size() - 1);
+    EXPECT(!PipelineCache::deserialize(truncated, identity, data));
+    truncated.resize(8);
+    EXPECT(!PipelineCache::deserialize(truncated, identity, data));
+    EXPECT(!PipelineCache::deserialize({}, identity, data));
+
+    // Bad magic
+    auto badMagic = file;
+    badMagic[0] = 'X';
+    EXPECT(!PipelineCache::deserialize(badMagic, identity, data));
+}
+
+CPU_TEST(PipelineCacheRejectForeignDriverData)
+{
+    // The file header matches but the driver data was produced by another device.
+    auto identity = makeIdentity();
+    auto other = identity;
+    other.vendorID = 0x1002;
+    auto driverData = makeDriverData(other, 128);
+    auto file = PipelineCache::serialize(identity, driverData.data(), driverData.size());
+    std::vector<uint8_t> data;
+    EXPECT(!PipelineCache::deserialize(file, identity, data));
+
+    // Bad driver header version
+    driverData = makeDriverData(identity, 128);
+    driverData[4] = 2;
+    file = PipelineCache::serialize(identity, driverData.data(), driverData.size());
+    EXPECT(!PipelineCache::deserialize(file, identity, data));
+
+    // Too small to hold the driver header
+    file = PipelineCache::serialize(identity, driverData.data(), 16);
+    EXPECT(!PipelineCache::deserialize(file, identity, data));
+}
+
+}  // namespace Falcor
@@ -0,0 +1,152 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include <chrono>
+
+namespace Falcor {
+
+namespace {
+
+/** Uniform-only stand-in for the scene block, built by hand so the tests don't need a compiled program:
+
+    struct Light { float3 posW; float intensity; };
+    struct Camera { float4x4 viewMat; float4 data; };
+    struct Scene { uint lightCount; Light lights[4]; Camera camera; };
+*/
+ReflectionType::SharedConstPtr createSceneType() {
+    using Basic = ReflectionBasicType;
+    ReflectionStructType::BuildState state;
+
+    auto pLight = ReflectionStructType::create(16, "Light", nullptr);
+    pLight->addMember(ReflectionVar::create("posW", Basic::create(Basic::Type::Float3, false, 12, nullptr), ShaderVarOffset(UniformShaderVarOffset(0), ResourceShaderVarOffset::kZero)), state);
+    pLight->addMember(ReflectionVar::create("intensity", Basic::create(Basic::Type::Float, false, 4, nullptr), ShaderVarOffset(UniformShaderVarOffset(12), ResourceShaderVarOffset::kZero)), state);
+
+    auto pCamera = ReflectionStructType::create(80, "Camera", nullptr);
+    pCamera->addMember(ReflectionVar::create("viewMat", Basic::create(Basic::Type::Float4x4, false, 64, nullptr), ShaderVarOffset(UniformShaderVarOffset(0), ResourceShaderVarOffset::kZero)), state);
+    pCamera->addMember(ReflectionVar::create("data", Basic::create(Basic::Type::Float4, false, 16, nullptr), ShaderVarOffset(UniformShaderVarOffset(64), ResourceShaderVarOffset::kZero)), state);
+
+    auto pLights = ReflectionArrayType::create(4, 16, pLight, 64, nullptr);
+
+    auto pScene = ReflectionStructType::create(160, "Scene", nullptr);
+    pScene->addMember(ReflectionVar::create("lightCount", Basic::create(Basic::Type::Uint, false, 4, nullptr), ShaderVarOffset(UniformShaderVarOffset(0), ResourceShaderVarOffset::kZero)), state);
+    pScene->addMember(ReflectionVar::create("lights", pLights, ShaderVarOffset(UniformShaderVarOffset(16), ResourceShaderVarOffset::kZero)), state);
+    pScene->addMember(ReflectionVar::create("camera", pCamera, ShaderVarOffset(UniformShaderVarOffset(80), ResourceShaderVarOffset::kZero)), state);
+    return pScene;
+}
+
+}  // namespace
+
+CPU_TEST(ShaderVarHandleResolve)
+{
+    auto pSceneType = createSceneType();
+    ShaderVar sceneVar(nullptr, pSceneType->getZeroOffset());
+
+    ShaderVarHandle lightCount("lightCount");
+    EXPECT(!lightCount.isValid());
+    EXPECT(lightCount.resolve(sceneVar));
+    EXPECT(lightCount.isResolvedFor(sceneVar));
+    EXPECT_EQ(sceneVar[lightCount].getByteOffset(), sceneVar["lightCount"].getByteOffset());
+
+    // Dotted paths walk nested structs
+    ShaderVarHandle cameraData("camera.data");
+    EXPECT(cameraData.resolve(sceneVar));
+    EXPECT_EQ(sceneVar[cameraData].getByteOffset(), sceneVar["camera"]["data"].getByteOffset());
+    EXPECT_EQ(sceneVar[cameraData].getByteOffset(), 144u);
+    EXPECT(sceneVar[cameraData].getType() == sceneVar["camera"]["data"].getType());
+
+    // Handles resolved against an array element apply to every element
+    ShaderVarHandle intensity("intensity");
+    EXPECT(intensity.resolve(sceneVar["lights"][size_t(0)]));
+    EXPECT(intensity.isResolvedFor(sceneVar["lights"][3]));
+    EXPECT(!intensity.isResolvedFor(sceneVar));
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        EXPECT_EQ(sceneVar["lights"][i][intensity].getByteOffset(), sceneVar["lights"][i]["intensity"].getByteOffset());
+    }
+
+    // A type with the same layout from another program version doesn't match
+    auto pOtherSceneType = createSceneType();
+    ShaderVar otherSceneVar(nullptr, pOtherSceneType->getZeroOffset());
+    EXPECT(!lightCount.isResolvedFor(otherSceneVar));
+    EXPECT(lightCount.resolve(otherSceneVar));
+    EXPECT(lightCount.isResolvedFor(otherSceneVar));
+}
+
+CPU_TEST(ShaderVarHandleInvalidPath)
+{
+    auto pSceneType = createSceneType();
+    ShaderVar sceneVar(nullptr, pSceneType->getZeroOffset());
+
+    ShaderVarHandle missing("camera.position");
+    EXPECT(!missing.resolve(sceneVar));
+    EXPECT(!missing.isValid());
+    EXPECT(!missing.isResolvedFor(sceneVar));
+
+    ShaderVarHandle unresolvedParent("lightCount");
+    EXPECT(!unresolvedParent.resolve(ShaderVar()));
+    EXPECT(!unresolvedParent.isValid());
+}
+
+CPU_TEST(ShaderVarHandleBenchmark)
+{
+    // The per-frame pattern of uploadMaterial(): an array element, then a few members of it
+    const uint32_t kIterations = 200000;
+    auto pSceneType = createSceneType();
+    ShaderVar sceneVar(nullptr, pSceneType->getZeroOffset());
+
+    ShaderVarHandle lights("lights");
+    ShaderVarHandle posW("posW");
+    ShaderVarHandle intensity("intensity");
+    lights.resolve(sceneVar);
+    posW.resolve(sceneVar[lights][size_t(0)]);
+    intensity.resolve(sceneVar[lights][size_t(0)]);
+
+    size_t checksumByName = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < kIterations; i++)
+    {
+        auto var = sceneVar["lights"][i & 3];
+        checksumByName += var["posW"].getByteOffset() + var["intensity"].getByteOffset();
+    }
+    double byNameMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    size_t checksumByHandle = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < kIterations; i++)
+    {
+        auto var = sceneVar[lights][i & 3];
+        checksumByHandle += var[posW].getByteOffset() + var[intensity].getByteOffset();
+    }
+    double byHandleMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    EXPECT_EQ(checksumByName, checksumByHandle);
+    logInfo("ShaderVarHandleBenchmark: " + std::to_string(kIterations * 3) + " lookups, " + std::to_string(byNameMs * 1e6 / (kIterations * 3)) +
+        " ns per lookup by name, " + std::to_string(byHandleMs * 1e6 / (kIterations * 3)) + " ns per lookup by handle.");
+}
+
+}  // namespace Falcor
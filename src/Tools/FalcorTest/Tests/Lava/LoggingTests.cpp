@@ -0,0 +1,323 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "lava_utils_lib/logging.h"
+#include "lava_utils_lib/log_ring.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+namespace Falcor {
+
+namespace {
+
+using namespace lava::ut::log;
+
+/** Read back what was written to a sink, keeping only the messages (the text after the prefix) starting with `tag`.
+*/
+std::vector<std::string> readMessages(FILE* pFile, const std::string& tag, std::vector<uint64_t>* pLineIDs = nullptr) {
+    std::fflush(pFile);
+    std::rewind(pFile);
+    std::vector<std::string> messages;
+    char line[512];
+    while (std::fgets(line, sizeof(line), pFile)) {
+        std::string s(line);
+        size_t pos = s.find("] - ");
+        if (pos == std::string::npos) continue;
+        std::string message = s.substr(pos + 4);
+        if (!message.empty() && message.back() == '\n') message.pop_back();
+        if (message.compare(0, tag.size(), tag) != 0) continue;
+        messages.push_back(message);
+        if (pLineIDs) pLineIDs->push_back(std::strtoull(line, nullptr, 10));
+    }
+    return messages;
+}
+
+}  // namespace
+
+CPU_TEST(LogRingFull)
+{
+    Ring<uint32_t> ring(5);
+    EXPECT_EQ(ring.capacity(), 8u);
+
+    for (uint32_t i = 0; i < 8; i++) EXPECT(ring.tryPush([i](uint32_t& v) { v = i; }));
+    EXPECT(!ring.tryPush([](uint32_t& v) { v = 100; }));
+
+    uint32_t value = 0;
+    EXPECT(ring.tryPop([&](uint32_t& v) { value = v; }));
+    EXPECT_EQ(value, 0u);
+    EXPECT(ring.tryPush([](uint32_t& v) { v = 8; }));
+
+    for (uint32_t i = 1; i <= 8; i++) {
+        EXPECT(ring.tryPop([&](uint32_t& v) { value = v; }));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT(!ring.tryPop([](uint32_t&) {}));
+    EXPECT_EQ(ring.pushCount(), 9u);
+    EXPECT_EQ(ring.popCount(), 9u);
+}
+
+CPU_TEST(LogRingMultiProducer)
+{
+    // A small ring, so producers keep running into a full ring while the consumer drains it
+    const uint32_t kProducers = 8;
+    const uint32_t kValues = 100000;
+    Ring<uint64_t> ring(64);
+
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < kProducers; p++) {
+        producers.emplace_back([&ring, p]() {
+            for (uint32_t i = 0; i < kValues; i++) {
+                uint64_t value = (uint64_t(p) << 32) | i;
+                while (!ring.tryPush([value](uint64_t& v) { v = value; })) std::this_thread::yield();
+            }
+        });
+    }
+
+    // Each producer's values must come out in the order they were pushed, none lost or duplicated
+    std::vector<uint32_t> next(kProducers, 0);
+    uint64_t popped = 0;
+    uint32_t outOfOrder = 0;
+    while (popped < uint64_t(kProducers) * kValues) {
+        if (!ring.tryPop([&](uint64_t& v) {
+            uint32_t p = uint32_t(v >> 32);
+            if (p >= kProducers || uint32_t(v) != next[p]++) outOfOrder++;
+        })) {
+            std::this_thread::yield();
+            continue;
+        }
+        popped++;
+    }
+    for (auto& t : producers) t.join();
+
+    EXPECT_EQ(outOfOrder, 0u);
+    for (uint32_t p = 0; p < kProducers; p++) EXPECT_EQ(next[p], kValues) << "producer " << p;
+    EXPECT(!ring.tryPop([](uint64_t&) {}));
+}
+
+CPU_TEST(LogSinkOrdering)
+{
+    const uint32_t kThreads = 8;
+    const uint32_t kMessages = 20000;
+
+    FILE* pFile = std::tmpfile();
+    EXPECT(pFile != nullptr);
+    if (!pFile) return;
+    int sinkID = add_sink(pFile, false);
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < kThreads; t++) {
+        threads.emplace_back([t]() {
+            for (uint32_t i = 0; i < kMessages; i++) {
+                // Every other record goes through the streaming macro, the long ones don't fit a ring cell
+                if (i & 1) LLOG_INF << "LogSinkOrdering " << t << " " << i;
+                else submit(Severity::info, "LogSinkOrdering " + std::to_string(t) + " " + std::to_string(i) + (i % 64 ? "" : std::string(300, '.')));
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    flush_log();
+
+    std::vector<uint64_t> lineIDs;
+    auto messages = readMessages(pFile, "LogSinkOrdering ", &lineIDs);
+    remove_sink(sinkID);
+    std::fclose(pFile);
+
+    EXPECT_EQ(messages.size(), size_t(kThreads) * kMessages);
+    std::vector<uint32_t> next(kThreads, 0);
+    uint32_t outOfOrder = 0;
+    for (const auto& message : messages) {
+        uint32_t t = 0, i = 0;
+        if (std::sscanf(message.c_str(), "LogSinkOrdering %u %u", &t, &i) != 2 || t >= kThreads || i != next[t]++) outOfOrder++;
+    }
+    EXPECT_EQ(outOfOrder, 0u);
+    for (uint32_t t = 0; t < kThreads; t++) EXPECT_EQ(next[t], kMessages) << "thread " << t;
+
+    // Line IDs number the records in the order they are written
+    uint32_t unordered = 0;
+    for (size_t i = 1; i < lineIDs.size(); i++) unordered += lineIDs[i] <= lineIDs[i - 1] ? 1 : 0;
+    EXPECT_EQ(unordered, 0u);
+}
+
+CPU_TEST(LogSeverityFilter)
+{
+    FILE* pFile = std::tmpfile();
+    EXPECT(pFile != nullptr);
+    if (!pFile) return;
+    int sinkID = add_sink(pFile, false, Severity::warning);
+
+    // Filtered records must not evaluate what they stream
+    Severity previous = min_severity();
+    set_min_severity(Severity::info);
+    uint32_t evaluated = 0;
+    auto count = [&evaluated]() { return ++evaluated; };
+    LLOG_DBG << "LogSeverityFilter debug " << count();
+    LLOG_INF << "LogSeverityFilter info " << count();
+    LLOG_WRN << "LogSeverityFilter warning " << count();
+    set_min_severity(previous);
+    flush_log();
+
+    auto messages = readMessages(pFile, "LogSeverityFilter ");
+    remove_sink(sinkID);
+    std::fclose(pFile);
+
+    EXPECT_EQ(evaluated, 2u);
+    EXPECT_EQ(messages.size(), 1u);
+    if (messages.size() == 1) {
+        EXPECT_EQ(messages[0], "LogSeverityFilter warning 2");
+    }
+
+    std::stringstream ss("warning bogus");
+    Severity severity = Severity::trace;
+    ss >> severity;
+    EXPECT(severity == Severity::warning);
+    ss >> severity;
+    EXPECT(ss.fail());
+}
+
+CPU_TEST(LogChannels)
+{
+    FILE* pLavaFile = std::tmpfile();
+    FILE* pFalcorFile = std::tmpfile();
+    FILE* pAllFile = std::tmpfile();
+    EXPECT(pLavaFile && pFalcorFile && pAllFile);
+    if (!pLavaFile || !pFalcorFile || !pAllFile) return;
+    int lavaSinkID = add_sink(pLavaFile, false, Severity::trace, uint32_t(Channel::lava));
+    int falcorSinkID = add_sink(pFalcorFile, false, Severity::trace, uint32_t(Channel::falcor));
+    int allSinkID = add_sink(pAllFile, false);
+
+    submit(Severity::info, "LogChannels lava");
+    submit(Severity::info, "LogChannels falcor", Channel::falcor);
+    flush_log();
+
+    auto lavaMessages = readMessages(pLavaFile, "LogChannels ");
+    auto falcorMessages = readMessages(pFalcorFile, "LogChannels ");
+    auto allMessages = readMessages(pAllFile, "LogChannels ");
+    remove_sink(lavaSinkID);
+    remove_sink(falcorSinkID);
+    remove_sink(allSinkID);
+    std::fclose(pLavaFile);
+    std::fclose(pFalcorFile);
+    std::fclose(pAllFile);
+
+    EXPECT(lavaMessages == std::vector<std::string>({ "LogChannels lava" }));
+    EXPECT(falcorMessages == std::vector<std::string>({ "LogChannels falcor" }));
+    EXPECT(allMessages == std::vector<std::string>({ "LogChannels lava", "LogChannels falcor" }));
+}
+
+CPU_TEST(LogCrashFlush)
+{
+    const uint32_t kMessages = 5000;
+
+    FILE* pFile = std::tmpfile();
+    EXPECT(pFile != nullptr);
+    if (!pFile) return;
+    int sinkID = add_sink(pFile, false);
+
+    // Whatever the writer hasn't picked up yet is drained by the crash path, racing the writer
+    for (uint32_t i = 0; i < kMessages; i++) submit(Severity::info, "LogCrashFlush " + std::to_string(i));
+    flush_log_on_crash();
+
+    // Records drained by the crash path count as written, so this must not wait forever
+    flush_log();
+
+    std::vector<uint64_t> lineIDs;
+    auto messages = readMessages(pFile, "LogCrashFlush ", &lineIDs);
+
+    // Both paths write the same prefix
+    std::vector<int64_t> minutes;
+    std::rewind(pFile);
+    char line[512];
+    uint32_t badPrefixes = 0;
+    while (std::fgets(line, sizeof(line), pFile)) {
+        if (!std::strstr(line, "LogCrashFlush ")) continue;
+        unsigned long long id = 0;
+        int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0, micro = 0, length = 0;
+        int fields = std::sscanf(line, "%llu | %4d-%2d-%2d, %2d:%2d:%2d.%6d [info] - %n", &id, &year, &month, &day, &hour, &minute, &second, &micro, &length);
+        if (fields != 8 || length == 0) badPrefixes++;
+        int64_t minuteStamp = ((int64_t(year) * 100 + month) * 100 + day) * 10000 + hour * 100 + minute;
+        if (std::find(minutes.begin(), minutes.end(), minuteStamp) == minutes.end()) minutes.push_back(minuteStamp);
+    }
+    remove_sink(sinkID);
+    std::fclose(pFile);
+
+    EXPECT_EQ(messages.size(), size_t(kMessages));
+    EXPECT_EQ(badPrefixes, 0u);
+    EXPECT_LE(minutes.size(), 2u) << "crash and writer timestamps disagree";
+    std::sort(lineIDs.begin(), lineIDs.end());
+    EXPECT(std::adjacent_find(lineIDs.begin(), lineIDs.end()) == lineIDs.end());
+}
+
+CPU_TEST(LogBenchmark)
+{
+    const uint32_t kMessages = 100000;
+    const char* kText = "LogBenchmark message with a few words of text, about as long as the average loader log line";
+
+    FILE* pFile = std::tmpfile();
+    EXPECT(pFile != nullptr);
+    if (!pFile) return;
+
+    // Wall time over the messages of one thread, i.e. the ns per message each thread sees while all of them log at once
+    auto run = [&](uint32_t threadCount, auto&& logMessage) {
+        std::vector<std::thread> threads;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t t = 0; t < threadCount; t++) {
+            threads.emplace_back([&]() {
+                for (uint32_t i = 0; i < kMessages; i++) logMessage(i);
+            });
+        }
+        for (auto& t : threads) t.join();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+        return ns / kMessages;
+    };
+
+    int sinkID = add_sink(pFile, false);
+    for (uint32_t threadCount : { 1u, 2u, 4u, 8u }) {
+        double ring = run(threadCount, [&](uint32_t) { submit(Severity::info, kText, std::strlen(kText)); });
+        auto start = std::chrono::high_resolution_clock::now();
+        flush_log();
+        double drainMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        // What Logger::log did before: format on the calling thread, fprintf and fflush per line
+        double direct = run(threadCount, [&](uint32_t i) {
+            std::fprintf(pFile, "%07u | (Info)\t%s\n", i, kText);
+            std::fflush(pFile);
+        });
+
+        logInfo("LogBenchmark: " + std::to_string(threadCount) + " threads, " + std::to_string(ring) + " ns/message/thread queued (" +
+            std::to_string(drainMs) + " ms to drain), " + std::to_string(direct) + " ns/message/thread with fprintf+fflush.");
+    }
+    remove_sink(sinkID);
+    std::fclose(pFile);
+}
+
+}  // namespace Falcor
@@ -0,0 +1,262 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "pxr/imaging/plugin/hdLava/sceneSync.h"
+
+#include <thread>
+
+namespace Falcor
+{
+    namespace
+    {
+        using namespace lava;
+
+        struct MockBackend : SceneSyncBackend
+        {
+            struct Mesh
+            {
+                std::vector<glm::vec3> points;
+                std::vector<uint32_t> indices;
+                std::vector<glm::vec2> uvs;
+                std::vector<glm::mat4> instances;
+            };
+
+            MeshHandle createMesh(const MeshSyncData& mesh) override
+            {
+                MeshHandle handle = nextHandle++;
+                meshes[handle] = { mesh.points, triangulate(mesh.faceVertexCounts, mesh.faceVertexIndices, mesh.points.size()), mesh.uvs, {} };
+                return handle;
+            }
+            void destroyMesh(MeshHandle mesh) override { meshes.erase(mesh); }
+            void updatePoints(MeshHandle mesh, const std::vector<glm::vec3>& points) override { meshes.at(mesh).points = points; }
+            void updatePrimvars(MeshHandle mesh, const MeshSyncData& data) override { meshes.at(mesh).uvs = data.uvs; }
+            void updateInstances(MeshHandle mesh, const std::vector<glm::mat4>& transforms) override { meshes.at(mesh).instances = transforms; }
+
+            std::map<MeshHandle, Mesh> meshes;
+            MeshHandle nextHandle = 0;
+        };
+
+        MeshSyncData makeQuad(float z = 0.f)
+        {
+            MeshSyncData data;
+            data.points = { { 0, 0, z }, { 1, 0, z }, { 1, 1, z }, { 0, 1, z } };
+            data.faceVertexCounts = { 4 };
+            data.faceVertexIndices = { 0, 1, 2, 3 };
+            data.uvs = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+            return data;
+        }
+    }
+
+    CPU_TEST(SceneSyncTriangulate)
+    {
+        // A quad, a degenerate face, a pentagon and a face with an out of range index.
+        std::vector<int32_t> counts = { 4, 2, 5, 3 };
+        std::vector<int32_t> indices = { 0, 1, 2, 3, 0, 1, 0, 1, 2, 3, 4, 0, 1, 9 };
+        auto triangles = triangulate(counts, indices, 5);
+
+        std::vector<uint32_t> expected = { 0, 1, 2, 0, 2, 3, 0, 1, 2, 0, 2, 3, 0, 3, 4 };
+        EXPECT(triangles == expected);
+    }
+
+    CPU_TEST(SceneSyncCreateAndRemove)
+    {
+        SceneSync sync;
+        MockBackend backend;
+
+        sync.syncMesh("/quad", SyncDirtyBits::All, makeQuad());
+        EXPECT(sync.hasPendingChanges());
+        auto stats = sync.commit(backend);
+        EXPECT(!sync.hasPendingChanges());
+        EXPECT_EQ(stats.created, 1u);
+        EXPECT_EQ(stats.instanceUpdates, 1u);
+        EXPECT_EQ(backend.meshes.size(), 1u);
+        EXPECT_EQ(backend.meshes.begin()->second.indices.size(), 6u);
+        EXPECT_EQ(backend.meshes.begin()->second.instances.size(), 1u);
+
+        // Nothing dirty, nothing to do.
+        sync.syncMesh("/quad", SyncDirtyBits::None, MeshSyncData());
+        EXPECT(!sync.hasPendingChanges());
+
+        sync.removeMesh("/quad");
+        stats = sync.commit(backend);
+        EXPECT_EQ(stats.destroyed, 1u);
+        EXPECT_EQ(backend.meshes.size(), 0u);
+        EXPECT_EQ(sync.getMeshCount(), 0u);
+    }
+
+    CPU_TEST(SceneSyncPartialUpdates)
+    {
+        SceneSync sync;
+        MockBackend backend;
+        sync.syncMesh("/quad", SyncDirtyBits::All, makeQuad());
+        sync.commit(backend);
+        auto handle = backend.meshes.begin()->first;
+
+        // Moving points keeps the mesh and its instances.
+        MeshSyncData moved;
+        moved.points = makeQuad(2.f).points;
+        sync.syncMesh("/quad", SyncDirtyBits::Points, std::move(moved));
+        auto stats = sync.commit(backend);
+        EXPECT_EQ(stats.created, 0u);
+        EXPECT_EQ(stats.pointUpdates, 1u);
+        EXPECT_EQ(stats.instanceUpdates, 0u);
+        EXPECT_EQ(backend.meshes.at(handle).points[0].z, 2.f);
+        EXPECT_EQ(backend.meshes.at(handle).uvs.size(), 4u);
+
+        // Transform only touches the instances.
+        MeshSyncData moveMesh;
+        moveMesh.transform = glm::mat4(1.f);
+        moveMesh.transform[3] = glm::vec4(5, 0, 0, 1);
+        sync.syncMesh("/quad", SyncDirtyBits::Transform, std::move(moveMesh));
+        stats = sync.commit(backend);
+        EXPECT_EQ(stats.created + stats.pointUpdates + stats.primvarUpdates, 0u);
+        EXPECT_EQ(stats.instanceUpdates, 1u);
+        EXPECT_EQ(backend.meshes.at(handle).instances[0][3].x, 5.f);
+        EXPECT_EQ(backend.meshes.at(handle).points[0].z, 2.f);
+
+        // Hiding empties the instance list, showing brings back the transform.
+        MeshSyncData hidden;
+        hidden.visible = false;
+        sync.syncMesh("/quad", SyncDirtyBits::Visibility, std::move(hidden));
+        sync.commit(backend);
+        EXPECT_EQ(backend.meshes.at(handle).instances.size(), 0u);
+        sync.syncMesh("/quad", SyncDirtyBits::Visibility, MeshSyncData());
+        sync.commit(backend);
+        EXPECT_EQ(backend.meshes.at(handle).instances.size(), 1u);
+        EXPECT_EQ(backend.meshes.at(handle).instances[0][3].x, 5.f);
+
+        // Changing the point count or topology recreates the geometry.
+        MeshSyncData triangle;
+        triangle.points = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 } };
+        triangle.faceVertexCounts = { 3 };
+        triangle.faceVertexIndices = { 0, 1, 2 };
+        sync.syncMesh("/quad", SyncDirtyBits::Points | SyncDirtyBits::Topology, std::move(triangle));
+        stats = sync.commit(backend);
+        EXPECT_EQ(stats.destroyed, 1u);
+        EXPECT_EQ(stats.created, 1u);
+        EXPECT_EQ(backend.meshes.size(), 1u);
+        EXPECT_EQ(backend.meshes.begin()->second.indices.size(), 3u);
+        EXPECT_EQ(backend.meshes.begin()->second.instances[0][3].x, 5.f);
+    }
+
+    CPU_TEST(SceneSyncMergesPendingChanges)
+    {
+        SceneSync sync;
+        MockBackend backend;
+        sync.syncMesh("/quad", SyncDirtyBits::All, makeQuad());
+        sync.commit(backend);
+
+        // Two syncs before a commit merge into one update with the latest data.
+        sync.syncMesh("/quad", SyncDirtyBits::Points, makeQuad(1.f));
+        sync.syncMesh("/quad", SyncDirtyBits::Points, makeQuad(3.f));
+        auto stats = sync.commit(backend);
+        EXPECT_EQ(stats.pointUpdates, 1u);
+        EXPECT_EQ(backend.meshes.begin()->second.points[0].z, 3.f);
+
+        // A removal followed by a sync in the same frame keeps the mesh.
+        sync.removeMesh("/quad");
+        sync.syncMesh("/quad", SyncDirtyBits::All, makeQuad());
+        sync.commit(backend);
+        EXPECT_EQ(backend.meshes.size(), 1u);
+    }
+
+    CPU_TEST(SceneSyncInstances)
+    {
+        SceneSync sync;
+        MockBackend backend;
+
+        MeshSyncData data = makeQuad();
+        data.transform = glm::mat4(2.f);
+        data.transform[3][3] = 1.f;
+        for (int i = 0; i < 3; i++)
+        {
+            glm::mat4 instance(1.f);
+            instance[3] = glm::vec4(float(i), 0, 0, 1);
+            data.instanceTransforms.push_back(instance);
+        }
+        sync.syncMesh("/quad", SyncDirtyBits::All, std::move(data));
+        sync.commit(backend);
+
+        // The prim transform applies first, then the instance transform.
+        const auto& instances = backend.meshes.begin()->second.instances;
+        EXPECT_EQ(instances.size(), 3u);
+        for (int i = 0; i < 3; i++)
+        {
+            glm::vec4 p = instances[i] * glm::vec4(1, 1, 0, 1);
+            EXPECT_EQ(p.x, 2.f + float(i));
+            EXPECT_EQ(p.y, 2.f);
+        }
+
+        MeshSyncData fewer;
+        fewer.instanceTransforms = { glm::mat4(1.f) };
+        sync.syncMesh("/quad", SyncDirtyBits::Instances, std::move(fewer));
+        auto stats = sync.commit(backend);
+        EXPECT_EQ(stats.created, 0u);
+        EXPECT_EQ(backend.meshes.begin()->second.instances.size(), 1u);
+    }
+
+    CPU_TEST(SceneSyncParallel)
+    {
+        const uint32_t kThreadCount = 8;
+        const uint32_t kMeshesPerThread = 64;
+        SceneSync sync;
+        MockBackend backend;
+
+        // Hydra syncs rprims from worker threads, commit runs once they are done.
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < kThreadCount; t++)
+        {
+            threads.emplace_back([&sync, t]()
+            {
+                for (uint32_t i = 0; i < kMeshesPerThread; i++)
+                {
+                    sync.syncMesh("/mesh" + std::to_string(t * kMeshesPerThread + i), SyncDirtyBits::All, makeQuad(float(t)));
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+
+        auto stats = sync.commit(backend);
+        EXPECT_EQ(stats.created, kThreadCount * kMeshesPerThread);
+        EXPECT_EQ(backend.meshes.size(), size_t(kThreadCount * kMeshesPerThread));
+        EXPECT_EQ(sync.getMeshCount(), size_t(kThreadCount * kMeshesPerThread));
+
+        // Commit order only depends on the prim ids.
+        MockBackend other;
+        SceneSync reversed;
+        for (uint32_t i = kThreadCount * kMeshesPerThread; i-- > 0;)
+        {
+            reversed.syncMesh("/mesh" + std::to_string(i), SyncDirtyBits::All, makeQuad(float(i / kMeshesPerThread)));
+        }
+        reversed.commit(other);
+        for (const auto& [handle, mesh] : backend.meshes)
+        {
+            EXPECT_EQ(mesh.points[0].z, other.meshes.at(handle).points[0].z);
+        }
+    }
+}
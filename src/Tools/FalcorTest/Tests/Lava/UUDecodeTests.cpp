@@ -0,0 +1,237 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "lava_lib/reader_lsd/uudecode.h"
+
+#include <chrono>
+#include <random>
+#include <sstream>
+
+namespace Falcor {
+
+namespace {
+
+using namespace lava::lsd;
+
+uint16_t crc16(const std::vector<unsigned char>& data) {
+    uint16_t crc = 0;
+    for (unsigned char c : data) {
+        uint16_t t = crc & 0xFF00;
+        for (int i = 0; i < 8; i++) t = (t & 0x8000) ? uint16_t(t << 1) ^ 0x1021 : uint16_t(t << 1);
+        crc = t ^ uint16_t(crc << 8) ^ c;
+    }
+    return crc;
+}
+
+/** Reference uuencoder, with the 45 byte lines and '`' for zero of the common implementations.
+*/
+std::string encodeUU(const std::vector<unsigned char>& data, const char* lineEnd = "\n", bool withCRC = false) {
+    auto enc = [](uint32_t v) { return char(v ? (v & 0x3F) + ' ' : '`'); };
+
+    std::string text = std::string("begin 644 embedded.bgeo") + lineEnd;
+    for (size_t offset = 0; offset < data.size(); offset += 45) {
+        size_t count = std::min<size_t>(45, data.size() - offset);
+        text += enc(uint32_t(count));
+        for (size_t i = 0; i < count; i += 3) {
+            uint32_t b0 = data[offset + i];
+            uint32_t b1 = i + 1 < count ? data[offset + i + 1] : 0;
+            uint32_t b2 = i + 2 < count ? data[offset + i + 2] : 0;
+            text += enc(b0 >> 2);
+            text += enc(((b0 << 4) | (b1 >> 4)) & 0x3F);
+            text += enc(((b1 << 2) | (b2 >> 6)) & 0x3F);
+            text += enc(b2 & 0x3F);
+        }
+        text += lineEnd;
+    }
+    text += std::string("`") + lineEnd;
+    if (withCRC) {
+        char crc[16];
+        std::snprintf(crc, sizeof(crc), "CRC= %04X", crc16(data));
+        text += std::string(crc) + lineEnd;
+    }
+    text += std::string("end") + lineEnd;
+    return text;
+}
+
+std::vector<unsigned char> randomData(std::mt19937& rng, size_t size) {
+    std::vector<unsigned char> data(size);
+    for (auto& c : data) c = (unsigned char)rng();
+    return data;
+}
+
+}  // namespace
+
+CPU_TEST(UUDecodeRoundTrip)
+{
+    std::mt19937 rng(48);
+    const size_t kChunkSizes[] = { 1, 3, 61, 4096, size_t(-1) };
+
+    for (size_t size : { 0, 1, 2, 3, 44, 45, 46, 89, 90, 1000, 100000 }) {
+        auto data = randomData(rng, size);
+        std::string text = encodeUU(data);
+
+        for (size_t chunkSize : kChunkSizes) {
+            std::vector<unsigned char> decoded;
+            uu::Decoder decoder(decoded);
+            for (size_t offset = 0; offset < text.size(); offset += chunkSize) {
+                EXPECT(decoder.feed(text.data() + offset, std::min(chunkSize, text.size() - offset)));
+            }
+            EXPECT(decoder.finish()) << decoder.error();
+            EXPECT(decoded == data) << "size " << size << ", chunks of " << chunkSize;
+            EXPECT_EQ(decoder.fileName(), "embedded.bgeo");
+            EXPECT_EQ(decoder.mode(), 0644u);
+        }
+
+        std::vector<unsigned char> decoded;
+        EXPECT(uu::decodeUU(text.data(), text.size(), decoded));
+        EXPECT(decoded == data) << "size " << size;
+    }
+}
+
+CPU_TEST(UUDecodeLineFormats)
+{
+    std::mt19937 rng(48);
+    auto data = randomData(rng, 500);
+
+    // CRLF line breaks
+    std::vector<unsigned char> decoded;
+    EXPECT(uu::decodeUU(encodeUU(data, "\r\n").c_str(), encodeUU(data, "\r\n").size(), decoded));
+    EXPECT(decoded == data);
+
+    // Encoders that use spaces for zeros and strip them at the end of lines
+    std::vector<unsigned char> zeros(90, 0);
+    zeros[0] = 0xFF;
+    std::string text = "begin 644 zeros\nM_P\nM\n`\nend\n";
+    decoded.clear();
+    EXPECT(uu::decodeUU(text.data(), text.size(), decoded));
+    EXPECT(decoded == zeros);
+
+    // No line break after the end line, and data past it is ignored
+    text = encodeUU(data);
+    text.pop_back();
+    decoded.clear();
+    EXPECT(uu::decodeUU(text.data(), text.size(), decoded));
+    EXPECT(decoded == data);
+    text += "\ntrailing garbage\n";
+    decoded.clear();
+    EXPECT(uu::decodeUU(text.data(), text.size(), decoded));
+    EXPECT(decoded == data);
+}
+
+CPU_TEST(UUDecodeCRC)
+{
+    std::mt19937 rng(48);
+    auto data = randomData(rng, 1000);
+    std::string text = encodeUU(data, "\n", true);
+
+    std::vector<unsigned char> decoded;
+    std::string error;
+    EXPECT(uu::decodeUU(text.data(), text.size(), decoded, true, &error)) << error;
+    EXPECT(decoded == data);
+
+    // One flipped bit in the data
+    std::string corrupted = text;
+    corrupted[corrupted.find('\n') + 10] ^= 0x01;
+    decoded.clear();
+    EXPECT(!uu::decodeUU(corrupted.data(), corrupted.size(), decoded, true, &error));
+    EXPECT(error.find("CRC") != std::string::npos) << error;
+
+    // CRC required but missing
+    text = encodeUU(data);
+    decoded.clear();
+    EXPECT(!uu::decodeUU(text.data(), text.size(), decoded, true, &error));
+    EXPECT(uu::decodeUU(text.data(), text.size(), decoded, false, &error));
+}
+
+CPU_TEST(UUDecodeErrors)
+{
+    std::vector<unsigned char> decoded;
+    std::string error;
+
+    std::string text = "no header here\n";
+    EXPECT(!uu::decodeUU(text.data(), text.size(), decoded, false, &error));
+    EXPECT(error.find("begin") != std::string::npos) << error;
+
+    text = "begin 644 truncated\n#0V%T\n";
+    EXPECT(!uu::decodeUU(text.data(), text.size(), decoded, false, &error));
+    EXPECT(error.find("end") != std::string::npos) << error;
+
+    text = "begin 644 bad\n#0V%T\n`\nnot the end\n";
+    uu::Decoder decoder(decoded);
+    EXPECT(!decoder.feed(text.data(), text.size()));
+    EXPECT(decoder.state() == uu::Decoder::State::Error);
+    EXPECT(!decoder.finish());
+}
+
+CPU_TEST(UUDecodeStream)
+{
+    std::mt19937 rng(48);
+    auto data = randomData(rng, 200000);
+    std::string block = encodeUU(data);
+
+    // The LSD parser continues right after the block
+    std::istringstream in(block + "ray_end\n");
+    std::vector<unsigned char> decoded;
+    EXPECT(uu::decodeUU(in, block.size(), decoded));
+    EXPECT(decoded == data);
+    std::string next;
+    std::getline(in, next);
+    EXPECT_EQ(next, "ray_end");
+
+    // Block size larger than what the stream holds
+    std::istringstream truncated(block.substr(0, block.size() / 2));
+    decoded.clear();
+    std::string error;
+    EXPECT(!uu::decodeUU(truncated, block.size(), decoded, false, &error));
+}
+
+CPU_TEST(UUDecodeBenchmark)
+{
+    const size_t kSize = 64 * 1024 * 1024;
+    const uint32_t kRuns = 3;
+    std::mt19937 rng(48);
+    auto data = randomData(rng, kSize);
+    std::string text = encodeUU(data);
+
+    double bestMs = 1e30;
+    std::vector<unsigned char> decoded;
+    for (uint32_t run = 0; run < kRuns; run++) {
+        decoded.clear();
+        decoded.shrink_to_fit();
+        std::istringstream in(text);
+        auto start = std::chrono::high_resolution_clock::now();
+        EXPECT(uu::decodeUU(in, text.size(), decoded));
+        bestMs = std::min(bestMs, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+    }
+    EXPECT(decoded == data);
+
+    logInfo("UUDecodeBenchmark: " + std::to_string(text.size() >> 20) + " MB of encoded text in " + std::to_string(bestMs) + " ms, " +
+        std::to_string(text.size() / (bestMs * 1e6)) + " GB/s.");
+}
+
+}  // namespace Falcor
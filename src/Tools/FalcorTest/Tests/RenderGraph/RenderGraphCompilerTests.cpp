@@ -0,0 +1,287 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include <map>
+#include <random>
+#include <set>
+
+namespace Falcor {
+
+namespace {
+
+const std::vector<std::string> kFields = { "in0", "in1", "out0", "out1" };
+
+/** Pass without GPU work with a fixed size output and one sized by the graph.
+*/
+class CompileTestPass : public RenderPass {
+ public:
+    using SharedPtr = std::shared_ptr<CompileTestPass>;
+
+    static SharedPtr create(Device::SharedPtr pDevice, uint32_t size) { return SharedPtr(new CompileTestPass(pDevice, size)); }
+
+    RenderPassReflection reflect(const CompileData& compileData) override {
+        RenderPassReflection reflector;
+        reflector.addInput("in0", "Input").flags(RenderPassReflection::Field::Flags::Optional);
+        reflector.addInput("in1", "Input").flags(RenderPassReflection::Field::Flags::Optional);
+        reflector.addOutput("out0", "Fixed size output").format(ResourceFormat::RGBA8Unorm).texture2D(mSize, mSize);
+        reflector.addOutput("out1", "Output with the graph's dimensions").format(ResourceFormat::R32Float);
+        return reflector;
+    }
+
+    void compile(RenderContext* pContext, const CompileData& compileData) override { compileCount++; }
+
+    void execute(RenderContext* pRenderContext, const RenderData& renderData) override {
+        executionIndex = (*pExecutionCounter)++;
+        for (const auto& field : kFields) resources[field] = renderData[field];
+    }
+
+    std::string getDesc() override { return "Render graph compiler test pass"; }
+
+    void setSize(uint32_t size) {
+        mSize = size;
+        mPassChangedCB();
+    }
+
+    uint32_t compileCount = 0;
+    int executionIndex = -1;
+    std::shared_ptr<int> pExecutionCounter;
+    std::map<std::string, Resource::SharedPtr> resources;
+
+ private:
+    CompileTestPass(Device::SharedPtr pDevice, uint32_t size) : RenderPass(pDevice), mSize(size) {}
+    uint32_t mSize;
+};
+
+/** What the randomized test builds. Passes are only connected from lower to higher index, so the graph is always acyclic.
+*/
+struct GraphDesc {
+    uint2 dims = uint2(32, 16);
+    std::vector<uint32_t> sizes;
+    std::set<std::pair<std::string, std::string>> edges;
+    std::set<std::string> outputs;
+};
+
+std::string passName(uint32_t i) { return "pass" + std::to_string(i); }
+
+struct TestGraph {
+    RenderGraph::SharedPtr pGraph;
+    std::vector<CompileTestPass::SharedPtr> passes;
+    std::shared_ptr<int> pExecutionCounter = std::make_shared<int>(0);
+
+    void execute(RenderContext* pContext) {
+        *pExecutionCounter = 0;
+        for (auto& pPass : passes) pPass->executionIndex = -1;
+        pGraph->execute(pContext);
+    }
+};
+
+TestGraph buildGraph(Device::SharedPtr pDevice, const GraphDesc& desc) {
+    TestGraph graph;
+    graph.pGraph = RenderGraph::create(pDevice, desc.dims, ResourceFormat::RGBA8Unorm, "CompilerTest");
+    for (uint32_t i = 0; i < (uint32_t)desc.sizes.size(); i++) {
+        graph.passes.push_back(CompileTestPass::create(pDevice, desc.sizes[i]));
+        graph.pGraph->addPass(graph.passes.back(), passName(i));
+    }
+    for (const auto& [src, dst] : desc.edges) graph.pGraph->addEdge(src, dst);
+    for (const auto& output : desc.outputs) graph.pGraph->markOutput(output);
+    for (auto& pPass : graph.passes) pPass->pExecutionCounter = graph.pExecutionCounter;
+    return graph;
+}
+
+/** Check the incrementally compiled graph against a full compilation of the same description: same passes executed in a valid order,
+    same resource properties per field and the same fields sharing resources.
+*/
+void compareGraphs(UnitTestContext& ctx, const TestGraph& incremental, const TestGraph& reference, const GraphDesc& desc) {
+    std::map<std::string, std::string> incrementalAliases, referenceAliases;
+    std::map<const Resource*, std::string> incrementalFirst, referenceFirst;
+
+    for (uint32_t i = 0; i < (uint32_t)desc.sizes.size(); i++) {
+        const auto& pIncremental = incremental.passes[i];
+        const auto& pReference = reference.passes[i];
+        EXPECT_EQ(pIncremental->executionIndex >= 0, pReference->executionIndex >= 0) << passName(i);
+        if (pReference->executionIndex < 0) continue;
+
+        for (const auto& field : kFields) {
+            std::string name = passName(i) + '.' + field;
+            const auto& pA = pIncremental->resources.at(field);
+            const auto& pB = pReference->resources.at(field);
+            EXPECT_EQ(pA == nullptr, pB == nullptr) << name;
+            if (!pA || !pB) continue;
+
+            EXPECT(pA->getType() == pB->getType()) << name;
+            EXPECT(pA->getBindFlags() == pB->getBindFlags()) << name;
+            auto pTexA = std::dynamic_pointer_cast<Texture>(pA);
+            auto pTexB = std::dynamic_pointer_cast<Texture>(pB);
+            if (pTexA && pTexB) {
+                EXPECT_EQ(pTexA->getWidth(), pTexB->getWidth()) << name;
+                EXPECT_EQ(pTexA->getHeight(), pTexB->getHeight()) << name;
+                EXPECT(pTexA->getFormat() == pTexB->getFormat()) << name;
+            }
+
+            incrementalAliases[name] = incrementalFirst.emplace(pA.get(), name).first->second;
+            referenceAliases[name] = referenceFirst.emplace(pB.get(), name).first->second;
+        }
+    }
+    EXPECT(incrementalAliases == referenceAliases);
+
+    for (const auto& [src, dst] : desc.edges) {
+        uint32_t srcPass = std::stoi(src.substr(4, src.find('.') - 4));
+        uint32_t dstPass = std::stoi(dst.substr(4, dst.find('.') - 4));
+        int srcIndex = incremental.passes[srcPass]->executionIndex;
+        int dstIndex = incremental.passes[dstPass]->executionIndex;
+        if (srcIndex >= 0 && dstIndex >= 0) EXPECT_LT(srcIndex, dstIndex) << src << " -> " << dst;
+    }
+}
+
+}  // namespace
+
+GPU_TEST(RenderGraphIncrementalCompile)
+{
+    // pass0 -> pass1 -> pass2, and an unconnected pass3 with its own output
+    auto pDevice = ctx.getRenderContext()->device();
+    GraphDesc desc;
+    desc.sizes = { 16, 16, 16, 16 };
+    desc.edges = { { "pass0.out0", "pass1.in0" }, { "pass1.out0", "pass2.in0" } };
+    desc.outputs = { "pass2.out0", "pass3.out1" };
+    auto graph = buildGraph(pDevice, desc);
+    graph.execute(ctx.getRenderContext());
+    for (const auto& pPass : graph.passes) EXPECT_EQ(pPass->compileCount, 1u);
+
+    // A pass change recompiles the pass and the passes connected to it, and reallocates only its changed resource
+    auto resources = graph.passes[2]->resources;
+    auto pOldOut0 = graph.passes[0]->resources["out0"];
+    graph.passes[0]->setSize(32);
+    graph.execute(ctx.getRenderContext());
+    EXPECT_EQ(graph.passes[0]->compileCount, 2u);
+    EXPECT_EQ(graph.passes[1]->compileCount, 2u);
+    EXPECT_EQ(graph.passes[2]->compileCount, 1u);
+    EXPECT_EQ(graph.passes[3]->compileCount, 1u);
+    EXPECT(graph.passes[0]->resources["out0"] != pOldOut0);
+    EXPECT_EQ(graph.passes[0]->resources["out0"]->asTexture()->getWidth(), 32u);
+    EXPECT(graph.passes[2]->resources["out0"] == resources["out0"]);
+    EXPECT(graph.passes[2]->resources["out1"] == resources["out1"]);
+
+    // A resize recompiles every pass, but keeps the fixed size resources
+    resources = graph.passes[2]->resources;
+    graph.pGraph->resize(64, 64, ResourceFormat::RGBA8Unorm);
+    graph.execute(ctx.getRenderContext());
+    for (const auto& pPass : graph.passes) EXPECT_GE(pPass->compileCount, 2u);
+    EXPECT(graph.passes[2]->resources["out0"] == resources["out0"]);
+    EXPECT(graph.passes[2]->resources["out1"] != resources["out1"]);
+    EXPECT_EQ(graph.passes[2]->resources["out1"]->asTexture()->getWidth(), 64u);
+
+    // Adding an edge changes the aliasing, which must not hand a resource to two fields
+    graph.pGraph->addEdge("pass3.out1", "pass2.in1");
+    graph.execute(ctx.getRenderContext());
+    EXPECT(graph.passes[2]->resources["in1"] == graph.passes[3]->resources["out1"]);
+    EXPECT(graph.passes[2]->resources["out1"] != graph.passes[3]->resources["out1"]);
+}
+
+GPU_TEST(RenderGraphIncrementalCompileRandomEdits)
+{
+    auto pDevice = ctx.getRenderContext()->device();
+    const uint32_t kPassCount = 6;
+    const uint32_t kEditCount = 60;
+    std::mt19937 rng(11);
+
+    GraphDesc desc;
+    for (uint32_t i = 0; i < kPassCount; i++) desc.sizes.push_back(8 << (rng() % 3));
+    desc.outputs = { passName(kPassCount - 1) + ".out0" };
+    auto graph = buildGraph(pDevice, desc);
+    graph.execute(ctx.getRenderContext());
+
+    for (uint32_t edit = 0; edit < kEditCount; edit++) {
+        switch (rng() % 6) {
+        case 0: {
+            // Connect a free input to an output of an earlier pass
+            uint32_t dst = 1 + rng() % (kPassCount - 1);
+            uint32_t src = rng() % dst;
+            std::string dstField = passName(dst) + ".in" + std::to_string(rng() % 2);
+            std::string srcField = passName(src) + ".out" + std::to_string(rng() % 2);
+            bool taken = std::any_of(desc.edges.begin(), desc.edges.end(), [&](const auto& e) { return e.second == dstField; });
+            if (taken) break;
+            desc.edges.insert({ srcField, dstField });
+            graph.pGraph->addEdge(srcField, dstField);
+            break;
+        }
+        case 1: {
+            if (desc.edges.empty()) break;
+            auto it = std::next(desc.edges.begin(), rng() % desc.edges.size());
+            graph.pGraph->removeEdge(it->first, it->second);
+            desc.edges.erase(it);
+            break;
+        }
+        case 2: {
+            uint32_t i = rng() % kPassCount;
+            desc.sizes[i] = 8 << (rng() % 3);
+            graph.passes[i]->setSize(desc.sizes[i]);
+            break;
+        }
+        case 3: {
+            desc.dims = uint2(8 + rng() % 32, 8 + rng() % 32);
+            graph.pGraph->resize(desc.dims.x, desc.dims.y, ResourceFormat::RGBA8Unorm);
+            break;
+        }
+        case 4: {
+            // The last pass' output stays marked so the graph always has one
+            std::string output = passName(rng() % (kPassCount - 1)) + ".out" + std::to_string(rng() % 2);
+            if (desc.outputs.erase(output)) graph.pGraph->unmarkOutput(output);
+            else {
+                desc.outputs.insert(output);
+                graph.pGraph->markOutput(output);
+            }
+            break;
+        }
+        case 5: {
+            // Replace a pass, dropping its edges and outputs
+            uint32_t i = rng() % (kPassCount - 1);
+            std::string prefix = passName(i) + '.';
+            for (auto it = desc.edges.begin(); it != desc.edges.end();) {
+                if (hasPrefix(it->first, prefix) || hasPrefix(it->second, prefix)) it = desc.edges.erase(it);
+                else ++it;
+            }
+            for (auto it = desc.outputs.begin(); it != desc.outputs.end();) {
+                if (hasPrefix(*it, prefix)) it = desc.outputs.erase(it);
+                else ++it;
+            }
+            graph.pGraph->removePass(passName(i));
+            graph.passes[i] = CompileTestPass::create(pDevice, desc.sizes[i]);
+            graph.passes[i]->pExecutionCounter = graph.pExecutionCounter;
+            graph.pGraph->addPass(graph.passes[i], passName(i));
+            break;
+        }
+        }
+
+        graph.execute(ctx.getRenderContext());
+        auto reference = buildGraph(pDevice, desc);
+        reference.execute(ctx.getRenderContext());
+        compareGraphs(ctx, graph, reference, desc);
+    }
+}
+
+}  // namespace Falcor
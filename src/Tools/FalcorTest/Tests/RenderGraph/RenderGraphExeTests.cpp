@@ -0,0 +1,228 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Falcor/Utils/ConfigStore.h"
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+
+namespace Falcor {
+
+namespace {
+
+/** Pass without GPU work that only looks up its resources, so executing a graph of them measures the graph overhead.
+*/
+class EmptyPass : public RenderPass {
+ public:
+    using SharedPtr = std::shared_ptr<EmptyPass>;
+
+    static SharedPtr create(Device::SharedPtr pDevice) { return SharedPtr(new EmptyPass(pDevice)); }
+
+    RenderPassReflection reflect(const CompileData& compileData) override {
+        RenderPassReflection reflector;
+        reflector.addInput("src", "Output of the previous pass").flags(RenderPassReflection::Field::Flags::Optional);
+        reflector.addOutput("dst", "Output").format(ResourceFormat::RGBA8Unorm).texture2D(16, 16);
+        return reflector;
+    }
+
+    void execute(RenderContext* pRenderContext, const RenderData& renderData) override {
+        pSrc = renderData["src"];
+        pDst = renderData["dst"];
+        pUnknown = renderData["unknown"];
+    }
+
+    std::string getDesc() override { return "Empty pass"; }
+
+    Resource::SharedPtr pSrc;
+    Resource::SharedPtr pDst;
+    Resource::SharedPtr pUnknown;
+
+ private:
+    EmptyPass(Device::SharedPtr pDevice) : RenderPass(pDevice) {}
+};
+
+/** Pass that clears its output and records which thread and context executed it.
+    Passes of a level wait for each other, so they only finish if they are recorded concurrently.
+*/
+class ParallelPass : public RenderPass {
+ public:
+    using SharedPtr = std::shared_ptr<ParallelPass>;
+
+    struct Rendezvous {
+        std::atomic<uint32_t> arrived = { 0 };
+        uint32_t expected = 0;
+    };
+
+    static SharedPtr create(Device::SharedPtr pDevice, float4 color, Rendezvous* pRendezvous) { return SharedPtr(new ParallelPass(pDevice, color, pRendezvous)); }
+
+    RenderPassReflection reflect(const CompileData& compileData) override {
+        RenderPassReflection reflector;
+        reflector.addInput("src", "Output of the previous pass").bindFlags(ResourceBindFlags::ShaderResource).flags(RenderPassReflection::Field::Flags::Optional);
+        reflector.addOutput("dst", "Output").bindFlags(ResourceBindFlags::RenderTarget).format(ResourceFormat::RGBA8Unorm).texture2D(16, 16);
+        return reflector;
+    }
+
+    void execute(RenderContext* pRenderContext, const RenderData& renderData) override {
+        threadID = std::this_thread::get_id();
+        pContext = pRenderContext;
+
+        // Passes of a level share their input, its view cache is hit from every worker
+        if (renderData["src"]) pSrcView = renderData["src"]->asTexture()->getSRV();
+        pRenderContext->clearRtv(renderData["dst"]->asTexture()->getRTV().get(), mColor);
+
+        if (mpRendezvous) {
+            mpRendezvous->arrived++;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (mpRendezvous->arrived < mpRendezvous->expected && std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+        }
+    }
+
+    bool supportsParallelRecording() const override { return mpRendezvous != nullptr; }
+
+    std::string getDesc() override { return "Parallel pass"; }
+
+    std::thread::id threadID;
+    RenderContext* pContext = nullptr;
+    ShaderResourceView::SharedPtr pSrcView;
+
+ private:
+    ParallelPass(Device::SharedPtr pDevice, float4 color, Rendezvous* pRendezvous) : RenderPass(pDevice), mColor(color), mpRendezvous(pRendezvous) {}
+
+    float4 mColor;
+    Rendezvous* mpRendezvous;
+};
+
+}  // namespace
+
+GPU_TEST(RenderGraphExeBindings)
+{
+    auto pDevice = ctx.getRenderContext()->device();
+    const uint32_t kPassCount = 8;
+
+    auto pGraph = RenderGraph::create(pDevice, uint2(16, 16), ResourceFormat::RGBA8Unorm, "Bindings");
+    std::vector<EmptyPass::SharedPtr> passes;
+    for (uint32_t i = 0; i < kPassCount; i++) {
+        passes.push_back(EmptyPass::create(pDevice));
+        pGraph->addPass(passes.back(), "pass" + std::to_string(i));
+        if (i > 0) pGraph->addEdge("pass" + std::to_string(i - 1) + ".dst", "pass" + std::to_string(i) + ".src");
+    }
+    pGraph->markOutput("pass" + std::to_string(kPassCount - 1) + ".dst");
+    pGraph->execute(ctx.getRenderContext());
+
+    EXPECT(passes[0]->pSrc == nullptr);
+    for (uint32_t i = 0; i < kPassCount; i++) {
+        EXPECT(passes[i]->pDst != nullptr);
+        EXPECT(passes[i]->pUnknown == nullptr);
+        if (i > 0) EXPECT(passes[i]->pSrc == passes[i - 1]->pDst);
+    }
+    EXPECT(pGraph->getOutput("pass" + std::to_string(kPassCount - 1) + ".dst") == passes[kPassCount - 1]->pDst);
+
+    // External inputs set after compilation must show up without recompiling
+    auto pInput = Texture::create2D(pDevice, 16, 16, ResourceFormat::RGBA8Unorm, 1, 1);
+    pGraph->setInput("pass0.src", pInput);
+    pGraph->execute(ctx.getRenderContext());
+    EXPECT(passes[0]->pSrc == pInput);
+
+    pGraph->setInput("pass0.src", nullptr);
+    pGraph->execute(ctx.getRenderContext());
+    EXPECT(passes[0]->pSrc == nullptr);
+}
+
+GPU_TEST(RenderGraphExeParallelRecording)
+{
+    // The graph reads the thread count when it is compiled. Values already in the store are kept.
+    ConfigStore::instance().set<int>("rg_record_threads", 4);
+    const uint32_t kThreadCount = (uint32_t)ConfigStore::instance().get<int>("rg_record_threads", 0);
+    if (kThreadCount < 2) {
+        logWarning("RenderGraphExeParallelRecording: rg_record_threads is " + std::to_string(kThreadCount) + ", nothing to test.");
+        return;
+    }
+
+    auto pDevice = ctx.getRenderContext()->device();
+    const uint32_t kReaderCount = 4;
+
+    // A producer followed by a level of readers that only share the producer's output
+    ParallelPass::Rendezvous rendezvous;
+    rendezvous.expected = std::min(kThreadCount, kReaderCount);
+
+    auto pGraph = RenderGraph::create(pDevice, uint2(16, 16), ResourceFormat::RGBA8Unorm, "ParallelRecording");
+    auto pProducer = ParallelPass::create(pDevice, float4(0.f), nullptr);
+    pGraph->addPass(pProducer, "producer");
+    std::vector<ParallelPass::SharedPtr> readers;
+    for (uint32_t i = 0; i < kReaderCount; i++) {
+        std::string name = "reader" + std::to_string(i);
+        readers.push_back(ParallelPass::create(pDevice, float4(float(i + 1) / 255.f, 0.f, 0.f, 1.f), &rendezvous));
+        pGraph->addPass(readers.back(), name);
+        pGraph->addEdge("producer.dst", name + ".src");
+        pGraph->markOutput(name + ".dst");
+    }
+    pGraph->execute(ctx.getRenderContext());
+
+    EXPECT_EQ(rendezvous.arrived.load(), kReaderCount);
+    EXPECT(pProducer->pContext == ctx.getRenderContext());
+
+    std::set<std::thread::id> threads;
+    for (uint32_t i = 0; i < kReaderCount; i++) {
+        const auto& pReader = readers[i];
+        EXPECT(pReader->threadID != std::this_thread::get_id()) << "reader " << i;
+        EXPECT(pReader->pContext != nullptr && pReader->pContext != ctx.getRenderContext()) << "reader " << i;
+        EXPECT(pReader->pSrcView == readers[0]->pSrcView) << "reader " << i;
+        threads.insert(pReader->threadID);
+
+        // The workers' commands were submitted before the graph returned
+        std::vector<uint8_t> color = ctx.getRenderContext()->readTextureSubresource(pGraph->getOutput("reader" + std::to_string(i) + ".dst")->asTexture().get(), 0);
+        EXPECT_EQ((uint32_t)color[0], i + 1) << "reader " << i;
+    }
+    EXPECT_EQ((uint32_t)threads.size(), rendezvous.expected);
+}
+
+GPU_TEST(RenderGraphExeBenchmark)
+{
+    // A chain of passes that record nothing, executed as often as lava executes a graph per sample
+    auto pDevice = ctx.getRenderContext()->device();
+    const uint32_t kPassCount = 16;
+    const uint32_t kExecutions = 1000;
+
+    auto pGraph = RenderGraph::create(pDevice, uint2(16, 16), ResourceFormat::RGBA8Unorm, "Benchmark");
+    for (uint32_t i = 0; i < kPassCount; i++) {
+        pGraph->addPass(EmptyPass::create(pDevice), "pass" + std::to_string(i));
+        if (i > 0) pGraph->addEdge("pass" + std::to_string(i - 1) + ".dst", "pass" + std::to_string(i) + ".src");
+    }
+    pGraph->markOutput("pass" + std::to_string(kPassCount - 1) + ".dst");
+    pGraph->execute(ctx.getRenderContext());
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < kExecutions; i++) pGraph->execute(ctx.getRenderContext());
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    logInfo("RenderGraphExeBenchmark: " + std::to_string(kExecutions) + " executions of " + std::to_string(kPassCount) + " empty passes in " +
+        std::to_string(ms) + " ms, " + std::to_string(ms * 1e6 / (kExecutions * kPassCount)) + " ns per pass.");
+}
+
+}  // namespace Falcor
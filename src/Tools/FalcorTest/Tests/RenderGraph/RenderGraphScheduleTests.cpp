@@ -0,0 +1,196 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Falcor/RenderGraph/RenderGraphSchedule.h"
+#include <random>
+#include <unordered_map>
+
+namespace Falcor {
+
+namespace {
+
+using Access = RenderGraphSchedule::Access;
+
+RenderGraphSchedule::PassDesc makePass(std::vector<uint32_t> dependencies, std::vector<RenderGraphSchedule::ResourceAccess> resources) {
+    return { std::move(dependencies), std::move(resources) };
+}
+
+/** Check the invariants every schedule must satisfy. Returns the level of each pass.
+*/
+std::vector<uint32_t> validateSchedule(UnitTestContext& ctx, const std::vector<RenderGraphSchedule::PassDesc>& passes, const RenderGraphSchedule& schedule) {
+    const uint32_t kUnscheduled = uint32_t(-1);
+    std::vector<uint32_t> passLevels(passes.size(), kUnscheduled);
+    const auto& levels = schedule.getLevels();
+    for (uint32_t l = 0; l < (uint32_t)levels.size(); l++) {
+        EXPECT(!levels[l].passes.empty()) << "level " << l;
+        for (size_t i = 0; i < levels[l].passes.size(); i++) {
+            uint32_t p = levels[l].passes[i];
+            EXPECT_EQ(passLevels[p], kUnscheduled) << "pass " << p << " scheduled twice";
+            passLevels[p] = l;
+            if (i > 0) EXPECT_LT(levels[l].passes[i - 1], p) << "level " << l << " is not in execution order";
+        }
+    }
+
+    // Accesses of each level, per resource, while replaying the planned transitions
+    std::unordered_map<uint32_t, Access> state;
+    for (uint32_t l = 0; l < (uint32_t)levels.size(); l++) {
+        std::unordered_map<uint32_t, Access> levelAccess;
+        for (uint32_t p : levels[l].passes) {
+            std::unordered_map<uint32_t, Access> passAccess;
+            for (const auto& r : passes[p].resources) passAccess[r.resource] = passAccess[r.resource] | r.access;
+            for (const auto& [resource, access] : passAccess) levelAccess[resource] = levelAccess[resource] | access;
+        }
+        for (const auto& [resource, access] : levelAccess) {
+            if (is_set(access, Access::Write)) {
+                // A written resource belongs to a single pass of the level
+                uint32_t users = 0;
+                for (uint32_t p : levels[l].passes) {
+                    for (const auto& r : passes[p].resources) if (r.resource == resource) { users++; break; }
+                }
+                EXPECT_EQ(users, 1u) << "resource " << resource << " conflicts in level " << l;
+            }
+        }
+
+        for (const auto& t : levels[l].transitions) {
+            EXPECT_EQ((uint32_t)state[t.resource], (uint32_t)t.before) << "resource " << t.resource << " level " << l;
+            EXPECT_EQ((uint32_t)levelAccess[t.resource], (uint32_t)t.after) << "resource " << t.resource << " level " << l;
+            state[t.resource] = t.after;
+        }
+        for (const auto& [resource, access] : levelAccess) {
+            EXPECT_EQ((uint32_t)state[resource], (uint32_t)access) << "resource " << resource << " has no transition into level " << l;
+        }
+    }
+
+    for (size_t p = 0; p < passes.size(); p++) {
+        EXPECT_NE(passLevels[p], kUnscheduled) << "pass " << p << " not scheduled";
+        for (uint32_t d : passes[p].dependencies) EXPECT_LT(passLevels[d], passLevels[p]) << "pass " << p << " depends on " << d;
+    }
+
+    // Conflicting accesses keep their execution order
+    for (size_t a = 0; a < passes.size(); a++) {
+        for (size_t b = a + 1; b < passes.size(); b++) {
+            for (const auto& ra : passes[a].resources) {
+                for (const auto& rb : passes[b].resources) {
+                    bool conflict = ra.resource == rb.resource && (is_set(ra.access, Access::Write) || is_set(rb.access, Access::Write));
+                    if (conflict) EXPECT_LT(passLevels[a], passLevels[b]) << "passes " << a << " and " << b << " on resource " << ra.resource;
+                }
+            }
+        }
+    }
+    return passLevels;
+}
+
+}  // namespace
+
+CPU_TEST(RenderGraphScheduleIndependentPasses)
+{
+    // A G-buffer pass feeding three AOV passes, which are combined by a last pass
+    std::vector<RenderGraphSchedule::PassDesc> passes = {
+        makePass({}, { { 0, Access::Write } }),
+        makePass({ 0 }, { { 0, Access::Read }, { 1, Access::Write } }),
+        makePass({ 0 }, { { 0, Access::Read }, { 2, Access::Write } }),
+        makePass({ 0 }, { { 0, Access::Read }, { 3, Access::Write } }),
+        makePass({ 1, 2, 3 }, { { 1, Access::Read }, { 2, Access::Read }, { 3, Access::Read }, { 4, Access::Write } }),
+    };
+    auto schedule = RenderGraphSchedule::build(passes);
+    validateSchedule(ctx, passes, schedule);
+
+    const auto& levels = schedule.getLevels();
+    EXPECT_EQ(levels.size(), 3);
+    EXPECT_EQ(schedule.getMaxLevelWidth(), 3u);
+    EXPECT(levels[1].passes == std::vector<uint32_t>({ 1, 2, 3 }));
+
+    // The G-buffer is transitioned to read once, for all three AOV passes
+    EXPECT_EQ(levels[1].transitions.size(), 4);
+    EXPECT_EQ(levels[1].transitions[0].resource, 0u);
+    EXPECT_EQ((uint32_t)levels[1].transitions[0].before, (uint32_t)Access::Write);
+    EXPECT_EQ((uint32_t)levels[1].transitions[0].after, (uint32_t)Access::Read);
+    EXPECT_EQ(levels[2].transitions.size(), 4);
+}
+
+CPU_TEST(RenderGraphScheduleResourceHazards)
+{
+    // No edges, the passes only share resources
+    std::vector<RenderGraphSchedule::PassDesc> passes = {
+        makePass({}, { { 0, Access::Write } }),
+        makePass({}, { { 0, Access::Read } }),
+        makePass({}, { { 0, Access::Read } }),
+        makePass({}, { { 0, Access::Write } }),            // Must wait for both readers
+        makePass({}, { { 0, Access::ReadWrite } }),
+        makePass({}, { { 1, Access::Write } }),            // Unrelated, goes to the first level
+    };
+    auto schedule = RenderGraphSchedule::build(passes);
+    auto passLevels = validateSchedule(ctx, passes, schedule);
+    EXPECT(passLevels == std::vector<uint32_t>({ 0, 1, 1, 2, 3, 0 }));
+
+    // Write after write still gets a transition
+    const auto& levels = schedule.getLevels();
+    EXPECT_EQ(levels[3].transitions.size(), 1);
+    EXPECT_EQ((uint32_t)levels[3].transitions[0].before, (uint32_t)Access::Write);
+    EXPECT_EQ((uint32_t)levels[3].transitions[0].after, (uint32_t)Access::ReadWrite);
+}
+
+CPU_TEST(RenderGraphScheduleExecutionEdges)
+{
+    // Execution edges order passes without any resource in common
+    std::vector<RenderGraphSchedule::PassDesc> passes = {
+        makePass({}, {}),
+        makePass({ 0 }, { { 0, Access::Write } }),
+        makePass({}, { { 1, Access::Write } }),
+        makePass({ 1 }, {}),
+    };
+    auto schedule = RenderGraphSchedule::build(passes);
+    auto passLevels = validateSchedule(ctx, passes, schedule);
+    EXPECT(passLevels == std::vector<uint32_t>({ 0, 1, 0, 2 }));
+    EXPECT(RenderGraphSchedule::build({}).getLevels().empty());
+}
+
+CPU_TEST(RenderGraphScheduleRandomGraphs)
+{
+    std::mt19937 rng(47);
+    for (uint32_t iteration = 0; iteration < 200; iteration++) {
+        uint32_t passCount = 1 + rng() % 24;
+        uint32_t resourceCount = 1 + rng() % 16;
+
+        std::vector<RenderGraphSchedule::PassDesc> passes(passCount);
+        for (uint32_t p = 0; p < passCount; p++) {
+            for (uint32_t d = 0; d < p; d++) if (rng() % 6 == 0) passes[p].dependencies.push_back(d);
+            uint32_t accessCount = rng() % 4;
+            for (uint32_t a = 0; a < accessCount; a++) passes[p].resources.push_back({ uint32_t(rng() % resourceCount), Access(1 + rng() % 3) });
+        }
+
+        auto schedule = RenderGraphSchedule::build(passes);
+        validateSchedule(ctx, passes, schedule);
+        if (!ctx.getFailureMessages().empty()) {
+            logInfo("RenderGraphScheduleRandomGraphs: failed at iteration " + std::to_string(iteration));
+            return;
+        }
+    }
+}
+
+}  // namespace Falcor
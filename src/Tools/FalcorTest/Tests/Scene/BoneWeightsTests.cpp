@@ -0,0 +1,112 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Importers/BoneWeights.h"
+
+#include <chrono>
+#include <random>
+
+namespace Falcor
+{
+    CPU_TEST(BoneWeightSelectorKeepsStrongest)
+    {
+        BoneWeightSelector selector(3);
+
+        // Vertex 0: two influences.
+        EXPECT(selector.add(0, 5, 0.25f));
+        EXPECT(selector.add(0, 7, 0.75f));
+
+        // Vertex 1: six influences, the two weakest get dropped whatever order they come in.
+        EXPECT(selector.add(1, 1, 0.1f));
+        EXPECT(selector.add(1, 2, 0.4f));
+        EXPECT(selector.add(1, 3, 0.2f));
+        EXPECT(selector.add(1, 4, 0.3f));
+        EXPECT(!selector.add(1, 5, 0.05f));     // Weaker than all four
+        EXPECT(!selector.add(1, 6, 0.5f));      // Replaces bone 1
+
+        // Vertex 2: zero weights are ignored.
+        EXPECT(selector.add(2, 9, 0.f));
+
+        std::vector<float4> weights;
+        std::vector<uint4> ids;
+        selector.finalize(weights, ids);
+        EXPECT_EQ(weights.size(), 3);
+        EXPECT_EQ(ids.size(), 3);
+
+        EXPECT_EQ(ids[0].x, 7);
+        EXPECT_EQ(ids[0].y, 5);
+        EXPECT_EQ(weights[0].x, 0.75f);
+        EXPECT_EQ(weights[0].y, 0.25f);
+        EXPECT_EQ(weights[0].z, 0.f);
+
+        EXPECT(ids[1] == uint4(6, 2, 4, 3));
+        float sum = weights[1].x + weights[1].y + weights[1].z + weights[1].w;
+        EXPECT(std::abs(sum - 1.f) < 1e-6f);
+        EXPECT(std::abs(weights[1].x - 0.5f / 1.4f) < 1e-6f);
+
+        EXPECT(weights[2] == float4(0.f));
+    }
+
+    CPU_TEST(BoneWeightSelectorBenchmark)
+    {
+        // A skinned character mesh where every vertex is influenced by 8 bones.
+        const uint32_t kVertexCount = 1000000;
+        const uint32_t kBoneCount = 64;
+        const uint32_t kInfluences = 8;
+
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> u(0.f, 1.f);
+        std::vector<uint32_t> vertexIDs(kVertexCount * kInfluences);
+        std::vector<float> weightValues(vertexIDs.size());
+        for (size_t i = 0; i < vertexIDs.size(); i++)
+        {
+            vertexIDs[i] = rng() % kVertexCount;
+            weightValues[i] = u(rng);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        BoneWeightSelector selector(kVertexCount);
+        uint32_t dropped = 0;
+        for (size_t i = 0; i < vertexIDs.size(); i++)
+        {
+            if (!selector.add(vertexIDs[i], (uint32_t)(i % kBoneCount), weightValues[i])) dropped++;
+        }
+        std::vector<float4> weights;
+        std::vector<uint4> ids;
+        selector.finalize(weights, ids);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        // Slots stay sorted by decreasing weight.
+        bool sorted = true;
+        for (const float4& w : weights) sorted = sorted && w.x >= w.y && w.y >= w.z && w.z >= w.w;
+        EXPECT(sorted);
+        EXPECT(dropped > 0);
+
+        logInfo("BoneWeightSelectorBenchmark: " + std::to_string(vertexIDs.size()) + " weights for " + std::to_string(kVertexCount) + " vertices in " + std::to_string(ms) + " ms.");
+    }
+}
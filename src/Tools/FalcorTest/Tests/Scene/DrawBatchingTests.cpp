@@ -0,0 +1,154 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/DrawBatching.h"
+
+#include <chrono>
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        // Check that the batches cover every instance exactly once and that each draw only references instances of its mesh and winding.
+        void checkBatches(CPUUnitTestContext& ctx, const DrawBatchList& list, const std::vector<uint32_t>& meshIDs, const std::vector<uint8_t>& flipped)
+        {
+            EXPECT_EQ(list.drawIDs.size(), meshIDs.size());
+
+            std::vector<uint32_t> seen(meshIDs.size(), 0);
+            auto checkList = [&](const std::vector<DrawBatch>& batches, uint8_t isFlipped)
+            {
+                for (const auto& batch : batches)
+                {
+                    EXPECT(batch.instanceCount > 0);
+                    EXPECT_LE(batch.startInstance + batch.instanceCount, list.drawIDs.size());
+                    for (uint32_t i = 0; i < batch.instanceCount; i++)
+                    {
+                        uint32_t instanceID = list.drawIDs[batch.startInstance + i];
+                        EXPECT_EQ(meshIDs[instanceID], batch.meshID);
+                        EXPECT_EQ(flipped[instanceID], isFlipped);
+                        seen[instanceID]++;
+                    }
+                }
+            };
+            checkList(list.counterClockwise, 0);
+            checkList(list.clockwise, 1);
+
+            for (uint32_t count : seen) EXPECT_EQ(count, 1);
+        }
+    }
+
+    CPU_TEST(DrawBatchingGroupsInstances)
+    {
+        // Mesh 2 has three regular instances and one flipped, mesh 0 two regular ones, mesh 1 none.
+        std::vector<uint32_t> meshIDs = { 2, 0, 2, 2, 0, 2 };
+        std::vector<uint8_t> flipped = { 0, 0, 1, 0, 0, 0 };
+
+        DrawBatchList list = buildDrawBatches(meshIDs, flipped, 3);
+        checkBatches(ctx, list, meshIDs, flipped);
+
+        EXPECT_EQ(list.getDrawCount(), 3);
+        EXPECT_EQ(list.counterClockwise.size(), 2);
+        EXPECT_EQ(list.clockwise.size(), 1);
+
+        EXPECT_EQ(list.counterClockwise[0].meshID, 0);
+        EXPECT_EQ(list.counterClockwise[0].instanceCount, 2);
+        EXPECT_EQ(list.counterClockwise[1].meshID, 2);
+        EXPECT_EQ(list.counterClockwise[1].instanceCount, 3);
+        EXPECT_EQ(list.clockwise[0].meshID, 2);
+        EXPECT_EQ(list.clockwise[0].instanceCount, 1);
+
+        // Instances keep their relative order within a draw.
+        EXPECT(list.drawIDs == std::vector<uint32_t>({ 1, 4, 0, 3, 5, 2 }));
+    }
+
+    CPU_TEST(DrawBatchingEdgeCases)
+    {
+        // No instances.
+        DrawBatchList list = buildDrawBatches({}, {}, 4);
+        EXPECT_EQ(list.getDrawCount(), 0);
+        EXPECT(list.drawIDs.empty());
+
+        // One instance per mesh degenerates to one draw per instance.
+        std::vector<uint32_t> meshIDs = { 3, 1, 0, 2 };
+        std::vector<uint8_t> flipped = { 1, 1, 1, 1 };
+        list = buildDrawBatches(meshIDs, flipped, 4);
+        checkBatches(ctx, list, meshIDs, flipped);
+        EXPECT_EQ(list.counterClockwise.size(), 0);
+        EXPECT_EQ(list.clockwise.size(), 4);
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            EXPECT_EQ(list.clockwise[i].meshID, i);
+            EXPECT_EQ(list.clockwise[i].startInstance, i);
+        }
+    }
+
+    CPU_TEST(DrawBatchingSubset)
+    {
+        // Only the instances that survived culling get drawn, draw IDs still refer to the full instance list.
+        std::vector<uint32_t> meshIDs = { 2, 0, 2, 2, 0, 2 };
+        std::vector<uint8_t> flipped = { 0, 0, 1, 0, 0, 0 };
+        std::vector<uint32_t> visible = { 5, 2, 4 };
+
+        DrawBatchList list = buildDrawBatches(visible, meshIDs, flipped, 3);
+        EXPECT_EQ(list.getDrawCount(), 3);
+        EXPECT(list.drawIDs == std::vector<uint32_t>({ 4, 5, 2 }));
+        EXPECT_EQ(list.counterClockwise[0].meshID, 0);
+        EXPECT_EQ(list.counterClockwise[1].meshID, 2);
+        EXPECT_EQ(list.counterClockwise[1].startInstance, 1);
+        EXPECT_EQ(list.clockwise[0].startInstance, 2);
+
+        list = buildDrawBatches(std::vector<uint32_t>(), meshIDs, flipped, 3);
+        EXPECT_EQ(list.getDrawCount(), 0);
+    }
+
+    CPU_TEST(DrawBatchingBenchmark)
+    {
+        // A forest: 500k instances of 1000 tree meshes, some of them mirrored.
+        const uint32_t kInstanceCount = 500000;
+        const uint32_t kMeshCount = 1000;
+
+        std::mt19937 rng(1234);
+        std::vector<uint32_t> meshIDs(kInstanceCount);
+        std::vector<uint8_t> flipped(kInstanceCount);
+        for (uint32_t i = 0; i < kInstanceCount; i++)
+        {
+            meshIDs[i] = rng() % kMeshCount;
+            flipped[i] = (rng() % 8) == 0 ? 1 : 0;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        DrawBatchList list = buildDrawBatches(meshIDs, flipped, kMeshCount);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        checkBatches(ctx, list, meshIDs, flipped);
+        EXPECT_LE(list.getDrawCount(), 2 * kMeshCount);
+
+        logInfo("DrawBatchingBenchmark: " + std::to_string(kInstanceCount) + " instances in " + std::to_string(list.getDrawCount()) + " draws, generated in " + std::to_string(ms) + " ms.");
+    }
+}
@@ -0,0 +1,189 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/InstanceCuller.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        // Random boxes spread over a cube, sized like objects in a large outdoor scene.
+        std::vector<BoundingBox> createRandomBoxes(uint32_t count, float sceneSize, uint32_t seed)
+        {
+            std::mt19937 rng(seed);
+            std::uniform_real_distribution<float> position(-sceneSize, sceneSize);
+            std::uniform_real_distribution<float> size(0.1f, 2.f);
+
+            std::vector<BoundingBox> boxes(count);
+            for (auto& box : boxes)
+            {
+                box.center = float3(position(rng), position(rng), position(rng));
+                box.extent = float3(size(rng), size(rng), size(rng));
+            }
+            return boxes;
+        }
+
+        Frustum createFrustum(const float3& eye, const float3& target)
+        {
+            glm::mat4 view = glm::lookAt(eye, target, float3(0.f, 1.f, 0.f));
+            glm::mat4 proj = glm::perspectiveRH_ZO(glm::radians(60.f), 16.f / 9.f, 0.1f, 500.f);
+            return Frustum::fromViewProjMatrix(proj * view);
+        }
+
+        std::vector<uint32_t> bruteForceCull(const Frustum& frustum, const std::vector<BoundingBox>& boxes)
+        {
+            std::vector<uint32_t> visible;
+            for (uint32_t i = 0; i < (uint32_t)boxes.size(); i++)
+            {
+                if (!frustum.isCulled(boxes[i])) visible.push_back(i);
+            }
+            return visible;
+        }
+
+        std::vector<uint32_t> sorted(std::vector<uint32_t> v)
+        {
+            std::sort(v.begin(), v.end());
+            return v;
+        }
+    }
+
+    CPU_TEST(FrustumPlanes)
+    {
+        Frustum frustum = createFrustum(float3(0.f), float3(0.f, 0.f, -1.f));
+
+        auto box = [](const float3& center) { return BoundingBox::fromMinMax(center - 0.5f, center + 0.5f); };
+        EXPECT(!frustum.isCulled(box(float3(0.f, 0.f, -10.f))));
+        EXPECT(frustum.isCulled(box(float3(0.f, 0.f, 10.f))));      // Behind the camera
+        EXPECT(frustum.isCulled(box(float3(0.f, 0.f, -600.f))));    // Beyond the far plane
+        EXPECT(frustum.isCulled(box(float3(100.f, 0.f, -10.f))));   // Left of the frustum
+        EXPECT(frustum.isCulled(box(float3(0.f, -100.f, -10.f))));  // Below the frustum
+        EXPECT(!frustum.isCulled(box(float3(0.f, 0.f, 0.f))));      // Intersects the near plane
+    }
+
+    CPU_TEST(InstanceCullerMatchesBruteForce)
+    {
+        std::vector<BoundingBox> boxes = createRandomBoxes(20000, 200.f, 1);
+        InstanceCuller culler(1);
+        culler.build(boxes);
+        EXPECT_EQ(culler.getInstanceCount(), 20000);
+
+        const float3 eyes[] = { float3(0.f), float3(150.f, 20.f, 150.f), float3(-300.f, 0.f, 0.f), float3(0.f, 500.f, 0.f) };
+        std::vector<uint32_t> visible;
+        for (const float3& eye : eyes)
+        {
+            Frustum frustum = createFrustum(eye, float3(10.f, 0.f, -20.f));
+            culler.cull(frustum, visible);
+            EXPECT(sorted(visible) == bruteForceCull(frustum, boxes));
+        }
+
+        // Empty input.
+        culler.build({});
+        culler.cull(createFrustum(float3(0.f), float3(0.f, 0.f, -1.f)), visible);
+        EXPECT(visible.empty());
+    }
+
+    CPU_TEST(InstanceCullerRefit)
+    {
+        std::vector<BoundingBox> boxes = createRandomBoxes(5000, 100.f, 2);
+        InstanceCuller culler(1);
+        culler.build(boxes);
+
+        // Move every instance and check the refit tree against the moved boxes.
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> offset(-50.f, 50.f);
+        for (auto& box : boxes) box.center += float3(offset(rng), offset(rng), offset(rng));
+        culler.refit(boxes);
+
+        Frustum frustum = createFrustum(float3(20.f, 10.f, 80.f), float3(0.f));
+        std::vector<uint32_t> visible;
+        culler.cull(frustum, visible);
+        EXPECT(sorted(visible) == bruteForceCull(frustum, boxes));
+    }
+
+    CPU_TEST(InstanceCullerThreadCountInvariant)
+    {
+        std::vector<BoundingBox> boxes = createRandomBoxes(50000, 300.f, 4);
+        Frustum frustum = createFrustum(float3(0.f, 10.f, 250.f), float3(0.f));
+
+        std::vector<uint32_t> reference;
+        InstanceCuller serial(1);
+        serial.build(boxes);
+        serial.cull(frustum, reference);
+
+        for (uint32_t threadCount : { 2u, 3u, 8u })
+        {
+            InstanceCuller culler(threadCount);
+            culler.build(boxes);
+            std::vector<uint32_t> visible;
+            culler.cull(frustum, visible);
+            EXPECT(visible == reference);
+        }
+    }
+
+    CPU_TEST(InstanceCullerBenchmark)
+    {
+        const uint32_t kInstanceCount = 1000000;
+        const uint32_t kFrameCount = 20;
+
+        std::vector<BoundingBox> boxes = createRandomBoxes(kInstanceCount, 1000.f, 5);
+        InstanceCuller culler;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        culler.build(boxes);
+        double buildMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        // Orbit the camera so every frame sees a different part of the scene.
+        std::vector<uint32_t> visible;
+        size_t visibleCount = 0;
+        double bruteForceMs = 0.0;
+        start = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < kFrameCount; i++)
+        {
+            float angle = glm::two_pi<float>() * i / kFrameCount;
+            Frustum frustum = createFrustum(float3(0.f), float3(std::cos(angle), 0.f, std::sin(angle)));
+            culler.cull(frustum, visible);
+            visibleCount += visible.size();
+        }
+        double cullMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        start = std::chrono::high_resolution_clock::now();
+        std::vector<uint32_t> reference = bruteForceCull(createFrustum(float3(0.f), float3(1.f, 0.f, 0.f)), boxes);
+        bruteForceMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        culler.cull(createFrustum(float3(0.f), float3(1.f, 0.f, 0.f)), visible);
+        EXPECT(sorted(visible) == reference);
+
+        logInfo("InstanceCullerBenchmark: " + std::to_string(kInstanceCount) + " instances, build " + std::to_string(buildMs) + " ms, " +
+            std::to_string(cullMs / kFrameCount) + " ms per frame (" + std::to_string(kInstanceCount * kFrameCount / cullMs) + " instances/ms, " +
+            std::to_string(visibleCount / kFrameCount) + " visible), brute force " + std::to_string(bruteForceMs) + " ms.");
+    }
+}
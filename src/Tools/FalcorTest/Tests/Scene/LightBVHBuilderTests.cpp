@@ -0,0 +1,127 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Experimental/Scene/Lights/LightBVHBuilder.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <cstring>
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Create a soup of small emissive triangles scattered in a unit cube.
+            A few triangles get zero flux so that the pre-integration culling is exercised as well.
+        */
+        std::vector<LightCollection::MeshLightTriangle> createTriangles(uint32_t triangleCount, uint32_t seed)
+        {
+            std::mt19937 rng(seed);
+            std::uniform_real_distribution<float> u(0.f, 1.f);
+
+            std::vector<LightCollection::MeshLightTriangle> triangles(triangleCount);
+            for (auto& tri : triangles)
+            {
+                float3 center = float3(u(rng), u(rng), u(rng));
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    tri.vtx[j].pos = center + 0.01f * (float3(u(rng), u(rng), u(rng)) - 0.5f);
+                }
+                float3 n = glm::cross(tri.vtx[1].pos - tri.vtx[0].pos, tri.vtx[2].pos - tri.vtx[0].pos);
+                tri.normal = glm::length(n) > 0.f ? glm::normalize(n) : float3(0.f, 0.f, 1.f);
+                tri.flux = u(rng) < 0.05f ? 0.f : u(rng);
+                tri.lightIdx = 0;
+            }
+            return triangles;
+        }
+
+        struct BuildOutput
+        {
+            std::vector<PackedNode> nodes;
+            std::vector<uint32_t> triangleIndices;
+            std::vector<uint64_t> triangleBitmasks;
+        };
+
+        BuildOutput build(const std::vector<LightCollection::MeshLightTriangle>& triangles, LightBVHBuilder::Options options, bool parallel)
+        {
+            options.useParallelBuild = parallel;
+            BuildOutput output;
+            LightBVHBuilder::create(options)->buildNodes(triangles, output.nodes, output.triangleIndices, output.triangleBitmasks);
+            return output;
+        }
+
+        void testParallelMatchesSerial(CPUUnitTestContext& ctx, const LightBVHBuilder::Options& options, uint32_t triangleCount)
+        {
+            auto triangles = createTriangles(triangleCount, 1234u);
+            BuildOutput serial = build(triangles, options, false);
+            BuildOutput parallel = build(triangles, options, true);
+
+            EXPECT(!serial.nodes.empty());
+            EXPECT_EQ(serial.nodes.size(), parallel.nodes.size());
+            EXPECT(serial.triangleIndices == parallel.triangleIndices);
+            EXPECT(serial.triangleBitmasks == parallel.triangleBitmasks);
+            if (serial.nodes.size() == parallel.nodes.size())
+            {
+                EXPECT_EQ(std::memcmp(serial.nodes.data(), parallel.nodes.data(), serial.nodes.size() * sizeof(PackedNode)), 0);
+            }
+        }
+    }
+
+    CPU_TEST(LightBVHBuilderParallelMatchesSerial)
+    {
+        LightBVHBuilder::Options options;
+        for (auto heuristic : { LightBVHBuilder::SplitHeuristic::Equal, LightBVHBuilder::SplitHeuristic::BinnedSAH, LightBVHBuilder::SplitHeuristic::BinnedSAOH })
+        {
+            options.splitHeuristicSelection = heuristic;
+            testParallelMatchesSerial(ctx, options, 1000);
+            testParallelMatchesSerial(ctx, options, 100000);
+        }
+
+        options.splitAlongLargest = true;
+        options.createLeavesASAP = false;
+        testParallelMatchesSerial(ctx, options, 100000);
+    }
+
+    CPU_TEST(LightBVHBuilderBuildTime)
+    {
+        LightBVHBuilder::Options options;
+        for (uint32_t triangleCount : { 1u << 14, 1u << 16, 1u << 18, 1u << 20 })
+        {
+            auto triangles = createTriangles(triangleCount, 5678u);
+
+            auto t0 = CpuTimer::getCurrentTimePoint();
+            BuildOutput serial = build(triangles, options, false);
+            auto t1 = CpuTimer::getCurrentTimePoint();
+            BuildOutput parallel = build(triangles, options, true);
+            auto t2 = CpuTimer::getCurrentTimePoint();
+
+            EXPECT_EQ(serial.nodes.size(), parallel.nodes.size());
+            logInfo("LightBVHBuilder: " + std::to_string(triangleCount) + " triangles, serial " + std::to_string(CpuTimer::calcDuration(t0, t1)) +
+                " ms, parallel " + std::to_string(CpuTimer::calcDuration(t1, t2)) + " ms");
+        }
+    }
+}
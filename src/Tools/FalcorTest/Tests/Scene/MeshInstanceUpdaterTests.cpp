@@ -0,0 +1,212 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/MeshInstanceUpdater.h"
+
+#include <chrono>
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        struct TestScene
+        {
+            std::vector<MeshInstanceData> instances;
+            std::vector<BoundingBox> meshBBs;
+            std::vector<glm::mat4> matrices;
+        };
+
+        // Instances spread over matrices and meshes at random. Every 16th matrix mirrors its instances.
+        TestScene createTestScene(uint32_t instanceCount, uint32_t matrixCount, uint32_t meshCount, uint32_t seed)
+        {
+            std::mt19937 rng(seed);
+            std::uniform_real_distribution<float> u(-100.f, 100.f);
+
+            TestScene scene;
+            scene.meshBBs.resize(meshCount);
+            for (auto& bb : scene.meshBBs) bb = BoundingBox::fromMinMax(float3(-1.f), float3(1.f, 2.f, 3.f) * (1.f + std::abs(u(rng)) * 0.01f));
+
+            scene.matrices.resize(matrixCount);
+            for (uint32_t m = 0; m < matrixCount; m++)
+            {
+                scene.matrices[m] = glm::translate(glm::mat4(1.f), float3(u(rng), u(rng), u(rng)));
+                if (m % 16 == 0) scene.matrices[m] = glm::scale(scene.matrices[m], float3(-1.f, 1.f, 1.f));
+            }
+
+            scene.instances.resize(instanceCount);
+            for (auto& inst : scene.instances)
+            {
+                inst = {};
+                inst.globalMatrixID = rng() % matrixCount;
+                inst.meshID = rng() % meshCount;
+            }
+            return scene;
+        }
+
+        bool equal(const BoundingBox& a, const BoundingBox& b)
+        {
+            return glm::all(glm::lessThanEqual(glm::abs(a.center - b.center), float3(1e-4f))) && glm::all(glm::lessThanEqual(glm::abs(a.extent - b.extent), float3(1e-4f)));
+        }
+    }
+
+    CPU_TEST(MeshInstanceUpdaterFindChangedInstances)
+    {
+        TestScene scene = createTestScene(1000, 50, 10, 1);
+        MeshInstanceUpdater updater(1);
+        updater.init(scene.instances, 50);
+
+        std::vector<uint32_t> changedMatrices = { 3, 17, 42 };
+        std::vector<uint32_t> changed;
+        updater.findChangedInstances(changedMatrices, changed);
+
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < (uint32_t)scene.instances.size(); i++)
+        {
+            uint32_t m = scene.instances[i].globalMatrixID;
+            if (m == 3 || m == 17 || m == 42) expected.push_back(i);
+        }
+        EXPECT(changed == expected);
+
+        updater.findChangedInstances({}, changed);
+        EXPECT(changed.empty());
+    }
+
+    CPU_TEST(MeshInstanceUpdaterBounds)
+    {
+        TestScene scene = createTestScene(20000, 500, 20, 2);
+        MeshInstanceUpdater updater(4);
+        updater.init(scene.instances, 500);
+
+        std::vector<BoundingBox> instanceBBs;
+        updater.updateBounds(scene.instances, scene.meshBBs, scene.matrices, instanceBBs);
+        BoundingBox sceneBB = updater.computeSceneBounds(instanceBBs);
+
+        // Move a few matrices and only update the affected instances.
+        std::vector<uint32_t> changedMatrices = { 1, 100, 499 };
+        for (uint32_t m : changedMatrices) scene.matrices[m] = glm::translate(scene.matrices[m], float3(500.f, 0.f, 0.f));
+        std::vector<uint32_t> changed;
+        updater.findChangedInstances(changedMatrices, changed);
+        updater.updateBounds(changed, scene.instances, scene.meshBBs, scene.matrices, instanceBBs);
+        sceneBB = updater.computeSceneBounds(instanceBBs);
+
+        BoundingBox expectedSceneBB = scene.meshBBs[scene.instances[0].meshID].transform(scene.matrices[scene.instances[0].globalMatrixID]);
+        bool allEqual = true;
+        for (size_t i = 0; i < scene.instances.size(); i++)
+        {
+            const auto& inst = scene.instances[i];
+            BoundingBox expected = scene.meshBBs[inst.meshID].transform(scene.matrices[inst.globalMatrixID]);
+            allEqual = allEqual && equal(instanceBBs[i], expected);
+            expectedSceneBB = BoundingBox::fromUnion(expectedSceneBB, expected);
+        }
+        EXPECT(allEqual);
+        EXPECT(equal(sceneBB, expectedSceneBB));
+
+        // Serial and parallel reductions agree.
+        MeshInstanceUpdater serial(1);
+        EXPECT(equal(serial.computeSceneBounds(instanceBBs), sceneBB));
+    }
+
+    CPU_TEST(MeshInstanceUpdaterDirtyRanges)
+    {
+        TestScene scene = createTestScene(10000, 100, 5, 3);
+        MeshInstanceUpdater updater(4);
+        updater.init(scene.instances, 100);
+
+        std::vector<MeshInstanceUpdater::Range> ranges;
+        updater.updateFlags(scene.instances, scene.matrices, ranges);
+        for (const auto& inst : scene.instances)
+        {
+            EXPECT_EQ(inst.flags, (uint32_t)(inst.globalMatrixID % 16 == 0 ? MeshInstanceFlags::Flipped : MeshInstanceFlags::None));
+        }
+
+        // Nothing changed, nothing to upload.
+        updater.updateFlags(scene.instances, scene.matrices, ranges);
+        EXPECT(ranges.empty());
+
+        // Mirror matrix 5 and move matrix 6. Only instances of matrix 5 become dirty.
+        scene.matrices[5] = glm::scale(scene.matrices[5], float3(1.f, -1.f, 1.f));
+        scene.matrices[6] = glm::translate(scene.matrices[6], float3(1.f));
+        std::vector<uint32_t> changed;
+        updater.findChangedInstances({ 5, 6 }, changed);
+        updater.updateFlags(changed, scene.instances, scene.matrices, ranges);
+
+        std::vector<uint8_t> covered(scene.instances.size(), 0);
+        uint32_t prevEnd = 0;
+        for (const auto& range : ranges)
+        {
+            EXPECT_LE(prevEnd, range.first);
+            prevEnd = range.first + range.count;
+            for (uint32_t i = range.first; i < range.first + range.count; i++) covered[i] = 1;
+        }
+        for (uint32_t i = 0; i < (uint32_t)scene.instances.size(); i++)
+        {
+            if (scene.instances[i].globalMatrixID == 5)
+            {
+                EXPECT_EQ(covered[i], 1);
+                EXPECT_EQ(scene.instances[i].flags, (uint32_t)MeshInstanceFlags::Flipped);
+            }
+        }
+        EXPECT_LE(ranges.size(), changed.size());
+    }
+
+    CPU_TEST(MeshInstanceUpdaterBenchmark)
+    {
+        const uint32_t kInstanceCount = 1000000;
+        const uint32_t kMatrixCount = 50000;
+        TestScene scene = createTestScene(kInstanceCount, kMatrixCount, 1000, 4);
+
+        MeshInstanceUpdater updater;
+        updater.init(scene.instances, kMatrixCount);
+        std::vector<BoundingBox> instanceBBs;
+        std::vector<MeshInstanceUpdater::Range> ranges;
+
+        // Full update, as done for every animated frame before change tracking.
+        auto start = std::chrono::high_resolution_clock::now();
+        updater.updateFlags(scene.instances, scene.matrices, ranges);
+        updater.updateBounds(scene.instances, scene.meshBBs, scene.matrices, instanceBBs);
+        BoundingBox sceneBB = updater.computeSceneBounds(instanceBBs);
+        double fullMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        // One animated node.
+        scene.matrices[7] = glm::translate(scene.matrices[7], float3(1.f));
+        std::vector<uint32_t> changed;
+        start = std::chrono::high_resolution_clock::now();
+        updater.findChangedInstances({ 7 }, changed);
+        updater.updateFlags(changed, scene.instances, scene.matrices, ranges);
+        updater.updateBounds(changed, scene.instances, scene.meshBBs, scene.matrices, instanceBBs);
+        sceneBB = updater.computeSceneBounds(instanceBBs);
+        double incrementalMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        EXPECT(ranges.empty());
+        EXPECT(glm::all(glm::greaterThan(sceneBB.extent, float3(0.f))));
+
+        logInfo("MeshInstanceUpdaterBenchmark: " + std::to_string(kInstanceCount) + " instances, full update " + std::to_string(fullMs) + " ms, one node moved (" +
+            std::to_string(changed.size()) + " instances) " + std::to_string(incrementalMs) + " ms.");
+    }
+}
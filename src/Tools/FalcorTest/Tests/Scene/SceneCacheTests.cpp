@@ -0,0 +1,319 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/SceneCache.h"
+
+#include <chrono>
+#include <fstream>
+
+namespace Falcor
+{
+    namespace
+    {
+        SceneCacheData createTestData(uint32_t vertexCount)
+        {
+            SceneCacheData data;
+            data.staticData.resize(vertexCount);
+            data.indices.resize(vertexCount);
+            for (uint32_t i = 0; i < vertexCount; i++)
+            {
+                data.staticData[i].position = float3((float)i, (float)i * 2.f, (float)i * 3.f);
+                data.staticData[i].packedNormalTangent = float3(0.5f, -0.5f, 1.f);
+                data.staticData[i].texCrd = float2((float)i / vertexCount, 1.f);
+                data.indices[i] = vertexCount - 1 - i;
+            }
+            data.dynamicData.resize(3);
+            data.dynamicData[1].boneID = uint4(1, 2, 3, 4);
+            data.dynamicData[1].staticIndex = 7;
+
+            SceneCacheData::MeshDesc mesh;
+            mesh.topology = 4;
+            mesh.materialId = 1;
+            mesh.indexCount = vertexCount;
+            mesh.vertexCount = vertexCount;
+            mesh.hasDynamicData = 1;
+            mesh.instances = { { 0, 0, 0 }, { 1, 0, 1 } };
+            data.meshes.push_back(mesh);
+
+            SceneCacheData::NodeDesc root;
+            root.name = "root";
+            root.transform = glm::mat4(2.f);
+            root.localToBindPose = glm::mat4(1.f);
+            root.children = { 1 };
+            root.meshes = { 0 };
+            SceneCacheData::NodeDesc child;
+            child.name = "child";
+            child.transform = glm::mat4(3.f);
+            child.localToBindPose = glm::mat4(1.f);
+            child.parent = 0;
+            child.meshes = { 0 };
+            data.sceneGraph = { root, child };
+
+            SceneCacheData::MaterialDesc plain;
+            plain.name = "plain";
+            plain.data.baseColor = float4(0.1f, 0.2f, 0.3f, 1.f);
+            SceneCacheData::MaterialDesc textured;
+            textured.name = "textured";
+            textured.occlusionMapEnabled = true;
+            textured.textures[(size_t)Material::TextureSlot::BaseColor] = { "textures/albedo.png", true, true };
+            textured.textures[(size_t)Material::TextureSlot::Normal] = { "textures/normal.exr", false, false };
+            data.materials = { plain, textured };
+
+            SceneCacheData::CameraDesc camera;
+            camera.name = "camera";
+            camera.data.focalLength = 35.f;
+            camera.preserveHeight = false;
+            data.cameras.push_back(camera);
+
+            SceneCacheData::LightDesc light;
+            light.name = "sun";
+            light.data.type = (uint32_t)LightType::Distant;
+            light.data.intensity = float3(5.f);
+            light.angle = 0.01f;
+            light.active = false;
+            data.lights.push_back(light);
+
+            data.selectedCamera = 0;
+            data.cameraSpeed = 4.f;
+            data.envMapFilename = "sky.exr";
+            data.dependencies = { "scene.mtl", "sky.exr" };
+            return data;
+        }
+
+        template<typename T>
+        bool equalBytes(const std::vector<T>& a, const std::vector<T>& b)
+        {
+            return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+        }
+
+        void checkEqual(CPUUnitTestContext& ctx, const SceneCacheData& a, const SceneCacheData& b)
+        {
+            EXPECT(equalBytes(a.indices, b.indices));
+            EXPECT(equalBytes(a.staticData, b.staticData));
+            EXPECT(equalBytes(a.dynamicData, b.dynamicData));
+
+            EXPECT_EQ(a.meshes.size(), b.meshes.size());
+            for (size_t i = 0; i < std::min(a.meshes.size(), b.meshes.size()); i++)
+            {
+                EXPECT_EQ(a.meshes[i].topology, b.meshes[i].topology);
+                EXPECT_EQ(a.meshes[i].materialId, b.meshes[i].materialId);
+                EXPECT_EQ(a.meshes[i].indexCount, b.meshes[i].indexCount);
+                EXPECT_EQ(a.meshes[i].vertexCount, b.meshes[i].vertexCount);
+                EXPECT_EQ(a.meshes[i].hasDynamicData, b.meshes[i].hasDynamicData);
+                EXPECT(equalBytes(a.meshes[i].instances, b.meshes[i].instances));
+            }
+
+            EXPECT_EQ(a.sceneGraph.size(), b.sceneGraph.size());
+            for (size_t i = 0; i < std::min(a.sceneGraph.size(), b.sceneGraph.size()); i++)
+            {
+                EXPECT(a.sceneGraph[i].name == b.sceneGraph[i].name);
+                EXPECT(a.sceneGraph[i].transform == b.sceneGraph[i].transform);
+                EXPECT(a.sceneGraph[i].localToBindPose == b.sceneGraph[i].localToBindPose);
+                EXPECT_EQ(a.sceneGraph[i].parent, b.sceneGraph[i].parent);
+                EXPECT(a.sceneGraph[i].children == b.sceneGraph[i].children);
+                EXPECT(a.sceneGraph[i].meshes == b.sceneGraph[i].meshes);
+            }
+
+            EXPECT_EQ(a.materials.size(), b.materials.size());
+            for (size_t i = 0; i < std::min(a.materials.size(), b.materials.size()); i++)
+            {
+                EXPECT(a.materials[i].name == b.materials[i].name);
+                EXPECT(std::memcmp(&a.materials[i].data, &b.materials[i].data, sizeof(MaterialData)) == 0);
+                EXPECT_EQ(a.materials[i].occlusionMapEnabled, b.materials[i].occlusionMapEnabled);
+                for (size_t t = 0; t < a.materials[i].textures.size(); t++)
+                {
+                    EXPECT(a.materials[i].textures[t].filename == b.materials[i].textures[t].filename);
+                    EXPECT_EQ(a.materials[i].textures[t].srgb, b.materials[i].textures[t].srgb);
+                    EXPECT_EQ(a.materials[i].textures[t].sparse, b.materials[i].textures[t].sparse);
+                }
+            }
+
+            EXPECT_EQ(a.cameras.size(), b.cameras.size());
+            for (size_t i = 0; i < std::min(a.cameras.size(), b.cameras.size()); i++)
+            {
+                EXPECT(a.cameras[i].name == b.cameras[i].name);
+                EXPECT(std::memcmp(&a.cameras[i].data, &b.cameras[i].data, sizeof(CameraData)) == 0);
+                EXPECT_EQ(a.cameras[i].preserveHeight, b.cameras[i].preserveHeight);
+            }
+
+            EXPECT_EQ(a.lights.size(), b.lights.size());
+            for (size_t i = 0; i < std::min(a.lights.size(), b.lights.size()); i++)
+            {
+                EXPECT(a.lights[i].name == b.lights[i].name);
+                EXPECT(std::memcmp(&a.lights[i].data, &b.lights[i].data, sizeof(LightData)) == 0);
+                EXPECT_EQ(a.lights[i].active, b.lights[i].active);
+                EXPECT(a.lights[i].scaling == b.lights[i].scaling);
+                EXPECT(a.lights[i].transform == b.lights[i].transform);
+                EXPECT_EQ(a.lights[i].angle, b.lights[i].angle);
+            }
+
+            EXPECT_EQ(a.selectedCamera, b.selectedCamera);
+            EXPECT_EQ(a.cameraSpeed, b.cameraSpeed);
+            EXPECT(a.envMapFilename == b.envMapFilename);
+            EXPECT(a.dependencies == b.dependencies);
+        }
+    }
+
+    CPU_TEST(SceneCacheRoundTrip)
+    {
+        const SceneCache::Key key = 0x1234;
+        const std::string filename = getTempFilename();
+        const SceneCacheData data = createTestData(1000);
+
+        EXPECT(SceneCache::writeCache(filename, key, data));
+        EXPECT(SceneCache::hasValidCache(filename, key));
+
+        SceneCacheData loaded;
+        EXPECT(SceneCache::readCache(filename, key, loaded));
+        checkEqual(ctx, data, loaded);
+
+        // Empty data round-trips as well.
+        EXPECT(SceneCache::writeCache(filename, key, SceneCacheData()));
+        EXPECT(SceneCache::readCache(filename, key, loaded));
+        checkEqual(ctx, SceneCacheData(), loaded);
+
+        std::remove(filename.c_str());
+    }
+
+    CPU_TEST(SceneCacheRejectsInvalidFiles)
+    {
+        const SceneCache::Key key = 0x5678;
+        const std::string filename = getTempFilename();
+        EXPECT(SceneCache::writeCache(filename, key, createTestData(100)));
+
+        // Wrong key.
+        SceneCacheData loaded;
+        EXPECT(!SceneCache::hasValidCache(filename, key + 1));
+        EXPECT(!SceneCache::readCache(filename, key + 1, loaded));
+
+        // Truncated file.
+        std::string contents;
+        {
+            std::ifstream in(filename, std::ios::binary);
+            contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        {
+            std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+            out.write(contents.data(), contents.size() - 10);
+        }
+        EXPECT(!SceneCache::hasValidCache(filename, key));
+        EXPECT(!SceneCache::readCache(filename, key, loaded));
+
+        // Missing file.
+        std::remove(filename.c_str());
+        EXPECT(!SceneCache::hasValidCache(filename, key));
+        EXPECT(!SceneCache::readCache(filename, key, loaded));
+    }
+
+    CPU_TEST(SceneCacheKey)
+    {
+        const std::string filename = getTempFilename();
+        {
+            std::ofstream out(filename);
+            out << "scene";
+        }
+
+        std::vector<glm::mat4> instances;
+        SceneCache::Key key = SceneCache::computeKey(filename, 0, instances);
+        EXPECT_NE(key, 0);
+        EXPECT_EQ(key, SceneCache::computeKey(filename, 0, instances));
+
+        // Build flags and instances are part of the key.
+        EXPECT_NE(key, SceneCache::computeKey(filename, 1, instances));
+        instances.push_back(glm::mat4(1.f));
+        EXPECT_NE(key, SceneCache::computeKey(filename, 0, instances));
+        instances.clear();
+
+        // So is the file content, through its size.
+        {
+            std::ofstream out(filename, std::ios::app);
+            out << "more";
+        }
+        EXPECT_NE(key, SceneCache::computeKey(filename, 0, instances));
+
+        std::remove(filename.c_str());
+        EXPECT_EQ(SceneCache::computeKey(filename, 0, instances), 0);
+    }
+
+    CPU_TEST(SceneCacheDependencies)
+    {
+        const SceneCache::Key key = 0x4321;
+        const std::string filename = getTempFilename();
+        const std::string dependency = getTempFilename();
+        {
+            std::ofstream out(dependency);
+            out << "newmtl";
+        }
+
+        SceneCacheData data = createTestData(10);
+        data.dependencies.push_back(dependency);
+        EXPECT(SceneCache::writeCache(filename, key, data));
+        EXPECT(SceneCache::hasValidCache(filename, key));
+
+        // A changed dependency invalidates the cache even though the key is the same.
+        {
+            std::ofstream out(dependency, std::ios::app);
+            out << " red";
+        }
+        SceneCacheData loaded;
+        EXPECT(!SceneCache::hasValidCache(filename, key));
+        EXPECT(!SceneCache::readCache(filename, key, loaded));
+
+        // So does a removed one.
+        EXPECT(SceneCache::writeCache(filename, key, data));
+        EXPECT(SceneCache::readCache(filename, key, loaded));
+        std::remove(dependency.c_str());
+        EXPECT(!SceneCache::hasValidCache(filename, key));
+        EXPECT(!SceneCache::readCache(filename, key, loaded));
+
+        std::remove(filename.c_str());
+    }
+
+    CPU_TEST(SceneCacheLoadBenchmark)
+    {
+        // 4M vertices, roughly the size of a production asset.
+        const uint32_t kVertexCount = 1 << 22;
+        const SceneCache::Key key = 0x9abc;
+        const std::string filename = getTempFilename();
+        const SceneCacheData data = createTestData(kVertexCount);
+        EXPECT(SceneCache::writeCache(filename, key, data));
+
+        SceneCacheData loaded;
+        auto start = std::chrono::high_resolution_clock::now();
+        EXPECT(SceneCache::readCache(filename, key, loaded));
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        EXPECT(equalBytes(data.staticData, loaded.staticData));
+        EXPECT(equalBytes(data.indices, loaded.indices));
+
+        double megabytes = (double)(kVertexCount * (sizeof(PackedStaticVertexData) + sizeof(uint32_t))) / (1024.0 * 1024.0);
+        logInfo("SceneCacheLoadBenchmark: loaded " + std::to_string(megabytes) + " MB in " + std::to_string(seconds * 1000.0) + " ms (" + std::to_string(megabytes / seconds) + " MB/s).");
+
+        std::remove(filename.c_str());
+    }
+}
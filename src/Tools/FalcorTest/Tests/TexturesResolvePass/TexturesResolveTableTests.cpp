@@ -0,0 +1,170 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "RenderPasses/TexturesResolvePass/TexturesResolveTable.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        TexturesResolve::VirtualTextureDesc createTexture(uint32_t textureID, uint32_t pagesCount, uint32_t firstPageID = 0)
+        {
+            TexturesResolve::VirtualTextureDesc desc;
+            desc.textureID = textureID;
+            desc.width = 1024;
+            desc.height = 512;
+            desc.mipLevelsCount = 11;
+            desc.mipTailStart = 4;
+            desc.pageSizeW = 128;
+            desc.pageSizeH = 128;
+            desc.pageSizeD = 1;
+            desc.pagesCount = pagesCount;
+            for (uint32_t i = 0; i < 16; i++) desc.mipBases[i] = i * 7;
+            for (uint32_t i = 0; i < pagesCount; i++) desc.pageIDs.push_back(firstPageID + i);
+            return desc;
+        }
+    }
+
+    CPU_TEST(TexturesResolveTablePacking)
+    {
+        // Texture 7 is shared by both materials, texture 3 is only used by the second one.
+        std::vector<TexturesResolve::MaterialTexturesDesc> materials =
+        {
+            { createTexture(7, 40), createTexture(9, 10) },
+            { createTexture(3, 5), createTexture(7, 40) },
+            { },
+        };
+
+        TexturesResolve::Table table;
+        EXPECT(table.build(materials));
+
+        const auto& packed = table.getMaterialsData();
+        EXPECT_EQ(packed.size(), 3);
+        EXPECT_EQ(packed[0].virtualTexturesCount, 2);
+        EXPECT_EQ(packed[1].virtualTexturesCount, 2);
+        EXPECT_EQ(packed[2].virtualTexturesCount, 0);
+
+        // Page ranges and resolve IDs are assigned in order of first use.
+        const auto& textures = table.getTextures();
+        EXPECT_EQ(textures.size(), 3);
+        EXPECT_EQ(textures[0].textureID, 7);
+        EXPECT_EQ(textures[0].pagesStartOffset, 0);
+        EXPECT_EQ(textures[1].textureID, 9);
+        EXPECT_EQ(textures[1].pagesStartOffset, 40);
+        EXPECT_EQ(textures[2].textureID, 3);
+        EXPECT_EQ(textures[2].pagesStartOffset, 50);
+        EXPECT_EQ(table.getTotalPagesCount(), 55 + TexturesResolve::kPageFlagsPadding);
+
+        // Shared textures are packed identically in every material that uses them.
+        EXPECT(std::memcmp(&packed[0].virtualTextures[0], &packed[1].virtualTextures[1], sizeof(VirtualTextureData)) == 0);
+        EXPECT_EQ(packed[1].virtualTextures[0].textureResolveID, 2);
+        EXPECT_EQ(packed[1].virtualTextures[0].pagesStartOffset, 50);
+        EXPECT_EQ(packed[1].virtualTextures[0].mipBases[3], 21);
+        EXPECT_EQ(packed[1].virtualTextures[0].empty, 0);
+        for (uint32_t t = 2; t < MAX_VTEX_PER_MATERIAL_COUNT; t++) EXPECT_EQ(packed[0].virtualTextures[t].empty, 1);
+
+        // Rebuilding from the same input does not require an upload, a change does.
+        EXPECT(!table.build(materials));
+        materials[2].push_back(createTexture(11, 1));
+        EXPECT(table.build(materials));
+        EXPECT_EQ(table.getTotalPagesCount(), 56 + TexturesResolve::kPageFlagsPadding);
+
+        // Materials can't reference more than MAX_VTEX_PER_MATERIAL_COUNT textures.
+        TexturesResolve::MaterialTexturesDesc manyTextures;
+        for (uint32_t i = 0; i < MAX_VTEX_PER_MATERIAL_COUNT + 4; i++) manyTextures.push_back(createTexture(100 + i, 1));
+        EXPECT(table.build({ manyTextures }));
+        EXPECT_EQ(table.getMaterialsData()[0].virtualTexturesCount, MAX_VTEX_PER_MATERIAL_COUNT);
+        EXPECT_EQ(table.getTextures().size(), MAX_VTEX_PER_MATERIAL_COUNT);
+    }
+
+    CPU_TEST(TexturesResolvePageFlagsDiff)
+    {
+        TexturesResolve::Table table;
+        table.build({ { createTexture(1, 8, 100), createTexture(2, 4, 200) } });
+
+        TexturesResolve::PageFlagsTracker tracker;
+        std::vector<int8_t> flags(table.getTotalPagesCount(), 0);
+
+        // Nothing flagged, nothing requested.
+        EXPECT(tracker.diff(table, flags.data()).empty());
+
+        flags[2] = 1;
+        flags[9] = 1;
+        flags[10] = 1;
+        auto requests = tracker.diff(table, flags.data());
+        EXPECT_EQ(requests.size(), 2);
+        EXPECT_EQ(requests[0].textureIndex, 0);
+        EXPECT(requests[0].pageIDs == std::vector<uint32_t>({ 102 }));
+        EXPECT_EQ(requests[1].textureIndex, 1);
+        EXPECT(requests[1].pageIDs == std::vector<uint32_t>({ 201, 202 }));
+        EXPECT_EQ(tracker.getRequestedCount(), 3);
+
+        // Same flags again: all pages were already requested.
+        EXPECT(tracker.diff(table, flags.data()).empty());
+
+        // Only the newly flagged page is reported. Flags in the padding are ignored.
+        flags[5] = 1;
+        flags[table.getTotalPagesCount() - 1] = 1;
+        requests = tracker.diff(table, flags.data());
+        EXPECT_EQ(requests.size(), 1);
+        EXPECT(requests[0].pageIDs == std::vector<uint32_t>({ 105 }));
+
+        // After a reset everything flagged is requested again.
+        tracker.reset(table.getTotalPagesCount());
+        requests = tracker.diff(table, flags.data());
+        EXPECT_EQ(requests.size(), 2);
+        EXPECT_EQ(tracker.getRequestedCount(), 4);
+    }
+
+    CPU_TEST(TexturesResolvePageFlagsGlobalIDs)
+    {
+        // The resource manager numbers pages globally in texture creation order, which differs from the resolve order here.
+        TexturesResolve::Table table;
+        table.build({ { createTexture(5, 6, 30) }, { createTexture(4, 3, 0) } });
+        EXPECT_EQ(table.getTextures()[1].pagesStartOffset, 6);
+
+        TexturesResolve::PageFlagsTracker tracker;
+        std::vector<int8_t> flags(table.getTotalPagesCount(), 0);
+        flags[0] = 1;
+        flags[6] = 1;
+        flags[8] = 1;
+        auto requests = tracker.diff(table, flags.data());
+        EXPECT_EQ(requests.size(), 2);
+        EXPECT(requests[0].pageIDs == std::vector<uint32_t>({ 30 }));
+        EXPECT_EQ(requests[1].textureIndex, 1);
+        EXPECT(requests[1].pageIDs == std::vector<uint32_t>({ 0, 2 }));
+
+        // Recreated textures get new page IDs, the layout is the same but the table must be rebuilt.
+        EXPECT(table.build({ { createTexture(5, 6, 30) }, { createTexture(4, 3, 40) } }));
+        requests = tracker.diff(table, flags.data());
+        EXPECT(requests.empty());
+        tracker.reset(table.getTotalPagesCount());
+        requests = tracker.diff(table, flags.data());
+        EXPECT(requests[1].pageIDs == std::vector<uint32_t>({ 40, 42 }));
+    }
+}
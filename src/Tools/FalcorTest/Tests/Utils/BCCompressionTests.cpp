@@ -0,0 +1,283 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Image/BCCompression.h"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Smooth gradients with some noise, roughly what texture content looks like.
+        */
+        std::vector<uint8_t> createTestImage(uint32_t width, uint32_t height, uint32_t channels, uint32_t seed)
+        {
+            std::mt19937 rng(seed);
+            std::uniform_int_distribution<int> noise(-6, 6);
+            std::vector<uint8_t> image(size_t(width) * height * channels);
+            for (uint32_t y = 0; y < height; y++)
+            {
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    for (uint32_t c = 0; c < channels; c++)
+                    {
+                        float v = 128.f + 100.f * std::sin(0.05f * x * (c + 1) + 0.07f * y);
+                        image[(size_t(y) * width + x) * channels + c] = uint8_t(std::min(255, std::max(0, int(v) + noise(rng))));
+                    }
+                }
+            }
+            return image;
+        }
+
+        double psnr(const uint8_t* pA, const uint8_t* pB, size_t count, uint32_t channels, uint32_t usedChannels)
+        {
+            double sum = 0.0;
+            size_t n = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (i % channels >= usedChannels) continue;
+                double d = double(pA[i]) - double(pB[i]);
+                sum += d * d;
+                n++;
+            }
+            if (sum == 0.0) return 100.0;
+            return 10.0 * std::log10(255.0 * 255.0 / (sum / n));
+        }
+
+        size_t getCompressedSize(ResourceFormat format, uint32_t width, uint32_t height)
+        {
+            return size_t((width + 3) / 4) * ((height + 3) / 4) * getFormatBytesPerBlock(format);
+        }
+
+        /** Compress and decompress an 8-bit image, returns the PSNR over the used channels.
+        */
+        double roundTrip(ResourceFormat format, uint32_t width, uint32_t height, const std::vector<uint8_t>& image, uint32_t channels, uint32_t usedChannels, std::vector<uint8_t>& decoded)
+        {
+            std::vector<uint8_t> blocks(getCompressedSize(format, width, height));
+            decoded.assign(image.size(), 0);
+            if (!bcCompress(format, width, height, image.data(), width * channels, blocks.data())) return 0.0;
+            if (!bcDecompress(format, width, height, blocks.data(), 0, decoded.data(), width * channels)) return 0.0;
+            return psnr(image.data(), decoded.data(), image.size(), channels, usedChannels);
+        }
+    }
+
+    CPU_TEST(BCCompressionFormats)
+    {
+        EXPECT(isBCEncodeSupported(ResourceFormat::BC1RGBUnorm));
+        EXPECT(isBCEncodeSupported(ResourceFormat::BC4Unorm));
+        EXPECT(isBCEncodeSupported(ResourceFormat::BC5Unorm));
+        EXPECT(isBCEncodeSupported(ResourceFormat::BC6HU16));
+        EXPECT(isBCEncodeSupported(ResourceFormat::BC7Unorm));
+        EXPECT(!isBCEncodeSupported(ResourceFormat::BC3RGBAUnorm));
+        EXPECT(!isBCEncodeSupported(ResourceFormat::RGBA8Unorm));
+
+        EXPECT(getBCSourceFormat(ResourceFormat::BC4Unorm) == ResourceFormat::R8Unorm);
+        EXPECT(getBCSourceFormat(ResourceFormat::BC5Unorm) == ResourceFormat::RG8Unorm);
+        EXPECT(getBCSourceFormat(ResourceFormat::BC6HU16) == ResourceFormat::RGBA32Float);
+        EXPECT(getBCSourceFormat(ResourceFormat::BC7Srgb) == ResourceFormat::RGBA8Unorm);
+
+        uint8_t texel = 0, block[16] = {};
+        EXPECT(!bcCompress(ResourceFormat::RGBA8Unorm, 1, 1, &texel, 4, block));
+    }
+
+    CPU_TEST(BCCompressionRoundTrip)
+    {
+        const uint32_t w = 64, h = 64;
+        std::vector<uint8_t> decoded;
+
+        auto rgba = createTestImage(w, h, 4, 1);
+        double bc1 = roundTrip(ResourceFormat::BC1RGBUnorm, w, h, rgba, 4, 3, decoded);
+        double bc7 = roundTrip(ResourceFormat::BC7Unorm, w, h, rgba, 4, 4, decoded);
+        auto r = createTestImage(w, h, 1, 2);
+        double bc4 = roundTrip(ResourceFormat::BC4Unorm, w, h, r, 1, 1, decoded);
+        auto rg = createTestImage(w, h, 2, 3);
+        double bc5 = roundTrip(ResourceFormat::BC5Unorm, w, h, rg, 2, 2, decoded);
+
+        EXPECT_GE(bc1, 30.0);
+        EXPECT_GE(bc7, 35.0);
+        EXPECT_GE(bc4, 38.0);
+        EXPECT_GE(bc5, 38.0);
+        EXPECT_GE(bc7, bc1);
+    }
+
+    CPU_TEST(BCCompressionSolidBlocks)
+    {
+        // Constant blocks must survive exactly where the endpoint precision allows it.
+        const uint8_t colors[][4] = { { 0, 0, 0, 255 }, { 255, 255, 255, 255 }, { 255, 0, 0, 255 }, { 0, 130, 255, 255 } };
+        for (const auto& color : colors)
+        {
+            std::vector<uint8_t> rgba(16 * 4);
+            for (uint32_t i = 0; i < 16; i++) std::memcpy(&rgba[i * 4], color, 4);
+
+            std::vector<uint8_t> decoded;
+            EXPECT_EQ(roundTrip(ResourceFormat::BC1RGBUnorm, 4, 4, rgba, 4, 3, decoded), 100.0);
+            EXPECT_GE(roundTrip(ResourceFormat::BC7Unorm, 4, 4, rgba, 4, 4, decoded), 45.0);
+        }
+
+        std::vector<uint8_t> r(16, 77), decoded;
+        EXPECT_EQ(roundTrip(ResourceFormat::BC4Unorm, 4, 4, r, 1, 1, decoded), 100.0);
+    }
+
+    CPU_TEST(BCCompressionAnchorIndex)
+    {
+        // A two color block whose first texel sits at the far end of the fitted line; the encoder has to swap the endpoints.
+        std::vector<uint8_t> rgba(16 * 4);
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            uint8_t v = (i == 0 || i == 5) ? 250 : 10;
+            rgba[i * 4 + 0] = v;
+            rgba[i * 4 + 1] = v;
+            rgba[i * 4 + 2] = 255 - v;
+            rgba[i * 4 + 3] = 255;
+        }
+        std::vector<uint8_t> decoded;
+        EXPECT_GE(roundTrip(ResourceFormat::BC7Unorm, 4, 4, rgba, 4, 4, decoded), 40.0);
+        EXPECT_GE(roundTrip(ResourceFormat::BC1RGBUnorm, 4, 4, rgba, 4, 3, decoded), 35.0);
+
+        std::vector<float> hdr(16 * 4, 1.f);
+        for (uint32_t i = 0; i < 16; i++) hdr[i * 4 + 0] = (i == 0) ? 8.f : 0.25f;
+        std::vector<uint8_t> block(16);
+        std::vector<float> hdrDecoded(16 * 4);
+        bcCompress(ResourceFormat::BC6HU16, 4, 4, hdr.data(), 4 * 16, block.data());
+        bcDecompress(ResourceFormat::BC6HU16, 4, 4, block.data(), 0, hdrDecoded.data(), 4 * 16);
+        EXPECT(std::abs(hdrDecoded[0] - 8.f) < 0.5f);
+        EXPECT(std::abs(hdrDecoded[4] - 0.25f) < 0.25f);
+    }
+
+    CPU_TEST(BCCompressionEdges)
+    {
+        // Sizes that are not multiples of the block size, including the mip tail sizes.
+        const uint32_t sizes[][2] = { { 1, 1 }, { 2, 2 }, { 3, 3 }, { 5, 7 }, { 13, 6 }, { 130, 67 } };
+        for (const auto& size : sizes)
+        {
+            uint32_t w = size[0], h = size[1];
+            auto rgba = createTestImage(w, h, 4, w * 31 + h);
+            std::vector<uint8_t> decoded;
+            EXPECT_GE(roundTrip(ResourceFormat::BC7Unorm, w, h, rgba, 4, 4, decoded), 30.0);
+
+            auto r = createTestImage(w, h, 1, w + h);
+            EXPECT_GE(roundTrip(ResourceFormat::BC4Unorm, w, h, r, 1, 1, decoded), 30.0);
+        }
+
+        // Encoding into a tile inside a larger page must leave the rest of the page alone.
+        const uint32_t w = 8, h = 8;
+        auto rgba = createTestImage(w, h, 4, 9);
+        const size_t pitch = 64;
+        std::vector<uint8_t> page(pitch * 4, 0xcd);
+        bcCompress(ResourceFormat::BC1RGBUnorm, w, h, rgba.data(), w * 4, page.data(), pitch);
+        for (uint32_t row = 0; row < 2; row++)
+        {
+            for (size_t i = 16; i < pitch; i++) EXPECT_EQ(page[row * pitch + i], 0xcd);
+        }
+        for (size_t i = 2 * pitch; i < page.size(); i++) EXPECT_EQ(page[i], 0xcd);
+    }
+
+    CPU_TEST(BCCompressionParallelMatchesSerial)
+    {
+        const uint32_t w = 256, h = 256;
+        auto rgba = createTestImage(w, h, 4, 5);
+        std::vector<uint8_t> serial(getCompressedSize(ResourceFormat::BC7Unorm, w, h));
+        std::vector<uint8_t> parallel(serial.size());
+        bcCompress(ResourceFormat::BC7Unorm, w, h, rgba.data(), w * 4, serial.data(), 0, false);
+        bcCompress(ResourceFormat::BC7Unorm, w, h, rgba.data(), w * 4, parallel.data(), 0, true);
+        EXPECT(serial == parallel);
+    }
+
+    CPU_TEST(BCCompressionHDR)
+    {
+        const uint32_t w = 32, h = 32;
+        std::vector<float> hdr(size_t(w) * h * 4);
+        for (uint32_t y = 0; y < h; y++)
+        {
+            for (uint32_t x = 0; x < w; x++)
+            {
+                float* p = &hdr[(size_t(y) * w + x) * 4];
+                p[0] = 0.1f + 4.f * x / w;
+                p[1] = 0.5f + 0.5f * std::sin(0.2f * y);
+                p[2] = 0.05f * y + 0.02f * x;
+                p[3] = 1.f;
+            }
+        }
+
+        std::vector<uint8_t> blocks(getCompressedSize(ResourceFormat::BC6HU16, w, h));
+        std::vector<float> decoded(hdr.size());
+        EXPECT(bcCompress(ResourceFormat::BC6HU16, w, h, hdr.data(), w * 16, blocks.data()));
+        EXPECT(bcDecompress(ResourceFormat::BC6HU16, w, h, blocks.data(), 0, decoded.data(), w * 16));
+
+        // Relative error in log space, BC6H quantizes roughly logarithmically.
+        double sum = 0.0;
+        for (size_t i = 0; i < hdr.size(); i++)
+        {
+            if (i % 4 == 3) continue;
+            double d = std::log2(1.0 + decoded[i]) - std::log2(1.0 + hdr[i]);
+            sum += d * d;
+        }
+        double rmse = std::sqrt(sum / (hdr.size() * 3 / 4));
+        EXPECT_LE(rmse, 0.1);
+
+        // Negative and non-finite input must not produce garbage.
+        std::vector<float> special(16 * 4, -1.f);
+        special[0] = std::numeric_limits<float>::infinity();
+        bcCompress(ResourceFormat::BC6HU16, 4, 4, special.data(), 64, blocks.data());
+        bcDecompress(ResourceFormat::BC6HU16, 4, 4, blocks.data(), 0, decoded.data(), 64);
+        for (uint32_t i = 0; i < 16; i++) EXPECT(std::isfinite(decoded[i * 4]) && decoded[i * 4] >= 0.f);
+    }
+
+    CPU_TEST(BCCompressionBenchmark)
+    {
+        const uint32_t w = 1024, h = 1024;
+        auto rgba = createTestImage(w, h, 4, 11);
+        auto rg = createTestImage(w, h, 2, 12);
+
+        struct Case { ResourceFormat format; const std::vector<uint8_t>* pImage; uint32_t channels; uint32_t usedChannels; const char* name; };
+        const Case cases[] = {
+            { ResourceFormat::BC1RGBUnorm, &rgba, 4, 3, "BC1" },
+            { ResourceFormat::BC5Unorm, &rg, 2, 2, "BC5" },
+            { ResourceFormat::BC7Unorm, &rgba, 4, 4, "BC7" },
+        };
+
+        for (const auto& c : cases)
+        {
+            std::vector<uint8_t> blocks(getCompressedSize(c.format, w, h));
+            std::vector<uint8_t> decoded(c.pImage->size());
+
+            auto start = std::chrono::high_resolution_clock::now();
+            bcCompress(c.format, w, h, c.pImage->data(), w * c.channels, blocks.data());
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+            bcDecompress(c.format, w, h, blocks.data(), 0, decoded.data(), w * c.channels);
+            double quality = psnr(c.pImage->data(), decoded.data(), decoded.size(), c.channels, c.usedChannels);
+            logInfo(std::string(c.name) + " " + std::to_string(w) + "x" + std::to_string(h) + ": " + std::to_string(ms) + " ms, " +
+                std::to_string(w * h / 1000.0 / ms) + " MTexels/s, PSNR " + std::to_string(quality) + " dB");
+            EXPECT_GE(quality, 28.0);
+        }
+    }
+}
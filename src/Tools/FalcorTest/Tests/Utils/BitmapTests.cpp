@@ -0,0 +1,118 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Image/Bitmap.h"
+#include <OpenImageIO/imageio.h>
+#include <cstdio>
+
+namespace Falcor
+{
+    namespace
+    {
+        std::vector<float> createTestImage(uint32_t width, uint32_t height)
+        {
+            std::vector<float> data(size_t(width) * height * 4);
+            for (size_t i = 0; i < data.size(); i++) data[i] = float(i % 1021) * 0.25f;
+            return data;
+        }
+
+        bool readExr(const std::string& filename, uint32_t width, uint32_t height, std::vector<float>& data)
+        {
+            auto in = OpenImageIO_v2_3::ImageInput::open(filename);
+            if (!in) return false;
+            const auto& spec = in->spec();
+            if (spec.width != int(width) || spec.height != int(height) || spec.nchannels != 4) return false;
+            data.resize(size_t(width) * height * 4);
+            bool result = in->read_image(OpenImageIO_v2_3::TypeDesc::FLOAT, data.data());
+            in->close();
+            return result;
+        }
+    }
+
+    CPU_TEST(BitmapStreamWriter)
+    {
+        // Odd sizes so that blocks don't line up with the conversion granularity.
+        const uint32_t width = 333, height = 257, blockRows = 50;
+        const auto image = createTestImage(width, height);
+        const std::string tempFilename = getTempFilename();
+        const std::string filename = tempFilename + ".exr";
+
+        auto flags = Bitmap::ExportFlags::ExportAlpha | Bitmap::ExportFlags::Uncompressed;
+        auto pWriter = Bitmap::StreamWriter::create(filename, width, height, flags, ResourceFormat::RGBA32Float);
+        EXPECT(pWriter != nullptr);
+        if (!pWriter) return;
+
+        // Rows out of order are rejected.
+        EXPECT(!pWriter->writeRows(blockRows, blockRows, image.data()));
+
+        for (uint32_t row = 0; row < height; row += blockRows)
+        {
+            uint32_t rowCount = std::min(blockRows, height - row);
+            EXPECT(pWriter->writeRows(row, rowCount, image.data() + size_t(row) * width * 4));
+        }
+        EXPECT_EQ(pWriter->getRowsWritten(), height);
+        EXPECT(pWriter->close());
+
+        std::vector<float> result;
+        EXPECT(readExr(filename, width, height, result));
+        EXPECT(result == image);
+        std::remove(filename.c_str());
+        std::remove(tempFilename.c_str());
+    }
+
+    CPU_TEST(BitmapSaveImageAsync)
+    {
+        const uint32_t width = 200, height = 150;
+        const uint32_t kFileCount = 8;
+        const auto image = createTestImage(width, height);
+        const auto pBytes = reinterpret_cast<const uint8_t*>(image.data());
+
+        std::vector<std::string> tempFilenames;
+        std::vector<std::string> filenames;
+        std::vector<std::shared_future<void>> futures;
+        for (uint32_t i = 0; i < kFileCount; i++)
+        {
+            tempFilenames.push_back(getTempFilename());
+            filenames.push_back(tempFilenames.back() + ".exr");
+            std::vector<uint8_t> data(pBytes, pBytes + image.size() * sizeof(float));
+            auto flags = Bitmap::ExportFlags::ExportAlpha | Bitmap::ExportFlags::Uncompressed;
+            futures.push_back(Bitmap::saveImageAsync(filenames.back(), width, height, Bitmap::FileFormat::ExrFile, flags, ResourceFormat::RGBA32Float, true, std::move(data)));
+        }
+        Bitmap::waitForPendingSaves();
+
+        for (uint32_t i = 0; i < kFileCount; i++)
+        {
+            EXPECT(futures[i].wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+            std::vector<float> result;
+            EXPECT(readExr(filenames[i], width, height, result));
+            EXPECT(result == image);
+            std::remove(filenames[i].c_str());
+            std::remove(tempFilenames[i].c_str());
+        }
+    }
+}
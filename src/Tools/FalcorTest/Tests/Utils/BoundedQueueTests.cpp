@@ -0,0 +1,94 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/BoundedQueue.h"
+
+#include <atomic>
+#include <thread>
+
+namespace Falcor
+{
+    CPU_TEST(BoundedQueueOrder)
+    {
+        BoundedQueue<int> queue(4);
+        EXPECT_EQ(queue.capacity(), 4u);
+        for (int i = 0; i < 4; i++) EXPECT(queue.push(i));
+        EXPECT_EQ(queue.size(), 4u);
+
+        int value = -1;
+        for (int i = 0; i < 4; i++)
+        {
+            EXPECT(queue.pop(value));
+            EXPECT_EQ(value, i);
+        }
+        EXPECT_EQ(queue.size(), 0u);
+    }
+
+    CPU_TEST(BoundedQueueClose)
+    {
+        BoundedQueue<int> queue(4);
+        queue.push(1);
+        queue.push(2);
+        queue.close();
+
+        // Closed queues refuse new items but still hand out the ones they hold.
+        EXPECT(!queue.push(3));
+        int value = 0;
+        EXPECT(queue.pop(value));
+        EXPECT_EQ(value, 1);
+        EXPECT(queue.pop(value));
+        EXPECT_EQ(value, 2);
+        EXPECT(!queue.pop(value));
+    }
+
+    CPU_TEST(BoundedQueueBackPressure)
+    {
+        const int kItemCount = 10000;
+        BoundedQueue<int> queue(2);
+        std::atomic<size_t> maxSize(0);
+
+        std::thread consumer([&]()
+        {
+            int value = 0;
+            int expected = 0;
+            while (queue.pop(value))
+            {
+                if (value != expected++) return;
+                size_t size = queue.size();
+                if (size > maxSize) maxSize = size;
+            }
+        });
+
+        for (int i = 0; i < kItemCount; i++) queue.push(i);
+        queue.close();
+        consumer.join();
+
+        // The producer never got more than capacity items ahead.
+        EXPECT_LE(maxSize.load(), 2u);
+    }
+}
@@ -0,0 +1,152 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "../../../ImageCompare/ImageMetrics.h"
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        ImageCompare::Image::SharedPtr createRandomImage(uint32_t width, uint32_t height, uint32_t seed)
+        {
+            std::mt19937 rng(seed);
+            std::uniform_real_distribution<float> u(0.f, 1.f);
+            auto image = ImageCompare::Image::create(width, height);
+            for (size_t i = 0; i < size_t(width) * height * 4; i++) image->getData()[i] = u(rng);
+            return image;
+        }
+
+        const ImageCompare::ErrorMetric* findMetric(const std::string& name)
+        {
+            for (const auto& metric : ImageCompare::errorMetrics)
+            {
+                if (metric.name == name) return &metric;
+            }
+            return nullptr;
+        }
+
+        /** Reference per-pixel evaluation: mean over RGB of channelError(a, b), averaged over all pixels.
+        */
+        template<typename Func>
+        double referenceError(const ImageCompare::Image& imageA, const ImageCompare::Image& imageB, const Func& channelError)
+        {
+            const size_t pixelCount = size_t(imageA.getWidth()) * imageA.getHeight();
+            double sum = 0.0;
+            for (size_t i = 0; i < pixelCount; i++)
+            {
+                double pixel = 0.0;
+                for (size_t c = 0; c < 3; c++) pixel += channelError(double(imageA.getData()[i * 4 + c]), double(imageB.getData()[i * 4 + c]));
+                sum += pixel / 3.0;
+            }
+            return sum / pixelCount;
+        }
+
+        void expectMetric(CPUUnitTestContext& ctx, const std::string& name, const ImageCompare::Image& imageA, const ImageCompare::Image& imageB, double expected)
+        {
+            const ImageCompare::ErrorMetric* pMetric = findMetric(name);
+            EXPECT(pMetric != nullptr) << name;
+            if (!pMetric) return;
+
+            ImageCompare::CompareOptions options;
+            for (uint32_t threadCount : { 1u, 4u })
+            {
+                options.threadCount = threadCount;
+                ImageCompare::CompareResult result = pMetric->compare(imageA, imageB, options, nullptr);
+                EXPECT(!result.aborted) << name;
+                EXPECT_LE(std::abs(result.error - expected), 1e-4 * std::max(1.0, std::abs(expected))) << name << " with " << threadCount << " threads";
+            }
+        }
+    }
+
+    CPU_TEST(ImageMetrics)
+    {
+        // Odd dimensions, so that there are partial tiles.
+        auto imageA = createRandomImage(131, 70, 1);
+        auto imageB = createRandomImage(131, 70, 2);
+
+        double mse = referenceError(*imageA, *imageB, [](double a, double b) { return (a - b) * (a - b); });
+        expectMetric(ctx, "mse", *imageA, *imageB, mse);
+        expectMetric(ctx, "rootmse", *imageA, *imageB, std::sqrt(mse));
+
+        // "rmse" keeps its original meaning, the relative MSE.
+        expectMetric(ctx, "rmse", *imageA, *imageB, referenceError(*imageA, *imageB, [](double a, double b) { return (a - b) * (a - b) / (a * a + 1e-3); }));
+        // So does "mae", which has always been the squared difference.
+        expectMetric(ctx, "mae", *imageA, *imageB, mse);
+        expectMetric(ctx, "absmae", *imageA, *imageB, referenceError(*imageA, *imageB, [](double a, double b) { return std::abs(a - b); }));
+        expectMetric(ctx, "mape", *imageA, *imageB, referenceError(*imageA, *imageB, [](double a, double b) { return 100.0 * std::abs((a - b) / (a + 1e-3)); }));
+
+        for (const auto& metric : ImageCompare::errorMetrics)
+        {
+            ImageCompare::CompareResult same = metric.compare(*imageA, *imageA, ImageCompare::CompareOptions(), nullptr);
+            EXPECT_EQ(same.error, 0.0) << metric.name;
+        }
+    }
+
+    CPU_TEST(ImageMetricsFLIP)
+    {
+        auto imageA = createRandomImage(96, 64, 3);
+        auto imageB = ImageCompare::Image::create(96, 64);
+        std::memcpy(imageB->getData(), imageA->getData(), size_t(96) * 64 * 4 * sizeof(float));
+
+        // A small square of different color must give a small error, and most of the error map stays at zero.
+        for (uint32_t y = 20; y < 28; y++)
+        {
+            for (uint32_t x = 40; x < 48; x++)
+            {
+                float* pixel = imageB->getData() + (size_t(y) * 96 + x) * 4;
+                pixel[0] = 1.f - pixel[0];
+            }
+        }
+
+        std::vector<float> errorMap(size_t(96) * 64);
+        ImageCompare::CompareResult result = ImageCompare::compareFLIP(*imageA, *imageB, ImageCompare::CompareOptions(), errorMap.data());
+        EXPECT_GT(result.error, 0.0);
+        EXPECT_LT(result.error, 0.1);
+        EXPECT_GT(errorMap[24 * 96 + 44], 0.f);
+        EXPECT_EQ(errorMap[0], 0.f);
+        for (float e : errorMap) EXPECT(e >= 0.f && e <= 1.f);
+    }
+
+    CPU_TEST(ImageMetricsEarlyOut)
+    {
+        auto imageA = createRandomImage(512, 512, 4);
+        auto imageB = createRandomImage(512, 512, 5);
+
+        ImageCompare::CompareOptions options;
+        options.threshold = 1e-3f;
+        double full = ImageCompare::compare<ImageCompare::MSE>(*imageA, *imageB, options, nullptr).error;
+
+        // The early out stops with a lower bound that already exceeds the threshold.
+        options.earlyOut = true;
+        ImageCompare::CompareResult result = ImageCompare::compare<ImageCompare::MSE>(*imageA, *imageB, options, nullptr);
+        EXPECT(result.aborted);
+        EXPECT_GT(result.error, double(options.threshold));
+        EXPECT_LE(result.error, full);
+    }
+}
@@ -0,0 +1,293 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Image/LTX_MipTail.h"
+#include "Utils/Image/BCCompression.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        template<typename T>
+        std::vector<uint8_t> createRandomImage(uint32_t width, uint32_t height, uint32_t channels, uint32_t seed)
+        {
+            std::mt19937 rng(seed);
+            std::vector<uint8_t> image(size_t(width) * height * channels * sizeof(T));
+            T* pTexels = reinterpret_cast<T*>(image.data());
+            for (size_t i = 0; i < size_t(width) * height * channels; i++)
+            {
+                if constexpr (std::is_same<T, float>::value) pTexels[i] = std::uniform_real_distribution<float>(0.f, 100.f)(rng);
+                else pTexels[i] = T(rng());
+            }
+            return image;
+        }
+
+        /** Reference 2x2 box filter, one texel at a time.
+        */
+        template<typename T>
+        std::vector<uint8_t> referenceDownsample(const std::vector<uint8_t>& src, uint32_t width, uint32_t height, uint32_t channels)
+        {
+            uint32_t dstWidth = std::max(width / 2, 1u);
+            uint32_t dstHeight = std::max(height / 2, 1u);
+            std::vector<uint8_t> dst(size_t(dstWidth) * dstHeight * channels * sizeof(T));
+            const T* pSrc = reinterpret_cast<const T*>(src.data());
+            T* pDst = reinterpret_cast<T*>(dst.data());
+
+            auto texel = [&](uint32_t x, uint32_t y, uint32_t c)
+            {
+                return pSrc[(size_t(std::min(y, height - 1)) * width + std::min(x, width - 1)) * channels + c];
+            };
+            for (uint32_t y = 0; y < dstHeight; y++)
+            {
+                for (uint32_t x = 0; x < dstWidth; x++)
+                {
+                    for (uint32_t c = 0; c < channels; c++)
+                    {
+                        T a = texel(2 * x, 2 * y, c), b = texel(2 * x + 1, 2 * y, c), d = texel(2 * x, 2 * y + 1, c), e = texel(2 * x + 1, 2 * y + 1, c);
+                        T& out = pDst[(size_t(y) * dstWidth + x) * channels + c];
+                        if constexpr (std::is_same<T, float>::value) out = (a + b + d + e) * 0.25f;
+                        else out = T(std::floor((double(a) + b + d + e) / 4.0 + 0.5));
+                    }
+                }
+            }
+            return dst;
+        }
+
+        template<typename T>
+        void testDownsample(CPUUnitTestContext& ctx, ResourceFormat format, uint32_t channels)
+        {
+            const uint32_t dims[][2] = { {1, 1}, {1, 7}, {9, 1}, {13, 6}, {64, 64}, {257, 130} };
+            for (const auto& d : dims)
+            {
+                uint32_t w = d[0], h = d[1];
+                auto src = createRandomImage<T>(w, h, channels, w * 31 + h);
+                auto reference = referenceDownsample<T>(src, w, h, channels);
+                uint32_t dstWidth = std::max(w / 2, 1u);
+                size_t texelSize = channels * sizeof(T);
+
+                for (bool parallel : { false, true })
+                {
+                    std::vector<uint8_t> dst(reference.size(), 0xcd);
+                    EXPECT(ltxDownsample(format, w, h, src.data(), w * texelSize, dst.data(), dstWidth * texelSize, parallel));
+                    EXPECT(dst == reference) << to_string(format) << " " << w << "x" << h << (parallel ? " parallel" : " serial");
+                }
+            }
+        }
+    }
+
+    CPU_TEST(LTXMipTailLayout)
+    {
+        size_t totalSize = 0;
+        auto layout = ltxGetMipTailLayout(256, 128, 9, 2, ResourceFormat::RGBA8Unorm, &totalSize);
+        EXPECT_EQ(layout.size(), 7);
+        size_t offset = 0;
+        for (size_t i = 0; i < layout.size(); i++)
+        {
+            const auto& level = layout[i];
+            EXPECT_EQ(level.mipLevel, i + 2);
+            EXPECT_EQ(level.width, std::max(256u >> level.mipLevel, 1u));
+            EXPECT_EQ(level.height, std::max(128u >> level.mipLevel, 1u));
+            EXPECT_EQ(level.rowPitch, level.width * 4);
+            EXPECT_EQ(level.size, level.rowPitch * level.height);
+            EXPECT_EQ(level.offset, offset);
+            EXPECT_EQ(level.offset % kLtxMipTailAlignment, 0);
+            offset += (level.size + kLtxMipTailAlignment - 1) / kLtxMipTailAlignment * kLtxMipTailAlignment;
+        }
+        EXPECT_EQ(totalSize, offset);
+
+        // Block compressed levels are stored in whole blocks, down to one block for 1x1
+        layout = ltxGetMipTailLayout(100, 60, 7, 3, ResourceFormat::BC1RGBUnorm, &totalSize);
+        EXPECT_EQ(layout.size(), 4);
+        EXPECT_EQ(layout[0].width, 12);
+        EXPECT_EQ(layout[0].height, 7);
+        EXPECT_EQ(layout[0].rowPitch, 3 * 8);
+        EXPECT_EQ(layout[0].size, 2 * 3 * 8);
+        EXPECT_EQ(layout[3].width, 1);
+        EXPECT_EQ(layout[3].size, 8);
+        EXPECT_EQ(totalSize, 48 + 16 + 16 + 16);
+
+        // No mip tail
+        EXPECT(ltxGetMipTailLayout(256, 256, 9, 9, ResourceFormat::R8Unorm, &totalSize).empty());
+        EXPECT_EQ(totalSize, 0);
+    }
+
+    CPU_TEST(LTXMipTailDownsample)
+    {
+        testDownsample<uint8_t>(ctx, ResourceFormat::R8Unorm, 1);
+        testDownsample<uint8_t>(ctx, ResourceFormat::RG8Unorm, 2);
+        testDownsample<uint8_t>(ctx, ResourceFormat::RGBA8Unorm, 4);
+        testDownsample<uint32_t>(ctx, ResourceFormat::RGBA32Uint, 4);
+        testDownsample<float>(ctx, ResourceFormat::R32Float, 1);
+        testDownsample<float>(ctx, ResourceFormat::RGBA32Float, 4);
+
+        uint8_t texels[16] = {};
+        EXPECT(!ltxDownsample(ResourceFormat::BC7Unorm, 4, 4, texels, 16, texels, 16));
+        EXPECT(!ltxDownsample(ResourceFormat::RGBA16Float, 2, 2, texels, 8, texels, 8));
+    }
+
+    CPU_TEST(LTXMipTailGenerate)
+    {
+        const uint32_t w = 300, h = 200;
+        const uint8_t mipLevels = 9, mipTailStart = 2;
+        auto level0 = createRandomImage<uint8_t>(w, h, 4, 7);
+
+        // Reference chain
+        std::vector<std::vector<uint8_t>> levels = { level0 };
+        for (uint32_t mip = 1; mip < mipLevels; mip++)
+        {
+            levels.push_back(referenceDownsample<uint8_t>(levels.back(), std::max(w >> (mip - 1), 1u), std::max(h >> (mip - 1), 1u), 4));
+        }
+
+        std::vector<uint8_t> data;
+        EXPECT(ltxGenerateMipTail(ResourceFormat::RGBA8Unorm, w, h, mipLevels, mipTailStart, level0.data(), data));
+        auto layout = ltxGetMipTailLayout(w, h, mipLevels, mipTailStart, ResourceFormat::RGBA8Unorm);
+        for (const auto& level : layout)
+        {
+            const auto& reference = levels[level.mipLevel];
+            EXPECT_EQ(level.size, reference.size());
+            EXPECT(std::equal(reference.begin(), reference.end(), data.begin() + level.offset)) << "level " << uint32_t(level.mipLevel);
+        }
+
+        // Block compressed tail levels are the reference levels through the encoder
+        EXPECT(ltxGenerateMipTail(ResourceFormat::BC7Unorm, w, h, mipLevels, mipTailStart, level0.data(), data));
+        layout = ltxGetMipTailLayout(w, h, mipLevels, mipTailStart, ResourceFormat::BC7Unorm);
+        for (const auto& level : layout)
+        {
+            std::vector<uint8_t> blocks(level.size);
+            bcCompress(ResourceFormat::BC7Unorm, level.width, level.height, levels[level.mipLevel].data(), level.width * 4, blocks.data(), level.rowPitch);
+            EXPECT(std::equal(blocks.begin(), blocks.end(), data.begin() + level.offset)) << "BC7 level " << uint32_t(level.mipLevel);
+        }
+
+        // A texture smaller than a page is all mip tail, level 0 included
+        EXPECT(ltxGenerateMipTail(ResourceFormat::RGBA8Unorm, 3, 2, 2, 0, level0.data(), data));
+        layout = ltxGetMipTailLayout(3, 2, 2, 0, ResourceFormat::RGBA8Unorm);
+        EXPECT_EQ(layout.size(), 2);
+        EXPECT(std::equal(level0.begin(), level0.begin() + 3 * 2 * 4, data.begin()));
+
+        EXPECT(ltxGenerateMipTail(ResourceFormat::RGBA8Unorm, w, h, mipLevels, mipLevels, level0.data(), data));
+        EXPECT(data.empty());
+        EXPECT(!ltxGenerateMipTail(ResourceFormat::RGBA16Float, w, h, mipLevels, mipTailStart, level0.data(), data));
+    }
+
+    CPU_TEST(LTXMipTailFromRows)
+    {
+        struct TestCase { ResourceFormat format; uint32_t channels; uint32_t w, h; uint8_t mipLevels, mipTailStart; };
+        const TestCase testCases[] =
+        {
+            { ResourceFormat::RGBA8Unorm, 4, 300, 200, 9, 2 },      // Odd level sizes on the way to the tail
+            { ResourceFormat::RGBA8Unorm, 4, 257, 1000, 10, 5 },
+            { ResourceFormat::RGBA8Unorm, 4, 600, 20, 10, 6 },      // Shorter than one band
+            { ResourceFormat::RGBA8Unorm, 4, 5, 3, 3, 0 },          // All mip tail
+            { ResourceFormat::BC7Unorm, 4, 300, 200, 9, 3 },
+        };
+
+        for (const auto& t : testCases)
+        {
+            auto level0 = createRandomImage<uint8_t>(t.w, t.h, t.channels, 11);
+            const size_t rowSize = size_t(t.w) * t.channels;
+
+            // Rows are handed out in bands, nothing outside the image is requested
+            uint32_t rowsRead = 0;
+            bool outOfBounds = false;
+            auto readRows = [&](uint32_t firstRow, uint32_t rowCount, void* pTexels)
+            {
+                outOfBounds |= firstRow + rowCount > t.h;
+                if (outOfBounds) return false;
+                std::memcpy(pTexels, level0.data() + firstRow * rowSize, rowCount * rowSize);
+                rowsRead += rowCount;
+                return true;
+            };
+
+            std::vector<uint8_t> reference, data;
+            EXPECT(ltxGenerateMipTail(t.format, t.w, t.h, t.mipLevels, t.mipTailStart, level0.data(), reference));
+            EXPECT(ltxGenerateMipTailFromRows(t.format, t.w, t.h, t.mipLevels, t.mipTailStart, readRows, data));
+            EXPECT(!outOfBounds) << t.w << "x" << t.h;
+            EXPECT_LE(rowsRead, t.h) << t.w << "x" << t.h;
+            EXPECT(data == reference) << t.w << "x" << t.h << " tail from " << uint32_t(t.mipTailStart);
+        }
+
+        // Read errors are passed on
+        std::vector<uint8_t> data;
+        EXPECT(!ltxGenerateMipTailFromRows(ResourceFormat::RGBA8Unorm, 64, 64, 7, 2, [](uint32_t, uint32_t, void*) { return false; }, data));
+    }
+
+    CPU_TEST(LTXMipTailBoxAverage)
+    {
+        // For power of two sizes every mip tail texel is the mean of its footprint in level 0
+        const uint32_t size = 64;
+        auto level0 = createRandomImage<float>(size, size, 1, 3);
+        const float* pLevel0 = reinterpret_cast<const float*>(level0.data());
+
+        std::vector<uint8_t> data;
+        EXPECT(ltxGenerateMipTail(ResourceFormat::R32Float, size, size, 7, 3, level0.data(), data));
+        for (const auto& level : ltxGetMipTailLayout(size, size, 7, 3, ResourceFormat::R32Float))
+        {
+            const float* pTexels = reinterpret_cast<const float*>(data.data() + level.offset);
+            uint32_t footprint = 1u << level.mipLevel;
+            float maxError = 0.f;
+            for (uint32_t y = 0; y < level.height; y++)
+            {
+                for (uint32_t x = 0; x < level.width; x++)
+                {
+                    double sum = 0.0;
+                    for (uint32_t v = 0; v < footprint; v++)
+                    {
+                        for (uint32_t u = 0; u < footprint; u++) sum += pLevel0[(y * footprint + v) * size + x * footprint + u];
+                    }
+                    maxError = std::max(maxError, float(std::abs(sum / (footprint * footprint) - pTexels[y * level.width + x])));
+                }
+            }
+            EXPECT_LE(maxError, 1e-3f) << "level " << uint32_t(level.mipLevel);
+        }
+    }
+
+    CPU_TEST(LTXMipTailBenchmark)
+    {
+        const uint32_t size = 4096;
+        const uint8_t mipLevels = 13, mipTailStart = 6;
+        auto level0 = createRandomImage<uint8_t>(size, size, 4, 1);
+
+        double ms[2] = {};
+        std::vector<uint8_t> data[2];
+        for (uint32_t parallel = 0; parallel < 2; parallel++)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            ltxGenerateMipTail(ResourceFormat::RGBA8Unorm, size, size, mipLevels, mipTailStart, level0.data(), data[parallel], parallel != 0);
+            ms[parallel] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+        EXPECT(data[0] == data[1]);
+
+        logInfo("LTX mip tail of " + std::to_string(size) + "x" + std::to_string(size) + " RGBA8: " + std::to_string(ms[0]) + " ms serial, " +
+            std::to_string(ms[1]) + " ms parallel, " + std::to_string(ms[0] / ms[1]) + "x");
+    }
+}
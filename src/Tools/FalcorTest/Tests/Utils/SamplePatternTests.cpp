@@ -0,0 +1,222 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/SampleGenerators/SobolSamplePattern.h"
+#include "Utils/SampleGenerators/PMJ02SamplePattern.h"
+
+#include <chrono>
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kSeedCount = 16;
+
+        /** Samples of a pattern shifted to [0, 1).
+        */
+        std::vector<float2> getSamples(CPUSampleGenerator& generator, uint32_t count, uint32_t startID = 0)
+        {
+            std::vector<float2> samples(count);
+            generator.reset(startID);
+            for (auto& s : samples) s = generator.next() + 0.5f;
+            return samples;
+        }
+
+        std::vector<float2> getRandomSamples(uint32_t count, uint32_t seed)
+        {
+            std::mt19937 rng(seed);
+            std::uniform_real_distribution<float> u;
+            std::vector<float2> samples(count);
+            for (auto& s : samples) s = float2(u(rng), u(rng));
+            return samples;
+        }
+
+        /** Check that every prefix of 2^m samples has one sample in each elementary interval of size 2^-m.
+        */
+        bool isStratified(const std::vector<float2>& samples)
+        {
+            for (uint32_t m = 0; (1u << m) <= samples.size(); m++)
+            {
+                const uint32_t count = 1u << m;
+                for (uint32_t k = 0; k <= m; k++)
+                {
+                    std::vector<uint32_t> cells(count, 0);
+                    for (uint32_t i = 0; i < count; i++)
+                    {
+                        if (samples[i].x < 0.f || samples[i].x >= 1.f || samples[i].y < 0.f || samples[i].y >= 1.f) return false;
+                        uint32_t x = (uint32_t)(samples[i].x * (1u << k));
+                        uint32_t y = (uint32_t)(samples[i].y * (1u << (m - k)));
+                        if (cells[y * (1u << k) + x]++ > 0) return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        /** L2 star discrepancy (Warnock's formula).
+        */
+        double l2StarDiscrepancy(const std::vector<float2>& samples)
+        {
+            const double n = (double)samples.size();
+            double sum1 = 0.0, sum2 = 0.0;
+            for (const auto& a : samples)
+            {
+                sum1 += (1.0 - a.x * a.x) * (1.0 - a.y * a.y);
+                for (const auto& b : samples) sum2 += (1.0 - std::max(a.x, b.x)) * (1.0 - std::max(a.y, b.y));
+            }
+            return std::sqrt(1.0 / 9.0 - sum1 / (2.0 * n) + sum2 / (n * n));
+        }
+
+        /** RMS error of estimating integrand f over the unit square, over kSeedCount independent sample sets.
+        */
+        template<typename Func, typename Integrand>
+        double rmsError(Func getSamplesForSeed, Integrand f, double reference)
+        {
+            double sumSq = 0.0;
+            for (uint32_t seed = 0; seed < kSeedCount; seed++)
+            {
+                auto samples = getSamplesForSeed(seed);
+                double estimate = 0.0;
+                for (const auto& s : samples) estimate += f(s.x, s.y);
+                estimate /= samples.size();
+                sumSq += (estimate - reference) * (estimate - reference);
+            }
+            return std::sqrt(sumSq / kSeedCount);
+        }
+    }
+
+    CPU_TEST(SobolSamplePatternStratification)
+    {
+        for (uint32_t seed = 0; seed < 4; seed++)
+        {
+            auto pGenerator = SobolSamplePattern::create(4096, seed);
+            EXPECT(isStratified(getSamples(*pGenerator, 4096)));
+        }
+    }
+
+    CPU_TEST(PMJ02SamplePatternStratification)
+    {
+        for (uint32_t seed = 0; seed < 4; seed++)
+        {
+            auto pGenerator = PMJ02SamplePattern::create(4096, seed);
+            EXPECT_EQ(pGenerator->getTableSize(), 4096u);
+            EXPECT(isStratified(getSamples(*pGenerator, 4096)));
+        }
+
+        // Non power-of-two counts round up.
+        EXPECT_EQ(PMJ02SamplePattern::create(100)->getTableSize(), 128u);
+    }
+
+    CPU_TEST(SamplePatternRandomAccess)
+    {
+        // Restarting at any sample continues the same sequence, also past the PMJ02 table.
+        auto pSobol = SobolSamplePattern::create(64, 3);
+        auto pPMJ02 = PMJ02SamplePattern::create(64, 3);
+        for (CPUSampleGenerator* pGenerator : { (CPUSampleGenerator*)pSobol.get(), (CPUSampleGenerator*)pPMJ02.get() })
+        {
+            auto all = getSamples(*pGenerator, 300);
+            auto tail = getSamples(*pGenerator, 100, 200);
+            for (uint32_t i = 0; i < 100; i++) EXPECT(all[200 + i] == tail[i]);
+            for (const auto& s : all) EXPECT(s.x >= 0.f && s.x < 1.f && s.y >= 0.f && s.y < 1.f);
+        }
+        EXPECT(pSobol->getSample(123) == pSobol->getSample(123));
+
+        // Rounds past the PMJ02 table are shifted copies.
+        EXPECT(pPMJ02->getSample(5) != pPMJ02->getSample(64 + 5));
+        EXPECT(pPMJ02->getSample(64 + 5) != pPMJ02->getSample(128 + 5));
+
+        // Aligned blocks far into the Sobol sequence are stratified as well.
+        EXPECT(isStratified(getSamples(*pSobol, 1024, 1u << 30)));
+    }
+
+    CPU_TEST(SamplePatternDiscrepancy)
+    {
+        const uint32_t kCount = 256;
+        double random = 0.0, sobol = 0.0, pmj02 = 0.0;
+        for (uint32_t seed = 0; seed < kSeedCount; seed++)
+        {
+            random += l2StarDiscrepancy(getRandomSamples(kCount, seed)) / kSeedCount;
+            sobol += l2StarDiscrepancy(getSamples(*SobolSamplePattern::create(kCount, seed), kCount)) / kSeedCount;
+            pmj02 += l2StarDiscrepancy(getSamples(*PMJ02SamplePattern::create(kCount, seed), kCount)) / kSeedCount;
+        }
+
+        EXPECT_LT(sobol, 0.5 * random);
+        EXPECT_LT(pmj02, 0.5 * random);
+        logInfo("SamplePatternDiscrepancy: L2 star discrepancy at " + std::to_string(kCount) + " samples, random " + std::to_string(random) +
+            ", Sobol " + std::to_string(sobol) + ", PMJ02 " + std::to_string(pmj02) + ".");
+    }
+
+    CPU_TEST(SamplePatternConvergence)
+    {
+        const uint32_t kCount = 1024;
+        const double kPi = 3.14159265358979323846;
+
+        // Quarter disk (discontinuous) and a Gaussian (smooth).
+        auto disk = [](double x, double y) { return x * x + y * y < 1.0 ? 1.0 : 0.0; };
+        auto gaussian = [](double x, double y) { return std::exp(-(x * x + y * y)); };
+        const double diskReference = kPi / 4.0;
+        const double gaussianReference = std::pow(std::sqrt(kPi) / 2.0 * std::erf(1.0), 2.0);
+
+        auto random = [&](uint32_t seed) { return getRandomSamples(kCount, seed); };
+        auto sobol = [&](uint32_t seed) { return getSamples(*SobolSamplePattern::create(kCount, seed), kCount); };
+        auto pmj02 = [&](uint32_t seed) { return getSamples(*PMJ02SamplePattern::create(kCount, seed), kCount); };
+
+        for (bool smooth : { false, true })
+        {
+            double randomError = smooth ? rmsError(random, gaussian, gaussianReference) : rmsError(random, disk, diskReference);
+            double sobolError = smooth ? rmsError(sobol, gaussian, gaussianReference) : rmsError(sobol, disk, diskReference);
+            double pmj02Error = smooth ? rmsError(pmj02, gaussian, gaussianReference) : rmsError(pmj02, disk, diskReference);
+
+            // Stratified sequences converge at O(N^-0.75) for discontinuities and faster for smooth integrands, vs O(N^-0.5).
+            const double maxRatio = smooth ? 0.05 : 0.5;
+            EXPECT_LT(sobolError, maxRatio * randomError);
+            EXPECT_LT(pmj02Error, maxRatio * randomError);
+            logInfo(std::string("SamplePatternConvergence: ") + (smooth ? "gaussian" : "disk") + " RMSE at " + std::to_string(kCount) +
+                " samples, random " + std::to_string(randomError) + ", Sobol " + std::to_string(sobolError) + ", PMJ02 " + std::to_string(pmj02Error) + ".");
+        }
+    }
+
+    CPU_TEST(SamplePatternBenchmark)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        auto pPMJ02 = PMJ02SamplePattern::create(PMJ02SamplePattern::kMaxTableSize);
+        double pmj02BuildMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        const uint32_t kCount = 1u << 20;
+        auto pSobol = SobolSamplePattern::create(kCount);
+        float2 sum(0.f);
+        start = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < kCount; i++) sum += pSobol->next();
+        double sobolMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        EXPECT_LT(std::abs(sum.x) / kCount, 1e-3f);
+        logInfo("SamplePatternBenchmark: PMJ02 table of " + std::to_string(pPMJ02->getTableSize()) + " samples built in " + std::to_string(pmj02BuildMs) +
+            " ms, Sobol " + std::to_string(kCount) + " samples in " + std::to_string(sobolMs) + " ms.");
+    }
+}
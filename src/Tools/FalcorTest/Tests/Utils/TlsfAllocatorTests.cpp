@@ -0,0 +1,265 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/TlsfAllocator.h"
+
+#include <chrono>
+#include <map>
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint64_t kMB = 1024 * 1024;
+
+        /** Backing store standing in for GPU buffers. Every block is plain CPU memory.
+        */
+        struct MockBackingStore
+        {
+            std::map<uint32_t, std::vector<uint8_t>> blocks;
+            uint32_t creates = 0;
+            uint32_t destroys = 0;
+
+            TlsfBlockPool createPool(const TlsfBlockPool::Desc& desc)
+            {
+                return TlsfBlockPool(desc,
+                    [this](uint32_t blockID, uint64_t size) { blocks[blockID].resize(size); creates++; },
+                    [this](uint32_t blockID) { blocks.erase(blockID); destroys++; });
+            }
+        };
+
+        /** Checks that live ranges never overlap.
+        */
+        struct RangeTracker
+        {
+            std::map<uint64_t, uint64_t> ranges;   // offset -> end
+
+            bool add(uint64_t offset, uint64_t size)
+            {
+                auto next = ranges.lower_bound(offset);
+                if (next != ranges.end() && next->first < offset + size) return false;
+                if (next != ranges.begin() && std::prev(next)->second > offset) return false;
+                ranges[offset] = offset + size;
+                return true;
+            }
+        };
+    }
+
+    CPU_TEST(TlsfAllocatorBasic)
+    {
+        TlsfAllocator allocator(kMB, 256);
+        EXPECT_EQ(allocator.getSize(), kMB);
+        EXPECT_EQ(allocator.getLargestFreeSize(), kMB);
+
+        uint64_t a = allocator.allocate(1000);
+        uint64_t b = allocator.allocate(256);
+        uint64_t c = allocator.allocate(4096, 4096);
+        EXPECT_NE(a, TlsfAllocator::kInvalidOffset);
+        EXPECT_NE(b, TlsfAllocator::kInvalidOffset);
+        EXPECT_EQ(c % 4096, 0u);
+        EXPECT_EQ(a % 256, 0u);
+        EXPECT_EQ(allocator.getAllocationCount(), 3u);
+        EXPECT_EQ(allocator.getUsedSize(), 1024u + 256u + 4096u);
+
+        // Freeing in any order merges everything back into one range.
+        allocator.free(b);
+        allocator.free(a);
+        allocator.free(c);
+        EXPECT(allocator.isEmpty());
+        EXPECT_EQ(allocator.getUsedSize(), 0u);
+        EXPECT_EQ(allocator.getLargestFreeSize(), kMB);
+    }
+
+    CPU_TEST(TlsfAllocatorExhaustion)
+    {
+        TlsfAllocator allocator(16 * 1024, 256);
+        std::vector<uint64_t> offsets;
+        for (uint32_t i = 0; i < 16; i++) offsets.push_back(allocator.allocate(1024));
+        for (auto offset : offsets) EXPECT_NE(offset, TlsfAllocator::kInvalidOffset);
+        EXPECT_EQ(allocator.allocate(1), TlsfAllocator::kInvalidOffset);
+
+        // Two adjacent free ranges make room for a larger allocation, two separate ones don't.
+        allocator.free(offsets[3]);
+        allocator.free(offsets[9]);
+        EXPECT_EQ(allocator.allocate(2048), TlsfAllocator::kInvalidOffset);
+        allocator.free(offsets[4]);
+        EXPECT_EQ(allocator.allocate(2048), offsets[3]);
+        EXPECT_EQ(allocator.allocate(1024), offsets[9]);
+    }
+
+    CPU_TEST(TlsfAllocatorRandom)
+    {
+        const uint64_t kSize = 64 * kMB;
+        TlsfAllocator allocator(kSize, 256);
+        std::mt19937 rng(7);
+        std::vector<std::pair<uint64_t, uint64_t>> live;
+        uint32_t failures = 0;
+
+        for (uint32_t i = 0; i < 20000; i++)
+        {
+            // Keep at most a few hundred ranges alive, about half the allocator on average.
+            if (live.empty() || (live.size() < 256 && rng() % 2 == 0))
+            {
+                uint64_t size = 1 + rng() % (256 * 1024);
+                uint64_t alignment = 1ull << (rng() % 14);
+                uint64_t offset = allocator.allocate(size, alignment);
+                if (offset == TlsfAllocator::kInvalidOffset) { failures++; continue; }
+                EXPECT_EQ(offset % alignment, 0u);
+                EXPECT_LE(offset + size, kSize);
+                live.emplace_back(offset, size);
+            }
+            else
+            {
+                size_t index = rng() % live.size();
+                allocator.free(live[index].first);
+                live[index] = live.back();
+                live.pop_back();
+            }
+        }
+
+        RangeTracker tracker;
+        for (const auto& [offset, size] : live) EXPECT(tracker.add(offset, size));
+        EXPECT_EQ(allocator.getAllocationCount(), (uint32_t)live.size());
+        EXPECT_EQ(failures, 0u);
+
+        for (const auto& [offset, size] : live) allocator.free(offset);
+        EXPECT_EQ(allocator.getLargestFreeSize(), kSize);
+    }
+
+    CPU_TEST(TlsfBlockPoolFenceReclamation)
+    {
+        MockBackingStore store;
+        auto pool = store.createPool({ 32 * kMB, 64 * kMB, 256 });
+
+        auto a = pool.allocate(8 * kMB);
+        auto b = pool.allocate(8 * kMB);
+        EXPECT_EQ(a.blockID, b.blockID);
+        EXPECT_EQ(store.creates, 1u);
+
+        // Writes through one allocation never land in another.
+        auto& memory = store.blocks[a.blockID];
+        std::fill(memory.begin() + a.offset, memory.begin() + a.offset + 8 * kMB, uint8_t(1));
+        std::fill(memory.begin() + b.offset, memory.begin() + b.offset + 8 * kMB, uint8_t(2));
+        EXPECT_EQ(memory[a.offset + 8 * kMB - 1], 1u);
+
+        pool.release(a, 5);
+        pool.executeDeferredReleases(4);
+        EXPECT_EQ(pool.getStats().allocationCount, 2u);
+        pool.executeDeferredReleases(5);
+        EXPECT_EQ(pool.getStats().allocationCount, 1u);
+
+        // The freed range is reused instead of growing the pool.
+        auto c = pool.allocate(16 * kMB);
+        EXPECT_EQ(c.blockID, a.blockID);
+        EXPECT_EQ(store.creates, 1u);
+    }
+
+    CPU_TEST(TlsfBlockPoolDedicatedBlocks)
+    {
+        MockBackingStore store;
+        auto pool = store.createPool({ 32 * kMB, 128 * kMB, 256 });
+
+        // Larger than a regular block: a dedicated block rounded up to a power of two.
+        auto big = pool.allocate(40 * kMB);
+        EXPECT_EQ(pool.getBlockSize(big.blockID), 64 * kMB);
+        pool.release(big, 1);
+        pool.executeDeferredReleases(1);
+        EXPECT_EQ(pool.getStats().idleBlockCount, 1u);
+
+        // A similar request reuses the pooled block.
+        auto again = pool.allocate(50 * kMB);
+        EXPECT_EQ(again.blockID, big.blockID);
+        EXPECT_EQ(store.creates, 1u);
+
+        // Small requests go to a regular block even while the large one has room.
+        auto small = pool.allocate(4 * kMB);
+        EXPECT_EQ(pool.getBlockSize(small.blockID), 32 * kMB);
+        EXPECT_EQ(store.creates, 2u);
+    }
+
+    CPU_TEST(TlsfBlockPoolTrimming)
+    {
+        MockBackingStore store;
+        auto pool = store.createPool({ 16 * kMB, 32 * kMB, 256 });
+
+        std::vector<TlsfBlockPool::Allocation> allocations;
+        for (uint32_t i = 0; i < 6; i++) allocations.push_back(pool.allocate(12 * kMB));
+        EXPECT_EQ(pool.getStats().blockCount, 6u);
+
+        uint64_t fence = 1;
+        for (const auto& allocation : allocations) pool.release(allocation, fence++);
+        pool.executeDeferredReleases(fence);
+
+        // Only the idle budget survives, the most recently used blocks are kept.
+        auto stats = pool.getStats();
+        EXPECT_EQ(stats.blockCount, 2u);
+        EXPECT_EQ(stats.blocksDestroyed, 4u);
+        EXPECT_EQ(store.blocks.size(), 2u);
+        EXPECT(store.blocks.count(allocations[4].blockID) && store.blocks.count(allocations[5].blockID));
+
+        // Destroyed block IDs are handed out again.
+        pool.allocate(12 * kMB);
+        pool.allocate(12 * kMB);
+        auto reused = pool.allocate(12 * kMB);
+        EXPECT_LT(reused.blockID, 6u);
+    }
+
+    CPU_TEST(TlsfBlockPoolBenchmark)
+    {
+        // Frames of streaming uploads larger than a 2 MB heap page, each released a frame later.
+        const uint32_t kFrames = 500;
+        TlsfBlockPool pool({ 32 * kMB, 128 * kMB, 256 }, [](uint32_t, uint64_t) {}, [](uint32_t) {});
+        std::mt19937 rng(3);
+        std::vector<TlsfBlockPool::Allocation> inFlight;
+        uint64_t allocationCount = 0;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t frame = 1; frame <= kFrames; frame++)
+        {
+            for (auto& allocation : inFlight) pool.release(allocation, frame);
+            inFlight.clear();
+            pool.executeDeferredReleases(frame - 1);
+
+            uint32_t count = 4 + rng() % 8;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                inFlight.push_back(pool.allocate(2 * kMB + rng() % (6 * kMB), 256));
+                allocationCount++;
+            }
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        // A heap with a resource per large allocation would have created one block per allocation.
+        auto stats = pool.getStats();
+        EXPECT_LT(stats.blocksCreated, 16u);
+        logInfo("TlsfBlockPoolBenchmark: " + std::to_string(allocationCount) + " large allocations over " + std::to_string(kFrames) +
+            " frames in " + std::to_string(ms) + " ms, " + std::to_string(stats.blocksCreated) + " blocks created, " +
+            std::to_string(stats.blocksDestroyed) + " destroyed.");
+    }
+}
@@ -0,0 +1,183 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Timing/TraceRecorder.h"
+#include "Utils/Timing/Profiler.h"
+#include <fstream>
+#include <limits>
+#include <thread>
+
+namespace Falcor
+{
+    CPU_TEST(TraceRecorder)
+    {
+        TraceRecorder::clear();
+        TraceRecorder::start();
+
+        const uint32_t kThreadCount = 4;
+        const uint32_t kEventCount = 1000;
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < kThreadCount; t++)
+        {
+            threads.emplace_back([]()
+            {
+                for (uint32_t i = 0; i < kEventCount; i++)
+                {
+                    TRACE_SCOPE("TraceRecorderTest.scope");
+                    TraceRecorder::beginEvent("TraceRecorderTest.pair");
+                    TraceRecorder::endEvent("TraceRecorderTest.pair");
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+
+        TraceRecorder::stop();
+        EXPECT_EQ(TraceRecorder::getDroppedEventCount(), 0);
+
+        auto events = TraceRecorder::getEvents();
+        EXPECT_EQ(events.size(), 3 * kThreadCount * kEventCount);
+
+        uint32_t completeCount = 0;
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            if (i > 0) EXPECT_LE(events[i - 1].timestamp, events[i].timestamp);
+            if (events[i].phase == TraceRecorder::Phase::Complete)
+            {
+                EXPECT(TraceRecorder::getEventName(events[i].nameId) == "TraceRecorderTest.scope");
+                completeCount++;
+            }
+        }
+        EXPECT_EQ(completeCount, kThreadCount * kEventCount);
+
+        // Check the binary header.
+        std::string filename = getTempFilename();
+        EXPECT(TraceRecorder::writeBinary(filename));
+        std::ifstream in(filename, std::ios::binary);
+        char magic[4] = {};
+        uint32_t version = 0;
+        in.read(magic, sizeof(magic));
+        in.read(reinterpret_cast<char*>(&version), sizeof(version));
+        EXPECT(std::string(magic, 4) == "FTRC");
+        EXPECT_EQ(version, 1);
+        in.close();
+        std::remove(filename.c_str());
+
+        EXPECT(TraceRecorder::writeChromeTrace(filename));
+        std::remove(filename.c_str());
+
+        TraceRecorder::clear();
+    }
+
+    GPU_TEST(TraceRecorderFrameOverhead, BENCHMARK_SKIP_MESSAGE)
+    {
+        // A frame of profiled passes, each copying a buffer on the GPU, like the passes of a render graph.
+        const uint32_t kPassCount = 8;
+        const uint32_t kFrameCount = 20;
+        const uint32_t kRoundCount = 10;
+        const size_t kBufferSize = 16 << 20;
+
+        auto pDevice = ctx.getRenderContext()->device();
+        auto pSrc = Buffer::create(pDevice, kBufferSize, ResourceBindFlags::None);
+        auto pDst = Buffer::create(pDevice, kBufferSize, ResourceBindFlags::None);
+        const std::string passNames[kPassCount] = { "pass0", "pass1", "pass2", "pass3", "pass4", "pass5", "pass6", "pass7" };
+
+        auto runFrames = [&]()
+        {
+            auto start = CpuTimer::getCurrentTimePoint();
+            for (uint32_t f = 0; f < kFrameCount; f++)
+            {
+                ProfilerEvent frameEvent(pDevice, "TraceRecorderTest.frame", Profiler::Flags::Internal);
+                for (uint32_t p = 0; p < kPassCount; p++)
+                {
+                    ProfilerEvent passEvent(pDevice, passNames[p], Profiler::Flags::Internal);
+                    ctx.getRenderContext()->copyResource(pDst.get(), pSrc.get());
+                }
+                ctx.getRenderContext()->flush(true);
+            }
+            return CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kFrameCount;
+        };
+
+        // Alternate between recording off and on and keep the fastest round of each, so load spikes don't count as overhead.
+        TraceRecorder::clear();
+        runFrames();
+        double disabledMs = std::numeric_limits<double>::max();
+        double enabledMs = std::numeric_limits<double>::max();
+        for (uint32_t r = 0; r < kRoundCount; r++)
+        {
+            disabledMs = std::min(disabledMs, runFrames());
+            TraceRecorder::start();
+            enabledMs = std::min(enabledMs, runFrames());
+            TraceRecorder::stop();
+        }
+        size_t eventCount = TraceRecorder::getEvents().size();
+        TraceRecorder::clear();
+        EXPECT_EQ(eventCount, kRoundCount * kFrameCount * (kPassCount + 1) * 2); // Begin and end per scope
+
+        double overheadPercent = 100.0 * (enabledMs - disabledMs) / disabledMs;
+        logInfo("TraceRecorder: " + std::to_string(disabledMs) + " ms/frame disabled, " + std::to_string(enabledMs) + " ms/frame enabled (" +
+            std::to_string(overheadPercent) + "% overhead)");
+        EXPECT_LT(overheadPercent, 1.0);
+    }
+
+    CPU_TEST(TraceRecorderReleaseBuffers)
+    {
+        TraceRecorder::clear();
+        TraceRecorder::start();
+
+        // Buffers of exited threads are freed once the collector drained them.
+        const uint32_t kThreadCount = 4;
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < kThreadCount; t++)
+        {
+            threads.emplace_back([]() { TraceRecorder::recordInstant("TraceRecorderTest.thread"); });
+        }
+        for (auto& t : threads) t.join();
+        TraceRecorder::recordInstant("TraceRecorderTest.main");
+        EXPECT_EQ(TraceRecorder::getEvents().size(), kThreadCount + 1);
+        EXPECT_EQ(TraceRecorder::getThreadBufferCount(), 1);
+
+        // Stopping frees the buffers of running threads as well, recording again allocates a new one.
+        TraceRecorder::stop();
+        EXPECT_EQ(TraceRecorder::getThreadBufferCount(), 0);
+        EXPECT_EQ(TraceRecorder::getEvents().size(), kThreadCount + 1);
+
+        TraceRecorder::start();
+        TraceRecorder::recordInstant("TraceRecorderTest.main");
+        EXPECT_EQ(TraceRecorder::getThreadBufferCount(), 1);
+        TraceRecorder::stop();
+
+        auto events = TraceRecorder::getEvents();
+        EXPECT_EQ(events.size(), kThreadCount + 2);
+        if (events.size() == kThreadCount + 2)
+        {
+            EXPECT_EQ(events[kThreadCount].threadId, events[kThreadCount + 1].threadId);
+        }
+        EXPECT_EQ(TraceRecorder::getThreadBufferCount(), 0);
+        TraceRecorder::clear();
+    }
+}
@@ -0,0 +1,98 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Video/VideoEncoder.h"
+
+#include <chrono>
+#include <filesystem>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kWidth = 1280;
+        const uint32_t kHeight = 720;
+        const uint32_t kFrameCount = 120;
+
+        /** Encodes synthetic BGRA frames and returns the time spent in appendFrame() and endCapture(), in ms.
+        */
+        double encodeFrames(CPUUnitTestContext& ctx, uint32_t queueDepth, double& appendMs)
+        {
+            VideoEncoder::Desc desc;
+            desc.width = kWidth;
+            desc.height = kHeight;
+            desc.fps = 30;
+            desc.codec = VideoEncoder::Codec::MPEG4;
+            desc.format = ResourceFormat::BGRA8UnormSrgb;
+            desc.queueDepth = queueDepth;
+            desc.filename = (std::filesystem::temp_directory_path() / ("VideoEncoderTest" + std::to_string(queueDepth) + ".mp4")).string();
+
+            auto pEncoder = VideoEncoder::create(desc);
+            EXPECT(pEncoder != nullptr);
+            if (!pEncoder) return 0.0;
+
+            // A moving gradient, so the codec has real work on every frame.
+            std::vector<uint8_t> frame(kWidth * kHeight * 4);
+            auto start = std::chrono::high_resolution_clock::now();
+            for (uint32_t f = 0; f < kFrameCount; f++)
+            {
+                for (uint32_t y = 0; y < kHeight; y++)
+                {
+                    uint8_t* pRow = frame.data() + y * kWidth * 4;
+                    for (uint32_t x = 0; x < kWidth; x++)
+                    {
+                        pRow[x * 4 + 0] = uint8_t(x + f * 3);
+                        pRow[x * 4 + 1] = uint8_t(y + f);
+                        pRow[x * 4 + 2] = uint8_t((x ^ y) + f);
+                        pRow[x * 4 + 3] = 255;
+                    }
+                }
+                pEncoder->appendFrame(frame.data());
+            }
+            appendMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            pEncoder->endCapture();
+            double totalMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+            EXPECT(std::filesystem::exists(desc.filename));
+            EXPECT_GT(std::filesystem::file_size(desc.filename), 0u);
+            std::filesystem::remove(desc.filename);
+            return totalMs;
+        }
+    }
+
+    CPU_TEST(VideoEncoderBenchmark)
+    {
+        double syncAppendMs = 0.0, asyncAppendMs = 0.0;
+        double syncMs = encodeFrames(ctx, 0, syncAppendMs);
+        double asyncMs = encodeFrames(ctx, 4, asyncAppendMs);
+
+        logInfo("VideoEncoderBenchmark: " + std::to_string(kFrameCount) + " frames " + std::to_string(kWidth) + "x" + std::to_string(kHeight) +
+            ", synchronous " + std::to_string(syncMs) + " ms, queued " + std::to_string(asyncMs) + " ms (" +
+            std::to_string(asyncAppendMs / kFrameCount) + " ms per appendFrame() vs " + std::to_string(syncAppendMs / kFrameCount) + " ms).");
+    }
+}
@@ -34,208 +34,17 @@
 #include <functional>
 #include <cstring>
 #include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 #include "args.h"
-#include "FreeImage.h"
+#include "ImageMetrics.h"
 
-template<typename T>
-T sqr(T x) { return x * x; }
+using namespace ImageCompare;
 
-template<typename T>
-T lerp(T a, T b, T t) { return a + t * (b - a); }
-
-template<typename T>
-T clamp(T x, T lo, T hi) { return std::max(lo, std::min(hi, x)); }
-
-class Image
-{
-public:
-    using SharedPtr = std::shared_ptr<Image>;
-
-    uint32_t getWidth() const { return mWidth; }
-    uint32_t getHeight() const { return mHeight; }
-    const float* getData() const { return mData.get(); }
-    float* getData() { return mData.get(); }
-
-    static SharedPtr create(uint32_t width, uint32_t height) { return SharedPtr(new Image(width, height)); }
-
-    static SharedPtr loadFromFile(const std::string& filename)
-    {
-        FREE_IMAGE_FORMAT fifFormat = FIF_UNKNOWN;
-
-        // Determine file format.
-        fifFormat = FreeImage_GetFileType(filename.c_str(), 0);
-        if (fifFormat == FIF_UNKNOWN) fifFormat = FreeImage_GetFIFFromFilename(filename.c_str());
-        if (fifFormat == FIF_UNKNOWN) throw std::runtime_error("Unknown image format");
-        if (!FreeImage_FIFSupportsReading(fifFormat)) throw std::runtime_error("Unsupported image format");
-
-        // Read image.
-        FIBITMAP* srcBitmap = FreeImage_Load(fifFormat, filename.c_str());
-        if (!srcBitmap) throw std::runtime_error("Cannot read image");
-
-        // Convert to RGBA32F.
-        FIBITMAP* floatBitmap = FreeImage_ConvertToRGBAF(srcBitmap);
-        FreeImage_Unload(srcBitmap);
-        if (!floatBitmap) throw std::runtime_error("Cannot convert to RGBA float format");
-
-        // Create image.
-        auto image = create(FreeImage_GetWidth(floatBitmap), FreeImage_GetHeight(floatBitmap));
-        int bytesPerPixel = 4 * sizeof(float);
-        FreeImage_ConvertToRawBits(reinterpret_cast<BYTE*>(image->getData()), floatBitmap, bytesPerPixel * image->getWidth(), bytesPerPixel * 8, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, true);
-        FreeImage_Unload(floatBitmap);
-
-        return image;
-    }
-
-    void saveToFile(const std::string& filename, bool writeAlpha = true) const
-    {
-        FREE_IMAGE_FORMAT fifFormat = FIF_UNKNOWN;
-
-        // Determine file format.
-        fifFormat = FreeImage_GetFIFFromFilename(filename.c_str());
-        if (fifFormat == FIF_UNKNOWN) throw std::runtime_error("Unknown image format");
-        if (!FreeImage_FIFSupportsWriting(fifFormat)) throw std::runtime_error("Unsupported image format");
-
-        bool writeFloat = fifFormat == FIF_EXR || fifFormat == FIF_PFM || fifFormat == FIF_HDR;
-        if (fifFormat != FIF_EXR || fifFormat != FIF_PNG) writeAlpha = false;
-
-        // Create bitmap.
-        FIBITMAP* bitmap;
-        const float* src = getData();
-        if (writeFloat)
-        {
-            bitmap = FreeImage_AllocateT(writeAlpha ? FIT_RGBAF : FIT_RGBF, mWidth, mHeight);
-            for (uint32_t y = 0; y < mHeight; y++)
-            {
-                float* dst = reinterpret_cast<float*>(FreeImage_GetScanLine(bitmap, mHeight - y - 1));
-                if (writeAlpha)
-                {
-                    std::memcpy(dst, src, mWidth * 4 * sizeof(float));
-                    src += mWidth * 4;
-                }
-                else
-                {
-                    for (uint32_t x = 0; x < mWidth; ++x)
-                    {
-                        dst[0] = src[0];
-                        dst[1] = src[1];
-                        dst[2] = src[2];
-                        dst += 3;
-                        src += 4;
-                    }
-                }
-            }
-        }
-        else
-        {
-            bitmap = FreeImage_Allocate(mWidth, mHeight, writeAlpha ? 32 : 24);
-            for (uint32_t y = 0; y < mHeight; y++)
-            {
-                uint8_t* dst = reinterpret_cast<uint8_t*>(FreeImage_GetScanLine(bitmap, mHeight - y - 1));
-                for (uint32_t x = 0; x < mWidth; ++x)
-                {
-                    dst[2] = clamp(int(src[0] * 255.f), 0, 255);
-                    dst[1] = clamp(int(src[1] * 255.f), 0, 255);
-                    dst[0] = clamp(int(src[2] * 255.f), 0, 255);
-                    if (writeAlpha) dst[3] = clamp(int(src[3] * 255.f), 0, 255);
-                    dst += writeAlpha ? 4 : 3;
-                    src += 4;
-                }
-            }
-        }
-
-        // Write image.
-        FreeImage_Save(fifFormat, bitmap, filename.c_str());
-        FreeImage_Unload(bitmap);
-    }
-
-private:
-    uint32_t mWidth;
-    uint32_t mHeight;
-    std::unique_ptr<float[]> mData;
-
-    Image(uint32_t width, uint32_t height)
-        : mWidth(width)
-        , mHeight(height)
-        , mData(std::make_unique<float[]>(width * height * 4))
-    {}
-};
-
-struct MSE
-{
-    double operator()(const float* a, const float* b, size_t count) const
-    {
-        double error = 0.0;
-        for (size_t i = 0; i < count; ++i) { error += sqr(a[i] - b[i]); }
-        return error / count;
-    }
-};
-
-struct RMSE
-{
-    double operator()(const float* a, const float* b, size_t count) const
-    {
-        double error = 0.0;
-        for (size_t i = 0; i < count; ++i) { error += sqr(a[i] - b[i]) / (sqr(a[i]) + 1e-3); }
-        return error / count;
-    }
-};
-
-struct MAE
-{
-    double operator()(const float* a, const float* b, size_t count) const
-    {
-        double error = 0.0;
-        for (size_t i = 0; i < count; ++i) { error += std::fabs(sqr(a[i] - b[i])); }
-        return error / count;
-    }
-};
-
-struct MAPE
-{
-    double operator()(const float* a, const float* b, size_t count) const
-    {
-        double error = 0.0;
-        for (size_t i = 0; i < count; ++i) { error += std::fabs((a[i] - b[i]) / (a[i] + 1e-3)); }
-        return 100.0 * error / count;
-    }
-};
-
-template<typename Metric>
-double compare(const Image& imageA, const Image& imageB, bool alpha, float* errorMap)
-{
-    Metric metric;
-    double sum = 0.0;
-    const float* a = imageA.getData();
-    const float* b = imageB.getData();
-    size_t count = imageA.getWidth() * imageA.getHeight();
-    for (size_t i = 0; i < count; ++i)
-    {
-        double error = metric(a, b, alpha ? 4 : 3);
-        if (errorMap) *errorMap++ = float(error);
-        sum += error;
-        a += 4;
-        b += 4;
-    }
-    return sum / count;
-}
-
-struct ErrorMetric
-{
-    std::string name;
-    std::string desc;
-    std::function<double(const Image& imageA, const Image& imageB, bool alpha, float* errorMap)> compare;
-};
-
-static const std::vector<ErrorMetric> errorMetrics =
-{
-    { "mse", "Mean Squared Error", compare<MSE> },
-    { "rmse", "Relative Mean Squared Error", compare<RMSE> },
-    { "mae", "Mean Absolute Error", compare<MAE> },
-    { "mape", "Mean Absolute Percentage Error", compare<MAPE> },
-};
-
-static Image::SharedPtr generateHeatMap(uint32_t width, uint32_t height, const float* errorMap)
+static Image::SharedPtr generateHeatMap(uint32_t width, uint32_t height, const float* errorMap, uint32_t threadCount)
 {
     auto writeColor = [] (float t, float* dst)
     {
@@ -252,21 +61,24 @@ static Image::SharedPtr generateHeatMap(uint32_t width, uint32_t height, const f
         *dst++ = 1.f;
     };
 
-    const auto [minValue, maxValue] = std::minmax_element(errorMap, errorMap + width * height);
+    const size_t pixelCount = size_t(width) * height;
+    const auto [minValue, maxValue] = std::minmax_element(errorMap, errorMap + pixelCount);
     const float range = std::max(1e-5f, *maxValue - *minValue);
     auto image = Image::create(width, height);
-    float* dst = image->getData();
-    for (size_t i = 0; i < width * height; ++i)
+    float* data = image->getData();
+    parallelFor(height, getThreadCount(threadCount), [&] (uint32_t y)
     {
-        float t = clamp((errorMap[i] - *minValue) / range, 0.f, 1.f);
-        writeColor(t, dst);
-        dst += 4;
-    }
+        for (size_t i = size_t(y) * width; i < size_t(y + 1) * width; ++i)
+        {
+            float t = clamp((errorMap[i] - *minValue) / range, 0.f, 1.f);
+            writeColor(t, data + i * 4);
+        }
+    });
 
     return image;
 }
 
-static bool compareImages(const std::string& filenameA, const std::string& filenameB, ErrorMetric metric, float threshold, bool alpha, const std::string& heatMapFilename)
+static bool compareImages(const std::string& filenameA, const std::string& filenameB, ErrorMetric metric, CompareOptions options, const std::string& heatMapFilename, uint32_t benchmarkIterations)
 {
     auto loadImage = [] (const std::string& filename)
     {
@@ -309,23 +121,39 @@ static bool compareImages(const std::string& filenameA, const std::string& filen
     uint32_t width = imageA->getWidth();
     uint32_t height = imageB->getHeight();
 
+    // The heat map needs the error of every pixel.
+    std::unique_ptr<float[]> errorMap = heatMapFilename.empty() ? nullptr : std::make_unique<float[]>(size_t(width) * height);
+    if (errorMap) options.earlyOut = false;
+
     // Compare images.
-    std::unique_ptr<float[]> errorMap = heatMapFilename.empty() ? nullptr : std::make_unique<float[]>(width * height);
-    double error = metric.compare(*imageA, *imageB, alpha, errorMap.get());
+    CompareResult result = metric.compare(*imageA, *imageB, options, errorMap.get());
+
+    if (benchmarkIterations > 0)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < benchmarkIterations; ++i) metric.compare(*imageA, *imageB, options, errorMap.get());
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        double megaPixels = double(width) * height * benchmarkIterations * 1e-6;
+        std::cerr << metric.name << ": " << width << "x" << height << ", " << getThreadCount(options.threadCount) << " threads, "
+                  << (seconds * 1e3 / benchmarkIterations) << " ms/compare, " << (megaPixels / seconds) << " MP/s"
+                  << (result.aborted ? " (early out)" : "") << std::endl;
+    }
 
     // Generate heat map.
     if (errorMap)
     {
-        auto heatMap = generateHeatMap(width, height, errorMap.get());
+        auto heatMap = generateHeatMap(width, height, errorMap.get(), options.threadCount);
         saveImage(*heatMap, heatMapFilename);
     }
 
-    std::cout << error << std::endl;
+    std::cout << result.error << std::endl;
 
     // Treat nans and infs as errors.
-    if (std::isnan(error) || std::isinf(error)) return false;
+    if (std::isnan(result.error) || std::isinf(result.error)) return false;
 
-    return error <= threshold;
+    return !result.aborted && result.error <= options.threshold;
 }
 
 static void printMetrics(std::ostream &stream = std::cout)
@@ -347,6 +175,9 @@ int main(int argc, char** argv)
     args::ValueFlag<float> thresholdFlag(parser, "threshold", "The error threshold.", {'t'});
     args::Flag alphaFlag(parser, "", "Include alpha channel.", {'a'});
     args::ValueFlag<std::string> heatMapFlag(parser, "filename", "Generate error heat map.", {'e'});
+    args::Flag earlyOutFlag(parser, "", "Stop as soon as the error exceeds the threshold (the reported error is then a lower bound).", {'x'});
+    args::ValueFlag<uint32_t> threadsFlag(parser, "count", "Number of worker threads (default: all hardware threads).", {'j'});
+    args::ValueFlag<uint32_t> benchmarkFlag(parser, "iterations", "Repeat the comparison and report the throughput in megapixels per second.", {'b'});
     args::Positional<std::string> image1(parser, "image1", "The first image.", args::Options::Required);
     args::Positional<std::string> image2(parser, "image2", "The second image.", args::Options::Required);
     args::CompletionFlag completionFlag(parser, {"complete"});
@@ -398,12 +229,18 @@ int main(int argc, char** argv)
         metric = *it;
     }
 
+    CompareOptions options;
+    options.alpha = alphaFlag ? args::get(alphaFlag) : false;
+    options.threshold = thresholdFlag ? args::get(thresholdFlag) : 0.f;
+    options.earlyOut = earlyOutFlag ? args::get(earlyOutFlag) : false;
+    options.threadCount = threadsFlag ? args::get(threadsFlag) : 0;
+
     return compareImages(
         args::get(image1),
         args::get(image2),
         metric,
-        thresholdFlag ? args::get(thresholdFlag) : 0.f,
-        alphaFlag ? args::get(alphaFlag) : false,
-        heatMapFlag ? args::get(heatMapFlag) : ""
+        options,
+        heatMapFlag ? args::get(heatMapFlag) : "",
+        benchmarkFlag ? args::get(benchmarkFlag) : 0
     ) ? 0 : 1;
 }
@@ -0,0 +1,684 @@
+/***************************************************************************
+ # Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FreeImage.h"
+
+/** Images and error metrics of the ImageCompare tool. Header only, so that FalcorTest can test the metrics.
+*/
+namespace ImageCompare
+{
+
+template<typename T>
+T sqr(T x) { return x * x; }
+
+template<typename T>
+T lerp(T a, T b, T t) { return a + t * (b - a); }
+
+template<typename T>
+T clamp(T x, T lo, T hi) { return std::max(lo, std::min(hi, x)); }
+
+class Image
+{
+public:
+    using SharedPtr = std::shared_ptr<Image>;
+
+    uint32_t getWidth() const { return mWidth; }
+    uint32_t getHeight() const { return mHeight; }
+    bool isLinear() const { return mLinear; }
+    const float* getData() const { return mData.get(); }
+    float* getData() { return mData.get(); }
+
+    static SharedPtr create(uint32_t width, uint32_t height) { return SharedPtr(new Image(width, height)); }
+
+    static SharedPtr loadFromFile(const std::string& filename)
+    {
+        FREE_IMAGE_FORMAT fifFormat = FIF_UNKNOWN;
+
+        // Determine file format.
+        fifFormat = FreeImage_GetFileType(filename.c_str(), 0);
+        if (fifFormat == FIF_UNKNOWN) fifFormat = FreeImage_GetFIFFromFilename(filename.c_str());
+        if (fifFormat == FIF_UNKNOWN) throw std::runtime_error("Unknown image format");
+        if (!FreeImage_FIFSupportsReading(fifFormat)) throw std::runtime_error("Unsupported image format");
+
+        // Read image.
+        FIBITMAP* srcBitmap = FreeImage_Load(fifFormat, filename.c_str());
+        if (!srcBitmap) throw std::runtime_error("Cannot read image");
+
+        // Integer formats store display-encoded (sRGB) values, float formats store linear values.
+        FREE_IMAGE_TYPE srcType = FreeImage_GetImageType(srcBitmap);
+        bool linear = srcType != FIT_BITMAP && srcType != FIT_UINT16 && srcType != FIT_RGB16 && srcType != FIT_RGBA16;
+
+        // Convert to RGBA32F.
+        FIBITMAP* floatBitmap = FreeImage_ConvertToRGBAF(srcBitmap);
+        FreeImage_Unload(srcBitmap);
+        if (!floatBitmap) throw std::runtime_error("Cannot convert to RGBA float format");
+
+        // Create image.
+        auto image = create(FreeImage_GetWidth(floatBitmap), FreeImage_GetHeight(floatBitmap));
+        int bytesPerPixel = 4 * sizeof(float);
+        FreeImage_ConvertToRawBits(reinterpret_cast<BYTE*>(image->getData()), floatBitmap, bytesPerPixel * image->getWidth(), bytesPerPixel * 8, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, true);
+        FreeImage_Unload(floatBitmap);
+        image->mLinear = linear;
+
+        return image;
+    }
+
+    void saveToFile(const std::string& filename, bool writeAlpha = true) const
+    {
+        FREE_IMAGE_FORMAT fifFormat = FIF_UNKNOWN;
+
+        // Determine file format.
+        fifFormat = FreeImage_GetFIFFromFilename(filename.c_str());
+        if (fifFormat == FIF_UNKNOWN) throw std::runtime_error("Unknown image format");
+        if (!FreeImage_FIFSupportsWriting(fifFormat)) throw std::runtime_error("Unsupported image format");
+
+        bool writeFloat = fifFormat == FIF_EXR || fifFormat == FIF_PFM || fifFormat == FIF_HDR;
+        if (fifFormat != FIF_EXR || fifFormat != FIF_PNG) writeAlpha = false;
+
+        // Create bitmap.
+        FIBITMAP* bitmap;
+        const float* src = getData();
+        if (writeFloat)
+        {
+            bitmap = FreeImage_AllocateT(writeAlpha ? FIT_RGBAF : FIT_RGBF, mWidth, mHeight);
+            for (uint32_t y = 0; y < mHeight; y++)
+            {
+                float* dst = reinterpret_cast<float*>(FreeImage_GetScanLine(bitmap, mHeight - y - 1));
+                if (writeAlpha)
+                {
+                    std::memcpy(dst, src, mWidth * 4 * sizeof(float));
+                    src += mWidth * 4;
+                }
+                else
+                {
+                    for (uint32_t x = 0; x < mWidth; ++x)
+                    {
+                        dst[0] = src[0];
+                        dst[1] = src[1];
+                        dst[2] = src[2];
+                        dst += 3;
+                        src += 4;
+                    }
+                }
+            }
+        }
+        else
+        {
+            bitmap = FreeImage_Allocate(mWidth, mHeight, writeAlpha ? 32 : 24);
+            for (uint32_t y = 0; y < mHeight; y++)
+            {
+                uint8_t* dst = reinterpret_cast<uint8_t*>(FreeImage_GetScanLine(bitmap, mHeight - y - 1));
+                for (uint32_t x = 0; x < mWidth; ++x)
+                {
+                    dst[2] = clamp(int(src[0] * 255.f), 0, 255);
+                    dst[1] = clamp(int(src[1] * 255.f), 0, 255);
+                    dst[0] = clamp(int(src[2] * 255.f), 0, 255);
+                    if (writeAlpha) dst[3] = clamp(int(src[3] * 255.f), 0, 255);
+                    dst += writeAlpha ? 4 : 3;
+                    src += 4;
+                }
+            }
+        }
+
+        // Write image.
+        FreeImage_Save(fifFormat, bitmap, filename.c_str());
+        FreeImage_Unload(bitmap);
+    }
+
+private:
+    uint32_t mWidth;
+    uint32_t mHeight;
+    bool mLinear = true;
+    std::unique_ptr<float[]> mData;
+
+    Image(uint32_t width, uint32_t height)
+        : mWidth(width)
+        , mHeight(height)
+        , mData(std::make_unique<float[]>(size_t(width) * height * 4))
+    {}
+};
+
+struct CompareOptions
+{
+    bool alpha = false;             ///< Include the alpha channel.
+    float threshold = 0.f;          ///< Error threshold.
+    bool earlyOut = false;          ///< Stop as soon as the error is known to exceed the threshold.
+    uint32_t threadCount = 0;       ///< Number of worker threads (0 = use all hardware threads).
+};
+
+struct CompareResult
+{
+    double error = 0.0;
+    bool aborted = false;           ///< True if the comparison stopped early. The error is then a lower bound.
+};
+
+inline uint32_t getThreadCount(uint32_t requested)
+{
+    return requested > 0 ? requested : std::max(1u, std::thread::hardware_concurrency());
+}
+
+/** Calls func(i) for i in [0, count) on threadCount threads. Work items are handed out dynamically.
+*/
+template<typename Func>
+void parallelFor(uint32_t count, uint32_t threadCount, const Func& func)
+{
+    threadCount = std::min(threadCount, count);
+    if (threadCount <= 1)
+    {
+        for (uint32_t i = 0; i < count; ++i) func(i);
+        return;
+    }
+
+    std::atomic<uint32_t> next{ 0 };
+    auto worker = [&] ()
+    {
+        for (uint32_t i = next++; i < count; i = next++) func(i);
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < threadCount; ++i) threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads) thread.join();
+}
+
+const uint32_t kTileSize = 64;
+
+struct Tile
+{
+    uint32_t x, y;
+    uint32_t width, height;
+};
+
+struct TileReduction
+{
+    double sum = 0.0;
+    bool aborted = false;
+};
+
+/** Splits the image into tiles, evaluates tileFunc(tile) -> double on all tiles in parallel and sums the results.
+    After each tile shouldAbort(partialSum) is evaluated; once it returns true the remaining tiles are skipped.
+    Tile sums are added in tile order, so the result does not depend on the number of threads.
+*/
+template<typename TileFunc, typename AbortFunc>
+TileReduction reduceTiles(uint32_t width, uint32_t height, uint32_t threadCount, const TileFunc& tileFunc, const AbortFunc& shouldAbort)
+{
+    const uint32_t tilesX = (width + kTileSize - 1) / kTileSize;
+    const uint32_t tilesY = (height + kTileSize - 1) / kTileSize;
+
+    std::vector<double> tileSums(size_t(tilesX) * tilesY, 0.0);
+    std::atomic<double> partialSum{ 0.0 };
+    std::atomic<bool> aborted{ false };
+
+    parallelFor(tilesX * tilesY, getThreadCount(threadCount), [&] (uint32_t index)
+    {
+        if (aborted.load(std::memory_order_relaxed)) return;
+
+        Tile tile;
+        tile.x = (index % tilesX) * kTileSize;
+        tile.y = (index / tilesX) * kTileSize;
+        tile.width = std::min(kTileSize, width - tile.x);
+        tile.height = std::min(kTileSize, height - tile.y);
+
+        double sum = tileFunc(tile);
+        tileSums[index] = sum;
+
+        double current = partialSum.load();
+        while (!partialSum.compare_exchange_weak(current, current + sum)) {}
+        if (shouldAbort(current + sum)) aborted = true;
+    });
+
+    TileReduction result;
+    for (double sum : tileSums) result.sum += sum;
+    result.aborted = aborted;
+    return result;
+}
+
+// Per-channel error metrics. The per-pixel error is the mean over the compared channels,
+// the image error is finalize() applied to the mean over all pixels.
+
+struct MSE
+{
+    float operator()(float a, float b) const { return sqr(a - b); }
+    static double finalize(double mean) { return mean; }
+};
+
+// Relative MSE, named "rmse" on the command line since before root MSE was available.
+struct RMSE
+{
+    float operator()(float a, float b) const { return sqr(a - b) / (sqr(a) + 1e-3f); }
+    static double finalize(double mean) { return mean; }
+};
+
+struct RootMSE
+{
+    float operator()(float a, float b) const { return sqr(a - b); }
+    static double finalize(double mean) { return std::sqrt(mean); }
+};
+
+// Named "mae" on the command line but has always measured the squared difference. Kept so existing thresholds keep working.
+struct MAE
+{
+    float operator()(float a, float b) const { return sqr(a - b); }
+    static double finalize(double mean) { return mean; }
+};
+
+struct AbsMAE
+{
+    float operator()(float a, float b) const { return std::fabs(a - b); }
+    static double finalize(double mean) { return mean; }
+};
+
+struct MAPE
+{
+    float operator()(float a, float b) const { return 100.f * std::fabs((a - b) / (a + 1e-3f)); }
+    static double finalize(double mean) { return mean; }
+};
+
+template<typename Metric>
+CompareResult compare(const Image& imageA, const Image& imageB, const CompareOptions& options, float* errorMap)
+{
+    const uint32_t width = imageA.getWidth();
+    const uint32_t height = imageA.getHeight();
+    const double pixelCount = double(width) * height;
+    const bool alpha = options.alpha;
+    const float invChannelCount = alpha ? 0.25f : 1.f / 3.f;
+
+    auto compareTile = [&] (const Tile& tile)
+    {
+        Metric metric;
+        float channelError[kTileSize * 4];
+        double sum = 0.0;
+
+        for (uint32_t y = tile.y; y < tile.y + tile.height; ++y)
+        {
+            const size_t offset = size_t(y) * width + tile.x;
+            const float* a = imageA.getData() + offset * 4;
+            const float* b = imageB.getData() + offset * 4;
+            const uint32_t count = tile.width * 4;
+
+            // Evaluate all channels in one flat loop so that it vectorizes. Alpha is masked out below.
+            for (uint32_t i = 0; i < count; ++i) channelError[i] = metric(a[i], b[i]);
+
+            float rowSum = 0.f;
+            for (uint32_t x = 0; x < tile.width; ++x)
+            {
+                const float* e = channelError + x * 4;
+                float error = (e[0] + e[1] + e[2] + (alpha ? e[3] : 0.f)) * invChannelCount;
+                if (errorMap) errorMap[offset + x] = error;
+                rowSum += error;
+            }
+            sum += rowSum;
+        }
+
+        return sum;
+    };
+
+    auto shouldAbort = [&] (double partialSum)
+    {
+        return options.earlyOut && Metric::finalize(partialSum / pixelCount) > options.threshold;
+    };
+
+    auto reduction = reduceTiles(width, height, options.threadCount, compareTile, shouldAbort);
+    return { Metric::finalize(reduction.sum / pixelCount), reduction.aborted };
+}
+
+/** Perceptual error in the spirit of FLIP (Andersson et al. 2020, "FLIP: A Difference Evaluator for Alternating Images").
+    Both images are filtered with per-channel Gaussian approximations of the contrast sensitivity functions in YCxCz space,
+    compared with the Hunt-adjusted HyAB color distance and the result is amplified where edges or points differ.
+    Values are in [0,1]. Inputs are clamped to [0,1], i.e. HDR images are compared as if they were tonemapped by clamping.
+*/
+namespace FLIP
+{
+    const float kPixelsPerDegree = 67.f;    // 0.7 m wide 4K monitor viewed from 0.7 m.
+    const float kQc = 0.7f;
+    const float kPc = 0.4f;
+    const float kPt = 0.95f;
+    const float kQf = 0.5f;
+    const float kFeatureWidth = 0.082f;     // Feature detector width in degrees.
+
+    // D65 reference white.
+    const float kWhiteX = 0.950428545f;
+    const float kWhiteY = 1.f;
+    const float kWhiteZ = 1.088900371f;
+
+    const float kPi = 3.14159265358979f;
+
+    inline float sRGBToLinear(float c)
+    {
+        return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    inline void linearRGBToXYZ(const float rgb[3], float xyz[3])
+    {
+        xyz[0] = 0.4124564f * rgb[0] + 0.3575761f * rgb[1] + 0.1804375f * rgb[2];
+        xyz[1] = 0.2126729f * rgb[0] + 0.7151522f * rgb[1] + 0.0721750f * rgb[2];
+        xyz[2] = 0.0193339f * rgb[0] + 0.1191920f * rgb[1] + 0.9503041f * rgb[2];
+    }
+
+    inline void XYZToLinearRGB(const float xyz[3], float rgb[3])
+    {
+        rgb[0] = 3.2404542f * xyz[0] - 1.5371385f * xyz[1] - 0.4985314f * xyz[2];
+        rgb[1] = -0.9692660f * xyz[0] + 1.8760108f * xyz[1] + 0.0415560f * xyz[2];
+        rgb[2] = 0.0556434f * xyz[0] - 0.2040259f * xyz[1] + 1.0572252f * xyz[2];
+    }
+
+    inline void XYZToYCxCz(const float xyz[3], float ycxcz[3])
+    {
+        float x = xyz[0] / kWhiteX, y = xyz[1] / kWhiteY, z = xyz[2] / kWhiteZ;
+        ycxcz[0] = 116.f * y - 16.f;
+        ycxcz[1] = 500.f * (x - y);
+        ycxcz[2] = 200.f * (y - z);
+    }
+
+    inline void YCxCzToXYZ(const float ycxcz[3], float xyz[3])
+    {
+        float y = (ycxcz[0] + 16.f) / 116.f;
+        xyz[0] = kWhiteX * (ycxcz[1] / 500.f + y);
+        xyz[1] = kWhiteY * y;
+        xyz[2] = kWhiteZ * (y - ycxcz[2] / 200.f);
+    }
+
+    /** Converts XYZ to CIELab with the Hunt adjustment applied to the chromatic channels.
+    */
+    inline void XYZToHuntLab(const float xyz[3], float lab[3])
+    {
+        auto f = [] (float t)
+        {
+            const float delta = 6.f / 29.f;
+            return t > delta * delta * delta ? std::cbrt(t) : t / (3.f * delta * delta) + 4.f / 29.f;
+        };
+        float fx = f(xyz[0] / kWhiteX), fy = f(xyz[1] / kWhiteY), fz = f(xyz[2] / kWhiteZ);
+        lab[0] = 116.f * fy - 16.f;
+        lab[1] = 0.01f * lab[0] * 500.f * (fx - fy);
+        lab[2] = 0.01f * lab[0] * 200.f * (fy - fz);
+    }
+
+    inline float HyAB(const float a[3], const float b[3])
+    {
+        return std::fabs(a[0] - b[0]) + std::sqrt(sqr(a[1] - b[1]) + sqr(a[2] - b[2]));
+    }
+
+    /** Maximum color error, given by the distance between pure green and pure blue.
+    */
+    inline float maxColorError()
+    {
+        const float green[3] = { 0.f, 1.f, 0.f };
+        const float blue[3] = { 0.f, 0.f, 1.f };
+        float xyz[3], labGreen[3], labBlue[3];
+        linearRGBToXYZ(green, xyz);
+        XYZToHuntLab(xyz, labGreen);
+        linearRGBToXYZ(blue, xyz);
+        XYZToHuntLab(xyz, labBlue);
+        return std::pow(HyAB(labGreen, labBlue), kQc);
+    }
+
+    /** Kernel of radius ceil(3 sigma) sampling the Gaussian (order 0) or its first/second derivative.
+        Order 0 is normalized to unit sum. Derivative kernels are normalized such that the positive weights sum to one.
+    */
+    inline std::vector<float> createKernel(float sigma, int order)
+    {
+        const int radius = std::max(1, int(std::ceil(3.f * sigma)));
+        std::vector<float> kernel(2 * radius + 1);
+        for (int i = -radius; i <= radius; ++i)
+        {
+            float x = float(i);
+            float g = std::exp(-x * x / (2.f * sigma * sigma));
+            if (order == 1) g *= -x / (sigma * sigma);
+            else if (order == 2) g *= (x * x / (sigma * sigma) - 1.f) / (sigma * sigma);
+            kernel[i + radius] = g;
+        }
+
+        if (order == 2)
+        {
+            // Make the second derivative kernel zero-mean so that flat regions do not respond.
+            float mean = 0.f;
+            for (float w : kernel) mean += w;
+            mean /= kernel.size();
+            for (float& w : kernel) w -= mean;
+        }
+
+        float norm = 0.f;
+        for (float w : kernel) norm += order == 0 ? w : std::max(w, 0.f);
+        for (float& w : kernel) w /= norm;
+        return kernel;
+    }
+
+    /** Separable convolution with clamp-to-edge addressing. Rows are processed in parallel.
+    */
+    inline void convolve(const float* src, float* dst, uint32_t width, uint32_t height, const std::vector<float>& kernelX, const std::vector<float>& kernelY, uint32_t threadCount, std::vector<float>& temp)
+    {
+        temp.resize(size_t(width) * height);
+        const int radiusX = int(kernelX.size() / 2);
+        const int radiusY = int(kernelY.size() / 2);
+
+        parallelFor(height, threadCount, [&] (uint32_t y)
+        {
+            // Copy the row into a padded buffer so that the inner loop needs no clamping and vectorizes.
+            thread_local std::vector<float> padded;
+            padded.resize(width + 2 * radiusX);
+            const float* srcRow = src + size_t(y) * width;
+            std::fill(padded.begin(), padded.begin() + radiusX, srcRow[0]);
+            std::copy(srcRow, srcRow + width, padded.begin() + radiusX);
+            std::fill(padded.end() - radiusX, padded.end(), srcRow[width - 1]);
+
+            float* tempRow = temp.data() + size_t(y) * width;
+            std::fill(tempRow, tempRow + width, 0.f);
+            for (int k = 0; k <= 2 * radiusX; ++k)
+            {
+                const float w = kernelX[k];
+                const float* p = padded.data() + k;
+                for (uint32_t x = 0; x < width; ++x) tempRow[x] += w * p[x];
+            }
+        });
+
+        parallelFor(height, threadCount, [&] (uint32_t y)
+        {
+            float* dstRow = dst + size_t(y) * width;
+            std::fill(dstRow, dstRow + width, 0.f);
+            for (int k = -radiusY; k <= radiusY; ++k)
+            {
+                const float w = kernelY[k + radiusY];
+                const float* tempRow = temp.data() + size_t(clamp(int(y) + k, 0, int(height) - 1)) * width;
+                for (uint32_t x = 0; x < width; ++x) dstRow[x] += w * tempRow[x];
+            }
+        });
+    }
+
+    /** Per-image data needed by the per-tile error evaluation.
+    */
+    struct Planes
+    {
+        std::vector<float> ycxcz[3];    ///< Spatially filtered YCxCz.
+        std::vector<float> edge;        ///< Edge detector magnitude.
+        std::vector<float> point;       ///< Point detector magnitude.
+    };
+
+    inline Planes preprocess(const Image& image, uint32_t threadCount)
+    {
+        const uint32_t width = image.getWidth();
+        const uint32_t height = image.getHeight();
+        const size_t pixelCount = size_t(width) * height;
+        const bool decode = !image.isLinear();
+
+        Planes planes;
+        for (auto& plane : planes.ycxcz) plane.resize(pixelCount);
+        std::vector<float> luminance(pixelCount);
+
+        parallelFor(height, threadCount, [&] (uint32_t y)
+        {
+            for (size_t i = size_t(y) * width; i < size_t(y + 1) * width; ++i)
+            {
+                float rgb[3], xyz[3], ycxcz[3];
+                for (size_t c = 0; c < 3; ++c)
+                {
+                    float v = clamp(image.getData()[i * 4 + c], 0.f, 1.f);
+                    rgb[c] = decode ? sRGBToLinear(v) : v;
+                }
+                linearRGBToXYZ(rgb, xyz);
+                XYZToYCxCz(xyz, ycxcz);
+                for (size_t c = 0; c < 3; ++c) planes.ycxcz[c][i] = ycxcz[c];
+                luminance[i] = (ycxcz[0] + 16.f) / 116.f;
+            }
+        });
+
+        // Contrast sensitivity filters. Each CSF is approximated by the Gaussian of its dominant term.
+        const float csfB[3] = { 0.0047f, 0.0053f, 0.04f };
+        std::vector<float> temp, filtered(pixelCount);
+        for (size_t c = 0; c < 3; ++c)
+        {
+            float sigma = std::sqrt(csfB[c] / (2.f * kPi * kPi)) * kPixelsPerDegree;
+            auto kernel = createKernel(sigma, 0);
+            convolve(planes.ycxcz[c].data(), filtered.data(), width, height, kernel, kernel, threadCount, temp);
+            planes.ycxcz[c].swap(filtered);
+        }
+
+        // Edge and point detectors on the unfiltered luminance.
+        const float featureSigma = 0.5f * kFeatureWidth * kPixelsPerDegree;
+        auto g0 = createKernel(featureSigma, 0);
+        auto g1 = createKernel(featureSigma, 1);
+        auto g2 = createKernel(featureSigma, 2);
+
+        std::vector<float> dx(pixelCount), dy(pixelCount);
+        auto magnitude = [&] (std::vector<float>& dst)
+        {
+            dst.resize(pixelCount);
+            parallelFor(height, threadCount, [&] (uint32_t y)
+            {
+                for (size_t i = size_t(y) * width; i < size_t(y + 1) * width; ++i) dst[i] = std::sqrt(dx[i] * dx[i] + dy[i] * dy[i]);
+            });
+        };
+
+        convolve(luminance.data(), dx.data(), width, height, g1, g0, threadCount, temp);
+        convolve(luminance.data(), dy.data(), width, height, g0, g1, threadCount, temp);
+        magnitude(planes.edge);
+        convolve(luminance.data(), dx.data(), width, height, g2, g0, threadCount, temp);
+        convolve(luminance.data(), dy.data(), width, height, g0, g2, threadCount, temp);
+        magnitude(planes.point);
+
+        return planes;
+    }
+
+    inline float pixelError(const Planes& a, const Planes& b, size_t i, float cmax)
+    {
+        auto huntLab = [i] (const Planes& planes, float lab[3])
+        {
+            float ycxcz[3] = { planes.ycxcz[0][i], planes.ycxcz[1][i], planes.ycxcz[2][i] };
+            float xyz[3], rgb[3];
+            YCxCzToXYZ(ycxcz, xyz);
+            XYZToLinearRGB(xyz, rgb);
+            for (size_t c = 0; c < 3; ++c) rgb[c] = clamp(rgb[c], 0.f, 1.f);
+            linearRGBToXYZ(rgb, xyz);
+            XYZToHuntLab(xyz, lab);
+        };
+
+        float labA[3], labB[3];
+        huntLab(a, labA);
+        huntLab(b, labB);
+
+        // Color error, compressed and remapped to [0,1].
+        float colorError = std::pow(HyAB(labA, labB), kQc);
+        const float pccmax = kPc * cmax;
+        colorError = colorError < pccmax ? kPt / pccmax * colorError : kPt + (colorError - pccmax) / (cmax - pccmax) * (1.f - kPt);
+        colorError = clamp(colorError, 0.f, 1.f);
+
+        // Feature error.
+        float edgeDiff = std::fabs(a.edge[i] - b.edge[i]);
+        float pointDiff = std::fabs(a.point[i] - b.point[i]);
+        float featureError = std::pow(clamp(std::max(edgeDiff, pointDiff) / std::sqrt(2.f), 0.f, 1.f), kQf);
+
+        return std::pow(colorError, 1.f - featureError);
+    }
+}
+
+inline CompareResult compareFLIP(const Image& imageA, const Image& imageB, const CompareOptions& options, float* errorMap)
+{
+    const uint32_t width = imageA.getWidth();
+    const uint32_t height = imageA.getHeight();
+    const double pixelCount = double(width) * height;
+    const uint32_t threadCount = getThreadCount(options.threadCount);
+
+    const FLIP::Planes planesA = FLIP::preprocess(imageA, threadCount);
+    const FLIP::Planes planesB = FLIP::preprocess(imageB, threadCount);
+    const float cmax = FLIP::maxColorError();
+
+    auto compareTile = [&] (const Tile& tile)
+    {
+        double sum = 0.0;
+        for (uint32_t y = tile.y; y < tile.y + tile.height; ++y)
+        {
+            const size_t offset = size_t(y) * width;
+            for (uint32_t x = tile.x; x < tile.x + tile.width; ++x)
+            {
+                float error = FLIP::pixelError(planesA, planesB, offset + x, cmax);
+                if (errorMap) errorMap[offset + x] = error;
+                sum += error;
+            }
+        }
+        return sum;
+    };
+
+    auto shouldAbort = [&] (double partialSum)
+    {
+        return options.earlyOut && partialSum / pixelCount > options.threshold;
+    };
+
+    auto reduction = reduceTiles(width, height, threadCount, compareTile, shouldAbort);
+    return { reduction.sum / pixelCount, reduction.aborted };
+}
+
+struct ErrorMetric
+{
+    std::string name;
+    std::string desc;
+    std::function<CompareResult(const Image& imageA, const Image& imageB, const CompareOptions& options, float* errorMap)> compare;
+};
+
+inline const std::vector<ErrorMetric> errorMetrics =
+{
+    { "mse", "Mean Squared Error", compare<MSE> },
+    { "rmse", "Relative Mean Squared Error", compare<RMSE> },
+    { "rootmse", "Root Mean Squared Error", compare<RootMSE> },
+    { "mae", "Mean Absolute Error (legacy, squared difference)", compare<MAE> },
+    { "absmae", "Mean Absolute Error", compare<AbsMAE> },
+    { "mape", "Mean Absolute Percentage Error", compare<MAPE> },
+    { "flip", "Perceptual error (FLIP-like, 0..1)", compareFLIP },
+};
+
+}  // namespace ImageCompare
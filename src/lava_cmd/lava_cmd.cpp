@@ -13,15 +13,13 @@
 #include <execinfo.h>
 #include <signal.h>
 
-#include <boost/log/core.hpp>
-#include <boost/log/trivial.hpp>
-#include <boost/log/expressions.hpp>
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string/join.hpp>
 namespace po = boost::program_options;
 
 #include "Falcor/Utils/ConfigStore.h"
+#include "Falcor/Utils/Timing/TraceRecorder.h"
 #include "Falcor/Core/API/DeviceManager.h"
 
 #include "lava_lib/renderer.h"
@@ -33,6 +31,7 @@ namespace po = boost::program_options;
 using namespace lava;
 
 void signalHandler( int signum ){
+  lava::ut::log::flush_log_on_crash();
   fprintf(stderr, "Error: signal %d:\n", signum);
   // cleanup and close up stuff here
   // terminate program
@@ -40,6 +39,7 @@ void signalHandler( int signum ){
 }
 
 void signalTraceHandler( int signum ){
+  lava::ut::log::flush_log_on_crash();
   fprintf(stderr, "Error: signal %d:\n", signum);
   // cleanup and close up stuff here
   // terminate program
@@ -69,20 +69,38 @@ void listGPUs() {
   std::cout << std::endl;
 }
 
+void writeTrace(const std::string& trace_file, const std::string& trace_metrics_file) {
+  if (!Falcor::TraceRecorder::isEnabled()) return;
+  Falcor::TraceRecorder::stop();
+
+  if (!trace_file.empty() && !Falcor::TraceRecorder::write(trace_file)) {
+    LLOG_ERR << "Unable to write trace file " << trace_file;
+  }
+  if (!trace_metrics_file.empty() && !Falcor::TraceRecorder::writeMetrics(trace_metrics_file)) {
+    LLOG_ERR << "Unable to write trace metrics file " << trace_metrics_file;
+  }
+  if (Falcor::TraceRecorder::getDroppedEventCount() > 0) {
+    LLOG_WRN << Falcor::TraceRecorder::getDroppedEventCount() << " trace events were dropped";
+  }
+}
+
 typedef std::basic_ifstream<wchar_t, std::char_traits<wchar_t> > wifstream;
 
 int main(int argc, char** argv){
     int gpuID = -1; // automatic gpu selection
 
-    boost::log::trivial::severity_level logSeverity;
+    lava::ut::log::Severity logSeverity;
 #ifdef DEBUG
-    boost::log::trivial::severity_level logSeverityDefault = boost::log::trivial::debug;
+    lava::ut::log::Severity logSeverityDefault = lava::ut::log::Severity::debug;
 #else
-    boost::log::trivial::severity_level logSeverityDefault = boost::log::trivial::warning;
+    lava::ut::log::Severity logSeverityDefault = lava::ut::log::Severity::warning;
 #endif
     bool echo_input = true;
     bool vtoff_flag = false; // virtual texturing enabled by default
     bool fconv_flag = false; // force virtual textures (re)conversion
+    int rg_record_threads = 0; // render graph passes recorded on the calling thread by default
+    std::string trace_file; // chrome trace (.json) or binary trace (.bin) output
+    std::string trace_metrics_file; // per event timing metrics output
 
     //std::atexit(atexitHandler);
 
@@ -109,12 +127,15 @@ int main(int argc, char** argv){
       ("device,d", po::value<int>(&gpuID)->default_value(0), "Use specific device")
       ("vtoff", po::bool_switch(&vtoff_flag), "Turn off vitrual texturing")
       ("fconv", po::bool_switch(&fconv_flag), "Force textures (re)conversion")
+      ("rg-record-threads", po::value<int>(&rg_record_threads)->default_value(0), "Record independent render graph passes on this many worker threads")
       ("include-path,i", po::value< std::vector<std::string> >()->composing(), "Include path")
+      ("trace", po::value<std::string>(&trace_file), "Record a trace of the run into a Chrome trace (.json) or binary (.bin) file")
+      ("trace-metrics", po::value<std::string>(&trace_metrics_file), "Record a trace of the run and write per event timing metrics (.json)")
       ;
 
     po::options_description logging("Logging");
     logging.add_options()
-      ("log-level,l", po::value<boost::log::trivial::severity_level>(&logSeverity)->default_value(logSeverityDefault),"log level to output")
+      ("log-level,l", po::value<lava::ut::log::Severity>(&logSeverity)->default_value(logSeverityDefault),"log level to output")
       ;
 
     po::options_description input("Input");
@@ -161,7 +182,7 @@ int main(int argc, char** argv){
 
     // Set up logging 
     lava::ut::log::init_log();
-    boost::log::core::get()->set_filter(  boost::log::trivial::severity >= logSeverity );
+    lava::ut::log::set_min_severity(logSeverity);
 
     if ( vm.count("list-devices")) {
       listGPUs();
@@ -191,6 +212,14 @@ int main(int argc, char** argv){
       app_config.set<bool>("fconv", true);
     }
 
+    if(rg_record_threads > 0) {
+      app_config.set<int>("rg_record_threads", rg_record_threads);
+    }
+
+    if(!trace_file.empty() || !trace_metrics_file.empty()) {
+      Falcor::TraceRecorder::start();
+    }
+
 
     // Populate Renderer_IO_Registry with internal and external scene translators
     SceneReadersRegistry::getInstance().addReader(
@@ -222,18 +251,19 @@ int main(int argc, char** argv){
     if (vm.count("input-file")) {
       // loading provided files
       std::vector<std::string> files = vm["input-file"].as< std::vector<std::string> >();
-      BOOST_LOG_TRIVIAL(debug) << "Input scene files are: "<< boost::algorithm::join(files, " ") << "\n";
+      LLOG_DBG << "Input scene files are: "<< boost::algorithm::join(files, " ") << "\n";
       for (std::vector<std::string>::const_iterator fi = files.begin(); fi != files.end(); ++fi) {
         std::ifstream in_file(*fi, std::ifstream::binary);
         
         if ( in_file ) {
           std::string file_extension = boost::filesystem::extension(*fi);
-          BOOST_LOG_TRIVIAL(debug) << "ext " << file_extension;
+          LLOG_DBG << "ext " << file_extension;
 
           auto reader = SceneReadersRegistry::getInstance().getReaderByExt(file_extension);
           reader->init(pRenderer->aquireInterface(), echo_input);
 
           LLOG_DBG << "Reading "<< *fi << " scene file with " << reader->formatName() << " reader";
+          TRACE_SCOPE("lava::readStream");
           if (!reader->readStream(in_file)) {
             // error loading scene from file
             LLOG_ERR << "Error loading scene from file: " << *fi;
@@ -245,10 +275,11 @@ int main(int argc, char** argv){
       }
     } else {
       // loading from stdin
-      BOOST_LOG_TRIVIAL(debug) << "Reading scene from stdin ...\n";
+      LLOG_DBG << "Reading scene from stdin ...\n";
       auto reader = SceneReadersRegistry::getInstance().getReaderByExt(".lsd"); // default format for reading stdin is ".lsd"
       reader->init(pRenderer->aquireInterface(), echo_input);
 
+      TRACE_SCOPE("lava::readStream");
       if (!reader->readStream(std::cin)) {
         // error loading scene from stdin
         LLOG_ERR << "Error loading scene from stdin !";
@@ -257,5 +288,7 @@ int main(int argc, char** argv){
 
     pDeviceManager = nullptr;
 
+    writeTrace(trace_file, trace_metrics_file);
+
     exit(EXIT_SUCCESS);
 }
\ No newline at end of file
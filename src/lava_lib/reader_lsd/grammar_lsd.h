@@ -41,7 +41,6 @@
 
 #include "../display.h"
 
-#include "boost/log/core.hpp"
 #include "lava_utils_lib/logging.h"
 
 namespace x3 = boost::spirit::x3;
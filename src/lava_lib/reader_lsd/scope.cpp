@@ -82,6 +82,8 @@ Global::SharedPtr Global::create() {
 	if(!pGlobal->declareProperty(Style::IMAGE, Type::INT2, "resolution", lsd::Int2{1280, 720}, Property::Owner::SYS)) return nullptr;
 	if(!pGlobal->declareProperty(Style::IMAGE, Type::INT, "samples", 16, Property::Owner::SYS)) return nullptr;
 	if(!pGlobal->declareProperty(Style::IMAGE, Type::FLOAT, "pixelaspect", 1.0, Property::Owner::SYS)) return nullptr;
+	if(!pGlobal->declareProperty(Style::IMAGE, Type::FLOAT, "variance", 0.0, Property::Owner::SYS)) return nullptr;
+	if(!pGlobal->declareProperty(Style::IMAGE, Type::INT, "minraysamples", 1, Property::Owner::SYS)) return nullptr;
 	if(!pGlobal->declareProperty(Style::IMAGE, Type::VECTOR4, "crop", lsd::Vector4{0.0, 1.0, 0.0, 1.0}, Property::Owner::SYS)) return nullptr;
 	
 	if(!pGlobal->declareProperty(Style::CAMERA, Type::VECTOR2, "clip", lsd::Vector2{0.01, 1000.0}, Property::Owner::SYS)) return nullptr;
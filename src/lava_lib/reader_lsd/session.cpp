@@ -133,6 +133,8 @@ bool Session::prepareFrameData() {
 	}
 
 	mFrameData.imageSamples = mpGlobal->getPropertyValue(ast::Style::IMAGE, "samples", 1);
+	mFrameData.imageVarianceThreshold = mpGlobal->getPropertyValue(ast::Style::IMAGE, "variance", (double)0.0);
+	mFrameData.imageMinSamples = mpGlobal->getPropertyValue(ast::Style::IMAGE, "minraysamples", 1);
 
 	return true;
 }
@@ -1,25 +1,20 @@
-/*
- * txt2bin [input]
- *
- * decode the specified text file and recreate the original binary file 
- * encoded with encode.
- */
-#include <stdlib.h>
-#include <stdio.h>
-#include <string.h>
-
 #include "uudecode.h"
 
-namespace lava { 
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+namespace lava {
 
 namespace lsd {
 
 namespace uu {
 
-unsigned short CRC = 0x0000; /* CRC-16 Accumulator */
+namespace {
 
 /* crctab calculated by Mark G. Mendel, Network Systems Corporation */ 
-static unsigned short crctab[256] = {
+static const uint16_t kCRCTable[256] = {
     0x0000,  0x1021,  0x2042,  0x3063,  0x4084,  0x50a5,  0x60c6,  0x70e7, 
     0x8108,  0x9129,  0xa14a,  0xb16b,  0xc18c,  0xd1ad,  0xe1ce,  0xf1ef, 
     0x1231,  0x0210,  0x3273,  0x2252,  0x52b5,  0x4294,  0x72f7,  0x62d6, 
@@ -67,189 +62,228 @@ static unsigned short crctab[256] = {
    Stephen Satchell of Satchell Evaluations and 
    Chuck Forsberg of Omen Technology.
 */
-     
-#define updcrc(cp, crc) ( crctab[((crc>>8)&0x0FF)]^(crc<<8)^(cp&0x0FF) )
-
-char DECN ( char ch );
-void decode ( FILE *in, FILE *out );
-void outdec ( char *p, FILE *f, int n );
-
-/******************************************************************************/
-  
-bool decodeUU ( FILE *in, FILE *out, bool checkCRC ) {
-
-  int mode;
-  char *ptr;
-  char dest[128]; // decoded file name
-  char buf[80];
-  unsigned int CODE;
-  bool diskFile = false;
-
-  //search for header line 
-  for (;;) {
-    if (fgets(buf, sizeof buf, in) == NULL)  {
-      fprintf(stderr, "No begin line - File is invalid OR corrupted\n"); 
-      return false;
-    }
-    if (strncmp(buf, "begin ", 6) == 0) break; 
-  }
-  sscanf(buf, "begin %o %s", &mode, dest);
-   
-  /* create output file */
-
-  if(out == NULL) {
-    diskFile = true;
-    out = fopen(dest, "wb");
-  }
-
-  if (out == NULL) {
-    printf("Can't create output file: %s\n", dest); 
-    return false;
-  }
-  
-  printf("Decoding into file: %s\n",dest); 
-  
-  decode(in, out);
-  
-  if (checkCRC) {   
-    ptr = fgets(buf, sizeof buf, in);
-     
-    if (strncmp(buf, "CRC= ",5) != 0 || ptr == NULL) {
-      fprintf(stderr, "CRC Checksum is missing  - Possible corruption.\n"); 
-      return false;
+
+/* updateCRC derived from the updcrc macro, Copyright (C) 1986 Stephen Satchell.
+ * Programmers may incorporate any or all code into their programs, giving proper credit within the source. Publication of the
+ * source routines is permitted so long as credit is given to Stephen Satchell of Satchell Evaluations and Chuck Forsberg of
+ * Omen Technology. */
+inline uint16_t updateCRC(uint8_t c, uint16_t crc) {
+    return kCRCTable[(crc >> 8) & 0xFF] ^ uint16_t(crc << 8) ^ c;
+}
+
+/* 6 bit value of each encoded character. Besides the standard ' ' to '`' range this accepts the substitutions the old txt2bin
+ * encoder made to avoid EBCDIC problem characters and spaces. */
+const std::array<uint8_t, 256> kDecodeTable = [] {
+    std::array<uint8_t, 256> table = {};
+    for (int c = 0; c < 256; c++) {
+        char ch = char(c);
+        switch (ch) {
+            case 'm': ch = ' '; break;
+            case 'd': ch = '['; break;
+            case 'e': ch = '\\'; break;
+            case 'f': ch = ']'; break;
+            case 'g': ch = '^'; break;
+            case 'h': ch = '\''; break;
+        }
+        table[c] = uint8_t((ch - ' ') & 0x3F);
     }
-     
-    sscanf(buf, "CRC= %x", &CODE);
-     
-    if (CODE != CRC) {
-      fprintf(stderr, "CRC Checksum is invalid - File is corrupted.\n"); 
-      fprintf(stderr, "Expected: %04X, Got: %04X\n",CODE, CRC);
-      return false;
+    return table;
+}();
+
+inline uint8_t dec(char c) {
+    return kDecodeTable[uint8_t(c)];
+}
+
+// 4 characters -> 3 bytes
+inline void decodeGroup(const char* p, unsigned char* pDst) {
+    uint32_t v = uint32_t(dec(p[0])) << 18 | uint32_t(dec(p[1])) << 12 | uint32_t(dec(p[2])) << 6 | uint32_t(dec(p[3]));
+    pDst[0] = uint8_t(v >> 16);
+    pDst[1] = uint8_t(v >> 8);
+    pDst[2] = uint8_t(v);
+}
+
+/* 8 characters -> 6 bytes, writing 8. Lines made of the standard characters are decoded arithmetically, 8 characters at a time;
+ * blocks holding anything else go through the table. */
+inline void decodeBlock(const char* p, unsigned char* pDst) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+
+    // Bytes >= 0x61 or < 0x20
+    uint64_t outside = (((v + 0x1F1F1F1F1F1F1F1Full) | v) | ((v - 0x2020202020202020ull) & ~v)) & 0x8080808080808080ull;
+    if (outside) {
+        decodeGroup(p, pDst);
+        decodeGroup(p + 4, pDst + 3);
+        return;
     }
-  }
 
-  ptr = fgets(buf, sizeof buf, in);
-  if (strcmp(buf, "end\n") != 0 || ptr == NULL) {
-    fprintf(stderr, "Missing end line - Possible corruption.\n"); 
-    return false;
-  }
+    // Gather the 6 bit values of each 4 characters into 24 bits, the first character in the top bits
+    v = (v - 0x2020202020202020ull) & 0x3F3F3F3F3F3F3F3Full;
+    v = ((v & 0x003F003F003F003Full) << 6) | ((v >> 8) & 0x003F003F003F003Full);
+    v = ((v & 0x00000FFF00000FFFull) << 12) | ((v >> 16) & 0x00000FFF00000FFFull);
+    uint64_t bytes = __builtin_bswap64(((v & 0xFFFFFFull) << 40) | ((v >> 32) << 16));
+    std::memcpy(pDst, &bytes, sizeof(bytes));
+}
 
-  if(diskFile)
-    fclose(out);
-     
-  return true;
+inline bool startsWith(const char* pLine, size_t length, const char* prefix) {
+    size_t prefixLength = std::strlen(prefix);
+    return length >= prefixLength && std::memcmp(pLine, prefix, prefixLength) == 0;
 }
-/******************************************************************************/
-/******************************************************************************/
 
-char DECN ( char ch )
+const size_t kChunkSize = 64 * 1024;
+const size_t kOutGrowth = 64 * 1024;
+
+}  // namespace
+
+Decoder::Decoder(std::vector<unsigned char>& out, bool checkCRC): mOut(out), mOutSize(out.size()), mCheckCRC(checkCRC) { }
+
+bool Decoder::feed(const char* pData, size_t size) {
+    const char* p = pData;
+    const char* pEnd = pData + size;
+    while (p < pEnd && (mState == State::Header || mState == State::Body || mState == State::Trailer)) {
+        const char* pLineEnd = static_cast<const char*>(std::memchr(p, '\n', pEnd - p));
+        if (!pLineEnd) {
+            mPartialLine.append(p, pEnd);
+            break;
+        }
+
+        if (mPartialLine.empty()) {
+            processLine(p, pLineEnd - p);
+        } else {
+            mPartialLine.append(p, pLineEnd);
+            processLine(mPartialLine.data(), mPartialLine.size());
+            mPartialLine.clear();
+        }
+        p = pLineEnd + 1;
+    }
 
-/******************************************************************************/
-/*
-  Purpose:
-
-    DECN decodes characters, avoiding ebcdic problem chars and spaces.
- */
-{
- switch (ch)
-  {
-   case 'm' : ch = ' ';
-          break;
-   case 'd' : ch = '[';
-          break;
-   case 'e' : ch = '\\';
-          break;
-   case 'f' : ch = ']';
-          break;
-   case 'g' : ch = '^';
-          break;
-   case 'h' : ch = '\'';
-          break;
-  }
-     
- /* final decode: output = input-0x20 */ 
- ch = (ch - ' ') & 0x03F;
-     
- return(ch);
+    // Lines are decoded into spare room at the end of the buffer, drop what wasn't used so the buffer holds the data decoded so far
+    mOut.resize(mOutSize);
+    return mState != State::Error;
 }
-/******************************************************************************/   
-     
-void decode ( FILE *in, FILE *out )
 
-/******************************************************************************/
-/*
-  Purpose:
+bool Decoder::finish() {
+    if (!mPartialLine.empty() && mState != State::Done && mState != State::Error) {
+        processLine(mPartialLine.data(), mPartialLine.size());
+    }
+    mPartialLine.clear();
 
-    DECODE copies from in to out, decoding as it goes along. 
-*/
-{
-  char buf[80];
-  char *bp;
-  int n;
-
-  for (;;) {
-    /* for each input line */
-    if (fgets(buf, sizeof buf, in) == NULL) {
-    printf("Short file - Zero record terminator not found.\n"); 
-    exit(10);
-  }
-  n = DECN(buf[0]);
-  if (n <= 0) break;
-
-  bp = &buf[1];
-  while (n > 0) {
-    outdec(bp, out, n);
-    bp += 4;
-    n -= 3;
-  }
-  }
+    if (mState == State::Header) fail("No begin line - data is invalid or corrupted");
+    else if (mState == State::Body || mState == State::Trailer) fail("Missing end line - possible corruption");
+    return mState == State::Done;
 }
-/******************************************************************************/
 
-void outdec ( char *p, FILE *f, int n )
+void Decoder::fail(const std::string& error) {
+    mState = State::Error;
+    mError = error;
+}
 
-/******************************************************************************/
-/*
- * output a group of 3 bytes (4 input characters). 
- * the input chars are pointed to by p, they are to
- * be output to file f.  n is used to tell us not to 
- * output all of them at the end of the file.
- */
-{
-  int c1, c2, c3;
-     
-  c1 = DECN(*p) << 2 | DECN(p[1]) >> 4; 
-  c2 = DECN(p[1]) << 4 | DECN(p[2]) >> 2; 
-  c3 = DECN(p[2]) << 6 | DECN(p[3]);
+void Decoder::processLine(const char* pLine, size_t length) {
+    if (length > 0 && pLine[length - 1] == '\r') length--;
+
+    switch (mState) {
+        case State::Header:
+            if (startsWith(pLine, length, "begin ")) {
+                std::string header(pLine + 6, length - 6);
+                size_t nameStart = header.find(' ');
+                mMode = uint32_t(std::strtoul(header.c_str(), nullptr, 8));
+                mFileName = nameStart == std::string::npos ? std::string() : header.substr(nameStart + 1);
+                mState = State::Body;
+            }
+            break;
+        case State::Body:
+            decodeLine(pLine, length);
+            break;
+        case State::Trailer:
+            if (length == 0) break;
+            if (startsWith(pLine, length, "CRC= ")) {
+                unsigned int crc = 0;
+                if (std::sscanf(std::string(pLine + 5, length - 5).c_str(), "%x", &crc) != 1) {
+                    fail("Invalid CRC line");
+                } else if (mCheckCRC && crc != mCRC) {
+                    char message[64];
+                    std::snprintf(message, sizeof(message), "CRC checksum is invalid. Expected: %04X, got: %04X", crc, mCRC);
+                    fail(message);
+                }
+                mHasCRC = true;
+            } else if (length == 3 && std::memcmp(pLine, "end", 3) == 0) {
+                if (mCheckCRC && !mHasCRC) fail("CRC checksum is missing - possible corruption");
+                else mState = State::Done;
+            } else {
+                fail("Missing end line - possible corruption");
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void Decoder::decodeLine(const char* pLine, size_t length) {
+    // The first character holds the line's byte count, a zero count ends the data
+    uint32_t count = length > 0 ? dec(pLine[0]) : 0;
+    if (count == 0) {
+        mState = State::Trailer;
+        return;
+    }
+
+    const char* pChars = pLine + 1;
+    size_t charCount = (count + 2) / 3 * 4;
+    char padded[88];
+    if (length - 1 < charCount) {
+        // Some encoders strip trailing spaces, which encode zeros
+        std::memset(padded, ' ', sizeof(padded));
+        std::memcpy(padded, pChars, length - 1);
+        pChars = padded;
+    }
+
+    // Blocks write 2 bytes past their output
+    if (mOut.size() < mOutSize + count + 2) mOut.resize(mOutSize + std::max(size_t(count) + 2, kOutGrowth));
+    unsigned char* pDst = mOut.data() + mOutSize;
+    mOutSize += count;
+
+    uint32_t blocks = count / 6;
+    for (uint32_t b = 0; b < blocks; b++) decodeBlock(pChars + b * 8, pDst + b * 6);
 
-  if ( n >= 1 ) { putc(c1, f); CRC=updcrc(c1,CRC); } 
-  if ( n >= 2 ) { putc(c2, f); CRC=updcrc(c2,CRC); } 
-  if ( n >= 3 ) { putc(c3, f); CRC=updcrc(c3,CRC); } 
+    // The last 1 to 5 bytes
+    for (uint32_t offset = blocks * 6; offset < count; offset += 3) {
+        unsigned char group[3];
+        decodeGroup(pChars + offset / 3 * 4, group);
+        std::memcpy(pDst + offset, group, std::min(3u, count - offset));
+    }
 
-  return;
+    if (mCheckCRC) {
+        for (uint32_t i = 0; i < count; i++) mCRC = updateCRC(pDst[i], mCRC);
+    }
 }
-/******************************************************************************/
 
-int fr ( FILE *fd, char *buf, int cnt )
+bool decodeUU(const char* pData, size_t size, std::vector<unsigned char>& out, bool checkCRC, std::string* pError) {
+    out.reserve(out.size() + size / 4 * 3);
 
-/******************************************************************************/
-/* 
-  fr: like read but stdio 
-*/
-{
-  int c;
-  int i;
-    
-  for (i=0; i<cnt; i++)
-  {
-    c = getc(fd);
-    if ( c == EOF )
-    {
-      return(i);
+    Decoder decoder(out, checkCRC);
+    decoder.feed(pData, size);
+    bool result = decoder.finish();
+    if (pError) *pError = decoder.error();
+    return result;
+}
+
+bool decodeUU(std::istream& in, size_t size, std::vector<unsigned char>& out, bool checkCRC, std::string* pError) {
+    out.reserve(out.size() + size / 4 * 3);
+
+    Decoder decoder(out, checkCRC);
+    std::vector<char> chunk(std::min(size, kChunkSize));
+    size_t remaining = size;
+
+    // The whole block is consumed even past the end line, so the stream is left right after it
+    while (remaining > 0) {
+        in.read(chunk.data(), std::min(remaining, chunk.size()));
+        size_t readCount = size_t(in.gcount());
+        if (readCount == 0) break;
+        decoder.feed(chunk.data(), readCount);
+        remaining -= readCount;
     }
-    buf[i] = c;
-  }
-  return cnt;
+
+    bool result = decoder.finish();
+    if (pError) *pError = remaining > 0 && result ? "Unexpected end of stream" : decoder.error();
+    return result && remaining == 0;
 }
 
 }  // namespace uu
@@ -1,24 +1,78 @@
-/*
- * txt2bin [input]
- *
- * decode the specified text file and recreate the original binary file 
- * encoded with encode.
- */
-# include <stdlib.h>
-# include <stdio.h>
-# include <string.h>
+#ifndef SRC_LAVA_LIB_READER_LSD_UUDECODE_H_
+#define SRC_LAVA_LIB_READER_LSD_UUDECODE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
 
-namespace lava { 
+namespace lava {
 
 namespace lsd {
 
 namespace uu {
- 
-bool decodeUU ( FILE *in, FILE *out, bool checkCRC = false );
 
+/** Streaming uudecoder.
+ *  Encoded text can be fed in chunks of any size, lines split across chunks included. Decoded bytes are appended to the output buffer
+ *  as each line completes, so nothing but the current partial line is ever buffered.
+ */
+class Decoder {
+ public:
+    enum class State { Header, Body, Trailer, Done, Error };
+
+    /** \param[out] out Buffer decoded bytes are appended to.
+     *  \param[in] checkCRC Require a "CRC= xxxx" line before the end line and check it against the decoded data.
+     */
+    Decoder(std::vector<unsigned char>& out, bool checkCRC = false);
+
+    /** Decode the next chunk of encoded text. Anything after the end line is ignored.
+     *  \return False once an error was found.
+     */
+    bool feed(const char* pData, size_t size);
+
+    /** Flush a last line that has no line break.
+     *  \return True if the end line was reached without error.
+     */
+    bool finish();
+
+    State state() const { return mState; }
+    const std::string& error() const { return mError; }
+
+    /** Name and permissions from the begin line.
+     */
+    const std::string& fileName() const { return mFileName; }
+    uint32_t mode() const { return mMode; }
+
+ private:
+    void processLine(const char* pLine, size_t length);
+    void decodeLine(const char* pLine, size_t length);
+    void fail(const std::string& error);
+
+    std::vector<unsigned char>& mOut;
+    size_t mOutSize;            // Bytes of mOut holding decoded data, the rest is room for the next lines
+    bool mCheckCRC;
+    uint16_t mCRC = 0;
+    bool mHasCRC = false;
+    State mState = State::Header;
+    std::string mError;
+    std::string mFileName;
+    uint32_t mMode = 0;
+    std::string mPartialLine;   // Start of a line the previous chunk ended in
+};
+
+/** Decode a uuencoded block in memory.
+ */
+bool decodeUU(const char* pData, size_t size, std::vector<unsigned char>& out, bool checkCRC = false, std::string* pError = nullptr);
+
+/** Decode the next `size` bytes of a stream, reading them in chunks.
+ */
+bool decodeUU(std::istream& in, size_t size, std::vector<unsigned char>& out, bool checkCRC = false, std::string* pError = nullptr);
 
 }  // namespace uu
 
 }  // namespace lsd
 
 }  // namespace lava
+
+#endif  // SRC_LAVA_LIB_READER_LSD_UUDECODE_H_
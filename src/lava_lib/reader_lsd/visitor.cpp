@@ -17,35 +17,14 @@ namespace lsd {
 bool readEmbeddedFileUU(std::istream* pParserStream, size_t size, std::vector<unsigned char>& decoded_data) {
     LLOG_DBG << "Reading " << size << " bytes of embedded data";
 
-    bool result = true;
-    std::istream &in = *pParserStream;
-
-    std::vector<char> buff(size);
- 
-    // read size amount of bytes from stream into buff
-    in.unsetf(std::ios::skipws);
-    in.read((char *)buff.data(), size);
-    in.setf(std::ios::skipws);
-
-    // decode data
-    FILE* inMemFile = fmemopen((void *)buff.data(), size, "rw");
-    
-    FILE* outTestFile = fopen("/home/max/Desktop/mistery_file_decoded", "w");
-
-    if(!uu::decodeUU(inMemFile, outTestFile)) {
-        LLOG_DBG << "Error decoding embedded data !!!";
+    // Decode in chunks straight from the parser stream into the scope's buffer
+    std::string error;
+    decoded_data.clear();
+    if(!uu::decodeUU(*pParserStream, size, decoded_data, false, &error)) {
+        LLOG_ERR << "Error decoding embedded data: " << error;
+        return false;
     }
-
-    fclose(inMemFile);
-    
-    if(outTestFile)
-        fclose(outTestFile);
-    // test write
-    //std::ofstream fout("/home/max/Desktop/mistery_file", std::ios::out | std::ios::binary);
-    //fout.write((char*)&buff[0], buff.size() * sizeof(unsigned char));
-    //fout.close();
-
-    return result;
+    return true;
 }
 
 bool readInlineBGEO(std::istream* pParserStream, ika::bgeo::Bgeo::SharedPtr pBgeo) {
@@ -6,6 +6,7 @@
 #include "Falcor/Utils/Scripting/Dictionary.h"
 #include "Falcor/Utils/Scripting/ScriptBindings.h"
 #include "Falcor/Utils/Debug/debug.h"
+#include "Falcor/Utils/Timing/TraceRecorder.h"
 
 #include "Falcor/Experimental/Scene/Lights/EnvMap.h"
 
@@ -307,6 +308,10 @@ static CPUSampleGenerator::SharedPtr createSamplePattern(Renderer::SamplePattern
             return HaltonSamplePattern::create(sampleCount);
         case Renderer::SamplePattern::Stratified:
             return StratifiedSamplePattern::create(sampleCount);
+        case Renderer::SamplePattern::Sobol:
+            return SobolSamplePattern::create(sampleCount);
+        case Renderer::SamplePattern::PMJ02:
+            return PMJ02SamplePattern::create(sampleCount);
         default:
             should_not_get_here();
             return nullptr;
@@ -314,9 +319,12 @@ static CPUSampleGenerator::SharedPtr createSamplePattern(Renderer::SamplePattern
 }
 
 void Renderer::finalizeScene(const RendererIface::FrameData& frame_data) {
+    TRACE_SCOPE("Renderer::finalizeScene");
+
     // finalize camera
     mInvFrameDim = 1.f / float2({frame_data.imageWidth, frame_data.imageHeight});
-    mpSampleGenerator = createSamplePattern(SamplePattern::Stratified, frame_data.imageSamples);
+    // Owen-scrambled Sobol has no sample count limit and reaches lower noise than stratified jitter at the same count.
+    mpSampleGenerator = createSamplePattern(SamplePattern::Sobol, frame_data.imageSamples);
     if (mpSampleGenerator) {
         mpCamera->setPatternGenerator(mpSampleGenerator, mInvFrameDim);
     }
@@ -355,10 +363,24 @@ void Renderer::finalizeScene(const RendererIface::FrameData& frame_data) {
         mpRenderGraph->resize(frame_data.imageWidth, frame_data.imageHeight, Falcor::ResourceFormat::RGBA32Float);
     }
 
+    mpAccumulatePass->setAdaptiveSampling(static_cast<float>(frame_data.imageVarianceThreshold), frame_data.imageMinSamples);
+
     //gpFramework->getClock().setTime(frame_data.time);
 }
 
+void Renderer::setSceneBuilder(const lava::SceneBuilder::SharedPtr& pSceneBuilder) {
+    assert(pSceneBuilder);
+    mpSceneBuilder = pSceneBuilder;
+    mpSceneBuilder->addCamera(mpCamera);
+    mpSceneBuilder->setCamera("main");
+
+    // Passes hold on to the scene they were created for
+    mpRenderGraph = nullptr;
+}
+
 void Renderer::renderFrame(const RendererIface::FrameData frame_data) {
+    TRACE_SCOPE("Renderer::renderFrame");
+
 	if (!mInited) {
 		LLOG_ERR << "Renderer not initialized !!!";
 		return;
@@ -408,14 +430,25 @@ void Renderer::renderFrame(const RendererIface::FrameData frame_data) {
         double time = frame_data.time;
         double sample_time_duration = (1.0 * shutter_length) / frame_data.imageSamples;
         
+        // Adaptive sampling keeps per-tile state from the previous frame, start over.
+        if (frame_data.imageVarianceThreshold > 0.0) mpAccumulatePass->reset();
+
         //resolvePerFrameSparseResourcesForActiveGraph(pRenderContext);
         pScene->update(pRenderContext, time);
         executeActiveGraph(pRenderContext);
 
         if ( frame_data.imageSamples > 1 ) {
             for (uint i = 1; i < frame_data.imageSamples; i++) {
+                // Every image tile reached the variance threshold, remaining samples wouldn't change the result.
+                if (mpAccumulatePass->isConverged()) {
+                    LLOG_DBG << "Image converged after " << i << " of " << frame_data.imageSamples << " samples";
+                    break;
+                }
+
                 LLOG_DBG << "Rendering sample no " << i << " of " << frame_data.imageSamples;
                 
+                TRACE_SCOPE("Renderer::renderSample");
+
                 // Update scene and camera.
                 time += sample_time_duration;
                 pScene->update(pRenderContext, time);
@@ -441,7 +474,8 @@ void Renderer::renderFrame(const RendererIface::FrameData frame_data) {
             assert(pTex);
             
             {
-            
+            TRACE_SCOPE("Renderer::readOutput");
+
             Falcor::ResourceFormat resourceFormat;
             uint32_t channels;
             std::vector<uint8_t> textureData;
@@ -17,6 +17,8 @@
 #include "Falcor/Scene/Camera/Camera.h"
 
 #include "Falcor/Utils/SampleGenerators/StratifiedSamplePattern.h"
+#include "Falcor/Utils/SampleGenerators/SobolSamplePattern.h"
+#include "Falcor/Utils/SampleGenerators/PMJ02SamplePattern.h"
 
 #include "RenderPasses/AccumulatePass/AccumulatePass.h"
 #include "RenderPasses/DepthPass/DepthPass.h"
@@ -44,6 +46,8 @@ class Renderer: public std::enable_shared_from_this<Renderer> {
         DirectX,
         Halton,
         Stratified,
+        Sobol,
+        PMJ02,
     };
 
  public:
@@ -73,6 +77,11 @@ class Renderer: public std::enable_shared_from_this<Renderer> {
 
  	void renderFrame(const RendererIface::FrameData frame_data);
 
+    /** Replace the scene builder, e.g. with one filled by a Hydra delegate. The main camera is added to it and the render
+        graph is rebuilt for its scene on the next renderFrame().
+    */
+    void setSceneBuilder(const lava::SceneBuilder::SharedPtr& pSceneBuilder);
+
 #ifdef SCRIPTING
  	static void registerBindings(pybind11::module& m);
 #endif
@@ -31,6 +31,8 @@ class RendererIface {
         uint imageWidth = 0;
         uint imageHeight = 0;
         uint imageSamples = 0;
+        double imageVarianceThreshold = 0.0;   // Relative error at which image tiles stop sampling. 0 disables adaptive sampling.
+        uint imageMinSamples = 1;              // Samples every tile gets before it can stop early.
 
         double time = 0.0;
 
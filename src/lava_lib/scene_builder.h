@@ -32,6 +32,10 @@ class SceneBuilder: public Falcor::SceneBuilder {
 
     void finalize();
 
+    /** Material of meshes that don't bind one.
+    */
+    const Material::SharedPtr& getDefaultMaterial() const { return mpDefaultMaterial; }
+
     ~SceneBuilder();
 
  private:
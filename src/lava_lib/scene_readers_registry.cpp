@@ -1,10 +1,6 @@
 #include <string>
 #include <vector>
 
-#include <boost/log/core.hpp>
-#include <boost/log/trivial.hpp>
-#include <boost/log/expressions.hpp>
-
 #include "scene_readers_registry.h"
 
 #include "lava_utils_lib/logging.h"
@@ -3,9 +3,7 @@
 #include <chrono>
 #include <array>
 
-#include <boost/log/core.hpp>
-#include <boost/log/trivial.hpp>
-#include <boost/log/expressions.hpp>
+#include "lava_utils_lib/logging.h"
 
 #include "prman/ndspy.h"
 #include <SDL.h>
@@ -107,7 +105,7 @@ PtDspyError DspyImageQuery(PtDspyImageHandle,PtDspyQueryType querytype, int data
         break; }
 
       case PkRenderingStartQuery :
-        std::cerr<<"Start rendering\n";
+        LLOG_INF << "Start rendering";
         break;
 
       case PkSupportsCheckpointing:
@@ -149,7 +147,7 @@ PtDspyError DspyImageData(PtDspyImageHandle ,int xmin,int xmax,int ymin,int ymax
     }
   }
 
-  //BOOST_LOG_TRIVIAL(debug) << "SDLDisplay data recieved with " << g_channels << " channels";
+  //LLOG_DBG << "SDLDisplay data recieved with " << g_channels << " channels";
 
   // copy data to image and draw
   window->updateImage(&g_pixels[0]);
@@ -159,13 +157,13 @@ PtDspyError DspyImageData(PtDspyImageHandle ,int xmin,int xmax,int ymin,int ymax
 }
 
 PtDspyError DspyImageClose(PtDspyImageHandle image_h) {
-  std::cerr<<"Rendering Complete ESC to Quit\n";
+  LLOG_INF << "Rendering Complete ESC to Quit";
   g_end = std::chrono::system_clock::now();
 
   std::chrono::duration<double> elapsed_seconds = g_end-g_start;
   std::time_t end_time = std::chrono::system_clock::to_time_t(g_end);
 
-  std::cout << "finished rendering at " << std::ctime(&end_time) << "elapsed time: " << elapsed_seconds.count() << "s\n";
+  LLOG_INF << "finished rendering at " << std::ctime(&end_time) << "elapsed time: " << elapsed_seconds.count() << "s";
   // go into window process loop until quit
   PtDspyError quit=PkDspyErrorNone;
   while(quit != PkDspyErrorCancel) {
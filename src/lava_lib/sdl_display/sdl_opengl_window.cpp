@@ -1,8 +1,4 @@
-#include <iostream>
-
-#include <boost/log/core.hpp>
-#include <boost/log/trivial.hpp>
-#include <boost/log/expressions.hpp>
+#include "lava_utils_lib/logging.h"
 
 #include "sdl_opengl_window.h"
 
@@ -47,7 +43,7 @@ void SDLOpenGLWindow::init() {
   GLenum err = glewInit();
   // error check
   if (GLEW_OK != err) {
-   std::cerr << "GLEW Error: "<< glewGetErrorString(err) << "\n";
+   LLOG_ERR << "GLEW Error: "<< glewGetErrorString(err);
   }
 
   ImGuiSetup();
@@ -75,7 +71,7 @@ void NGLCheckGLError( const std::string  &_file, const int _line ) noexcept {
     }
     if(errNum !=GL_NO_ERROR)
     {
-      std::cerr<<"GL error "<< str<<" line : "<<_line<<" file : "<<_file<<"\n";
+      LLOG_ERR<<"GL error "<< str<<" line : "<<_line<<" file : "<<_file;
     }
     errNum = glGetError();
 
@@ -94,12 +90,12 @@ void printInfoLog(const GLuint &_obj , GLenum _mode=GL_COMPILE_STATUS  ) {
     infoLog = new char[infologLength];
     glGetShaderInfoLog(_obj, infologLength, &charsWritten, infoLog);
 
-    std::cerr<<infoLog<<std::endl;
+    LLOG_WRN<<infoLog;
     delete [] infoLog;
     glGetShaderiv(_obj, _mode,&infologLength);
     if( infologLength == GL_FALSE)
     {
-      std::cerr<<"Shader compile failed or had warnings \n";
+      LLOG_FTL<<"Shader compile failed or had warnings";
       exit(EXIT_FAILURE);
     }
   }
@@ -367,8 +363,7 @@ void SDLOpenGLWindow::ImGuiCleanup() const {
 }
 
 void SDLOpenGLWindow::ErrorExit(const std::string &_msg) const {
-  std::cerr<<_msg<<'\n';
-  std::cerr<<SDL_GetError()<<'\n';
+  LLOG_FTL<<_msg<<": "<<SDL_GetError();
 
   ImGuiCleanup();
   SDL_Quit();
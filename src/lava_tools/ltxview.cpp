@@ -10,9 +10,6 @@
 #include <stdlib.h>
 #include <getopt.h>
 
-#include <boost/log/core.hpp>
-#include <boost/log/trivial.hpp>
-#include <boost/log/expressions.hpp>
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string/join.hpp>
@@ -49,6 +46,7 @@ void printUsage() {
 
 void signalHandler( int signum ){
     LLOG_DBG << "Interrupt signal (" << signum << ") received !";
+    lava::ut::log::flush_log_on_crash();
 
     // cleanup and close up stuff here
     // terminate program
@@ -69,7 +67,7 @@ typedef std::basic_ifstream<wchar_t, std::char_traits<wchar_t> > wifstream;
 int main(int argc, char** argv){
     // Set up logging level quick 
     lava::ut::log::init_log();
-    boost::log::core::get()->set_filter(  boost::log::trivial::severity >=  boost::log::trivial::debug );
+    lava::ut::log::set_min_severity(lava::ut::log::Severity::debug);
     
     int gpuID = -1; // automatic gpu selection
     int verbose_level = 6;
@@ -167,13 +165,13 @@ int main(int argc, char** argv){
     if (vm.count("input-file")) {
       // loading provided files
       std::vector<std::string> files = vm["input-file"].as< std::vector<std::string> >();
-      BOOST_LOG_TRIVIAL(debug) << "Input scene files are: "<< boost::algorithm::join(files, " ") << "\n";
+      LLOG_DBG << "Input scene files are: "<< boost::algorithm::join(files, " ") << "\n";
       for (std::vector<std::string>::const_iterator fi = files.begin(); fi != files.end(); ++fi) {
         std::ifstream in_file(*fi, std::ifstream::binary);
         
         if ( in_file ) {
           std::string file_extension = boost::filesystem::extension(*fi);
-          BOOST_LOG_TRIVIAL(debug) << "ext " << file_extension;
+          LLOG_DBG << "ext " << file_extension;
 
           auto reader = SceneReadersRegistry::getInstance().getReaderByExt(file_extension);
           reader->init(pRenderer->aquireInterface(), echo_input);
@@ -190,7 +188,7 @@ int main(int argc, char** argv){
       }
     } else {
       // loading from stdin
-      BOOST_LOG_TRIVIAL(debug) << "Reading scene from stdin ...\n";
+      LLOG_DBG << "Reading scene from stdin ...\n";
       auto reader = SceneReadersRegistry::getInstance().getReaderByExt(".lsd"); // default format for reading stdin is ".lsd"
       reader->init(pRenderer->aquireInterface(), echo_input);
 
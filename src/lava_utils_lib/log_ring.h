@@ -0,0 +1,101 @@
+#ifndef LAVA_UTILS_LOG_RING_H_
+#define LAVA_UTILS_LOG_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace lava { namespace ut { namespace log {
+
+/** Bounded lock-free multi-producer multi-consumer ring buffer (D. Vyukov's sequence numbered cells).
+ *  Producers and consumers only contend on their own position counter, a push or pop is one CAS when uncontended.
+ *  The log uses a single consumer, the second consumer is a signal handler draining what is left on a crash.
+ */
+template<typename T>
+class Ring {
+ public:
+    /** \param[in] capacity Number of cells, rounded up to a power of two.
+     */
+    explicit Ring(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        mMask = size - 1;
+        mCells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++) mCells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    size_t capacity() const { return mMask + 1; }
+
+    /** Claim a cell and fill it with `fill(T&)`.
+     *  \return False if the ring is full.
+     */
+    template<typename Fill>
+    bool tryPush(Fill&& fill) {
+        size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+        Cell* pCell;
+        for (;;) {
+            pCell = &mCells[pos & mMask];
+            size_t sequence = pCell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(sequence) - intptr_t(pos);
+            if (diff == 0) {
+                if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = mEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        fill(pCell->data);
+        pCell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Take the oldest cell and hand it to `consume(T&)`.
+     *  \return False if the ring is empty.
+     */
+    template<typename Consume>
+    bool tryPop(Consume&& consume) {
+        size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+        Cell* pCell;
+        for (;;) {
+            pCell = &mCells[pos & mMask];
+            size_t sequence = pCell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(sequence) - intptr_t(pos + 1);
+            if (diff == 0) {
+                if (mDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = mDequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        consume(pCell->data);
+        pCell->sequence.store(pos + mMask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Number of pushes claimed so far. A consumer that popped this many has seen every one of them.
+     */
+    size_t pushCount() const { return mEnqueuePos.load(std::memory_order_acquire); }
+    size_t popCount() const { return mDequeuePos.load(std::memory_order_acquire); }
+
+ private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> mCells;
+    size_t mMask;
+    alignas(64) std::atomic<size_t> mEnqueuePos = {0};
+    alignas(64) std::atomic<size_t> mDequeuePos = {0};
+};
+
+}}} // namespace lava::ut::log
+
+#endif // LAVA_UTILS_LOG_RING_H_
@@ -1,87 +1,577 @@
-#include <fstream>
-#include <ostream>
-#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
 
-//#include <boost/log/sources/severity_logger.hpp>
+#if defined(__unix__)
+#include <unistd.h>
+#endif
 
 #include "lava_utils_lib/logging.h"
+#include "lava_utils_lib/log_ring.h"
 
-namespace lava { namespace ut { namespace log { 
+namespace lava { namespace ut { namespace log {
 
-std::vector< std::function< void() > > g_log_stop_functions;
+namespace detail {
+    std::atomic<int> g_min_severity = { int(Severity::trace) };
+}
 
-BOOST_LOG_ATTRIBUTE_KEYWORD(line_id,    "LineID",       unsigned int)
-BOOST_LOG_ATTRIBUTE_KEYWORD(timestamp,  "TimeStamp",    boost::posix_time::ptime)
-BOOST_LOG_ATTRIBUTE_KEYWORD(severity,   "Severity",     boost::log::trivial::severity_level)
+namespace {
 
-// Initialize console logger
-void init_log() {
-    // create sink to stdout
-    boost::shared_ptr<text_sink> sink = boost::make_shared<text_sink>();
-
-    sink->locked_backend()->add_stream(
-        boost::shared_ptr<std::ostream>(&std::cout, boost::null_deleter()));
-
-    // flush
-    sink->locked_backend()->auto_flush(true);
-
-    // format sink
-    boost::log::formatter formatter = boost::log::expressions::stream
-        << std::setw(7) << std::setfill('0') << line_id << std::setfill(' ') << " | "
-        << boost::log::expressions::format_date_time(timestamp, "%Y-%m-%d, %H:%M:%S.%f") << " "
-        << "[" << boost::log::trivial::severity << "]"
-        << " - " << boost::log::expressions::smessage;
-    sink->set_formatter(formatter);
-
-    // filter
-    // TODO: add any filters
-
-    // register sink
-    boost::log::core::get()->add_sink(sink);
-
-    // add sink stop functions
-    g_log_stop_functions.emplace_back([sink]() {
-        sink->flush();
-        sink->stop();   
-    });
+const size_t kRingCapacity = 16384;
+const size_t kInlineTextSize = 200;
+const size_t kBatchRecords = 1024;
+const size_t kFormattedPrefixSize = 64;
+
+const char* kSeverityNames[] = { "trace", "debug", "info", "warning", "error", "fatal" };
+const int kStderrFd = 2;
+
+struct Entry {
+    Severity severity;
+    Channel channel;
+    int64_t timestampUs;            // System clock
+    uint32_t length;
+    char text[kInlineTextSize];
+    std::string longText;           // Texts that don't fit inline
+};
+
+struct Sink {
+    int id;
+    FILE* pFile;
+    int fd;                         // Descriptor of pFile, for writing from the crash handler
+    bool closeOnRemove;
+    Severity minSeverity;
+    uint32_t channels;
+    std::string batch;
+};
+
+/** Days since 1970-01-01 of a date in the proleptic Gregorian calendar (H. Hinnant's days_from_civil).
+ */
+int64_t daysFromCivil(int64_t year, int64_t month, int64_t day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yearOfEra = year - era * 400;
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
 }
 
-void shutdown_log() {
-    for (auto& stop : g_log_stop_functions)
+/** Formats "0000001 | 2020-01-31, 12:00:00.000000 [info] - " into pBuffer, caching the date and time of the last second.
+ */
+class PrefixFormatter {
+ public:
+    size_t format(char* pBuffer, uint64_t lineID, Severity severity, int64_t timestampUs) {
+        int64_t seconds = timestampUs / 1000000;
+        if (seconds != mSeconds) {
+            std::time_t t = std::time_t(seconds);
+            std::tm tm;
+            localtime_r(&t, &tm);
+            std::strftime(mDateTime, sizeof(mDateTime), "%Y-%m-%d, %H:%M:%S", &tm);
+            mSeconds = seconds;
+            mUtcOffset = daysFromCivil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday) * 86400 + tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec - seconds;
+        }
+        int length = std::snprintf(pBuffer, kFormattedPrefixSize, "%07llu | %s.%06lld [%s] - ", (unsigned long long)lineID, mDateTime,
+            (long long)(timestampUs % 1000000), kSeverityNames[int(severity)]);
+        return std::min(size_t(std::max(length, 0)), kFormattedPrefixSize - 1);
+    }
+
+    /** Seconds local time is ahead of UTC, as of the last formatted record.
+     */
+    int64_t utcOffset() const { return mUtcOffset; }
+
+ private:
+    int64_t mSeconds = -1;
+    int64_t mUtcOffset = 0;
+    char mDateTime[32] = {};
+};
+
+/** Same output as PrefixFormatter, for the crash handler. Async-signal-safe: integer arithmetic only, no locale,
+ *  time zone database or stdio. Local time is derived from the UTC offset the writer saw last.
+ */
+class SignalSafePrefixFormatter {
+ public:
+    size_t format(char* pBuffer, uint64_t lineID, Severity severity, int64_t timestampUs, int64_t utcOffset) {
+        mpBuffer = pBuffer;
+        mLength = 0;
+
+        int64_t local = timestampUs / 1000000 + utcOffset;
+        int64_t days = (local >= 0 ? local : local - 86399) / 86400;
+        int64_t secondOfDay = local - days * 86400;
+
+        // H. Hinnant's civil_from_days
+        int64_t z = days + 719468;
+        int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        int64_t dayOfEra = z - era * 146097;
+        int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        int64_t mp = (5 * dayOfYear + 2) / 153;
+        int64_t day = dayOfYear - (153 * mp + 2) / 5 + 1;
+        int64_t month = mp < 10 ? mp + 3 : mp - 9;
+        int64_t year = yearOfEra + era * 400 + (month <= 2);
+
+        appendNumber(lineID, 7);
+        append(" | ");
+        appendNumber(uint64_t(std::max<int64_t>(year, 0)), 4);
+        append("-");
+        appendNumber(uint64_t(month), 2);
+        append("-");
+        appendNumber(uint64_t(day), 2);
+        append(", ");
+        appendNumber(uint64_t(secondOfDay / 3600), 2);
+        append(":");
+        appendNumber(uint64_t(secondOfDay / 60 % 60), 2);
+        append(":");
+        appendNumber(uint64_t(secondOfDay % 60), 2);
+        append(".");
+        appendNumber(uint64_t(timestampUs % 1000000), 6);
+        append(" [");
+        append(kSeverityNames[int(severity)]);
+        append("] - ");
+        return mLength;
+    }
+
+ private:
+    void append(const char* pText) {
+        while (*pText && mLength < kFormattedPrefixSize - 1) mpBuffer[mLength++] = *pText++;
+    }
+
+    void appendNumber(uint64_t value, size_t minDigits) {
+        char digits[20];
+        size_t count = 0;
+        do {
+            digits[count++] = char('0' + value % 10);
+            value /= 10;
+        } while (value);
+        while (count < minDigits && count < sizeof(digits)) digits[count++] = '0';
+        while (count && mLength < kFormattedPrefixSize - 1) mpBuffer[mLength++] = digits[--count];
+    }
+
+    char* mpBuffer = nullptr;
+    size_t mLength = 0;
+};
+
+class Backend {
+ public:
+    enum class State { Idle, Running, Stopped };
+
+    static Backend& instance() {
+        // Never destroyed, records can still be submitted while static objects are destroyed
+        static Backend* pBackend = new Backend();
+        return *pBackend;
+    }
+
+    void submit(Severity severity, const char* pText, size_t length, Channel channel) {
+        int64_t timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+        if (mState.load(std::memory_order_acquire) != State::Running) {
+            if (!start()) {
+                // Stopped, e.g. while exiting, write straight away
+                std::lock_guard<std::mutex> lock(mSinksMutex);
+                Entry entry;
+                fill(entry, severity, channel, timestampUs, pText, length);
+                formatEntry(entry);
+                writeBatches();
+                return;
+            }
+        }
+
+        auto fillEntry = [&](Entry& entry) { fill(entry, severity, channel, timestampUs, pText, length); };
+        while (!mRing.tryPush(fillEntry)) {
+            // Full, the writer is behind
+            wakeWriter();
+            std::this_thread::yield();
+        }
+        if (mWriterSleeping.load(std::memory_order_acquire)) wakeWriter();
+
+        if (severity >= Severity::error) flush();
+    }
+
+    void flush() {
+        if (mState.load(std::memory_order_acquire) != State::Running || std::this_thread::get_id() == mWriter.get_id()) return;
+
+        size_t target = mRing.pushCount();
+        while (mWritten.load(std::memory_order_acquire) < target) {
+            wakeWriter();
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    void flushOnCrash() {
+        // Runs in a signal handler. No locks (the crashing thread may hold them), no allocation and no stdio: records are
+        // formatted into a stack buffer and written with write(2). Sinks are only changed by add/remove, which don't run
+        // concurrently with a crash.
+        if (mCrashFlushing.exchange(true)) return;
+
+        char prefix[kFormattedPrefixSize];
+        SignalSafePrefixFormatter formatter;
+        int64_t utcOffset = mUtcOffset.load(std::memory_order_relaxed);
+        auto write = [](int fd, FILE* pFile, const char* pData, size_t size) {
+#if defined(__unix__)
+            (void)pFile;
+            while (size > 0) {
+                ssize_t written = ::write(fd, pData, size);
+                if (written < 0 && errno == EINTR) continue;
+                if (written <= 0) return;
+                pData += written;
+                size -= size_t(written);
+            }
+#else
+            (void)fd;
+            std::fwrite(pData, 1, size, pFile);
+            std::fflush(pFile);
+#endif
+        };
+        // Inline records go out in one write, so they stay whole lines while the writer thread keeps writing to the same file
+        char record[kFormattedPrefixSize + kInlineTextSize + 1];
+        auto writeRecord = [&](int fd, FILE* pFile, size_t prefixLength, const char* pText, size_t length, bool newline) {
+            if (length <= kInlineTextSize) {
+                std::memcpy(record, prefix, prefixLength);
+                std::memcpy(record + prefixLength, pText, length);
+                if (newline) record[prefixLength + length] = '\n';
+                write(fd, pFile, record, prefixLength + length + (newline ? 1 : 0));
+                return;
+            }
+            write(fd, pFile, prefix, prefixLength);
+            write(fd, pFile, pText, length);
+            if (newline) write(fd, pFile, "\n", 1);
+        };
+
+        size_t count = 0;
+        while (mRing.tryPop([&](Entry& entry) {
+            size_t prefixLength = formatter.format(prefix, mLineID.fetch_add(1) + 1, entry.severity, entry.timestampUs, utcOffset);
+            const char* pText = entry.length <= kInlineTextSize ? entry.text : entry.longText.data();
+            bool newline = entry.length == 0 || pText[entry.length - 1] != '\n';
+
+            bool subscribed = false;
+            for (const auto& sink : mSinks) {
+                if (!(sink.channels & uint32_t(entry.channel))) continue;
+                subscribed = true;
+                if (entry.severity >= sink.minSeverity) writeRecord(sink.fd, sink.pFile, prefixLength, pText, entry.length, newline);
+            }
+            if (!subscribed) writeRecord(kStderrFd, stderr, prefixLength, pText, entry.length, newline);
+        })) count++;
+
+        // Count them as written, or flush() would wait for records that are no longer in the ring
+        mWritten.fetch_add(count, std::memory_order_release);
+        mCrashFlushing = false;
+    }
+
+    int addSink(FILE* pFile, bool closeOnRemove, Severity minSeverity, uint32_t channels) {
+        std::lock_guard<std::mutex> lock(mSinksMutex);
+        int id = mNextSinkID++;
+#if defined(__unix__)
+        int fd = fileno(pFile);
+#else
+        int fd = -1;
+#endif
+        mSinks.push_back({ id, pFile, fd, closeOnRemove, minSeverity, channels, {} });
+        return id;
+    }
+
+    void removeSink(int sinkID) {
+        flush();
+        std::lock_guard<std::mutex> lock(mSinksMutex);
+        auto it = std::find_if(mSinks.begin(), mSinks.end(), [sinkID](const Sink& sink) { return sink.id == sinkID; });
+        if (it == mSinks.end()) return;
+        closeSink(*it);
+        mSinks.erase(it);
+    }
+
+    /** Write everything queued and stop the writer. Records submitted afterwards are written synchronously.
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mStartMutex);
+            if (mState.load() != State::Running) {
+                mState = State::Stopped;
+                return;
+            }
+            mStopRequested = true;
+        }
+        wakeWriter();
+        mWriter.join();
+        mState = State::Stopped;
+    }
+
+    void shutdown() {
         stop();
+        std::lock_guard<std::mutex> lock(mSinksMutex);
+        for (auto& sink : mSinks) closeSink(sink);
+        mSinks.clear();
+    }
+
+ private:
+    Backend() : mRing(kRingCapacity) {}
+
+    static void fill(Entry& entry, Severity severity, Channel channel, int64_t timestampUs, const char* pText, size_t length) {
+        entry.severity = severity;
+        entry.channel = channel;
+        entry.timestampUs = timestampUs;
+        entry.length = uint32_t(length);
+        if (length <= kInlineTextSize) std::memcpy(entry.text, pText, length);
+        else entry.longText.assign(pText, length);
+    }
+
+    static void closeSink(Sink& sink) {
+        std::fflush(sink.pFile);
+        if (sink.closeOnRemove) std::fclose(sink.pFile);
+    }
+
+    /** Start the writer on first use. Returns false if the log was stopped.
+     */
+    bool start() {
+        std::lock_guard<std::mutex> lock(mStartMutex);
+        State state = mState.load();
+        if (state == State::Running) return true;
+        if (state == State::Stopped) return false;
+
+        mStopRequested = false;
+        {
+            // Until the writer formats its first record, for records written by the crash handler
+            PrefixFormatter formatter;
+            char prefix[kFormattedPrefixSize];
+            int64_t timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            formatter.format(prefix, 0, Severity::info, timestampUs);
+            mUtcOffset.store(formatter.utcOffset(), std::memory_order_relaxed);
+        }
+        mWriter = std::thread([this] { writerLoop(); });
+        mState.store(State::Running, std::memory_order_release);
+
+        static bool sHandlersInstalled = false;
+        if (!sHandlersInstalled) {
+            sHandlersInstalled = true;
+            std::atexit([] { Backend::instance().stop(); });
+            installSignalHandlers();
+        }
+        return true;
+    }
+
+    void wakeWriter() {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mWakeCV.notify_one();
+    }
 
-    boost::log::core::get()->remove_all_sinks();
+    void writerLoop() {
+        uint32_t idleSpins = 0;
+        for (;;) {
+            size_t count = 0;
+            {
+                std::lock_guard<std::mutex> lock(mSinksMutex);
+                while (count < kBatchRecords && mRing.tryPop([this](Entry& entry) { formatEntry(entry); })) count++;
+                if (count) writeBatches();
+            }
+            if (count) {
+                mWritten.fetch_add(count, std::memory_order_release);
+                idleSpins = 0;
+                continue;
+            }
+
+            if (mStopRequested.load() && mRing.popCount() == mRing.pushCount()) break;
+
+            // Spin a little for bursts, then sleep until a producer wakes us up. The timeout covers a wake up racing with going to sleep.
+            if (++idleSpins < 64) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mWakeMutex);
+            mWriterSleeping.store(true, std::memory_order_release);
+            mWakeCV.wait_for(lock, std::chrono::milliseconds(10));
+            mWriterSleeping.store(false, std::memory_order_release);
+        }
+    }
+
+    // Called with mSinksMutex held
+    void formatEntry(Entry& entry) {
+        char prefix[kFormattedPrefixSize];
+        size_t prefixLength = mFormatter.format(prefix, mLineID.fetch_add(1) + 1, entry.severity, entry.timestampUs);
+        mUtcOffset.store(mFormatter.utcOffset(), std::memory_order_relaxed);
+        const char* pText = entry.length <= kInlineTextSize ? entry.text : entry.longText.data();
+        bool newline = entry.length == 0 || pText[entry.length - 1] != '\n';
+
+        auto append = [&](std::string& batch) {
+            batch.append(prefix, prefixLength);
+            batch.append(pText, entry.length);
+            if (newline) batch.push_back('\n');
+        };
+        bool subscribed = false;
+        for (auto& sink : mSinks) {
+            if (!(sink.channels & uint32_t(entry.channel))) continue;
+            subscribed = true;
+            if (entry.severity >= sink.minSeverity) append(sink.batch);
+        }
+        if (!subscribed) append(mStderrBatch);
+
+        if (entry.longText.capacity() > 4096) std::string().swap(entry.longText);
+    }
+
+    // Called with mSinksMutex held
+    void writeBatches() {
+        auto write = [](FILE* pFile, std::string& batch) {
+            if (batch.empty()) return;
+            std::fwrite(batch.data(), 1, batch.size(), pFile);
+            std::fflush(pFile);
+            batch.clear();
+        };
+        write(stderr, mStderrBatch);
+        for (auto& sink : mSinks) write(sink.pFile, sink.batch);
+    }
+
+    static void installSignalHandlers();
+
+    Ring<Entry> mRing;
+    std::atomic<State> mState = { State::Idle };
+    std::atomic<bool> mStopRequested = { false };
+    std::atomic<bool> mCrashFlushing = { false };
+    std::atomic<size_t> mWritten = { 0 };
+    std::atomic<uint64_t> mLineID = { 0 };
+    std::atomic<int64_t> mUtcOffset = { 0 };    // Local time - UTC in seconds, for the crash handler
+    std::mutex mStartMutex;
+    std::thread mWriter;
+
+    std::atomic<bool> mWriterSleeping = { false };
+    std::mutex mWakeMutex;
+    std::condition_variable mWakeCV;
+
+    std::mutex mSinksMutex;
+    std::vector<Sink> mSinks;
+    std::string mStderrBatch;
+    int mNextSinkID = 0;
+    PrefixFormatter mFormatter;
+};
+
+#if defined(__unix__)
+// Only signals that end the process abnormally. SIGINT and SIGTERM belong to the host application, lava_cmd exits
+// normally on SIGTERM and the log is stopped through atexit.
+const int kCrashSignals[] = { SIGSEGV, SIGABRT, SIGBUS, SIGFPE, SIGILL };
+struct sigaction gPreviousActions[sizeof(kCrashSignals) / sizeof(kCrashSignals[0])];
+
+void crashSignalHandler(int signum) {
+    int savedErrno = errno;
+    Backend::instance().flushOnCrash();
+    errno = savedErrno;
+
+    // Hand over to whoever was installed before, or the default action
+    for (size_t i = 0; i < sizeof(kCrashSignals) / sizeof(kCrashSignals[0]); i++) {
+        if (kCrashSignals[i] == signum) sigaction(signum, &gPreviousActions[i], nullptr);
+    }
+    raise(signum);
+}
+
+void Backend::installSignalHandlers() {
+    struct sigaction action = {};
+    action.sa_handler = crashSignalHandler;
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0; i < sizeof(kCrashSignals) / sizeof(kCrashSignals[0]); i++) sigaction(kCrashSignals[i], &action, &gPreviousActions[i]);
+}
+#else
+void Backend::installSignalHandlers() {}
+#endif
+
+/** Stream buffer appending to a string whose capacity is kept between records.
+ */
+class RecordBuffer : public std::streambuf {
+ public:
+    std::string text;
+
+ protected:
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) text.push_back(char(c));
+        return c;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        text.append(s, size_t(n));
+        return n;
+    }
+};
+
+struct RecordStream {
+    RecordBuffer buffer;
+    std::ostream stream;
+    RecordStream() : stream(&buffer) {}
+};
+
+// One stream per nesting level, for records built while streaming another record
+struct RecordStreams {
+    std::vector<std::unique_ptr<RecordStream>> streams;
+    size_t depth = 0;
+};
+thread_local RecordStreams tRecordStreams;
+
+}  // namespace
+
+std::ostream& operator<<(std::ostream& os, Severity severity) {
+    int index = int(severity);
+    if (index >= 0 && index <= int(Severity::fatal)) os << kSeverityNames[index];
+    else os << index;
+    return os;
+}
+
+std::istream& operator>>(std::istream& is, Severity& severity) {
+    std::string name;
+    is >> name;
+    for (int i = 0; i <= int(Severity::fatal); i++) {
+        if (name == kSeverityNames[i]) {
+            severity = Severity(i);
+            return is;
+        }
+    }
+    is.setstate(std::ios::failbit);
+    return is;
+}
+
+void set_min_severity(Severity severity) { detail::g_min_severity.store(int(severity), std::memory_order_relaxed); }
+Severity min_severity() { return Severity(detail::g_min_severity.load(std::memory_order_relaxed)); }
+
+void submit(Severity severity, const char* pText, size_t length, Channel channel) { Backend::instance().submit(severity, pText, length, channel); }
+void flush_log() { Backend::instance().flush(); }
+void flush_log_on_crash() { Backend::instance().flushOnCrash(); }
+
+int add_sink(FILE* pFile, bool closeOnRemove, Severity minSeverity, uint32_t channels) {
+    return Backend::instance().addSink(pFile, closeOnRemove, minSeverity, channels);
+}
+void remove_sink(int sinkID) { Backend::instance().removeSink(sinkID); }
+
+Record::Record(Severity severity) : mSeverity(severity) {
+    auto& streams = tRecordStreams;
+    if (streams.depth == streams.streams.size()) streams.streams.push_back(std::make_unique<RecordStream>());
+    auto& recordStream = *streams.streams[streams.depth++];
+    recordStream.buffer.text.clear();
+    recordStream.stream.clear();
+    mpStream = &recordStream.stream;
+}
+
+Record::~Record() {
+    auto& streams = tRecordStreams;
+    const auto& text = streams.streams[--streams.depth]->buffer.text;
+    submit(mSeverity, text.data(), text.size());
+}
+
+// Initialize console logger. Falcor records have their own sinks and stay off lava's stdout, Houdini reads it.
+void init_log() {
+    add_sink(stdout, false, Severity::trace, uint32_t(Channel::lava));
+}
+
+void shutdown_log() {
+    Backend::instance().shutdown();
 }
 
-// Initialize file logger
+// Initialize file logger, Falcor and lava records in one order
 void init_file_log(const std::string& logfilename) {
-    // create sink to logfile
-    boost::shared_ptr<text_sink> sink = boost::make_shared<text_sink>();
-    sink->locked_backend()->add_stream(
-        boost::make_shared<std::ofstream>(logfilename.c_str()));
-
-    // flush
-    sink->locked_backend()->auto_flush(true);
-
-    // format sink
-    boost::log::formatter formatter = boost::log::expressions::stream
-        << std::setw(7) << std::setfill('0') << line_id << std::setfill(' ') << " | "
-        << boost::log::expressions::format_date_time(timestamp, "%Y-%m-%d, %H:%M:%S.%f") << " "
-        << "[" << boost::log::trivial::severity << "]"
-        << " - " << boost::log::expressions::smessage;
-    sink->set_formatter(formatter);
-
-    // filter
-    // TODO: add any filters
-
-    // register sink
-    boost::log::core::get()->add_sink(sink);
-
-    // add sink stop functions
-    g_log_stop_functions.emplace_back([sink]() {
-        sink->flush();
-        sink->stop();       
-    });
+    FILE* pFile = std::fopen(logfilename.c_str(), "w");
+    if (!pFile) {
+        LLOG_ERR << "Unable to open log file " << logfilename;
+        return;
+    }
+    add_sink(pFile, true);
 }
 
-}}} // namespace lava::ut::log
\ No newline at end of file
+}}} // namespace lava::ut::log
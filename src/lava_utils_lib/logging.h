@@ -1,56 +1,104 @@
 #ifndef LAVA_UTILS_LOGGING_H_
 #define LAVA_UTILS_LOGGING_H_
 
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
-#include <fstream>
-#include <cstring>
 #include <string>
 
-#include <boost/log/core.hpp>
-#include <boost/log/trivial.hpp>
-#include <boost/log/expressions.hpp>
-#include <boost/log/sources/severity_channel_logger.hpp>
-#include <boost/log/sources/severity_feature.hpp>
-#include <boost/log/sources/global_logger_storage.hpp>
-#include <boost/log/sinks/sync_frontend.hpp>
-#include <boost/log/sinks/async_frontend.hpp>
-#include <boost/log/sinks/text_ostream_backend.hpp>
-#include <boost/log/expressions/formatters/date_time.hpp>
-#include <boost/log/sources/severity_logger.hpp>
-#include <boost/log/support/date_time.hpp>
-#include <boost/core/null_deleter.hpp>
-#include <boost/log/utility/setup/common_attributes.hpp>
-//#include <boost/make_shared.hpp>
-//#include <boost/shared_ptr.hpp>
-
-// Logging macro or static inline to stay within namespace boundaries
-#define LLOG_TRC BOOST_LOG_SEV(lava::ut::log::global_logger::get(), boost::log::trivial::trace)
-#define LLOG_DBG BOOST_LOG_SEV(lava::ut::log::global_logger::get(), boost::log::trivial::debug)
-#define LLOG_INF BOOST_LOG_SEV(lava::ut::log::global_logger::get(), boost::log::trivial::info)
-#define LLOG_WRN BOOST_LOG_SEV(lava::ut::log::global_logger::get(), boost::log::trivial::warning)
-#define LLOG_ERR BOOST_LOG_SEV(lava::ut::log::global_logger::get(), boost::log::trivial::error)
-#define LLOG_FTL BOOST_LOG_SEV(lava::ut::log::global_logger::get(), boost::log::trivial::fatal)
-
-namespace lava { 
+/** Compile-time severity filter. Records below it compile to nothing, arguments included.
+ *  0 trace, 1 debug, 2 info, 3 warning, 4 error, 5 fatal.
+ */
+#ifndef LAVA_LOG_MIN_SEVERITY
+#define LAVA_LOG_MIN_SEVERITY 0
+#endif
+
+// Logging macro or static inline to stay within namespace boundaries.
+// The streamed expression is only evaluated if the record passes the compile-time and the runtime filter.
+#define LAVA_LOG_RECORD(sev) \
+    if (!lava::ut::log::is_enabled(sev)) {} else lava::ut::log::Record(sev).stream()
+
+#define LLOG_TRC LAVA_LOG_RECORD(lava::ut::log::Severity::trace)
+#define LLOG_DBG LAVA_LOG_RECORD(lava::ut::log::Severity::debug)
+#define LLOG_INF LAVA_LOG_RECORD(lava::ut::log::Severity::info)
+#define LLOG_WRN LAVA_LOG_RECORD(lava::ut::log::Severity::warning)
+#define LLOG_ERR LAVA_LOG_RECORD(lava::ut::log::Severity::error)
+#define LLOG_FTL LAVA_LOG_RECORD(lava::ut::log::Severity::fatal)
+
+namespace lava {
 
 namespace ut { namespace log {
 
-// Initializing global boost::log logger
-typedef boost::log::sources::severity_channel_logger_mt<boost::log::trivial::severity_level, std::string> global_logger_type;
+/** Names match boost::log::trivial, so command line options and log files read the same as before.
+ */
+enum class Severity : int { trace = 0, debug, info, warning, error, fatal };
 
-// basic text based sink. TODO: asyncronous sink
-typedef boost::log::sinks::asynchronous_sink<boost::log::sinks::text_ostream_backend> text_sink;
+/** Origin of a record. Sinks only receive the channels they were added for, so Falcor's log file and lava's console
+ *  stay separate while a lava log file can still hold both in one order.
+ */
+enum class Channel : uint32_t { lava = 1 << 0, falcor = 1 << 1 };
+const uint32_t kAllChannels = uint32_t(Channel::lava) | uint32_t(Channel::falcor);
 
-BOOST_LOG_INLINE_GLOBAL_LOGGER_INIT(global_logger, global_logger_type) {
-	global_logger_type logger = global_logger_type(boost::log::keywords::channel = "global_logger");
+std::ostream& operator<<(std::ostream& os, Severity severity);
+std::istream& operator>>(std::istream& is, Severity& severity);
 
-	// add attributes
-    logger.add_attribute("LineID", boost::log::attributes::counter<unsigned int>(1));     // lines are sequentially numbered
-    logger.add_attribute("TimeStamp", boost::log::attributes::local_clock());             // each log line gets a timestamp
+/** Runtime severity filter for the LLOG_* macros, everything passes by default.
+ */
+void set_min_severity(Severity severity);
+Severity min_severity();
 
-    return logger;
+namespace detail {
+    extern std::atomic<int> g_min_severity;
 }
 
+inline bool is_enabled(Severity severity) {
+    return int(severity) >= LAVA_LOG_MIN_SEVERITY && int(severity) >= detail::g_min_severity.load(std::memory_order_relaxed);
+}
+
+/** Queue a message. Records are timestamped here, then numbered, formatted and written in batches by a background thread.
+ *  Records of error severity and above are flushed before this returns.
+ */
+void submit(Severity severity, const char* pText, size_t length, Channel channel = Channel::lava);
+inline void submit(Severity severity, const std::string& text, Channel channel = Channel::lava) { submit(severity, text.data(), text.size(), channel); }
+
+/** Block until everything submitted so far is written to the sinks.
+ */
+void flush_log();
+
+/** Synchronously write whatever is still queued, from a signal handler or before terminating abnormally.
+ *  Async-signal-safe: no locks, allocation or stdio, records go straight to the sinks' descriptors with write(2).
+ *  Best effort, sinks must not be added or removed concurrently, so it must only be used when the process is about to end.
+ */
+void flush_log_on_crash();
+
+/** Add a destination for the log. Records of a channel no sink was added for go to stderr.
+ *  \param[in] pFile Stream to write to.
+ *  \param[in] closeOnRemove Close the stream when the sink is removed or the log shut down.
+ *  \param[in] minSeverity Records below this are not written to this sink.
+ *  \param[in] channels Mask of the channels written to this sink.
+ *  \return Sink ID to pass to remove_sink().
+ */
+int add_sink(FILE* pFile, bool closeOnRemove, Severity minSeverity = Severity::trace, uint32_t channels = kAllChannels);
+void remove_sink(int sinkID);
+
+/** Collects one streamed record and submits it when destroyed.
+ */
+class Record {
+ public:
+    explicit Record(Severity severity);
+    ~Record();
+
+    Record(const Record&) = delete;
+    Record& operator=(const Record&) = delete;
+
+    std::ostream& stream() { return *mpStream; }
+
+ private:
+    Severity mSeverity;
+    std::ostream* mpStream;
+};
+
 // Initialize/add file logger sink
 void init_log();
 void init_file_log(const std::string& logfilename);
@@ -58,4 +106,4 @@ void shutdown_log();
 
 }}} // namespace lava::ut::log
 
-#endif // LAVA_UTILS_LOGGING_H_
\ No newline at end of file
+#endif // LAVA_UTILS_LOGGING_H_
@@ -0,0 +1,126 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#include "instancer.h"
+
+#include "pxr/imaging/hd/changeTracker.h"
+#include "pxr/imaging/hd/renderIndex.h"
+#include "pxr/base/gf/quaternion.h"
+#include "pxr/base/gf/rotation.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/base/gf/vec4f.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_PRIVATE_TOKENS(HdLavaInstancerTokens,
+    (instanceTransform)
+    (rotate)
+    (scale)
+    (translate)
+);
+
+namespace {
+
+template <typename T>
+VtArray<T> const* GetPrimvar(TfHashMap<TfToken, VtValue, TfToken::HashFunctor> const& primvarMap, TfToken const& name) {
+    auto it = primvarMap.find(name);
+    if (it == primvarMap.end() || !it->second.IsHolding<VtArray<T>>()) {
+        return nullptr;
+    }
+    return &it->second.UncheckedGet<VtArray<T>>();
+}
+
+} // namespace anonymous
+
+void HdLavaInstancer::SyncPrimvars() {
+    HdChangeTracker& changeTracker = GetDelegate()->GetRenderIndex().GetChangeTracker();
+    SdfPath const& id = GetId();
+
+    // Only the first prototype to get here reads the primvars, the rest see a clean instancer.
+    HdDirtyBits dirtyBits = changeTracker.GetInstancerDirtyBits(id);
+    if (HdChangeTracker::IsAnyPrimvarDirty(dirtyBits, id)) {
+        auto primvars = GetDelegate()->GetPrimvarDescriptors(id, HdInterpolationInstance);
+        for (auto const& primvar : primvars) {
+            if (HdChangeTracker::IsPrimvarDirty(dirtyBits, id, primvar.name)) {
+                VtValue value = GetDelegate()->Get(id, primvar.name);
+                if (!value.IsEmpty()) {
+                    m_primvarMap[primvar.name] = value;
+                }
+            }
+        }
+        changeTracker.MarkInstancerClean(id);
+    }
+}
+
+VtMatrix4dArray HdLavaInstancer::ComputeInstanceTransforms(SdfPath const& prototypeId) {
+    VtIntArray instanceIndices = GetDelegate()->GetInstanceIndices(GetId(), prototypeId);
+    GfMatrix4d instancerTransform = GetDelegate()->GetInstancerTransform(GetId());
+
+    VtMatrix4dArray transforms(instanceIndices.size());
+    {
+        std::lock_guard<std::mutex> lock(m_syncMutex);
+        SyncPrimvars();
+
+        auto translates = GetPrimvar<GfVec3f>(m_primvarMap, HdLavaInstancerTokens->translate);
+        auto rotates = GetPrimvar<GfVec4f>(m_primvarMap, HdLavaInstancerTokens->rotate);
+        auto scales = GetPrimvar<GfVec3f>(m_primvarMap, HdLavaInstancerTokens->scale);
+        auto instanceTransforms = GetPrimvar<GfMatrix4d>(m_primvarMap, HdLavaInstancerTokens->instanceTransform);
+
+        for (size_t i = 0; i < instanceIndices.size(); ++i) {
+            size_t index = size_t(instanceIndices[i]);
+            GfMatrix4d transform = instancerTransform;
+
+            if (translates && index < translates->size()) {
+                GfMatrix4d mat(1);
+                mat.SetTranslate(GfVec3d((*translates)[index]));
+                transform = mat * transform;
+            }
+            if (rotates && index < rotates->size()) {
+                GfVec4f const& q = (*rotates)[index];
+                GfMatrix4d mat(1);
+                mat.SetRotate(GfRotation(GfQuaternion(q[0], GfVec3d(q[1], q[2], q[3]))));
+                transform = mat * transform;
+            }
+            if (scales && index < scales->size()) {
+                GfMatrix4d mat(1);
+                mat.SetScale(GfVec3d((*scales)[index]));
+                transform = mat * transform;
+            }
+            if (instanceTransforms && index < instanceTransforms->size()) {
+                transform = (*instanceTransforms)[index] * transform;
+            }
+            transforms[i] = transform;
+        }
+    }
+
+    if (GetParentId().IsEmpty()) {
+        return transforms;
+    }
+
+    auto parentInstancer = static_cast<HdLavaInstancer*>(GetDelegate()->GetRenderIndex().GetInstancer(GetParentId()));
+    if (!TF_VERIFY(parentInstancer)) {
+        return transforms;
+    }
+
+    // Every instance of the parent gets a full copy of this instancer's instances.
+    VtMatrix4dArray parentTransforms = parentInstancer->ComputeInstanceTransforms(GetId());
+    VtMatrix4dArray result(parentTransforms.size() * transforms.size());
+    for (size_t i = 0; i < parentTransforms.size(); ++i) {
+        for (size_t j = 0; j < transforms.size(); ++j) {
+            result[i * transforms.size() + j] = transforms[j] * parentTransforms[i];
+        }
+    }
+    return result;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,49 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#ifndef HDLAVA_INSTANCER_H_
+#define HDLAVA_INSTANCER_H_
+
+#include "pxr/imaging/hd/instancer.h"
+#include "pxr/imaging/hd/sceneDelegate.h"
+#include "pxr/base/tf/hashmap.h"
+#include "pxr/base/tf/token.h"
+#include "pxr/base/vt/array.h"
+#include "pxr/base/vt/value.h"
+#include "pxr/base/gf/matrix4d.h"
+
+#include <mutex>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+class HdLavaInstancer : public HdInstancer {
+public:
+    HdLavaInstancer(HdSceneDelegate* delegate,
+                    SdfPath const& id,
+                    SdfPath const& parentInstancerId)
+        : HdInstancer(delegate, id, parentInstancerId) {}
+
+    // Per instance transforms of prototypeId, nested instancers included.
+    // Thread safe, called from the Sync() of every prototype.
+    VtMatrix4dArray ComputeInstanceTransforms(SdfPath const& prototypeId);
+
+private:
+    void SyncPrimvars();
+
+    std::mutex m_syncMutex;
+    TfHashMap<TfToken, VtValue, TfToken::HashFunctor> m_primvarMap;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDLAVA_INSTANCER_H_
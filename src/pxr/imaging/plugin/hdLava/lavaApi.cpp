@@ -49,6 +49,7 @@ limitations under the License.
 //#include <RadeonProRender_Baikal.h>
 //#include <RprLoadStore.h>
 
+#include <algorithm>
 #include <fstream>
 #include <vector>
 #include <mutex>
@@ -132,7 +133,30 @@ HdFormat ConvertUsdRenderVarDataType(TfToken const& format) {
 
 HdLavaApi::HdLavaApi(HdLavaDelegate* delegate) : mDelegate(delegate) {
     printf("HdLavaApi constructor\n");
-    mRenderer = lava::Renderer::create();
+
+    auto pDeviceManager = Falcor::DeviceManager::create();
+    if (!pDeviceManager) {
+        TF_RUNTIME_ERROR("Unable to create lava device manager");
+        return;
+    }
+
+    const int gpuID = 0;
+    pDeviceManager->setDefaultRenderingDevice(gpuID);
+
+    Falcor::Device::Desc deviceDesc;
+    deviceDesc.width = 1280;
+    deviceDesc.height = 720;
+    mDevice = pDeviceManager->createRenderingDevice(gpuID, deviceDesc);
+    if (!mDevice) {
+        TF_RUNTIME_ERROR("Unable to create lava rendering device");
+        return;
+    }
+
+    mRenderer = lava::Renderer::create(mDevice);
+    if (!mRenderer->init() || !mRenderer->loadDisplay(lava::Display::DisplayType::NUL)) {
+        TF_RUNTIME_ERROR("Unable to initialize lava renderer");
+        mRenderer = nullptr;
+    }
 }
 
 HdLavaApi::~HdLavaApi() {
@@ -144,8 +168,7 @@ bool HdLavaApi::IsAovFormatConversionAvailable() const {
 }
 
 int HdLavaApi::GetNumCompletedSamples() const {
-    //return m_impl->GetNumCompletedSamples();
-    return 0;
+    return mNumCompletedSamples;
 }
 
 GfVec2i HdLavaApi::GetViewportSize() const {
@@ -162,9 +185,176 @@ void HdLavaApi::CommitResources() {
     //m_impl->CommitResources();
 }
 
+HdLavaApi::MeshHandle HdLavaApi::createMesh(const lava::MeshSyncData& mesh) {
+    MeshHandle handle = mNextMeshHandle++;
+    auto& record = mMeshes[handle];
+    record.points = mesh.points;
+    record.indices = lava::triangulate(mesh.faceVertexCounts, mesh.faceVertexIndices, mesh.points.size());
+    if (mesh.normals.size() == mesh.points.size()) record.normals = mesh.normals;
+    if (mesh.uvs.size() == mesh.points.size()) record.uvs = mesh.uvs;
+    mSceneDirty = true;
+    return handle;
+}
+
+void HdLavaApi::destroyMesh(MeshHandle mesh) {
+    mMeshes.erase(mesh);
+    mSceneDirty = true;
+}
+
+void HdLavaApi::updatePoints(MeshHandle mesh, const std::vector<glm::vec3>& points) {
+    auto it = mMeshes.find(mesh);
+    if (it == mMeshes.end()) return;
+    it->second.points = points;
+    it->second.geometryEdited = true;
+    mSceneEdited = true;
+}
+
+void HdLavaApi::updatePrimvars(MeshHandle mesh, const lava::MeshSyncData& data) {
+    auto it = mMeshes.find(mesh);
+    if (it == mMeshes.end()) return;
+    auto& record = it->second;
+    record.normals.clear();
+    record.uvs.clear();
+    if (data.normals.size() == record.points.size()) record.normals = data.normals;
+    if (data.uvs.size() == record.points.size()) record.uvs = data.uvs;
+    record.geometryEdited = true;
+    mSceneEdited = true;
+}
+
+void HdLavaApi::updateInstances(MeshHandle mesh, const std::vector<glm::mat4>& transforms) {
+    auto it = mMeshes.find(mesh);
+    if (it == mMeshes.end()) return;
+    auto& record = it->second;
+
+    // Moving instances only updates their nodes, adding, removing or hiding them changes the scene's instance list
+    if (transforms.size() != record.instances.size()) mSceneDirty = true;
+    else {
+        record.instancesEdited = true;
+        mSceneEdited = true;
+    }
+    record.instances = transforms;
+}
+
+void HdLavaApi::UploadScene() {
+    // Falcor's SceneBuilder can't remove meshes, so creating or destroying one rebuilds the scene from the committed
+    // records. Unchanged prims were not touched by the sync, so the cost is the rebuild itself, not reading the stage again.
+    auto pSceneBuilder = lava::SceneBuilder::create(mDevice);
+
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<bool> referenced;
+    uint32_t meshCount = 0;
+    for (auto& [handle, record] : mMeshes) {
+        record.sceneMeshID = kNoSceneID;
+        record.sceneNodeIDs.clear();
+        record.sceneVertexPoints.clear();
+        record.geometryEdited = false;
+        record.instancesEdited = false;
+        if (record.indices.empty() || record.instances.empty()) continue;
+
+        Falcor::SceneBuilder::Mesh mesh;
+        mesh.name = "mesh" + std::to_string(handle);
+        mesh.topology = Falcor::Vao::Topology::TriangleList;
+        mesh.pMaterial = pSceneBuilder->getDefaultMaterial();
+        mesh.vertexCount = (uint32_t)record.points.size();
+        mesh.indexCount = (uint32_t)record.indices.size();
+        mesh.faceCount = mesh.indexCount / 3;
+        mesh.pIndices = record.indices.data();
+        mesh.positions = { record.points.data(), Falcor::SceneBuilder::Mesh::AttributeFrequency::Vertex };
+
+        // SceneBuilder only warns about missing normals and uvs, fill them so shading reads defined values
+        normals = record.normals.empty() ? std::vector<glm::vec3>(record.points.size(), glm::vec3(0.f, 1.f, 0.f)) : record.normals;
+        uvs = record.uvs.empty() ? std::vector<glm::vec2>(record.points.size(), glm::vec2(0.f)) : record.uvs;
+        mesh.normals = { normals.data(), Falcor::SceneBuilder::Mesh::AttributeFrequency::Vertex };
+        mesh.texCrds = { uvs.data(), Falcor::SceneBuilder::Mesh::AttributeFrequency::Vertex };
+
+        record.sceneMeshID = pSceneBuilder->addMesh(mesh);
+        for (const auto& transform : record.instances) {
+            Falcor::SceneBuilder::Node node;
+            node.name = mesh.name;
+            node.transform = transform;
+            uint32_t nodeID = pSceneBuilder->addNode(node);
+            pSceneBuilder->addMeshInstance(nodeID, record.sceneMeshID);
+            record.sceneNodeIDs.push_back(nodeID);
+        }
+
+        // With per point attributes SceneBuilder merges all corners of a point into one vertex, and stores the vertices
+        // in the order their points are first referenced. Unreferenced points are dropped.
+        referenced.assign(record.points.size(), false);
+        for (uint32_t index : record.indices) {
+            if (referenced[index]) continue;
+            referenced[index] = true;
+            record.sceneVertexPoints.push_back(index);
+        }
+        meshCount++;
+    }
+
+    // An empty builder can't produce a scene. Drop the old one so deleted geometry is released, Render() stops.
+    if (meshCount == 0) {
+        mSceneBuilder = nullptr;
+        mRenderer->setSceneBuilder(pSceneBuilder);
+        return;
+    }
+    mSceneBuilder = pSceneBuilder;
+    mRenderer->setSceneBuilder(mSceneBuilder);
+}
+
+bool HdLavaApi::UpdateScene() {
+    if (!mSceneBuilder) return true;
+    auto pScene = mSceneBuilder->getScene();
+    if (!pScene) return false;
+
+    std::vector<Falcor::StaticVertexData> vertices;
+    for (auto& [handle, record] : mMeshes) {
+        if (record.sceneMeshID != kNoSceneID && record.geometryEdited) {
+            // Corners of a point with NaN attributes are never merged, that mesh has more vertices than points
+            if (pScene->getMesh(record.sceneMeshID).vertexCount != record.sceneVertexPoints.size()) return false;
+
+            vertices.resize(record.sceneVertexPoints.size());
+            for (size_t i = 0; i < vertices.size(); i++) {
+                uint32_t point = record.sceneVertexPoints[i];
+                auto& vertex = vertices[i];
+                vertex.position = record.points[point];
+                vertex.normal = record.normals.empty() ? glm::vec3(0.f, 1.f, 0.f) : record.normals[point];
+                vertex.tangent = glm::vec4(0.f);
+                vertex.texCrd = record.uvs.empty() ? glm::vec2(0.f) : record.uvs[point];
+            }
+            pScene->updateMeshVertices(record.sceneMeshID, vertices);
+        }
+        if (record.sceneMeshID != kNoSceneID && record.instancesEdited) {
+            for (size_t i = 0; i < record.sceneNodeIDs.size(); i++) pScene->setNodeTransform(record.sceneNodeIDs[i], record.instances[i]);
+        }
+        record.geometryEdited = false;
+        record.instancesEdited = false;
+    }
+    return true;
+}
+
 void HdLavaApi::Render(HdLavaRenderThread* renderThread) {
+    if (!mRenderer) return;
+
     const bool isBatch = mDelegate->IsBatch();
-    
+
+    // Meshes were committed while the render thread was stopped. Edits of existing meshes are applied in place.
+    if (mSceneEdited && !mSceneDirty && !UpdateScene()) mSceneDirty = true;
+    if (mSceneDirty) UploadScene();
+    mSceneDirty = false;
+    mSceneEdited = false;
+
+    {
+        HdLavaConfig* config;
+        auto configInstanceLock = HdLavaConfig::GetInstance(&config);
+        mMaxSamples = config->GetMaxSamples();
+    }
+    mNumCompletedSamples = 0;
+
+    lava::RendererIface::FrameData frameData;
+    frameData.imageWidth = std::max(0, mViewportSize[0]);
+    frameData.imageHeight = std::max(0, mViewportSize[1]);
+    frameData.imageSamples = 1;
+    frameData.cameraTransform = glm::mat4(1.f);
+    if (!mSceneBuilder || frameData.imageWidth == 0 || frameData.imageHeight == 0) return;
+
     bool firstResolve = true;
     bool stopRequested = false;
     while (!IsConverged() || stopRequested) {
@@ -174,7 +364,10 @@ void HdLavaApi::Render(HdLavaRenderThread* renderThread) {
             break;
         }
 
-        auto status = lava::LAVA_SUCCESS;// = mRenderer->RenderSample();
+        // The render graph accumulates every sample rendered since it was built
+        auto status = lava::LAVA_SUCCESS;
+        mRenderer->renderFrame(frameData);
+        mNumCompletedSamples++;
 
         if (status == lava::LAVA_ERROR_ABORTED) {
             stopRequested = true;
@@ -195,7 +388,7 @@ void HdLavaApi::Render(HdLavaRenderThread* renderThread) {
 }
 
 bool HdLavaApi::IsConverged() const {
-    return false;
+    return mMaxSamples > 0 && mNumCompletedSamples >= mMaxSamples;
 }
 
 void HdLavaApi::AbortRender() {
@@ -15,6 +15,7 @@ limitations under the License.
 #define HDLAVA_LAVA_API_H_
 
 #include "api.h"
+#include "sceneSync.h"
 
 #include "pxr/base/gf/vec2i.h"
 #include "pxr/base/gf/vec3f.h"
@@ -28,6 +29,7 @@ limitations under the License.
 #include "pxr/imaging/hd/renderPassState.h"
 #include "pxr/imaging/hd/renderDelegate.h"
 
+#include <map>
 #include <memory>
 #include <vector>
 #include <string>
@@ -65,7 +67,7 @@ enum HdLavaVisibilityFlag {
 };
 const uint32_t kInvisible = 0u;
 
-class HdLavaApi final {
+class HdLavaApi final : public lava::SceneSyncBackend {
  public:
     HdLavaApi(HdLavaDelegate* delegate);
     ~HdLavaApi();
@@ -84,11 +86,50 @@ class HdLavaApi final {
     bool IsAovFormatConversionAvailable() const;
     bool IsConverged() const;
 
+    // lava::SceneSyncBackend
+    MeshHandle createMesh(const lava::MeshSyncData& mesh) override;
+    void destroyMesh(MeshHandle mesh) override;
+    void updatePoints(MeshHandle mesh, const std::vector<glm::vec3>& points) override;
+    void updatePrimvars(MeshHandle mesh, const lava::MeshSyncData& data) override;
+    void updateInstances(MeshHandle mesh, const std::vector<glm::mat4>& transforms) override;
+
  private:
+    static const uint32_t kNoSceneID = ~0u;
+
+    // Triangulated geometry as last committed by lava::SceneSync, and where it lives in the renderer's scene.
+    struct MeshRecord {
+        std::vector<glm::vec3> points;
+        std::vector<uint32_t> indices;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> uvs;
+        std::vector<glm::mat4> instances;
+
+        uint32_t sceneMeshID = kNoSceneID;
+        std::vector<uint32_t> sceneNodeIDs;         // One node per instance.
+        std::vector<uint32_t> sceneVertexPoints;    // Point of each scene vertex, in the order SceneBuilder stored them.
+        bool geometryEdited = false;                // Points, normals or uvs changed since the scene was built.
+        bool instancesEdited = false;               // Instance transforms changed, their count didn't.
+    };
+
+    // Build a lava scene from the committed meshes and hand it to the renderer.
+    void UploadScene();
+
+    // Apply edited points and transforms to the renderer's scene in place. Returns false if the scene has to be rebuilt.
+    bool UpdateScene();
+
     HdLavaDelegate* mDelegate = nullptr;
-    lava::Renderer::UniquePtr mRenderer = nullptr;
+    Falcor::Device::SharedPtr mDevice;
+    lava::Renderer::SharedPtr mRenderer = nullptr;
 
     GfVec2i mViewportSize;
+    int mNumCompletedSamples = 0;
+    int mMaxSamples = 0;
+
+    std::map<MeshHandle, MeshRecord> mMeshes;   // Sorted, so the scene is built in creation order.
+    MeshHandle mNextMeshHandle = 0;
+    lava::SceneBuilder::SharedPtr mSceneBuilder;    // Builder of the renderer's scene, nullptr while there is none.
+    bool mSceneDirty = false;   // Meshes were created or destroyed, or an instance count changed since the last render.
+    bool mSceneEdited = false;  // Points, primvars or transforms of meshes in the scene changed since the last render.
 
 };
 
@@ -0,0 +1,157 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#include "mesh.h"
+#include "instancer.h"
+#include "renderParam.h"
+
+#include "pxr/imaging/hd/meshTopology.h"
+#include "pxr/imaging/hd/tokens.h"
+#include "pxr/base/gf/matrix4d.h"
+
+#include <cstring>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_PRIVATE_TOKENS(HdLavaMeshTokens,
+    (st)
+);
+
+namespace {
+
+glm::mat4 ToGlm(GfMatrix4d const& m) {
+    // Gf matrices act on row vectors, so the storage order is already the column-major layout glm expects.
+    glm::mat4 result;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            result[i][j] = float(m[i][j]);
+        }
+    }
+    return result;
+}
+
+template <typename T, typename U>
+bool GetArray(HdSceneDelegate* sceneDelegate, SdfPath const& id, TfToken const& name, std::vector<U>* value) {
+    VtValue vtval = sceneDelegate->Get(id, name);
+    if (!vtval.IsHolding<VtArray<T>>()) {
+        value->clear();
+        return false;
+    }
+
+    auto const& array = vtval.UncheckedGet<VtArray<T>>();
+    static_assert(sizeof(T) == sizeof(U), "Element layouts must match");
+    value->resize(array.size());
+    std::memcpy(value->data(), array.cdata(), array.size() * sizeof(T));
+    return true;
+}
+
+} // namespace anonymous
+
+HdLavaMesh::HdLavaMesh(SdfPath const& id, SdfPath const& instancerId) : HdMesh(id, instancerId) {
+
+}
+
+HdDirtyBits HdLavaMesh::GetInitialDirtyBitsMask() const {
+    return HdChangeTracker::Clean
+        | HdChangeTracker::InitRepr
+        | HdChangeTracker::DirtyPoints
+        | HdChangeTracker::DirtyTopology
+        | HdChangeTracker::DirtyNormals
+        | HdChangeTracker::DirtyPrimvar
+        | HdChangeTracker::DirtyTransform
+        | HdChangeTracker::DirtyVisibility
+        | HdChangeTracker::DirtyInstancer
+        | HdChangeTracker::DirtyInstanceIndex;
+}
+
+HdDirtyBits HdLavaMesh::_PropagateDirtyBits(HdDirtyBits bits) const {
+    return bits;
+}
+
+void HdLavaMesh::_InitRepr(TfToken const& reprName, HdDirtyBits* dirtyBits) {
+    TF_UNUSED(reprName);
+    TF_UNUSED(dirtyBits);
+
+    // No-op
+}
+
+void HdLavaMesh::Sync(HdSceneDelegate* sceneDelegate,
+                      HdRenderParam* renderParam,
+                      HdDirtyBits* dirtyBits,
+                      TfToken const& reprName) {
+    SdfPath const& id = GetId();
+    lava::MeshSyncData data;
+    uint32_t syncBits = lava::SyncDirtyBits::None;
+
+    if (*dirtyBits & HdChangeTracker::DirtyTopology) {
+        HdMeshTopology topology = GetMeshTopology(sceneDelegate);
+        auto const& counts = topology.GetFaceVertexCounts();
+        auto const& indices = topology.GetFaceVertexIndices();
+        data.faceVertexCounts.assign(counts.begin(), counts.end());
+        data.faceVertexIndices.assign(indices.begin(), indices.end());
+        syncBits |= lava::SyncDirtyBits::Topology;
+    }
+
+    if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->points)) {
+        GetArray<GfVec3f>(sceneDelegate, id, HdTokens->points, &data.points);
+        syncBits |= lava::SyncDirtyBits::Points;
+    }
+
+    if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->normals)) {
+        GetArray<GfVec3f>(sceneDelegate, id, HdTokens->normals, &data.normals);
+        syncBits |= lava::SyncDirtyBits::Normals;
+    }
+
+    if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdLavaMeshTokens->st)) {
+        GetArray<GfVec2f>(sceneDelegate, id, HdLavaMeshTokens->st, &data.uvs);
+        syncBits |= lava::SyncDirtyBits::Primvars;
+    }
+
+    if (*dirtyBits & HdChangeTracker::DirtyTransform) {
+        data.transform = ToGlm(sceneDelegate->GetTransform(id));
+        syncBits |= lava::SyncDirtyBits::Transform;
+    }
+
+    if (*dirtyBits & HdChangeTracker::DirtyVisibility) {
+        _sharedData.visible = sceneDelegate->GetVisible(id);
+        data.visible = _sharedData.visible;
+        syncBits |= lava::SyncDirtyBits::Visibility;
+    }
+
+    // Instance transforms depend on the instancer primvars too, which Hydra reports through DirtyInstancer.
+    if (*dirtyBits & (HdChangeTracker::DirtyInstancer | HdChangeTracker::DirtyInstanceIndex)) {
+        if (!GetInstancerId().IsEmpty()) {
+            auto instancer = static_cast<HdLavaInstancer*>(sceneDelegate->GetRenderIndex().GetInstancer(GetInstancerId()));
+            if (instancer) {
+                auto transforms = instancer->ComputeInstanceTransforms(id);
+                data.instanceTransforms.reserve(transforms.size());
+                for (auto const& transform : transforms) {
+                    data.instanceTransforms.push_back(ToGlm(transform));
+                }
+            }
+        }
+        syncBits |= lava::SyncDirtyBits::Instances;
+    }
+
+    static_cast<HdLavaRenderParam*>(renderParam)->GetSceneSync().syncMesh(id.GetString(), syncBits, std::move(data));
+
+    *dirtyBits = HdChangeTracker::Clean;
+}
+
+void HdLavaMesh::Finalize(HdRenderParam* renderParam) {
+    static_cast<HdLavaRenderParam*>(renderParam)->GetSceneSync().removeMesh(GetId().GetString());
+
+    HdMesh::Finalize(renderParam);
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
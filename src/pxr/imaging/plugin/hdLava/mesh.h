@@ -0,0 +1,47 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#ifndef HDLAVA_MESH_H_
+#define HDLAVA_MESH_H_
+
+#include "pxr/imaging/hd/mesh.h"
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+// Reads the dirty parts of a mesh prim and hands them to lava::SceneSync. No renderer state is touched here,
+// so meshes can be synced in parallel without stopping the render thread.
+class HdLavaMesh final : public HdMesh {
+public:
+    HF_MALLOC_TAG_NEW("new HdLavaMesh");
+
+    HdLavaMesh(SdfPath const& id, SdfPath const& instancerId = SdfPath());
+    ~HdLavaMesh() override = default;
+
+    void Sync(HdSceneDelegate* sceneDelegate,
+              HdRenderParam* renderParam,
+              HdDirtyBits* dirtyBits,
+              TfToken const& reprName) override;
+
+    void Finalize(HdRenderParam* renderParam) override;
+
+    HdDirtyBits GetInitialDirtyBitsMask() const override;
+
+protected:
+    HdDirtyBits _PropagateDirtyBits(HdDirtyBits bits) const override;
+
+    void _InitRepr(TfToken const& reprName, HdDirtyBits* dirtyBits) override;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // HDLAVA_MESH_H_
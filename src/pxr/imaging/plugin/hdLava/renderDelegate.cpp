@@ -22,8 +22,8 @@ limitations under the License.
 #include "config.h"
 #include "renderPass.h"
 #include "renderParam.h"
-//#include "mesh.h"
-//#include "instancer.h"
+#include "mesh.h"
+#include "instancer.h"
 //#include "domeLight.h"
 //#include "distantLight.h"
 //#include "light.h"
@@ -195,7 +195,12 @@ HdRenderParam* HdLavaDelegate::GetRenderParam() const {
 void HdLavaDelegate::CommitResources(HdChangeTracker* tracker) {
     // CommitResources() is called after prim sync has finished, but before any
     // tasks (such as draw tasks) have run.
-
+    auto& sceneSync = m_renderParam->GetSceneSync();
+    if (sceneSync.hasPendingChanges()) {
+        auto rprApi = m_renderParam->AcquireLavaApiForEdit();
+        sceneSync.commit(*rprApi);
+        m_renderParam->RestartRender();
+    }
 }
 
 TfToken HdLavaDelegate::GetMaterialNetworkSelector() const {
@@ -224,8 +229,7 @@ HdRenderPassSharedPtr HdLavaDelegate::CreateRenderPass(HdRenderIndex* index, HdR
 }
 
 HdInstancer* HdLavaDelegate::CreateInstancer(HdSceneDelegate* delegate, SdfPath const& id, SdfPath const& instancerId) {
-    //return new HdLavaInstancer(delegate, id, instancerId);
-    return nullptr;
+    return new HdLavaInstancer(delegate, id, instancerId);
 }
 
 void HdLavaDelegate::DestroyInstancer(HdInstancer* instancer) {
@@ -235,10 +239,11 @@ void HdLavaDelegate::DestroyInstancer(HdInstancer* instancer) {
 }
 
 HdRprim* HdLavaDelegate::CreateRprim(TfToken const& typeId, SdfPath const& rprimId, SdfPath const& instancerId) {
-    /*
     if (typeId == HdPrimTypeTokens->mesh) {
         return new HdLavaMesh(rprimId, instancerId);
-    } else if (typeId == HdPrimTypeTokens->basisCurves) {
+    }
+    /*
+    else if (typeId == HdPrimTypeTokens->basisCurves) {
         return new HdLavaBasisCurves(rprimId, instancerId);
     } else if (typeId == HdPrimTypeTokens->points) {
         return new HdLavaPoints(rprimId, instancerId);
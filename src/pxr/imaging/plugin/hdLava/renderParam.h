@@ -2,6 +2,7 @@
 #define HDLAVA_RENDER_PARAM_H_
 
 #include "renderThread.h"
+#include "sceneSync.h"
 
 #include "pxr/imaging/hd/renderDelegate.h"
 
@@ -26,6 +27,9 @@ public:
 
     HdLavaRenderThread* GetRenderThread() { return mRenderThread; }
 
+    // Prims record their changes here during Sync(), HdLavaDelegate::CommitResources() applies them.
+    lava::SceneSync& GetSceneSync() { return mSceneSync; }
+
     // Hydra does not mark HdVolume as changed if HdField used by it is changed
     // We implement this volume-to-field dependency by ourself until it's implemented in Hydra
     // More info: https://groups.google.com/forum/#!topic/usd-interest/pabUE0B_5X4
@@ -39,6 +43,7 @@ public:
 private:
     HdLavaApi* mLavaApi;
     HdLavaRenderThread* mRenderThread;
+    lava::SceneSync mSceneSync;
 
     std::mutex mSubscribedVolumesMutex;
     std::map<SdfPath, std::vector<HdLavaVolumeFieldSubscriptionHandle>> mSubscribedVolumes;
@@ -0,0 +1,245 @@
+/************************************************************************
+Copyright 2020 Advanced Micro Devices, Inc
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+************************************************************************/
+
+#ifndef HDLAVA_SCENE_SYNC_H_
+#define HDLAVA_SCENE_SYNC_H_
+
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Change-tracked mesh sync between Hydra prims and the lava scene. HdLavaMesh::Sync() reports what changed on a
+// prim, SceneSync merges the reports and HdLavaApi receives them as SceneSyncBackend calls at commit time.
+
+namespace lava {
+
+// What changed on a prim since its last sync. Mirrors the Hydra dirty bits the delegate cares about.
+struct SyncDirtyBits {
+    enum : uint32_t {
+        None        = 0,
+        Points      = 1 << 0,
+        Topology    = 1 << 1,
+        Normals     = 1 << 2,
+        Primvars    = 1 << 3,   // Texture coordinates.
+        Transform   = 1 << 4,
+        Instances   = 1 << 5,
+        Visibility  = 1 << 6,
+        All         = (1 << 7) - 1
+    };
+};
+
+// Mesh state as read from the scene delegate. Only the parts flagged dirty need to be filled in.
+// Matrices transform column vectors, instance transforms are applied after the prim transform.
+struct MeshSyncData {
+    std::vector<glm::vec3> points;
+    std::vector<int32_t> faceVertexCounts;
+    std::vector<int32_t> faceVertexIndices;
+    std::vector<glm::vec3> normals;             // Per point, or empty.
+    std::vector<glm::vec2> uvs;                 // Per point, or empty.
+    glm::mat4 transform = glm::mat4(1.f);
+    std::vector<glm::mat4> instanceTransforms;  // Empty if the prim isn't instanced.
+    bool visible = true;
+};
+
+// Fan-triangulate polygons. Faces with less than three vertices or out of range indices are skipped.
+inline std::vector<uint32_t> triangulate(const std::vector<int32_t>& faceVertexCounts, const std::vector<int32_t>& faceVertexIndices, size_t pointCount) {
+    std::vector<uint32_t> indices;
+    size_t offset = 0;
+    for (int32_t count : faceVertexCounts) {
+        if (count < 0 || offset + count > faceVertexIndices.size()) break;
+
+        bool valid = count >= 3;
+        for (int32_t i = 0; i < count && valid; i++) {
+            int32_t index = faceVertexIndices[offset + i];
+            valid = index >= 0 && (size_t)index < pointCount;
+        }
+        if (valid) {
+            for (int32_t i = 1; i + 1 < count; i++) {
+                indices.push_back(faceVertexIndices[offset]);
+                indices.push_back(faceVertexIndices[offset + i]);
+                indices.push_back(faceVertexIndices[offset + i + 1]);
+            }
+        }
+        offset += count;
+    }
+    return indices;
+}
+
+// Renderer side of the sync. Only called from SceneSync::commit().
+class SceneSyncBackend {
+ public:
+    using MeshHandle = uint32_t;
+    static const MeshHandle kInvalidMesh = ~0u;
+
+    virtual ~SceneSyncBackend() = default;
+
+    // Create the geometry of a mesh. It has no instances until updateInstances() is called.
+    virtual MeshHandle createMesh(const MeshSyncData& mesh) = 0;
+    virtual void destroyMesh(MeshHandle mesh) = 0;
+
+    // Replace the points of a mesh. The point count is unchanged.
+    virtual void updatePoints(MeshHandle mesh, const std::vector<glm::vec3>& points) = 0;
+
+    // Replace normals and texture coordinates.
+    virtual void updatePrimvars(MeshHandle mesh, const MeshSyncData& data) = 0;
+
+    // Replace the world transforms of all instances of a mesh. Empty hides the mesh.
+    virtual void updateInstances(MeshHandle mesh, const std::vector<glm::mat4>& transforms) = 0;
+};
+
+// Collects prim changes from concurrent Hydra Sync() calls and applies the minimal set of backend updates in
+// CommitResources(). Geometry is only recreated when topology or the point count changes.
+class SceneSync {
+ public:
+    struct Stats {
+        uint32_t created = 0;
+        uint32_t destroyed = 0;
+        uint32_t pointUpdates = 0;
+        uint32_t primvarUpdates = 0;
+        uint32_t instanceUpdates = 0;
+    };
+
+    // Record changes of a mesh prim. Thread safe, the parts of data not flagged in dirtyBits are ignored.
+    void syncMesh(const std::string& id, uint32_t dirtyBits, MeshSyncData&& data) {
+        if (dirtyBits == SyncDirtyBits::None) return;
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto& pending = mPending[id];
+        pending.removed = false;
+        pending.dirtyBits |= dirtyBits;
+        moveDirtyParts(pending.data, data, dirtyBits);
+    }
+
+    // Record removal of a mesh prim. Thread safe.
+    void removeMesh(const std::string& id) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto& pending = mPending[id];
+        pending.removed = true;
+        pending.dirtyBits = SyncDirtyBits::None;
+        pending.data = MeshSyncData();
+    }
+
+    bool hasPendingChanges() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return !mPending.empty();
+    }
+
+    size_t getMeshCount() const { return mMeshes.size(); }
+
+    // Apply all recorded changes in prim order. Must not run concurrently with syncMesh() or removeMesh().
+    Stats commit(SceneSyncBackend& backend) {
+        std::map<std::string, Pending> pendingChanges;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            pendingChanges.swap(mPending);
+        }
+
+        Stats stats;
+        for (auto& [id, pending] : pendingChanges) {
+            auto it = mMeshes.find(id);
+            if (pending.removed) {
+                if (it != mMeshes.end()) {
+                    if (it->second.handle != SceneSyncBackend::kInvalidMesh) {
+                        backend.destroyMesh(it->second.handle);
+                        stats.destroyed++;
+                    }
+                    mMeshes.erase(it);
+                }
+                continue;
+            }
+
+            if (it == mMeshes.end()) it = mMeshes.emplace(id, MeshRecord()).first;
+            auto& record = it->second;
+            const uint32_t bits = pending.dirtyBits;
+            const size_t oldPointCount = record.data.points.size();
+            moveDirtyParts(record.data, pending.data, bits);
+
+            bool recreate = record.handle == SceneSyncBackend::kInvalidMesh || (bits & SyncDirtyBits::Topology) ||
+                record.data.points.size() != oldPointCount;
+            if (recreate) {
+                if (record.handle != SceneSyncBackend::kInvalidMesh) {
+                    backend.destroyMesh(record.handle);
+                    stats.destroyed++;
+                    record.handle = SceneSyncBackend::kInvalidMesh;
+                }
+                if (record.data.points.empty() || record.data.faceVertexCounts.empty()) continue;
+
+                record.handle = backend.createMesh(record.data);
+                stats.created++;
+            } else {
+                if (bits & SyncDirtyBits::Points) {
+                    backend.updatePoints(record.handle, record.data.points);
+                    stats.pointUpdates++;
+                }
+                if (bits & (SyncDirtyBits::Normals | SyncDirtyBits::Primvars)) {
+                    backend.updatePrimvars(record.handle, record.data);
+                    stats.primvarUpdates++;
+                }
+            }
+
+            if (recreate || (bits & (SyncDirtyBits::Transform | SyncDirtyBits::Instances | SyncDirtyBits::Visibility))) {
+                backend.updateInstances(record.handle, getWorldTransforms(record.data));
+                stats.instanceUpdates++;
+            }
+        }
+        return stats;
+    }
+
+    static std::vector<glm::mat4> getWorldTransforms(const MeshSyncData& data) {
+        if (!data.visible) return {};
+        if (data.instanceTransforms.empty()) return { data.transform };
+
+        std::vector<glm::mat4> transforms;
+        transforms.reserve(data.instanceTransforms.size());
+        for (const auto& instance : data.instanceTransforms) transforms.push_back(instance * data.transform);
+        return transforms;
+    }
+
+ private:
+    struct Pending {
+        uint32_t dirtyBits = SyncDirtyBits::None;
+        bool removed = false;
+        MeshSyncData data;
+    };
+
+    struct MeshRecord {
+        MeshSyncData data;
+        SceneSyncBackend::MeshHandle handle = SceneSyncBackend::kInvalidMesh;
+    };
+
+    static void moveDirtyParts(MeshSyncData& dst, MeshSyncData& src, uint32_t bits) {
+        if (bits & SyncDirtyBits::Points) dst.points = std::move(src.points);
+        if (bits & SyncDirtyBits::Topology) {
+            dst.faceVertexCounts = std::move(src.faceVertexCounts);
+            dst.faceVertexIndices = std::move(src.faceVertexIndices);
+        }
+        if (bits & SyncDirtyBits::Normals) dst.normals = std::move(src.normals);
+        if (bits & SyncDirtyBits::Primvars) dst.uvs = std::move(src.uvs);
+        if (bits & SyncDirtyBits::Transform) dst.transform = src.transform;
+        if (bits & SyncDirtyBits::Instances) dst.instanceTransforms = std::move(src.instanceTransforms);
+        if (bits & SyncDirtyBits::Visibility) dst.visible = src.visible;
+    }
+
+    mutable std::mutex mMutex;
+    std::map<std::string, Pending> mPending;                // Sorted, so commit order doesn't depend on sync order.
+    std::unordered_map<std::string, MeshRecord> mMeshes;    // State last sent to the backend.
+};
+
+}  // namespace lava
+
+#endif  // HDLAVA_SCENE_SYNC_H_